@@ -11,6 +11,11 @@
 
 #include "Log.h"
 #include "../Tests/ECS/Unit/UnitTestMain.h"
+#include "../Tests/Terrain/TestTerrain.h"
+#include "../Tests/Mesh/TestModelMath.h"
+#include "../Tests/Mesh/TestMeshOptimizer.h"
+#include "../Tests/Mesh/TestPackedVertex.h"
+#include "../Tests/Mesh/TestMeshSimplifier.h"
 
 #include "imgui.h"
 #include "imgui_impl_win32.h"
@@ -24,11 +29,43 @@ Engine::Engine()
 	// execute testing of some modules
 	UnitTestMain ecs_Unit_Tests;
 	ecs_Unit_Tests.Run();
+
+	TestTerrain terrainTests;
+	terrainTests.Run();
+
+	TestModelMath modelMathTests;
+	modelMathTests.Run();
+
+	TestMeshOptimizer meshOptimizerTests;
+	meshOptimizerTests.Run();
+
+	TestPackedVertex packedVertexTests;
+	packedVertexTests.Run();
+
+	TestMeshSimplifier meshSimplifierTests;
+	meshSimplifierTests.Run();
 	//exit(-1);
 #endif
 
 }
 
+///////////////////////////////////////////////////////////
+
+void Engine::RunBenchmarks()
+{
+	// performance benchmarks of the engine modules; they are heavy so
+	// they are run only by request (see the "-bench" switch in main.cpp)
+
+	UnitTestMain ecsBenchmarks;
+	ecsBenchmarks.RunBenchmarks();
+
+	TestTerrain terrainBenchmarks;
+	terrainBenchmarks.RunBenchmarks();
+
+	TestModelMath modelMathBenchmarks;
+	modelMathBenchmarks.RunBenchmarks();
+}
+
 
 Engine::~Engine()
 {
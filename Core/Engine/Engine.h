@@ -47,6 +47,9 @@ public:
 	Engine();
 	~Engine();
 
+	// run performance benchmarks of the engine modules (instead of the game)
+	static void RunBenchmarks();
+
 	// initializes the private members for the Engine class
 	bool Initialize(HINSTANCE hInstance,
 					HWND hwnd,
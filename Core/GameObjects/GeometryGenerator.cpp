@@ -306,7 +306,7 @@ void GeometryGenerator::GenerateFlatGridMesh(
 
 		for (UINT j = 0; j < verticesByX; ++j)
 		{
-			Vertex3D& vertex = meshData.vertices[i*verticesByZ + j];
+			Vertex3D& vertex = meshData.vertices[i*verticesByX + j];
 
 			vertex.position = DirectX::XMFLOAT3(quadsXCoords[j], 0.0f, z);
 			vertex.texture = DirectX::XMFLOAT2(quadsTU[j], i * dv);
@@ -340,9 +340,10 @@ void GeometryGenerator::GenerateFlatGridMesh(
 	meshData.indices.resize(faceCount * 3);   // 3 indices per face
 
 	// iterate over each quad and compute indices
+	// (m - number of rows, n - number of vertices in a row)
 	UINT k = 0;
-	const UINT m = verticesByX;
-	const UINT n = verticesByZ;
+	const UINT m = verticesByZ;
+	const UINT n = verticesByX;
 	for (UINT i = 0; i < m-1; ++i)
 	{
 		for (UINT j = 0; j < n-1; ++j)
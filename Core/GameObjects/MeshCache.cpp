@@ -0,0 +1,436 @@
+// *********************************************************************************
+// Filename:      MeshCache.cpp
+// Description:   implementation of the MeshCache functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "MeshCache.h"
+#include "TextureManager.h"
+#include "../Common/Assert.h"
+#include "../Engine/StringHelper.h"
+#include "../Engine/log.h"
+#include "Common/MappedFile.h"        // from the ECS module
+#include "Common/LIB_Exception.h"     // ECS exception
+
+#include <filesystem>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+
+namespace fs = std::filesystem;
+using namespace DirectX;
+
+
+static const std::string cacheDirPath = "data/cache/meshes/";
+
+using FilePtr = std::unique_ptr<FILE, decltype(&fclose)>;
+
+///////////////////////////////////////////////////////////
+
+static uint64_t HashFNV1a(const void* pData, const size_t bytesCount, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = (const uint8_t*)pData;
+
+	for (size_t i = 0; i < bytesCount; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+///////////////////////////////////////////////////////////
+
+static void Write(FILE* pFile, const void* pData, const size_t bytesCount)
+{
+	if (bytesCount == 0)
+		return;
+
+	Assert::True(fwrite(pData, 1, bytesCount, pFile) == bytesCount, "can't write data into the mesh cache file");
+}
+
+
+// *********************************************************************************
+
+std::string MeshCache::GetCachePath(const std::string& srcPath, const u32 importFlags)
+{
+	// the name of the cache file is made of the source file name and a hash
+	// of the source path + import flags (so the same model imported with
+	// different flags has different cache files)
+
+	const std::string normPath = fs::path(srcPath).lexically_normal().generic_string();
+
+	uint64_t hash = HashFNV1a(normPath.data(), normPath.size());
+	hash = HashFNV1a(&importFlags, sizeof(importFlags), hash);
+
+	char hashStr[17]{ '\0' };
+	snprintf(hashStr, sizeof(hashStr), "%016llx", (unsigned long long)hash);
+
+	return cacheDirPath + StringHelper::GetFileName(srcPath) + "_" + hashStr + ".mcache";
+}
+
+///////////////////////////////////////////////////////////
+
+bool MeshCache::Load(
+	const std::string& srcPath,
+	const u32 importFlags,
+	std::vector<Mesh::MeshData>& outMeshes)
+{
+	// load meshes from the cache file and load their textures by paths
+	// (textures which are already loaded by other models are just shared)
+
+	std::vector<Mesh::MeshData> meshes;
+	std::vector<TexPath> texPaths;
+
+	if (!Load(srcPath, importFlags, meshes, texPaths))
+		return false;
+
+	TextureManager* pTexMgr = TextureManager::Get();
+
+	for (size_t i = 0; i < texPaths.size(); ++i)
+	{
+		if (texPaths[i].empty())
+			continue;
+
+		try
+		{
+			meshes[i / TEXTURE_TYPE_COUNT].texIDs[i % TEXTURE_TYPE_COUNT] = pTexMgr->LoadFromFile(texPaths[i]);
+		}
+		catch (EngineException& e)
+		{
+			Log::Error(e, false);
+			Log::Error("can't load a texture: " + texPaths[i]);
+		}
+	}
+
+	// append loaded meshes to the output array
+	outMeshes.insert(outMeshes.end(),
+		std::make_move_iterator(meshes.begin()),
+		std::make_move_iterator(meshes.end()));
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+
+bool MeshCache::Load(
+	const std::string& srcPath,
+	const u32 importFlags,
+	std::vector<Mesh::MeshData>& outMeshes,
+	std::vector<TexPath>& outTexPaths)
+{
+	// load meshes from the cache file if it exists and it is up to date;
+	// the file is mapped into memory so all the vertices/indices are just copied
+	// into the output meshes (the output arrays are replaced)
+
+	int64_t srcWriteTime = 0;
+
+	if (!GetSourceWriteTime(srcPath, srcWriteTime))
+		return false;
+
+	const std::string cachePath = GetCachePath(srcPath, importFlags);
+	ECS::MappedFile file;
+
+	// there is no cache for this model yet
+	std::error_code ec;
+	if (!fs::is_regular_file(cachePath, ec))
+		return false;
+
+	try
+	{
+		file.Open(cachePath);
+	}
+	catch (ECS::LIB_Exception& e)
+	{
+		Log::Error(e.GetStr());
+		return false;
+	}
+
+	if (file.GetSize() < sizeof(MeshCacheHeader))
+	{
+		Log::Debug("mesh cache is too small: " + cachePath);
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	const bool isUpToDate =
+		(header.magic == MAGIC) &&
+		(header.version == VERSION) &&
+		(header.importFlags == importFlags) &&
+		(header.sourceWriteTime == srcWriteTime) &&
+		(header.vertexSize == sizeof(Vertex3D));
+
+	if (!isUpToDate)
+	{
+		Log::Debug("mesh cache is stale: " + cachePath);
+		return false;
+	}
+
+	try
+	{
+		ReadMeshes(file.GetData(), (size_t)file.GetSize(), header, outMeshes, outTexPaths);
+	}
+	catch (EngineException& e)
+	{
+		outMeshes.clear();
+		outTexPaths.clear();
+
+		Log::Error(e, false);
+		Log::Error("the mesh cache is corrupted (will be rebaked): " + cachePath);
+		return false;
+	}
+
+	Log::Debug("meshes are loaded from the cache: " + cachePath);
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+
+bool MeshCache::Save(
+	const std::string& srcPath,
+	const u32 importFlags,
+	const std::vector<Mesh::MeshData>& meshes)
+{
+	// bake meshes into the cache file; textures are stored by their paths
+	// so we can bake only meshes which use textures from the disk
+
+	int64_t srcWriteTime = 0;
+
+	if (!GetSourceWriteTime(srcPath, srcWriteTime))
+		return false;
+
+	TextureManager* pTexMgr = TextureManager::Get();
+	const TexID unloadedTexID = TextureManager::TEX_ID_UNLOADED;
+
+	// get paths of textures for each mesh
+	std::vector<TexPath> texPaths(meshes.size() * TEXTURE_TYPE_COUNT);
+
+	for (size_t meshIdx = 0; meshIdx < meshes.size(); ++meshIdx)
+	{
+		const std::vector<TexID>& texIDs = meshes[meshIdx].texIDs;
+
+		for (size_t type = 0; type < texIDs.size(); ++type)
+		{
+			if (texIDs[type] == unloadedTexID)
+				continue;
+
+			TexPath path = pTexMgr->GetNameByID(texIDs[type]);
+
+			// embedded/generated textures have no files so we can't bake such meshes
+			std::error_code ec;
+			if (path.empty() || !fs::is_regular_file(path, ec))
+			{
+				Log::Debug("can't bake meshes with texture which isn't a file: " + srcPath);
+				return false;
+			}
+
+			texPaths[meshIdx * TEXTURE_TYPE_COUNT + type] = std::move(path);
+		}
+	}
+
+	// ---------------------------------------------
+
+	const std::string cachePath = GetCachePath(srcPath, importFlags);
+	const std::string tempPath  = cachePath + ".tmp";
+
+	try
+	{
+		std::error_code ec;
+		fs::create_directories(cacheDirPath, ec);
+
+		FILE* pRawFile = nullptr;
+		const errno_t error = fopen_s(&pRawFile, tempPath.c_str(), "wb");
+		Assert::True((error == 0) && (pRawFile != nullptr), "can't open the file: " + tempPath);
+
+		FilePtr pFile(pRawFile, &fclose);
+
+		MeshCacheHeader header;
+		header.magic           = MAGIC;
+		header.version         = VERSION;
+		header.importFlags     = importFlags;
+		header.meshesCount     = (u32)meshes.size();
+		header.sourceWriteTime = srcWriteTime;
+		header.vertexSize      = sizeof(Vertex3D);
+
+		Write(pFile.get(), &header, sizeof(header));
+
+		for (size_t meshIdx = 0; meshIdx < meshes.size(); ++meshIdx)
+		{
+			const Mesh::MeshData& mesh = meshes[meshIdx];
+			const TexPath* meshTexPaths = texPaths.data() + meshIdx * TEXTURE_TYPE_COUNT;
+
+			MeshCacheRecord record{};
+			record.type          = (u32)mesh.type;
+			record.nameLength    = (u32)mesh.name.size();
+			record.pathLength    = (u32)mesh.path.size();
+			record.verticesCount = (u32)mesh.vertices.size();
+			record.indicesCount  = (u32)mesh.indices.size();
+			record.lodsCount     = (u32)mesh.lods.size();
+			record.material      = mesh.material;
+			record.aabbCenter    = mesh.AABB.Center;
+			record.aabbExtents   = mesh.AABB.Extents;
+
+			for (u32 type = 0; type < TEXTURE_TYPE_COUNT; ++type)
+				record.texPathsLengths[type] = (u32)meshTexPaths[type].size();
+
+			Write(pFile.get(), &record, sizeof(record));
+			Write(pFile.get(), mesh.name.data(), mesh.name.size());
+			Write(pFile.get(), mesh.path.data(), mesh.path.size());
+
+			for (u32 type = 0; type < TEXTURE_TYPE_COUNT; ++type)
+				Write(pFile.get(), meshTexPaths[type].data(), meshTexPaths[type].size());
+
+			Write(pFile.get(), mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex3D));
+			Write(pFile.get(), mesh.indices.data(), mesh.indices.size() * sizeof(UINT));
+
+			for (const Mesh::LOD& lod : mesh.lods)
+			{
+				const u32 lodIndicesCount = (u32)lod.indices.size();
+
+				Write(pFile.get(), &lodIndicesCount, sizeof(lodIndicesCount));
+				Write(pFile.get(), &lod.error, sizeof(lod.error));
+				Write(pFile.get(), lod.indices.data(), lod.indices.size() * sizeof(UINT));
+			}
+		}
+
+		pFile.reset();
+
+		// replace the previous cache only when the new one is completely written
+		fs::rename(tempPath, cachePath, ec);
+		Assert::True(!ec, "can't rename the mesh cache file: " + tempPath);
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("can't bake meshes into the cache: " + cachePath);
+
+		std::error_code ec;
+		fs::remove(tempPath, ec);
+		return false;
+	}
+
+	Log::Debug("meshes are baked into the cache: " + cachePath);
+	return true;
+}
+
+
+// *********************************************************************************
+//
+//                              PRIVATE HELPERS
+//
+// *********************************************************************************
+
+bool MeshCache::GetSourceWriteTime(const std::string& srcPath, int64_t& outTime)
+{
+	std::error_code ec;
+	const fs::file_time_type time = fs::last_write_time(srcPath, ec);
+
+	if (ec)
+		return false;
+
+	outTime = (int64_t)time.time_since_epoch().count();
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshCache::ReadMeshes(
+	const uint8_t* pData,
+	const size_t dataSize,
+	const MeshCacheHeader& header,
+	std::vector<Mesh::MeshData>& outMeshes,
+	std::vector<TexPath>& outTexPaths)
+{
+	// read meshes from the mapped cache file; each count is checked against the rest
+	// of the file before any allocation and each read is checked against the file size
+	// so a corrupted or truncated file won't be read out of bounds
+
+	size_t offset = sizeof(MeshCacheHeader);
+
+	auto CheckCount = [dataSize, &offset](const size_t count, const size_t elemSize)
+	{
+		Assert::True(count <= (dataSize - offset) / elemSize, "unexpected end of the mesh cache file");
+	};
+
+	auto Read = [pData, dataSize, &offset](void* pDst, const size_t bytesCount)
+	{
+		Assert::True(bytesCount <= dataSize - offset, "unexpected end of the mesh cache file");
+
+		if (bytesCount)
+			memcpy(pDst, pData + offset, bytesCount);
+
+		offset += bytesCount;
+	};
+
+	const TexID unloadedTexID = TextureManager::TEX_ID_UNLOADED;
+
+	CheckCount(header.meshesCount, sizeof(MeshCacheRecord));
+
+	outMeshes.clear();
+	outMeshes.resize(header.meshesCount);
+	outTexPaths.clear();
+	outTexPaths.resize((size_t)header.meshesCount * TEXTURE_TYPE_COUNT);
+
+	for (u32 meshIdx = 0; meshIdx < header.meshesCount; ++meshIdx)
+	{
+		Mesh::MeshData& mesh = outMeshes[meshIdx];
+		TexPath* meshTexPaths = outTexPaths.data() + (size_t)meshIdx * TEXTURE_TYPE_COUNT;
+
+		MeshCacheRecord record{};
+		Read(&record, sizeof(record));
+
+		mesh.type = (Mesh::MeshType)record.type;
+
+		CheckCount(record.nameLength, sizeof(char));
+		mesh.name.resize(record.nameLength);
+		Read(mesh.name.data(), record.nameLength);
+
+		CheckCount(record.pathLength, sizeof(char));
+		mesh.path.resize(record.pathLength);
+		Read(mesh.path.data(), record.pathLength);
+
+		// textures are loaded by paths later
+		mesh.texIDs.resize(TEXTURE_TYPE_COUNT, unloadedTexID);
+
+		for (u32 type = 0; type < TEXTURE_TYPE_COUNT; ++type)
+		{
+			CheckCount(record.texPathsLengths[type], sizeof(char));
+			meshTexPaths[type].resize(record.texPathsLengths[type]);
+			Read(meshTexPaths[type].data(), record.texPathsLengths[type]);
+		}
+
+		// vertices/indices are copied as is
+		CheckCount(record.verticesCount, sizeof(Vertex3D));
+		mesh.vertices.resize(record.verticesCount);
+		Read(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex3D));
+
+		CheckCount(record.indicesCount, sizeof(UINT));
+		mesh.indices.resize(record.indicesCount);
+		Read(mesh.indices.data(), mesh.indices.size() * sizeof(UINT));
+
+		// each LOD has at least the number of indices and the error
+		CheckCount(record.lodsCount, sizeof(u32) + sizeof(float));
+		mesh.lods.resize(record.lodsCount);
+
+		for (Mesh::LOD& lod : mesh.lods)
+		{
+			u32 lodIndicesCount = 0;
+
+			Read(&lodIndicesCount, sizeof(lodIndicesCount));
+			Read(&lod.error, sizeof(lod.error));
+
+			CheckCount(lodIndicesCount, sizeof(UINT));
+			lod.indices.resize(lodIndicesCount);
+			Read(lod.indices.data(), lod.indices.size() * sizeof(UINT));
+		}
+
+		mesh.material     = record.material;
+		mesh.AABB.Center  = record.aabbCenter;
+		mesh.AABB.Extents = record.aabbExtents;
+	}
+
+	Assert::True(offset == dataSize, "wrong size of the mesh cache file");
+}
@@ -0,0 +1,104 @@
+// *********************************************************************************
+// Filename:      MeshCache.h
+// Description:   a cache of baked meshes: meshes of an imported model are written
+//                into a binary file the first time the model is imported and
+//                on later runs this file is memory-mapped and its data is copied
+//                straight into the meshes (no Assimp/text parsing at all);
+//
+//                a cache file is keyed by the source path + import flags (its name)
+//                and by the last write time of the source (is stored in the header)
+//                so if the source is changed the cache is rebaked;
+//
+//                file layout:
+//                  [header]
+//                  [mesh record 0][name][path][texture paths][vertices][indices][LODs]
+//                  ...
+//                  [mesh record N-1][name][path][texture paths][vertices][indices][LODs]
+//
+//                  each LOD: [u32 indices count][float error][indices]
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "MeshHelperTypes.h"
+#include "../Common/Types.h"
+
+
+struct MeshCacheHeader
+{
+	u32     magic           = 0;
+	u32     version         = 0;
+	u32     importFlags     = 0;     // flags which were used for import of the source
+	u32     meshesCount     = 0;
+	int64_t sourceWriteTime = 0;     // the last write time of the source file
+	u32     vertexSize      = 0;     // sizeof(Vertex3D) when the file was baked
+	u32     reserved        = 0;
+};
+
+///////////////////////////////////////////////////////////
+
+struct MeshCacheRecord
+{
+	u32               type          = 0;     // Mesh::MeshType
+	u32               nameLength    = 0;
+	u32               pathLength    = 0;
+	u32               verticesCount = 0;
+	u32               indicesCount  = 0;
+	u32               lodsCount     = 0;     // the number of LODs (without LOD 0)
+	Mesh::Material    material;
+	DirectX::XMFLOAT3 aabbCenter{ 0,0,0 };
+	DirectX::XMFLOAT3 aabbExtents{ 0,0,0 };
+
+	// lengths of texture paths by types (0 if there is no texture by this type)
+	u32               texPathsLengths[TEXTURE_TYPE_COUNT]{ 0 };
+};
+
+///////////////////////////////////////////////////////////
+
+class MeshCache final
+{
+public:
+	static constexpr u32 MAGIC   = 0x4348534D;   // "MSHC"
+	static constexpr u32 VERSION = 3;            // increase it when the baked data is changed
+
+public:
+	// returns a path to the cache file of the source model
+	static std::string GetCachePath(const std::string& srcPath, const u32 importFlags);
+
+	// load meshes of the source model from its cache file (+ load their textures);
+	// returns false if there is no cache or it is stale (so the source must be imported)
+	static bool Load(
+		const std::string& srcPath,
+		const u32 importFlags,
+		std::vector<Mesh::MeshData>& outMeshes);
+
+	// the same but the texture manager isn't touched so it can be called from any thread:
+	// paths of textures are returned instead (TEXTURE_TYPE_COUNT per mesh, empty if none)
+	static bool Load(
+		const std::string& srcPath,
+		const u32 importFlags,
+		std::vector<Mesh::MeshData>& outMeshes,
+		std::vector<TexPath>& outTexPaths);
+
+	// bake meshes of the source model into the cache file; returns false if meshes
+	// can't be baked (for instance: they use textures embedded into the source)
+	static bool Save(
+		const std::string& srcPath,
+		const u32 importFlags,
+		const std::vector<Mesh::MeshData>& meshes);
+
+private:
+	static bool GetSourceWriteTime(const std::string& srcPath, int64_t& outTime);
+
+	static void ReadMeshes(
+		const uint8_t* pData,
+		const size_t dataSize,
+		const MeshCacheHeader& header,
+		std::vector<Mesh::MeshData>& outMeshes,
+		std::vector<TexPath>& outTexPaths);
+};
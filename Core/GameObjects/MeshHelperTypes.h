@@ -103,6 +103,14 @@ namespace Mesh
 		{ MeshType::Sphere, "sphere" },
 	};
 
+	// a simplified level of detail of the mesh; it uses vertices of the mesh
+	// so only indices are stored
+	struct LOD
+	{
+		std::vector<UINT> indices;
+		float error = 0.0f;            // geometric error (in units of the mesh space) relatively to the origin mesh
+	};
+
 	// is used during generation/loading mesh
 	struct MeshData
 	{
@@ -123,6 +131,8 @@ namespace Mesh
 		DirectX::BoundingBox AABB;         
 
 		Mesh::Material material;
+
+		std::vector<LOD> lods;             // LODs 1..N (LOD 0 is the mesh itself); can be empty
 	};
 
 	
@@ -138,6 +148,7 @@ namespace Mesh
 			dataIdxs_.reserve(meshesCount);
 			boundBoxes_.reserve(meshesCount);
 			materials_.reserve(meshesCount);
+			lods_.reserve(meshesCount);
 			texIDs_.reserve(meshesCount * 22);   // 22 - the number of textures per mesh (all kinds of textures)
 		}
 
@@ -150,11 +161,19 @@ namespace Mesh
 			dataIdxs_.clear();
 			boundBoxes_.clear();
 			materials_.clear();
+			lods_.clear();
 			texIDs_.clear();
 		}
 
 		using AABB = DirectX::BoundingBox;
 
+		struct LodData
+		{
+			ID3D11Buffer* pIB = nullptr;
+			UINT          indexCount = 0;
+			float         error = 0.0f;
+		};
+
 		std::vector<MeshName> names_;            // for debug
 		std::vector<ID3D11Buffer*> pVBs_;        // ptrs to vertex buffers
 		std::vector<ID3D11Buffer*> pIBs_;        // ptrs to index buffers
@@ -164,6 +183,7 @@ namespace Mesh
 		std::vector<UINT>     dataIdxs_;         // for debug: mesh data idx
 		std::vector<AABB>     boundBoxes_;
 		std::vector<Material> materials_;
+		std::vector<std::vector<LodData>> lods_;   // LODs 1..N of each mesh (empty if the mesh has no LODs)
 
 		std::vector<std::vector<TexID>> texIDs_;              // each mesh has 22 textures; so in this arr we place texture IDs for (tex_ids_num / 22) meshes
 	};
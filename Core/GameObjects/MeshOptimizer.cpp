@@ -0,0 +1,556 @@
+// *********************************************************************************
+// Filename:      MeshOptimizer.cpp
+// Description:   implementation of the MeshOptimizer functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "MeshOptimizer.h"
+#include "MeshHelperTypes.h"
+#include "../Common/Assert.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cmath>
+
+using namespace DirectX;
+
+
+namespace
+{
+
+// params of the Forsyth's vertex scoring
+constexpr float CACHE_DECAY_POWER   = 1.5f;
+constexpr float LAST_TRI_SCORE      = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+constexpr u32   MAX_VALENCE         = 32;       // valence scores are tabulated up to this number of triangles
+
+constexpr u32   INVALID_IDX         = 0xFFFFFFFF;
+
+///////////////////////////////////////////////////////////
+
+struct VertexScoreTables
+{
+	float cache[MeshOptimizer::FORSYTH_CACHE_SIZE];
+	float valence[MAX_VALENCE + 1];
+
+	VertexScoreTables()
+	{
+		// the 3 most recently used vertices get a fixed score (they are used
+		// by the last triangle so we don't want to use them right away)
+		for (u32 pos = 0; pos < MeshOptimizer::FORSYTH_CACHE_SIZE; ++pos)
+		{
+			if (pos < 3)
+			{
+				cache[pos] = LAST_TRI_SCORE;
+			}
+			else
+			{
+				const float scale = 1.0f / (MeshOptimizer::FORSYTH_CACHE_SIZE - 3);
+				cache[pos] = powf(1.0f - (pos - 3) * scale, CACHE_DECAY_POWER);
+			}
+		}
+
+		// boost vertices with few triangles left so lone triangles aren't left behind
+		valence[0] = 0.0f;
+
+		for (u32 count = 1; count <= MAX_VALENCE; ++count)
+			valence[count] = VALENCE_BOOST_SCALE * powf((float)count, -VALENCE_BOOST_POWER);
+	}
+
+	inline float GetScore(const int cachePos, const u32 remainingTris) const
+	{
+		// vertices without triangles are never used again
+		if (remainingTris == 0)
+			return -1.0f;
+
+		const float cacheScore = (cachePos < 0) ? 0.0f : cache[cachePos];
+		return cacheScore + valence[std::min(remainingTris, MAX_VALENCE)];
+	}
+};
+
+static const VertexScoreTables s_ScoreTables;
+
+///////////////////////////////////////////////////////////
+
+struct VertexHasher
+{
+	// vertices are referenced by idx so the map doesn't copy them
+
+	const std::vector<Vertex3D>* pVertices = nullptr;
+
+	size_t operator()(const u32 idx) const
+	{
+		// FNV-1a over bytes of the vertex
+		const uint8_t* bytes = (const uint8_t*)&(*pVertices)[idx];
+		size_t hash = 14695981039346656037ull;
+
+		for (size_t i = 0; i < sizeof(Vertex3D); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+};
+
+struct VertexEqual
+{
+	const std::vector<Vertex3D>* pVertices = nullptr;
+
+	bool operator()(const u32 idx0, const u32 idx1) const
+	{
+		return memcmp(&(*pVertices)[idx0], &(*pVertices)[idx1], sizeof(Vertex3D)) == 0;
+	}
+};
+
+///////////////////////////////////////////////////////////
+
+static u32 SimulateFifoCache(
+	const u32* indices,
+	const u32 trianglesCount,
+	const u32 cacheSize,
+	std::vector<u32>& cacheTimestamps,       // per vertex: the "time" of putting into the cache
+	u32& time,                               // the number of vertices put into the cache so far
+	uint8_t* outTriMisses = nullptr)         // cache misses of each triangle (optional)
+{
+	// a vertex is in the FIFO cache if less than cacheSize vertices
+	// were put into the cache after it; return the number of misses
+
+	u32 missesCount = 0;
+
+	for (u32 tri = 0; tri < trianglesCount; ++tri)
+	{
+		uint8_t triMisses = 0;
+
+		for (u32 i = 0; i < 3; ++i)
+		{
+			const u32 v = indices[tri * 3 + i];
+
+			if (time - cacheTimestamps[v] >= cacheSize)
+			{
+				cacheTimestamps[v] = time++;
+				++triMisses;
+			}
+		}
+
+		if (outTriMisses)
+			outTriMisses[tri] = triMisses;
+
+		missesCount += triMisses;
+	}
+
+	return missesCount;
+}
+
+} // namespace
+
+
+// *********************************************************************************
+
+void MeshOptimizer::Optimize(Mesh::MeshData& mesh, const bool weldVertices)
+{
+	if (weldVertices)
+		WeldVertices(mesh);
+
+	OptimizeVertexCache(mesh);
+	OptimizeOverdraw(mesh);
+	OptimizeVertexFetch(mesh);
+}
+
+///////////////////////////////////////////////////////////
+
+u32 MeshOptimizer::WeldVertices(Mesh::MeshData& mesh)
+{
+	// find vertices which are bitwise equal, keep only the first one of them
+	// and remap indices onto it
+
+	std::vector<Vertex3D>& vertices = mesh.vertices;
+	const u32 verticesCount = (u32)vertices.size();
+
+	std::unordered_map<u32, u32, VertexHasher, VertexEqual> uniqueVertices(
+		verticesCount,
+		VertexHasher{ &vertices },
+		VertexEqual{ &vertices });
+
+	std::vector<u32> remap(verticesCount);
+	std::vector<Vertex3D> outVertices;
+	outVertices.reserve(verticesCount);
+
+	for (u32 idx = 0; idx < verticesCount; ++idx)
+	{
+		const auto [it, isInserted] = uniqueVertices.try_emplace(idx, (u32)outVertices.size());
+
+		if (isInserted)
+			outVertices.push_back(vertices[idx]);
+
+		remap[idx] = it->second;
+	}
+
+	const u32 uniqueCount = (u32)outVertices.size();
+
+	if (uniqueCount == verticesCount)
+		return 0;
+
+	for (UINT& index : mesh.indices)
+		index = remap[index];
+
+	vertices = std::move(outVertices);
+
+	return verticesCount - uniqueCount;
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshOptimizer::OptimizeVertexCache(Mesh::MeshData& mesh)
+{
+	OptimizeVertexCache(mesh.indices, (u32)mesh.vertices.size());
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<UINT>& indices, const u32 verticesCount)
+{
+	// Tom Forsyth's linear-speed vertex cache optimization:
+	// we greedily emit the triangle with the best score; the score of a triangle
+	// is the sum of scores of its vertices which depend on the position of vertex
+	// in the simulated LRU cache and on the number of not emitted triangles of vertex;
+	// after each step only scores of vertices in the cache are updated
+
+	const u32 trianglesCount = (u32)(indices.size() / 3);
+
+	if (trianglesCount == 0)
+		return;
+
+	// build lists of triangles for each vertex
+	std::vector<u32> valence(verticesCount, 0);            // the number of not emitted triangles of the vertex
+	std::vector<u32> trisOffsets(verticesCount + 1, 0);
+	std::vector<u32> vertTris(trianglesCount * 3);
+
+	for (const UINT idx : indices)
+	{
+		Assert::True(idx < verticesCount, "an index of the mesh is out of range");
+		++valence[idx];
+	}
+
+	for (u32 v = 0; v < verticesCount; ++v)
+		trisOffsets[v + 1] = trisOffsets[v] + valence[v];
+
+	{
+		std::vector<u32> fillCount(verticesCount, 0);
+
+		for (u32 tri = 0; tri < trianglesCount; ++tri)
+		{
+			for (u32 i = 0; i < 3; ++i)
+			{
+				const u32 v = indices[tri * 3 + i];
+				vertTris[trisOffsets[v] + fillCount[v]++] = tri;
+			}
+		}
+	}
+
+	// ---------------------------------------------
+
+	std::vector<int>   cachePos(verticesCount, -1);
+	std::vector<float> vertScores(verticesCount);
+	std::vector<bool>  isEmitted(trianglesCount, false);
+
+	for (u32 v = 0; v < verticesCount; ++v)
+		vertScores[v] = s_ScoreTables.GetScore(-1, valence[v]);
+
+	// start from the triangle with the best score
+	u32 bestTri = 0;
+	float bestScore = -1.0f;
+
+	for (u32 tri = 0; tri < trianglesCount; ++tri)
+	{
+		const UINT* triIdxs = &indices[tri * 3];
+		const float score = vertScores[triIdxs[0]] + vertScores[triIdxs[1]] + vertScores[triIdxs[2]];
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestTri = tri;
+		}
+	}
+
+	// the cache has 3 extra slots for vertices which are pushed out by the new triangle
+	u32 cache[FORSYTH_CACHE_SIZE + 3];
+	u32 newCache[FORSYTH_CACHE_SIZE + 3];
+	u32 cacheSize = 0;
+
+	std::vector<UINT> outIndices;
+	outIndices.reserve(indices.size());
+
+	u32 searchCursor = 0;                 // all the triangles before it are already emitted
+
+	for (u32 emittedCount = 0; emittedCount < trianglesCount; ++emittedCount)
+	{
+		if (bestTri == INVALID_IDX)
+		{
+			// there are no triangles in the cache so take the first not emitted one
+			while (isEmitted[searchCursor])
+				++searchCursor;
+
+			bestTri = searchCursor;
+		}
+
+		// emit the triangle and remove it from lists of its vertices
+		const UINT* triIdxs = &indices[bestTri * 3];
+		outIndices.insert(outIndices.end(), triIdxs, triIdxs + 3);
+		isEmitted[bestTri] = true;
+
+		for (u32 i = 0; i < 3; ++i)
+		{
+			const u32 v = triIdxs[i];
+			u32* tris = &vertTris[trisOffsets[v]];
+			u32* last = tris + valence[v] - 1;
+
+			std::iter_swap(std::find(tris, last, bestTri), last);
+			--valence[v];
+		}
+
+		// put vertices of the triangle at the front of the cache (LRU);
+		// (vertices of a degenerate triangle are put only once)
+		u32 newCacheSize = 0;
+
+		for (u32 i = 0; i < 3; ++i)
+		{
+			if (std::find(newCache, newCache + newCacheSize, triIdxs[i]) == newCache + newCacheSize)
+				newCache[newCacheSize++] = triIdxs[i];
+		}
+
+		for (u32 i = 0; i < cacheSize; ++i)
+		{
+			const u32 v = cache[i];
+
+			if ((v != triIdxs[0]) && (v != triIdxs[1]) && (v != triIdxs[2]))
+				newCache[newCacheSize++] = v;
+		}
+
+		// update scores of vertices in the cache (vertices which are pushed out
+		// of the cache get the score without the cache part)
+		for (u32 i = 0; i < newCacheSize; ++i)
+		{
+			const u32 v = newCache[i];
+			cachePos[v] = (i < FORSYTH_CACHE_SIZE) ? (int)i : -1;
+			vertScores[v] = s_ScoreTables.GetScore(cachePos[v], valence[v]);
+		}
+
+		// update scores of triangles which use these vertices and find the best one
+		bestTri = INVALID_IDX;
+		bestScore = -1.0f;
+
+		for (u32 i = 0; i < newCacheSize; ++i)
+		{
+			const u32 v = newCache[i];
+			const u32* tris = &vertTris[trisOffsets[v]];
+
+			for (u32 t = 0; t < valence[v]; ++t)
+			{
+				const u32 tri = tris[t];
+				const UINT* idxs = &indices[tri * 3];
+				const float score = vertScores[idxs[0]] + vertScores[idxs[1]] + vertScores[idxs[2]];
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTri = tri;
+				}
+			}
+		}
+
+		cacheSize = std::min(newCacheSize, FORSYTH_CACHE_SIZE);
+		std::copy(newCache, newCache + cacheSize, cache);
+	}
+
+	indices = std::move(outIndices);
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshOptimizer::OptimizeOverdraw(Mesh::MeshData& mesh, const float threshold)
+{
+	// split the (cache optimized) triangles into clusters and sort the clusters
+	// so the ones which are facing out of the mesh center are drawn first: they
+	// most likely occlude other clusters so pixels behind them are rejected by
+	// the depth test;
+	//
+	// clusters are split where the simulated cache was restarted anyway (all
+	// the vertices of a triangle are misses) and also where a triangle has
+	// 2+ misses if the ACMR of the current cluster is within the threshold;
+	// so the reordering doesn't hurt the vertex cache much
+
+	std::vector<UINT>& indices = mesh.indices;
+	const std::vector<Vertex3D>& vertices = mesh.vertices;
+	const u32 verticesCount = (u32)vertices.size();
+	const u32 trianglesCount = (u32)(indices.size() / 3);
+
+	if (trianglesCount == 0)
+		return;
+
+	std::vector<u32> cacheTimestamps(verticesCount, 0);
+	std::vector<uint8_t> triMisses(trianglesCount);
+	u32 time = FIFO_CACHE_SIZE + 1;       // so initially there are no vertices in the cache
+
+	const u32 missesCount = SimulateFifoCache(indices.data(), trianglesCount, FIFO_CACHE_SIZE, cacheTimestamps, time, triMisses.data());
+	const float maxClusterAcmr = threshold * ((float)missesCount / trianglesCount);
+
+	// ---------------------------------------------
+
+	std::vector<u32> clustersStarts;
+	u32 clusterMisses = 0;
+
+	for (u32 tri = 0; tri < trianglesCount; ++tri)
+	{
+		const u32 clusterTris = (clustersStarts.empty()) ? 0 : tri - clustersStarts.back();
+		const bool isHardBoundary = (triMisses[tri] == 3);
+		const bool isSoftBoundary = (triMisses[tri] >= 2) && (clusterTris > 0) && ((float)clusterMisses / clusterTris <= maxClusterAcmr);
+
+		if (clustersStarts.empty() || isHardBoundary || isSoftBoundary)
+		{
+			clustersStarts.push_back(tri);
+			clusterMisses = 0;
+		}
+
+		clusterMisses += triMisses[tri];
+	}
+
+	const u32 clustersCount = (u32)clustersStarts.size();
+	clustersStarts.push_back(trianglesCount);
+
+	if (clustersCount == 1)
+		return;
+
+	// ---------------------------------------------
+
+	// compute area-weighted centroids and normals of clusters and the center of the mesh
+	std::vector<XMFLOAT3> clustersCentroids(clustersCount);
+	std::vector<XMFLOAT3> clustersNormals(clustersCount);
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.0f;
+
+	for (u32 cluster = 0; cluster < clustersCount; ++cluster)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (u32 tri = clustersStarts[cluster]; tri < clustersStarts[cluster + 1]; ++tri)
+		{
+			const XMVECTOR p0 = XMLoadFloat3(&vertices[indices[tri * 3 + 0]].position);
+			const XMVECTOR p1 = XMLoadFloat3(&vertices[indices[tri * 3 + 1]].position);
+			const XMVECTOR p2 = XMLoadFloat3(&vertices[indices[tri * 3 + 2]].position);
+
+			// the length of the cross product is a doubled area of the triangle
+			const XMVECTOR cross = XMVector3Cross(p1 - p0, p2 - p0);
+			const float triArea = XMVectorGetX(XMVector3Length(cross));
+
+			centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+			normal += cross;
+			area += triArea;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+
+		const float invArea = (area > 0.0f) ? 1.0f / area : 0.0f;
+
+		XMStoreFloat3(&clustersCentroids[cluster], centroid * invArea);
+		XMStoreFloat3(&clustersNormals[cluster], XMVector3Normalize(normal));
+	}
+
+	meshCentroid = meshCentroid * ((meshArea > 0.0f) ? 1.0f / meshArea : 0.0f);
+
+	// the more the cluster is facing out of the mesh center the earlier it is drawn
+	std::vector<float> sortKeys(clustersCount);
+	std::vector<u32> clustersOrder(clustersCount);
+
+	for (u32 cluster = 0; cluster < clustersCount; ++cluster)
+	{
+		const XMVECTOR dir = XMLoadFloat3(&clustersCentroids[cluster]) - meshCentroid;
+		sortKeys[cluster] = XMVectorGetX(XMVector3Dot(dir, XMLoadFloat3(&clustersNormals[cluster])));
+	}
+
+	std::iota(clustersOrder.begin(), clustersOrder.end(), 0);
+	std::stable_sort(clustersOrder.begin(), clustersOrder.end(), [&sortKeys](const u32 c0, const u32 c1)
+	{
+		return sortKeys[c0] > sortKeys[c1];
+	});
+
+	// ---------------------------------------------
+
+	std::vector<UINT> outIndices;
+	outIndices.reserve(indices.size());
+
+	for (const u32 cluster : clustersOrder)
+	{
+		const UINT* begin = indices.data() + clustersStarts[cluster] * 3;
+		const UINT* end   = indices.data() + clustersStarts[cluster + 1] * 3;
+		outIndices.insert(outIndices.end(), begin, end);
+	}
+
+	indices = std::move(outIndices);
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshOptimizer::OptimizeVertexFetch(Mesh::MeshData& mesh)
+{
+	// put vertices in order of their first use by the index buffer so
+	// the vertex fetch goes through the memory (almost) sequentially
+
+	std::vector<Vertex3D>& vertices = mesh.vertices;
+	std::vector<u32> remap(vertices.size(), INVALID_IDX);
+	std::vector<Vertex3D> outVertices;
+	outVertices.reserve(vertices.size());
+
+	for (UINT& index : mesh.indices)
+	{
+		if (remap[index] == INVALID_IDX)
+		{
+			remap[index] = (u32)outVertices.size();
+			outVertices.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(outVertices);
+}
+
+///////////////////////////////////////////////////////////
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(
+	const std::vector<u32>& indices,
+	const u32 verticesCount,
+	const u32 cacheSize)
+{
+	// simulate the FIFO post-transform cache of the input size
+
+	VertexCacheStats stats;
+	const u32 trianglesCount = (u32)(indices.size() / 3);
+
+	if (trianglesCount == 0)
+		return stats;
+
+	std::vector<u32> cacheTimestamps(verticesCount, 0);
+	std::vector<bool> isUsed(verticesCount, false);
+	u32 time = cacheSize + 1;
+	u32 usedCount = 0;
+
+	for (const u32 idx : indices)
+	{
+		usedCount += !isUsed[idx];
+		isUsed[idx] = true;
+	}
+
+	stats.transformedCount = SimulateFifoCache(indices.data(), trianglesCount, cacheSize, cacheTimestamps, time);
+	stats.acmr = (float)stats.transformedCount / trianglesCount;
+	stats.atvr = (float)stats.transformedCount / usedCount;
+
+	return stats;
+}
@@ -0,0 +1,67 @@
+// *********************************************************************************
+// Filename:      MeshOptimizer.h
+// Description:   optimization of indexed meshes for rendering:
+//
+//                1. welding of duplicated vertices (optional);
+//                2. reordering of triangles for the post-transform vertex cache
+//                   (Tom Forsyth's linear-speed vertex cache optimization);
+//                3. reordering of clusters of triangles to reduce overdraw
+//                   (outer clusters are drawn first);
+//                4. reordering of vertices in order of their first use
+//                   so the vertex fetch goes through the memory linearly;
+//
+//                the efficiency of the vertex cache is measured on the CPU
+//                by simulation of a FIFO cache (ACMR/ATVR)
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include "../Common/Types.h"
+
+namespace Mesh
+{
+	struct MeshData;
+}
+
+
+struct VertexCacheStats
+{
+	u32   transformedCount = 0;   // number of vertices which were transformed (cache misses)
+	float acmr = 0.0f;            // average cache miss ratio: transformed vertices per triangle (0.5 is the best for a big grid, 3 is the worst)
+	float atvr = 0.0f;            // average transformed vertex ratio: transformed / used vertices (1 is the best)
+};
+
+///////////////////////////////////////////////////////////
+
+class MeshOptimizer final
+{
+public:
+	static constexpr u32 FORSYTH_CACHE_SIZE = 32;   // the size of LRU cache which is simulated during reordering
+	static constexpr u32 FIFO_CACHE_SIZE    = 16;   // the size of post-transform cache for the metrics
+
+public:
+	// do all the optimizations in the right order
+	void Optimize(Mesh::MeshData& mesh, const bool weldVertices = false);
+
+	// remove vertices which are exactly equal to some other vertex;
+	// return: the number of removed vertices
+	u32 WeldVertices(Mesh::MeshData& mesh);
+
+	void OptimizeVertexCache(Mesh::MeshData& mesh);
+
+	// the same but only for indices (for instance: indices of a LOD which uses vertices of the mesh)
+	void OptimizeVertexCache(std::vector<u32>& indices, const u32 verticesCount);
+
+	// threshold: how many times the ACMR can grow because of splitting into finer clusters
+	void OptimizeOverdraw(Mesh::MeshData& mesh, const float threshold = 1.05f);
+
+	// unused vertices are removed
+	void OptimizeVertexFetch(Mesh::MeshData& mesh);
+
+	static VertexCacheStats AnalyzeVertexCache(
+		const std::vector<u32>& indices,
+		const u32 verticesCount,
+		const u32 cacheSize = FIFO_CACHE_SIZE);
+};
@@ -0,0 +1,520 @@
+// *********************************************************************************
+// Filename:      MeshSimplifier.cpp
+// Description:   implementation of the MeshSimplifier functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "MeshHelperTypes.h"
+#include "../Common/Assert.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+
+namespace
+{
+
+constexpr u32   INVALID_IDX  = 0xFFFFFFFF;
+constexpr u32   MAX_PASSES   = 100;
+
+// a collapse is rejected if some triangle is rotated by it more than by ~75 degrees
+constexpr float MIN_FLIP_COS = 0.25f;
+
+///////////////////////////////////////////////////////////
+
+struct Quadric
+{
+	// the sum of squared distances to planes of triangles (weighted by their areas):
+	// Q(p) = p*A*p + 2*b*p + c, where A is a symmetric 3x3 matrix
+
+	double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+	double b0  = 0, b1  = 0, b2  = 0;
+	double c   = 0;
+	double weight = 0;
+
+	void AddPlane(const double n[3], const double d, const double w)
+	{
+		a00 += w * n[0] * n[0];  a01 += w * n[0] * n[1];  a02 += w * n[0] * n[2];
+		a11 += w * n[1] * n[1];  a12 += w * n[1] * n[2];  a22 += w * n[2] * n[2];
+
+		b0 += w * d * n[0];
+		b1 += w * d * n[1];
+		b2 += w * d * n[2];
+		c  += w * d * d;
+
+		weight += w;
+	}
+
+	void Add(const Quadric& q)
+	{
+		a00 += q.a00;  a01 += q.a01;  a02 += q.a02;
+		a11 += q.a11;  a12 += q.a12;  a22 += q.a22;
+		b0  += q.b0;   b1  += q.b1;   b2  += q.b2;
+		c   += q.c;
+		weight += q.weight;
+	}
+
+	double Eval(const XMFLOAT3& p) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+
+		const double r =
+			x * (a00 * x + 2.0 * (a01 * y + a02 * z + b0)) +
+			y * (a11 * y + 2.0 * (a12 * z + b1)) +
+			z * (a22 * z + 2.0 * b2) + c;
+
+		return std::max(r, 0.0);
+	}
+};
+
+///////////////////////////////////////////////////////////
+
+struct Collapse
+{
+	u32   from;      // vertex which is removed
+	u32   to;        // vertex which stays
+	float cost;      // squared error
+};
+
+///////////////////////////////////////////////////////////
+
+struct PositionHasher
+{
+	const std::vector<Vertex3D>* pVertices = nullptr;
+
+	size_t operator()(const u32 idx) const
+	{
+		// FNV-1a over bytes of the position
+		const uint8_t* bytes = (const uint8_t*)&(*pVertices)[idx].position;
+		size_t hash = 14695981039346656037ull;
+
+		for (size_t i = 0; i < sizeof(XMFLOAT3); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+};
+
+struct PositionEqual
+{
+	const std::vector<Vertex3D>* pVertices = nullptr;
+
+	bool operator()(const u32 idx0, const u32 idx1) const
+	{
+		return memcmp(&(*pVertices)[idx0].position, &(*pVertices)[idx1].position, sizeof(XMFLOAT3)) == 0;
+	}
+};
+
+///////////////////////////////////////////////////////////
+
+static XMVECTOR ComputeNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+{
+	// a not normalized normal of the triangle (its length is twice the area)
+	const XMVECTOR v0 = XMLoadFloat3(&p0);
+	return XMVector3Cross(XMLoadFloat3(&p1) - v0, XMLoadFloat3(&p2) - v0);
+}
+
+///////////////////////////////////////////////////////////
+
+static void BuildVertexTriangles(
+	const std::vector<u32>& indices,
+	const std::vector<u32>& positionIdxs,
+	const u32 verticesCount,
+	std::vector<u32>& outOffsets,
+	std::vector<u32>& outTriangles)
+{
+	// build lists of triangles for each position (CSR arrays)
+
+	const u32 trianglesCount = (u32)(indices.size() / 3);
+
+	outOffsets.assign(verticesCount + 1, 0);
+	outTriangles.resize(indices.size());
+
+	for (const u32 idx : indices)
+		++outOffsets[positionIdxs[idx] + 1];
+
+	for (u32 v = 0; v < verticesCount; ++v)
+		outOffsets[v + 1] += outOffsets[v];
+
+	std::vector<u32> fillCount(outOffsets.begin(), outOffsets.end() - 1);
+
+	for (u32 tri = 0; tri < trianglesCount; ++tri)
+	{
+		for (u32 i = 0; i < 3; ++i)
+			outTriangles[fillCount[positionIdxs[indices[tri * 3 + i]]]++] = tri;
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static void LockBorderAndSeamVertices(
+	const std::vector<u32>& indices,
+	const std::vector<u32>& positionIdxs,
+	std::vector<bool>& outLocked)
+{
+	// lock positions on borders (an edge has only one triangle), on non-manifold
+	// edges (an edge has more than two triangles) and on attribute seams
+	// (a few different vertices are used in the same position)
+
+	const size_t indicesCount = indices.size();
+	std::vector<uint64_t> edges;
+	edges.reserve(indicesCount);
+
+	for (size_t i = 0; i < indicesCount; i += 3)
+	{
+		for (u32 e = 0; e < 3; ++e)
+		{
+			const uint64_t p0 = positionIdxs[indices[i + e]];
+			const uint64_t p1 = positionIdxs[indices[i + (e + 1) % 3]];
+
+			edges.push_back((std::min(p0, p1) << 32) | std::max(p0, p1));
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+
+	for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+	{
+		while (end < edges.size() && edges[end] == edges[begin])
+			++end;
+
+		if (end - begin != 2)
+		{
+			outLocked[(u32)(edges[begin] >> 32)] = true;
+			outLocked[(u32)(edges[begin] & 0xFFFFFFFF)] = true;
+		}
+	}
+
+	// seams: a position is used by some vertex which isn't the first one in this position
+	std::vector<u32> usedVertex(outLocked.size(), INVALID_IDX);
+
+	for (const u32 idx : indices)
+	{
+		u32& used = usedVertex[positionIdxs[idx]];
+
+		if (used == INVALID_IDX)
+			used = idx;
+		else if (used != idx)
+			outLocked[positionIdxs[idx]] = true;
+	}
+}
+
+} // namespace
+
+
+
+// *********************************************************************************
+
+float MeshSimplifier::Simplify(
+	const std::vector<Vertex3D>& vertices,
+	const std::vector<u32>& indices,
+	const u32 targetIndexCount,
+	const float maxError,
+	std::vector<u32>& outIndices)
+{
+	// each pass computes costs of all the possible collapses and applies the cheapest
+	// of them; after a collapse the 1-ring of the removed vertex is locked till the
+	// end of the pass so collapses of the same pass don't affect each other
+
+	const u32 verticesCount = (u32)vertices.size();
+	const double maxCost = (double)maxError * maxError;
+
+	outIndices = indices;
+
+	if (indices.size() <= targetIndexCount)
+		return 0.0f;
+
+	// ---------------------------------------------
+	// vertices in the same position are simplified as one position
+	// (position idx == idx of the first vertex in this position)
+
+	std::unordered_map<u32, u32, PositionHasher, PositionEqual> uniquePositions(
+		verticesCount,
+		PositionHasher{ &vertices },
+		PositionEqual{ &vertices });
+
+	std::vector<u32> positionIdxs(verticesCount);
+
+	for (u32 idx = 0; idx < verticesCount; ++idx)
+		positionIdxs[idx] = uniquePositions.try_emplace(idx, idx).first->second;
+
+	// ---------------------------------------------
+	// compute quadrics of positions using planes of their triangles
+
+	std::vector<Quadric> quadrics(verticesCount);
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		Assert::True(std::max({ indices[i], indices[i + 1], indices[i + 2] }) < verticesCount, "an index of the mesh is out of range");
+
+		const XMFLOAT3& p0 = vertices[indices[i + 0]].position;
+		const XMFLOAT3& p1 = vertices[indices[i + 1]].position;
+		const XMFLOAT3& p2 = vertices[indices[i + 2]].position;
+
+		XMFLOAT3 normal;
+		XMStoreFloat3(&normal, ComputeNormal(p0, p1, p2));
+
+		const double length = sqrt((double)normal.x * normal.x + (double)normal.y * normal.y + (double)normal.z * normal.z);
+
+		if (length == 0.0)
+			continue;
+
+		const double n[3] = { normal.x / length, normal.y / length, normal.z / length };
+		const double d    = -(n[0] * p0.x + n[1] * p0.y + n[2] * p0.z);
+		const double area = 0.5 * length;
+
+		for (u32 v = 0; v < 3; ++v)
+			quadrics[positionIdxs[indices[i + v]]].AddPlane(n, d, area);
+	}
+
+	// ---------------------------------------------
+
+	std::vector<u32>      trisOffsets;
+	std::vector<u32>      vertTris;
+	std::vector<bool>     locked(verticesCount);
+	std::vector<bool>     passLocked(verticesCount);
+	std::vector<u32>      collapseTo(verticesCount);
+	std::vector<Collapse> collapses;
+	std::vector<u32>      neighbours;
+
+	double resultCost = 0.0;
+
+	for (u32 pass = 0; (pass < MAX_PASSES) && (outIndices.size() > targetIndexCount); ++pass)
+	{
+		const u32 trianglesCount = (u32)(outIndices.size() / 3);
+		const u32 targetTrianglesCount = targetIndexCount / 3;
+
+		BuildVertexTriangles(outIndices, positionIdxs, verticesCount, trisOffsets, vertTris);
+
+		locked.assign(verticesCount, false);
+		LockBorderAndSeamVertices(outIndices, positionIdxs, locked);
+
+		// gather possible collapses by edges of triangles (in both directions)
+		collapses.clear();
+
+		for (size_t i = 0; i < outIndices.size(); i += 3)
+		{
+			for (u32 e = 0; e < 3; ++e)
+			{
+				const u32 v0 = outIndices[i + e];
+				const u32 v1 = outIndices[i + (e + 1) % 3];
+				const u32 p0 = positionIdxs[v0];
+				const u32 p1 = positionIdxs[v1];
+
+				if (p0 == p1)
+					continue;
+
+				// the cost of moving p0 into p1 differs from the opposite one
+				Quadric q = quadrics[p0];
+				q.Add(quadrics[p1]);
+
+				const double invWeight = (q.weight > 0.0) ? 1.0 / q.weight : 0.0;
+
+				if (!locked[p0])
+					collapses.push_back({ v0, v1, (float)(q.Eval(vertices[v1].position) * invWeight) });
+
+				if (!locked[p1])
+					collapses.push_back({ v1, v0, (float)(q.Eval(vertices[v0].position) * invWeight) });
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& c0, const Collapse& c1)
+		{
+			return c0.cost < c1.cost;
+		});
+
+		// ---------------------------------------------
+		// apply the cheapest collapses
+
+		passLocked.assign(verticesCount, false);
+		collapseTo.assign(verticesCount, INVALID_IDX);
+
+		u32 removedCount = 0;
+		u32 collapsesCount = 0;
+
+		for (const Collapse& collapse : collapses)
+		{
+			if ((collapse.cost > maxCost) || (trianglesCount - removedCount <= targetTrianglesCount))
+				break;
+
+			const u32 p0 = positionIdxs[collapse.from];
+			const u32 p1 = positionIdxs[collapse.to];
+
+			if (passLocked[p0] || passLocked[p1])
+				continue;
+
+			// check that the collapse doesn't flip triangles and doesn't glue
+			// the surface (the ends of the edge can have only 2 common neighbours)
+			const XMFLOAT3& newPos = vertices[collapse.to].position;
+			u32 edgeTrianglesCount = 0;
+			bool isValid = true;
+
+			neighbours.clear();
+
+			for (u32 t = trisOffsets[p0]; (t < trisOffsets[p0 + 1]) && isValid; ++t)
+			{
+				const u32* tri = &outIndices[vertTris[t] * 3];
+				XMFLOAT3 pos[3];
+				bool hasP1 = false;
+
+				for (u32 i = 0; i < 3; ++i)
+				{
+					const u32 p = positionIdxs[tri[i]];
+
+					hasP1 |= (p == p1);
+					pos[i] = vertices[tri[i]].position;
+
+					if (p != p0)
+						neighbours.push_back(p);
+				}
+
+				if (hasP1)
+				{
+					++edgeTrianglesCount;
+					continue;
+				}
+
+				const XMVECTOR oldNormal = ComputeNormal(pos[0], pos[1], pos[2]);
+
+				for (u32 i = 0; i < 3; ++i)
+				{
+					if (positionIdxs[tri[i]] == p0)
+						pos[i] = newPos;
+				}
+
+				const XMVECTOR newNormal = ComputeNormal(pos[0], pos[1], pos[2]);
+				const float dot     = XMVectorGetX(XMVector3Dot(oldNormal, newNormal));
+				const float lengths = XMVectorGetX(XMVector3Length(oldNormal) * XMVector3Length(newNormal));
+
+				isValid = (dot > MIN_FLIP_COS * lengths);
+			}
+
+			if (!isValid)
+				continue;
+
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+			u32 commonCount = 0;
+
+			for (u32 t = trisOffsets[p1]; t < trisOffsets[p1 + 1]; ++t)
+			{
+				const u32* tri = &outIndices[vertTris[t] * 3];
+
+				for (u32 i = 0; i < 3; ++i)
+				{
+					const u32 p = positionIdxs[tri[i]];
+
+					if ((p != p0) && (p != p1) && std::binary_search(neighbours.begin(), neighbours.end(), p))
+					{
+						++commonCount;
+
+						// count each common neighbour only once
+						neighbours.erase(std::lower_bound(neighbours.begin(), neighbours.end(), p));
+					}
+				}
+			}
+
+			if (commonCount > edgeTrianglesCount)
+				continue;
+
+			// --------------------------------
+
+			collapseTo[p0] = collapse.to;
+			quadrics[p1].Add(quadrics[p0]);
+			resultCost = std::max(resultCost, (double)collapse.cost);
+
+			removedCount += edgeTrianglesCount;
+			++collapsesCount;
+
+			// lock the 1-ring of the removed vertex
+			for (u32 t = trisOffsets[p0]; t < trisOffsets[p0 + 1]; ++t)
+			{
+				const u32* tri = &outIndices[vertTris[t] * 3];
+
+				for (u32 i = 0; i < 3; ++i)
+					passLocked[positionIdxs[tri[i]]] = true;
+			}
+		}
+
+		if (collapsesCount == 0)
+			break;
+
+		// ---------------------------------------------
+		// remap indices and remove degenerate triangles
+
+		size_t writeIdx = 0;
+
+		for (size_t i = 0; i < outIndices.size(); i += 3)
+		{
+			u32 tri[3];
+
+			for (u32 v = 0; v < 3; ++v)
+			{
+				const u32 idx = outIndices[i + v];
+				const u32 to  = collapseTo[positionIdxs[idx]];
+
+				tri[v] = (to != INVALID_IDX) ? to : idx;
+			}
+
+			const u32 p0 = positionIdxs[tri[0]];
+			const u32 p1 = positionIdxs[tri[1]];
+			const u32 p2 = positionIdxs[tri[2]];
+
+			if ((p0 == p1) || (p1 == p2) || (p0 == p2))
+				continue;
+
+			outIndices[writeIdx++] = tri[0];
+			outIndices[writeIdx++] = tri[1];
+			outIndices[writeIdx++] = tri[2];
+		}
+
+		outIndices.resize(writeIdx);
+	}
+
+	return (float)sqrt(resultCost);
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshSimplifier::GenerateLODs(Mesh::MeshData& mesh, const u32 maxLodsCount)
+{
+	// errors of LODs are accumulated since each LOD is made from the previous one
+
+	MeshOptimizer optimizer;
+	const u32 verticesCount = (u32)mesh.vertices.size();
+
+	mesh.lods.clear();
+
+	for (u32 lodIdx = 1; lodIdx < maxLodsCount; ++lodIdx)
+	{
+		const std::vector<UINT>& prevIndices = (lodIdx == 1) ? mesh.indices : mesh.lods.back().indices;
+		const float prevError = (lodIdx == 1) ? 0.0f : mesh.lods.back().error;
+		const u32 targetTrianglesCount = (u32)(prevIndices.size() / 3 * LOD_REDUCTION);
+
+		if (targetTrianglesCount < MIN_LOD_TRIANGLES)
+			break;
+
+		Mesh::LOD lod;
+		const float error = Simplify(mesh.vertices, prevIndices, targetTrianglesCount * 3, FLT_MAX, lod.indices);
+
+		// the mesh can't be simplified more (for instance: most of vertices are on seams)
+		if (lod.indices.size() > prevIndices.size() * MIN_REDUCTION)
+			break;
+
+		lod.error = prevError + error;
+		optimizer.OptimizeVertexCache(lod.indices, verticesCount);
+
+		mesh.lods.push_back(std::move(lod));
+	}
+}
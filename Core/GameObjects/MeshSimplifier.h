@@ -0,0 +1,52 @@
+// *********************************************************************************
+// Filename:      MeshSimplifier.h
+// Description:   simplification of indexed meshes and generation of chains of LODs;
+//
+//                edges are collapsed in order of the quadric error (Garland-Heckbert):
+//                a vertex is moved into another end of the edge so simplified triangles
+//                use the same vertices as the origin mesh (only indices are changed)
+//                and all the LODs of a mesh share its vertex buffer;
+//
+//                vertices on borders, attribute seams (a few vertices in the same
+//                position) and non-manifold edges are locked so the outline of
+//                the mesh and its texture mapping are kept
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include "../Common/Types.h"
+
+class Vertex3D;
+
+namespace Mesh
+{
+	struct MeshData;
+}
+
+///////////////////////////////////////////////////////////
+
+class MeshSimplifier final
+{
+public:
+	static constexpr u32   MAX_LODS_COUNT    = 4;       // including LOD 0 (the origin mesh)
+	static constexpr float LOD_REDUCTION     = 0.5f;    // how many triangles of the previous LOD the next LOD has
+	static constexpr float MIN_REDUCTION     = 0.8f;    // if a LOD has more triangles than this part of the previous one we stop the chain
+	static constexpr u32   MIN_LOD_TRIANGLES = 64;      // LODs with less triangles aren't generated
+
+public:
+	// collapse edges until the number of indices is not greater than the target
+	// or there is no collapse with the error below the max error;
+	// return: the geometric error of the simplified mesh (in units of the mesh space)
+	float Simplify(
+		const std::vector<Vertex3D>& vertices,
+		const std::vector<u32>& indices,
+		const u32 targetIndexCount,
+		const float maxError,
+		std::vector<u32>& outIndices);
+
+	// generate a chain of LODs of the mesh (each next LOD is simplified from
+	// the previous one) and store them into mesh.lods
+	void GenerateLODs(Mesh::MeshData& mesh, const u32 maxLodsCount = MAX_LODS_COUNT);
+};
@@ -311,6 +311,22 @@ void MeshStorage::GetMeshesDataForRendering(
 			outData.indexCount_.push_back(ib.GetIndexCount());
 		}
 
+		// get index buffers of LODs of each mesh
+		for (const ptrdiff_t idx : idxs)
+		{
+			std::vector<Mesh::DataForRendering::LodData>& lods = outData.lods_.emplace_back();
+			const std::vector<IndexBuffer>& lodsIBs = lodsIndexBuffers_[idx];
+
+			lods.resize(lodsIBs.size());
+
+			for (size_t lodIdx = 0; lodIdx < lodsIBs.size(); ++lodIdx)
+			{
+				lods[lodIdx].pIB        = lodsIBs[lodIdx].Get();
+				lods[lodIdx].indexCount = lodsIBs[lodIdx].GetIndexCount();
+				lods[lodIdx].error      = lodsErrors_[idx][lodIdx];
+			}
+		}
+
 		// get arr of textures shader resource views for each mesh
 		for (const ptrdiff_t idx : idxs)
 			outData.texIDs_.push_back(textures_[idx]);
@@ -345,6 +361,7 @@ void MeshStorage::SetTextureForMeshByID(
 	{
 		const DataIdx meshIdx = meshIdToDataIdx_.at(meshID);
 		textures_[meshIdx][type] = texID;
+		++texAndMaterialsVersion_;
 	}
 	catch (const std::out_of_range& e)
 	{
@@ -372,6 +389,8 @@ void MeshStorage::SetTexturesForMeshByID(
 			// it.second - texture ID
 			textures_[meshIdx][it.first] = it.second;
 		}
+
+		++texAndMaterialsVersion_;
 	}
 	catch (const std::out_of_range& e)
 	{
@@ -390,6 +409,7 @@ void MeshStorage::SetMaterialForMeshByID(
 	{
 		const UINT idx = meshIdToDataIdx_.at(meshID);
 		materials_[idx] = material;
+		++texAndMaterialsVersion_;
 	}
 	catch (const std::out_of_range& e)
 	{
@@ -472,12 +492,25 @@ const UINT MeshStorage::CreateMeshHelper(
 		vertexBuffers_.emplace_back(pDevice, data.vertices, false);
 		indexBuffers_.emplace_back(pDevice, data.indices);
 
+		// create index buffers for LODs of the mesh (if there are any)
+		std::vector<IndexBuffer>& lodsIBs = lodsIndexBuffers_.emplace_back();
+		std::vector<float>& lodsErrors = lodsErrors_.emplace_back();
+
+		lodsIBs.reserve(data.lods.size());
+		lodsErrors.reserve(data.lods.size());
+
+		for (const Mesh::LOD& lod : data.lods)
+		{
+			lodsIBs.emplace_back(pDevice, lod.indices);
+			lodsErrors.push_back(lod.error);
+		}
+
 		textures_.push_back(data.texIDs);
 		aabb_.push_back(data.AABB);
 		materials_.push_back(data.material);
 
 		// return data index of the last added mesh
-		return static_cast<UINT>(vertexBuffers_.size() - 1);
+		return static_cast<UINT>(names_.size() - 1);
 	}
 
 	catch (EngineException& e)
@@ -92,6 +92,10 @@ public:
 		const std::vector<MeshID>& meshesIDs, 
 		Mesh::DataForRendering& outData);
 
+	// is increased each time when textures or a material of some mesh are changed
+	// (so cached rendering data of meshes can be updated)
+	inline u32 GetTexAndMaterialsVersion() const { return texAndMaterialsVersion_; }
+
 	// *****************************************************************************
 	//                        Public setters API
 	// *****************************************************************************
@@ -124,13 +128,17 @@ public:
 
 	static MeshStorage* pInstance_;      
 
-	std::map<MeshID, DataIdx>           meshIdToDataIdx_;
+	std::map<MeshID, DataIdx>             meshIdToDataIdx_;
+
+	//std::vector<MeshPath>               srcDataFilepaths_;   // from where was the mesh loaded (or where to store the mesh if it was dynamically generated)
+	std::vector<MeshName>                 names_;               // name of the mesh
+	std::vector<VertexBuffer<Vertex3D>>   vertexBuffers_;
+	std::vector<IndexBuffer>              indexBuffers_;	
+	std::vector<std::vector<IndexBuffer>> lodsIndexBuffers_;    // index buffers of LODs 1..N of each mesh (LODs use the vertex buffer of the mesh)
+	std::vector<std::vector<float>>       lodsErrors_;          // geometric error of each LOD (in units of the mesh space)
+	std::vector<std::vector<TexID>>       textures_;            // each mesh has its ows set of textures
+	std::vector<DirectX::BoundingBox>     aabb_;
+	std::vector<Mesh::Material>           materials_;
 
-	//std::vector<MeshPath>             srcDataFilepaths_;   // from where was the mesh loaded (or where to store the mesh if it was dynamically generated)
-	std::vector<MeshName>               names_;             // name of the mesh
-	std::vector<VertexBuffer<Vertex3D>> vertexBuffers_;
-	std::vector<IndexBuffer>            indexBuffers_;	
-	std::vector<std::vector<TexID>>     textures_;          // each mesh has its ows set of textures
-	std::vector<DirectX::BoundingBox>   aabb_;
-	std::vector<Mesh::Material>         materials_;
+	u32                                   texAndMaterialsVersion_ = 0;
 };
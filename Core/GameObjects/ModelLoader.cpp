@@ -6,6 +6,8 @@
 ////////////////////////////////////////////////////////////////////
 #include "../GameObjects/ModelLoader.h"
 #include "../GameObjects/ModelMath.h"
+#include "../GameObjects/MeshOptimizer.h"
+#include "../GameObjects/MeshSimplifier.h"
 #include "../GameObjects/TextureManager.h"
 #include "../GameObjects/ModelLoaderHelpers.h"
 
@@ -17,12 +19,30 @@
 #include "../Common/Utils.h"
 
 #include <algorithm>                      // for using std::replace()
+#include <chrono>
 
 
 using namespace DirectX;
 using namespace Mesh;
 
 
+static bool HasEmbeddedTexture(
+	const std::vector<ModelLoader::MeshTexture>& textures,
+	const TexPath& path)
+{
+	// check if an embedded texture by such path was already created during
+	// the current import (the last element is the texture which is being added)
+
+	for (size_t i = 0; i + 1 < textures.size(); ++i)
+	{
+		if (textures[i].isEmbedded && (textures[i].path == path))
+			return true;
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////
 
 void ModelLoader::LoadFromFile(ID3D11Device* pDevice,
 	std::vector<MeshData>& rawMeshes,
@@ -31,11 +51,35 @@ void ModelLoader::LoadFromFile(ID3D11Device* pDevice,
 	// this function initializes a new model from the file 
 	// of type .blend, .fbx, .3ds, .obj, etc.
 
+	std::vector<MeshTexture> textures;
+
+	ImportFromFile(pDevice, rawMeshes, filePath, textures);
+	RegisterTextures(textures, rawMeshes);
+}
+
+///////////////////////////////////////////////////////////
+
+void ModelLoader::ImportFromFile(
+	ID3D11Device* pDevice,
+	std::vector<MeshData>& rawMeshes,
+	const std::string& filePath,
+	std::vector<MeshTexture>& outTextures)
+{
+	// import meshes of the model; textures which are used by these meshes
+	// are returned by outTextures (see RegisterTextures())
+
 	Assert::NotEmpty(filePath.empty(), "the input filePath is empty");
 
+	using clock = std::chrono::steady_clock;
+
+	textures_.clear();
+	readFileTime_ = 0;
+	processTime_ = 0;
+
 	try
 	{
 		Assimp::Importer importer;
+		const clock::time_point readStart = clock::now();
 #if 0
 		const aiScene* pScene = importer.ReadFile(
 			filePath,
@@ -44,15 +88,14 @@ void ModelLoader::LoadFromFile(ID3D11Device* pDevice,
 
 #endif
 
-		const aiScene* pScene = importer.ReadFile(
-			filePath, 
-			aiProcessPreset_TargetRealtime_MaxQuality |
-			aiProcess_ConvertToLeftHanded |
-			aiProcess_GenNormals);
+		const aiScene* pScene = importer.ReadFile(filePath, IMPORT_FLAGS);
 
 		// assert that we successfully read the data file 
 		Assert::NotNullptr(pScene, "can't read a model's data file: " + filePath);
 
+		const clock::time_point processStart = clock::now();
+		readFileTime_ = std::chrono::duration<float, std::milli>(processStart - readStart).count();
+
 		// load all the meshes/materials/textures of this model
 		ProcessNode(pDevice, 
 			rawMeshes,
@@ -62,6 +105,9 @@ void ModelLoader::LoadFromFile(ID3D11Device* pDevice,
 			filePath);
 
 		importer.FreeScene();
+
+		processTime_ = std::chrono::duration<float, std::milli>(clock::now() - processStart).count();
+		outTextures = std::move(textures_);
 	}
 	catch (EngineException & e)
 	{
@@ -70,6 +116,43 @@ void ModelLoader::LoadFromFile(ID3D11Device* pDevice,
 	}
 }
 
+///////////////////////////////////////////////////////////
+
+void ModelLoader::RegisterTextures(
+	std::vector<MeshTexture>& textures,
+	std::vector<MeshData>& meshes)
+{
+	// add textures of imported meshes into the texture manager (textures which
+	// are already there are just shared) and setup meshes with them;
+	// if some texture can't be loaded the mesh keeps the default (unloaded) one
+
+	TextureManager* pTexMgr = TextureManager::Get();
+
+	for (MeshTexture& tex : textures)
+	{
+		try
+		{
+			TexID id = TextureManager::TEX_ID_UNLOADED;
+
+			if (pTexMgr->GetTexPtrByName(tex.path) != nullptr)
+				id = pTexMgr->GetIDByName(tex.path);
+
+			else if (tex.isEmbedded)
+				id = pTexMgr->Add(tex.path, std::move(tex.embeddedTex));
+
+			else
+				id = pTexMgr->LoadFromFile(tex.path);
+
+			meshes[tex.meshIdx].texIDs[tex.type] = id;
+		}
+		catch (EngineException& e)
+		{
+			Log::Error(e);
+			Log::Error("can't load a texture: " + tex.path);
+		}
+	}
+}
+
 
 
 
@@ -143,8 +226,17 @@ void ModelLoader::ProcessMesh(ID3D11Device* pDevice,
 		// fill in arrays with vertices/indices data
 		GetVerticesAndIndicesFromMesh(pMesh, meshData);
 
+		// reorder triangles and vertices for the vertex cache/overdraw
+		// (identical vertices are already joined by assimp)
+		MeshOptimizer meshOptimizer;
+		meshOptimizer.Optimize(meshData);
+
+		// generate a chain of simplified LODs (they use vertices of the mesh)
+		MeshSimplifier meshSimplifier;
+		meshSimplifier.GenerateLODs(meshData);
+
 		// do some math calculations with these vertices (for instance: computation of tangents/bitangents)
-		ExecuteModelMathCalculations(meshData.vertices);
+		ExecuteModelMathCalculations(meshData);
 
 		// get material data of this mesh
 		aiMaterial* pMaterial = pScene->mMaterials[pMesh->mMaterialIndex];
@@ -157,6 +249,7 @@ void ModelLoader::ProcessMesh(ID3D11Device* pDevice,
 			pMaterial,
 			pScene,
 			filePath,
+			(u32)rawMeshes.size() - 1,
 			meshData);
 		
 	}
@@ -170,7 +263,7 @@ void ModelLoader::ProcessMesh(ID3D11Device* pDevice,
 		Log::Error(e);
 
 		// maybe we just can't load textures for this mesh so set them to default (unloaded)
-		const TexID unloadedTexID = TextureManager::Get()->GetIDByName("unloaded");
+		const TexID unloadedTexID = TextureManager::TEX_ID_UNLOADED;
 		meshData.texIDs.resize(TextureClass::TEXTURE_TYPE_COUNT, unloadedTexID);
 	}
 }
@@ -232,18 +325,18 @@ void ModelLoader::LoadMaterialTextures(
 	aiMaterial* pMaterial,
 	const aiScene* pScene,
 	const std::string& filePath,
+	const u32 meshIdx,
 	MeshData& meshData)
 {
 	//
-	// load all the available textures for this mesh by its material data
+	// gather all the available textures for this mesh by its material data;
+	// (the texture manager isn't touched here: textures are registered later)
 	//
 	
 	// set all the textures of this mesh material to default value
-	const TexID unloadedTexID = TextureManager::Get()->GetIDByName("unloaded");
+	const TexID unloadedTexID = TextureManager::TEX_ID_UNLOADED;
 	meshData.texIDs.resize(TextureClass::TEXTURE_TYPE_COUNT, unloadedTexID);
 
-
-	TextureManager* pTexMgr = TextureManager::Get();
 	std::vector<aiTextureType> texTypesToLoad;
 	std::vector<UINT> texCounts;
 
@@ -288,31 +381,30 @@ void ModelLoader::LoadMaterialTextures(
 			// load a texture which is located on the disk
 			case TextureStorageType::Disk:
 			{
-				// load a texture by path and setup the material with this texture
-				const TexID id = pTexMgr->LoadFromFile(modelDirPath + path.C_Str());
-				meshData.texIDs[type] = id;
-
+				// the texture will be loaded by path during registration
+				textures_.push_back({ meshIdx, (u32)type, modelDirPath + path.C_Str() });
 				break;
 			}
 
 			// load an embedded compressed texture
 			case TextureStorageType::EmbeddedCompressed:
 			{
-				const aiTexture* pAiTexture = pScene->GetEmbeddedTexture(path.C_Str());
 				const TexPath texPath = filePath + path.C_Str();
-
-				// create a new embedded texture object
-				TextureClass embeddedTexture = TextureClass(
-					pDevice,
-					texPath,
-					(uint8_t*)(pAiTexture->pcData),          // data of texture
-					pAiTexture->mWidth);                     // size of texture
-					
-
-				// store this embedded texture into the texture manager
-				// and setup the material with this new texture
-				const TexID id = pTexMgr->Add(texPath, embeddedTexture);
-				meshData.texIDs[type] = id;
+				textures_.push_back({ meshIdx, (u32)type, texPath, true });
+
+				// the same embedded texture can be used by several meshes
+				// so we create a texture object only once
+				if (!HasEmbeddedTexture(textures_, texPath))
+				{
+					const aiTexture* pAiTexture = pScene->GetEmbeddedTexture(path.C_Str());
+
+					// create a new embedded texture object
+					textures_.back().embeddedTex = TextureClass(
+						pDevice,
+						texPath,
+						(uint8_t*)(pAiTexture->pcData),          // data of texture
+						pAiTexture->mWidth);                     // size of texture
+				}
 
 				break;
 			}
@@ -325,19 +417,17 @@ void ModelLoader::LoadMaterialTextures(
 				const std::string fileName = StringHelper::GetFileName(filePath);
 
 				const TexPath texName = fileName + "_" + meshData.name + "_" + namesOfTexTypes[type] + "_" + path.C_Str()[1];
-
-				// create a new embedded indexed texture object;
-				TextureClass embeddedIndexedTexture = TextureClass(
-					pDevice,
-					texName,
-					(uint8_t*)(pScene->mTextures[index]->pcData),  // data of texture
-					pScene->mTextures[index]->mWidth);             // size of texture
-					
-
-				// store this embedded texture into the texture manager
-				// and setup the material with this new texture
-				const TexID id = pTexMgr->Add(texName, embeddedIndexedTexture);
-				meshData.texIDs[type] = id;
+				textures_.push_back({ meshIdx, (u32)type, texName, true });
+
+				if (!HasEmbeddedTexture(textures_, texName))
+				{
+					// create a new embedded indexed texture object;
+					textures_.back().embeddedTex = TextureClass(
+						pDevice,
+						texName,
+						(uint8_t*)(pScene->mTextures[index]->pcData),  // data of texture
+						pScene->mTextures[index]->mWidth);             // size of texture
+				}
 
 				break;
 
@@ -410,12 +500,12 @@ void ModelLoader::GetVerticesAndIndicesFromMesh(
 
 ///////////////////////////////////////////////////////////
 
-void ModelLoader::ExecuteModelMathCalculations(std::vector<Vertex3D> & verticesArr)
+void ModelLoader::ExecuteModelMathCalculations(Mesh::MeshData& meshData)
 {
 	// is used for calculations of the model's normal vector, binormal, etc.
 	ModelMath modelMath;
 
-	// after the model data has been loaded we now call the CalculateModelVectors() to
-	// calculate the tangent and binormal. It also recalculates the normal vector;
-	modelMath.CalculateModelVectors(verticesArr, false);
+	// after the model data has been loaded we compute per-vertex tangents and binormals
+	// of the indexed mesh (normals are already generated by assimp)
+	modelMath.CalculateMeshTangents(meshData, pThreadPool_);
 }
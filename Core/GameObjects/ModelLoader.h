@@ -19,8 +19,15 @@
 #include <assimp/scene.h>
 
 #include "MeshHelperTypes.h"
+#include "textureclass.h"
+#include "../Common/Types.h"
 #include <assimp/material.h>
 
+namespace ECS
+{
+	class ThreadPool;
+}
+
 
 
 //////////////////////////////////
@@ -29,7 +36,26 @@
 class ModelLoader final
 {
 public:
-	ModelLoader() {};
+	// post-processing flags of import (are also a part of the key of baked meshes cache)
+	static constexpr u32 IMPORT_FLAGS =
+		aiProcessPreset_TargetRealtime_MaxQuality |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals;
+
+	// a texture of the imported mesh which isn't registered in the texture manager yet
+	// (the texture manager isn't thread-safe so textures are registered after import)
+	struct MeshTexture
+	{
+		u32          meshIdx = 0;          // idx of the mesh in the array of imported meshes
+		u32          type = 0;             // aiTextureType
+		TexPath      path;                 // path to the file OR name of the embedded texture
+		bool         isEmbedded = false;
+		TextureClass embeddedTex;          // is created during import (only for the first use of embedded texture)
+	};
+
+public:
+	// the thread pool (if passed) is used for mesh math calculations
+	explicit ModelLoader(ECS::ThreadPool* pThreadPool = nullptr) : pThreadPool_(pThreadPool) {};
 
 	
 	void LoadFromFile(
@@ -37,6 +63,23 @@ public:
 		std::vector<Mesh::MeshData>& rawMeshes,
 		const std::string & filePath);
 
+	// import meshes without registration of their textures so it can be
+	// executed on any thread; call RegisterTextures() on the main thread after that
+	void ImportFromFile(
+		ID3D11Device* pDevice,
+		std::vector<Mesh::MeshData>& rawMeshes,
+		const std::string& filePath,
+		std::vector<MeshTexture>& outTextures);
+
+	// add textures into the texture manager and setup meshes with them
+	static void RegisterTextures(
+		std::vector<MeshTexture>& textures,
+		std::vector<Mesh::MeshData>& meshes);
+
+	// timings of the last import (in ms)
+	inline float GetReadFileTime() const { return readFileTime_; }   // Assimp: reading + post-processing
+	inline float GetProcessTime()  const { return processTime_; }    // building of meshes (+ tangents)
+
 private:
 	void ProcessNode(
 		ID3D11Device* pDevice,
@@ -64,9 +107,16 @@ private:
 		aiMaterial* pMaterial,
 		const aiScene* pScene,
 		const std::string& filePath,
+		const u32 meshIdx,
 		Mesh::MeshData& meshData);
 
 	void GetVerticesAndIndicesFromMesh(const aiMesh* pMesh, Mesh::MeshData& meshData);
 
-	void ExecuteModelMathCalculations(std::vector<Vertex3D>& vertices);
+	void ExecuteModelMathCalculations(Mesh::MeshData& meshData);
+
+private:
+	ECS::ThreadPool*         pThreadPool_ = nullptr;
+	std::vector<MeshTexture> textures_;          // textures of the currently imported meshes
+	float                    readFileTime_ = 0;
+	float                    processTime_ = 0;
 };
\ No newline at end of file
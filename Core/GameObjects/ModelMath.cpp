@@ -3,9 +3,13 @@
 // Created:      06.02.23
 ////////////////////////////////////////////////////////////////////
 #include "ModelMath.h"
+#include "MeshHelperTypes.h"
 #include "../Common/Types.h"
+#include "../Common/Assert.h"
+#include "Common/ThreadPool.h"      // from the ECS module
 
 #include <cmath>
+#include <cfloat>
 
 using namespace DirectX;
 
@@ -76,6 +80,130 @@ void ModelMath::CalculateModelVectors(
 
 ///////////////////////////////////////////////////////////
 
+void ModelMath::CalculateMeshTangents(
+	Mesh::MeshData& mesh,
+	ECS::ThreadPool* pThreadPool)
+{
+	// compute per-vertex tangents and binormals of the indexed mesh:
+	// 1. compute the tangent/binormal of each face (they aren't normalized
+	//    so bigger faces have more influence on their vertices);
+	// 2. build a list of faces of each vertex (CSR) so each vertex accumulates
+	//    values of its faces in a single task without any locks (and in the same
+	//    order for any number of threads);
+	// 3. orthogonalize the accumulated tangent against the vertex normal (Gram-Schmidt)
+	//    and restore the binormal by the normal and the tangent keeping
+	//    the handedness of the texture space;
+	//
+	// faces and vertices are processed by chunks in parallel
+
+	std::vector<Vertex3D>& vertices = mesh.vertices;
+	const std::vector<UINT>& indices = mesh.indices;
+
+	Assert::True(indices.size() % 3 == 0, "wrong number of indices of the mesh: " + mesh.name);
+
+	const size facesCount    = std::ssize(indices) / 3;
+	const size verticesCount = std::ssize(vertices);
+	constexpr size chunkSize = 4096;
+
+	auto parallelFor = [pThreadPool](const size count, const auto& func)
+	{
+		if (pThreadPool)
+			pThreadPool->ParallelFor(count, chunkSize, func);
+		else
+			func(0, count);
+	};
+
+	// ---------------------------------------------
+
+	std::vector<XMFLOAT3> facesTangents(facesCount);
+	std::vector<XMFLOAT3> facesBinormals(facesCount);
+
+	parallelFor(facesCount, [&](const size begin, const size end)
+	{
+		for (size face = begin; face < end; ++face)
+		{
+			const Vertex3D& v0 = vertices[indices[face * 3 + 0]];
+			const Vertex3D& v1 = vertices[indices[face * 3 + 1]];
+			const Vertex3D& v2 = vertices[indices[face * 3 + 2]];
+
+			const XMVECTOR p0    = XMLoadFloat3(&v0.position);
+			const XMVECTOR edge1 = XMLoadFloat3(&v1.position) - p0;
+			const XMVECTOR edge2 = XMLoadFloat3(&v2.position) - p0;
+
+			const float du1 = v1.texture.x - v0.texture.x;
+			const float dv1 = v1.texture.y - v0.texture.y;
+			const float du2 = v2.texture.x - v0.texture.x;
+			const float dv2 = v2.texture.y - v0.texture.y;
+
+			// faces with degenerated texture coords don't affect their vertices
+			const float det = du1 * dv2 - du2 * dv1;
+			const float den = (fabsf(det) > FLT_EPSILON) ? 1.0f / det : 0.0f;
+
+			XMStoreFloat3(&facesTangents[face],  (edge1 * dv2 - edge2 * dv1) * den);
+			XMStoreFloat3(&facesBinormals[face], (edge2 * du1 - edge1 * du2) * den);
+		}
+	});
+
+	// ---------------------------------------------
+
+	// faces of each vertex: faces of the i-th vertex are in range [offsets[i], offsets[i+1])
+	std::vector<u32> offsets(verticesCount + 1, 0);
+	std::vector<u32> vertexFaces(indices.size());
+
+	for (const UINT idx : indices)
+		++offsets[idx + 1];
+
+	for (size i = 0; i < verticesCount; ++i)
+		offsets[i + 1] += offsets[i];
+
+	std::vector<u32> insertPos(offsets.begin(), offsets.end() - 1);
+
+	for (size i = 0; i < std::ssize(indices); ++i)
+		vertexFaces[insertPos[indices[i]]++] = (u32)(i / 3);
+
+	// ---------------------------------------------
+
+	parallelFor(verticesCount, [&](const size begin, const size end)
+	{
+		for (size v = begin; v < end; ++v)
+		{
+			XMVECTOR tangent  = XMVectorZero();
+			XMVECTOR binormal = XMVectorZero();
+
+			for (u32 i = offsets[v]; i < offsets[v + 1]; ++i)
+			{
+				tangent  += XMLoadFloat3(&facesTangents[vertexFaces[i]]);
+				binormal += XMLoadFloat3(&facesBinormals[vertexFaces[i]]);
+			}
+
+			Vertex3D& vertex = vertices[v];
+			const XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertex.normal));
+
+			// Gram-Schmidt orthogonalization
+			tangent -= normal * XMVector3Dot(normal, tangent);
+
+			// if there is no valid tangent we take any vector which is perpendicular to the normal
+			if (XMVectorGetX(XMVector3LengthSq(tangent)) < FLT_EPSILON)
+			{
+				const XMVECTOR axis = (fabsf(vertex.normal.x) < 0.9f) ? g_XMIdentityR0 : g_XMIdentityR1;
+				tangent = XMVector3Cross(normal, axis);
+			}
+
+			tangent = XMVector3Normalize(tangent);
+
+			XMVECTOR orthoBinormal = XMVector3Cross(normal, tangent);
+
+			if (XMVectorGetX(XMVector3Dot(orthoBinormal, binormal)) < 0.0f)
+				orthoBinormal = XMVectorNegate(orthoBinormal);
+
+			XMStoreFloat3(&vertex.tangent,  tangent);
+			XMStoreFloat3(&vertex.binormal, orthoBinormal);
+		}
+	});
+}
+
+///////////////////////////////////////////////////////////
+
 void ModelMath::CalculateTangentBinormal(
 	const Vertex3D & vertex1,
 	const Vertex3D & vertex2,
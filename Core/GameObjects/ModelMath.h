@@ -13,6 +13,15 @@
 
 #include "Vertex.h"
 
+namespace Mesh
+{
+	struct MeshData;
+}
+
+namespace ECS
+{
+	class ThreadPool;
+}
 
 
 //////////////////////////////////
@@ -26,6 +35,13 @@ public:
 		std::vector<Vertex3D>& verticesArr,
 		const bool calculateNormals = true);
 
+	// compute per-vertex tangents and binormals of the indexed mesh (faces values are
+	// accumulated into vertices and orthogonalized against vertex normals);
+	// the work is processed in parallel if the thread pool is passed
+	void CalculateMeshTangents(
+		Mesh::MeshData& mesh,
+		ECS::ThreadPool* pThreadPool = nullptr);
+
 	void CalculateTangentBinormal(
 		const Vertex3D& vertex1,
 		const Vertex3D& vertex2,
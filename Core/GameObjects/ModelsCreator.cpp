@@ -11,12 +11,18 @@
 #include "ModelMath.h"
 #include "MeshStorage.h"
 #include "ModelLoader.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 #include "GeometryGenerator.h"
 
+#include "Common/ThreadPool.h"      // from the ECS module
+
 #include "../Engine/Settings.h"
 #include "../Common/MathHelper.h"
 
 #include <sstream>
+#include <chrono>
+#include <optional>
 
 using namespace DirectX;
 
@@ -28,45 +34,221 @@ ModelsCreator::ModelsCreator()
 
 const std::vector<MeshID> ModelsCreator::ImportFromFile(
 	ID3D11Device* pDevice,
-	const std::string& filePath)
+	const std::string& filePath,
+	ECS::ThreadPool* pThreadPool)
 {
 	// create meshes loading its vertices/indices/texture data/etc. from a file
 	// input:  filePath - a path to the data file
 	// return: array of meshes IDs
 
-	std::vector<MeshID> meshIDs;
+	return ImportFromFiles(pDevice, { filePath }, pThreadPool).front();
+}
+
+///////////////////////////////////////////////////////////
+
+const std::vector<std::vector<MeshID>> ModelsCreator::ImportFromFiles(
+	ID3D11Device* pDevice,
+	const std::vector<std::string>& filesPaths,
+	ECS::ThreadPool* pThreadPool,
+	ImportStats* pOutStats)
+{
+	// import models from files by input paths:
+	//
+	// 1. (in parallel) each file is loaded from the baked cache or imported
+	//    with Assimp (+ tangents); textures aren't registered yet since
+	//    the texture manager isn't thread-safe;
+	// 2. textures of all the files are registered;
+	// 3. newly imported files are baked into the cache;
+	// 4. meshes are created in the mesh storage
 
-	try
+	using clock = std::chrono::steady_clock;
+	using ms = std::chrono::duration<float, std::milli>;
+
+	struct ImportedFile
+	{
+		std::vector<Mesh::MeshData>           meshes;
+		std::vector<ModelLoader::MeshTexture> textures;
+		std::optional<EngineException>        exception;   // is set if the file can't be imported
+		std::string                           errMsg;
+		bool                                  isCached = false;
+		bool                                  isFailed = false;
+		float                                 cacheLoadTime = 0;
+		float                                 readFileTime = 0;
+		float                                 processTime = 0;
+	};
+
+	const clock::time_point start = clock::now();
+	const size filesCount = std::ssize(filesPaths);
+
+	std::vector<ImportedFile> files(filesCount);
+	std::vector<std::vector<MeshID>> meshesIDs(filesCount);
+	ImportStats stats;
+
+	// ---------------------------------------------
+	// 1. import files in parallel
+
+	auto ImportFile = [pDevice, pThreadPool, &filesPaths, &files](const size idx)
 	{
-		ModelLoader modelLoader;
-		MeshStorage* pMeshStorage = MeshStorage::Get();
-		std::vector<Mesh::MeshData> meshes;
+		const std::string& path = filesPaths[idx];
+		ImportedFile& file = files[idx];
 
-		// load vertices/indices/textures/etc. of meshes from a file by filePath
-		modelLoader.LoadFromFile(pDevice, meshes, filePath);
+		try
+		{
+			// load meshes from the baked cache if the source wasn't changed since the last import
+			const clock::time_point cacheStart = clock::now();
+			std::vector<TexPath> texPaths;
+
+			file.isCached = MeshCache::Load(path, ModelLoader::IMPORT_FLAGS, file.meshes, texPaths);
+			file.cacheLoadTime = ms(clock::now() - cacheStart).count();
+
+			if (file.isCached)
+			{
+				for (size_t i = 0; i < texPaths.size(); ++i)
+				{
+					if (!texPaths[i].empty())
+						file.textures.push_back({ (u32)(i / TEXTURE_TYPE_COUNT), (u32)(i % TEXTURE_TYPE_COUNT), std::move(texPaths[i]) });
+				}
+				return;
+			}
+
+			ModelLoader modelLoader(pThreadPool);
+			modelLoader.ImportFromFile(pDevice, file.meshes, path, file.textures);
+
+			file.readFileTime = modelLoader.GetReadFileTime();
+			file.processTime  = modelLoader.GetProcessTime();
+		}
+		catch (const std::bad_alloc& e)
+		{
+			file.isFailed = true;
+			file.errMsg = e.what();
+		}
+		catch (EngineException& e)
+		{
+			file.isFailed = true;
+			file.exception = e;
+		}
+	};
 
-		// go through the array of raw meshes and store them into the mesh storage
-		
-		for (Mesh::MeshData& data : meshes)
+	if (pThreadPool)
+	{
+		// a file per task: the thread which waits for the tasks helps to execute them
+		pThreadPool->ParallelFor(filesCount, 1, [&ImportFile](const size begin, const size end)
 		{
-			// create a new mesh using the prepared data
-			const MeshID id = pMeshStorage->CreateMeshWithRawData(pDevice, data);
+			for (size idx = begin; idx < end; ++idx)
+				ImportFile(idx);
+		});
+	}
+	else
+	{
+		for (size idx = 0; idx < filesCount; ++idx)
+			ImportFile(idx);
+	}
 
-			meshIDs.push_back(id);
+	const clock::time_point texturesStart = clock::now();
+	stats.importStageTime = ms(texturesStart - start).count();
+
+	// ---------------------------------------------
+	// 2. register textures (on the calling thread)
+
+	for (size idx = 0; idx < filesCount; ++idx)
+	{
+		ImportedFile& file = files[idx];
+
+		if (file.isFailed)
+		{
+			// errors are printed here so logs of different files don't mix up
+			if (file.exception)
+				Log::Error(*file.exception, false);
+			else
+				Log::Error(file.errMsg);
+
+			Log::Error("can't load meshes from a file by path: " + filesPaths[idx]);
+			continue;
 		}
+
+		ModelLoader::RegisterTextures(file.textures, file.meshes);
+		file.textures.clear();
 	}
-	catch (const std::bad_alloc& e)
+
+	const clock::time_point bakeStart = clock::now();
+	stats.texturesStageTime = ms(bakeStart - texturesStart).count();
+
+	// ---------------------------------------------
+	// 3. bake newly imported files so next time they are loaded from the cache
+
+	for (size idx = 0; idx < filesCount; ++idx)
 	{
-		Log::Error(e.what());
-		Log::Error("can't load meshes from a file by path: " + filePath);
+		if (!files[idx].isFailed && !files[idx].isCached)
+			MeshCache::Save(filesPaths[idx], ModelLoader::IMPORT_FLAGS, files[idx].meshes);
 	}
-	catch (EngineException& e)
+
+	const clock::time_point storageStart = clock::now();
+	stats.bakeStageTime = ms(storageStart - bakeStart).count();
+
+	// ---------------------------------------------
+	// 4. store meshes into the mesh storage
+
+	MeshStorage* pMeshStorage = MeshStorage::Get();
+
+	for (size idx = 0; idx < filesCount; ++idx)
 	{
-		Log::Error(e, false);
-		Log::Error("can't load meshes from a file by path: " + filePath);
+		ImportedFile& file = files[idx];
+
+		if (file.isFailed)
+			continue;
+
+		try
+		{
+			for (Mesh::MeshData& data : file.meshes)
+			{
+				// create a new mesh using the prepared data
+				meshesIDs[idx].push_back(pMeshStorage->CreateMeshWithRawData(pDevice, data));
+			}
+		}
+		catch (const std::bad_alloc& e)
+		{
+			Log::Error(e.what());
+			Log::Error("can't load meshes from a file by path: " + filesPaths[idx]);
+		}
+		catch (EngineException& e)
+		{
+			Log::Error(e, false);
+			Log::Error("can't load meshes from a file by path: " + filesPaths[idx]);
+		}
+
+		stats.cacheLoadTime    += file.cacheLoadTime;
+		stats.readFileTime     += file.readFileTime;
+		stats.processTime      += file.processTime;
+		stats.cachedFilesCount += file.isCached;
+		stats.meshesCount      += (u32)meshesIDs[idx].size();
 	}
 
-	return meshIDs;
+	const clock::time_point end = clock::now();
+	stats.storageStageTime = ms(end - storageStart).count();
+	stats.totalTime        = ms(end - start).count();
+	stats.filesCount       = (u32)filesCount;
+
+	// ---------------------------------------------
+
+	char buf[512]{ '\0' };
+	snprintf(buf, sizeof(buf),
+		"models import: files: %u (cached: %u), meshes: %u, total: %.2f ms\n"
+		"\timport stage:   %.2f ms (cache load: %.2f ms, assimp: %.2f ms, processing: %.2f ms)\n"
+		"\ttextures stage: %.2f ms\n"
+		"\tbake stage:     %.2f ms\n"
+		"\tstorage stage:  %.2f ms",
+		stats.filesCount, stats.cachedFilesCount, stats.meshesCount, stats.totalTime,
+		stats.importStageTime, stats.cacheLoadTime, stats.readFileTime, stats.processTime,
+		stats.texturesStageTime,
+		stats.bakeStageTime,
+		stats.storageStageTime);
+
+	Log::Debug(buf);
+
+	if (pOutStats)
+		*pOutStats = stats;
+
+	return meshesIDs;
 }
 
 ///////////////////////////////////////////////////////////
@@ -195,6 +377,13 @@ MeshID ModelsCreator::CreateSkull(ID3D11Device* pDevice)
 	// and return its ID
 
 	const std::string dataFilepath = "data/models/default/skull.txt";
+	const u32 importFlags = 0;       // the skull isn't imported with assimp
+
+	std::vector<Mesh::MeshData> cachedMeshes;
+
+	// load the skull from the baked cache if the text file wasn't changed
+	if (MeshCache::Load(dataFilepath, importFlags, cachedMeshes))
+		return MeshStorage::Get()->CreateMeshWithRawData(pDevice, cachedMeshes.front());
 
 	std::ifstream fin(dataFilepath);
 	Assert::True(fin.is_open(), dataFilepath + " not found");
@@ -243,6 +432,13 @@ MeshID ModelsCreator::CreateSkull(ID3D11Device* pDevice)
 	data.path = dataFilepath;
 	data.texIDs = GetDefaultTexIDsArr();
 
+	// weld duplicated vertices of the text data and reorder triangles/vertices
+	// for the vertex cache (the optimized mesh is baked so it's done only once)
+	MeshOptimizer meshOptimizer;
+	meshOptimizer.Optimize(data, true);
+
+	MeshCache::Save(dataFilepath, importFlags, { data });
+
 	// store the mesh and return its ID
 	return MeshStorage::Get()->CreateMeshWithRawData(pDevice, data);
 }
@@ -382,7 +578,9 @@ MeshID ModelsCreator::CreateGeneratedTerrain(
 	const float terrainWidth,
 	const float terrainDepth,
 	const UINT verticesCountByX,
-	const UINT verticesCountByZ)
+	const UINT verticesCountByZ,
+	TerrainHeightField& outHeightField,
+	ECS::ThreadPool* pThreadPool)
 {
 	//
 	// CREATE TERRAIN GRID
@@ -410,6 +608,12 @@ MeshID ModelsCreator::CreateGeneratedTerrain(
 	// generate height for each vertex of the terrain grid
 	GenerateHeightsForGrid(terrainGrid);
 
+	// keep heights of the grid resident for fast height queries
+	outHeightField.InitializeFromGrid(
+		terrainGrid.vertices,
+		(u32)terrainWidth + 1,
+		(u32)terrainDepth + 1);
+
 
 	// compute normals, tangents, and bitangents for this terrain grid
 	//ModelMath modelMath;
@@ -417,40 +621,13 @@ MeshID ModelsCreator::CreateGeneratedTerrain(
 
 	
 	std::vector<Vertex3D>& vertices = terrainGrid.vertices;
-	std::vector<UINT>& indices = terrainGrid.indices;
-	const u32 numTriangles = static_cast<u32>(indices.size()) / 3;
 
-	// for each triangle in the mesh
-	for (u32 i = 0; i < numTriangles; ++i)
-	{
-		// indices of the ith triangle 
-		UINT i0 = indices[i*3 + 0];
-		UINT i1 = indices[i*3 + 1];
-		UINT i2 = indices[i*3 + 2];
-
-		// positions of vertices of ith triangle stored as XMVECTOR
-		XMVECTOR v0 = DirectX::XMLoadFloat3(&vertices[i0].position);
-		XMVECTOR v1 = DirectX::XMLoadFloat3(&vertices[i1].position);
-		XMVECTOR v2 = DirectX::XMLoadFloat3(&vertices[i2].position);
-
-		// compute face normal
-		XMVECTOR e0 = v1 - v0;
-		XMVECTOR e1 = v2 - v0;
-		XMVECTOR normalVec = DirectX::XMVector3Cross(e0, e1);
-		XMFLOAT3 faceNormal;
-		DirectX::XMStoreFloat3(&faceNormal, normalVec);
-
-		// this triangle shares the following three vertices, 
-		// so add this face normal into the average of these vertex normals
-		vertices[i0].normal += faceNormal;
-		vertices[i1].normal += faceNormal;
-		vertices[i2].normal += faceNormal;
-	}
+	// compute normals directly from heights of the grid (by central differences)
+	std::vector<XMFLOAT3> normals(vertices.size());
+	outHeightField.ComputeNormals(normals, pThreadPool);
 
-	// for each vertex v, we have summed the face normals of all
-	// the triangles that share v, so now we just need to normalize
-	for (Vertex3D& vertex : vertices)
-		vertex.normal = DirectX::XMFloat3Normalize(vertex.normal);
+	for (size_t i = 0; i < vertices.size(); ++i)
+		vertices[i].normal = normals[i];
 		
 	
 
@@ -12,9 +12,33 @@
 #include "MeshHelperTypes.h"
 #include "MeshStorage.h"
 #include "TextureManager.h"
+#include "TerrainHeightField.h"
 
 #include "../Common/Types.h"
 
+// timings of stages of the models import (in ms)
+struct ImportStats
+{
+	// are summed over all the files; files are imported in parallel so
+	// the sum can be greater than the time of the whole import stage
+	float cacheLoadTime     = 0;    // loading of baked meshes
+	float readFileTime      = 0;    // Assimp: reading + post-processing
+	float processTime       = 0;    // building of meshes (+ tangents)
+
+	// stages which are executed one after another
+	float importStageTime   = 0;    // parallel import of all the files
+	float texturesStageTime = 0;    // registration of textures in the texture manager
+	float bakeStageTime     = 0;    // writing of meshes into the baked cache
+	float storageStageTime  = 0;    // creation of meshes in the mesh storage (+ GPU buffers)
+	float totalTime         = 0;
+
+	u32   filesCount        = 0;
+	u32   cachedFilesCount  = 0;    // files which were loaded from the baked cache
+	u32   meshesCount       = 0;
+};
+
+///////////////////////////////////////////////////////////
+
 class ModelsCreator
 {
 public:
@@ -22,7 +46,18 @@ public:
 
 	const std::vector<MeshID> ImportFromFile(
 		ID3D11Device* pDevice, 
-		const std::string& filepath);
+		const std::string& filepath,
+		ECS::ThreadPool* pThreadPool = nullptr);    // is used for mesh math calculations
+
+	// import a batch of models: independent files are imported in parallel
+	// on the thread pool and only the registration of textures and creation
+	// of meshes in the storage go on the calling thread;
+	// return: arrays of meshes IDs for each file (empty if the file can't be imported)
+	const std::vector<std::vector<MeshID>> ImportFromFiles(
+		ID3D11Device* pDevice,
+		const std::vector<std::string>& filesPaths,
+		ECS::ThreadPool* pThreadPool = nullptr,
+		ImportStats* pOutStats = nullptr);
 
 	const std::vector<TextureClass*> GetDefaultTexPtrsArr() const;
 	const std::vector<TexID> GetDefaultTexIDsArr() const;
@@ -44,7 +79,9 @@ public:
 		const float terrainWidth,
 		const float terrainDepth,
 		const UINT verticesCountByX,
-		const UINT verticesCountByZ);
+		const UINT verticesCountByZ,
+		TerrainHeightField& outHeightField,
+		ECS::ThreadPool* pThreadPool = nullptr);    // is used to compute normals in parallel
 	
 	void GenerateHeightsForGrid(Mesh::MeshData& grid);
 #if 0
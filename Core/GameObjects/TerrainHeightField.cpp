@@ -0,0 +1,331 @@
+// *********************************************************************************
+// Filename:      TerrainHeightField.cpp
+// Description:   implementation of the TerrainHeightField functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "TerrainHeightField.h"
+#include "../Common/Assert.h"
+#include "../Engine/log.h"
+#include "Common/ThreadPool.h"      // from the ECS module
+
+#include <algorithm>
+
+using namespace DirectX;
+
+
+void TerrainHeightField::Initialize(
+	const std::vector<float>& heights,
+	const u32 verticesByX,
+	const u32 verticesByZ,
+	const float minX,
+	const float maxZ,
+	const float cellSizeX,
+	const float cellSizeZ)
+{
+	Assert::True((verticesByX > 1) && (verticesByZ > 1), "the height-field must have at least 2x2 vertices");
+	Assert::True(heights.size() == (size_t)verticesByX * verticesByZ, "wrong number of heights");
+	Assert::True((cellSizeX > 0.0f) && (cellSizeZ > 0.0f), "cell size must be > 0");
+
+	heights_      = heights;
+	verticesByX_  = verticesByX;
+	verticesByZ_  = verticesByZ;
+	minX_         = minX;
+	maxZ_         = maxZ;
+	cellSizeX_    = cellSizeX;
+	cellSizeZ_    = cellSizeZ;
+	invCellSizeX_ = 1.0f / cellSizeX;
+	invCellSizeZ_ = 1.0f / cellSizeZ;
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainHeightField::InitializeFromGrid(
+	const std::vector<Vertex3D>& vertices,
+	const u32 verticesByX,
+	const u32 verticesByZ)
+{
+	// build the height-field from vertices of the grid mesh; vertices go row by row
+	// starting from the upper left corner (min X, max Z) so the params of the
+	// height-field are taken directly from positions of the grid
+
+	Assert::True((verticesByX > 1) && (verticesByZ > 1), "the grid must have at least 2x2 vertices");
+	Assert::True(vertices.size() == (size_t)verticesByX * verticesByZ, "wrong number of grid vertices");
+
+	std::vector<float> heights(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+		heights[i] = vertices[i].position.y;
+
+	const XMFLOAT3& first = vertices[0].position;
+
+	Initialize(
+		heights,
+		verticesByX,
+		verticesByZ,
+		first.x,
+		first.z,
+		vertices[1].position.x - first.x,              // distance between columns
+		first.z - vertices[verticesByX].position.z);   // distance between rows
+
+	Log::Debug("terrain height-field is built: " + std::to_string(verticesByX) + "x" + std::to_string(verticesByZ));
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainHeightField::Shutdown()
+{
+	heights_.clear();
+	heights_.shrink_to_fit();
+	verticesByX_ = 0;
+	verticesByZ_ = 0;
+}
+
+///////////////////////////////////////////////////////////
+
+bool TerrainHeightField::GetHeightAtPosition(
+	const float posX,
+	const float posZ,
+	float& outHeight) const
+{
+	// returns the height of the terrain triangle which is directly under the input
+	// position; if the position is off the terrain grid we return false and
+	// don't change the output height
+
+	if (!IsInitialized())
+		return false;
+
+	const float fx = (posX - minX_) * invCellSizeX_;
+	const float fz = (maxZ_ - posZ) * invCellSizeZ_;
+
+	if ((fx < 0.0f) || (fz < 0.0f) || (fx > (float)(verticesByX_ - 1)) || (fz > (float)(verticesByZ_ - 1)))
+		return false;
+
+	outHeight = SampleHeight(posX, posZ);
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainHeightField::GetHeightsAtPositions(
+	const std::span<const XMFLOAT2> positions,
+	const std::span<float> outHeights) const
+{
+	// get heights of the terrain for a batch of positions;
+	// 4 positions are processed at once: coords of cells and barycentric
+	// params are computed using SIMD registers, only heights of the cells
+	// corners are gathered one by one
+
+	Assert::True(IsInitialized(), "the terrain height-field isn't initialized");
+	Assert::True(outHeights.size() >= positions.size(), "the output arr is too small");
+
+	const size count = std::ssize(positions);
+	const size count4 = count & ~3;
+	const u32 strideZ = verticesByX_;
+	const float* heights = heights_.data();
+
+	const XMVECTOR minX     = XMVectorReplicate(minX_);
+	const XMVECTOR maxZ     = XMVectorReplicate(maxZ_);
+	const XMVECTOR invCellX = XMVectorReplicate(invCellSizeX_);
+	const XMVECTOR invCellZ = XMVectorReplicate(invCellSizeZ_);
+	const XMVECTOR quadsX   = XMVectorReplicate((float)(verticesByX_ - 1));
+	const XMVECTOR quadsZ   = XMVectorReplicate((float)(verticesByZ_ - 1));
+	const XMVECTOR one      = g_XMOne;
+	const XMVECTOR zero     = XMVectorZero();
+
+	for (size i = 0; i < count4; i += 4)
+	{
+		// deinterleave (x, z) pairs into separate registers
+		const XMVECTOR p01 = XMLoadFloat4((const XMFLOAT4*)&positions[i + 0]);
+		const XMVECTOR p23 = XMLoadFloat4((const XMFLOAT4*)&positions[i + 2]);
+		const XMVECTOR xs  = XMVectorPermute<0, 2, 4, 6>(p01, p23);
+		const XMVECTOR zs  = XMVectorPermute<1, 3, 5, 7>(p01, p23);
+
+		// coords in cells space (clamped to the grid)
+		const XMVECTOR fx   = XMVectorClamp((xs - minX) * invCellX, zero, quadsX);
+		const XMVECTOR fz   = XMVectorClamp((maxZ - zs) * invCellZ, zero, quadsZ);
+		const XMVECTOR cols = XMVectorMin(XMVectorFloor(fx), quadsX - one);
+		const XMVECTOR rows = XMVectorMin(XMVectorFloor(fz), quadsZ - one);
+		const XMVECTOR s    = fx - cols;
+		const XMVECTOR t    = fz - rows;
+
+		XMUINT4 colsIdxs;
+		XMUINT4 rowsIdxs;
+		XMStoreUInt4(&colsIdxs, XMConvertVectorFloatToUInt(cols, 0));
+		XMStoreUInt4(&rowsIdxs, XMConvertVectorFloatToUInt(rows, 0));
+
+		const u32 idx0 = rowsIdxs.x * strideZ + colsIdxs.x;
+		const u32 idx1 = rowsIdxs.y * strideZ + colsIdxs.y;
+		const u32 idx2 = rowsIdxs.z * strideZ + colsIdxs.z;
+		const u32 idx3 = rowsIdxs.w * strideZ + colsIdxs.w;
+
+		// gather heights of corners of each cell:
+		//  A ___ B
+		//   |  /|
+		//   | / |
+		//  C|/__|D
+		const XMVECTOR hA = XMVectorSet(heights[idx0],               heights[idx1],               heights[idx2],               heights[idx3]);
+		const XMVECTOR hB = XMVectorSet(heights[idx0 + 1],           heights[idx1 + 1],           heights[idx2 + 1],           heights[idx3 + 1]);
+		const XMVECTOR hC = XMVectorSet(heights[idx0 + strideZ],     heights[idx1 + strideZ],     heights[idx2 + strideZ],     heights[idx3 + strideZ]);
+		const XMVECTOR hD = XMVectorSet(heights[idx0 + strideZ + 1], heights[idx1 + strideZ + 1], heights[idx2 + strideZ + 1], heights[idx3 + strideZ + 1]);
+
+		// interpolate by both triangles and select the one we are above
+		const XMVECTOR hABC = XMVectorMultiplyAdd(t, hC - hA, XMVectorMultiplyAdd(s, hB - hA, hA));
+		const XMVECTOR hCBD = XMVectorMultiplyAdd(one - t, hB - hD, XMVectorMultiplyAdd(one - s, hC - hD, hD));
+		const XMVECTOR isABC = XMVectorLessOrEqual(s + t, one);
+
+		XMStoreFloat4((XMFLOAT4*)&outHeights[i], XMVectorSelect(hCBD, hABC, isABC));
+	}
+
+	// process the rest of positions
+	for (size i = count4; i < count; ++i)
+		outHeights[i] = SampleHeight(positions[i].x, positions[i].y);
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainHeightField::ComputeNormals(
+	const std::span<XMFLOAT3> outNormals,
+	ECS::ThreadPool* pThreadPool) const
+{
+	// compute a normal of each vertex directly from the height-field (without
+	// intermediate face normals) by central differences:
+	//
+	//   n = normalize(-dh/dx, 1, -dh/dz), where
+	//   dh/dx = (h[row][col+1] - h[row][col-1]) / (2 * cellSizeX)
+	//   dh/dz = (h[row-1][col] - h[row+1][col]) / (2 * cellSizeZ)   (rows go along -Z)
+	//
+	// on the border of the grid one-sided differences are used;
+	// rows don't depend on each other so they are split into chunks which are
+	// processed in parallel (the result doesn't depend on the number of threads)
+
+	Assert::True(IsInitialized(), "the terrain height-field isn't initialized");
+	Assert::True(outNormals.size() >= heights_.size(), "the output arr is too small");
+
+	constexpr size rowsPerTask = 16;
+	XMFLOAT3* normals = outNormals.data();
+
+	auto computeRows = [this, normals](const size begin, const size end)
+	{
+		for (size row = begin; row < end; ++row)
+			ComputeNormalsOfRow((u32)row, normals);
+	};
+
+	if (pThreadPool)
+		pThreadPool->ParallelFor(verticesByZ_, rowsPerTask, computeRows);
+	else
+		computeRows(0, verticesByZ_);
+}
+
+
+
+// *********************************************************************************
+//                              PRIVATE HELPERS
+// *********************************************************************************
+
+float TerrainHeightField::SampleHeight(const float posX, const float posZ) const
+{
+	// compute the height of the terrain triangle under the input position
+	// (the position is clamped to the grid)
+
+	const u32 quadsX = verticesByX_ - 1;
+	const u32 quadsZ = verticesByZ_ - 1;
+
+	const float fx = std::clamp((posX - minX_) * invCellSizeX_, 0.0f, (float)quadsX);
+	const float fz = std::clamp((maxZ_ - posZ) * invCellSizeZ_, 0.0f, (float)quadsZ);
+	const u32 col  = std::min((u32)fx, quadsX - 1);
+	const u32 row  = std::min((u32)fz, quadsZ - 1);
+	const float s  = fx - (float)col;
+	const float t  = fz - (float)row;
+
+	const u32 idx  = row * verticesByX_ + col;
+	const float hA = heights_[idx];
+	const float hB = heights_[idx + 1];
+	const float hC = heights_[idx + verticesByX_];
+	const float hD = heights_[idx + verticesByX_ + 1];
+
+	// the upper left triangle (ABC) or the lower right one (CBD)
+	if (s + t <= 1.0f)
+		return hA + s * (hB - hA) + t * (hC - hA);
+	else
+		return hD + (1.0f - s) * (hC - hD) + (1.0f - t) * (hB - hD);
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainHeightField::ComputeNormalsOfRow(const u32 row, XMFLOAT3* outNormals) const
+{
+	// compute normals of a single row of vertices; inner vertices are processed
+	// by 4 at once: derivatives and normalization are computed in SIMD registers
+	// and then normals are transposed from SoA into 3 packed XMFLOAT3 quads
+
+	const u32 stride   = verticesByX_;
+	const u32 rowUp    = (row > 0) ? row - 1 : row;
+	const u32 rowDown  = (row + 1 < verticesByZ_) ? row + 1 : row;
+
+	const float* heights     = heights_.data() + row * stride;
+	const float* heightsUp   = heights_.data() + rowUp * stride;
+	const float* heightsDown = heights_.data() + rowDown * stride;
+	XMFLOAT3*    normals     = outNormals + row * stride;
+
+	const XMVECTOR scaleX = XMVectorReplicate(0.5f * invCellSizeX_);
+	const XMVECTOR scaleZ = XMVectorReplicate(invCellSizeZ_ / (float)(rowDown - rowUp));
+	const XMVECTOR one    = g_XMOne;
+
+	normals[0] = ComputeNormal(0, row);
+
+	u32 col = 1;
+
+	for (; col + 4 < stride; col += 4)
+	{
+		const XMVECTOR hL = XMLoadFloat4((const XMFLOAT4*)(heights + col - 1));
+		const XMVECTOR hR = XMLoadFloat4((const XMFLOAT4*)(heights + col + 1));
+		const XMVECTOR hU = XMLoadFloat4((const XMFLOAT4*)(heightsUp + col));
+		const XMVECTOR hD = XMLoadFloat4((const XMFLOAT4*)(heightsDown + col));
+
+		// (-dh/dx, 1, -dh/dz) and its normalization
+		const XMVECTOR nx     = (hL - hR) * scaleX;
+		const XMVECTOR nz     = (hD - hU) * scaleZ;
+		const XMVECTOR invLen = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(nx, nx, XMVectorMultiplyAdd(nz, nz, one)));
+
+		const XMVECTOR xs = nx * invLen;
+		const XMVECTOR ys = invLen;
+		const XMVECTOR zs = nz * invLen;
+
+		// (x0 x1 x2 x3)(y0 y1 y2 y3)(z0 z1 z2 z3) => (x0 y0 z0 x1)(y1 z1 x2 y2)(z2 x3 y3 z3)
+		const XMVECTOR xy01 = XMVectorPermute<0, 4, 1, 5>(xs, ys);
+		const XMVECTOR yz12 = XMVectorPermute<1, 5, 2, 6>(ys, zs);
+		const XMVECTOR xy23 = XMVectorPermute<2, 6, 3, 7>(xs, ys);
+
+		XMFLOAT4* dst = (XMFLOAT4*)(normals + col);
+		XMStoreFloat4(dst + 0, XMVectorPermute<0, 1, 4, 2>(xy01, zs));
+		XMStoreFloat4(dst + 1, XMVectorPermute<0, 1, 6, 2>(yz12, xs));
+		XMStoreFloat4(dst + 2, XMVectorPermute<6, 2, 3, 7>(xy23, zs));
+	}
+
+	// process the rest of vertices (including the last one on the border)
+	for (; col < stride; ++col)
+		normals[col] = ComputeNormal(col, row);
+}
+
+///////////////////////////////////////////////////////////
+
+XMFLOAT3 TerrainHeightField::ComputeNormal(const u32 col, const u32 row) const
+{
+	// compute a normal of a single vertex by differences of heights of its neighbours
+	// (if the vertex is on the border we use a one-sided difference)
+
+	const u32 colL = (col > 0) ? col - 1 : col;
+	const u32 colR = (col + 1 < verticesByX_) ? col + 1 : col;
+	const u32 rowU = (row > 0) ? row - 1 : row;
+	const u32 rowD = (row + 1 < verticesByZ_) ? row + 1 : row;
+
+	const u32 stride = verticesByX_;
+	const float dhdx = (heights_[row * stride + colR] - heights_[row * stride + colL]) * invCellSizeX_ / (float)(colR - colL);
+	const float dhdz = (heights_[rowU * stride + col] - heights_[rowD * stride + col]) * invCellSizeZ_ / (float)(rowD - rowU);
+
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f)));
+
+	return normal;
+}
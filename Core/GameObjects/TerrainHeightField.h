@@ -0,0 +1,91 @@
+// *********************************************************************************
+// Filename:      TerrainHeightField.h
+// Description:   a resident height-field of the terrain grid which is used
+//                for fast height queries (camera locking, grounding of objects);
+//
+//                heights are kept in a flat row-major array (row 0 is at the
+//                max Z of the terrain) so the cell under a position is found
+//                directly by its coordinates; the height is sampled exactly
+//                by the triangle of the cell (the same triangulation as
+//                the grid mesh has: each quad is split by its B-C diagonal);
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include <span>
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+#include "../Common/Types.h"
+
+namespace ECS
+{
+	class ThreadPool;
+}
+
+
+class TerrainHeightField final
+{
+public:
+	TerrainHeightField() {}
+	~TerrainHeightField() {}
+
+	void Initialize(
+		const std::vector<float>& heights,       // row-major heights (verticesByX * verticesByZ)
+		const u32 verticesByX,
+		const u32 verticesByZ,
+		const float minX,                        // X-coord of the first column
+		const float maxZ,                        // Z-coord of the first row
+		const float cellSizeX,
+		const float cellSizeZ);
+
+	void InitializeFromGrid(
+		const std::vector<Vertex3D>& vertices,   // vertices of the grid mesh (see GeometryGenerator::GenerateFlatGridMesh)
+		const u32 verticesByX,
+		const u32 verticesByZ);
+
+	void Shutdown();
+
+	// returns false if the position is off the terrain grid
+	bool GetHeightAtPosition(const float posX, const float posZ, float& outHeight) const;
+
+	// positions which are off the grid are clamped to its border
+	void GetHeightsAtPositions(
+		const std::span<const DirectX::XMFLOAT2> positions,   // (x, z) pairs
+		const std::span<float> outHeights) const;
+
+	// compute a normal of each vertex directly from heights by central differences;
+	// rows are processed in parallel if the thread pool is passed
+	void ComputeNormals(
+		const std::span<DirectX::XMFLOAT3> outNormals,         // row-major (the same order as heights)
+		ECS::ThreadPool* pThreadPool = nullptr) const;
+
+	inline bool  IsInitialized()  const { return !heights_.empty(); }
+	inline u32   GetVerticesByX() const { return verticesByX_; }
+	inline u32   GetVerticesByZ() const { return verticesByZ_; }
+	inline float GetMinX()        const { return minX_; }
+	inline float GetMaxZ()        const { return maxZ_; }
+	inline float GetCellSizeX()   const { return cellSizeX_; }
+	inline float GetCellSizeZ()   const { return cellSizeZ_; }
+	inline const std::vector<float>& GetHeights() const { return heights_; }
+
+private:
+	float SampleHeight(const float posX, const float posZ) const;
+	void  ComputeNormalsOfRow(const u32 row, DirectX::XMFLOAT3* outNormals) const;
+	DirectX::XMFLOAT3 ComputeNormal(const u32 col, const u32 row) const;
+
+private:
+	std::vector<float> heights_;
+
+	u32   verticesByX_ = 0;
+	u32   verticesByZ_ = 0;
+
+	float minX_ = 0.0f;
+	float maxZ_ = 0.0f;
+	float cellSizeX_ = 1.0f;
+	float cellSizeZ_ = 1.0f;
+	float invCellSizeX_ = 1.0f;
+	float invCellSizeZ_ = 1.0f;
+};
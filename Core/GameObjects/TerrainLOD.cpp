@@ -0,0 +1,292 @@
+// *********************************************************************************
+// Filename:      TerrainLOD.cpp
+// Description:   implementation of the TerrainLOD functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "TerrainLOD.h"
+#include "../Common/Assert.h"
+#include "../Engine/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+using namespace DirectX;
+
+
+void TerrainLOD::Initialize(
+	const TerrainHeightField& heightField,
+	const u32 chunkSize,
+	const float lodDistance)
+{
+	Assert::True(heightField.IsInitialized(), "the terrain height-field isn't initialized");
+	Assert::True(chunkSize > 0, "chunk size must be > 0");
+	Assert::True(lodDistance > 0.0f, "LOD distance must be > 0");
+
+	const u32 quadsByX = heightField.GetVerticesByX() - 1;
+	const u32 quadsByZ = heightField.GetVerticesByZ() - 1;
+
+	Assert::True((quadsByX % chunkSize == 0) && (quadsByZ % chunkSize == 0), "the terrain can't be split into chunks of size: " + std::to_string(chunkSize));
+
+	stride_      = heightField.GetVerticesByX();
+	chunkSize_   = chunkSize;
+	chunksByX_   = quadsByX / chunkSize;
+	chunksByZ_   = quadsByZ / chunkSize;
+	lodDistance_ = lodDistance;
+
+	// LOD N is possible if the chunk size is a multiple of 2^N
+	lodsCount_ = 1;
+
+	while ((lodsCount_ < MAX_LODS_COUNT) && (chunkSize % (1 << lodsCount_) == 0))
+		++lodsCount_;
+
+	// ---------------------------------------------
+
+	// build indices for each pair [LOD, stitched edges]
+	indices_.clear();
+	indexRanges_.assign(lodsCount_ * EDGES_COMBINATIONS, IndexRange());
+
+	for (u32 lod = 0; lod < lodsCount_; ++lod)
+	{
+		// the coarsest LOD has no coarser neighbours so it is never stitched
+		const u32 combinationsCount = (lod + 1 < lodsCount_) ? EDGES_COMBINATIONS : 1;
+
+		for (u32 edgesMask = 0; edgesMask < combinationsCount; ++edgesMask)
+			BuildIndices(lod, edgesMask);
+
+		for (u32 edgesMask = combinationsCount; edgesMask < EDGES_COMBINATIONS; ++edgesMask)
+			indexRanges_[lod * EDGES_COMBINATIONS + edgesMask] = indexRanges_[lod * EDGES_COMBINATIONS];
+	}
+
+	// ---------------------------------------------
+
+	const u32 chunksCount = GetChunksCount();
+
+	chunksBaseVertices_.resize(chunksCount);
+	chunksLODs_.assign(chunksCount, 0);
+	drawCalls_.reserve(chunksCount);
+
+	for (u32 cz = 0, idx = 0; cz < chunksByZ_; ++cz)
+	{
+		for (u32 cx = 0; cx < chunksByX_; ++cx, ++idx)
+			chunksBaseVertices_[idx] = (cz * chunkSize_) * stride_ + (cx * chunkSize_);
+	}
+
+	ComputeChunksAABBs(heightField);
+
+	Log::Debug("terrain LOD is built: chunks: " + std::to_string(chunksCount) + "; LODs: " + std::to_string(lodsCount_));
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainLOD::Shutdown()
+{
+	indices_.clear();
+	indexRanges_.clear();
+	chunksAABBs_.clear();
+	chunksBaseVertices_.clear();
+	chunksLODs_.clear();
+	drawCalls_.clear();
+
+	chunksByX_ = 0;
+	chunksByZ_ = 0;
+	lodsCount_ = 0;
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainLOD::SelectLODs(const XMFLOAT3& cameraPos)
+{
+	// select LOD of each chunk by the distance from the camera to the chunk's AABB:
+	// LOD 0 is used within the lodDistance, and each next LOD is used at twice
+	// as far distance as the previous one
+
+	const XMVECTOR camPos = XMLoadFloat3(&cameraPos);
+	const float invLodDistance = 1.0f / lodDistance_;
+
+	for (size i = 0; i < std::ssize(chunksAABBs_); ++i)
+	{
+		const XMVECTOR center  = XMLoadFloat3(&chunksAABBs_[i].Center);
+		const XMVECTOR extents = XMLoadFloat3(&chunksAABBs_[i].Extents);
+
+		// distance to the nearest point of the box (0 if the camera is inside)
+		const XMVECTOR d  = XMVectorMax(XMVectorAbs(camPos - center) - extents, XMVectorZero());
+		const float dist = XMVectorGetX(XMVector3Length(d));
+
+		u32 lod = 0;
+
+		if (dist > lodDistance_)
+			lod = std::min(1 + (u32)log2f(dist * invLodDistance), lodsCount_ - 1);
+
+		chunksLODs_[i] = lod;
+	}
+
+	RelaxLODs();
+
+	// ---------------------------------------------
+
+	drawCalls_.clear();
+
+	for (u32 cz = 0, idx = 0; cz < chunksByZ_; ++cz)
+	{
+		for (u32 cx = 0; cx < chunksByX_; ++cx, ++idx)
+		{
+			const IndexRange& range = GetIndexRange(chunksLODs_[idx], GetEdgesMask(cx, cz));
+			drawCalls_.push_back({ range.startIndex, range.indexCount, chunksBaseVertices_[idx] });
+		}
+	}
+}
+
+
+
+// *********************************************************************************
+//                              PRIVATE HELPERS
+// *********************************************************************************
+
+void TerrainLOD::BuildIndices(const u32 lod, const u32 edgesMask)
+{
+	// build indices of a chunk for the input LOD; each quad is split into two
+	// triangles the same way as the grid mesh (ABC, CBD);
+	//
+	// if an edge is stitched the odd vertices of this edge are collapsed
+	// to the neighbour even ones so the edge consists of the same segments
+	// as the edge of the coarser neighbour; triangles which become
+	// degenerate after collapsing are skipped;
+	//
+	// NOTE: the top/left edges are collapsed towards the upper left corner and
+	//       the bottom/right edges towards the lower right corner so collapsed
+	//       vertices of two stitched edges never overlap in a corner quad
+
+	const u32 step = 1 << lod;
+	const u32 n = chunkSize_ / step;            // number of quads by each side of the chunk
+	const u32 startIndex = (u32)indices_.size();
+
+	auto getIdx = [this, step, n, edgesMask](u32 row, u32 col)
+	{
+		if      ((edgesMask & EDGE_TOP)    && (row == 0) && (col & 1))   --col;
+		else if ((edgesMask & EDGE_BOTTOM) && (row == n) && (col & 1))   ++col;
+		else if ((edgesMask & EDGE_LEFT)   && (col == 0) && (row & 1))   --row;
+		else if ((edgesMask & EDGE_RIGHT)  && (col == n) && (row & 1))   ++row;
+
+		return (row * step) * stride_ + (col * step);
+	};
+
+	auto addTriangle = [this](const u32 i0, const u32 i1, const u32 i2)
+	{
+		if ((i0 != i1) && (i1 != i2) && (i0 != i2))
+		{
+			indices_.push_back(i0);
+			indices_.push_back(i1);
+			indices_.push_back(i2);
+		}
+	};
+
+	for (u32 row = 0; row < n; ++row)
+	{
+		for (u32 col = 0; col < n; ++col)
+		{
+			const u32 a = getIdx(row,     col);
+			const u32 b = getIdx(row,     col + 1);
+			const u32 c = getIdx(row + 1, col);
+			const u32 d = getIdx(row + 1, col + 1);
+
+			addTriangle(a, b, c);
+			addTriangle(c, b, d);
+		}
+	}
+
+	IndexRange& range = indexRanges_[lod * EDGES_COMBINATIONS + edgesMask];
+	range.startIndex = startIndex;
+	range.indexCount = (u32)indices_.size() - startIndex;
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainLOD::ComputeChunksAABBs(const TerrainHeightField& heightField)
+{
+	// compute a bounding box of each chunk using heights of its vertices
+
+	const std::vector<float>& heights = heightField.GetHeights();
+	const float chunkWidth = chunkSize_ * heightField.GetCellSizeX();
+	const float chunkDepth = chunkSize_ * heightField.GetCellSizeZ();
+
+	chunksAABBs_.resize(GetChunksCount());
+
+	for (u32 cz = 0, idx = 0; cz < chunksByZ_; ++cz)
+	{
+		for (u32 cx = 0; cx < chunksByX_; ++cx, ++idx)
+		{
+			float minY = FLT_MAX;
+			float maxY = -FLT_MAX;
+
+			for (u32 row = 0; row <= chunkSize_; ++row)
+			{
+				const float* rowHeights = heights.data() + chunksBaseVertices_[idx] + row * stride_;
+				const auto [minIt, maxIt] = std::minmax_element(rowHeights, rowHeights + chunkSize_ + 1);
+
+				minY = std::min(minY, *minIt);
+				maxY = std::max(maxY, *maxIt);
+			}
+
+			const float minX = heightField.GetMinX() + cx * chunkWidth;
+			const float maxZ = heightField.GetMaxZ() - cz * chunkDepth;
+
+			BoundingBox& aabb = chunksAABBs_[idx];
+			aabb.Center  = { minX + 0.5f * chunkWidth, 0.5f * (minY + maxY), maxZ - 0.5f * chunkDepth };
+			aabb.Extents = { 0.5f * chunkWidth,        0.5f * (maxY - minY), 0.5f * chunkDepth };
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainLOD::RelaxLODs()
+{
+	// stitching is possible only with a neighbour which is coarser by 1 LOD
+	// so we decrease LODs of chunks until all the neighbours differ by 1 LOD at most
+
+	bool isChanged = true;
+
+	while (isChanged)
+	{
+		isChanged = false;
+
+		for (u32 cz = 0, idx = 0; cz < chunksByZ_; ++cz)
+		{
+			for (u32 cx = 0; cx < chunksByX_; ++cx, ++idx)
+			{
+				u32 minNeighbourLOD = chunksLODs_[idx];
+
+				if (cz > 0)               minNeighbourLOD = std::min(minNeighbourLOD, chunksLODs_[idx - chunksByX_]);
+				if (cx + 1 < chunksByX_)  minNeighbourLOD = std::min(minNeighbourLOD, chunksLODs_[idx + 1]);
+				if (cz + 1 < chunksByZ_)  minNeighbourLOD = std::min(minNeighbourLOD, chunksLODs_[idx + chunksByX_]);
+				if (cx > 0)               minNeighbourLOD = std::min(minNeighbourLOD, chunksLODs_[idx - 1]);
+
+				if (chunksLODs_[idx] > minNeighbourLOD + 1)
+				{
+					chunksLODs_[idx] = minNeighbourLOD + 1;
+					isChanged = true;
+				}
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+u32 TerrainLOD::GetEdgesMask(const u32 cx, const u32 cz) const
+{
+	// get a mask of edges of the chunk which have a coarser neighbour
+
+	const u32 idx = cz * chunksByX_ + cx;
+	const u32 lod = chunksLODs_[idx];
+	u32 mask = 0;
+
+	if ((cz > 0)              && (chunksLODs_[idx - chunksByX_] > lod))  mask |= EDGE_TOP;
+	if ((cx + 1 < chunksByX_) && (chunksLODs_[idx + 1] > lod))           mask |= EDGE_RIGHT;
+	if ((cz + 1 < chunksByZ_) && (chunksLODs_[idx + chunksByX_] > lod))  mask |= EDGE_BOTTOM;
+	if ((cx > 0)              && (chunksLODs_[idx - 1] > lod))           mask |= EDGE_LEFT;
+
+	return mask;
+}
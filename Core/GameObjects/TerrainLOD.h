@@ -0,0 +1,114 @@
+// *********************************************************************************
+// Filename:      TerrainLOD.h
+// Description:   chunked level of detail for the terrain grid (geomipmapping);
+//
+//                the terrain is rendered using a single vertex buffer with shared
+//                vertices (one vertex per height sample, row-major) and it is split
+//                into square chunks; each chunk is rendered at some LOD where LOD N
+//                uses each (2^N)-th vertex of the grid;
+//
+//                index buffers don't depend on the chunk position (indices are
+//                local to the upper left vertex of the chunk and the chunk is drawn
+//                with its base vertex) so there is only one set of indices per each
+//                pair [LOD, stitched edges]; if a neighbour chunk is coarser the
+//                odd vertices of the common edge are collapsed to even ones so there
+//                are no cracks between chunks;
+//
+//                LODs of chunks are selected on the CPU by the distance from the
+//                camera and are relaxed so neighbour chunks differ by 1 LOD at most;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "TerrainHeightField.h"
+#include "../Common/Types.h"
+
+
+class TerrainLOD final
+{
+public:
+	static constexpr u32 MAX_LODS_COUNT = 8;
+
+	// edges of a chunk which are stitched with a coarser neighbour
+	enum EdgeFlags : u32
+	{
+		EDGE_TOP    = 1 << 0,      // the first row of the chunk (max Z)
+		EDGE_RIGHT  = 1 << 1,
+		EDGE_BOTTOM = 1 << 2,
+		EDGE_LEFT   = 1 << 3,
+
+		EDGES_COMBINATIONS = 16,
+	};
+
+	struct IndexRange
+	{
+		u32 startIndex = 0;
+		u32 indexCount = 0;
+	};
+
+	// params for ID3D11DeviceContext::DrawIndexed() for a single chunk
+	struct DrawCall
+	{
+		u32 startIndex = 0;
+		u32 indexCount = 0;
+		u32 baseVertex = 0;
+	};
+
+public:
+	TerrainLOD() {}
+	~TerrainLOD() {}
+
+	void Initialize(
+		const TerrainHeightField& heightField,
+		const u32 chunkSize,                   // number of quads by each side of a chunk
+		const float lodDistance);              // chunks closer than this distance are rendered with LOD 0
+
+	void Shutdown();
+
+	// select LOD of each chunk and prepare draw calls for this frame
+	void SelectLODs(const DirectX::XMFLOAT3& cameraPos);
+
+	inline const std::vector<u32>&                  GetIndices()     const { return indices_; }
+	inline const std::vector<DrawCall>&             GetDrawCalls()   const { return drawCalls_; }
+	inline const std::vector<DirectX::BoundingBox>& GetChunksAABBs() const { return chunksAABBs_; }
+	inline const std::vector<u32>&                  GetChunksLODs()  const { return chunksLODs_; }
+
+	inline u32 GetLODsCount()   const { return lodsCount_; }
+	inline u32 GetChunkSize()   const { return chunkSize_; }
+	inline u32 GetChunksByX()   const { return chunksByX_; }
+	inline u32 GetChunksByZ()   const { return chunksByZ_; }
+	inline u32 GetChunksCount() const { return chunksByX_ * chunksByZ_; }
+
+	inline const IndexRange& GetIndexRange(const u32 lod, const u32 edgesMask) const
+	{
+		return indexRanges_[lod * EDGES_COMBINATIONS + edgesMask];
+	}
+
+private:
+	void BuildIndices(const u32 lod, const u32 edgesMask);
+	void ComputeChunksAABBs(const TerrainHeightField& heightField);
+	void RelaxLODs();
+	u32  GetEdgesMask(const u32 chunkX, const u32 chunkZ) const;
+
+private:
+	std::vector<u32>                  indices_;       // indices of all the LODs and stitching variants
+	std::vector<IndexRange>           indexRanges_;   // [LOD * EDGES_COMBINATIONS + edges_mask] => range of indices_
+
+	std::vector<DirectX::BoundingBox> chunksAABBs_;   // chunks go row by row (from max Z)
+	std::vector<u32>                  chunksBaseVertices_;
+	std::vector<u32>                  chunksLODs_;    // LOD of each chunk which was selected for the current frame
+
+	std::vector<DrawCall>             drawCalls_;
+
+	u32   stride_     = 0;                            // number of vertices in a row of the grid
+	u32   chunkSize_  = 0;
+	u32   chunksByX_  = 0;
+	u32   chunksByZ_  = 0;
+	u32   lodsCount_  = 0;
+	float lodDistance_ = 0.0f;
+};
@@ -0,0 +1,486 @@
+// *********************************************************************************
+// Filename:      TerrainStreamer.cpp
+// Description:   implementation of the TerrainStreamer functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "TerrainStreamer.h"
+#include "../Common/Assert.h"
+#include "../Engine/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+
+void TerrainStreamer::Initialize(
+	const std::string& tilesFilename,
+	const float loadRadius,
+	const size_t memoryBudget)
+{
+	Assert::True(loadRadius > 0.0f, "load radius must be > 0");
+
+	Shutdown();
+	file_.Open(tilesFilename);
+
+	const TerrainTilesHeader& header = file_.GetHeader();
+	const u32 tileVerts  = header.tileSize + 1;
+	const u32 tilesCount = header.tilesByX * header.tilesByZ;
+
+	tiles_.resize(tilesCount);
+	tilesStates_.assign(tilesCount, TILE_NOT_LOADED);
+	tilesLastUsed_.assign(tilesCount, 0);
+
+	// all the tiles have the same topology so indices are shared;
+	// each quad is split into two triangles the same way as the grid mesh (ABC, CBD)
+	tileIndices_.clear();
+	tileIndices_.reserve((size_t)header.tileSize * header.tileSize * 6);
+
+	for (u32 row = 0; row < header.tileSize; ++row)
+	{
+		for (u32 col = 0; col < header.tileSize; ++col)
+		{
+			const u32 a = row * tileVerts + col;
+			const u32 b = a + 1;
+			const u32 c = a + tileVerts;
+			const u32 d = c + 1;
+
+			tileIndices_.insert(tileIndices_.end(), { a, b, c, c, b, d });
+		}
+	}
+
+	loadRadius_       = loadRadius;
+	tileBytes_        = sizeof(Tile) + (size_t)tileVerts * tileVerts * (sizeof(Vertex3D) + sizeof(float));
+	maxResidentCount_ = (u32)std::max<size_t>(1, memoryBudget / tileBytes_);
+	residentCount_    = 0;
+	frameIdx_         = 0;
+
+	worker_ = std::thread(&TerrainStreamer::WorkerLoop, this);
+
+	Log::Debug("terrain streamer is initialized: tiles: " + std::to_string(tilesCount) +
+	           "; max resident tiles: " + std::to_string(maxResidentCount_));
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::Shutdown()
+{
+	if (worker_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			isStopped_ = true;
+			requests_.clear();
+		}
+
+		wakeUp_.notify_all();
+		worker_.join();
+	}
+
+	builtTiles_.clear();
+	isStopped_ = false;
+	buildingCount_ = 0;
+
+	tiles_.clear();
+	tilesStates_.clear();
+	tilesLastUsed_.clear();
+	tileIndices_.clear();
+	loadedTiles_.clear();
+	evictedTiles_.clear();
+	residentCount_ = 0;
+
+	file_.Close();
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::LoadAround(const XMFLOAT3& pos)
+{
+	// build tiles around the position right on the calling thread
+
+	Assert::True(file_.IsOpened(), "the terrain streamer isn't initialized");
+	Flush();
+
+	++frameIdx_;
+	loadedTiles_.clear();
+	evictedTiles_.clear();
+
+	std::vector<u32> neededTiles;
+	GetTilesAround(pos, neededTiles);
+
+	for (const u32 idx : neededTiles)
+	{
+		tilesLastUsed_[idx] = frameIdx_;
+
+		if (tilesStates_[idx] == TILE_NOT_LOADED)
+			AddBuiltTile(TryBuildTile(idx));
+	}
+
+	EvictTiles();
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::Update(const XMFLOAT3& cameraPos)
+{
+	if (!file_.IsOpened())
+		return;
+
+	++frameIdx_;
+	loadedTiles_.clear();
+	evictedTiles_.clear();
+
+	std::vector<u32> neededTiles;
+	GetTilesAround(cameraPos, neededTiles);
+
+	for (const u32 idx : neededTiles)
+		tilesLastUsed_[idx] = frameIdx_;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// take tiles which were built by the worker
+		for (BuiltTile& builtTile : builtTiles_)
+			AddBuiltTile(std::move(builtTile));
+
+		builtTiles_.clear();
+
+		// the camera could move so the old requests which weren't taken by
+		// the worker yet are replaced with requests for the current position
+		for (const u32 idx : requests_)
+			tilesStates_[idx] = TILE_NOT_LOADED;
+
+		requests_.clear();
+
+		for (const u32 idx : neededTiles)
+		{
+			if (tilesStates_[idx] == TILE_NOT_LOADED)
+			{
+				tilesStates_[idx] = TILE_PENDING;
+				requests_.push_back(idx);
+			}
+		}
+	}
+
+	wakeUp_.notify_one();
+
+	EvictTiles();
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	isIdle_.wait(lock, [this]() { return requests_.empty() && (buildingCount_ == 0); });
+
+	for (BuiltTile& builtTile : builtTiles_)
+		AddBuiltTile(std::move(builtTile));
+
+	builtTiles_.clear();
+}
+
+///////////////////////////////////////////////////////////
+
+bool TerrainStreamer::GetHeightAtPosition(
+	const float posX,
+	const float posZ,
+	float& outHeight) const
+{
+	if (!file_.IsOpened())
+		return false;
+
+	const TerrainTilesHeader& header = file_.GetHeader();
+	const float tileWidth = header.tileSize * header.cellSize;
+	const float maxZ = (header.verticesByZ - 1) * header.cellSize;
+
+	const float fx = posX / tileWidth;
+	const float fz = (maxZ - posZ) / tileWidth;
+
+	if ((fx < 0.0f) || (fz < 0.0f) || (fx > (float)header.tilesByX) || (fz > (float)header.tilesByZ))
+		return false;
+
+	const u32 tx = std::min((u32)fx, header.tilesByX - 1);
+	const u32 tz = std::min((u32)fz, header.tilesByZ - 1);
+	const u32 idx = tz * header.tilesByX + tx;
+
+	if (tilesStates_[idx] != TILE_RESIDENT)
+		return false;
+
+	return tiles_[idx]->heightField.GetHeightAtPosition(posX, posZ, outHeight);
+}
+
+
+
+// *********************************************************************************
+//                              PRIVATE HELPERS
+// *********************************************************************************
+
+void TerrainStreamer::GetTilesAround(const XMFLOAT3& pos, std::vector<u32>& outTiles) const
+{
+	// get tiles which are within the load radius (in the XZ-plane) sorted by
+	// distance so the nearest tiles are built first; the number of tiles
+	// is limited by the memory budget
+
+	const TerrainTilesHeader& header = file_.GetHeader();
+	const float tileWidth = header.tileSize * header.cellSize;
+	const float maxZ = (header.verticesByZ - 1) * header.cellSize;
+	const float r = loadRadius_;
+
+	// range of tiles which intersect the square around the position
+	const int minTX = std::max(0, (int)floorf((pos.x - r) / tileWidth));
+	const int maxTX = std::min((int)header.tilesByX - 1, (int)floorf((pos.x + r) / tileWidth));
+	const int minTZ = std::max(0, (int)floorf((maxZ - (pos.z + r)) / tileWidth));
+	const int maxTZ = std::min((int)header.tilesByZ - 1, (int)floorf((maxZ - (pos.z - r)) / tileWidth));
+
+	std::vector<std::pair<float, u32>> tiles;
+
+	for (int tz = minTZ; tz <= maxTZ; ++tz)
+	{
+		for (int tx = minTX; tx <= maxTX; ++tx)
+		{
+			// distance to the nearest point of the tile
+			const float x0 = tx * tileWidth;
+			const float z1 = maxZ - tz * tileWidth;
+			const float dx = std::max({ 0.0f, x0 - pos.x, pos.x - (x0 + tileWidth) });
+			const float dz = std::max({ 0.0f, (z1 - tileWidth) - pos.z, pos.z - z1 });
+			const float sqrDist = dx*dx + dz*dz;
+
+			if (sqrDist <= r*r)
+				tiles.push_back({ sqrDist, tz * header.tilesByX + tx });
+		}
+	}
+
+	std::sort(tiles.begin(), tiles.end());
+
+	if (tiles.size() > maxResidentCount_)
+	{
+		Log::Error("the terrain streaming budget is too small for the load radius");
+		tiles.resize(maxResidentCount_);
+	}
+
+	outTiles.resize(tiles.size());
+
+	for (size_t i = 0; i < tiles.size(); ++i)
+		outTiles[i] = tiles[i].second;
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::BuildTile(const u32 tileIdx, Tile& outTile) const
+{
+	// build geometry of the tile using its heights from the mapped file;
+	// normals are computed by central differences (samples out of the tile
+	// are read from the neighbour tiles so there are no seams between tiles);
+	//
+	// NOTE: the terrain is placed the same way as the legacy terrain:
+	//       X is in [0, width], Z is in [0, depth] and row 0 is at the max Z
+
+	const TerrainTilesHeader& header = file_.GetHeader();
+	const u32   tileSize  = header.tileSize;
+	const u32   tileVerts = tileSize + 1;
+	const u32   tileX     = tileIdx % header.tilesByX;
+	const u32   tileZ     = tileIdx / header.tilesByX;
+	const int   col0      = (int)(tileX * tileSize);
+	const int   row0      = (int)(tileZ * tileSize);
+	const float cellSize  = header.cellSize;
+	const float invScale  = 1.0f / header.heightScale;
+	const float maxZ      = (header.verticesByZ - 1) * cellSize;
+	const float du        = 1.0f / (header.verticesByX - 1);
+	const float dv        = 1.0f / (header.verticesByZ - 1);
+
+	const uint16_t* samples = file_.GetTileSamples(tileIdx);
+	std::vector<float> heights((size_t)tileVerts * tileVerts);
+
+	for (size_t i = 0; i < heights.size(); ++i)
+		heights[i] = samples[i] * invScale;
+
+	auto getHeight = [&](const int col, const int row)
+	{
+		if ((col >= 0) && (row >= 0) && (col <= (int)tileSize) && (row <= (int)tileSize))
+			return heights[row * tileVerts + col];
+
+		return file_.GetSample(col0 + col, row0 + row) * invScale;
+	};
+
+	// ---------------------------------------------
+
+	const float invTwoCells = 0.5f / cellSize;
+	outTile.vertices.resize(heights.size());
+
+	for (u32 row = 0, idx = 0; row < tileVerts; ++row)
+	{
+		for (u32 col = 0; col < tileVerts; ++col, ++idx)
+		{
+			const int c = (int)col;
+			const int r = (int)row;
+
+			// derivatives of the height by X and Z (rows go along -Z)
+			const float dhdx = (getHeight(c + 1, r) - getHeight(c - 1, r)) * invTwoCells;
+			const float dhdz = (getHeight(c, r - 1) - getHeight(c, r + 1)) * invTwoCells;
+
+			XMFLOAT3 normal;
+			XMFLOAT3 tangent;
+			XMFLOAT3 binormal;
+			XMStoreFloat3(&normal,   XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f)));
+			XMStoreFloat3(&tangent,  XMVector3Normalize(XMVectorSet(1.0f, dhdx, 0.0f, 0.0f)));
+			XMStoreFloat3(&binormal, XMVector3Normalize(XMVectorSet(0.0f, -dhdz, -1.0f, 0.0f)));
+
+			outTile.vertices[idx] = Vertex3D(
+				(col0 + c) * cellSize, heights[idx], maxZ - (row0 + r) * cellSize,
+				(col0 + c) * du,       (row0 + r) * dv,
+				normal.x,   normal.y,   normal.z,
+				tangent.x,  tangent.y,  tangent.z,
+				binormal.x, binormal.y, binormal.z);
+		}
+	}
+
+	outTile.heightField.Initialize(
+		heights,
+		tileVerts,
+		tileVerts,
+		col0 * cellSize,
+		maxZ - row0 * cellSize,
+		cellSize,
+		cellSize);
+}
+
+///////////////////////////////////////////////////////////
+
+TerrainStreamer::BuiltTile TerrainStreamer::TryBuildTile(const u32 tileIdx) const
+{
+	// build the tile; an exception isn't thrown out (this is also called on
+	// the worker thread) but is kept so the main thread can report it
+
+	BuiltTile builtTile;
+	builtTile.idx = tileIdx;
+
+	try
+	{
+		builtTile.tile = std::make_unique<Tile>();
+		BuildTile(tileIdx, *builtTile.tile);
+	}
+	catch (...)
+	{
+		builtTile.tile.reset();
+		builtTile.error = std::current_exception();
+	}
+
+	return builtTile;
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::AddBuiltTile(BuiltTile&& builtTile)
+{
+	if (builtTile.tile)
+	{
+		MakeResident(builtTile.idx, std::move(builtTile.tile));
+		return;
+	}
+
+	// the tile is marked as failed so it won't be requested again
+	tilesStates_[builtTile.idx] = TILE_FAILED;
+
+	try
+	{
+		std::rethrow_exception(builtTile.error);
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+	}
+	catch (const std::exception& e)
+	{
+		Log::Error(e.what());
+	}
+	catch (...)
+	{
+		Log::Error("unknown error");
+	}
+
+	Log::Error("can't build the terrain tile: " + std::to_string(builtTile.idx));
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::MakeResident(const u32 tileIdx, std::unique_ptr<Tile>&& tile)
+{
+	tiles_[tileIdx] = std::move(tile);
+	tilesStates_[tileIdx] = TILE_RESIDENT;
+	++residentCount_;
+
+	loadedTiles_.push_back(tileIdx);
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::EvictTiles()
+{
+	// if the memory budget is exceeded we evict the least recently used tiles;
+	// tiles which are within the load radius in this frame are never evicted
+
+	if (residentCount_ <= maxResidentCount_)
+		return;
+
+	std::vector<std::pair<u32, u32>> candidates;   // [last used frame => tile idx]
+
+	for (u32 idx = 0; idx < (u32)tilesStates_.size(); ++idx)
+	{
+		if ((tilesStates_[idx] == TILE_RESIDENT) && (tilesLastUsed_[idx] != frameIdx_))
+			candidates.push_back({ tilesLastUsed_[idx], idx });
+	}
+
+	const size_t evictCount = std::min<size_t>(residentCount_ - maxResidentCount_, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + evictCount, candidates.end());
+
+	for (size_t i = 0; i < evictCount; ++i)
+	{
+		const u32 idx = candidates[i].second;
+
+		tiles_[idx].reset();
+		tilesStates_[idx] = TILE_NOT_LOADED;
+		--residentCount_;
+
+		evictedTiles_.push_back(idx);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainStreamer::WorkerLoop()
+{
+	// the background thread: build requested tiles one by one;
+	// the worker only reads from the mapped file so it doesn't touch
+	// any state of the streamer except the requests/built tiles queues
+
+	while (true)
+	{
+		u32 tileIdx = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wakeUp_.wait(lock, [this]() { return isStopped_ || !requests_.empty(); });
+
+			if (isStopped_)
+				return;
+
+			tileIdx = requests_.front();
+			requests_.pop_front();
+			++buildingCount_;
+		}
+
+		// a failed tile is also passed to the main thread (so it is marked as failed
+		// and buildingCount_ is decreased anyway, otherwise Flush() would never return)
+		BuiltTile builtTile = TryBuildTile(tileIdx);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			builtTiles_.push_back(std::move(builtTile));
+			--buildingCount_;
+		}
+
+		isIdle_.notify_all();
+	}
+}
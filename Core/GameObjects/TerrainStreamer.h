@@ -0,0 +1,140 @@
+// *********************************************************************************
+// Filename:      TerrainStreamer.h
+// Description:   pages tiles of a big terrain in/out around the camera;
+//
+//                heights are read from the memory-mapped tiles file (see TerrainTilesFile)
+//                so only pages of tiles which are really used are loaded from disk;
+//                geometry of tiles (vertices + a height-field for queries) is built on
+//                a background thread: each frame we request tiles within the load
+//                radius (the nearest ones first) and take the built tiles from the worker;
+//                a tile which can't be built is marked as failed and isn't requested again;
+//
+//                the memory of built tiles is limited by a budget: when it is exceeded
+//                the least recently used tiles (which are out of the load radius)
+//                are evicted;
+//
+//                all the public methods must be called from a single (main) thread;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <DirectXMath.h>
+
+#include "TerrainTiles.h"
+#include "TerrainHeightField.h"
+#include "Vertex.h"
+#include "../Common/Types.h"
+
+
+class TerrainStreamer final
+{
+public:
+	enum TileState : uint8_t
+	{
+		TILE_NOT_LOADED,
+		TILE_PENDING,           // is queued or is being built by the worker
+		TILE_RESIDENT,
+		TILE_FAILED,            // building of the tile failed (it isn't requested again)
+	};
+
+	// geometry of a single tile; vertices go row by row (from the max Z) and
+	// all the tiles share the same indices (see GetTileIndices())
+	struct Tile
+	{
+		std::vector<Vertex3D> vertices;
+		TerrainHeightField    heightField;
+	};
+
+public:
+	TerrainStreamer() {}
+	~TerrainStreamer() { Shutdown(); }
+
+	// restrict any copying of instances of this class
+	TerrainStreamer(const TerrainStreamer&) = delete;
+	TerrainStreamer& operator=(const TerrainStreamer&) = delete;
+
+	void Initialize(
+		const std::string& tilesFilename,
+		const float loadRadius,                // tiles within this distance from the camera are loaded
+		const size_t memoryBudget);            // max number of bytes for built tiles
+
+	void Shutdown();
+
+	// synchronously build tiles around the position (is used at startup
+	// so only tiles near the spawn point are loaded before the first frame)
+	void LoadAround(const DirectX::XMFLOAT3& pos);
+
+	// per-frame update: request tiles around the camera, take built tiles
+	// from the worker and evict the least recently used ones if needed
+	void Update(const DirectX::XMFLOAT3& cameraPos);
+
+	// wait until the worker builds all the requested tiles
+	void Flush();
+
+	// returns false if a tile under the position isn't resident
+	bool GetHeightAtPosition(const float posX, const float posZ, float& outHeight) const;
+
+	inline const TerrainTilesHeader& GetHeader()            const { return file_.GetHeader(); }
+	inline u32                       GetTilesCount()        const { return (u32)tilesStates_.size(); }
+	inline TileState                 GetTileState(const u32 idx) const { return tilesStates_[idx]; }
+	inline const Tile*               GetTile(const u32 idx) const { return tiles_[idx].get(); }
+	inline const std::vector<u32>&   GetTileIndices()       const { return tileIndices_; }
+	inline size_t                    GetUsedMemory()        const { return residentCount_ * tileBytes_; }
+	inline u32                       GetResidentCount()     const { return residentCount_; }
+
+	// tiles which became resident/were evicted during the last LoadAround()/Update()
+	// (so the renderer can create/release their GPU buffers)
+	inline const std::vector<u32>&   GetLoadedTiles()       const { return loadedTiles_; }
+	inline const std::vector<u32>&   GetEvictedTiles()      const { return evictedTiles_; }
+
+private:
+	struct BuiltTile
+	{
+		u32                   idx = 0;
+		std::unique_ptr<Tile> tile;            // nullptr if building of the tile failed
+		std::exception_ptr    error;
+	};
+
+	void GetTilesAround(const DirectX::XMFLOAT3& pos, std::vector<u32>& outTiles) const;
+	void BuildTile(const u32 tileIdx, Tile& outTile) const;
+	BuiltTile TryBuildTile(const u32 tileIdx) const;
+	void AddBuiltTile(BuiltTile&& builtTile);
+	void MakeResident(const u32 tileIdx, std::unique_ptr<Tile>&& tile);
+	void EvictTiles();
+	void WorkerLoop();
+
+private:
+	TerrainTilesFile                   file_;
+
+	std::vector<std::unique_ptr<Tile>> tiles_;            // built tiles (nullptr if not resident)
+	std::vector<TileState>             tilesStates_;
+	std::vector<u32>                   tilesLastUsed_;    // the last frame when the tile was within the load radius
+	std::vector<u32>                   tileIndices_;
+
+	std::vector<u32>                   loadedTiles_;
+	std::vector<u32>                   evictedTiles_;
+
+	float                              loadRadius_ = 0.0f;
+	size_t                             tileBytes_ = 0;    // memory of a single built tile
+	u32                                maxResidentCount_ = 0;
+	u32                                residentCount_ = 0;
+	u32                                frameIdx_ = 0;
+
+	// shared with the worker thread
+	std::thread                        worker_;
+	std::mutex                         mutex_;
+	std::condition_variable            wakeUp_;
+	std::condition_variable            isIdle_;
+	std::deque<u32>                    requests_;         // tiles to build (the nearest first)
+	std::vector<BuiltTile>             builtTiles_;
+	u32                                buildingCount_ = 0;
+	bool                               isStopped_ = false;
+};
@@ -0,0 +1,228 @@
+// *********************************************************************************
+// Filename:      TerrainTiles.cpp
+// Description:   implementation of the TerrainTilesFile functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "TerrainTiles.h"
+#include "../Common/Assert.h"
+#include "../Engine/log.h"
+#include "Common/LIB_Exception.h"     // ECS exception
+
+#include <windows.h>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+
+using FilePtr = std::unique_ptr<FILE, decltype(&fclose)>;
+
+static FilePtr OpenFile(const std::string& filename, const char* mode)
+{
+	FILE* pFile = nullptr;
+	const errno_t error = fopen_s(&pFile, filename.c_str(), mode);
+	Assert::True((error == 0) && (pFile != nullptr), "can't open the file: " + filename);
+
+	return FilePtr(pFile, &fclose);
+}
+
+
+// *********************************************************************************
+
+void TerrainTilesFile::ConvertHeightmap(
+	const std::string& srcFilename,
+	const HeightmapFormat srcFormat,
+	const u32 verticesByX,
+	const u32 verticesByZ,
+	const u32 tileSize,
+	const float cellSize,
+	const float heightScale,
+	const std::string& dstFilename)
+{
+	// convert a BMP/RAW16 heightmap into the tiled format; we read a strip of
+	// (tileSize + 1) rows of the source, split it into tiles and write them
+	// so only a single strip of the heightmap is kept in memory at once
+
+	Assert::True(tileSize > 0, "tile size must be > 0");
+	Assert::True((cellSize > 0.0f) && (heightScale > 0.0f), "cell size and height scale must be > 0");
+
+	FilePtr pSrc = OpenFile(srcFilename, "rb");
+
+	u32    width         = verticesByX;
+	u32    height        = verticesByZ;
+	u32    bytesPerPixel = sizeof(uint16_t);
+	size_t srcRowBytes   = (size_t)width * sizeof(uint16_t);
+	size_t dataOffset    = 0;
+	bool   isBottomUp    = false;
+
+	if (srcFormat == HEIGHTMAP_BMP)
+	{
+		BITMAPFILEHEADER fileHeader;
+		BITMAPINFOHEADER infoHeader;
+
+		Assert::True(fread(&fileHeader, sizeof(fileHeader), 1, pSrc.get()) == 1, "can't read in the bitmap file header");
+		Assert::True(fread(&infoHeader, sizeof(infoHeader), 1, pSrc.get()) == 1, "can't read in the bitmap info header");
+		Assert::True(fileHeader.bfType == 0x4D42, "the file isn't a bitmap: " + srcFilename);
+
+		const u32 bitCount = infoHeader.biBitCount;
+		Assert::True((bitCount == 8) || (bitCount == 24) || (bitCount == 32), "unsupported bits per pixel of the heightmap: " + std::to_string(bitCount));
+
+		width         = (u32)infoHeader.biWidth;
+		height        = (u32)std::abs(infoHeader.biHeight);
+		bytesPerPixel = bitCount / 8;
+		srcRowBytes   = (((size_t)width * bitCount + 31) / 32) * 4;   // each line is aligned to 4 bytes
+		dataOffset    = fileHeader.bfOffBits;
+		isBottomUp    = (infoHeader.biHeight > 0);
+	}
+
+	Assert::True((width > 1) && (height > 1), "the heightmap must have at least 2x2 samples");
+	Assert::True(((width - 1) % tileSize == 0) && ((height - 1) % tileSize == 0), "the heightmap can't be split into tiles of size: " + std::to_string(tileSize));
+
+	TerrainTilesHeader header;
+	header.magic       = MAGIC;
+	header.version     = VERSION;
+	header.verticesByX = width;
+	header.verticesByZ = height;
+	header.tileSize    = tileSize;
+	header.tilesByX    = (width - 1) / tileSize;
+	header.tilesByZ    = (height - 1) / tileSize;
+	header.cellSize    = cellSize;
+	header.heightScale = heightScale;
+
+	FilePtr pDst = OpenFile(dstFilename, "wb");
+	Assert::True(fwrite(&header, sizeof(header), 1, pDst.get()) == 1, "can't write the header of tiles file");
+
+	// ---------------------------------------------
+
+	const u32 tileVerts = tileSize + 1;
+
+	std::vector<uint8_t>  srcRow(srcRowBytes);
+	std::vector<uint16_t> strip((size_t)tileVerts * width);
+	std::vector<uint16_t> tile((size_t)tileVerts * tileVerts);
+
+	for (u32 tz = 0; tz < header.tilesByZ; ++tz)
+	{
+		// read rows of the strip (the last row is shared with the next strip)
+		for (u32 r = 0; r < tileVerts; ++r)
+		{
+			const u32 row     = tz * tileSize + r;
+			const u32 fileRow = (isBottomUp) ? (height - 1 - row) : row;
+
+			_fseeki64(pSrc.get(), (long long)(dataOffset + fileRow * srcRowBytes), SEEK_SET);
+			Assert::True(fread(srcRow.data(), 1, srcRowBytes, pSrc.get()) == srcRowBytes, "can't read in the heightmap row: " + std::to_string(row));
+
+			uint16_t* stripRow = strip.data() + (size_t)r * width;
+
+			if (srcFormat == HEIGHTMAP_BMP)
+			{
+				// this is a grey scale image so we take only the first colour
+				for (u32 col = 0; col < width; ++col)
+					stripRow[col] = srcRow[col * bytesPerPixel];
+			}
+			else
+			{
+				memcpy(stripRow, srcRow.data(), width * sizeof(uint16_t));
+			}
+		}
+
+		// split the strip into tiles
+		for (u32 tx = 0; tx < header.tilesByX; ++tx)
+		{
+			for (u32 r = 0; r < tileVerts; ++r)
+			{
+				const uint16_t* src = strip.data() + (size_t)r * width + tx * tileSize;
+				std::copy(src, src + tileVerts, tile.data() + (size_t)r * tileVerts);
+			}
+
+			Assert::True(fwrite(tile.data(), sizeof(uint16_t), tile.size(), pDst.get()) == tile.size(), "can't write a tile into the file: " + dstFilename);
+		}
+	}
+
+	Log::Debug("heightmap is converted into tiles: " + dstFilename + " (tiles: " + std::to_string(header.tilesByX) + "x" + std::to_string(header.tilesByZ) + ")");
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainTilesFile::Open(const std::string& filename)
+{
+	// map the tiles file into memory; pages of the file are loaded by the OS
+	// only when some tile is accessed for the first time (and can be dropped
+	// by the OS under memory pressure since the view is read-only)
+
+	Close();
+
+	try
+	{
+		file_.Open(filename, ECS::MappedFile::ACCESS_RANDOM);
+	}
+	catch (ECS::LIB_Exception& e)
+	{
+		throw EngineException("can't map the tiles file: " + filename + " (" + e.GetStr() + ")");
+	}
+
+	try
+	{
+		Assert::True(file_.GetSize() >= sizeof(TerrainTilesHeader), "the tiles file is too small: " + filename);
+
+		// check the header
+		memcpy(&header_, file_.GetData(), sizeof(header_));
+
+		Assert::True(header_.magic == MAGIC, "the file isn't a terrain tiles file: " + filename);
+		Assert::True(header_.version == VERSION, "wrong version of the terrain tiles file: " + filename);
+
+		const u32 tileVerts = header_.tileSize + 1;
+		tileSamplesCount_ = (size_t)tileVerts * tileVerts;
+
+		const size_t tilesCount   = (size_t)header_.tilesByX * header_.tilesByZ;
+		const size_t expectedSize = sizeof(header_) + tilesCount * tileSamplesCount_ * sizeof(uint16_t);
+
+		Assert::True(file_.GetSize() == expectedSize, "wrong size of the terrain tiles file: " + filename);
+	}
+	catch (EngineException&)
+	{
+		Close();
+		throw;
+	}
+
+	Log::Debug("terrain tiles file is mapped: " + filename);
+}
+
+///////////////////////////////////////////////////////////
+
+void TerrainTilesFile::Close()
+{
+	file_.Close();
+	header_ = TerrainTilesHeader();
+	tileSamplesCount_ = 0;
+}
+
+///////////////////////////////////////////////////////////
+
+const uint16_t* TerrainTilesFile::GetTileSamples(const u32 tileIdx) const
+{
+	const uint8_t* pTiles = file_.GetData() + sizeof(TerrainTilesHeader);
+	return (const uint16_t*)(pTiles + tileIdx * tileSamplesCount_ * sizeof(uint16_t));
+}
+
+///////////////////////////////////////////////////////////
+
+uint16_t TerrainTilesFile::GetSample(const int col, const int row) const
+{
+	// find a tile which contains the sample and read it from this tile
+
+	const int c = std::clamp(col, 0, (int)header_.verticesByX - 1);
+	const int r = std::clamp(row, 0, (int)header_.verticesByZ - 1);
+	const u32 tileSize = header_.tileSize;
+
+	// samples on the right/bottom border belong to the last tile
+	const u32 tx = std::min((u32)c / tileSize, header_.tilesByX - 1);
+	const u32 tz = std::min((u32)r / tileSize, header_.tilesByZ - 1);
+
+	const u32 localCol = c - tx * tileSize;
+	const u32 localRow = r - tz * tileSize;
+
+	return GetTileSamples(tz * header_.tilesByX + tx)[localRow * (tileSize + 1) + localCol];
+}
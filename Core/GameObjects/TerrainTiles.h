@@ -0,0 +1,89 @@
+// *********************************************************************************
+// Filename:      TerrainTiles.h
+// Description:   a tiled terrain heightmap file (is preprocessed from BMP/RAW16
+//                heightmaps) which is memory-mapped for reading;
+//
+//                file layout:
+//                  [header][tile 0][tile 1]...[tile N-1]
+//
+//                tiles go row by row (from the max Z of the terrain); each tile
+//                is a contiguous block of (tileSize+1)*(tileSize+1) uint16 samples
+//                (tiles overlap their neighbours by 1 sample so each tile can be
+//                built without touching others); so loading of a single tile
+//                touches only the pages of this tile;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "../Common/Types.h"
+#include "Common/MappedFile.h"        // from the ECS module
+
+
+struct TerrainTilesHeader
+{
+	u32   magic       = 0;
+	u32   version     = 0;
+	u32   verticesByX = 0;     // size of the whole heightmap
+	u32   verticesByZ = 0;
+	u32   tileSize    = 0;     // number of quads by each side of a tile
+	u32   tilesByX    = 0;
+	u32   tilesByZ    = 0;
+	float cellSize    = 1.0f;  // distance between neighbour samples
+	float heightScale = 1.0f;  // height = sample / heightScale
+};
+
+///////////////////////////////////////////////////////////
+
+class TerrainTilesFile final
+{
+public:
+	static constexpr u32 MAGIC   = 0x534C5454;   // "TTLS"
+	static constexpr u32 VERSION = 1;
+
+	enum HeightmapFormat
+	{
+		HEIGHTMAP_RAW16,        // 16 bit samples, the first row is the max Z
+		HEIGHTMAP_BMP,          // grey scale bitmap (8/24/32 bits), stored upside down
+	};
+
+public:
+	TerrainTilesFile() {}
+	~TerrainTilesFile() { Close(); }
+
+	// restrict any copying of instances of this class
+	TerrainTilesFile(const TerrainTilesFile&) = delete;
+	TerrainTilesFile& operator=(const TerrainTilesFile&) = delete;
+
+	// preprocess a heightmap into the tiled format; the source is read by strips
+	// of rows so the whole heightmap is never kept in memory;
+	// (for BMP the dimensions are taken from the file so verticesByX/Z are ignored)
+	static void ConvertHeightmap(
+		const std::string& srcFilename,
+		const HeightmapFormat srcFormat,
+		const u32 verticesByX,
+		const u32 verticesByZ,
+		const u32 tileSize,
+		const float cellSize,
+		const float heightScale,
+		const std::string& dstFilename);
+
+	void Open(const std::string& filename);
+	void Close();
+
+	inline bool IsOpened() const { return file_.IsOpen(); }
+	inline const TerrainTilesHeader& GetHeader() const { return header_; }
+
+	// get samples of the tile (row by row); pages are read by the OS on the first access
+	const uint16_t* GetTileSamples(const u32 tileIdx) const;
+
+	// get a sample by its coords in the whole heightmap (coords are clamped)
+	uint16_t GetSample(const int col, const int row) const;
+
+private:
+	TerrainTilesHeader header_;
+	ECS::MappedFile    file_;
+	size_t             tileSamplesCount_ = 0;
+};
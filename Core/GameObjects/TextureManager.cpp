@@ -318,6 +318,15 @@ TexID TextureManager::GetIDByName(const TexName& name)
 
 ///////////////////////////////////////////////////////////
 
+TexName TextureManager::GetNameByID(const TexID id)
+{
+	// return a name (path) of texture by ID or an empty string if there is no such a texture
+
+	return (BinarySearch(ids_, id)) ? names_[GetIdxInSortedArr(ids_, id)] : "";
+}
+
+///////////////////////////////////////////////////////////
+
 void TextureManager::GetIDsByNames(
 	const std::vector<TexName>& names, 
 	std::vector<TexID>& outIDs)
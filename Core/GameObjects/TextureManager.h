@@ -61,6 +61,7 @@ public:
 	TextureClass* GetTexPtrByName(const TexName& name);
 
 	TexID GetIDByName(const TexName& name);
+	TexName GetNameByID(const TexID id);
 	void GetIDsByNames(const std::vector<TexName>& names, std::vector<TexID>& outIDs);
 
 	inline void GetAllTexturesIDs(std::vector<TexID>& outTexturesIDs) { outTexturesIDs = ids_; }
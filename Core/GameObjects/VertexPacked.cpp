@@ -0,0 +1,311 @@
+// *********************************************************************************
+// Filename:      VertexPacked.cpp
+// Description:   implementation of packing/unpacking of vertices;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "VertexPacked.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+
+static constexpr float SNORM16_MAX = 32767.0f;
+static constexpr float UNORM16_MAX = 65535.0f;
+
+
+static inline float SignNotZero(const float value)
+{
+	return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+static inline int16_t FloatToSnorm16(const float value)
+{
+	return (int16_t)std::lroundf(std::clamp(value, -1.0f, 1.0f) * SNORM16_MAX);
+}
+
+static inline float Snorm16ToFloat(const int16_t value)
+{
+	// -32768 and -32767 are both mapped to -1
+	return std::max((float)value / SNORM16_MAX, -1.0f);
+}
+
+static inline uint16_t FloatToUnorm16(const float value)
+{
+	return (uint16_t)std::lroundf(std::clamp(value, 0.0f, 1.0f) * UNORM16_MAX);
+}
+
+///////////////////////////////////////////////////////////
+
+static void GetAABBMinAndSize(
+	const BoundingBox& aabb,
+	XMFLOAT3& outMin,
+	XMFLOAT3& outSize)
+{
+	outMin  = { aabb.Center.x - aabb.Extents.x, aabb.Center.y - aabb.Extents.y, aabb.Center.z - aabb.Extents.z };
+	outSize = { 2.0f * aabb.Extents.x, 2.0f * aabb.Extents.y, 2.0f * aabb.Extents.z };
+}
+
+///////////////////////////////////////////////////////////
+
+static inline uint16_t QuantizePosition(const float pos, const float min, const float size)
+{
+	// flat meshes have zero size by some axis so all the positions are at the min
+	return (size > 0.0f) ? FloatToUnorm16((pos - min) / size) : 0;
+}
+
+
+
+// *********************************************************************************
+//                          OCTAHEDRAL ENCODING
+// *********************************************************************************
+
+void VertexPacking::EncodeOctahedral(const XMFLOAT3& vec, int16_t outOct[2])
+{
+	// project the vector onto the octahedron |x| + |y| + |z| = 1 and
+	// unfold its lower half (z < 0) onto the XY-plane over the upper half
+
+	const float l1Norm = fabsf(vec.x) + fabsf(vec.y) + fabsf(vec.z);
+
+	// a zero vector can't be encoded so we store +Z
+	if (l1Norm < 1e-20f)
+	{
+		outOct[0] = 0;
+		outOct[1] = 0;
+		return;
+	}
+
+	float x = vec.x / l1Norm;
+	float y = vec.y / l1Norm;
+
+	if (vec.z < 0.0f)
+	{
+		const float foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+		const float foldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+
+		x = foldedX;
+		y = foldedY;
+	}
+
+	outOct[0] = FloatToSnorm16(x);
+	outOct[1] = FloatToSnorm16(y);
+}
+
+///////////////////////////////////////////////////////////
+
+XMFLOAT3 VertexPacking::DecodeOctahedral(const int16_t oct[2])
+{
+	float x = Snorm16ToFloat(oct[0]);
+	float y = Snorm16ToFloat(oct[1]);
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+
+	// unfold the lower half of the octahedron
+	if (z < 0.0f)
+	{
+		const float unfoldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+		const float unfoldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+
+		x = unfoldedX;
+		y = unfoldedY;
+	}
+
+	XMFLOAT3 vec;
+	XMStoreFloat3(&vec, XMVector3Normalize(XMVectorSet(x, y, z, 0.0f)));
+
+	return vec;
+}
+
+///////////////////////////////////////////////////////////
+
+XMFLOAT3 VertexPacking::GetPositionMaxError(const BoundingBox& aabb)
+{
+	const float scale = 1.0f / UNORM16_MAX;
+
+	return { aabb.Extents.x * scale, aabb.Extents.y * scale, aabb.Extents.z * scale };
+}
+
+
+
+// *********************************************************************************
+//                          PACKING OF A SINGLE VERTEX
+// *********************************************************************************
+
+void VertexPacking::Pack(const Vertex3D& vertex, VertexPacked& outVertex)
+{
+	const XMFLOAT3& pos = vertex.position;
+
+	outVertex.position = { pos.x, pos.y, pos.z, GetBinormalSign(vertex) };
+	outVertex.texture  = XMHALF2(vertex.texture.x, vertex.texture.y);
+	outVertex.color    = vertex.color;
+
+	EncodeOctahedral(vertex.normal, outVertex.normal);
+	EncodeOctahedral(vertex.tangent, outVertex.tangent);
+}
+
+///////////////////////////////////////////////////////////
+
+void VertexPacking::Unpack(const VertexPacked& vertex, Vertex3D& outVertex)
+{
+	const XMFLOAT4& pos = vertex.position;
+
+	outVertex.position = { pos.x, pos.y, pos.z };
+	outVertex.texture  = { XMConvertHalfToFloat(vertex.texture.x), XMConvertHalfToFloat(vertex.texture.y) };
+	outVertex.normal   = DecodeOctahedral(vertex.normal);
+	outVertex.tangent  = DecodeOctahedral(vertex.tangent);
+	outVertex.binormal = ComputeBinormal(outVertex.normal, outVertex.tangent, pos.w);
+	outVertex.color    = vertex.color;
+}
+
+///////////////////////////////////////////////////////////
+
+void VertexPacking::Pack(
+	const Vertex3D& vertex,
+	const BoundingBox& aabb,
+	VertexPacked16& outVertex)
+{
+	XMFLOAT3 min;
+	XMFLOAT3 size;
+	GetAABBMinAndSize(aabb, min, size);
+
+	const XMFLOAT3& pos = vertex.position;
+
+	outVertex.position[0] = QuantizePosition(pos.x, min.x, size.x);
+	outVertex.position[1] = QuantizePosition(pos.y, min.y, size.y);
+	outVertex.position[2] = QuantizePosition(pos.z, min.z, size.z);
+	outVertex.position[3] = (GetBinormalSign(vertex) < 0.0f) ? UINT16_MAX : 0;
+
+	outVertex.texture = XMHALF2(vertex.texture.x, vertex.texture.y);
+	outVertex.color   = vertex.color;
+
+	EncodeOctahedral(vertex.normal, outVertex.normal);
+	EncodeOctahedral(vertex.tangent, outVertex.tangent);
+}
+
+///////////////////////////////////////////////////////////
+
+void VertexPacking::Unpack(
+	const VertexPacked16& vertex,
+	const BoundingBox& aabb,
+	Vertex3D& outVertex)
+{
+	XMFLOAT3 min;
+	XMFLOAT3 size;
+	GetAABBMinAndSize(aabb, min, size);
+
+	const uint16_t* pos = vertex.position;
+	const float binormalSign = (pos[3] != 0) ? -1.0f : 1.0f;
+
+	outVertex.position.x = min.x + size.x * (pos[0] / UNORM16_MAX);
+	outVertex.position.y = min.y + size.y * (pos[1] / UNORM16_MAX);
+	outVertex.position.z = min.z + size.z * (pos[2] / UNORM16_MAX);
+
+	outVertex.texture  = { XMConvertHalfToFloat(vertex.texture.x), XMConvertHalfToFloat(vertex.texture.y) };
+	outVertex.normal   = DecodeOctahedral(vertex.normal);
+	outVertex.tangent  = DecodeOctahedral(vertex.tangent);
+	outVertex.binormal = ComputeBinormal(outVertex.normal, outVertex.tangent, binormalSign);
+	outVertex.color    = vertex.color;
+}
+
+
+
+// *********************************************************************************
+//                          PACKING OF ARRAYS
+// *********************************************************************************
+
+void VertexPacking::PackVertices(
+	const std::vector<Vertex3D>& vertices,
+	std::vector<VertexPacked>& outVertices)
+{
+	outVertices.resize(vertices.size());
+
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+		Pack(vertices[idx], outVertices[idx]);
+}
+
+///////////////////////////////////////////////////////////
+
+void VertexPacking::PackVertices(
+	const std::vector<Vertex3D>& vertices,
+	const BoundingBox& aabb,
+	std::vector<VertexPacked16>& outVertices)
+{
+	outVertices.resize(vertices.size());
+
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+		Pack(vertices[idx], aabb, outVertices[idx]);
+}
+
+///////////////////////////////////////////////////////////
+
+void VertexPacking::UnpackVertices(
+	const std::vector<VertexPacked>& vertices,
+	std::vector<Vertex3D>& outVertices)
+{
+	outVertices.resize(vertices.size());
+
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+		Unpack(vertices[idx], outVertices[idx]);
+}
+
+///////////////////////////////////////////////////////////
+
+void VertexPacking::UnpackVertices(
+	const std::vector<VertexPacked16>& vertices,
+	const BoundingBox& aabb,
+	std::vector<Vertex3D>& outVertices)
+{
+	outVertices.resize(vertices.size());
+
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+		Unpack(vertices[idx], aabb, outVertices[idx]);
+}
+
+///////////////////////////////////////////////////////////
+
+uint32_t VertexPacking::GetVertexSize(const VertexFormat format)
+{
+	switch (format)
+	{
+		case VERTEX_FORMAT_PACKED:    return sizeof(VertexPacked);
+		case VERTEX_FORMAT_PACKED_16: return sizeof(VertexPacked16);
+		default:                      return sizeof(Vertex3D);
+	}
+}
+
+
+
+// *********************************************************************************
+//                              PRIVATE HELPERS
+// *********************************************************************************
+
+float VertexPacking::GetBinormalSign(const Vertex3D& vertex)
+{
+	// the binormal is restored as cross(normal, tangent) so we only need
+	// to know if the tangent frame is mirrored (for instance: mirrored UVs)
+
+	const XMVECTOR normal   = XMLoadFloat3(&vertex.normal);
+	const XMVECTOR tangent  = XMLoadFloat3(&vertex.tangent);
+	const XMVECTOR binormal = XMLoadFloat3(&vertex.binormal);
+
+	const float dot = XMVectorGetX(XMVector3Dot(XMVector3Cross(normal, tangent), binormal));
+
+	return (dot < 0.0f) ? -1.0f : 1.0f;
+}
+
+///////////////////////////////////////////////////////////
+
+XMFLOAT3 VertexPacking::ComputeBinormal(
+	const XMFLOAT3& normal,
+	const XMFLOAT3& tangent,
+	const float sign)
+{
+	const XMVECTOR cross = XMVector3Cross(XMLoadFloat3(&normal), XMLoadFloat3(&tangent));
+
+	XMFLOAT3 binormal;
+	XMStoreFloat3(&binormal, XMVector3Normalize(cross) * sign);
+
+	return binormal;
+}
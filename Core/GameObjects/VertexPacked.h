@@ -0,0 +1,116 @@
+// *********************************************************************************
+// Filename:      VertexPacked.h
+// Description:   compact (packed) vertex formats which are used instead of Vertex3D
+//                to cut the memory of vertex buffers + CPU encoding/decoding of them;
+//
+//                what is packed:
+//                  texture coords: half floats;
+//                  normal/tangent: octahedral encoding into 2 x snorm16;
+//                  binormal:       only its sign (binormal = sign * cross(normal, tangent));
+//                  position:       full floats (VertexPacked) or 3 x unorm16
+//                                  relative to the mesh AABB (VertexPacked16);
+//
+//                sizes: Vertex3D - 60 bytes, VertexPacked - 32, VertexPacked16 - 24
+//
+//                NOTE: it's a standalone encoding/decoding utility: there is no shader
+//                      with the packed input layouts yet so the MeshStorage creates
+//                      vertex buffers only from Vertex3D
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <DirectXCollision.h>
+
+#include "Vertex.h"
+
+
+enum VertexFormat
+{
+	VERTEX_FORMAT_FULL,          // Vertex3D
+	VERTEX_FORMAT_PACKED,        // VertexPacked
+	VERTEX_FORMAT_PACKED_16,     // VertexPacked16
+};
+
+///////////////////////////////////////////////////////////
+
+struct VertexPacked
+{
+	// input layout: R32G32B32A32_FLOAT, R16G16_FLOAT, R16G16_SNORM, R16G16_SNORM, B8G8R8A8_UNORM
+
+	DirectX::XMFLOAT4              position;        // w: the sign of binormal (+1/-1)
+	DirectX::PackedVector::XMHALF2 texture;
+	int16_t                        normal[2];       // octahedral
+	int16_t                        tangent[2];      // octahedral
+	DirectX::PackedVector::XMCOLOR color;
+};
+
+///////////////////////////////////////////////////////////
+
+struct VertexPacked16
+{
+	// input layout: R16G16B16A16_UNORM, R16G16_FLOAT, R16G16_SNORM, R16G16_SNORM, B8G8R8A8_UNORM;
+	// position = aabbMin + position.xyz * aabbSize
+
+	uint16_t                       position[4];     // w: the sign of binormal (0: +1, 0xFFFF: -1)
+	DirectX::PackedVector::XMHALF2 texture;
+	int16_t                        normal[2];       // octahedral
+	int16_t                        tangent[2];      // octahedral
+	DirectX::PackedVector::XMCOLOR color;
+};
+
+///////////////////////////////////////////////////////////
+
+class VertexPacking final
+{
+public:
+	// a unit vector <=> 2 x snorm16 (the vector doesn't have to be normalized before encoding)
+	static void EncodeOctahedral(const DirectX::XMFLOAT3& vec, int16_t outOct[2]);
+	static DirectX::XMFLOAT3 DecodeOctahedral(const int16_t oct[2]);
+
+	// the max error of positions of VertexPacked16 by each axis (a half of the quantization step)
+	static DirectX::XMFLOAT3 GetPositionMaxError(const DirectX::BoundingBox& aabb);
+
+	// --------------------------------------------
+
+	static void Pack  (const Vertex3D& vertex, VertexPacked& outVertex);
+	static void Unpack(const VertexPacked& vertex, Vertex3D& outVertex);
+
+	static void Pack  (const Vertex3D& vertex, const DirectX::BoundingBox& aabb, VertexPacked16& outVertex);
+	static void Unpack(const VertexPacked16& vertex, const DirectX::BoundingBox& aabb, Vertex3D& outVertex);
+
+	// --------------------------------------------
+
+	static void PackVertices(
+		const std::vector<Vertex3D>& vertices,
+		std::vector<VertexPacked>& outVertices);
+
+	static void PackVertices(
+		const std::vector<Vertex3D>& vertices,
+		const DirectX::BoundingBox& aabb,
+		std::vector<VertexPacked16>& outVertices);
+
+	static void UnpackVertices(
+		const std::vector<VertexPacked>& vertices,
+		std::vector<Vertex3D>& outVertices);
+
+	static void UnpackVertices(
+		const std::vector<VertexPacked16>& vertices,
+		const DirectX::BoundingBox& aabb,
+		std::vector<Vertex3D>& outVertices);
+
+	// the size of one vertex in bytes by its format
+	static uint32_t GetVertexSize(const VertexFormat format);
+
+private:
+	static float GetBinormalSign(const Vertex3D& vertex);
+
+	static DirectX::XMFLOAT3 ComputeBinormal(
+		const DirectX::XMFLOAT3& normal,
+		const DirectX::XMFLOAT3& tangent,
+		const float sign);
+};
@@ -83,6 +83,7 @@ bool InitializeGraphics::InitializeScene(
 	MeshStorage& meshStorage,
 	Settings& settings,
 	RenderToTextureClass& renderToTexture,
+	TerrainHeightField& terrainHeightField,
 	ID3D11Device* pDevice,
 	ID3D11DeviceContext* pDeviceContext)
 	
@@ -112,6 +113,7 @@ bool InitializeGraphics::InitializeScene(
 			pDeviceContext, 
 			entityMgr,
 			meshStorage,
+			terrainHeightField,
 			settings, 
 			farZ);
 		Assert::True(result, "can't initialize models");
@@ -590,7 +592,10 @@ void CreateCubes(ID3D11Device* pDevice, ECS::EntityManager& enttMgr)
 
 ///////////////////////////////////////////////////////////
 
-void CreateTerrain(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
+void CreateTerrain(
+	ID3D11Device* pDevice,
+	ECS::EntityManager& entityMgr,
+	TerrainHeightField& heightField)
 {
 	//
 	// create and setup terrain elements
@@ -611,7 +616,9 @@ void CreateTerrain(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
 		gridWidth,
 		gridDepth,
 		gridWidth + 1,
-		gridDepth + 1);
+		gridDepth + 1,
+		heightField,
+		&entityMgr.GetThreadPool());
 
 	// load and set a texture for the terrain mesh
 	const TexPath dirt01diffTexPath = "data/textures/dirt01d.dds";
@@ -635,8 +642,9 @@ void CreateTerrain(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
 	entityMgr.AddNameComponent(terrainEnttID, "terrain");
 	entityMgr.AddMeshComponent(terrainEnttID, terrainMeshID);
 
+	// NOTE: the terrain isn't added into the render buckets since
+	//       it is rendered by chunks with LODs (see GraphicsClass::RenderTerrain())
 	entityMgr.AddTextureTransformComponent(ECS::TexTransformType::STATIC, { terrainEnttID }, { terrainTexTransform });
-	entityMgr.AddRenderingComponent({ terrainEnttID });
 	entityMgr.AddBoundingComponent(terrainEnttID, aabb, ECS::BoundingType::AABB);
 }
 
@@ -878,7 +886,9 @@ void CreatePlanes(ID3D11Device* pDevice, ECS::EntityManager& mgr)
 
 ///////////////////////////////////////////////////////////
 
-void CreateTrees(ID3D11Device* pDevice, ECS::EntityManager& mgr)
+void CreateTrees(
+	ECS::EntityManager& mgr,
+	const std::vector<MeshID>& treeMeshesIds)
 {
 	// create and setup trees entities
 
@@ -889,16 +899,8 @@ void CreateTrees(ID3D11Device* pDevice, ECS::EntityManager& mgr)
 	const u32 treesCount = 30;
 	const std::vector<EntityID> treesEnttIDs = mgr.CreateEntities(treesCount);
 
-	//const std::string pathToModel = "data/models/tree2/source/HeroTree.fbx";
-	//const std::string pathToModel = "data/models/trees/60-tree/Tree.blend";
-
-	ModelsCreator modelCreator;
 	MeshStorage* pMeshStorage = MeshStorage::Get();
 
-	const std::string pathToModel = "data/models/trees/FBX format/conifer_macedonian_pine1.fbx";
-	const std::vector<MeshID> treeMeshesIds = modelCreator.ImportFromFile(pDevice, pathToModel);
-
-
 	std::vector<DirectX::XMFLOAT3> positions;
 
 	positions.reserve(treesCount);
@@ -964,17 +966,16 @@ void CreateTrees(ID3D11Device* pDevice, ECS::EntityManager& mgr)
 
 ///////////////////////////////////////////////////////////
 
-void CreateNanoSuit(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
+void CreateNanoSuit(
+	ECS::EntityManager& entityMgr,
+	const std::vector<MeshID>& nanosuitMeshesIDs)
 {
 	// create and setup a nanosuit entity
 
 	Log::Debug();
 
-	ModelsCreator modelCreator;
 	const EntityID nanosuitEnttID = entityMgr.CreateEntity();
 
-	const std::vector<MeshID> nanosuitMeshesIDs = modelCreator.ImportFromFile(pDevice, "data/models/nanosuit/nanosuit.obj");
-
 	entityMgr.AddTransformComponent(nanosuitEnttID, { 10, 2, 8 }, {0,0,0,1}, {0.5f});
 	entityMgr.AddNameComponent(nanosuitEnttID, "nanosuit");
 	entityMgr.AddMeshComponent(nanosuitEnttID, nanosuitMeshesIDs);
@@ -988,18 +989,16 @@ void CreateNanoSuit(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
 
 ///////////////////////////////////////////////////////////
 
-void CreateHouse(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
+void CreateHouse(
+	ECS::EntityManager& entityMgr,
+	const std::vector<MeshID>& meshID)
 {
 	// create and setup a nanosuit entity
 
 	Log::Debug();
 
-	ModelsCreator modelCreator;
 	const EntityID enttID = entityMgr.CreateEntity();
 
-	const std::string pathToModel = "data/models/stalker/stalker-house/source/SmallHouse.fbx";
-	const std::vector<MeshID> meshID = modelCreator.ImportFromFile(pDevice, pathToModel);
-
 	const DirectX::XMVECTOR quat = DirectX::XMQuaternionRotationRollPitchYawFromVector({ DirectX::XM_PIDIV2, 0,0 });
 
 	entityMgr.AddTransformComponent(enttID, { -10,3,-10 }, quat);
@@ -1015,18 +1014,16 @@ void CreateHouse(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
 
 ///////////////////////////////////////////////////////////
 
-void CreateHouse2(ID3D11Device* pDevice, ECS::EntityManager& entityMgr)
+void CreateHouse2(
+	ECS::EntityManager& entityMgr,
+	const std::vector<MeshID>& meshID)
 {
 	// create and setup a nanosuit entity
 
 	Log::Debug();
 
-	ModelsCreator modelCreator;
 	const EntityID enttID = entityMgr.CreateEntity();
 
-	const std::string pathToModel = "data/models/stalker/abandoned-house-20/source/LittleHouse.fbx";
-	const std::vector<MeshID> meshID = modelCreator.ImportFromFile(pDevice, pathToModel);
-
 	const DirectX::XMVECTOR quat = DirectX::XMQuaternionRotationRollPitchYawFromVector({ DirectX::XM_PIDIV2, 0,0 });
 
 	entityMgr.AddTransformComponent(enttID, { 20,3,-10 }, quat, {0.01f});
@@ -1048,6 +1045,7 @@ bool InitializeGraphics::InitializeModels(
 	ID3D11DeviceContext* pDeviceContext,
 	ECS::EntityManager& entityMgr,
 	MeshStorage& meshStorage,
+	TerrainHeightField& terrainHeightField,
 	Settings & settings,
 	const float farZ)
 {
@@ -1059,22 +1057,42 @@ bool InitializeGraphics::InitializeModels(
 
 	try
 	{
+		// import all the models of the scene at once (independent
+		// files are imported in parallel on the thread pool)
+
+		//"data/models/tree2/source/HeroTree.fbx"
+		//"data/models/trees/60-tree/Tree.blend"
+
+		const std::vector<std::string> modelsPaths =
+		{
+			"data/models/trees/FBX format/conifer_macedonian_pine1.fbx",
+			"data/models/nanosuit/nanosuit.obj",
+			"data/models/stalker/stalker-house/source/SmallHouse.fbx",
+			"data/models/stalker/abandoned-house-20/source/LittleHouse.fbx",
+		};
+
+		ModelsCreator modelCreator;
+		const std::vector<std::vector<MeshID>> modelsMeshesIDs = modelCreator.ImportFromFiles(
+			pDevice,
+			modelsPaths,
+			&entityMgr.GetThreadPool());
+
 		CreateSkull(pDevice, entityMgr);
 		CreateWater(pDevice, entityMgr);
-		CreateTerrain(pDevice, entityMgr);
+		CreateTerrain(pDevice, entityMgr, terrainHeightField);
 
 		
 		CreateCubes(pDevice, entityMgr);
 
 		CreateSpheres(pDevice, entityMgr);
 		CreateCylinders(pDevice, entityMgr);
-		CreateTrees(pDevice, entityMgr);
+		CreateTrees(entityMgr, modelsMeshesIDs[0]);
 
 		CreatePlanes(pDevice, entityMgr);
-		CreateNanoSuit(pDevice, entityMgr);
+		CreateNanoSuit(entityMgr, modelsMeshesIDs[1]);
 
-		CreateHouse(pDevice, entityMgr);
-		CreateHouse2(pDevice, entityMgr);
+		CreateHouse(entityMgr, modelsMeshesIDs[2]);
+		CreateHouse2(entityMgr, modelsMeshesIDs[3]);
 
 	}
 	catch (const std::out_of_range& e)
@@ -1212,6 +1230,19 @@ bool InitializeGraphics::InitializeLightSources(
 	std::vector<EntityID> pointLightsIds = mgr.CreateEntities(numPointLights);
 	mgr.AddLightComponent(pointLightsIds, pointLightsParams);
 
+	// circle the first point light over the land surface (other point lights are static
+	// so only this light is changed each frame)
+	if (!pointLightsIds.empty())
+	{
+		ECS::LightAnimParams orbitParams;
+		orbitParams.type   = ECS::LIGHT_ANIM_ORBIT;
+		orbitParams.center = { 0, 3, 0 };
+		orbitParams.radius = 30.0f;
+		orbitParams.speed  = 0.2f;
+
+		mgr.lightSystem_.AddPointLightAnimation(pointLightsIds.front(), orbitParams);
+	}
+
 
 	// -----------------------------------------------------------------------------
 	//                   SPOT LIGHTS: SETUP AND CREATE
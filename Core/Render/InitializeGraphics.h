@@ -49,6 +49,7 @@ public:
 		MeshStorage& meshStorage,
 		Settings& settings,
 		RenderToTextureClass& renderToTexture,
+		TerrainHeightField& terrainHeightField,
 		ID3D11Device* pDevice,
 		ID3D11DeviceContext* pDeviceContext);
 
@@ -56,6 +57,7 @@ public:
 		ID3D11DeviceContext* pDeviceContext,
 		ECS::EntityManager& entityMgr,
 		MeshStorage& meshStorage,
+		TerrainHeightField& terrainHeightField,
 		Settings & settings,
 		const float farZ);
 
@@ -0,0 +1,346 @@
+// *********************************************************************************
+// Filename:      LodSelector.cpp
+// Description:   implementation of the LodSelector functional;
+//
+// Created:       17.10.26
+// *********************************************************************************
+#include "LodSelector.h"
+#include "../Common/Assert.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+
+// the distance to the camera can't be less than this value
+// (the camera is inside the bounding sphere of the instance)
+static constexpr float MIN_DISTANCE = 0.001f;
+
+
+// *********************************************************************************
+
+void LodSelector::SetCamera(
+	const XMFLOAT3& cameraPos,
+	const float projScaleY,
+	const float viewportHeight)
+{
+	cameraPos_     = cameraPos;
+	pixelsPerUnit_ = 0.5f * projScaleY * viewportHeight;
+}
+
+///////////////////////////////////////////////////////////
+
+bool LodSelector::SelectLODs(
+	const std::vector<XMMATRIX>& worlds,
+	const std::vector<u32>& visibleInstances,
+	const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh,
+	const Mesh::DataForRendering& meshesData,
+	std::vector<uint8_t>& inOutLods,
+	std::vector<u32>& outChangedMeshes) const
+{
+	Assert::True(numVisibleInstancesPerMesh.size() == meshesData.boundBoxes_.size(), "the number of meshes is wrong");
+	Assert::True(meshesData.lods_.size() == meshesData.boundBoxes_.size(), "there are no LODs data for some mesh");
+
+	// the set of instances is changed
+	bool isChanged = (inOutLods.size() != worlds.size());
+	inOutLods.resize(worlds.size(), 0);
+	outChangedMeshes.clear();
+
+	for (size_t meshIdx = 0, i = 0; meshIdx < numVisibleInstancesPerMesh.size(); ++meshIdx)
+	{
+		const BoundingBox& aabb = meshesData.boundBoxes_[meshIdx];
+		const std::vector<Mesh::DataForRendering::LodData>& lods = meshesData.lods_[meshIdx];
+		const size_t visibleEnd = i + (size_t)numVisibleInstancesPerMesh[meshIdx];
+		bool isMeshChanged = false;
+
+		Assert::True(visibleEnd <= visibleInstances.size(), "the number of visible instances is wrong");
+
+		// the mesh has no LODs
+		if (lods.empty())
+		{
+			for (; i < visibleEnd; ++i)
+			{
+				const u32 instanceIdx = visibleInstances[i];
+
+				isMeshChanged |= (inOutLods[instanceIdx] != 0);
+				inOutLods[instanceIdx] = 0;
+			}
+		}
+		else
+		{
+			for (; i < visibleEnd; ++i)
+			{
+				const u32 instanceIdx = visibleInstances[i];
+				const uint8_t lod = SelectLOD(worlds[instanceIdx], aabb, lods, inOutLods[instanceIdx]);
+
+				isMeshChanged |= (inOutLods[instanceIdx] != lod);
+				inOutLods[instanceIdx] = lod;
+			}
+		}
+
+		if (isMeshChanged)
+			outChangedMeshes.push_back((u32)meshIdx);
+	}
+
+	return isChanged || !outChangedMeshes.empty();
+}
+
+///////////////////////////////////////////////////////////
+
+uint8_t LodSelector::SelectLOD(
+	const XMMATRIX& world,
+	const BoundingBox& aabb,
+	const std::vector<Mesh::DataForRendering::LodData>& lods,
+	const uint8_t currentLod) const
+{
+	// the error of LOD is scaled by the instance scale (the max scale by axes)
+	// and projected onto the screen at the nearest point of the bounding sphere;
+	// errors of LODs go in ascending order so we stop at the first LOD which
+	// is too coarse
+	//
+	// LODs which aren't coarser than the current one are allowed up to the max
+	// pixel error but coarser LODs only up to (max pixel error * LOD_HYSTERESIS)
+	// so an instance near the threshold doesn't switch LODs back and forth
+
+	if (pixelsPerUnit_ <= 0.0f)
+		return 0;
+
+	const XMVECTOR scale = XMVectorMax(
+		XMVector3LengthSq(world.r[0]),
+		XMVectorMax(XMVector3LengthSq(world.r[1]), XMVector3LengthSq(world.r[2])));
+
+	const float maxScale = sqrtf(XMVectorGetX(scale));
+
+	const XMVECTOR center   = XMVector3TransformCoord(XMLoadFloat3(&aabb.Center), world);
+	const float    radius   = XMVectorGetX(XMVector3Length(XMLoadFloat3(&aabb.Extents))) * maxScale;
+	const float    distance = XMVectorGetX(XMVector3Length(center - XMLoadFloat3(&cameraPos_))) - radius;
+
+	// how many pixels the error of 1 unit of the mesh space takes
+	const float pixelsPerMeshUnit = maxScale * pixelsPerUnit_ / std::max(distance, MIN_DISTANCE);
+
+	uint8_t selected = 0;
+
+	for (size_t lodIdx = 0; lodIdx < lods.size(); ++lodIdx)
+	{
+		const uint8_t lod = (uint8_t)(lodIdx + 1);
+		const float maxError = (lod > currentLod) ? maxPixelError_ * LOD_HYSTERESIS : maxPixelError_;
+
+		if (lods[lodIdx].error * pixelsPerMeshUnit > maxError)
+			break;
+
+		selected = lod;
+	}
+
+	return selected;
+}
+
+///////////////////////////////////////////////////////////
+
+void LodSelector::GroupInstances(
+	const std::vector<u32>& visibleInstances,
+	const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh,
+	const std::vector<uint8_t>& lods,
+	const Mesh::DataForRendering& meshesData,
+	std::vector<u32>& outOrder,
+	std::vector<u32>& outRenderIdxs,
+	std::vector<ptrdiff_t>& outNumInstancesPerGroup,
+	Mesh::DataForRendering& outGroupsData)
+{
+	// visible instances of each mesh are already together so we only have to sort them
+	// by LODs inside the range of the mesh; so the range of each mesh in the rendering
+	// order is the same as its range in the arr of visible instances
+
+	const size_t visibleCount = visibleInstances.size();
+
+	// instances which were visible before now can be invisible
+	if (outRenderIdxs.size() != lods.size())
+	{
+		outRenderIdxs.assign(lods.size(), INVALID_RENDER_IDX);
+	}
+	else
+	{
+		for (const u32 instanceIdx : outOrder)
+			outRenderIdxs[instanceIdx] = INVALID_RENDER_IDX;
+	}
+
+	outOrder.resize(visibleCount);
+	outNumInstancesPerGroup.clear();
+	outGroupsData.Clear();
+	outGroupsData.Reserve((u32)numVisibleInstancesPerMesh.size());
+
+	std::vector<u32> lodsCounts;
+	size_t visibleBegin = 0;
+
+	for (u32 meshIdx = 0; meshIdx < (u32)numVisibleInstancesPerMesh.size(); ++meshIdx)
+	{
+		const size_t visibleEnd = visibleBegin + (size_t)numVisibleInstancesPerMesh[meshIdx];
+
+		GroupMeshInstances(
+			meshIdx,
+			visibleBegin,
+			visibleEnd,
+			visibleInstances,
+			lods,
+			meshesData,
+			lodsCounts,
+			outOrder,
+			outRenderIdxs,
+			outNumInstancesPerGroup,
+			outGroupsData);
+
+		visibleBegin = visibleEnd;
+	}
+
+	Assert::True(visibleBegin == visibleCount, "the number of visible instances is wrong");
+}
+
+///////////////////////////////////////////////////////////
+
+void LodSelector::RegroupInstances(
+	const std::vector<u32>& changedMeshes,
+	const std::vector<u32>& visibleInstances,
+	const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh,
+	const std::vector<uint8_t>& lods,
+	const Mesh::DataForRendering& meshesData,
+	std::vector<u32>& inOutOrder,
+	std::vector<u32>& inOutRenderIdxs,
+	std::vector<ptrdiff_t>& inOutNumInstancesPerGroup,
+	Mesh::DataForRendering& inOutGroupsData)
+{
+	// groups are rebuilt for all the meshes (it is cheap since it's made per group)
+	// but instances are sorted again only in ranges of meshes with changed LODs;
+	// LODs of instances of other meshes aren't changed so the LOD of their old
+	// group is the LOD of its first instance
+
+	Assert::True(inOutOrder.size() == visibleInstances.size(), "visible instances are changed since the last grouping");
+
+	std::vector<ptrdiff_t> oldNumInstancesPerGroup;
+	std::swap(oldNumInstancesPerGroup, inOutNumInstancesPerGroup);
+
+	inOutGroupsData.Clear();
+	inOutGroupsData.Reserve((u32)numVisibleInstancesPerMesh.size());
+
+	std::vector<u32> lodsCounts;
+	size_t visibleBegin = 0;
+	size_t oldGroupIdx = 0;
+	size_t changedIdx = 0;
+
+	for (u32 meshIdx = 0; meshIdx < (u32)numVisibleInstancesPerMesh.size(); ++meshIdx)
+	{
+		const size_t visibleEnd = visibleBegin + (size_t)numVisibleInstancesPerMesh[meshIdx];
+		const bool isChanged = (changedIdx < changedMeshes.size()) && (changedMeshes[changedIdx] == meshIdx);
+
+		if (isChanged)
+		{
+			GroupMeshInstances(
+				meshIdx,
+				visibleBegin,
+				visibleEnd,
+				visibleInstances,
+				lods,
+				meshesData,
+				lodsCounts,
+				inOutOrder,
+				inOutRenderIdxs,
+				inOutNumInstancesPerGroup,
+				inOutGroupsData);
+
+			++changedIdx;
+		}
+
+		// go through old groups of the mesh
+		for (size_t renderIdx = visibleBegin; renderIdx < visibleEnd; ++oldGroupIdx)
+		{
+			Assert::True(oldGroupIdx < oldNumInstancesPerGroup.size(), "groups don't match visible instances");
+			const ptrdiff_t count = oldNumInstancesPerGroup[oldGroupIdx];
+
+			if (!isChanged)
+				AddGroup(meshIdx, lods[inOutOrder[renderIdx]], count, meshesData, inOutNumInstancesPerGroup, inOutGroupsData);
+
+			renderIdx += (size_t)count;
+		}
+
+		visibleBegin = visibleEnd;
+	}
+
+	Assert::True(visibleBegin == visibleInstances.size(), "the number of visible instances is wrong");
+	Assert::True(changedIdx == changedMeshes.size(), "idxs of changed meshes are wrong");
+}
+
+///////////////////////////////////////////////////////////
+
+void LodSelector::GroupMeshInstances(
+	const u32 meshIdx,
+	const size_t visibleBegin,
+	const size_t visibleEnd,
+	const std::vector<u32>& visibleInstances,
+	const std::vector<uint8_t>& lods,
+	const Mesh::DataForRendering& meshesData,
+	std::vector<u32>& lodsCounts,
+	std::vector<u32>& outOrder,
+	std::vector<u32>& outRenderIdxs,
+	std::vector<ptrdiff_t>& outNumInstancesPerGroup,
+	Mesh::DataForRendering& outGroupsData)
+{
+	// sort visible instances of the mesh by LODs (one pass per LOD since the number
+	// of LODs is small); instances with the same LOD keep their order
+
+	const size_t lodsCount = meshesData.lods_[meshIdx].size();
+	u32 renderIdx = (u32)visibleBegin;
+
+	lodsCounts.assign(lodsCount + 1, 0);
+
+	for (size_t i = visibleBegin; i < visibleEnd; ++i)
+	{
+		Assert::True(lods[visibleInstances[i]] <= lodsCount, "the mesh has no such LOD");
+		++lodsCounts[lods[visibleInstances[i]]];
+	}
+
+	for (u32 lod = 0; lod < (u32)lodsCounts.size(); ++lod)
+	{
+		if (lodsCounts[lod] == 0)
+			continue;
+
+		for (size_t i = visibleBegin; i < visibleEnd; ++i)
+		{
+			const u32 instanceIdx = visibleInstances[i];
+
+			if (lods[instanceIdx] != lod)
+				continue;
+
+			outOrder[renderIdx]        = instanceIdx;
+			outRenderIdxs[instanceIdx] = renderIdx;
+			++renderIdx;
+		}
+
+		AddGroup(meshIdx, lod, lodsCounts[lod], meshesData, outNumInstancesPerGroup, outGroupsData);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void LodSelector::AddGroup(
+	const u32 meshIdx,
+	const u32 lod,
+	const ptrdiff_t instancesCount,
+	const Mesh::DataForRendering& meshesData,
+	std::vector<ptrdiff_t>& outNumInstancesPerGroup,
+	Mesh::DataForRendering& outGroupsData)
+{
+	// the group is rendered as a separate mesh which uses the same vertex
+	// buffer, textures and material but another index buffer
+
+	const std::vector<Mesh::DataForRendering::LodData>& meshLods = meshesData.lods_[meshIdx];
+
+	outNumInstancesPerGroup.push_back(instancesCount);
+
+	outGroupsData.names_.push_back(meshesData.names_[meshIdx]);
+	outGroupsData.pVBs_.push_back(meshesData.pVBs_[meshIdx]);
+	outGroupsData.pIBs_.push_back((lod == 0) ? meshesData.pIBs_[meshIdx] : meshLods[lod - 1].pIB);
+	outGroupsData.indexCount_.push_back((lod == 0) ? meshesData.indexCount_[meshIdx] : meshLods[lod - 1].indexCount);
+	outGroupsData.boundBoxes_.push_back(meshesData.boundBoxes_[meshIdx]);
+	outGroupsData.materials_.push_back(meshesData.materials_[meshIdx]);
+	outGroupsData.texIDs_.push_back(meshesData.texIDs_[meshIdx]);
+	outGroupsData.lods_.emplace_back();
+}
@@ -0,0 +1,113 @@
+// *********************************************************************************
+// Filename:      LodSelector.h
+// Description:   selection of LODs of meshes for each instance by the distance
+//                to the camera;
+//
+//                a LOD is chosen when its geometric error projected onto the screen
+//                (in pixels) isn't greater than the max pixel error (with hysteresis
+//                so instances near the threshold don't flip LODs); after that
+//                instances of each mesh are grouped by their LODs so each group is
+//                rendered as a separate mesh (with the LOD index buffer)
+//
+// Created:       17.10.26
+// *********************************************************************************
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+
+#include "../GameObjects/MeshHelperTypes.h"
+#include "../Common/Types.h"
+
+
+class LodSelector final
+{
+public:
+	static constexpr float DEFAULT_MAX_PIXEL_ERROR = 1.0f;
+	static constexpr float LOD_HYSTERESIS          = 0.8f;           // a coarser LOD is taken only if its error <= max pixel error * LOD_HYSTERESIS
+	static constexpr u32   INVALID_RENDER_IDX      = UINT32_MAX;     // a rendering idx of invisible instances
+
+public:
+	// projScaleY:     the element [1][1] of the projection matrix (1 / tan(fovY/2))
+	// viewportHeight: in pixels (if 0 only LOD 0 is selected)
+	void SetCamera(
+		const DirectX::XMFLOAT3& cameraPos,
+		const float projScaleY,
+		const float viewportHeight);
+
+	inline void  SetMaxPixelError(const float error) { maxPixelError_ = error; }
+	inline float GetMaxPixelError() const            { return maxPixelError_; }
+
+	// select a LOD for each visible instance (instances are sorted by meshes);
+	// LODs of invisible instances aren't changed;
+	// return: true if a LOD of some visible instance is changed
+	bool SelectLODs(
+		const std::vector<DirectX::XMMATRIX>& worlds,          // worlds of all the instances
+		const std::vector<u32>& visibleInstances,              // idxs of visible instances in ascending order
+		const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh,
+		const Mesh::DataForRendering& meshesData,
+		std::vector<uint8_t>& inOutLods,                       // LOD of each instance
+		std::vector<u32>& outChangedMeshes) const;             // idxs of meshes which have visible instances with changed LODs
+
+	// select a LOD of a single instance by its distance to the camera;
+	// the current LOD is kept while its error <= max pixel error
+	uint8_t SelectLOD(
+		const DirectX::XMMATRIX& world,
+		const DirectX::BoundingBox& aabb,
+		const std::vector<Mesh::DataForRendering::LodData>& lods,
+		const uint8_t currentLod) const;
+
+	// group visible instances of each mesh by their LODs; each group is added into the output
+	// meshes data as a separate mesh with the LOD index buffer (empty groups are skipped)
+	static void GroupInstances(
+		const std::vector<u32>& visibleInstances,           // idxs of visible instances in ascending order
+		const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh,
+		const std::vector<uint8_t>& lods,                   // LOD of each instance
+		const Mesh::DataForRendering& meshesData,
+		std::vector<u32>& outOrder,                         // idx of instance by its rendering idx
+		std::vector<u32>& outRenderIdxs,                    // rendering idx by idx of instance (INVALID_RENDER_IDX if invisible)
+		std::vector<ptrdiff_t>& outNumInstancesPerGroup,
+		Mesh::DataForRendering& outGroupsData);
+
+	// group again visible instances only of meshes with changed LODs (the visible
+	// instances are the same as for the previous grouping so the range of each mesh
+	// in the rendering order isn't changed); groups of other meshes are kept
+	static void RegroupInstances(
+		const std::vector<u32>& changedMeshes,              // idxs of meshes in ascending order
+		const std::vector<u32>& visibleInstances,
+		const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh,
+		const std::vector<uint8_t>& lods,
+		const Mesh::DataForRendering& meshesData,
+		std::vector<u32>& inOutOrder,
+		std::vector<u32>& inOutRenderIdxs,
+		std::vector<ptrdiff_t>& inOutNumInstancesPerGroup,
+		Mesh::DataForRendering& inOutGroupsData);
+
+private:
+	static void GroupMeshInstances(
+		const u32 meshIdx,
+		const size_t visibleBegin,
+		const size_t visibleEnd,
+		const std::vector<u32>& visibleInstances,
+		const std::vector<uint8_t>& lods,
+		const Mesh::DataForRendering& meshesData,
+		std::vector<u32>& lodsCounts,
+		std::vector<u32>& outOrder,
+		std::vector<u32>& outRenderIdxs,
+		std::vector<ptrdiff_t>& outNumInstancesPerGroup,
+		Mesh::DataForRendering& outGroupsData);
+
+	static void AddGroup(
+		const u32 meshIdx,
+		const u32 lod,
+		const ptrdiff_t instancesCount,
+		const Mesh::DataForRendering& meshesData,
+		std::vector<ptrdiff_t>& outNumInstancesPerGroup,
+		Mesh::DataForRendering& outGroupsData);
+
+private:
+	DirectX::XMFLOAT3 cameraPos_{ 0, 0, 0 };
+	float             pixelsPerUnit_ = 0.0f;             // pixels per world unit at the distance 1 (projScaleY * viewportHeight / 2)
+	float             maxPixelError_ = DEFAULT_MAX_PIXEL_ERROR;
+};
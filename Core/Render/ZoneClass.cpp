@@ -6,6 +6,8 @@
 ////////////////////////////////////////////////////////////////////////////////////////////
 #include "ZoneClass.h"
 
+#include <filesystem>
+
 
 //////////////////////////////////
 // INCLUDES FOR INTERNAL NEEDS
@@ -65,6 +67,146 @@ bool ZoneClass::Initialize(
 
 ///////////////////////////////////////////////////////////
 
+void ZoneClass::InitializeTerrainLOD(
+	ID3D11Device* pDevice,
+	const u32 chunkSize,
+	const float lodDistance)
+{
+	// the vertex buffer of the terrain grid mesh is used as is (one vertex per
+	// height sample, row by row) so here we only build indices of chunks LODs
+
+	terrainLOD_.Initialize(heightField_, chunkSize, lodDistance);
+	terrainLodIB_.Initialize(pDevice, terrainLOD_.GetIndices());
+}
+
+///////////////////////////////////////////////////////////
+
+void ZoneClass::PrepareTerrainChunks(
+	const DirectX::XMFLOAT3& cameraPos,
+	const DirectX::BoundingFrustum& frustum,
+	ID3D11Buffer* pTerrainVB,
+	Render::Render::ChunksDataToRender& outChunksData)
+{
+	// LODs are selected for all the chunks (so edges of visible chunks are
+	// stitched with their neighbours) but only visible chunks are rendered
+
+	outChunksData.Clear();
+
+	if (terrainLOD_.GetChunksCount() == 0)
+		return;
+
+	terrainLOD_.SelectLODs(cameraPos);
+
+	const std::vector<TerrainLOD::DrawCall>& drawCalls = terrainLOD_.GetDrawCalls();
+	const std::vector<DirectX::BoundingBox>& chunksAABBs = terrainLOD_.GetChunksAABBs();
+
+	for (size idx = 0; idx < std::ssize(drawCalls); ++idx)
+	{
+		if (!frustum.Intersects(chunksAABBs[idx]))
+			continue;
+
+		outChunksData.ptrsVB.push_back(pTerrainVB);
+		outChunksData.startIndices.push_back(drawCalls[idx].startIndex);
+		outChunksData.indexCounts.push_back(drawCalls[idx].indexCount);
+		outChunksData.baseVertices.push_back(drawCalls[idx].baseVertex);
+	}
+
+	outChunksData.pIB = terrainLodIB_.Get();
+	outChunksData.vertexSize = sizeof(Vertex3D);
+}
+
+///////////////////////////////////////////////////////////
+
+void ZoneClass::InitializeTerrainStreaming(
+	ID3D11Device* pDevice,
+	const std::string& heightmapFilename,
+	const std::string& tilesFilename,
+	const u32 tileSize,
+	const float cellSize,
+	const float heightScale,
+	const float loadRadius,
+	const size_t memoryBudget,
+	const DirectX::XMFLOAT3& cameraPos)
+{
+	// if the streaming can't be initialized the terrain grid is rendered instead
+
+	try
+	{
+		// the heightmap is converted only once and the tiles file is kept on the disk
+		if (!std::filesystem::exists(tilesFilename))
+		{
+			TerrainTilesFile::ConvertHeightmap(
+				heightmapFilename,
+				TerrainTilesFile::HEIGHTMAP_BMP,
+				0, 0,                        // dimensions are taken from the BMP file
+				tileSize,
+				cellSize,
+				heightScale,
+				tilesFilename);
+		}
+
+		terrainStreamer_.Initialize(tilesFilename, loadRadius, memoryBudget);
+
+		const u32 tilesCount = terrainStreamer_.GetTilesCount();
+
+		tilesVBs_.clear();
+		tilesVBs_.resize(tilesCount);
+		tilesAABBs_.resize(tilesCount);
+		tilesIB_.Initialize(pDevice, terrainStreamer_.GetTileIndices());
+
+		// only tiles near the camera are loaded before the first frame
+		terrainStreamer_.LoadAround(cameraPos);
+		UpdateTilesBuffers(pDevice);
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("can't initialize streaming of the terrain: " + tilesFilename);
+
+		terrainStreamer_.Shutdown();
+		tilesVBs_.clear();
+		tilesAABBs_.clear();
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void ZoneClass::UpdateTerrainStreaming(ID3D11Device* pDevice, const DirectX::XMFLOAT3& cameraPos)
+{
+	if (!IsTerrainStreamed())
+		return;
+
+	terrainStreamer_.Update(cameraPos);
+	UpdateTilesBuffers(pDevice);
+}
+
+///////////////////////////////////////////////////////////
+
+void ZoneClass::PrepareTerrainTiles(
+	const DirectX::BoundingFrustum& frustum,
+	Render::Render::ChunksDataToRender& outChunksData)
+{
+	// all the tiles have the same topology so they share the index buffer
+
+	outChunksData.Clear();
+
+	for (size idx = 0; idx < std::ssize(tilesVBs_); ++idx)
+	{
+		if (!tilesVBs_[idx] || !frustum.Intersects(tilesAABBs_[idx]))
+			continue;
+
+		outChunksData.ptrsVB.push_back(tilesVBs_[idx]->Get());
+		outChunksData.startIndices.push_back(0);
+		outChunksData.indexCounts.push_back(tilesIB_.GetIndexCount());
+		outChunksData.baseVertices.push_back(0);
+	}
+
+	outChunksData.pIB = tilesIB_.Get();
+	outChunksData.vertexSize = sizeof(Vertex3D);
+}
+
+///////////////////////////////////////////////////////////
+
 bool ZoneClass::Render(D3DClass* pD3D,
 	CameraClass & editorCamera,
 	const float deltaTime,
@@ -121,6 +263,8 @@ void ZoneClass::HandleMovementInput(
 	// handle keyboard input to control the zone state (state of the camera, terrain, etc.)
 	HandleZoneControlInput(kbe);
 
+	LockCameraToTerrainHeight(editorCamera);
+
 	return;
 }
 
@@ -191,6 +335,58 @@ void ZoneClass::HandleZoneControlInput(const KeyboardEvent& kbe)
 
 	return;
 }
+
+///////////////////////////////////////////////////////////
+
+void ZoneClass::LockCameraToTerrainHeight(EditorCamera& editorCamera)
+{
+	// the camera's position is just above the terrain's triangle by some height value;
+	// the height is taken directly from the height-field (no search through the terrain cells)
+	// or from the resident tiles if the terrain is streamed
+
+	if (!heightLocked_)
+		return;
+
+	DirectX::XMFLOAT3 pos;
+	float height = 0.0f;
+
+	editorCamera.GetPositionFloat3(pos);
+
+	const bool isOnTerrain = (IsTerrainStreamed()) ?
+		terrainStreamer_.GetHeightAtPosition(pos.x, pos.z, height) :
+		heightField_.IsInitialized() && heightField_.GetHeightAtPosition(pos.x, pos.z, height);
+
+	// the camera is off the terrain (or the tile under it isn't loaded yet)
+	if (!isOnTerrain)
+		return;
+
+	editorCamera.SetPosition(DirectX::XMVectorSet(pos.x, height + cameraHeightOffset_, pos.z, 1.0f));
+}
+
+///////////////////////////////////////////////////////////
+
+void ZoneClass::UpdateTilesBuffers(ID3D11Device* pDevice)
+{
+	// a tile can be loaded and evicted during the same update
+	// so just loaded tiles are handled first
+
+	for (const u32 idx : terrainStreamer_.GetLoadedTiles())
+	{
+		const std::vector<Vertex3D>& vertices = terrainStreamer_.GetTile(idx)->vertices;
+
+		tilesVBs_[idx] = std::make_unique<VertexBuffer<Vertex3D>>(pDevice, vertices, false);
+
+		DirectX::BoundingBox::CreateFromPoints(
+			tilesAABBs_[idx],
+			vertices.size(),
+			&vertices[0].position,
+			sizeof(Vertex3D));
+	}
+
+	for (const u32 idx : terrainStreamer_.GetEvictedTiles())
+		tilesVBs_[idx].reset();
+}
+
 #if 0
 ///////////////////////////////////////////////////////////
 
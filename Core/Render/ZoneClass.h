@@ -24,6 +24,16 @@
 #include "../Camera/EditorCamera.h"
 #include "../Render/frustumclass.h"
 
+// terrain
+#include "../GameObjects/TerrainHeightField.h"
+#include "../GameObjects/TerrainLOD.h"
+#include "../GameObjects/TerrainStreamer.h"
+#include "../GameObjects/IndexBuffer.h"
+#include "../GameObjects/VertexBuffer.h"
+
+// render stuff
+#include "Render.h"
+
 
 
 
@@ -42,6 +52,42 @@ public:
 		const float farZ,                   // screen depth
 		const float cameraHeightOffset);    // the offset of the camera above the terrain
 
+	// split the terrain grid into chunks and create an index buffer with indices
+	// of all the chunks LODs (heights are taken from the terrain height-field)
+	void InitializeTerrainLOD(
+		ID3D11Device* pDevice,
+		const u32 chunkSize,                // number of quads by each side of a chunk
+		const float lodDistance);           // chunks closer than this distance are rendered with LOD 0
+
+	// select LODs of the terrain chunks and prepare draw calls of chunks
+	// which are within the frustum (the camera and frustum are in the terrain's space)
+	void PrepareTerrainChunks(
+		const DirectX::XMFLOAT3& cameraPos,
+		const DirectX::BoundingFrustum& frustum,
+		ID3D11Buffer* pTerrainVB,           // the vertex buffer of the terrain grid mesh
+		Render::Render::ChunksDataToRender& outChunksData);
+
+	// open the tiles file of a big terrain (it is converted from the BMP heightmap
+	// if there is no such file yet) and synchronously load tiles around the camera
+	void InitializeTerrainStreaming(
+		ID3D11Device* pDevice,
+		const std::string& heightmapFilename,
+		const std::string& tilesFilename,
+		const u32 tileSize,                 // number of quads by each side of a tile
+		const float cellSize,
+		const float heightScale,
+		const float loadRadius,
+		const size_t memoryBudget,          // max number of bytes for resident tiles
+		const DirectX::XMFLOAT3& cameraPos);
+
+	// load/evict tiles around the camera and create/release their vertex buffers
+	void UpdateTerrainStreaming(ID3D11Device* pDevice, const DirectX::XMFLOAT3& cameraPos);
+
+	// prepare draw calls of resident tiles which are within the frustum
+	void PrepareTerrainTiles(
+		const DirectX::BoundingFrustum& frustum,
+		Render::Render::ChunksDataToRender& outChunksData);
+
 	bool Render(D3DClass* pD3D, 
 		CameraClass & editorCamera,
 		const float deltaTime, 
@@ -58,6 +104,10 @@ public:
 		const MouseEvent & me,
 		const float deltaTime);
 
+	inline TerrainHeightField& GetTerrainHeightField()              { return heightField_; }
+	inline bool IsTerrainStreamed()                           const { return terrainStreamer_.GetTilesCount() > 0; }
+	inline void SetCameraHeightOffset(const float offset)           { cameraHeightOffset_ = offset; }
+
 private:  // restrict a copying of this class instance
 	ZoneClass(const ZoneClass & obj);
 	ZoneClass & operator=(const ZoneClass & obj);
@@ -66,6 +116,12 @@ private:
 	// handle keyboard input to control the zone state (state of the camera, terrain, etc.)
 	void HandleZoneControlInput(const KeyboardEvent& kbe);   
 
+	// put the camera on the terrain (if the height is locked)
+	void LockCameraToTerrainHeight(EditorCamera& editorCamera);
+
+	// create vertex buffers of just loaded tiles and release buffers of evicted ones
+	void UpdateTilesBuffers(ID3D11Device* pDevice);
+
 	// there are main parts of the zone: sky, terrain, etc.
 	void RenderSkyElements(D3DClass* pD3D);
 
@@ -79,6 +135,14 @@ private:
 
 private:
 	FrustumClass          editorFrustum_;
+	TerrainHeightField    heightField_;                    // heights of the terrain grid for fast height queries
+	TerrainLOD            terrainLOD_;                     // chunks of the terrain grid and their LODs
+	IndexBuffer           terrainLodIB_;                   // indices of all the LODs of chunks (see TerrainLOD)
+
+	TerrainStreamer       terrainStreamer_;                // pages tiles of a big terrain in/out around the camera
+	IndexBuffer           tilesIB_;                        // indices which are shared by all the tiles
+	std::vector<std::unique_ptr<VertexBuffer<Vertex3D>>> tilesVBs_;   // vertex buffer of each resident tile (or nullptr)
+	std::vector<DirectX::BoundingBox>                    tilesAABBs_;
 
 	float deltaTime_ = 0.0f;                               // time between frames
 	float cameraHeightOffset_ = 0.0f;                      // camera's height above the terrain
@@ -10,6 +10,7 @@
 #include "../Common/Utils.h"
 
 #include <random>
+#include <algorithm>
 
 
 using namespace DirectX;
@@ -22,6 +23,11 @@ GraphicsClass::GraphicsClass()
 	{	
 		// get a pointer to the engine settings class
 		pIntersectionWithGameObjects_ = new IntersectionWithGameObjects();             // execution of picking of some model
+
+		// rendering data of each render bucket is kept from frame to frame
+		render_.renderDataStorage_.Resize(ECS::RENDER_BUCKETS_COUNT);
+		meshesData_.resize(ECS::RENDER_BUCKETS_COUNT);
+		bucketsCache_.resize(ECS::RENDER_BUCKETS_COUNT);
 	}
 	catch (std::bad_alloc& e)
 	{
@@ -141,10 +147,20 @@ void GraphicsClass::UpdateScene(
 	const XMFLOAT3& cameraPos = sysState.editorCameraPos;
 	const XMFLOAT3& cameraDir = sysState.editorCameraDir;
 
+	// update the camera params which are used to select LODs of meshes
+	D3D11_VIEWPORT viewport{};
+	UINT viewportsCount = 1;
+
+	pDeviceContext_->RSGetViewports(&viewportsCount, &viewport);
+	lodSelector_.SetCamera(cameraPos, XMVectorGetY(projMatrix.r[1]), viewport.Height);
+
 	// reset render counters (do it before frustum culling)
 	sysState.visibleObjectsCount = 0;
 	sysState.visibleVerticesCount = 0;
 
+	// load/evict tiles of the streamed terrain around the camera
+	zone_.UpdateTerrainStreaming(pDevice_, cameraPos);
+
 	// update the entities and related data
 	entityMgr_.Update(totalGameTime, deltaTime);
 	entityMgr_.lightSystem_.UpdateSpotLights(cameraPos, cameraDir);
@@ -215,100 +231,23 @@ void GraphicsClass::RenderFrame(
 
 void GraphicsClass::ComputeFrustumCulling(SystemState& sysState)
 {
+	// define which renderable entities are visible by the editor camera
+	// (world AABBs of entities are tested against the frustum in the ECS)
 
 	const bool frustumCullingEnabled = true;
 	
 	ECS::EntityManager& mgr = entityMgr_;
 
-	sysState.visibleObjectsCount = 0;
-	mgr.renderSystem_.ClearVisibleEntts();
-
-	// temp
-	//mgr.renderSystem_.SetVisibleEntts(mgr.ids_);
-
-#if 1
-	//std::vector<EntityID> allIDs = mgr.ids_;
-	
-
 	if (frustumCullingEnabled)
 	{
-		const std::vector<EntityID> enttsRenderable = mgr.renderSystem_.GetAllEnttsIDs();
-		const size renderEnttsCount = std::ssize(enttsRenderable);
-
-		XMVECTOR detView = XMMatrixDeterminant(editorCamera_.GetViewMatrix());
-		XMMATRIX invView = XMMatrixInverse(&detView, editorCamera_.GetViewMatrix());
-
-		// get world matrix of each entity which is set as renderable
-		std::vector<XMMATRIX> worlds;
-		mgr.transformSystem_.GetWorldMatricesOfEntts(enttsRenderable, worlds);
-
-		std::vector<XMMATRIX> invWorlds;
-		std::vector<XMMATRIX> enttsLocal;
-
-		invWorlds.reserve(renderEnttsCount);
-		enttsLocal.reserve(renderEnttsCount);
-
-		// precompute world inverse matrices for each renderable entt
-		XMVECTOR detWorld;
-
-		for (size idx = 0; idx < renderEnttsCount; ++idx)
-			invWorlds.emplace_back(XMMatrixInverse(&detWorld, worlds[idx]));
-
-		// precompute local space matrices for each renderable entt
-		for (size idx = 0; idx < renderEnttsCount; ++idx)
-			enttsLocal.emplace_back(XMMatrixMultiply(invView, invWorlds[idx]));
-
-		// clear some arrs since we don't need already
-		worlds.clear();
-		invWorlds.clear();
-
-		// get arr of AABB / bounding spheres for each renderable entt
-		std::vector<DirectX::BoundingBox> AABBs;
-		mgr.boundingSystem_.GetBoundingDataByIDs(enttsRenderable, AABBs);
-
-
-		std::vector<EntityID> visibleEntts(std::ssize(enttsRenderable));
-		u32 visibleEnttsCount = 0;
-
-
-		// go through each entity and define if it is visible
-		for (ptrdiff_t idx = 0; idx < renderEnttsCount; ++idx)
-		{
-			// decompose the matrix into its individual parts
-			XMVECTOR scale;
-			XMVECTOR dirQuat;
-			XMVECTOR translation;
-			XMMatrixDecompose(&scale, &dirQuat, &translation, enttsLocal[idx]);
-
-			//EntityName name = mgr.nameSystem_.GetNameById(enttsRenderable[idx]);
-
-			// transform the camera frustum from view space to the object's local space
-			DirectX::BoundingFrustum localspaceFrustum;
-
-			frustums_[0].Transform(
-				localspaceFrustum,
-				XMVectorGetX(scale),
-				dirQuat,
-				translation);
-
-			DirectX::BoundingBox enttsBoundingBox;
-
-			EntityID enttID = enttsRenderable[idx];
-
-			
-			// perform the box/frustum intersection test in local space
-			if (localspaceFrustum.Intersects(AABBs[idx]))
-			{
-				visibleEntts[visibleEnttsCount++] = enttsRenderable[idx];
-			}
-		}
-
-		visibleEntts.resize(visibleEnttsCount);
-		mgr.renderSystem_.SetVisibleEntts(visibleEntts);
-		sysState.visibleObjectsCount = visibleEnttsCount;
+		mgr.ComputeFrustumCulling(viewProj_);
 	}
-#endif
-	
+	else
+	{
+		mgr.renderSystem_.SetVisibleEntts(mgr.renderSystem_.GetAllEnttsIDs());
+	}
+
+	sysState.visibleObjectsCount = (u32)mgr.renderSystem_.GetVisibleEnttsCount();
 }
 
 ///////////////////////////////////////////////////////////
@@ -545,9 +484,52 @@ void GraphicsClass::InitSceneHelper(InitializeGraphics& init, Settings& settings
 		meshStorage_,
 		settings,
 		renderToTexture_,
+		zone_.GetTerrainHeightField(),
 		pDevice_,
 		pDeviceContext_);
 	Assert::True(result, "can't initialize the scene elements (models, etc.)");
+
+	// the camera is put above the terrain by this offset when its height is locked (F4)
+	zone_.SetCameraHeightOffset(settings.GetFloat("CAMERA_HEIGHT_OFFSET"));
+
+	InitTerrainHelper(settings);
+}
+
+///////////////////////////////////////////////////////////
+
+void GraphicsClass::InitTerrainHelper(Settings& settings)
+{
+	// the terrain grid is rendered by chunks with LODs: the vertex buffer of
+	// the terrain mesh + indices of chunks LODs which are created by the zone
+
+	terrainCache_.enttID = entityMgr_.nameSystem_.GetIdByName("terrain");
+
+	if (terrainCache_.enttID == INVALID_ENTITY_ID)
+		return;
+
+	zone_.InitializeTerrainLOD(
+		pDevice_,
+		(u32)settings.GetInt("TERRAIN_CHUNK_SIZE"),
+		settings.GetFloat("TERRAIN_LOD_DISTANCE"));
+
+	// a big terrain is streamed by tiles around the camera (it is rendered
+	// instead of the terrain grid but with the same textures and material)
+	if (settings.GetBool("IS_STREAM_TERRAIN_TILES"))
+	{
+		XMFLOAT3 cameraPos;
+		editorCamera_.GetPositionFloat3(cameraPos);
+
+		zone_.InitializeTerrainStreaming(
+			pDevice_,
+			settings.GetString("TERRAIN_TILES_HEIGHTMAP"),
+			settings.GetString("TERRAIN_TILES_FILE"),
+			(u32)settings.GetInt("TERRAIN_TILE_SIZE"),
+			settings.GetFloat("TERRAIN_TILES_CELL_SIZE"),
+			settings.GetFloat("TERRAIN_TILES_HEIGHT_SCALE"),
+			settings.GetFloat("TERRAIN_TILES_LOAD_RADIUS"),
+			(size_t)settings.GetInt("TERRAIN_TILES_MEMORY_BUDGET_MB") << 20,
+			cameraPos);
+	}
 }
 
 ///////////////////////////////////////////////////////////
@@ -571,34 +553,27 @@ void GraphicsClass::UpdateShadersDataPerFrame()
 	perFrameData.viewProj = DirectX::XMMatrixTranspose(viewProj_);
 	editorCamera_.GetPositionFloat3(perFrameData.cameraPos);
 
+	// the shader takes a fixed arr of point lights so we only need to know
+	// which of them are visible (clusters of lights aren't uploaded)
+	GetVisiblePointLights(entityMgr_.lightSystem_.GetPointLights(), visiblePointLights_);
+
 	SetupLightsForFrame(
 		entityMgr_.lightSystem_,
+		visiblePointLights_,
+		perFrameData.cameraPos,
 		perFrameData.dirLights,
 		perFrameData.pointLights,
 		perFrameData.spotLights);
 
+	// all the changes of lights are already taken
+	entityMgr_.lightSystem_.ResetDirtyRanges();
+
 	// update lighting data, camera pos, etc. for this frame
 	render_.UpdatePerFrame(pDeviceContext_, perFrameData);
 }
 
 ///////////////////////////////////////////////////////////
 
-void GraphicsClass::ClearRenderingDataBeforeFrame()
-{
-	// clear rendering data from the previous frame / instances set
-
-	for (auto& it : meshesData_)
-	{
-		it.second.Clear();
-	}
-	
-	meshesData_.clear();
-	render_.renderDataStorage_.Clear();
-	rsDataToRender_.Clear();
-}
-
-///////////////////////////////////////////////////////////
-
 void GraphicsClass::Render3D()
 {
 	//
@@ -608,25 +583,18 @@ void GraphicsClass::Render3D()
 
 	try
 	{
-	ClearRenderingDataBeforeFrame();
-	
-
-	// prepare all the visible entities for rendering
-	const std::vector<EntityID>& visibleEntts = entityMgr_.renderSystem_.GetAllVisibleEntts();
-
-	// separate entts into opaque and blended
-	entityMgr_.renderStatesSystem_.GetRenderStates(visibleEntts, rsDataToRender_);
-
-	// prepare data for each entts set
-	PrepareEnttsDataForRendering(rsDataToRender_.enttsDefault_.ids_, "default_states");
-	PrepareEnttsDataForRendering(rsDataToRender_.enttsAlphaClipping_.ids_, "alpha_clip_cull_none");
-	PrepareEnttsDataForRendering(rsDataToRender_.enttsBlended_.ids_, "blending");
+	// prepare visible entities of each render bucket for rendering
+	// NOTE: instances data of render buckets isn't cleared since it is updated partially
+	PrepareEnttsDataForRendering(ECS::BUCKET_DEFAULT_STATES);
+	PrepareEnttsDataForRendering(ECS::BUCKET_ALPHA_CLIP_CULL_NONE);
+	PrepareEnttsDataForRendering(ECS::BUCKET_BLENDING);
 	//PrepareEnttsDataForRendering(rsDataToRender.enttsReflects_, "reflection_planes");
 
 	// render as usual
-	RenderEntts("default_states");
-	RenderEntts("alpha_clip_cull_none");
-	//RenderEntts("blending");
+	RenderEntts(ECS::BUCKET_DEFAULT_STATES);
+	RenderTerrain();
+	RenderEntts(ECS::BUCKET_ALPHA_CLIP_CULL_NONE);
+	//RenderEntts(ECS::BUCKET_BLENDING);
 
 #if 0
 	// render reflections of each entt
@@ -733,90 +701,280 @@ void GraphicsClass::Render3D()
 
 ///////////////////////////////////////////////////////////
 
-void GraphicsClass::PrepareEnttsDataForRendering(
-	const std::vector<EntityID>& enttsIds,
-	const std::string& enttsSetKey)
+void GraphicsClass::PrepareEnttsDataForRendering(const ECS::RenderBucketID bucketID)
 {
-	// if we haven't any entts to get we just go out
-	if (enttsIds.empty()) return;
-
+	// prepare instances data of the render bucket; the data is kept from frame to frame:
+	//
+	// 1. meshes data, materials and textures are gathered only for a new set of instances
+	//    of the bucket (after structural changes of the ECS) or when textures/materials
+	//    of meshes are changed;
+	// 2. if visible instances are changed we group visible instances and fill in
+	//    their data again (from the cache, without any searching);
+	// 3. if only LODs are changed we group again only instances of meshes with
+	//    changed LODs and copy data of these instances;
+	// 4. then we copy data of changed instances
+	//
+	// instances of each mesh are grouped by their LODs and each group is rendered
+	// as a separate mesh (the same vertex buffer but the LOD index buffer)
 
 	using InstanceBufferData = Render::Render::InstanceBufferData;
 	using InstancesDataToRender = Render::Render::InstancesDataToRender;
 
-	Render::Render::RenderDataStorage& storage = render_.renderDataStorage_;
-
-	storage.instanceBuffData_[enttsSetKey];
-	storage.perInstanceData_[enttsSetKey];
-	storage.keys_.insert(enttsSetKey);
-	meshesData_[enttsSetKey];
-
 	// 1. data is used to fill in the instance buffer of shaders
 	// 2. data per each set of instances (multiple instances but the same geometry, textures, etc)
 	// 3. meshes data for this set of instances
-	InstanceBufferData& instanceBuffData = render_.renderDataStorage_.instanceBuffData_.at(enttsSetKey);
-	InstancesDataToRender& perInstanceData = render_.renderDataStorage_.perInstanceData_.at(enttsSetKey);
-	Mesh::DataForRendering& meshesData = meshesData_.at(enttsSetKey);
+	InstanceBufferData& instanceBuffData = render_.renderDataStorage_.instanceBuffData_[bucketID];
+	InstancesDataToRender& perInstanceData = render_.renderDataStorage_.perInstanceData_[bucketID];
+	Mesh::DataForRendering& meshesData = meshesData_[bucketID];
+	BucketRenderCache& cache = bucketsCache_[bucketID];
 
-	ECS::EntityManager& enttMgr = entityMgr_;
-	std::vector<MeshID> meshesIDsToRender;
-	std::vector<EntityID> enttsSortedByMeshes;
+	const ECS::InstancesBucket& bucket = entityMgr_.UpdateInstancesBucket(bucketID);
+	const u32 texAndMaterialsVersion = MeshStorage::Get()->GetTexAndMaterialsVersion();
 
-	// --------------------------------------------
+	const bool isBucketChanged     = (bucket.version_ != cache.bucketVersion);
+	const bool isMeshesDataChanged = isBucketChanged || (texAndMaterialsVersion != cache.texAndMaterialsVersion);
+	const bool isVisibilityChanged = (bucket.visibilityVersion_ != cache.visibilityVersion);
 
-	enttMgr.meshSystem_.GetMeshesIDsRelatedToEntts(
-		enttsIds,
-		meshesIDsToRender,     // arr of meshes IDs which will be rendered
-		enttsSortedByMeshes,
-		perInstanceData.numInstancesPerMesh);
+	// instances of the old set aren't rendered anymore
+	if (isBucketChanged)
+	{
+		cache.lods.clear();
+		cache.order.clear();
+		cache.renderIdxs.clear();
+	}
 
-	// prepare meshes data for rendering
-	MeshStorage::Get()->GetMeshesDataForRendering(meshesIDsToRender, meshesData);
+	if (isMeshesDataChanged)
+		PrepareBucketMeshesData(bucket, cache);
 
-	// --------------------------------------------
+	const bool isLodChanged = lodSelector_.SelectLODs(
+		bucket.worlds_,
+		bucket.visibleInstances_,
+		bucket.numVisibleInstancesPerMesh_,
+		cache.meshesData,
+		cache.lods,
+		cache.lodChangedMeshes);
+
+	cache.bucketVersion          = bucket.version_;
+	cache.visibilityVersion      = bucket.visibilityVersion_;
+	cache.texAndMaterialsVersion = texAndMaterialsVersion;
 
-	enttMgr.transformSystem_.GetWorldMatricesOfEntts(enttsSortedByMeshes, instanceBuffData.worlds);
-	enttMgr.texTransformSystem_.GetTexTransformsForEntts(enttsSortedByMeshes, instanceBuffData.texTransforms);
+	// group visible instances of each mesh by LODs and prepare meshes data for rendering
+	if (isMeshesDataChanged || isVisibilityChanged)
+	{
+		perInstanceData.Clear();
+
+		LodSelector::GroupInstances(
+			bucket.visibleInstances_,
+			bucket.numVisibleInstancesPerMesh_,
+			cache.lods,
+			cache.meshesData,
+			cache.order,
+			cache.renderIdxs,
+			perInstanceData.numInstancesPerMesh,
+			meshesData);
+
+		FillInstancesDataForRendering(bucket, cache, meshesData, instanceBuffData, perInstanceData);
+		return;
+	}
+
+	// visible instances are the same so only instances of meshes with changed LODs are moved
+	if (isLodChanged)
+	{
+		LodSelector::RegroupInstances(
+			cache.lodChangedMeshes,
+			bucket.visibleInstances_,
+			bucket.numVisibleInstancesPerMesh_,
+			cache.lods,
+			cache.meshesData,
+			cache.order,
+			cache.renderIdxs,
+			perInstanceData.numInstancesPerMesh,
+			meshesData);
+
+		UpdateRegroupedInstancesData(bucket, cache, instanceBuffData, perInstanceData);
+	}
+
+	// --------------------------------------------
 
-	// TEMPORARY: 
-	// prepare materials for each mesh instance (but not for each entt)
-	for (size idx = 0; idx < std::ssize(meshesData.materials_); ++idx)
+	// update data only of changed instances
+	for (const u32 idx : bucket.patchedInstances_)
 	{
-		const ptrdiff_t instanceCount = perInstanceData.numInstancesPerMesh[idx];
-		const Mesh::Material& mat = meshesData.materials_[idx];
+		const u32 renderIdx = cache.renderIdxs[idx];
+
+		// the instance isn't visible
+		if (renderIdx == LodSelector::INVALID_RENDER_IDX)
+			continue;
 
-		Render::Material meshMat(mat.ambient_, mat.diffuse_, mat.specular_, mat.reflect_);
-		CoreUtils::AppendArray(instanceBuffData.meshesMaterials, std::vector<Render::Material>(instanceCount, meshMat));
+		instanceBuffData.worlds[renderIdx] = bucket.worlds_[idx];
+		instanceBuffData.texTransforms[renderIdx] = bucket.texTransforms_[idx];
 	}
+}
 
-	// ------------------------------------------
+///////////////////////////////////////////////////////////
+
+void GraphicsClass::PrepareBucketMeshesData(
+	const ECS::InstancesBucket& bucket,
+	BucketRenderCache& cache)
+{
+	// gather data of meshes of the bucket (buffers, LODs, materials, textures)
+	// and define a textures set of each instance: instances use textures of
+	// their meshes if their entts don't have the Textured component (own textures)
+
+	Mesh::DataForRendering& meshesData = cache.meshesData;
+	const size meshesCount = std::ssize(bucket.meshesIDs_);
+	const size instancesCount = bucket.GetInstancesCount();
+
+	meshesData.Clear();
+	MeshStorage::Get()->GetMeshesDataForRendering(bucket.meshesIDs_, meshesData);
+
+	// textures sets: the set of each mesh and then own sets of instances
+	std::vector<EntityID> enttsWithOwnTex;
 
-	// prepare instances data for shaders
-	std::vector<EntityID> enttsTextured;     // ids of entts which have the Textured component
+	cache.texSRVs.clear();
 
-	// get SRV (shader resource view) of each texture of the mesh and
-	// entities which have the Textured component (own textures)
 	GetTexSRVsForEntts(
-		enttsSortedByMeshes,
+		bucket.instancesEntts_,
 		meshesData.texIDs_,
-		std::ssize(perInstanceData.numInstancesPerMesh),
-		perInstanceData.texturesSRVs,
-		enttsTextured);
+		meshesCount,
+		cache.texSRVs,
+		enttsWithOwnTex);
 
-	GenInstancesTexSetData(
-		enttsSortedByMeshes,
-		enttsTextured,
-		perInstanceData.numInstancesPerMesh,
-		perInstanceData.enttsMaterialTexIdxs,
-		perInstanceData.enttsPerTexSet,
-		perInstanceData.numOfTexSet);
+	// entts with own textures go in the same order as their instances
+	cache.texSetIdxs.resize(instancesCount);
+
+	for (size meshIdx = 0, i = 0, ownSetIdx = 0; meshIdx < meshesCount; ++meshIdx)
+	{
+		const size instancesEnd = i + bucket.numInstancesPerMesh_[meshIdx];
+
+		for (; i < instancesEnd; ++i)
+		{
+			const bool hasOwnTex =
+				(ownSetIdx < std::ssize(enttsWithOwnTex)) &&
+				(enttsWithOwnTex[ownSetIdx] == bucket.instancesEntts_[i]);
+
+			cache.texSetIdxs[i] = (hasOwnTex) ? (u32)(meshesCount + ownSetIdx++) : (u32)meshIdx;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void GraphicsClass::FillInstancesDataForRendering(
+	const ECS::InstancesBucket& bucket,
+	const BucketRenderCache& cache,
+	const Mesh::DataForRendering& groupsData,
+	Render::Render::InstanceBufferData& outInstanceBuffData,
+	Render::Render::InstancesDataToRender& outPerInstanceData)
+{
+	// fill in data of visible instances in the rendering order (is defined by grouping
+	// of instances by meshes and LODs); instances of each group are split into sets
+	// with the same textures so each set is rendered with a single draw call
+
+	const size visibleCount = std::ssize(cache.order);
+	const size groupsCount = std::ssize(outPerInstanceData.numInstancesPerMesh);
+
+	outInstanceBuffData.worlds.resize(visibleCount);
+	outInstanceBuffData.texTransforms.resize(visibleCount);
+	outInstanceBuffData.meshesMaterials.resize(visibleCount);
 
-	perInstanceData.vertexSize = sizeof(Vertex3D);
+	for (size groupIdx = 0, renderIdx = 0; groupIdx < groupsCount; ++groupIdx)
+	{
+		const size groupEnd = renderIdx + outPerInstanceData.numInstancesPerMesh[groupIdx];
+		const Mesh::Material& mat = groupsData.materials_[groupIdx];
+		const Render::Material groupMat(mat.ambient_, mat.diffuse_, mat.specular_, mat.reflect_);
+
+		for (; renderIdx < groupEnd; ++renderIdx)
+		{
+			const u32 idx = cache.order[renderIdx];
+
+			outInstanceBuffData.worlds[renderIdx] = bucket.worlds_[idx];
+			outInstanceBuffData.texTransforms[renderIdx] = bucket.texTransforms_[idx];
+			outInstanceBuffData.meshesMaterials[renderIdx] = groupMat;
+		}
+	}
+
+	FillTexSetsForRendering(cache, outPerInstanceData);
+
+	outPerInstanceData.texturesSRVs = cache.texSRVs;
+	outPerInstanceData.numOfTexSet  = (u32)(std::ssize(cache.texSRVs) / 2);
+	outPerInstanceData.vertexSize   = sizeof(Vertex3D);
 }
 
 ///////////////////////////////////////////////////////////
 
-void GraphicsClass::RenderEntts(const std::string& enttsSetKey)
+void GraphicsClass::UpdateRegroupedInstancesData(
+	const ECS::InstancesBucket& bucket,
+	const BucketRenderCache& cache,
+	Render::Render::InstanceBufferData& inOutInstanceBuffData,
+	Render::Render::InstancesDataToRender& inOutPerInstanceData)
+{
+	// instances were moved only inside the ranges of meshes with changed LODs
+	// (each range has the same material) so we copy data only of these ranges
+	// and split groups into textures sets again
+
+	const std::vector<ptrdiff_t>& numVisibleInstancesPerMesh = bucket.numVisibleInstancesPerMesh_;
+	size renderBegin = 0;
+
+	for (u32 meshIdx = 0, i = 0; i < (u32)cache.lodChangedMeshes.size(); ++meshIdx)
+	{
+		const size renderEnd = renderBegin + numVisibleInstancesPerMesh[meshIdx];
+
+		if (cache.lodChangedMeshes[i] == meshIdx)
+		{
+			for (size renderIdx = renderBegin; renderIdx < renderEnd; ++renderIdx)
+			{
+				const u32 idx = cache.order[renderIdx];
+
+				inOutInstanceBuffData.worlds[renderIdx] = bucket.worlds_[idx];
+				inOutInstanceBuffData.texTransforms[renderIdx] = bucket.texTransforms_[idx];
+			}
+
+			++i;
+		}
+
+		renderBegin = renderEnd;
+	}
+
+	inOutPerInstanceData.enttsMaterialTexIdxs.clear();
+	inOutPerInstanceData.enttsPerTexSet.clear();
+
+	FillTexSetsForRendering(cache, inOutPerInstanceData);
+}
+
+///////////////////////////////////////////////////////////
+
+void GraphicsClass::FillTexSetsForRendering(
+	const BucketRenderCache& cache,
+	Render::Render::InstancesDataToRender& outPerInstanceData)
+{
+	// split instances of each group into sets with the same textures
+	// (each set is rendered with a single draw call)
+
+	const std::vector<ptrdiff_t>& numInstancesPerGroup = outPerInstanceData.numInstancesPerMesh;
+
+	for (size groupIdx = 0, renderIdx = 0; groupIdx < std::ssize(numInstancesPerGroup); ++groupIdx)
+	{
+		const size groupEnd = renderIdx + numInstancesPerGroup[groupIdx];
+
+		for (u32 prevTexSet = UINT32_MAX; renderIdx < groupEnd; ++renderIdx)
+		{
+			const u32 texSet = cache.texSetIdxs[cache.order[renderIdx]];
+
+			if (texSet != prevTexSet)
+			{
+				outPerInstanceData.enttsMaterialTexIdxs.push_back(texSet);
+				outPerInstanceData.enttsPerTexSet.push_back(0);
+				prevTexSet = texSet;
+			}
+
+			++outPerInstanceData.enttsPerTexSet.back();
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void GraphicsClass::RenderEntts(const ECS::RenderBucketID bucketID)
 {
 	try
 	{
@@ -825,57 +983,139 @@ void GraphicsClass::RenderEntts(const std::string& enttsSetKey)
 		//
 
 		const Render::Render::RenderDataStorage& storage = render_.renderDataStorage_;
+		const Render::Render::InstanceBufferData& instanceBuffData = storage.instanceBuffData_[bucketID];
+		const Render::Render::InstancesDataToRender& perInstanceData = storage.perInstanceData_[bucketID];
 	
-		// if we haven't any entts to rendering by input key we just go out
-		bool haveEntts = storage.keys_.contains(enttsSetKey);
-		if (!haveEntts) return;
+		// if we haven't any entts to rendering by input bucket we just go out
+		if (instanceBuffData.worlds.empty()) return;
 
-#if 1
-		if (enttsSetKey == "default_states")
+		switch (bucketID)
 		{
+			case ECS::BUCKET_DEFAULT_STATES:
+			{
+				d3d_.GetRenderStates().ResetRS(pDeviceContext_);
+				d3d_.GetRenderStates().ResetBS(pDeviceContext_);
+				break;
+			}
+			case ECS::BUCKET_ALPHA_CLIP_CULL_NONE:
+			{
+				using enum RenderStates::STATES;
+				d3d_.GetRenderStates().SetRS(pDeviceContext_, { CULL_NONE });
+				render_.GetLightShader().SetAlphaClipping(pDeviceContext_, true);
+				break;
+			}
+			default:
+			{
+				// rendering of other buckets isn't implemented yet
+				return;
+			}
+		}
+
+		UpdateInstanceBuffAndRenderInstances(
+			pDeviceContext_,
+			instanceBuffData,
+			perInstanceData,
+			meshesData_[bucketID]);
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e);
+		Log::Error("can't render entts of the render bucket: " + std::to_string(bucketID));
+	}
+}
 
-			d3d_.GetRenderStates().ResetRS(pDeviceContext_);
-			d3d_.GetRenderStates().ResetBS(pDeviceContext_);
+///////////////////////////////////////////////////////////
 
+void GraphicsClass::PrepareTerrainMeshData()
+{
+	// gather buffers, material and textures of the terrain mesh
 
-			const Render::Render::InstanceBufferData instanceBuffData = storage.instanceBuffData_.at(enttsSetKey);
-			const Render::Render::InstancesDataToRender& perInstanceData = storage.perInstanceData_.at(enttsSetKey);
+	TerrainRenderCache& cache = terrainCache_;
+	const std::vector<EntityID> enttsIDs = { cache.enttID };
 
-			UpdateInstanceBuffAndRenderInstances(
-				pDeviceContext_,
-				instanceBuffData,
-				perInstanceData,
-				meshesData_.at(enttsSetKey));
-		}
-		else if (enttsSetKey == "alpha_clip_cull_none")
+	std::vector<MeshID> meshesIDs;
+	std::vector<EntityID> enttsSortedByMeshes;
+	std::vector<size> numInstancesPerMesh;
+
+	entityMgr_.meshSystem_.GetMeshesIDsRelatedToEntts(
+		enttsIDs,
+		meshesIDs,
+		enttsSortedByMeshes,
+		numInstancesPerMesh);
+
+	Assert::True(meshesIDs.size() == 1, "the terrain entity must have a single mesh");
+
+	cache.meshData.Clear();
+	MeshStorage::Get()->GetMeshesDataForRendering(meshesIDs, cache.meshData);
+
+	// textures of the mesh go first and then own textures of the entity (if it has)
+	std::vector<SRV*> texSRVs;
+	std::vector<EntityID> enttsWithOwnTex;
+
+	GetTexSRVsForEntts(enttsIDs, cache.meshData.texIDs_, 1, texSRVs, enttsWithOwnTex);
+
+	const size texSetIdx = (enttsWithOwnTex.empty()) ? 0 : 1;
+	cache.chunksData.texturesSRVs[0] = texSRVs[texSetIdx * 2];
+	cache.chunksData.texturesSRVs[1] = texSRVs[texSetIdx * 2 + 1];
+
+	const Mesh::Material& mat = cache.meshData.materials_[0];
+	cache.instanceData.meshesMaterials.assign(1, Render::Material(mat.ambient_, mat.diffuse_, mat.specular_, mat.reflect_));
+}
+
+///////////////////////////////////////////////////////////
+
+void GraphicsClass::RenderTerrain()
+{
+	// render the terrain grid by chunks: LODs of chunks are selected by
+	// the distance to the camera and only visible chunks are rendered;
+	// (if the terrain is streamed we render its resident tiles instead)
+
+	TerrainRenderCache& cache = terrainCache_;
+
+	if (cache.enttID == INVALID_ENTITY_ID)
+		return;
+
+	try
+	{
+		const u32 texAndMaterialsVersion = MeshStorage::Get()->GetTexAndMaterialsVersion();
+
+		if (texAndMaterialsVersion != cache.texAndMaterialsVersion)
 		{
-			using enum RenderStates::STATES;
-			d3d_.GetRenderStates().SetRS(pDeviceContext_, { CULL_NONE });
-			render_.GetLightShader().SetAlphaClipping(pDeviceContext_, true);
-
-			const Render::Render::InstanceBufferData instanceBuffData = storage.instanceBuffData_.at(enttsSetKey);
-			const Render::Render::InstancesDataToRender& perInstanceData = storage.perInstanceData_.at(enttsSetKey);
-
-			UpdateInstanceBuffAndRenderInstances(
-				pDeviceContext_,
-				instanceBuffData,
-				perInstanceData,
-				meshesData_.at(enttsSetKey));
+			PrepareTerrainMeshData();
+			cache.texAndMaterialsVersion = texAndMaterialsVersion;
 		}
-#endif
 
-		
-		
+		// chunks are in the terrain's space so the camera and frustum are transformed into it
+		const XMMATRIX world = entityMgr_.transformSystem_.GetWorldMatrixOfEntt(cache.enttID);
+		const XMMATRIX invWorld = XMMatrixInverse(nullptr, world);
 
+		XMFLOAT3 cameraPos;
+		BoundingFrustum frustum;
 
-		
-	
+		XMStoreFloat3(&cameraPos, XMVector3TransformCoord(editorCamera_.GetPosition(), invWorld));
+		frustums_[0].Transform(frustum, XMMatrixInverse(nullptr, world * editorCamera_.GetViewMatrix()));
+
+		if (zone_.IsTerrainStreamed())
+			zone_.PrepareTerrainTiles(frustum, cache.chunksData);
+		else
+			zone_.PrepareTerrainChunks(cameraPos, frustum, cache.meshData.pVBs_[0], cache.chunksData);
+
+		if (cache.chunksData.indexCounts.empty())
+			return;
 
+		cache.instanceData.worlds.assign(1, world);
+		entityMgr_.texTransformSystem_.GetTexTransformsForEntts({ cache.enttID }, cache.instanceData.texTransforms);
+
+		d3d_.GetRenderStates().ResetRS(pDeviceContext_);
+		d3d_.GetRenderStates().ResetBS(pDeviceContext_);
+
+		render_.UpdateInstancedBuffer(pDeviceContext_, cache.instanceData);
+		render_.RenderChunks(pDeviceContext_, cache.chunksData);
 	}
 	catch (EngineException& e)
 	{
 		Log::Error(e);
-		Log::Error("can't render entts by key: " + enttsSetKey);
+		Log::Error("can't render the terrain");
 	}
 }
 
@@ -1052,23 +1292,85 @@ void GraphicsClass::RenderEnttsShadows(
 
 ///////////////////////////////////////////////////////////
 
+void GraphicsClass::GetVisiblePointLights(
+	const ECS::PointLights& pointLights,
+	std::vector<u32>& outLightsIdxs) const
+{
+	// get idxs of point lights which bounding spheres intersect
+	// the view frustum of the editor camera (in ascending order)
+
+	// the frustum is built in view space so transform it into world space
+	BoundingFrustum frustum;
+	frustums_[0].Transform(frustum, XMMatrixInverse(nullptr, editorCamera_.GetViewMatrix()));
+
+	outLightsIdxs.clear();
+
+	for (u32 idx = 0; idx < (u32)pointLights.GetCount(); ++idx)
+	{
+		const ECS::PointLight& light = pointLights.data_[idx];
+
+		if (frustum.Intersects(BoundingSphere(light.position_, light.range_)))
+			outLightsIdxs.push_back(idx);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
 void GraphicsClass::SetupLightsForFrame(
 	const ECS::LightSystem& lightSys,
+	const std::vector<u32>& visiblePointLights,
+	const DirectX::XMFLOAT3& cameraPos,
 	std::vector<Render::DirLight>& outDirLights,
 	std::vector<Render::PointLight>& outPointLights,
 	std::vector<Render::SpotLight>& outSpotLights)
 {
 	// convert light source data from the ECS into Render format
-	// (they are the same so we simply need to copy data)
+	// (they are the same so we simply need to copy data);
+	//
+	// only visible point lights are copied; they go from the nearest to the camera
+	// and if there are more lights than the shader can take, the farthest ones
+	// are dropped;
+	//
+	// directional and spot lights keep the order of the ECS so (if the number
+	// of lights is the same as in the previous frame) we copy only lights
+	// from dirty ranges: lights which were changed since the previous frame
+	// (the constant buffer of lights is still written whole, see LightsDirtyRange)
 
 	const ECS::DirLights& dirLights = lightSys.GetDirLights();
 	const ECS::PointLights& pointLights = lightSys.GetPointLights();
 	const ECS::SpotLights& spotLights = lightSys.GetSpotLights();
 
 	const size numDirLights = dirLights.GetCount();
-	const size numPointLights = pointLights.GetCount();
+	const size numVisiblePointLights = std::ssize(visiblePointLights);
+	const size numPointLights = std::min(numVisiblePointLights, (size)Render::buffTypes::MAX_POINT_LIGHTS_PER_FRAME);
 	const size numSpotLights = spotLights.GetCount();
 
+	const XMVECTOR camPos = XMLoadFloat3(&cameraPos);
+	pointLightsByDist_.resize(numVisiblePointLights);
+
+	for (size idx = 0; idx < numVisiblePointLights; ++idx)
+	{
+		const u32 lightIdx = visiblePointLights[idx];
+		const XMVECTOR pos = XMLoadFloat3(&pointLights.data_[lightIdx].position_);
+
+		pointLightsByDist_[idx] = { XMVectorGetX(XMVector3LengthSq(pos - camPos)), lightIdx };
+	}
+
+	// we need only the nearest lights which fit into the shader
+	std::partial_sort(
+		pointLightsByDist_.begin(),
+		pointLightsByDist_.begin() + numPointLights,
+		pointLightsByDist_.end());
+
+	ECS::LightsDirtyRange dirLightsRange = dirLights.dirtyRange_;
+	ECS::LightsDirtyRange spotLightsRange = spotLights.dirtyRange_;
+
+	if (std::ssize(outDirLights) != numDirLights)
+		dirLightsRange.Add(0, (u32)numDirLights);
+
+	if (std::ssize(outSpotLights) != numSpotLights)
+		spotLightsRange.Add(0, (u32)numSpotLights);
+
 	outDirLights.resize(numDirLights);
 	outPointLights.resize(numPointLights);
 	outSpotLights.resize(numSpotLights);
@@ -1080,13 +1382,13 @@ void GraphicsClass::SetupLightsForFrame(
 	size spotLightSize  = sizeof(ECS::SpotLight);
 
 	// copy data of directional/point/spot light sources
-	for (size idx = 0; idx < numDirLights; ++idx)
+	for (size idx = dirLightsRange.begin; idx < std::min((size)dirLightsRange.end, numDirLights); ++idx)
 		memcpy(&outDirLights[idx], &dirLights.data_[idx], dirLightSize);
 
 	for (size idx = 0; idx < numPointLights; ++idx)
-		memcpy(&outPointLights[idx], &pointLights.data_[idx], pointLightSize);
+		memcpy(&outPointLights[idx], &pointLights.data_[pointLightsByDist_[idx].second], pointLightSize);
 
-	for (size idx = 0; idx < numSpotLights; ++idx)
+	for (size idx = spotLightsRange.begin; idx < std::min((size)spotLightsRange.end, numSpotLights); ++idx)
 		memcpy(&outSpotLights[idx], &spotLights.data_[idx], spotLightSize);
 }
 
@@ -1141,71 +1443,4 @@ void GraphicsClass::GetTexSRVsForEntts(
 
 	// get textures shader resource views by textures ids
 	TextureManager::Get()->GetSRVsByTexIDs(texIDs, outTexSRVs);
-}
-
-///////////////////////////////////////////////////////////
-
-void GraphicsClass::GenInstancesTexSetData(
-	const std::vector<EntityID>& inAllEntts,
-	const std::vector<EntityID>& enttsWithOwnTex,
-	const std::vector<ptrdiff_t>& numInstancesPerMesh,       // how many entts instances will be rendered using geometry of the mesh)
-	std::vector<u32>& outTexSetIdxs,
-	std::vector<u32>& outInstancesPerTexSet,
-	u32& outNumUniqueTexSet)
-{
-	const size enttsCount = std::ssize(inAllEntts);
-	const size meshesCount = std::ssize(numInstancesPerMesh);
-
-	// get an arr of indices to textures set for each input entt
-	// so we will know what texture set to use for rendering particular instance
-	outTexSetIdxs.resize(enttsCount);
-
-	int enttsTexSetIdx = 0;
-
-	for (int texIdx = 0; enttsTexSetIdx < meshesCount; ++enttsTexSetIdx)
-	{
-		for (int i = 0; i < numInstancesPerMesh[enttsTexSetIdx]; ++i)
-			outTexSetIdxs[texIdx++] = enttsTexSetIdx;
-	}
-
-	// setup idx to textures set for entts which have the Textured component
-	std::vector<ptrdiff_t> idxsToEnttsWithTex;
-	CoreUtils::GetIdxsInArr(inAllEntts, enttsWithOwnTex, idxsToEnttsWithTex);
-
-	for (const ptrdiff_t idx : idxsToEnttsWithTex)
-		outTexSetIdxs[idx] = enttsTexSetIdx++;
-
-	// how many UNIQUE textures sets we have
-	outNumUniqueTexSet = enttsTexSetIdx;
-
-
-	// ---------------------------------------------
-	// define how many instances we have per texture set
-	// (somewhat branchless method)
-
-	outInstancesPerTexSet.resize(std::size(outTexSetIdxs));
-	u32 pos = 0;
-	outInstancesPerTexSet[pos]++;
-
-	// define how many instance will be rendered per textures set
-	for (size i = 1; i < std::ssize(outTexSetIdxs); ++i)
-	{
-		pos += (outTexSetIdxs[i] != outTexSetIdxs[i - 1]);
-		outInstancesPerTexSet[pos]++;
-	}
-
-	outInstancesPerTexSet.resize(pos + 1);
-
-
-	// ---------------------------------------------
-	// remove duplicates in sequences of the same textures set idxs
-	pos = 0;
-
-	for (size i = 1; i < std::ssize(outTexSetIdxs); ++i)
-	{
-		pos += (outTexSetIdxs[i] != outTexSetIdxs[i - 1]);
-		outTexSetIdxs[pos] = outTexSetIdxs[i];
-	}
-
-	outTexSetIdxs.resize(pos + 1);
 }
\ No newline at end of file
@@ -56,6 +56,9 @@
 // terrain / camera movement handling
 #include "ZoneClass.h"
 
+// selection of meshes LODs by the distance to the camera
+#include "LodSelector.h"
+
 
 
 //////////////////////////////////
@@ -128,12 +131,11 @@ private:
 	void InitCamerasHelper(InitializeGraphics& init, Settings& settings);
 	void InitSceneHelper(InitializeGraphics& init, Settings& settings);
 	void InitGuiHelper(InitializeGraphics& init, Settings& settings);
+	void InitTerrainHelper(Settings& settings);
 
 	// private updating API
 	void UpdateShadersDataPerFrame();
 
-	void ClearRenderingDataBeforeFrame();
-
 	// private rendering API
 	void Render3D();
 
@@ -141,15 +143,38 @@ private:
 	// ------------------------------------------
 	// rendering data prepararing stage API
 
-	void PrepareEnttsDataForRendering(
-		const std::vector<EntityID>& enttsIds,
-		const std::string& enttsSetKey);
+	struct BucketRenderCache;
+
+	void PrepareEnttsDataForRendering(const ECS::RenderBucketID bucketID);
+
+	void PrepareBucketMeshesData(
+		const ECS::InstancesBucket& bucket,
+		BucketRenderCache& cache);
 
+	void FillInstancesDataForRendering(
+		const ECS::InstancesBucket& bucket,
+		const BucketRenderCache& cache,
+		const Mesh::DataForRendering& groupsData,
+		Render::Render::InstanceBufferData& outInstanceBuffData,
+		Render::Render::InstancesDataToRender& outPerInstanceData);
+
+	void UpdateRegroupedInstancesData(
+		const ECS::InstancesBucket& bucket,
+		const BucketRenderCache& cache,
+		Render::Render::InstanceBufferData& inOutInstanceBuffData,
+		Render::Render::InstancesDataToRender& inOutPerInstanceData);
+
+	void FillTexSetsForRendering(
+		const BucketRenderCache& cache,
+		Render::Render::InstancesDataToRender& outPerInstanceData);
 
 
 	// ------------------------------------------
 
-	void RenderEntts(const std::string& enttsSetKey);	
+	void RenderEntts(const ECS::RenderBucketID bucketID);
+
+	void PrepareTerrainMeshData();
+	void RenderTerrain();
 
 	void RenderEnttsReflections(const std::vector<EntityID>& enttsIds);         
 
@@ -166,8 +191,14 @@ private:
 
 	// ------------------------------------------
 
+	void GetVisiblePointLights(
+		const ECS::PointLights& pointLights,
+		std::vector<u32>& outLightsIdxs) const;
+
 	void SetupLightsForFrame(
 		const ECS::LightSystem& lightSys,
+		const std::vector<u32>& visiblePointLights,     // idxs of point lights which intersect the view frustum
+		const DirectX::XMFLOAT3& cameraPos,
 		std::vector<Render::DirLight>& outDirLights,
 		std::vector<Render::PointLight>& outPointLights,
 		std::vector<Render::SpotLight>& outSpotLights);
@@ -179,13 +210,39 @@ private:
 		std::vector<SRV*>& outTexSRVs,
 		std::vector<EntityID>& outEnttsWithOwnTex);
 
-	void GenInstancesTexSetData(
-		const std::vector<EntityID>& inAllEntts,
-		const std::vector<EntityID>& enttsWithOwnTex,
-		const std::vector<ptrdiff_t>& numInstancesPerMesh,       // how many entts instances will be rendered using geometry of the mesh)
-		std::vector<u32>& outTexSetIdxs,
-		std::vector<u32>& outInstancesPerTexSet,
-		u32& outNumUniqueTexSet);
+private:
+	struct BucketRenderCache
+	{
+		// rendering data of a render bucket which is kept from frame to frame;
+		// it is gathered from meshes only for a new set of instances of the bucket
+		// or when textures/materials of meshes are changed
+
+		Mesh::DataForRendering meshesData;       // data of meshes of the bucket (without grouping by LODs)
+		std::vector<SRV*>      texSRVs;          // textures sets (2 per set): sets of meshes and then own sets of instances
+		std::vector<u32>       texSetIdxs;       // idx of the textures set of each instance
+
+		std::vector<uint8_t>   lods;             // the selected LOD of each instance (0 - the mesh itself)
+		std::vector<u32>       order;            // idx of instance by its rendering idx (only visible instances)
+		std::vector<u32>       renderIdxs;       // rendering idx of each instance (or LodSelector::INVALID_RENDER_IDX)
+		std::vector<u32>       lodChangedMeshes; // idxs of meshes which have visible instances with changed LODs
+
+		u32 bucketVersion          = UINT32_MAX;    // versions of data which was used to prepare the rendering data
+		u32 visibilityVersion      = UINT32_MAX;
+		u32 texAndMaterialsVersion = UINT32_MAX;
+	};
+
+	struct TerrainRenderCache
+	{
+		// the terrain grid is rendered by chunks with LODs (not with the render buckets);
+		// data of its mesh is gathered again only when textures/materials of meshes are changed
+
+		EntityID                           enttID = INVALID_ENTITY_ID;
+		Mesh::DataForRendering             meshData;
+		Render::Render::InstanceBufferData instanceData;          // the terrain is rendered as a single instance
+		Render::Render::ChunksDataToRender chunksData;            // visible chunks of the terrain
+
+		u32 texAndMaterialsVersion = UINT32_MAX;
+	};
 
 private:
 	DirectX::XMMATRIX WVO_            = DirectX::XMMatrixIdentity();  // main_world * baseView * ortho
@@ -219,8 +276,14 @@ private:
 	IntersectionWithGameObjects* pIntersectionWithGameObjects_ = nullptr;
 	
 	// for rendering
-	ECS::RenderStatesSystem::EnttsRenderStatesData rsDataToRender_;
-	std::map<std::string, Mesh::DataForRendering> meshesData_;   
+	std::vector<Mesh::DataForRendering> meshesData_;               // meshes data of each render bucket (grouped by LODs)
+	std::vector<BucketRenderCache>      bucketsCache_;             // rendering data of instances of each render bucket
+	TerrainRenderCache                  terrainCache_;
+	LodSelector                         lodSelector_;
+
+	// for lights setup (are reused from frame to frame)
+	std::vector<u32>                    visiblePointLights_;       // idxs of point lights which intersect the view frustum
+	std::vector<std::pair<float, u32>>  pointLightsByDist_;        // visible point lights sorted by the squared distance to the camera
 	
 	// different boolean flags
 	bool isWireframeMode_ = false;             // do we render everything is the WIREFRAME mode?
@@ -5,6 +5,9 @@
 #include "../Engine/EngineException.h"
 #include "../Engine/log.h"
 
+#include <chrono>
+#include <cstring>
+
 
 using namespace TestUtils;
 
@@ -25,6 +28,178 @@ void TestEntityMgr::TestEntitiesCreation()
 
 ///////////////////////////////////////////////////////////
 
+void TestEntityMgr::TestEntitiesBatchCreation()
+{
+	// UNIT TEST: create a few batches of entities, add a component to the entities 
+	//            in reversed (unsorted) order and check if we can get the component
+	//            data of each entity by its ID
+
+	ECS::EntityManager mgr;
+	const u32 batchesCount = 4;
+	const u32 enttsPerBatch = 5000;
+	std::vector<EntityID> ids;
+	TransformData data;
+
+	for (u32 i = 0; i < batchesCount; ++i)
+		Utils::AppendArray(ids, mgr.CreateEntities(enttsPerBatch));
+
+	const size enttsCount = std::ssize(ids);
+	Assert::True(mgr.CheckEnttsByIDsExist(ids), "not all the created entities are stored in the manager");
+	Assert::True(enttsCount == std::ssize(mgr.ids_), "wrong number of entities in the manager");
+
+	// each ID must be unique
+	std::vector<EntityID> sortedIDs = ids;
+	std::sort(sortedIDs.begin(), sortedIDs.end());
+	Assert::True(std::adjacent_find(sortedIDs.begin(), sortedIDs.end()) == sortedIDs.end(), "generated IDs aren't unique");
+
+	// add the Transform component in reversed order of IDs
+	std::reverse(ids.begin(), ids.end());
+	GetRandTransformData((u32)enttsCount, data);
+	mgr.AddTransformComponent(ids, data.positions, data.dirQuats, data.uniformScales);
+
+	// get data by IDs and compare it with the origin data
+	std::vector<ptrdiff_t> idxs;
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMVECTOR> dirQuats;
+	std::vector<float> scales;
+
+	mgr.transformSystem_.GetTransformDataOfEntts(ids, idxs, positions, dirQuats, scales);
+
+	Assert::True(ContainerCompare(positions, data.positions), "got wrong positions by entities IDs");
+	Assert::True(ContainerCompare(scales, data.uniformScales), "got wrong uniform scales by entities IDs");
+
+	Log::Print("\t\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestEntityMgr::TestEntitiesDestruction()
+{
+	// UNIT TEST: destroy some entities and check if their records are removed from
+	//            the components, the rest of data is still valid, and IDs of
+	//            destroyed entities become stale after reusing of their indices
+
+	ECS::EntityManager mgr;
+	const u32 enttsCount = 100;
+	TransformData data;
+	std::vector<EntityName> names;
+
+	const std::vector<EntityID> ids = mgr.CreateEntities(enttsCount);
+
+	GetRandTransformData(enttsCount, data);
+
+	for (const EntityID id : ids)
+		names.push_back("entt_" + std::to_string(id));
+
+	mgr.AddTransformComponent(ids, data.positions, data.dirQuats, data.uniformScales);
+	mgr.AddNameComponent(ids, names);
+
+	// destroy each third entity
+	std::vector<EntityID> idsToDestroy;
+	std::vector<EntityID> idsToKeep;
+	std::vector<XMFLOAT3> positionsToKeep;
+
+	for (u32 i = 0; i < enttsCount; ++i)
+	{
+		if (i % 3 == 0)
+		{
+			idsToDestroy.push_back(ids[i]);
+		}
+		else
+		{
+			idsToKeep.push_back(ids[i]);
+			positionsToKeep.push_back(data.positions[i]);
+		}
+	}
+
+	mgr.DestroyEntities(idsToDestroy);
+
+	// check destroyed entities
+	bool areDestroyed = true;
+
+	for (const EntityID id : idsToDestroy)
+		areDestroyed &= !mgr.CheckEnttsByIDsExist({ id }) && (mgr.nameSystem_.GetNameById(id) == INVALID_ENTITY_NAME);
+
+	Assert::True(areDestroyed, "some entity wasn't destroyed");
+	Assert::True(std::ssize(mgr.ids_) == std::ssize(idsToKeep), "wrong number of entities after destruction");
+	Assert::True(std::ssize(mgr.GetComponentTransform().ids_) == std::ssize(idsToKeep), "wrong number of records in the Transform component");
+	Assert::True(std::ssize(mgr.GetComponentName().ids_) == std::ssize(idsToKeep), "wrong number of records in the Name component");
+
+	// check the rest of entities
+	std::vector<ptrdiff_t> idxs;
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMVECTOR> dirQuats;
+	std::vector<float> scales;
+
+	mgr.transformSystem_.GetTransformDataOfEntts(idsToKeep, idxs, positions, dirQuats, scales);
+	Assert::True(ContainerCompare(positions, positionsToKeep), "data of entities which weren't destroyed is corrupted");
+
+	for (const EntityID id : idsToKeep)
+		Assert::True(mgr.nameSystem_.GetNameById(id) == "entt_" + std::to_string(id), "got wrong name of entity by ID");
+
+	// create new entities (indices of destroyed ones are reused) and check 
+	// if old IDs of the destroyed entities are still invalid
+	const std::vector<EntityID> newIDs = mgr.CreateEntities((u32)idsToDestroy.size());
+
+	Assert::True(mgr.CheckEnttsByIDsExist(newIDs), "new entities weren't created");
+
+	for (const EntityID id : idsToDestroy)
+		Assert::True(!mgr.CheckEnttsByIDsExist({ id }), "a stale ID of destroyed entity is valid");
+
+	Log::Print("\t\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestEntityMgr::TestEnttsQuery()
+{
+	// UNIT TEST: check if a query returns proper entities and data idxs
+	//            and if it is rebuilt after structural changes
+
+	ECS::EntityManager mgr;
+	const u32 enttsCount = 10;
+	TransformData transform;
+	MoveData move;
+
+	const std::vector<EntityID> ids = mgr.CreateEntities(enttsCount);
+	std::vector<EntityID> movedIDs;
+
+	for (u32 i = 0; i < enttsCount; i += 2)
+		movedIDs.push_back(ids[i]);
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandMoveData((u32)movedIDs.size(), move);
+
+	mgr.AddTransformComponent(ids, transform.positions, transform.dirQuats, transform.uniformScales);
+	mgr.AddMoveComponent(movedIDs, move.translations, move.rotQuats, move.uniformScales);
+
+	// check the query result
+	const ECS::EnttsQuery& query = mgr.Query({ ECS::MoveComponent, ECS::TransformComponent });
+	const std::vector<ptrdiff_t>& transIdxs = query.GetDataIdxs(ECS::TransformComponent);
+	const std::vector<ptrdiff_t>& moveIdxs = query.GetDataIdxs(ECS::MoveComponent);
+
+	Assert::True(ContainerCompare(query.ids_, movedIDs), "the query has wrong entities");
+
+	for (size i = 0; i < query.Count(); ++i)
+	{
+		Assert::True(mgr.GetComponentTransform().ids_[transIdxs[i]] == query.ids_[i], "wrong data idx into the Transform component");
+		Assert::True(mgr.GetComponentMovement().ids_[moveIdxs[i]] == query.ids_[i], "wrong data idx into the Movement component");
+	}
+
+	// after a structural change the query must be rebuilt
+	mgr.DestroyEntities({ movedIDs.front() });
+	Assert::True(mgr.Query({ ECS::MoveComponent, ECS::TransformComponent }).Count() == std::ssize(movedIDs) - 1, "the query wasn't rebuilt after destruction of entities");
+
+	// filtering of entities is made using the query as well
+	std::vector<EntityID> filtered;
+	mgr.FilterInputEnttsByComponents(ids, { ECS::MoveComponent }, filtered);
+	Assert::True(ContainerCompare(filtered, std::vector<EntityID>(movedIDs.begin() + 1, movedIDs.end())), "wrong result of filtering entities by components");
+
+	Log::Print("\t\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
 void CheckDeserialEnttMgrData(
 	const ECS::EntityManager& mgr,
 	const std::vector<EntityID>& origIDs,
@@ -42,6 +217,202 @@ void CheckDeserialEnttMgrData(
 
 ///////////////////////////////////////////////////////////
 
+static void AddRestOfComponents(
+	ECS::EntityManager& mgr,
+	const std::vector<EntityID>& ids)
+{
+	// add to entities the components which aren't covered by other data generators:
+	// each 10th entt is textured, each 20th entt is a point light, each 50th entt
+	// (with offset) is a spot light; all the entts have render states and bounding boxes
+
+	const u32 texTypesCount = (u32)ECS::Textured::TEXTURES_TYPES_COUNT;
+	const ECS::Transform& transform = mgr.GetComponentTransform();
+
+	std::vector<EntityID> texturedIDs;
+	std::vector<EntityID> pointLightsIDs;
+	std::vector<EntityID> spotLightsIDs;
+
+	for (size i = 0; i < std::ssize(ids); ++i)
+	{
+		if (i % 10 == 0) texturedIDs.push_back(ids[i]);
+		if (i % 20 == 0) pointLightsIDs.push_back(ids[i]);
+		if (i % 50 == 25) spotLightsIDs.push_back(ids[i]);
+	}
+
+	// textures (there are only a few unique paths so the string table stays small)
+	std::vector<std::vector<TexID>> texIDs(texturedIDs.size(), std::vector<TexID>(texTypesCount, 0));
+	std::vector<std::vector<TexPath>> texPaths(texturedIDs.size(), std::vector<TexPath>(texTypesCount, "unloaded"));
+
+	for (size i = 0; i < std::ssize(texturedIDs); ++i)
+	{
+		texIDs[i][1] = (TexID)(i % 16) + 1;
+		texPaths[i][1] = "data/textures/test_" + std::to_string(i % 16) + ".dds";
+	}
+
+	mgr.AddTexturedComponent(texturedIDs, texIDs, texPaths);
+
+	const ECS::StaticTexTransParams staticTexParams((u32)texturedIDs.size(), DirectX::XMMatrixScaling(2, 2, 1));
+	mgr.AddTextureTransformComponent(ECS::TexTransformType::STATIC, texturedIDs, staticTexParams);
+
+	// light sources (a few of point lights are animated)
+	ECS::PointLightsInitParams pointLightsParams;
+	ECS::SpotLightsInitParams spotLightsParams;
+
+	GetRandPointLightsData((u32)pointLightsIDs.size(), pointLightsParams);
+	mgr.AddLightComponent(pointLightsIDs, pointLightsParams);
+
+	if (!spotLightsIDs.empty())
+	{
+		GetRandSpotLightsData((u32)spotLightsIDs.size(), spotLightsParams);
+		mgr.AddLightComponent(spotLightsIDs, spotLightsParams);
+	}
+
+	ECS::LightAnimParams animParams;
+	animParams.type   = ECS::LIGHT_ANIM_ORBIT;
+	animParams.radius = 5.0f;
+
+	for (size i = 0; i < std::ssize(pointLightsIDs); i += 4)
+		mgr.lightSystem_.AddPointLightAnimation(pointLightsIDs[i], animParams);
+
+	// render states and bounding boxes around positions of entities
+	std::vector<std::set<ECS::RenderStatesTypes>> states(ids.size(), { ECS::FILL_SOLID, ECS::CULL_BACK });
+	std::vector<DirectX::BoundingBox> boxes(ids.size());
+	std::vector<ECS::BoundingType> boundTypes(ids.size(), ECS::BoundingType::AABB);
+
+	for (size i = 0; i < std::ssize(ids); ++i)
+	{
+		const XMFLOAT4& pos = transform.posAndUniformScale_[transform.sparse_.GetIdx(ids[i])];
+		boxes[i] = DirectX::BoundingBox({ pos.x, pos.y, pos.z }, { 1, 1, 1 });
+	}
+
+	mgr.AddRenderStatesComponent(ids, states);
+	mgr.AddBoundingComponent(ids, boxes, boundTypes);
+}
+
+///////////////////////////////////////////////////////////
+
+template <typename T>
+static bool AreBytesEqual(const std::vector<T>& lhs, const std::vector<T>& rhs)
+{
+	// check if two arrays of POD data are completely equal
+	return (lhs.size() == rhs.size()) && (memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(T)) == 0);
+}
+
+///////////////////////////////////////////////////////////
+
+static bool AreLightAnimsEqual(const ECS::LightAnimations& lhs, const ECS::LightAnimations& rhs)
+{
+	return
+		AreBytesEqual(lhs.ids_, rhs.ids_) &&
+		AreBytesEqual(lhs.dataIdxs_, rhs.dataIdxs_) &&
+		AreBytesEqual(lhs.types_, rhs.types_) &&
+		AreBytesEqual(lhs.baseDiffuses_, rhs.baseDiffuses_) &&
+		AreBytesEqual(lhs.baseSpeculars_, rhs.baseSpeculars_) &&
+		AreBytesEqual(lhs.centersX_, rhs.centersX_) &&
+		AreBytesEqual(lhs.radiuses_, rhs.radiuses_) &&
+		AreBytesEqual(lhs.speeds_, rhs.speeds_) &&
+		AreBytesEqual(lhs.positionsX_, rhs.positionsX_);
+}
+
+///////////////////////////////////////////////////////////
+
+static void CompareAllComponents(
+	const ECS::EntityManager& orig,
+	const ECS::EntityManager& deser)
+{
+	// check if data of all the components of the deserialized entity manager
+	// is the same as data of the origin entity manager
+
+	const ECS::Transform&        t1    = orig.GetComponentTransform();
+	const ECS::Transform&        t2    = deser.GetComponentTransform();
+	const ECS::WorldMatrix&      w1    = orig.GetComponentWorld();
+	const ECS::WorldMatrix&      w2    = deser.GetComponentWorld();
+	const ECS::Movement&         m1    = orig.GetComponentMovement();
+	const ECS::Movement&         m2    = deser.GetComponentMovement();
+	const ECS::MeshComponent&    mesh1 = orig.GetComponentMesh();
+	const ECS::MeshComponent&    mesh2 = deser.GetComponentMesh();
+	const ECS::Rendered&         r1    = orig.GetComponentRendered();
+	const ECS::Rendered&         r2    = deser.GetComponentRendered();
+	const ECS::Textured&         tex1  = orig.GetComponentTextured();
+	const ECS::Textured&         tex2  = deser.GetComponentTextured();
+	const ECS::TextureTransform& tt1   = orig.GetComponentTexTransform();
+	const ECS::TextureTransform& tt2   = deser.GetComponentTexTransform();
+	const ECS::Light&            l1    = orig.GetComponentLight();
+	const ECS::Light&            l2    = deser.GetComponentLight();
+	const ECS::RenderStates&     rs1   = orig.GetComponentRenderStates();
+	const ECS::RenderStates&     rs2   = deser.GetComponentRenderStates();
+	const ECS::Bounding&         b1    = orig.GetComponentBounding();
+	const ECS::Bounding&         b2    = deser.GetComponentBounding();
+
+	Assert::True(AreBytesEqual(orig.ids_, deser.ids_) && AreBytesEqual(orig.componentHashes_, deser.componentHashes_), "TEST ENTITY MANAGER: deserialized data of entities isn't correct");
+
+	Assert::True(
+		AreBytesEqual(t1.ids_, t2.ids_) &&
+		AreBytesEqual(t1.posAndUniformScale_, t2.posAndUniformScale_) &&
+		AreBytesEqual(t1.dirQuats_, t2.dirQuats_) &&
+		AreBytesEqual(t1.dirtyFlags_, t2.dirtyFlags_), "TEST ENTITY MANAGER: deserialized Transform data isn't correct");
+
+	Assert::True(AreBytesEqual(w1.ids_, w2.ids_) && AreBytesEqual(w1.worlds_, w2.worlds_), "TEST ENTITY MANAGER: deserialized WorldMatrix data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(m1.ids_, m2.ids_) &&
+		AreBytesEqual(m1.translationAndUniScales_, m2.translationAndUniScales_) &&
+		AreBytesEqual(m1.rotationQuats_, m2.rotationQuats_), "TEST ENTITY MANAGER: deserialized Movement data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(orig.GetComponentName().ids_, deser.GetComponentName().ids_) &&
+		ContainerCompare(orig.GetComponentName().names_, deser.GetComponentName().names_), "TEST ENTITY MANAGER: deserialized Name data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(mesh1.ids_, mesh2.ids_) &&
+		AreBytesEqual(mesh1.enttsOffsets_, mesh2.enttsOffsets_) &&
+		AreBytesEqual(mesh1.enttsMeshes_, mesh2.enttsMeshes_), "TEST ENTITY MANAGER: deserialized MeshComponent data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(r1.ids_, r2.ids_) &&
+		AreBytesEqual(r1.shaderTypes_, r2.shaderTypes_) &&
+		AreBytesEqual(r1.primTopologies_, r2.primTopologies_), "TEST ENTITY MANAGER: deserialized Rendered data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(tex1.ids_, tex2.ids_) &&
+		ContainerCompare(tex1.texIDs_, tex2.texIDs_) &&
+		ContainerCompare(tex1.texPaths_, tex2.texPaths_), "TEST ENTITY MANAGER: deserialized Textured data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(tt1.ids_, tt2.ids_) &&
+		AreBytesEqual(tt1.transformTypes_, tt2.transformTypes_) &&
+		AreBytesEqual(tt1.texTransforms_, tt2.texTransforms_) &&
+		AreBytesEqual(tt1.texStaticTrans_.ids_, tt2.texStaticTrans_.ids_) &&
+		AreBytesEqual(tt1.texStaticTrans_.transformations_, tt2.texStaticTrans_.transformations_), "TEST ENTITY MANAGER: deserialized TextureTransform data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(l1.ids_, l2.ids_) &&
+		AreBytesEqual(l1.dirLights_.ids_, l2.dirLights_.ids_) &&
+		AreBytesEqual(l1.pointLights_.ids_, l2.pointLights_.ids_) &&
+		AreBytesEqual(l1.pointLights_.data_, l2.pointLights_.data_) &&
+		AreBytesEqual(l1.spotLights_.ids_, l2.spotLights_.ids_) &&
+		AreBytesEqual(l1.spotLights_.data_, l2.spotLights_.data_) &&
+		AreLightAnimsEqual(l1.pointLightsAnims_, l2.pointLightsAnims_) &&
+		AreLightAnimsEqual(l1.spotLightsAnims_, l2.spotLightsAnims_), "TEST ENTITY MANAGER: deserialized Light data isn't correct");
+
+	Assert::True(AreBytesEqual(rs1.ids_, rs2.ids_) && AreBytesEqual(rs1.statesHashes_, rs2.statesHashes_), "TEST ENTITY MANAGER: deserialized RenderStates data isn't correct");
+
+	Assert::True(
+		AreBytesEqual(b1.ids_, b2.ids_) &&
+		AreBytesEqual(b1.types_, b2.types_) &&
+		AreBytesEqual(b1.data_, b2.data_), "TEST ENTITY MANAGER: deserialized Bounding data isn't correct");
+
+	// mappings ['entity_id' => 'data_idx'] must be rebuilt
+	for (const EntityID id : orig.ids_)
+	{
+		Assert::True(t1.sparse_.GetIdx(id) == t2.sparse_.GetIdx(id), "TEST ENTITY MANAGER: wrong mapping of the deserialized Transform");
+		Assert::True(b1.sparse_.GetIdx(id) == b2.sparse_.GetIdx(id), "TEST ENTITY MANAGER: wrong mapping of the deserialized Bounding");
+		Assert::True(l1.pointLights_.sparse_.GetIdx(id) == l2.pointLights_.sparse_.GetIdx(id), "TEST ENTITY MANAGER: wrong mapping of the deserialized Light");
+	}
+}
+
+///////////////////////////////////////////////////////////
+
 void TestEntityMgr::TestSerialDeserial()
 {
 	// test the EntityManager for correct serialization/deserialization 
@@ -74,6 +445,7 @@ void TestEntityMgr::TestSerialDeserial()
 	origMgr.AddMoveComponent(enttsIDs, move.translations, move.rotQuats, move.uniformScales);
 	origMgr.AddMeshComponent(enttsIDs, meshesIDs);
 	origMgr.AddRenderingComponent(enttsIDs, rendered.shaderTypes, rendered.primTopologyTypes);
+	AddRestOfComponents(origMgr, enttsIDs);
 
 	// ---------------------------------------------
 
@@ -97,6 +469,269 @@ void TestEntityMgr::TestSerialDeserial()
 	CompareNameData(deserMgr.GetComponentName(), enttsIDs, names);
 	CompareMeshData(deserMgr.meshSystem_, enttsIDs, meshesIDs);
 	CompareRenderedData(deserMgr.GetComponentRendered(), enttsIDs, rendered);
+	CompareAllComponents(origMgr, deserMgr);
+
+	Log::Print("\t\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestEntityMgr::TestDeserialGenerations()
+{
+	// UNIT TEST: IDs of entities which are created after loading of a scene must not
+	//            match neither IDs which were destroyed before saving of the scene
+	//            nor IDs which existed in the manager before loading;
+	//            a file of the legacy format must be rejected
+
+	const std::string filepath = "test_entity_mgr_generations.bin";
+
+	ECS::EntityManager origMgr;
+	ECS::EntityManager deserMgr;
+
+	const std::vector<EntityID> origIDs = origMgr.CreateEntities(10);
+	const std::vector<EntityID> destroyedIDs = { origIDs[1], origIDs[4], origIDs[7] };
+
+	origMgr.DestroyEntities(destroyedIDs);
+	Assert::True(origMgr.Serialize(filepath), "TEST ENTITY MANAGER: can't serialize a scene");
+
+	// handles which exist before loading
+	const std::vector<EntityID> oldIDs = deserMgr.CreateEntities(20);
+	deserMgr.DestroyEntities({ oldIDs[15] });
+
+	Assert::True(deserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: can't deserialize a scene");
+	RemoveFile(filepath);
+
+	Assert::True(deserMgr.GetAllEnttsIDs() == origMgr.GetAllEnttsIDs(), "TEST ENTITY MANAGER: wrong IDs after loading");
+
+	const std::vector<EntityID> newIDs = deserMgr.CreateEntities(30);
+
+	auto HasID = [](const std::vector<EntityID>& ids, const EntityID id)
+	{
+		return std::find(ids.begin(), ids.end(), id) != ids.end();
+	};
+
+	for (const EntityID id : newIDs)
+	{
+		Assert::True(!HasID(destroyedIDs, id), "TEST ENTITY MANAGER: a new ID aliases an ID destroyed before saving");
+		Assert::True(!HasID(oldIDs, id), "TEST ENTITY MANAGER: a new ID aliases an ID which existed before loading");
+		Assert::True(!HasID(origIDs, id), "TEST ENTITY MANAGER: a new ID aliases a loaded ID");
+	}
+
+	// the legacy format starts with the number of data blocks
+	std::ofstream fout(filepath, std::ios::binary);
+	const std::vector<u32> legacyData(64, ECS::LEGACY_SCENE_FILE_BLOCKS_COUNT);
+	fout.write((const char*)legacyData.data(), legacyData.size() * sizeof(u32));
+	fout.close();
+
+	Assert::True(!deserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: a file of the legacy format was loaded");
+	RemoveFile(filepath);
+
+	Log::Print("\t\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestEntityMgr::TestDeserialCorruptedFile()
+{
+	// UNIT TEST: a scene file with a corrupted offset must be rejected and the manager
+	//            must stay the same as before the loading (and still be usable);
+	//            an offset of an array in the table of arrays is checked when the file
+	//            is opened, while offsets of meshes are checked when some blocks
+	//            are already decoded into the manager
+
+	const std::string filepath = "test_entity_mgr_corrupted.bin";
+	const u32 enttsCount = 100;
+	const std::vector<MeshID> meshesIDs{ 1,2,3 };
+
+	ECS::EntityManager origMgr;
+	ECS::EntityManager deserMgr;
+	TransformData transform;
+	RenderedData rendered;
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandRenderedData(enttsCount, rendered);
+
+	const std::vector<EntityID> enttsIDs = origMgr.CreateEntities(enttsCount);
+
+	origMgr.AddTransformComponent(enttsIDs, transform.positions, transform.dirQuats, transform.uniformScales);
+	origMgr.AddMeshComponent(enttsIDs, meshesIDs);
+	origMgr.AddRenderingComponent(enttsIDs, rendered.shaderTypes, rendered.primTopologyTypes);
+	AddRestOfComponents(origMgr, enttsIDs);
+
+	Assert::True(origMgr.Serialize(filepath), "TEST ENTITY MANAGER: can't serialize a scene");
+	Assert::True(deserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: can't deserialize a scene");
+
+	// read the valid file and find the table of arrays of the Mesh block
+	std::vector<char> fileData((size_t)fs::file_size(filepath));
+	std::ifstream fin(filepath, std::ios::binary);
+	fin.read(fileData.data(), fileData.size());
+	fin.close();
+
+	ECS::SceneFileHeader header;
+	memcpy(&header, fileData.data(), sizeof(header));
+
+	ECS::SceneBlockDesc meshBlock;
+
+	for (u32 i = 0; i < header.blocksCount; ++i)
+	{
+		ECS::SceneBlockDesc block;
+		memcpy(&block, fileData.data() + header.blocksTablePos + i * sizeof(block), sizeof(block));
+
+		if (block.type == ECS::SCENE_BLOCK_MESH)
+			meshBlock = block;
+	}
+
+	Assert::True(meshBlock.arraysCount == 3, "TEST ENTITY MANAGER: there is no Mesh block in the file");
+
+	// arrays of the Mesh block: IDs, offsets of meshes of entities, meshes of entities
+	const size_t offsetsDescPos = meshBlock.arraysTablePos + sizeof(ECS::SceneArrayDesc);
+	ECS::SceneArrayDesc offsetsDesc;
+	memcpy(&offsetsDesc, fileData.data() + offsetsDescPos, sizeof(offsetsDesc));
+
+	auto LoadCorruptedFile = [&](const size_t pos, const uint64_t value, const size_t valueSize)
+	{
+		std::vector<char> corrupted = fileData;
+		memcpy(corrupted.data() + pos, &value, valueSize);
+
+		std::ofstream fout(filepath, std::ios::binary);
+		fout.write(corrupted.data(), corrupted.size());
+		fout.close();
+
+		Assert::True(!deserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: a corrupted scene file was loaded");
+
+		// the manager must keep the previously loaded scene
+		Assert::True(deserMgr.GetAllEnttsIDs() == origMgr.GetAllEnttsIDs(), "TEST ENTITY MANAGER: IDs were changed by a failed loading");
+		CompareAllComponents(origMgr, deserMgr);
+	};
+
+	// the offset of the array of offsets of meshes points out of the file
+	LoadCorruptedFile(offsetsDescPos + offsetof(ECS::SceneArrayDesc, pos), fileData.size(), sizeof(uint64_t));
+
+	// offsets of meshes of entities are decreasing
+	LoadCorruptedFile(offsetsDesc.pos + sizeof(u32), 3 * enttsCount, sizeof(u32));
+
+	// ---------------------------------------------
+
+	// the manager is still usable: new entities don't alias the loaded ones
+	const std::vector<EntityID> newIDs = deserMgr.CreateEntities(10);
+
+	for (const EntityID id : newIDs)
+		Assert::True(std::find(enttsIDs.begin(), enttsIDs.end(), id) == enttsIDs.end(), "TEST ENTITY MANAGER: a new ID aliases a loaded ID");
+
+	TransformData newTransform;
+	GetRandTransformData(10, newTransform);
+	deserMgr.AddTransformComponent(newIDs, newTransform.positions, newTransform.dirQuats, newTransform.uniformScales);
+	Assert::True(deserMgr.GetComponentTransform().ids_.size() == enttsCount + 10, "TEST ENTITY MANAGER: can't add components after a failed loading");
+
+	// and the valid file is still loaded
+	std::ofstream fout(filepath, std::ios::binary);
+	fout.write(fileData.data(), fileData.size());
+	fout.close();
+
+	Assert::True(deserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: can't deserialize a scene after a failed loading");
+	RemoveFile(filepath);
+
+	CompareAllComponents(origMgr, deserMgr);
+
+	Log::Print("\t\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestEntityMgr::BenchmarkSceneLoad()
+{
+	// BENCHMARK: save a scene of 100k entities with all the components and load it;
+	//            the loading time is compared with the time of plain reading of
+	//            the same file into a buffer (the bandwidth of the disk / file cache)
+
+	using Clock = std::chrono::steady_clock;
+
+	const std::string filepath = "test_scene_load_benchmark.bin";
+	const u32 enttsCount = 100000;
+	const std::vector<MeshID> meshesIDs{ 1,2,3 };
+	std::vector<EntityName> names;
+
+	ECS::EntityManager origMgr;
+	ECS::EntityManager deserMgr;
+	TransformData transform;
+	MoveData move;
+	RenderedData rendered;
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandEnttsNames(enttsCount, 16, names);
+	GetRandMoveData(enttsCount, move);
+	GetRandRenderedData(enttsCount, rendered);
+
+	const std::vector<EntityID> enttsIDs = origMgr.CreateEntities(enttsCount);
+
+	origMgr.AddTransformComponent(enttsIDs, transform.positions, transform.dirQuats, transform.uniformScales);
+	origMgr.AddNameComponent(enttsIDs, names);
+	origMgr.AddMoveComponent(enttsIDs, move.translations, move.rotQuats, move.uniformScales);
+	origMgr.AddMeshComponent(enttsIDs, meshesIDs);
+	origMgr.AddRenderingComponent(enttsIDs, rendered.shaderTypes, rendered.primTopologyTypes);
+	AddRestOfComponents(origMgr, enttsIDs);
+
+	// ---------------------------------------------
+
+	auto start = Clock::now();
+	Assert::True(origMgr.Serialize(filepath), "TEST ENTITY MANAGER: can't serialize a scene");
+	const double saveTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	const uintmax_t fileSize = fs::file_size(filepath);
+	std::vector<char> buffer((size_t)fileSize);
+
+	// the first reading warms up the file cache so both next measurements read from the same source
+	std::ifstream fin(filepath, std::ios::binary);
+	fin.read(buffer.data(), buffer.size());
+	fin.close();
+
+	start = Clock::now();
+	fin.open(filepath, std::ios::binary);
+	fin.read(buffer.data(), buffer.size());
+	fin.close();
+	const double readTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	// blocks are decoded by the thread pool of the manager so compare
+	// the loading by a single thread with the loading by all the workers
+	ECS::EntityManager serialDeserMgr;
+	serialDeserMgr.SetWorkersCount(0);
+
+	start = Clock::now();
+	Assert::True(serialDeserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: can't deserialize a scene");
+	const double serialLoadTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	Assert::True(deserMgr.Deserialize(filepath), "TEST ENTITY MANAGER: can't deserialize a scene");
+	const double loadTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	RemoveFile(filepath);
+
+	CompareAllComponents(origMgr, serialDeserMgr);
+	CompareAllComponents(origMgr, deserMgr);
+
+	const double sizeMb = (double)fileSize / (1024.0 * 1024.0);
+
+	Log::Print("\tscene of " + std::to_string(enttsCount) + " entts (" + std::to_string(sizeMb) + " MB): "
+		"save: " + std::to_string(saveTimeMs) + " ms; "
+		"load (1 thread): " + std::to_string(serialLoadTimeMs) + " ms (" + std::to_string(sizeMb * 1000.0 / serialLoadTimeMs) + " MB/s); "
+		"load (" + std::to_string(deserMgr.GetWorkersCount()) + " workers): " + std::to_string(loadTimeMs) + " ms (" + std::to_string(sizeMb * 1000.0 / loadTimeMs) + " MB/s); "
+		"plain read: " + std::to_string(readTimeMs) + " ms (" + std::to_string(sizeMb * 1000.0 / readTimeMs) + " MB/s)");
+
+	// which blocks dominate the loading time
+	const ECS::SceneLoadTimings& timings = deserMgr.GetSceneLoadTimings();
+
+	Log::Print("\t\topen: " + std::to_string(timings.openMs) + " ms; "
+		"decode: " + std::to_string(timings.decodeMs) + " ms; "
+		"validation: " + std::to_string(timings.validationMs) + " ms; "
+		"total: " + std::to_string(timings.totalMs) + " ms");
+
+	for (u32 type = 0; type < ECS::NUM_SCENE_BLOCKS; ++type)
+	{
+		if (type == ECS::SCENE_BLOCK_STRINGS)
+			continue;
+
+		Log::Print("\t\t" + std::string(ECS::GetSceneBlockName((ECS::SceneBlockType)type)) + ": " + std::to_string(timings.blocksMs[type]) + " ms");
+	}
 
 	Log::Print("\t\tPASSED");
 }
@@ -12,5 +12,11 @@ public:
 	TestEntityMgr() {}
 
 	void TestEntitiesCreation();
+	void TestEntitiesBatchCreation();
+	void TestEntitiesDestruction();
+	void TestEnttsQuery();
 	void TestSerialDeserial();
+	void TestDeserialGenerations();
+	void TestDeserialCorruptedFile();
+	void BenchmarkSceneLoad();
 };
\ No newline at end of file
@@ -7,6 +7,15 @@
 #include "TestSystems.h"
 #include "TestUtils.h"
 #include "../Common/MathHelper.h"
+#include "Systems/LightClusters.h"
+#include "Systems/LightInfluenceSystem.h"
+
+#include <chrono>
+#include <cfloat>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstdlib>
 
 using namespace DirectX;
 using namespace TestUtils;
@@ -23,7 +32,11 @@ void TestSystems::Run()
 
 		TestSerialDeserial();
 		TestMoveSysUpdating();
+		TestDirtyWorldMatricesUpdating();
 		TestTexTransformSysUpdating();
+		TestSystemsScheduling();
+		TestBVHQueries();
+		TestLightInfluence();
 	}
 	catch (EngineException& e)
 	{
@@ -35,6 +48,32 @@ void TestSystems::Run()
 
 ///////////////////////////////////////////////////////////
 
+void TestSystems::RunBenchmarks()
+{
+	Log::Print();
+	Log::Print("-----------  BENCHMARKS: ECS SYSTEMS  ------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		srand((u32)time(NULL));
+
+		BenchmarkMoveSysUpdating();
+		BenchmarkFrustumCulling();
+		BenchmarkInstancesCache();
+		BenchmarkLightClusters();
+		BenchmarkLightAnimations();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("BENCHMARK SYSTEMS: some benchmark failed");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
 void TestSystems::TestSerialDeserial()
 {
 	// here we test ECS systems for correct SEPARATE
@@ -111,6 +150,1173 @@ void TestSystems::TestMoveSysUpdating()
 
 // --------------------------------------------------------
 
+void TestSystems::TestDirtyWorldMatricesUpdating()
+{
+	// UNIT TEST: only moved entities must be marked as dirty and only their
+	//            world matrices must be rebuilt from the transform data
+
+	const u32 enttsCount = 100;
+	const float eps = 0.001f;
+
+	ECS::EntityManager mgr;
+	TransformData transform;
+	MoveData move;
+
+	const std::vector<EntityID> ids = mgr.CreateEntities(enttsCount);
+	std::vector<EntityID> movedIDs;
+
+	// only each second entity is moving
+	for (u32 i = 0; i < enttsCount; i += 2)
+		movedIDs.push_back(ids[i]);
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandMoveData((u32)movedIDs.size(), move);
+
+	mgr.AddTransformComponent(ids, transform.positions, transform.dirQuats, transform.uniformScales);
+	mgr.AddMoveComponent(movedIDs, move.translations, move.rotQuats, move.uniformScales);
+
+	const std::vector<XMMATRIX> origWorlds = mgr.GetComponentWorld().worlds_;
+
+	mgr.Update(100.0f, 0.016f);
+
+	const ECS::Transform& transComp = mgr.GetComponentTransform();
+	const ECS::WorldMatrix& worldComp = mgr.GetComponentWorld();
+
+	// check the dirty list
+	std::vector<EntityID> dirtyIDs = mgr.transformSystem_.GetDirtyEnttsIDs();
+	std::sort(dirtyIDs.begin(), dirtyIDs.end());
+
+	Assert::True(dirtyIDs == movedIDs, "wrong list of dirty entities");
+
+	for (u32 i = 0; i < enttsCount; ++i)
+	{
+		const bool isMoved = (i % 2 == 0);
+		const ptrdiff_t transIdx = transComp.sparse_.GetIdx(ids[i]);
+		const ptrdiff_t worldIdx = worldComp.sparse_.GetIdx(ids[i]);
+
+		Assert::True(transComp.dirtyFlags_[transIdx] == 0, "dirty flag wasn't cleared after updating");
+
+		// a matrix which is built from the canonical transform data
+		const XMFLOAT4& posAndScale = transComp.posAndUniformScale_[transIdx];
+		const XMMATRIX expectedWorld = (isMoved) ?
+			XMMatrixScaling(posAndScale.w, posAndScale.w, posAndScale.w) *
+			XMMatrixRotationQuaternion(transComp.dirQuats_[transIdx]) *
+			XMMatrixTranslation(posAndScale.x, posAndScale.y, posAndScale.z) :
+			origWorlds[worldIdx];
+
+		const XMMATRIX& world = worldComp.worlds_[worldIdx];
+		const XMVECTOR epsVec = XMVectorReplicate(eps);
+
+		for (int row = 0; row < 4; ++row)
+			Assert::True(XMVector4NearEqual(world.r[row], expectedWorld.r[row], epsVec), "wrong world matrix of entity: " + std::to_string(ids[i]));
+	}
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+// allocations are counted by the replaced global operator new (of all the threads)
+// only while counting is enabled so it works in any build configuration
+static std::atomic<bool> s_isCountingAllocs = false;
+static std::atomic<long> s_allocsCount = 0;
+
+void* operator new(const size_t count)
+{
+	if (s_isCountingAllocs.load(std::memory_order_relaxed))
+		s_allocsCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* ptr = malloc(count ? count : 1))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, const size_t) noexcept
+{
+	free(ptr);
+}
+
+///////////////////////////////////////////////////////////
+
+void TestSystems::BenchmarkMoveSysUpdating()
+{
+	// BENCHMARK: update of a big number of moving entities through the same path
+	//            as a real frame (EntityManager::Update: the scheduler and the pool
+	//            of worker threads); measure the average frame time and check that
+	//            there are no heap allocations during updating
+
+	const u32 enttsCount = 50000;
+	const u32 framesCount = 100;
+	const float deltaTime = 0.016f;
+
+	ECS::EntityManager mgr;
+	TransformData transform;
+	MoveData move;
+
+	mgr.SetWorkersCount(4);
+
+	const std::vector<EntityID> ids = mgr.CreateEntities(enttsCount);
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandMoveData(enttsCount, move);
+
+	mgr.AddTransformComponent(ids, transform.positions, transform.dirQuats, transform.uniformScales);
+	mgr.AddMoveComponent(ids, move.translations, move.rotQuats, move.uniformScales);
+
+	// warm up: the query and lists of moved/dirty entities are built during the first frame
+	mgr.Update(0.0f, deltaTime);
+
+	s_allocsCount = 0;
+	s_isCountingAllocs = true;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (u32 i = 1; i <= framesCount; ++i)
+		mgr.Update(i * deltaTime, deltaTime);
+
+	const auto end = std::chrono::steady_clock::now();
+
+	s_isCountingAllocs = false;
+	const long allocsCount = s_allocsCount;
+
+	const double frameTimeMs = std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+
+	Log::Print("\tmove system (" + std::to_string(enttsCount) + " entts, " + std::to_string(mgr.GetWorkersCount()) + " workers): " + std::to_string(frameTimeMs) + " ms per frame");
+	Log::Print("\theap allocations during " + std::to_string(framesCount) + " frames: " + std::to_string(allocsCount));
+	Assert::True(allocsCount == 0, "there are heap allocations during updating of the move system");
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+void TestSystems::TestSystemsScheduling()
+{
+	// UNIT TEST: update the same scene using a few worker threads and in the
+	//            single-thread mode; the results must be exactly the same
+
+	const u32 enttsCount = 20000;   // a few chunks of the move system
+	const u32 framesCount = 10;
+	const float deltaTime = 0.016f;
+
+	ECS::EntityManager mgrST;       // single-threaded
+	ECS::EntityManager mgrMT;       // multi-threaded
+	TransformData transform;
+	MoveData move;
+
+	mgrST.SetWorkersCount(0);
+	mgrMT.SetWorkersCount(4);
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandMoveData(enttsCount, move);
+
+	for (ECS::EntityManager* pMgr : { &mgrST, &mgrMT })
+	{
+		const std::vector<EntityID> ids = pMgr->CreateEntities(enttsCount);
+		pMgr->AddTransformComponent(ids, transform.positions, transform.dirQuats, transform.uniformScales);
+		pMgr->AddMoveComponent(ids, move.translations, move.rotQuats, move.uniformScales);
+
+		for (u32 i = 0; i < framesCount; ++i)
+			pMgr->Update(i * deltaTime, deltaTime);
+	}
+
+	const ECS::Transform& transST = mgrST.GetComponentTransform();
+	const ECS::Transform& transMT = mgrMT.GetComponentTransform();
+	const ECS::WorldMatrix& worldST = mgrST.GetComponentWorld();
+	const ECS::WorldMatrix& worldMT = mgrMT.GetComponentWorld();
+
+	const bool arePosEqual    = !memcmp(transST.posAndUniformScale_.data(), transMT.posAndUniformScale_.data(), sizeof(XMFLOAT4) * enttsCount);
+	const bool areDirsEqual   = !memcmp(transST.dirQuats_.data(), transMT.dirQuats_.data(), sizeof(XMVECTOR) * enttsCount);
+	const bool areWorldsEqual = !memcmp(worldST.worlds_.data(), worldMT.worlds_.data(), sizeof(XMMATRIX) * enttsCount);
+
+	Assert::True(arePosEqual && areDirsEqual && areWorldsEqual, "multi-threaded update of systems gives another result than the single-threaded one");
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+void TestSystems::BenchmarkFrustumCulling()
+{
+	// BENCHMARK: frustum culling of 10k / 100k / 1M boxes which are randomly
+	//            placed around the camera: the parallel SIMD test of SoA boxes vs.
+	//            the traversal of the BVH; for the smallest set we also check
+	//            the result against the plain (not SIMD) box/plane test
+
+	const u32 framesCount = 20;
+	const XMMATRIX view = XMMatrixLookAtLH({ 0,0,0 }, { 0,0,1 }, { 0,1,0 });
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 500.0f);
+	const XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+	ECS::ThreadPool pool;
+
+	for (const u32 boxesCount : { 10'000u, 100'000u, 1'000'000u })
+	{
+		ECS::Bounding bounding;
+		ECS::WorldMatrix world;
+		ECS::CullingSystem cullingSys(&bounding, &world);
+		std::vector<EntityID> ids(boxesCount);
+		std::vector<EntityID> visibleIDs;
+
+		// generate boxes in the cube [-500, 500]
+		for (u32 i = 0; i < boxesCount; ++i)
+		{
+			const XMFLOAT3 pos = { MathHelper::RandF(-500, 500), MathHelper::RandF(-500, 500), MathHelper::RandF(-500, 500) };
+			ids[i] = i + 1;
+
+			world.worlds_.push_back(XMMatrixRotationRollPitchYaw(MathHelper::RandF(0, XM_PI), 0, 0) * XMMatrixTranslation(pos.x, pos.y, pos.z));
+			bounding.data_.push_back(DirectX::BoundingBox({ 0,0,0 }, { 1,1,1 }));
+			bounding.types_.push_back(ECS::BoundingType::AABB);
+		}
+
+		world.ids_ = ids;
+		world.sparse_.Rebuild(ids);
+		bounding.ids_ = ids;
+		bounding.sparse_.Rebuild(ids);
+
+		cullingSys.RebuildWorldBoxes(ids, pool);
+
+		// warm up: allocate memory for the output
+		cullingSys.CullByFrustum(viewProj, pool, visibleIDs);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (u32 i = 0; i < framesCount; ++i)
+			cullingSys.CullByFrustum(viewProj, pool, visibleIDs);
+
+		auto end = std::chrono::steady_clock::now();
+		const double frameTimeMs = std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+
+		// the same culling by the BVH (the building time isn't counted)
+		std::vector<EntityID> bvhVisibleIDs;
+
+		cullingSys.EnableBVH(true);
+		cullingSys.CullByFrustumBVH(viewProj, bvhVisibleIDs);
+
+		start = std::chrono::steady_clock::now();
+
+		for (u32 i = 0; i < framesCount; ++i)
+			cullingSys.CullByFrustumBVH(viewProj, bvhVisibleIDs);
+
+		end = std::chrono::steady_clock::now();
+		const double bvhFrameTimeMs = std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+
+		cullingSys.EnableBVH(false);
+
+		Assert::True(bvhVisibleIDs.size() == visibleIDs.size(), "the BVH culling gives another number of visible entities");
+
+		Log::Print("\tfrustum culling (" + std::to_string(boxesCount) + " boxes, " + std::to_string(visibleIDs.size()) + " visible): "
+			"SoA (" + std::to_string(pool.GetWorkersCount()) + " workers): " + std::to_string(frameTimeMs) + " ms per frame; "
+			"BVH (1 thread): " + std::to_string(bvhFrameTimeMs) + " ms per frame");
+
+		if (boxesCount > 10'000u)
+			continue;
+
+		// check the result: the box is visible if it isn't behind any frustum plane
+		const XMMATRIX m = XMMatrixTranspose(viewProj);
+		const XMVECTOR planes[6] =
+		{
+			XMPlaneNormalize(m.r[3] + m.r[0]), XMPlaneNormalize(m.r[3] - m.r[0]),
+			XMPlaneNormalize(m.r[3] + m.r[1]), XMPlaneNormalize(m.r[3] - m.r[1]),
+			XMPlaneNormalize(m.r[2]),          XMPlaneNormalize(m.r[3] - m.r[2]),
+		};
+
+		std::vector<EntityID> expectedIDs;
+
+		for (u32 i = 0; i < boxesCount; ++i)
+		{
+			DirectX::BoundingBox worldBox;
+			bounding.data_[i].Transform(worldBox, world.worlds_[i]);
+
+			bool isVisible = true;
+
+			for (const XMVECTOR& plane : planes)
+			{
+				XMFLOAT4 p;
+				XMStoreFloat4(&p, plane);
+
+				const float dist = p.x * worldBox.Center.x + p.y * worldBox.Center.y + p.z * worldBox.Center.z + p.w;
+				const float radius = fabsf(p.x) * worldBox.Extents.x + fabsf(p.y) * worldBox.Extents.y + fabsf(p.z) * worldBox.Extents.z;
+
+				// compare with a small tolerance since boxes are computed in different ways
+				isVisible &= (dist + radius >= -0.001f);
+			}
+
+			if (isVisible)
+				expectedIDs.push_back(ids[i]);
+		}
+
+		Assert::True(ContainerCompare(visibleIDs, expectedIDs), "frustum culling gives a wrong set of visible entities");
+	}
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+void TestSystems::TestBVHQueries()
+{
+	// UNIT TEST: results of BVH queries (frustum, ray, sphere, box) must be the
+	//            same as results of brute force tests over all the boxes; then we
+	//            move a part of boxes (the BVH is refitted) and check it again
+
+	const u32 boxesCount = 5000;
+	const XMMATRIX view = XMMatrixLookAtLH({ 0,0,0 }, { 1,0,1 }, { 0,1,0 });
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 200.0f);
+	const XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+	ECS::ThreadPool pool(0);
+	ECS::Bounding bounding;
+	ECS::WorldMatrix world;
+	ECS::CullingSystem cullingSys(&bounding, &world);
+	std::vector<EntityID> ids(boxesCount);
+
+	for (u32 i = 0; i < boxesCount; ++i)
+	{
+		ids[i] = i + 1;
+		world.worlds_.push_back(XMMatrixTranslation(MathHelper::RandF(-200, 200), MathHelper::RandF(-50, 50), MathHelper::RandF(-200, 200)));
+		bounding.data_.push_back(DirectX::BoundingBox({ 0,0,0 }, { MathHelper::RandF(0.5f, 4), 1, 1 }));
+		bounding.types_.push_back(ECS::BoundingType::AABB);
+	}
+
+	world.ids_ = ids;
+	world.sparse_.Rebuild(ids);
+	bounding.ids_ = ids;
+	bounding.sparse_.Rebuild(ids);
+
+	cullingSys.RebuildWorldBoxes(ids, pool);
+	cullingSys.EnableBVH(true);
+
+	std::vector<EntityID> movedIDs;
+
+	for (u32 i = 0; i < boxesCount; i += 3)
+		movedIDs.push_back(ids[i]);
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		std::vector<EntityID> linearResult;
+		std::vector<EntityID> bvhResult;
+		std::vector<EntityID> expected;
+
+		// frustum culling
+		cullingSys.CullByFrustum(viewProj, pool, linearResult);
+		cullingSys.CullByFrustumBVH(viewProj, bvhResult);
+		std::sort(bvhResult.begin(), bvhResult.end());
+
+		Assert::True(ContainerCompare(bvhResult, linearResult), "BVH frustum culling gives a wrong set of entities");
+
+		// sphere and box overlaps
+		const DirectX::BoundingSphere sphere({ 10, 0, 10 }, 40);
+		const DirectX::BoundingBox box({ -50, 0, 20 }, { 30, 10, 30 });
+
+		for (const EntityID id : ids)
+		{
+			DirectX::BoundingBox worldBox;
+			bounding.data_[id - 1].Transform(worldBox, world.worlds_[id - 1]);
+
+			if (worldBox.Intersects(sphere))
+				expected.push_back(id);
+		}
+
+		cullingSys.QuerySphere(sphere, bvhResult);
+		std::sort(bvhResult.begin(), bvhResult.end());
+		Assert::True(ContainerCompare(bvhResult, expected), "BVH sphere query gives a wrong set of entities");
+
+		expected.clear();
+
+		for (const EntityID id : ids)
+		{
+			DirectX::BoundingBox worldBox;
+			bounding.data_[id - 1].Transform(worldBox, world.worlds_[id - 1]);
+
+			if (worldBox.Intersects(box))
+				expected.push_back(id);
+		}
+
+		cullingSys.QueryBox(box, bvhResult);
+		std::sort(bvhResult.begin(), bvhResult.end());
+		Assert::True(ContainerCompare(bvhResult, expected), "BVH box query gives a wrong set of entities");
+
+		// ray picking: the nearest hit must be the same as the nearest one of all the boxes
+		const XMVECTOR rayOrigin = { 0, 0, 0 };
+		const XMVECTOR rayDir = XMVector3Normalize({ 1, 0.01f, 1.2f });
+		float nearestDist = FLT_MAX;
+
+		for (const EntityID id : ids)
+		{
+			DirectX::BoundingBox worldBox;
+			float dist = 0;
+			bounding.data_[id - 1].Transform(worldBox, world.worlds_[id - 1]);
+
+			// NOTE: the distance is negative if the ray origin is inside the box
+			if (worldBox.Intersects(rayOrigin, rayDir, dist))
+				nearestDist = std::min(nearestDist, std::max(dist, 0.0f));
+		}
+
+		EntityID pickedID = INVALID_ENTITY_ID;
+		float pickedDist = 0;
+		const bool isPicked = cullingSys.RayCast(rayOrigin, rayDir, pickedID, pickedDist);
+
+		Assert::True(isPicked == (nearestDist != FLT_MAX), "BVH ray cast gives a wrong result");
+		Assert::True(!isPicked || (fabsf(pickedDist - nearestDist) < 0.001f), "BVH ray cast didn't find the nearest entity");
+
+		const ECS::BVHStats& stats = cullingSys.GetBVH().GetStats();
+		Log::Print("\tBVH (pass " + std::to_string(pass) + "): visited nodes: " + std::to_string(stats.nodesVisited) +
+			"; tested leaves: " + std::to_string(stats.leavesTested) +
+			"; refits: " + std::to_string(stats.refitsCount) +
+			"; rebuilds: " + std::to_string(stats.rebuildsCount));
+
+		cullingSys.GetBVH().ResetStats();
+
+		// move a part of boxes so the BVH is refitted
+		for (const EntityID id : movedIDs)
+			world.worlds_[id - 1] *= XMMatrixTranslation(MathHelper::RandF(-20, 20), 0, MathHelper::RandF(-20, 20));
+
+		cullingSys.UpdateWorldBoxes(movedIDs, pool);
+	}
+
+	// axis-parallel rays whose origin lies right on planes of slabs of a box
+	// (zero components of the direction mustn't give NaN in the slab test)
+	ECS::BVH bvh;
+	bvh.Build({ 1 }, { DirectX::BoundingBox({ 0,0,0 }, { 1,1,1 }) });
+
+	EntityID hitID = INVALID_ENTITY_ID;
+	float hitDist = 0;
+
+	Assert::True(bvh.RayCast({ -5, 1, 0 }, { 1, 0, 0 }, hitID, hitDist) && (hitID == 1) && (fabsf(hitDist - 4) < 0.001f), "BVH ray cast: a ray along the face of the box is missed");
+	Assert::True(bvh.RayCast({ 1, -1, -5 }, { 0, 0, 1 }, hitID, hitDist) && (fabsf(hitDist - 4) < 0.001f), "BVH ray cast: a ray along the edge of the box is missed");
+	Assert::True(!bvh.RayCast({ -5, 1.001f, 0 }, { 1, 0, 0 }, hitID, hitDist), "BVH ray cast: a ray outside the box hits it");
+	Assert::True(!bvh.RayCast({ 5, 0, 0 }, { 1, 0, 0 }, hitID, hitDist), "BVH ray cast: a ray which goes away from the box hits it");
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+void TestSystems::BenchmarkInstancesCache()
+{
+	// BENCHMARK: per-frame preparing of instances data for 10k static and 1k dynamic
+	//            entities: full gathering of data (as it was made each frame before)
+	//            vs. the persistent cache where only moved instances are patched;
+	//            we also check that the patched data is the same as the gathered one;
+	//            then the visible subset is changed each frame (as when the camera moves):
+	//            the bucket mustn't be rebuilt, only its list of visible instances
+
+	const u32 staticEnttsCount = 10000;
+	const u32 dynamicEnttsCount = 1000;
+	const u32 enttsCount = staticEnttsCount + dynamicEnttsCount;
+	const u32 meshesCount = 10;
+	const u32 framesCount = 100;
+	const float deltaTime = 0.016f;
+
+	ECS::EntityManager mgr;
+	TransformData transform;
+	MoveData move;
+
+	const std::vector<EntityID> ids = mgr.CreateEntities(enttsCount);
+	const std::vector<EntityID> dynamicIDs(ids.end() - dynamicEnttsCount, ids.end());
+
+	GetRandTransformData(enttsCount, transform);
+	GetRandMoveData(dynamicEnttsCount, move);
+
+	mgr.AddTransformComponent(ids, transform.positions, transform.dirQuats, transform.uniformScales);
+	mgr.AddMoveComponent(dynamicIDs, move.translations, move.rotQuats, move.uniformScales);
+
+	// each entity has one of a few meshes
+	for (u32 i = 0; i < enttsCount; ++i)
+		mgr.AddMeshComponent(ids[i], (MeshID)(1 + i % meshesCount));
+
+	// ---------------------------------------------
+
+	// full gathering of data each frame
+	std::vector<MeshID> meshesIDs;
+	std::vector<EntityID> enttsSortedByMeshes;
+	std::vector<ptrdiff_t> numInstancesPerMesh;
+	std::vector<XMMATRIX> worlds;
+	std::vector<XMMATRIX> texTransforms;
+
+	double gatherTimeMs = 0;
+	double cacheTimeMs = 0;
+
+	const ECS::InstancesBucket& bucket = mgr.UpdateInstancesBucket(ECS::BUCKET_DEFAULT_STATES, ids, ids);
+	const u32 bucketVersion = bucket.version_;
+
+	for (u32 i = 0; i < framesCount; ++i)
+	{
+		mgr.Update(i * deltaTime, deltaTime);
+
+		auto start = std::chrono::steady_clock::now();
+
+		meshesIDs.clear();
+		enttsSortedByMeshes.clear();
+		numInstancesPerMesh.clear();
+		worlds.clear();
+		texTransforms.clear();
+
+		mgr.meshSystem_.GetMeshesIDsRelatedToEntts(ids, meshesIDs, enttsSortedByMeshes, numInstancesPerMesh);
+		mgr.transformSystem_.GetWorldMatricesOfEntts(enttsSortedByMeshes, worlds);
+		mgr.texTransformSystem_.GetTexTransformsForEntts(enttsSortedByMeshes, texTransforms);
+
+		auto end = std::chrono::steady_clock::now();
+		gatherTimeMs += std::chrono::duration<double, std::milli>(end - start).count();
+
+		start = std::chrono::steady_clock::now();
+		mgr.UpdateInstancesBucket(ECS::BUCKET_DEFAULT_STATES, ids, ids);
+		end = std::chrono::steady_clock::now();
+
+		cacheTimeMs += std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	Log::Print("\tinstances data (" + std::to_string(staticEnttsCount) + " static + " + std::to_string(dynamicEnttsCount) + " dynamic entts):");
+	Log::Print("\t\tfull gathering: " + std::to_string(gatherTimeMs / framesCount) + " ms per frame");
+	Log::Print("\t\tcached:         " + std::to_string(cacheTimeMs / framesCount) + " ms per frame");
+
+	// ---------------------------------------------
+
+	// check the result: the set of entities is the same so the bucket mustn't be rebuilt
+	// and only instances of moved entities are patched
+	Assert::True(bucket.version_ == bucketVersion, "the bucket was rebuilt but the set of entities wasn't changed");
+	Assert::True(std::ssize(bucket.patchedInstances_) <= (size)dynamicEnttsCount, "too many instances were patched");
+	Assert::True(bucket.meshesIDs_ == meshesIDs, "wrong meshes of instances");
+	Assert::True(bucket.instancesEntts_ == enttsSortedByMeshes, "wrong order of instances");
+
+	for (size i = 0; i < std::ssize(worlds); ++i)
+	{
+		const bool isEqual = (memcmp(&bucket.worlds_[i], &worlds[i], sizeof(XMMATRIX)) == 0);
+		Assert::True(isEqual, "wrong world matrix of instance: " + std::to_string(i));
+	}
+
+	// ---------------------------------------------
+
+	// a half of entities is visible and the visible window is shifted each frame
+	const u32 visibleCount = enttsCount / 2;
+	const u32 windowStep = 100;
+	std::vector<EntityID> visibleIDs;
+
+	double visibleGatherTimeMs = 0;
+	double visibleCacheTimeMs = 0;
+
+	for (u32 i = 0; i < framesCount; ++i)
+	{
+		const u32 windowBegin = (i * windowStep) % (enttsCount - visibleCount);
+		visibleIDs.assign(ids.begin() + windowBegin, ids.begin() + windowBegin + visibleCount);
+
+		mgr.Update(i * deltaTime, deltaTime);
+
+		auto start = std::chrono::steady_clock::now();
+
+		meshesIDs.clear();
+		enttsSortedByMeshes.clear();
+		numInstancesPerMesh.clear();
+		worlds.clear();
+		texTransforms.clear();
+
+		mgr.meshSystem_.GetMeshesIDsRelatedToEntts(visibleIDs, meshesIDs, enttsSortedByMeshes, numInstancesPerMesh);
+		mgr.transformSystem_.GetWorldMatricesOfEntts(enttsSortedByMeshes, worlds);
+		mgr.texTransformSystem_.GetTexTransformsForEntts(enttsSortedByMeshes, texTransforms);
+
+		auto end = std::chrono::steady_clock::now();
+		visibleGatherTimeMs += std::chrono::duration<double, std::milli>(end - start).count();
+
+		start = std::chrono::steady_clock::now();
+		mgr.UpdateInstancesBucket(ECS::BUCKET_DEFAULT_STATES, ids, visibleIDs);
+		end = std::chrono::steady_clock::now();
+
+		visibleCacheTimeMs += std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	Log::Print("\tinstances data (" + std::to_string(visibleCount) + " visible entts, the visible set is changed each frame):");
+	Log::Print("\t\tfull gathering: " + std::to_string(visibleGatherTimeMs / framesCount) + " ms per frame");
+	Log::Print("\t\tcached:         " + std::to_string(visibleCacheTimeMs / framesCount) + " ms per frame");
+
+	// check the result: the bucket isn't rebuilt and its visible instances
+	// are the same as instances which are gathered for visible entts
+	Assert::True(bucket.version_ == bucketVersion, "the bucket was rebuilt but only the visible set was changed");
+	Assert::True(std::ssize(bucket.visibleInstances_) == std::ssize(enttsSortedByMeshes), "wrong number of visible instances");
+
+	for (size i = 0; i < std::ssize(enttsSortedByMeshes); ++i)
+	{
+		const u32 idx = bucket.visibleInstances_[i];
+		const bool isEqual = (memcmp(&bucket.worlds_[idx], &worlds[i], sizeof(XMMATRIX)) == 0);
+
+		Assert::True(bucket.instancesEntts_[idx] == enttsSortedByMeshes[i], "wrong visible instance: " + std::to_string(i));
+		Assert::True(isEqual, "wrong world matrix of visible instance: " + std::to_string(i));
+	}
+
+	// meshes without visible instances are skipped by the full gathering
+	std::vector<ptrdiff_t> numVisiblePerMesh;
+
+	for (const size count : bucket.numVisibleInstancesPerMesh_)
+	{
+		if (count > 0)
+			numVisiblePerMesh.push_back(count);
+	}
+
+	Assert::True(numVisiblePerMesh == numInstancesPerMesh, "wrong number of visible instances per mesh");
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+void TestSystems::BenchmarkLightClusters()
+{
+	// BENCHMARK: clustered assignment of 1k / 10k point and spot lights which are
+	//            randomly placed in front of the camera (1 thread vs. the pool);
+	//            for the smallest set we also check the result against the plain
+	//            test of each light against each cluster
+
+	const u32 framesCount = 20;
+	const XMMATRIX view = XMMatrixLookAtLH({ 0,0,0 }, { 0,0,1 }, { 0,1,0 });
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 1.0f, 500.0f);
+
+	ECS::ThreadPool singleThreadPool(0);
+	ECS::ThreadPool pool;
+
+	for (const u32 lightsCount : { 1'000u, 10'000u })
+	{
+		ECS::PointLights pointLights;
+		ECS::SpotLights spotLights;
+
+		// each 4th light is a spot light
+		for (u32 i = 0; i < lightsCount; ++i)
+		{
+			const XMFLOAT3 pos   = { MathHelper::RandF(-200, 200), MathHelper::RandF(-50, 50), MathHelper::RandF(-20, 400) };
+			const float    range = MathHelper::RandF(1, 20);
+
+			if (i % 4)
+			{
+				ECS::PointLight light;
+				light.position_ = pos;
+				light.range_    = range;
+				pointLights.data_.push_back(light);
+			}
+			else
+			{
+				ECS::SpotLight light;
+				light.position_ = pos;
+				light.range_    = range;
+				light.spot_     = MathHelper::RandF(0, 64);
+
+				XMStoreFloat3(&light.direction_, XMVector3Normalize({ MathHelper::RandF(-1, 1), MathHelper::RandF(-1, 1), MathHelper::RandF(-1, 1) }));
+				spotLights.data_.push_back(light);
+			}
+		}
+
+		ECS::LightClusters clusters;
+		ECS::LightClusters clustersMT;
+		double frameTimeMs[2] = { 0, 0 };
+		ECS::LightClusters* pClusters[2] = { &clusters, &clustersMT };
+		ECS::ThreadPool* pPools[2] = { &singleThreadPool, &pool };
+
+		for (u32 i = 0; i < 2; ++i)
+		{
+			// warm up: allocate memory for the output
+			pClusters[i]->Build(view, proj, pointLights, spotLights, *pPools[i]);
+
+			const auto start = std::chrono::steady_clock::now();
+
+			for (u32 frame = 0; frame < framesCount; ++frame)
+				pClusters[i]->Build(view, proj, pointLights, spotLights, *pPools[i]);
+
+			const auto end = std::chrono::steady_clock::now();
+			frameTimeMs[i] = std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+		}
+
+		Log::Print("\tlight clusters (" + std::to_string(lightsCount) + " lights, " + std::to_string(clusters.GetLightIdxs().size()) + " light-cluster pairs):");
+		Log::Print("\t\t1 thread:              " + std::to_string(frameTimeMs[0]) + " ms per frame");
+		Log::Print("\t\tthe pool (" + std::to_string(pool.GetWorkersCount()) + " workers): " + std::to_string(frameTimeMs[1]) + " ms per frame");
+
+		Assert::True(
+			(clusters.GetLightIdxs()   == clustersMT.GetLightIdxs()) &&
+			(clusters.GetOffsets()     == clustersMT.GetOffsets()) &&
+			(clusters.GetPointCounts() == clustersMT.GetPointCounts()) &&
+			(clusters.GetSpotCounts()  == clustersMT.GetSpotCounts()),
+			"the result of light clustering depends on the number of threads");
+
+		if (lightsCount > 1'000u)
+			continue;
+
+		// check the result: a light is in the cluster if its sphere intersects the cluster AABB
+		// and (for spot lights) its cone intersects the bounding sphere of the AABB;
+		// the view matrix is identity so view space is the same as world space;
+		// lights which are near the border (by a small tolerance) can be either in or out
+		const float eps = 0.01f;
+		const std::vector<u32>& lightIdxs = clusters.GetLightIdxs();
+		std::vector<u32> visiblePointLights;
+		std::vector<u32> visibleSpotLights;
+
+		for (u32 z = 0; z < ECS::LightClusters::SLICES_Z; ++z)
+		{
+			for (u32 y = 0; y < ECS::LightClusters::TILES_Y; ++y)
+			{
+				for (u32 x = 0; x < ECS::LightClusters::TILES_X; ++x)
+				{
+					const u32 clusterIdx   = ECS::LightClusters::GetClusterIdx(x, y, z);
+					const u32* pointsBegin = lightIdxs.data() + clusters.GetOffsets()[clusterIdx];
+					const u32* pointsEnd   = pointsBegin + clusters.GetPointCounts()[clusterIdx];
+					const u32* spotsEnd    = pointsEnd + clusters.GetSpotCounts()[clusterIdx];
+
+					const DirectX::BoundingBox box = clusters.GetClusterBox(x, y, z);
+					const XMVECTOR boxMin = XMLoadFloat3(&box.Center) - XMLoadFloat3(&box.Extents);
+					const XMVECTOR boxMax = XMLoadFloat3(&box.Center) + XMLoadFloat3(&box.Extents);
+					const float boxRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&box.Extents)));
+
+					visiblePointLights.insert(visiblePointLights.end(), pointsBegin, pointsEnd);
+					visibleSpotLights.insert(visibleSpotLights.end(), pointsEnd, spotsEnd);
+
+					for (size i = 0; i < pointLights.GetCount() + spotLights.GetCount(); ++i)
+					{
+						const bool isPoint = (i < pointLights.GetCount());
+						const u32  idx     = (u32)(isPoint ? i : i - pointLights.GetCount());
+
+						const XMFLOAT3& pos = (isPoint) ? pointLights.data_[idx].position_ : spotLights.data_[idx].position_;
+						const float range   = (isPoint) ? pointLights.data_[idx].range_    : spotLights.data_[idx].range_;
+						const XMVECTOR center = XMLoadFloat3(&pos);
+
+						// the distance from the sphere center to the box
+						const XMVECTOR closest = XMVectorClamp(center, boxMin, boxMax);
+						float margin = range - XMVectorGetX(XMVector3Length(center - closest));
+
+						if (!isPoint && (spotLights.data_[idx].spot_ > 0))
+						{
+							const float cosA = powf(ECS::LightClusters::SPOT_CUTOFF, 1.0f / spotLights.data_[idx].spot_);
+							const float sinA = sqrtf(1.0f - cosA * cosA);
+							const XMVECTOR v = XMLoadFloat3(&box.Center) - center;
+							const float v1   = XMVectorGetX(XMVector3Dot(v, XMLoadFloat3(&spotLights.data_[idx].direction_)));
+							const float v2   = XMVectorGetX(XMVector3LengthSq(v)) - v1 * v1;
+							const float sideDist = cosA * sqrtf(std::max(v2, 0.0f)) - v1 * sinA;
+
+							margin = std::min({ margin, boxRadius - sideDist, boxRadius + range - v1, v1 + boxRadius });
+						}
+
+						const bool isInCluster = (isPoint) ?
+							std::binary_search(pointsBegin, pointsEnd, idx) :
+							std::binary_search(pointsEnd, spotsEnd, idx);
+
+						Assert::True(isInCluster ? (margin > -eps) : (margin < eps),
+							"wrong light " + std::to_string(i) + " in the cluster " + std::to_string(clusterIdx));
+					}
+				}
+			}
+		}
+
+		// lights which are in some cluster
+		std::sort(visiblePointLights.begin(), visiblePointLights.end());
+		std::sort(visibleSpotLights.begin(), visibleSpotLights.end());
+		visiblePointLights.erase(std::unique(visiblePointLights.begin(), visiblePointLights.end()), visiblePointLights.end());
+		visibleSpotLights.erase(std::unique(visibleSpotLights.begin(), visibleSpotLights.end()), visibleSpotLights.end());
+
+		Assert::True(visiblePointLights == clusters.GetVisiblePointLights(), "wrong visible point lights");
+		Assert::True(visibleSpotLights == clusters.GetVisibleSpotLights(), "wrong visible spot lights");
+	}
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+static void ComputeEnttLightsBruteForce(
+	const DirectX::BoundingBox& box,
+	const ECS::Light& light,
+	ECS::EnttLights& outLights)
+{
+	// compute the relevance of each light and sort lights by it: this is what
+	// the LightInfluenceSystem computes using SIMD tests and insertions into lists
+
+	std::vector<std::pair<float, u32>> pointLights;
+	std::vector<std::pair<float, u32>> spotLights;
+
+	const u32 pointLightsCount = (u32)light.pointLights_.GetCount();
+	const u32 spotLightsCount  = (u32)light.spotLights_.GetCount();
+
+	for (u32 i = 0; i < pointLightsCount + spotLightsCount; ++i)
+	{
+		const bool isPoint = (i < pointLightsCount);
+		const u32  idx     = (isPoint) ? i : i - pointLightsCount;
+
+		const XMFLOAT3& pos  = (isPoint) ? light.pointLights_.data_[idx].position_ : light.spotLights_.data_[idx].position_;
+		const XMFLOAT3& att  = (isPoint) ? light.pointLights_.data_[idx].att_      : light.spotLights_.data_[idx].att_;
+		const XMFLOAT4& diff = (isPoint) ? light.pointLights_.data_[idx].diffuse_  : light.spotLights_.data_[idx].diffuse_;
+		const float range    = (isPoint) ? light.pointLights_.data_[idx].range_    : light.spotLights_.data_[idx].range_;
+
+		const float dx = std::max(fabsf(pos.x - box.Center.x) - box.Extents.x, 0.0f);
+		const float dy = std::max(fabsf(pos.y - box.Center.y) - box.Extents.y, 0.0f);
+		const float dz = std::max(fabsf(pos.z - box.Center.z) - box.Extents.z, 0.0f);
+		const float distSq = dx*dx + dy*dy + dz*dz;
+
+		if (distSq > range * range)
+			continue;
+
+		if (!isPoint && (light.spotLights_.data_[idx].spot_ > 0))
+		{
+			const ECS::SpotLight& spot = light.spotLights_.data_[idx];
+			const float cosCone   = powf(ECS::LightClusters::SPOT_CUTOFF, 1.0f / spot.spot_);
+			const XMVECTOR toBox  = XMLoadFloat3(&box.Center) - XMLoadFloat3(&pos);
+			const float dist      = XMVectorGetX(XMVector3Length(toBox));
+			const float boxRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&box.Extents)));
+
+			if (dist > boxRadius)
+			{
+				const float cosAngle = XMVectorGetX(XMVector3Dot(toBox, XMVector3Normalize(XMLoadFloat3(&spot.direction_)))) / dist;
+
+				if (acosf(std::clamp(cosAngle, -1.0f, 1.0f)) - asinf(boxRadius / dist) > acosf(cosCone))
+					continue;
+			}
+		}
+
+		const float d = sqrtf(distSq);
+		const float attenuation = ((att.x) ? (1.0f / att.x) : 0.0f) + ((att.y) ? (1.0f / att.y) : 0.0f) * d + ((att.z) ? (1.0f / att.z) : 0.0f) * d*d;
+		const float relevance = std::max({ diff.x, diff.y, diff.z }) / ((attenuation > 0) ? attenuation : 1.0f);
+
+		if (isPoint)
+			pointLights.push_back({ relevance, idx });
+		else
+			spotLights.push_back({ relevance, idx });
+	}
+
+	const auto isMoreRelevant = [](const std::pair<float, u32>& a, const std::pair<float, u32>& b) { return a.first > b.first; };
+	std::stable_sort(pointLights.begin(), pointLights.end(), isMoreRelevant);
+	std::stable_sort(spotLights.begin(), spotLights.end(), isMoreRelevant);
+
+	outLights.pointLightsCount = std::min((u32)pointLights.size(), ECS::EnttLights::MAX_POINT_LIGHTS);
+	outLights.spotLightsCount  = std::min((u32)spotLights.size(), ECS::EnttLights::MAX_SPOT_LIGHTS);
+
+	for (u32 i = 0; i < outLights.pointLightsCount; ++i)
+		outLights.pointLights[i] = pointLights[i].second;
+
+	for (u32 i = 0; i < outLights.spotLightsCount; ++i)
+		outLights.spotLights[i] = spotLights[i].second;
+}
+
+///////////////////////////////////////////////////////////
+
+void TestSystems::TestLightInfluence()
+{
+	// UNIT TEST: lists of the most relevant lights of visible entts must be the same as
+	//            lists which are computed by the plain test of each light; lists must be
+	//            recomputed only for new entts, moved entts and entts near moved lights
+
+	const u32 enttsCount       = 4000;
+	const u32 pointLightsCount = 64;
+	const u32 spotLightsCount  = 8;
+
+	ECS::ThreadPool pool;
+	ECS::Bounding bounding;
+	ECS::WorldMatrix world;
+	ECS::Light light;
+	ECS::CullingSystem cullingSys(&bounding, &world);
+	ECS::LightInfluenceSystem lightInfluenceSys(&light, &cullingSys);
+	std::vector<EntityID> ids(enttsCount);
+	std::vector<EntityID> visibleIDs;
+
+	for (u32 i = 0; i < enttsCount; ++i)
+	{
+		ids[i] = i + 1;
+		world.worlds_.push_back(XMMatrixTranslation(MathHelper::RandF(-100, 100), MathHelper::RandF(-5, 5), MathHelper::RandF(-100, 100)));
+		bounding.data_.push_back(DirectX::BoundingBox({ 0,0,0 }, { MathHelper::RandF(0.5f, 3), 1, MathHelper::RandF(0.5f, 3) }));
+		bounding.types_.push_back(ECS::BoundingType::AABB);
+
+		// only a half of entts is visible
+		if (i % 2)
+			visibleIDs.push_back(ids[i]);
+	}
+
+	world.ids_ = ids;
+	world.sparse_.Rebuild(ids);
+	bounding.ids_ = ids;
+	bounding.sparse_.Rebuild(ids);
+
+	cullingSys.RebuildWorldBoxes(ids, pool);
+	cullingSys.EnableBVH(true);
+
+	for (u32 i = 0; i < pointLightsCount; ++i)
+	{
+		light.pointLights_.data_.push_back(ECS::PointLight(
+			{ 0,0,0,1 },
+			{ MathHelper::RandF(0, 1), MathHelper::RandF(0, 1), MathHelper::RandF(0, 1), 1 },
+			{ 0,0,0,1 },
+			{ MathHelper::RandF(-100, 100), MathHelper::RandF(-5, 5), MathHelper::RandF(-100, 100) },
+			MathHelper::RandF(5, 30),
+			{ 1, MathHelper::RandF(0, 0.5f), MathHelper::RandF(0, 0.1f) }));
+	}
+
+	for (u32 i = 0; i < spotLightsCount; ++i)
+	{
+		XMFLOAT3 dir;
+		XMStoreFloat3(&dir, XMVector3Normalize({ MathHelper::RandF(-1, 1), MathHelper::RandF(-1, 0), MathHelper::RandF(-1, 1) }));
+
+		light.spotLights_.data_.push_back(ECS::SpotLight(
+			{ 0,0,0,1 },
+			{ 1,1,1,1 },
+			{ 0,0,0,1 },
+			{ MathHelper::RandF(-100, 100), 10, MathHelper::RandF(-100, 100) },
+			MathHelper::RandF(20, 50),
+			dir,
+			MathHelper::RandF(1, 64),
+			{ 1, 0.1f, 0.01f }));
+	}
+
+	const auto checkLists = [&]()
+	{
+		for (const EntityID id : visibleIDs)
+		{
+			DirectX::BoundingBox box;
+			ECS::EnttLights expected;
+
+			cullingSys.GetWorldBoxByID(id, box);
+			ComputeEnttLightsBruteForce(box, light, expected);
+
+			Assert::True(memcmp(&expected, &lightInfluenceSys.GetEnttLights(id), sizeof(ECS::EnttLights)) == 0,
+				"wrong list of lights of the entity: " + std::to_string(id));
+		}
+	};
+
+	// the first update: all the visible entts are new
+	lightInfluenceSys.Update(visibleIDs, {}, true, pool);
+	checkLists();
+
+	Assert::True(lightInfluenceSys.GetRecomputedCount() == std::ssize(visibleIDs), "lists of all visible entts must be computed");
+
+	// nothing is changed
+	lightInfluenceSys.Update(visibleIDs, {}, false, pool);
+	Assert::True(lightInfluenceSys.GetRecomputedCount() == 0, "lists are recomputed for a static scene");
+	Assert::True(lightInfluenceSys.GetChangedEntts().empty(), "lists are changed for a static scene");
+
+	// move a point light: only visible entts which are touched by its old or new sphere are recomputed
+	ECS::PointLight& movedLight = light.pointLights_.data_[0];
+	std::vector<EntityID> touchedIDs;
+	std::vector<EntityID> queried;
+
+	cullingSys.QuerySphere(DirectX::BoundingSphere(movedLight.position_, movedLight.range_), queried);
+	touchedIDs.insert(touchedIDs.end(), queried.begin(), queried.end());
+
+	movedLight.position_.x += 20;
+
+	cullingSys.QuerySphere(DirectX::BoundingSphere(movedLight.position_, movedLight.range_), queried);
+	touchedIDs.insert(touchedIDs.end(), queried.begin(), queried.end());
+
+	std::sort(touchedIDs.begin(), touchedIDs.end());
+	touchedIDs.erase(std::unique(touchedIDs.begin(), touchedIDs.end()), touchedIDs.end());
+
+	const size touchedVisibleCount = std::count_if(touchedIDs.begin(), touchedIDs.end(), [](const EntityID id) { return (id - 1) % 2; });
+
+	lightInfluenceSys.Update(visibleIDs, {}, false, pool);
+	checkLists();
+
+	Assert::True(lightInfluenceSys.GetRecomputedCount() == touchedVisibleCount, "wrong number of recomputed lists after moving of a light");
+	Log::Print("\tmoved light: recomputed " + std::to_string(touchedVisibleCount) + " of " + std::to_string(visibleIDs.size()) + " lists");
+
+	// move a few visible entts (their world boxes are updated as by the frame update)
+	std::vector<EntityID> movedIDs;
+
+	for (u32 i = 0; i < 100; ++i)
+	{
+		const EntityID id = visibleIDs[i * 7];
+
+		world.worlds_[id - 1] *= XMMatrixTranslation(MathHelper::RandF(-20, 20), 0, MathHelper::RandF(-20, 20));
+		movedIDs.push_back(id);
+	}
+
+	cullingSys.UpdateWorldBoxes(movedIDs, pool);
+	lightInfluenceSys.Update(visibleIDs, movedIDs, false, pool);
+	checkLists();
+
+	Assert::True(lightInfluenceSys.GetRecomputedCount() == std::ssize(movedIDs), "wrong number of recomputed lists after moving of entts");
+
+	// invisible entts become visible
+	lightInfluenceSys.Update(ids, {}, false, pool);
+	visibleIDs = ids;
+	checkLists();
+
+	Assert::True(lightInfluenceSys.GetRecomputedCount() == enttsCount / 2, "lists of new visible entts must be computed");
+
+	// change a single light without the BVH (as it is by default in the EntityManager):
+	// only lists of entts touched by its old or new sphere must be recomputed
+	cullingSys.EnableBVH(false);
+
+	ECS::PointLight& changedLight = light.pointLights_.data_[1];
+	const DirectX::BoundingSphere oldSphere(changedLight.position_, changedLight.range_);
+
+	changedLight.position_.z += 15;
+	const DirectX::BoundingSphere newSphere(changedLight.position_, changedLight.range_);
+
+	size touchedCount = 0;
+
+	for (const EntityID id : visibleIDs)
+	{
+		DirectX::BoundingBox box;
+		cullingSys.GetWorldBoxByID(id, box);
+
+		if (box.Intersects(oldSphere) || box.Intersects(newSphere))
+			++touchedCount;
+	}
+
+	lightInfluenceSys.Update(visibleIDs, {}, false, pool);
+	checkLists();
+
+	Assert::True(touchedCount < std::ssize(visibleIDs), "the changed light touches all the entts");
+	Assert::True(lightInfluenceSys.GetRecomputedCount() == touchedCount, "wrong number of recomputed lists after changing of a light without the BVH");
+	Log::Print("\tchanged light (no BVH): recomputed " + std::to_string(touchedCount) + " of " + std::to_string(visibleIDs.size()) + " lists");
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
+void TestSystems::BenchmarkLightAnimations()
+{
+	// BENCHMARK: animation of 10k point lights: setting of each light by its ID
+	//            vs. the batched animation by data idxs; then we check values of
+	//            curves, dirty ranges and animations after removing of a light
+
+	const u32 lightsCount = 10'000;
+	const u32 framesCount = 100;
+	const float eps = 0.001f;
+
+	ECS::Light light;
+	ECS::LightSystem lightSys(&light);
+	ECS::PointLightsInitParams params;
+	std::vector<EntityID> ids(lightsCount);
+
+	for (u32 i = 0; i < lightsCount; ++i)
+	{
+		ids[i] = i + 1;
+		params.ambients.push_back({ 0,0,0,1 });
+		params.diffuses.push_back({ MathHelper::RandF(0, 1), MathHelper::RandF(0, 1), MathHelper::RandF(0, 1), 1 });
+		params.speculars.push_back({ 0.5f, 0.5f, 0.5f, 1 });
+		params.positions.push_back({ MathHelper::RandF(-100, 100), 5, MathHelper::RandF(-100, 100) });
+		params.attenuations.push_back({ 1, 0.1f, 0.01f });
+		params.ranges.push_back(MathHelper::RandF(5, 30));
+	}
+
+	lightSys.AddPointLights(ids, params);
+
+	// each light has one of curves
+	std::vector<ECS::LightAnimParams> animsParams(lightsCount);
+
+	for (u32 i = 0; i < lightsCount; ++i)
+	{
+		ECS::LightAnimParams& anim = animsParams[i];
+
+		anim.type      = (ECS::LightAnimType)(i % 3);
+		anim.center    = params.positions[i];
+		anim.radius    = MathHelper::RandF(1, 10);
+		anim.speed     = MathHelper::RandF(0.5f, 10);
+		anim.phase     = MathHelper::RandF(0, XM_2PI);
+		anim.amplitude = MathHelper::RandF(0, 0.5f);
+
+		lightSys.AddPointLightAnimation(ids[i], anim);
+	}
+
+	// setting of positions by IDs (each call looks for the light by its ID)
+	auto start = std::chrono::steady_clock::now();
+
+	for (u32 frame = 0; frame < framesCount; ++frame)
+	{
+		const float time = frame * 0.016f;
+
+		for (u32 i = 0; i < lightsCount; ++i)
+		{
+			const ECS::LightAnimParams& anim = animsParams[i];
+			const float angle = anim.speed * time + anim.phase;
+			const XMFLOAT3 pos = { anim.center.x + anim.radius * cosf(angle), anim.center.y, anim.center.z + anim.radius * sinf(angle) };
+
+			lightSys.SetPointLightProp(ids[i], ECS::LightProps::POSITION, pos);
+		}
+	}
+
+	const double byIDsTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / framesCount;
+
+	// batched animation
+	start = std::chrono::steady_clock::now();
+
+	for (u32 frame = 0; frame < framesCount; ++frame)
+		lightSys.UpdateAnimations(frame * 0.016f);
+
+	const double batchedTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / framesCount;
+
+	Log::Print("\tlight animations (" + std::to_string(lightsCount) + " lights): by IDs: " + std::to_string(byIDsTimeMs) +
+		" ms; batched: " + std::to_string(batchedTimeMs) + " ms per frame");
+
+	// check values of curves
+	const float time = 12.3f;
+	const ECS::PointLights& lights = lightSys.GetPointLights();
+
+	lightSys.ResetDirtyRanges();
+	lightSys.UpdateAnimations(time);
+
+	const ECS::LightsDirtyRange& range = lightSys.GetDirtyRange(ECS::LightTypes::POINT);
+	Assert::True((range.begin == 0) && (range.end == lightsCount), "wrong dirty range of animated lights");
+
+	for (u32 i = 0; i < lightsCount; ++i)
+	{
+		const ECS::LightAnimParams& anim = animsParams[i];
+		const ECS::PointLight& pointLight = lights.data_[i];
+		const float angle = anim.speed * time + anim.phase;
+
+		if (anim.type == ECS::LIGHT_ANIM_ORBIT)
+		{
+			Assert::True(fabsf(pointLight.position_.x - (anim.center.x + anim.radius * cosf(angle))) < eps, "wrong orbit position of the light: " + std::to_string(i));
+			Assert::True(fabsf(pointLight.position_.z - (anim.center.z + anim.radius * sinf(angle))) < eps, "wrong orbit position of the light: " + std::to_string(i));
+		}
+		else if (anim.type == ECS::LIGHT_ANIM_PULSE)
+		{
+			const float factor = 1.0f + anim.amplitude * sinf(angle);
+			Assert::True(fabsf(pointLight.diffuse_.x - params.diffuses[i].x * factor) < eps, "wrong pulse of the light: " + std::to_string(i));
+		}
+		else
+		{
+			const float factor = pointLight.specular_.x / 0.5f;
+			Assert::True((factor > 1.0f - anim.amplitude - eps) && (factor < 1.0f + eps), "wrong flicker of the light: " + std::to_string(i));
+		}
+	}
+
+	// the same time: nothing is changed
+	lightSys.ResetDirtyRanges();
+	lightSys.UpdateAnimations(time);
+	Assert::True(lightSys.GetDirtyRange(ECS::LightTypes::POINT).IsEmpty(), "lights are dirty but they weren't changed");
+
+	// set a new diffuse color of a pulsing light: the animation must pulse the new color
+	const u32 pulsingIdx = 1;
+	const ECS::LightAnimParams& pulseAnim = animsParams[pulsingIdx];
+	const XMFLOAT4 newDiffuse = { 0.2f, 0.4f, 0.6f, 1.0f };
+	const float pulseFactor = 1.0f + pulseAnim.amplitude * sinf(pulseAnim.speed * (time + 0.5f) + pulseAnim.phase);
+
+	Assert::True(pulseAnim.type == ECS::LIGHT_ANIM_PULSE, "the light isn't pulsing");
+
+	lightSys.SetPointLightProp(ids[pulsingIdx], ECS::LightProps::DIFFUSE, newDiffuse);
+	lightSys.UpdateAnimations(time + 0.5f);
+
+	const XMFLOAT4& pulsedDiffuse = lights.data_[pulsingIdx].diffuse_;
+
+	Assert::True(fabsf(pulsedDiffuse.x - newDiffuse.x * pulseFactor) < eps, "the new diffuse color was overwritten by the animation");
+	Assert::True(fabsf(pulsedDiffuse.y - newDiffuse.y * pulseFactor) < eps, "the new diffuse color was overwritten by the animation");
+	Assert::True(fabsf(pulsedDiffuse.z - newDiffuse.z * pulseFactor) < eps, "the new diffuse color was overwritten by the animation");
+
+	// remove the first light: the last light is moved on its place and it must be still animated
+	lightSys.RemoveRecords({ ids[0] });
+	lightSys.ResetDirtyRanges();
+	lightSys.UpdateAnimations(time + 1.0f);
+
+	const ECS::LightAnimParams& lastAnim = animsParams[lightsCount - 1];
+	const float lastAngle = lastAnim.speed * (time + 1.0f) + lastAnim.phase;
+
+	Assert::True(light.pointLightsAnims_.GetCount() == lightsCount - 1, "the animation of the removed light wasn't removed");
+	Assert::True(lights.ids_[0] == ids[lightsCount - 1], "the last light wasn't moved on the place of the removed one");
+	Assert::True(fabsf(lights.data_[0].position_.x - (lastAnim.center.x + lastAnim.radius * cosf(lastAngle))) < eps, "the moved light is animated wrong");
+
+	Log::Print("\tPASSED");
+}
+
+// --------------------------------------------------------
+
 void TestSystems::TestTexTransformSysUpdating()
 {
 	Log::Print("\tPASSED");
@@ -140,7 +1346,7 @@ void TestSystems::TestTransformSysSerialDeserial()
 
 	// serialize and deserialize transform data
 	// and then check if deserialized data is correct
-	SysSerialDeserialHelper(filepath, ECS::TransformComponent, origMgr, deserMgr);
+	SysSerialDeserialHelper(filepath, origMgr, deserMgr);
 	CompareTransformData(deserMgr.GetComponentTransform(), ids, data);
 
 	Log::Print("\tPASSED");
@@ -168,7 +1374,7 @@ void TestSystems::TestNameSysSerialDeserial()
 
 	// serialize and deserialize names data
 	// and then check if deserialized data is correct
-	SysSerialDeserialHelper(filepath, ECS::NameComponent, origMgr, deserMgr);
+	SysSerialDeserialHelper(filepath, origMgr, deserMgr);
 	CompareNameData(deserMgr.GetComponentName(), ids, names);
 
 	Log::Print("\tPASSED");
@@ -195,7 +1401,7 @@ void TestSystems::TestMoveSysSerialDeserial()
 
 	// serialize and deserialize movement data
 	// and then check if deserialized data is correct
-	SysSerialDeserialHelper(filepath, ECS::MoveComponent, origMgr, deserMgr);
+	SysSerialDeserialHelper(filepath, origMgr, deserMgr);
 	CompareMoveData(deserMgr.GetComponentMovement(), ids, data);
 
 	Log::Print("\tPASSED");
@@ -232,7 +1438,7 @@ void TestSystems::TestMeshSysSerialDeserial()
 
 	// serialize and deserialize Mesh component data
 	// and then check if deserialized data is correct
-	SysSerialDeserialHelper(filepath, ECS::MeshComp, origMgr, deserMgr);
+	SysSerialDeserialHelper(filepath, origMgr, deserMgr);
 	CompareMeshData(deserMgr.meshSystem_, enttsIDs, meshesIDs);
 
 	Log::Print("\tPASSED");
@@ -258,7 +1464,7 @@ void TestSystems::TestRenderedSysSerialDeserial()
 
 	// serialize and deserialize Rendered component data
 	// and then check if deserialized data is correct
-	SysSerialDeserialHelper(filepath, ECS::RenderedComponent, origMgr, deserMgr);
+	SysSerialDeserialHelper(filepath, origMgr, deserMgr);
 	CompareRenderedData(deserMgr.GetComponentRendered(), ids, data);
 
 	
@@ -12,12 +12,23 @@ public:
 	TestSystems() {}
 	~TestSystems() {};
 
-	void Run();
+	void Run();              // correctness tests
+	void RunBenchmarks();    // performance benchmarks (they aren't run at startup)
 
 	void TestTexTransformSysUpdating();
 	void TestMoveSysUpdating();
+	void TestDirtyWorldMatricesUpdating();
+	void TestSystemsScheduling();
+	void TestBVHQueries();
+	void TestLightInfluence();
 	void TestSerialDeserial();
 
+	void BenchmarkMoveSysUpdating();
+	void BenchmarkFrustumCulling();
+	void BenchmarkInstancesCache();
+	void BenchmarkLightClusters();
+	void BenchmarkLightAnimations();
+
 private:
 	// test serialization and deserialization functional of ECS systems
 	void TestTransformSysSerialDeserial();   
@@ -53,82 +53,19 @@ static void RemoveFile(const std::string& filepath)
 
 static void SysSerialDeserialHelper(
 	const std::string filepath,
-	ECS::ComponentType type,
 	ECS::EntityManager& fromMgr,
 	ECS::EntityManager& intoMgr)
 {
-	// in: filepath - path to the data file with the serialized data
-	//     type     - handle data related to this component
+	// in: filepath - path to the scene file with the serialized data
 	//     fromMgr  - serialize data from this entity manager
 	//     intoMgr  - deserialize data into this entity manager
+	//
+	// data of systems is stored only as blocks of the scene file
+	// so the whole entity manager is serialized / deserialized
 
-	u32 offset = 0;
-	std::ifstream fin;
+	Assert::True(fromMgr.Serialize(filepath), "can't serialize data into the file: " + filepath);
+	Assert::True(intoMgr.Deserialize(filepath), "can't deserialize data from the file: " + filepath);
 
-	std::ofstream fout(filepath, std::ios::binary);
-	Assert::True(fout.is_open(), "can't open a file for writing: " + filepath);
-
-	using namespace ECS;
-
-	switch (type)
-	{
-		case TransformComponent:
-		{
-			fromMgr.transformSystem_.Serialize(fout, offset);
-			fout.close();
-			fin.open(filepath, std::ios::binary);
-			intoMgr.transformSystem_.Deserialize(fin, offset);
-
-			break;
-		}
-		case MoveComponent:
-		{
-			fromMgr.moveSystem_.Serialize(fout, offset);
-			fout.close();
-			fin.open(filepath, std::ios::binary);
-			intoMgr.moveSystem_.Deserialize(fin, offset);
-
-			break;
-		}
-		case NameComponent:
-		{
-			fromMgr.nameSystem_.Serialize(fout, offset);
-			fout.close();
-			fin.open(filepath, std::ios::binary);
-			intoMgr.nameSystem_.Deserialize(fin, offset);
-			
-			break;
-		}
-		case MeshComp:
-		{
-			fromMgr.meshSystem_.Serialize(fout, offset);
-			fout.close();
-			fin.open(filepath, std::ios::binary);
-			intoMgr.meshSystem_.Deserialize(fin, offset);
-
-			break;
-		}
-		case RenderedComponent:
-		{
-			fromMgr.renderSystem_.Serialize(fout, offset);
-			fout.close();
-			fin.open(filepath, std::ios::binary);
-			intoMgr.renderSystem_.Deserialize(fin, offset);
-			break;
-		}
-		case TexturedComponent:
-		{
-			assert("TODO: implement is!" && 0);
-			break;
-		}
-		case TextureTransformComponent:
-		{
-			assert("TODO: implement it!" && 0);
-			break;
-		}
-	}
-
-	fin.close();
 	TestUtils::RemoveFile(filepath);
 }
 
@@ -41,7 +41,37 @@ void UnitTestMain::Run()
 		Log::Print();
 
 		testEntityMgr.TestEntitiesCreation();
+		testEntityMgr.TestEntitiesBatchCreation();
+		testEntityMgr.TestEntitiesDestruction();
+		testEntityMgr.TestEnttsQuery();
 		testEntityMgr.TestSerialDeserial();
+		testEntityMgr.TestDeserialGenerations();
+		testEntityMgr.TestDeserialCorruptedFile();
+
+		Log::Print("");
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, true);
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void UnitTestMain::RunBenchmarks()
+{
+	TestEntityMgr testEntityMgr;
+	TestSystems testSystems;
+
+	try
+	{
+		testSystems.RunBenchmarks();
+
+		Log::Print("-------------  BENCHMARKS: EntityManager ---------------", ConsoleColor::YELLOW);
+		Log::Print();
+
+		testEntityMgr.BenchmarkSceneLoad();
 
 		Log::Print("");
 	}
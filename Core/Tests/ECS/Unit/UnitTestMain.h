@@ -15,5 +15,6 @@ public:
 	UnitTestMain();
 	~UnitTestMain();
 
-	void Run();
+	void Run();              // correctness tests
+	void RunBenchmarks();    // performance benchmarks (they aren't run at startup)
 };
\ No newline at end of file
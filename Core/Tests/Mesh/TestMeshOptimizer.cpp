@@ -0,0 +1,283 @@
+// *********************************************************************************
+// Filename:       TestMeshOptimizer.cpp
+// Description:    implementation of tests for optimizations of meshes;
+//
+// Created:        17.10.26
+// *********************************************************************************
+#include "TestMeshOptimizer.h"
+
+#include "../../GameObjects/MeshOptimizer.h"
+#include "../../GameObjects/MeshHelperTypes.h"
+#include "../../Engine/log.h"
+#include "../../Common/Assert.h"
+
+#include <array>
+#include <tuple>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+using Triangle = std::array<float, 9>;    // positions of 3 vertices
+
+
+static void BuildTestGrid(const u32 verticesCount, Mesh::MeshData& mesh)
+{
+	// build an indexed grid in the XZ-plane; rows of quads go one after another
+
+	mesh.name = "test_grid";
+	mesh.vertices.resize(verticesCount * verticesCount);
+	mesh.indices.clear();
+
+	for (u32 row = 0, idx = 0; row < verticesCount; ++row)
+	{
+		for (u32 col = 0; col < verticesCount; ++col, ++idx)
+		{
+			mesh.vertices[idx].position = { (float)col, 0.0f, -(float)row };
+			mesh.vertices[idx].texture  = { (float)col, (float)row };
+		}
+	}
+
+	for (u32 row = 0; row < verticesCount - 1; ++row)
+	{
+		for (u32 col = 0; col < verticesCount - 1; ++col)
+		{
+			const u32 a = row * verticesCount + col;
+			const u32 b = a + 1;
+			const u32 c = a + verticesCount;
+			const u32 d = c + 1;
+
+			mesh.indices.insert(mesh.indices.end(), { a, b, c, c, b, d });
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static void ShuffleTriangles(Mesh::MeshData& mesh)
+{
+	// shuffle triangles (with a fixed seed) to get the worst order for the cache
+
+	const size_t trianglesCount = mesh.indices.size() / 3;
+	std::vector<u32> order(trianglesCount);
+	std::vector<UINT> indices(mesh.indices.size());
+
+	for (u32 i = 0; i < (u32)trianglesCount; ++i)
+		order[i] = i;
+
+	std::shuffle(order.begin(), order.end(), std::mt19937(12345));
+
+	for (size_t i = 0; i < trianglesCount; ++i)
+		std::copy_n(&mesh.indices[order[i] * 3], 3, &indices[i * 3]);
+
+	mesh.indices = std::move(indices);
+}
+
+///////////////////////////////////////////////////////////
+
+static void GetSortedTriangles(const Mesh::MeshData& mesh, std::vector<Triangle>& outTriangles)
+{
+	// get triangles as positions of their vertices; each triangle is rotated
+	// so its "smallest" vertex goes first (the winding order is kept)
+
+	outTriangles.resize(mesh.indices.size() / 3);
+
+	for (size_t tri = 0; tri < outTriangles.size(); ++tri)
+	{
+		std::array<XMFLOAT3, 3> pos;
+
+		for (u32 i = 0; i < 3; ++i)
+			pos[i] = mesh.vertices[mesh.indices[tri * 3 + i]].position;
+
+		auto less = [](const XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+		};
+
+		const size_t first = std::min_element(pos.begin(), pos.end(), less) - pos.begin();
+		std::rotate(pos.begin(), pos.begin() + first, pos.end());
+
+		for (u32 i = 0; i < 3; ++i)
+		{
+			outTriangles[tri][i * 3 + 0] = pos[i].x;
+			outTriangles[tri][i * 3 + 1] = pos[i].y;
+			outTriangles[tri][i * 3 + 2] = pos[i].z;
+		}
+	}
+
+	std::sort(outTriangles.begin(), outTriangles.end());
+}
+
+///////////////////////////////////////////////////////////
+
+static bool HasSameTriangles(const Mesh::MeshData& mesh0, const Mesh::MeshData& mesh1)
+{
+	std::vector<Triangle> triangles0;
+	std::vector<Triangle> triangles1;
+
+	GetSortedTriangles(mesh0, triangles0);
+	GetSortedTriangles(mesh1, triangles1);
+
+	return triangles0 == triangles1;
+}
+
+///////////////////////////////////////////////////////////
+
+static VertexCacheStats Analyze(const Mesh::MeshData& mesh)
+{
+	return MeshOptimizer::AnalyzeVertexCache(mesh.indices, (u32)mesh.vertices.size());
+}
+
+///////////////////////////////////////////////////////////
+
+static void PrintStats(const char* label, const VertexCacheStats& stats)
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "\t\t%-28s ACMR: %.3f  ATVR: %.3f", label, stats.acmr, stats.atvr);
+	Log::Print(buf);
+}
+
+// *********************************************************************************
+
+void TestMeshOptimizer::Run()
+{
+	Log::Print();
+	Log::Print("----------------  TESTS: MESH OPTIMIZER  ----------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		TestWeldVertices();
+		TestVertexCache();
+		TestOverdrawAndVertexFetch();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("TEST MESH OPTIMIZER: some test doesn't pass");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestMeshOptimizer::TestWeldVertices()
+{
+	// expand the grid so each triangle has its own vertices and
+	// check that welding restores the shared vertices
+
+	Mesh::MeshData grid;
+	Mesh::MeshData expanded;
+	MeshOptimizer optimizer;
+
+	BuildTestGrid(33, grid);
+
+	expanded.name = grid.name;
+	expanded.vertices.reserve(grid.indices.size());
+
+	for (const UINT idx : grid.indices)
+	{
+		expanded.indices.push_back((UINT)expanded.vertices.size());
+		expanded.vertices.push_back(grid.vertices[idx]);
+	}
+
+	const u32 removedCount = optimizer.WeldVertices(expanded);
+
+	Assert::True(expanded.vertices.size() == grid.vertices.size(), "wrong number of vertices after welding");
+	Assert::True(removedCount == grid.indices.size() - grid.vertices.size(), "wrong number of removed vertices");
+	Assert::True(HasSameTriangles(grid, expanded), "triangles are changed after welding");
+
+	// welding of the mesh without duplicates changes nothing
+	Assert::True(optimizer.WeldVertices(grid) == 0, "vertices of the grid are unique but were welded");
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestMeshOptimizer::TestVertexCache()
+{
+	// reorder triangles of the grid (in rows and shuffled order) and check
+	// that the set of triangles is the same and the ACMR is improved
+
+	Mesh::MeshData grid;
+	Mesh::MeshData shuffled;
+	MeshOptimizer optimizer;
+
+	BuildTestGrid(65, grid);
+	shuffled = grid;
+	ShuffleTriangles(shuffled);
+
+	const VertexCacheStats rowsStats     = Analyze(grid);
+	const VertexCacheStats shuffledStats = Analyze(shuffled);
+
+	Mesh::MeshData optimizedGrid = grid;
+	Mesh::MeshData optimizedShuffled = shuffled;
+
+	optimizer.OptimizeVertexCache(optimizedGrid);
+	optimizer.OptimizeVertexCache(optimizedShuffled);
+
+	const VertexCacheStats optGridStats     = Analyze(optimizedGrid);
+	const VertexCacheStats optShuffledStats = Analyze(optimizedShuffled);
+
+	Assert::True(HasSameTriangles(grid, optimizedGrid),         "triangles are changed by the vertex cache optimization");
+	Assert::True(HasSameTriangles(grid, optimizedShuffled),     "triangles are changed by the vertex cache optimization");
+
+	Assert::True(optGridStats.acmr < rowsStats.acmr,            "the ACMR of the grid isn't improved");
+	Assert::True(optShuffledStats.acmr < 0.8f,                  "the ACMR of the shuffled grid isn't improved enough");
+	Assert::True(optShuffledStats.atvr < 1.5f,                  "the ATVR of the shuffled grid isn't improved enough");
+
+	Log::Print("\tvertex cache (grid 64x64 quads, FIFO " + std::to_string(MeshOptimizer::FIFO_CACHE_SIZE) + "):");
+	PrintStats("rows order:",              rowsStats);
+	PrintStats("rows order (optimized):",  optGridStats);
+	PrintStats("shuffled:",                shuffledStats);
+	PrintStats("shuffled (optimized):",    optShuffledStats);
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestMeshOptimizer::TestOverdrawAndVertexFetch()
+{
+	// check the whole optimization:
+	// 1. the set of triangles is the same;
+	// 2. the overdraw reordering doesn't make the ACMR much worse;
+	// 3. vertices go in order of their first use by indices
+
+	Mesh::MeshData grid;
+	MeshOptimizer optimizer;
+
+	BuildTestGrid(65, grid);
+	ShuffleTriangles(grid);
+
+	Mesh::MeshData mesh = grid;
+	const float threshold = 1.05f;
+
+	optimizer.OptimizeVertexCache(mesh);
+	const VertexCacheStats cacheStats = Analyze(mesh);
+
+	optimizer.OptimizeOverdraw(mesh, threshold);
+	const VertexCacheStats overdrawStats = Analyze(mesh);
+
+	optimizer.OptimizeVertexFetch(mesh);
+	const VertexCacheStats fetchStats = Analyze(mesh);
+
+	Assert::True(HasSameTriangles(grid, mesh), "triangles are changed by the optimization");
+	Assert::True(overdrawStats.acmr <= threshold * cacheStats.acmr + 0.05f, "the overdraw optimization hurts the vertex cache too much");
+	Assert::True(fetchStats.transformedCount == overdrawStats.transformedCount, "the vertex fetch optimization changes the vertex cache efficiency");
+
+	u32 nextNewIdx = 0;
+
+	for (const UINT idx : mesh.indices)
+	{
+		Assert::True(idx <= nextNewIdx, "vertices aren't in order of their first use");
+		nextNewIdx = std::max(nextNewIdx, idx + 1);
+	}
+
+	Assert::True(nextNewIdx == mesh.vertices.size(), "there are unused vertices after the vertex fetch optimization");
+
+	PrintStats("after overdraw reordering:", overdrawStats);
+	Log::Print("\tPASSED");
+}
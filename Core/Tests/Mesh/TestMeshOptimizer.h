@@ -0,0 +1,20 @@
+// *********************************************************************************
+// Filename:       TestMeshOptimizer.h
+// Description:    tests for optimizations of meshes (vertex cache, overdraw, etc.)
+// 
+// Created:        17.10.26
+// *********************************************************************************
+#pragma once
+
+class TestMeshOptimizer final
+{
+public:
+	TestMeshOptimizer() {}
+	~TestMeshOptimizer() {}
+
+	void Run();
+
+	void TestWeldVertices();
+	void TestVertexCache();
+	void TestOverdrawAndVertexFetch();
+};
@@ -0,0 +1,506 @@
+// *********************************************************************************
+// Filename:       TestMeshSimplifier.cpp
+// Description:    implementation of tests for simplification of meshes and LODs;
+//
+// Created:        17.10.26
+// *********************************************************************************
+#include "TestMeshSimplifier.h"
+
+#include "../../GameObjects/MeshSimplifier.h"
+#include "../../GameObjects/MeshHelperTypes.h"
+#include "../../Render/LodSelector.h"
+#include "../../Engine/log.h"
+#include "../../Common/Assert.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+
+static void BuildTestSphere(
+	const float radius,
+	const u32 slicesCount,
+	const u32 stacksCount,
+	Mesh::MeshData& mesh)
+{
+	// build a UV-sphere without seams (each position has only one vertex)
+	// so the simplifier can collapse any of its edges
+
+	mesh.name = "test_sphere";
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	auto AddVertex = [&mesh, radius](const XMFLOAT3& dir)
+	{
+		Vertex3D v;
+		v.position = { dir.x * radius, dir.y * radius, dir.z * radius };
+		v.normal   = dir;
+		mesh.vertices.push_back(v);
+	};
+
+	// the top pole, rings, the bottom pole
+	AddVertex({ 0, 1, 0 });
+
+	for (u32 stack = 1; stack < stacksCount; ++stack)
+	{
+		const float phi = XM_PI * stack / stacksCount;
+
+		for (u32 slice = 0; slice < slicesCount; ++slice)
+		{
+			const float theta = XM_2PI * slice / slicesCount;
+			AddVertex({ sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta) });
+		}
+	}
+
+	AddVertex({ 0, -1, 0 });
+
+	const u32 bottomIdx = (u32)mesh.vertices.size() - 1;
+	const u32 ringsCount = stacksCount - 1;
+
+	for (u32 slice = 0; slice < slicesCount; ++slice)
+	{
+		const u32 next = (slice + 1) % slicesCount;
+
+		// the top cap
+		mesh.indices.insert(mesh.indices.end(), { 0, 1 + next, 1 + slice });
+
+		// rings
+		for (u32 ring = 0; ring < ringsCount - 1; ++ring)
+		{
+			const u32 a = 1 + ring * slicesCount + slice;
+			const u32 b = 1 + ring * slicesCount + next;
+			const u32 c = a + slicesCount;
+			const u32 d = b + slicesCount;
+
+			mesh.indices.insert(mesh.indices.end(), { a, b, c, c, b, d });
+		}
+
+		// the bottom cap
+		const u32 lastRing = 1 + (ringsCount - 1) * slicesCount;
+		mesh.indices.insert(mesh.indices.end(), { bottomIdx, lastRing + slice, lastRing + next });
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static void BuildTestGrid(const u32 verticesCount, Mesh::MeshData& mesh)
+{
+	// build an indexed flat grid in the XZ-plane (normals of triangles are +Y)
+
+	mesh.name = "test_grid";
+	mesh.vertices.resize(verticesCount * verticesCount);
+	mesh.indices.clear();
+
+	for (u32 row = 0, idx = 0; row < verticesCount; ++row)
+	{
+		for (u32 col = 0; col < verticesCount; ++col, ++idx)
+		{
+			mesh.vertices[idx].position = { (float)col, 0.0f, -(float)row };
+			mesh.vertices[idx].texture  = { (float)col, (float)row };
+		}
+	}
+
+	for (u32 row = 0; row < verticesCount - 1; ++row)
+	{
+		for (u32 col = 0; col < verticesCount - 1; ++col)
+		{
+			const u32 a = row * verticesCount + col;
+			const u32 b = a + 1;
+			const u32 c = a + verticesCount;
+			const u32 d = c + 1;
+
+			mesh.indices.insert(mesh.indices.end(), { a, b, c, c, b, d });
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static float GetDistanceToTriangle(const XMVECTOR p, const XMVECTOR a, const XMVECTOR b, const XMVECTOR c)
+{
+	// the distance from the point to the closest point of the triangle
+	// (Ericson, Real-Time Collision Detection, 5.1.5)
+
+	const XMVECTOR ab = b - a;
+	const XMVECTOR ac = c - a;
+	const XMVECTOR ap = p - a;
+
+	const float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+	const float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return XMVectorGetX(XMVector3Length(ap));
+
+	const XMVECTOR bp = p - b;
+	const float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+	const float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+	if (d3 >= 0.0f && d4 <= d3)
+		return XMVectorGetX(XMVector3Length(bp));
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return XMVectorGetX(XMVector3Length(p - (a + ab * (d1 / (d1 - d3)))));
+
+	const XMVECTOR cp = p - c;
+	const float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+	const float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+	if (d6 >= 0.0f && d5 <= d6)
+		return XMVectorGetX(XMVector3Length(cp));
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return XMVectorGetX(XMVector3Length(p - (a + ac * (d2 / (d2 - d6)))));
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		return XMVectorGetX(XMVector3Length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))));
+
+	const float denom = 1.0f / (va + vb + vc);
+	return XMVectorGetX(XMVector3Length(p - (a + ab * (vb * denom) + ac * (vc * denom))));
+}
+
+///////////////////////////////////////////////////////////
+
+static float MeasureSphereError(
+	const Mesh::MeshData& sphere,
+	const std::vector<UINT>& lodIndices,
+	const float radius)
+{
+	// a two-sided geometric error of the LOD:
+	// 1. the max distance from vertices of the origin mesh to the LOD surface;
+	// 2. the max distance from centers of the LOD triangles to the ideal sphere
+
+	float maxError = 0.0f;
+
+	for (const Vertex3D& v : sphere.vertices)
+	{
+		const XMVECTOR p = XMLoadFloat3(&v.position);
+		float minDist = FLT_MAX;
+
+		for (size_t i = 0; i < lodIndices.size(); i += 3)
+		{
+			minDist = std::min(minDist, GetDistanceToTriangle(
+				p,
+				XMLoadFloat3(&sphere.vertices[lodIndices[i + 0]].position),
+				XMLoadFloat3(&sphere.vertices[lodIndices[i + 1]].position),
+				XMLoadFloat3(&sphere.vertices[lodIndices[i + 2]].position)));
+		}
+
+		maxError = std::max(maxError, minDist);
+	}
+
+	for (size_t i = 0; i < lodIndices.size(); i += 3)
+	{
+		const XMVECTOR center =
+			(XMLoadFloat3(&sphere.vertices[lodIndices[i + 0]].position) +
+			 XMLoadFloat3(&sphere.vertices[lodIndices[i + 1]].position) +
+			 XMLoadFloat3(&sphere.vertices[lodIndices[i + 2]].position)) / 3.0f;
+
+		maxError = std::max(maxError, radius - XMVectorGetX(XMVector3Length(center)));
+	}
+
+	return maxError;
+}
+
+///////////////////////////////////////////////////////////
+
+static void CheckTriangles(const Mesh::MeshData& mesh, const std::vector<UINT>& indices)
+{
+	// LODs use vertices of the mesh and have no degenerate triangles
+
+	Assert::True(indices.size() % 3 == 0, "the number of indices of the LOD isn't a multiple of 3");
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const UINT a = indices[i + 0];
+		const UINT b = indices[i + 1];
+		const UINT c = indices[i + 2];
+
+		Assert::True(std::max({ a, b, c }) < mesh.vertices.size(), "an index of the LOD is out of range");
+		Assert::True((a != b) && (b != c) && (a != c), "the LOD has a degenerate triangle");
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static void PrintLOD(const u32 lodIdx, const u32 trianglesCount, const float error, const float measuredError)
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "\t\tLOD %u: %5u triangles;  error: %.4f  (measured: %.4f)", lodIdx, trianglesCount, error, measuredError);
+	Log::Print(buf);
+}
+
+// *********************************************************************************
+
+void TestMeshSimplifier::Run()
+{
+	Log::Print();
+	Log::Print("----------------  TESTS: MESH SIMPLIFIER  ---------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		TestSphereLODs();
+		TestFlatGrid();
+		TestLODSelection();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("TEST MESH SIMPLIFIER: some test doesn't pass");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestMeshSimplifier::TestSphereLODs()
+{
+	// generate LODs of a sphere and check their triangle counts and errors;
+	// the measured error of the sphere LODs is compared with the ideal sphere
+
+	const float radius = 10.0f;
+	Mesh::MeshData sphere;
+	MeshSimplifier simplifier;
+
+	BuildTestSphere(radius, 48, 24, sphere);
+	simplifier.GenerateLODs(sphere);
+
+	Assert::True(sphere.lods.size() == MeshSimplifier::MAX_LODS_COUNT - 1, "wrong number of LODs of the sphere");
+
+	Log::Print("\tsphere LODs (radius: " + std::to_string((int)radius) + "):");
+	PrintLOD(0, (u32)sphere.indices.size() / 3, 0.0f, 0.0f);
+
+	size_t prevIndicesCount = sphere.indices.size();
+	float  prevError = 0.0f;
+
+	for (u32 lodIdx = 0; lodIdx < (u32)sphere.lods.size(); ++lodIdx)
+	{
+		const Mesh::LOD& lod = sphere.lods[lodIdx];
+		const float measuredError = MeasureSphereError(sphere, lod.indices, radius);
+
+		PrintLOD(lodIdx + 1, (u32)lod.indices.size() / 3, lod.error, measuredError);
+		CheckTriangles(sphere, lod.indices);
+
+		Assert::True(lod.indices.size() <= prevIndicesCount * MeshSimplifier::LOD_REDUCTION + 3, "the LOD isn't simplified enough");
+		Assert::True(lod.error > prevError, "errors of LODs aren't in ascending order");
+
+		// the quadric error is a mean error so it can be a little less than the max distance
+		Assert::True(measuredError <= 2.0f * lod.error + 0.001f, "the measured error of the LOD is too big relative to its error");
+		Assert::True(measuredError <= 0.1f * radius, "the measured error of the LOD is too big");
+
+		prevIndicesCount = lod.indices.size();
+		prevError = lod.error;
+	}
+
+	// any collapse of the sphere edge has an error so nothing is collapsed with the zero max error
+	std::vector<u32> indices;
+	const float error = simplifier.Simplify(sphere.vertices, sphere.indices, 0, 0.0f, indices);
+
+	Assert::True(indices == sphere.indices, "the sphere is simplified with the zero max error");
+	Assert::True(error == 0.0f, "the error of the not simplified mesh isn't zero");
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestMeshSimplifier::TestFlatGrid()
+{
+	// a flat grid is simplified without any error; its border is locked
+	// so the area is the same and no triangle is flipped
+
+	Mesh::MeshData grid;
+	MeshSimplifier simplifier;
+
+	BuildTestGrid(33, grid);
+	simplifier.GenerateLODs(grid);
+
+	Assert::True(!grid.lods.empty(), "the grid has no LODs");
+
+	const float gridArea = 32.0f * 32.0f;
+
+	for (const Mesh::LOD& lod : grid.lods)
+	{
+		CheckTriangles(grid, lod.indices);
+		Assert::True(lod.error < 1e-4f, "the error of the flat grid LOD isn't zero");
+
+		float area = 0.0f;
+		std::vector<bool> isUsed(grid.vertices.size(), false);
+
+		for (size_t i = 0; i < lod.indices.size(); i += 3)
+		{
+			const XMVECTOR a = XMLoadFloat3(&grid.vertices[lod.indices[i + 0]].position);
+			const XMVECTOR b = XMLoadFloat3(&grid.vertices[lod.indices[i + 1]].position);
+			const XMVECTOR c = XMLoadFloat3(&grid.vertices[lod.indices[i + 2]].position);
+			const XMVECTOR n = XMVector3Cross(b - a, c - a);
+
+			Assert::True(XMVectorGetY(n) > 0.0f, "a triangle of the grid LOD is flipped or degenerate");
+			area += 0.5f * XMVectorGetY(n);
+
+			isUsed[lod.indices[i + 0]] = true;
+			isUsed[lod.indices[i + 1]] = true;
+			isUsed[lod.indices[i + 2]] = true;
+		}
+
+		Assert::True(fabsf(area - gridArea) < 0.01f, "the area of the grid LOD is changed");
+
+		// all the vertices of the border are kept
+		for (const Vertex3D& v : grid.vertices)
+		{
+			const bool isBorder =
+				(v.position.x == 0.0f) || (v.position.x == 32.0f) ||
+				(v.position.z == 0.0f) || (v.position.z == -32.0f);
+
+			if (isBorder)
+				Assert::True(isUsed[&v - grid.vertices.data()], "a vertex of the grid border is removed");
+		}
+	}
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "\tflat grid: %u triangles => LOD %u: %u triangles (error: %.2e)",
+		(u32)grid.indices.size() / 3,
+		(u32)grid.lods.size(),
+		(u32)grid.lods.back().indices.size() / 3,
+		grid.lods.back().error);
+
+	Log::Print(buf);
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestMeshSimplifier::TestLODSelection()
+{
+	// the camera is at the origin, 500 pixels per unit at the distance 1;
+	// the LOD is selected if: error * scale * 500 / (distance - radius) <= 1 pixel
+
+	LodSelector selector;
+	selector.SetCamera({ 0, 0, 0 }, 1.0f, 1000.0f);
+
+	ID3D11Buffer* pIB0 = reinterpret_cast<ID3D11Buffer*>(0x10);
+	ID3D11Buffer* pIB1 = reinterpret_cast<ID3D11Buffer*>(0x20);
+	ID3D11Buffer* pIB2 = reinterpret_cast<ID3D11Buffer*>(0x30);
+	ID3D11Buffer* pIB3 = reinterpret_cast<ID3D11Buffer*>(0x40);
+
+	// the first mesh has 3 LODs, the second one has no LODs
+	Mesh::DataForRendering meshesData;
+	meshesData.names_      = { "with_lods", "without_lods" };
+	meshesData.pVBs_       = { nullptr, nullptr };
+	meshesData.pIBs_       = { pIB0, pIB0 };
+	meshesData.indexCount_ = { 300, 30 };
+	meshesData.boundBoxes_ = { BoundingBox({ 0, 0, 0 }, { 1, 1, 1 }), BoundingBox({ 0, 0, 0 }, { 1, 1, 1 }) };
+	meshesData.materials_.resize(2);
+	meshesData.texIDs_.resize(2);
+	meshesData.lods_       = { { { pIB1, 150, 0.01f }, { pIB2, 75, 0.05f }, { pIB3, 36, 0.2f } }, {} };
+
+	// instances of the first mesh are at distances: 3, 10, 50, 200 and 50 (scaled by 2)
+	const std::vector<ptrdiff_t> numInstancesPerMesh = { 5, 2 };
+	std::vector<XMMATRIX> worlds =
+	{
+		XMMatrixTranslation(0, 0, 3),
+		XMMatrixTranslation(0, 0, 10),
+		XMMatrixTranslation(0, 0, 50),
+		XMMatrixTranslation(0, 0, 200),
+		XMMatrixScaling(2, 2, 2) * XMMatrixTranslation(0, 0, 50),
+		XMMatrixTranslation(0, 0, 200),
+		XMMatrixTranslation(0, 0, 3),
+	};
+
+	// all the instances are visible
+	const std::vector<u32> visibleInstances = { 0, 1, 2, 3, 4, 5, 6 };
+	std::vector<uint8_t> lods;
+	std::vector<u32> changedMeshes;
+
+	Assert::True(selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes), "LODs of new instances aren't changed");
+	Assert::True(lods == std::vector<uint8_t>({ 0, 1, 2, 3, 1, 0, 0 }), "LODs are selected wrong");
+	Assert::True(changedMeshes == std::vector<u32>({ 0 }), "wrong meshes with changed LODs");
+
+	Assert::True(!selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes), "LODs are changed but nothing is moved");
+	Assert::True(changedMeshes.empty(), "there are meshes with changed LODs but nothing is moved");
+
+	// hysteresis: at the distance 7.3 the error of LOD 1 is ~0.9 pixels so the instance
+	// with LOD 1 keeps it but the instance with LOD 0 doesn't switch to LOD 1
+	worlds[0] = XMMatrixTranslation(0, 0, 7.3f);
+	worlds[1] = XMMatrixTranslation(0, 0, 7.3f);
+	Assert::True(!selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes), "LODs are changed inside the hysteresis band");
+	Assert::True(lods[0] == 0 && lods[1] == 1, "LODs inside the hysteresis band are wrong");
+
+	worlds[1] = XMMatrixTranslation(0, 0, 10);
+
+	// move the nearest instance far away
+	worlds[0] = XMMatrixTranslation(0, 0, 1000);
+	Assert::True(selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes), "LODs aren't changed after moving");
+	Assert::True(lods[0] == 3, "the LOD of the moved instance is wrong");
+	Assert::True(changedMeshes == std::vector<u32>({ 0 }), "wrong meshes with changed LODs after moving");
+
+	// ---------------------------------------------
+	// group instances: mesh 0 => LOD 1 (2 instances), LOD 2, LOD 3 (2 instances); mesh 1 => LOD 0
+
+	std::vector<u32> order;
+	std::vector<u32> renderIdxs;
+	std::vector<ptrdiff_t> numInstancesPerGroup;
+	Mesh::DataForRendering groupsData;
+
+	LodSelector::GroupInstances(visibleInstances, numInstancesPerMesh, lods, meshesData, order, renderIdxs, numInstancesPerGroup, groupsData);
+
+	Assert::True(numInstancesPerGroup == std::vector<ptrdiff_t>({ 2, 1, 2, 2 }), "wrong number of instances in groups");
+	Assert::True(order == std::vector<u32>({ 1, 4, 2, 0, 3, 5, 6 }), "wrong order of instances");
+	Assert::True(groupsData.pIBs_ == std::vector<ID3D11Buffer*>({ pIB1, pIB2, pIB3, pIB0 }), "wrong index buffers of groups");
+	Assert::True(groupsData.indexCount_ == std::vector<UINT>({ 150, 75, 36, 30 }), "wrong index counts of groups");
+	Assert::True(groupsData.names_.size() == numInstancesPerGroup.size(), "wrong number of groups");
+
+	for (u32 renderIdx = 0; renderIdx < (u32)order.size(); ++renderIdx)
+		Assert::True(renderIdxs[order[renderIdx]] == renderIdx, "rendering idxs of instances are wrong");
+
+	// ---------------------------------------------
+	// only LODs are changed: instances are grouped again only in the range of the changed
+	// mesh and the result is the same as after the full grouping
+
+	worlds[2] = XMMatrixTranslation(0, 0, 3);
+	Assert::True(selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes), "LODs aren't changed after moving");
+	Assert::True(changedMeshes == std::vector<u32>({ 0 }), "wrong meshes with changed LODs after regrouping");
+
+	LodSelector::RegroupInstances(changedMeshes, visibleInstances, numInstancesPerMesh, lods, meshesData, order, renderIdxs, numInstancesPerGroup, groupsData);
+
+	Assert::True(numInstancesPerGroup == std::vector<ptrdiff_t>({ 1, 2, 2, 2 }), "wrong number of instances in regrouped groups");
+	Assert::True(order == std::vector<u32>({ 2, 1, 4, 0, 3, 5, 6 }), "wrong order of regrouped instances");
+	Assert::True(groupsData.pIBs_ == std::vector<ID3D11Buffer*>({ pIB0, pIB1, pIB3, pIB0 }), "wrong index buffers of regrouped groups");
+	Assert::True(groupsData.indexCount_ == std::vector<UINT>({ 300, 150, 36, 30 }), "wrong index counts of regrouped groups");
+
+	for (u32 renderIdx = 0; renderIdx < (u32)order.size(); ++renderIdx)
+		Assert::True(renderIdxs[order[renderIdx]] == renderIdx, "rendering idxs of regrouped instances are wrong");
+
+	worlds[2] = XMMatrixTranslation(0, 0, 50);
+	selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes);
+
+	// ---------------------------------------------
+	// only a part of instances is visible: LODs of invisible instances aren't changed
+	// and they aren't rendered (mesh 0 => LOD 1, LOD 2; mesh 1 => LOD 0)
+
+	const std::vector<u32> visiblePart = { 1, 2, 5 };
+	const std::vector<ptrdiff_t> numVisiblePerMesh = { 2, 1 };
+
+	worlds[3] = XMMatrixTranslation(0, 0, 3);
+	Assert::True(!selector.SelectLODs(worlds, visiblePart, numVisiblePerMesh, meshesData, lods, changedMeshes), "LODs are changed but visible instances aren't moved");
+	Assert::True(lods[3] == 3, "the LOD of the invisible instance is changed");
+
+	LodSelector::GroupInstances(visiblePart, numVisiblePerMesh, lods, meshesData, order, renderIdxs, numInstancesPerGroup, groupsData);
+
+	Assert::True(numInstancesPerGroup == std::vector<ptrdiff_t>({ 1, 1, 1 }), "wrong number of visible instances in groups");
+	Assert::True(order == std::vector<u32>({ 1, 2, 5 }), "wrong order of visible instances");
+	Assert::True(groupsData.pIBs_ == std::vector<ID3D11Buffer*>({ pIB1, pIB2, pIB0 }), "wrong index buffers of groups of visible instances");
+
+	for (const u32 idx : { 0u, 3u, 4u, 6u })
+		Assert::True(renderIdxs[idx] == LodSelector::INVALID_RENDER_IDX, "an invisible instance has a rendering idx");
+
+	// without the camera (zero viewport height) only LOD 0 is selected
+	selector.SetCamera({ 0, 0, 0 }, 1.0f, 0.0f);
+	selector.SelectLODs(worlds, visibleInstances, numInstancesPerMesh, meshesData, lods, changedMeshes);
+
+	Assert::True(std::all_of(lods.begin(), lods.end(), [](const uint8_t lod) { return lod == 0; }), "not LOD 0 is selected without the camera");
+
+	Log::Print("\tPASSED");
+}
@@ -0,0 +1,21 @@
+// *********************************************************************************
+// Filename:       TestMeshSimplifier.h
+// Description:    tests for simplification of meshes, generation of LODs
+//                 and selection of LODs by the distance to the camera
+//
+// Created:        17.10.26
+// *********************************************************************************
+#pragma once
+
+class TestMeshSimplifier final
+{
+public:
+	TestMeshSimplifier() {}
+	~TestMeshSimplifier() {}
+
+	void Run();
+
+	void TestSphereLODs();
+	void TestFlatGrid();
+	void TestLODSelection();
+};
@@ -0,0 +1,239 @@
+// *********************************************************************************
+// Filename:       TestModelMath.cpp
+// Description:    implementation of tests for the mesh math;
+//
+// Created:        17.10.26
+// *********************************************************************************
+#include "TestModelMath.h"
+
+#include "../../GameObjects/ModelMath.h"
+#include "../../GameObjects/MeshHelperTypes.h"
+#include "../../Engine/log.h"
+#include "../../Common/Assert.h"
+#include "Common/ThreadPool.h"        // from the ECS module
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+
+static void BuildTestGrid(const u32 verticesCount, const float amplitude, Mesh::MeshData& mesh)
+{
+	// build an indexed grid in the XZ-plane with waves of the input amplitude;
+	// texture coords go along +X (u) and -Z (v); normals are analytic
+
+	const float halfSize = 0.5f * (verticesCount - 1);
+	const float invSize = 1.0f / (verticesCount - 1);
+
+	mesh.name = "test_grid";
+	mesh.vertices.resize(verticesCount * verticesCount);
+	mesh.indices.clear();
+
+	for (u32 row = 0, idx = 0; row < verticesCount; ++row)
+	{
+		for (u32 col = 0; col < verticesCount; ++col, ++idx)
+		{
+			const float x = -halfSize + col;
+			const float z = halfSize - row;
+			const float y = amplitude * sinf(0.2f * x) * cosf(0.1f * z);
+
+			// n = (-dy/dx, 1, -dy/dz)
+			const float dydx = amplitude * 0.2f * cosf(0.2f * x) * cosf(0.1f * z);
+			const float dydz = -amplitude * 0.1f * sinf(0.2f * x) * sinf(0.1f * z);
+
+			Vertex3D& v = mesh.vertices[idx];
+			v.position = { x, y, z };
+			v.texture  = { col * invSize, row * invSize };
+			XMStoreFloat3(&v.normal, XMVector3Normalize(XMVectorSet(-dydx, 1.0f, -dydz, 0.0f)));
+		}
+	}
+
+	for (u32 row = 0; row < verticesCount - 1; ++row)
+	{
+		for (u32 col = 0; col < verticesCount - 1; ++col)
+		{
+			const u32 a = row * verticesCount + col;
+			const u32 b = a + 1;
+			const u32 c = a + verticesCount;
+			const u32 d = c + 1;
+
+			mesh.indices.insert(mesh.indices.end(), { a, b, c, c, b, d });
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static void DeindexMesh(const Mesh::MeshData& mesh, std::vector<Vertex3D>& outVertices)
+{
+	// the old implementation of tangents computation works with
+	// non-indexed triangles so we expand vertices of the mesh
+
+	outVertices.resize(mesh.indices.size());
+
+	for (size_t i = 0; i < mesh.indices.size(); ++i)
+		outVertices[i] = mesh.vertices[mesh.indices[i]];
+}
+
+///////////////////////////////////////////////////////////
+
+static float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return XMVectorGetX(XMVector3Dot(XMLoadFloat3(&a), XMLoadFloat3(&b)));
+}
+
+// *********************************************************************************
+
+void TestModelMath::Run()
+{
+	Log::Print();
+	Log::Print("----------------  TESTS: MODEL MATH  ----------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		TestMeshTangents();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("TEST MODEL MATH: some test doesn't pass");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestModelMath::RunBenchmarks()
+{
+	Log::Print();
+	Log::Print("------------  BENCHMARKS: MODEL MATH  ------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		BenchmarkMeshTangents();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("BENCHMARK MODEL MATH: some benchmark failed");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestModelMath::TestMeshTangents()
+{
+	// check tangents/binormals of the indexed mesh:
+	// 1. for a flat grid they are exactly along the texture axes;
+	// 2. for a curved grid they are unit, orthogonal to each other and to
+	//    the normal, and are close to tangents of faces which are computed
+	//    by the old (per-face) implementation;
+	// 3. the result of the parallel computation is the same as the single-thread one
+
+	ModelMath modelMath;
+	Mesh::MeshData flat;
+	Mesh::MeshData waves;
+
+	BuildTestGrid(65, 0.0f, flat);
+	modelMath.CalculateMeshTangents(flat);
+
+	for (const Vertex3D& v : flat.vertices)
+	{
+		Assert::True(Dot(v.tangent,  { 1, 0, 0 }) > 0.99999f, "wrong tangent of the flat grid");
+		Assert::True(Dot(v.binormal, { 0, 0, -1 }) > 0.99999f, "wrong binormal of the flat grid");
+	}
+
+	// ---------------------------------------------
+
+	BuildTestGrid(65, 3.0f, waves);
+	modelMath.CalculateMeshTangents(waves);
+
+	for (const Vertex3D& v : waves.vertices)
+	{
+		Assert::True(fabsf(Dot(v.tangent, v.tangent) - 1.0f) < 1e-4f,   "the tangent isn't unit");
+		Assert::True(fabsf(Dot(v.binormal, v.binormal) - 1.0f) < 1e-4f, "the binormal isn't unit");
+		Assert::True(fabsf(Dot(v.tangent, v.normal)) < 1e-4f,           "the tangent isn't orthogonal to the normal");
+		Assert::True(fabsf(Dot(v.binormal, v.normal)) < 1e-4f,          "the binormal isn't orthogonal to the normal");
+		Assert::True(fabsf(Dot(v.tangent, v.binormal)) < 1e-4f,         "the tangent isn't orthogonal to the binormal");
+	}
+
+	std::vector<Vertex3D> faces;
+	DeindexMesh(waves, faces);
+	modelMath.CalculateModelVectors(faces, false);
+
+	for (size_t i = 0; i < waves.indices.size(); ++i)
+	{
+		const Vertex3D& v = waves.vertices[waves.indices[i]];
+
+		Assert::True(Dot(v.tangent,  faces[i].tangent) > 0.95f,  "the tangent differs from the tangent of the face");
+		Assert::True(Dot(v.binormal, faces[i].binormal) > 0.95f, "the binormal differs from the binormal of the face");
+	}
+
+	// ---------------------------------------------
+
+	ECS::ThreadPool pool;
+	Mesh::MeshData parallelWaves;
+
+	BuildTestGrid(65, 3.0f, parallelWaves);
+	modelMath.CalculateMeshTangents(parallelWaves, &pool);
+
+	for (size_t i = 0; i < waves.vertices.size(); ++i)
+	{
+		const Vertex3D& v0 = waves.vertices[i];
+		const Vertex3D& v1 = parallelWaves.vertices[i];
+
+		Assert::True(memcmp(&v0.tangent,  &v1.tangent,  sizeof(XMFLOAT3)) == 0, "the parallel result differs from the single-thread one");
+		Assert::True(memcmp(&v0.binormal, &v1.binormal, sizeof(XMFLOAT3)) == 0, "the parallel result differs from the single-thread one");
+	}
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestModelMath::BenchmarkMeshTangents()
+{
+	// BENCHMARK: throughput of tangents computation for a mesh of 200k+ triangles:
+	//            the old per-face implementation (non-indexed vertices) vs.
+	//            the indexed one (1 thread / N threads)
+
+	const u32 verticesCount = 321;          // 320 * 320 * 2 = 204800 triangles
+
+	ModelMath modelMath;
+	Mesh::MeshData mesh;
+	std::vector<Vertex3D> faces;
+	ECS::ThreadPool pool;
+
+	BuildTestGrid(verticesCount, 3.0f, mesh);
+	DeindexMesh(mesh, faces);
+
+	const size_t trianglesCount = mesh.indices.size() / 3;
+
+	auto measure = [](const auto& func)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		const auto end = std::chrono::steady_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	};
+
+	const double oldTimeMs      = measure([&]() { modelMath.CalculateModelVectors(faces, false); });
+	const double singleTimeMs   = measure([&]() { modelMath.CalculateMeshTangents(mesh); });
+	const double parallelTimeMs = measure([&]() { modelMath.CalculateMeshTangents(mesh, &pool); });
+
+	auto toStr = [trianglesCount](const double timeMs)
+	{
+		return std::to_string(timeMs) + " ms (" + std::to_string((size_t)(trianglesCount / timeMs)) + " triangles/ms)";
+	};
+
+	Log::Print("\tmesh tangents (triangles: " + std::to_string(trianglesCount) + "):");
+	Log::Print("\t\tper-face (non-indexed):  " + toStr(oldTimeMs));
+	Log::Print("\t\tindexed (1 thread):      " + toStr(singleTimeMs));
+	Log::Print("\t\tindexed (" + std::to_string(pool.GetWorkersCount()) + " workers):     " + toStr(parallelTimeMs));
+}
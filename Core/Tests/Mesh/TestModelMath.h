@@ -0,0 +1,20 @@
+// *********************************************************************************
+// Filename:       TestModelMath.h
+// Description:    tests for the mesh math (tangents, binormals, etc.)
+// 
+// Created:        17.10.26
+// *********************************************************************************
+#pragma once
+
+class TestModelMath final
+{
+public:
+	TestModelMath() {}
+	~TestModelMath() {}
+
+	void Run();              // correctness tests
+	void RunBenchmarks();    // performance benchmarks (they aren't run at startup)
+
+	void TestMeshTangents();
+	void BenchmarkMeshTangents();
+};
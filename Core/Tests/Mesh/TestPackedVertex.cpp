@@ -0,0 +1,311 @@
+// *********************************************************************************
+// Filename:       TestPackedVertex.cpp
+// Description:    implementation of tests for packing/unpacking of vertices;
+//
+// Created:        17.10.26
+// *********************************************************************************
+#include "TestPackedVertex.h"
+
+#include "../../GameObjects/VertexPacked.h"
+#include "../../Engine/log.h"
+#include "../../Common/Assert.h"
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+
+// max round-trip errors
+static constexpr float MAX_DIRECTION_ERROR = 0.001f;     // radians
+static constexpr float MAX_TEXCOORD_ERROR  = 0.001f;     // relative to the coord (half floats)
+
+struct PackingErrors
+{
+	float position = 0.0f;
+	float texture  = 0.0f;
+	float normal   = 0.0f;
+	float tangent  = 0.0f;
+	float binormal = 0.0f;
+};
+
+
+static float GetAngle(const XMFLOAT3& vec0, const XMFLOAT3& vec1)
+{
+	// atan2 is used since acos is too imprecise for small angles
+
+	const XMVECTOR v0  = XMLoadFloat3(&vec0);
+	const XMVECTOR v1  = XMLoadFloat3(&vec1);
+	const float    sin = XMVectorGetX(XMVector3Length(XMVector3Cross(v0, v1)));
+	const float    cos = XMVectorGetX(XMVector3Dot(v0, v1));
+
+	return atan2f(sin, cos);
+}
+
+///////////////////////////////////////////////////////////
+
+static XMFLOAT3 GetRandomDirection(std::mt19937& generator)
+{
+	std::uniform_real_distribution<float> distribute(-1.0f, 1.0f);
+	XMVECTOR dir;
+
+	// pick a point inside the unit sphere so directions are uniformly distributed
+	do
+	{
+		dir = XMVectorSet(distribute(generator), distribute(generator), distribute(generator), 0.0f);
+	} while (XMVectorGetX(XMVector3LengthSq(dir)) < 0.0001f || XMVectorGetX(XMVector3LengthSq(dir)) > 1.0f);
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVector3Normalize(dir));
+
+	return result;
+}
+
+///////////////////////////////////////////////////////////
+
+static void GenerateVertices(
+	const u32 count,
+	const BoundingBox& aabb,
+	std::vector<Vertex3D>& outVertices)
+{
+	// generate vertices with positions inside the AABB, orthonormal
+	// tangent frames (half of them are mirrored) and random colors
+
+	std::mt19937 generator(12345);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> texCoord(-4.0f, 4.0f);
+	std::uniform_int_distribution<uint32_t> color(0, UINT32_MAX);
+
+	outVertices.resize(count);
+
+	for (u32 idx = 0; idx < count; ++idx)
+	{
+		Vertex3D& v = outVertices[idx];
+
+		v.position = {
+			aabb.Center.x + aabb.Extents.x * unit(generator),
+			aabb.Center.y + aabb.Extents.y * unit(generator),
+			aabb.Center.z + aabb.Extents.z * unit(generator) };
+
+		v.texture = { texCoord(generator), texCoord(generator) };
+		v.normal  = GetRandomDirection(generator);
+
+		// make the tangent orthogonal to the normal
+		const XMFLOAT3 dir     = GetRandomDirection(generator);
+		const XMVECTOR normal  = XMLoadFloat3(&v.normal);
+		const XMVECTOR randDir = XMLoadFloat3(&dir);
+		const XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(normal, randDir));
+		const float    sign    = (idx & 1) ? -1.0f : 1.0f;
+
+		XMStoreFloat3(&v.tangent, tangent);
+		XMStoreFloat3(&v.binormal, XMVector3Cross(normal, tangent) * sign);
+
+		v.color = PackedVector::XMCOLOR(color(generator));
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static PackingErrors GetErrors(
+	const std::vector<Vertex3D>& origin,
+	const std::vector<Vertex3D>& unpacked)
+{
+	// compute max errors of the unpacked vertices (the position error is by axis);
+	// colors must be exactly the same
+
+	PackingErrors errors;
+
+	Assert::True(origin.size() == unpacked.size(), "wrong number of unpacked vertices");
+
+	for (size_t idx = 0; idx < origin.size(); ++idx)
+	{
+		const Vertex3D& v0 = origin[idx];
+		const Vertex3D& v1 = unpacked[idx];
+
+		const float posErr = std::max({
+			fabsf(v0.position.x - v1.position.x),
+			fabsf(v0.position.y - v1.position.y),
+			fabsf(v0.position.z - v1.position.z) });
+
+		const float texErr = std::max(
+			fabsf(v0.texture.x - v1.texture.x) / std::max(1.0f, fabsf(v0.texture.x)),
+			fabsf(v0.texture.y - v1.texture.y) / std::max(1.0f, fabsf(v0.texture.y)));
+
+		errors.position = std::max(errors.position, posErr);
+		errors.texture  = std::max(errors.texture, texErr);
+		errors.normal   = std::max(errors.normal,   GetAngle(v0.normal,   v1.normal));
+		errors.tangent  = std::max(errors.tangent,  GetAngle(v0.tangent,  v1.tangent));
+		errors.binormal = std::max(errors.binormal, GetAngle(v0.binormal, v1.binormal));
+
+		Assert::True(v0.color.c == v1.color.c, "a color is changed after packing");
+	}
+
+	return errors;
+}
+
+///////////////////////////////////////////////////////////
+
+static void CheckErrors(const PackingErrors& errors, const float maxPositionError)
+{
+	Assert::True(errors.position <= maxPositionError,    "the position error is too big");
+	Assert::True(errors.texture  <= MAX_TEXCOORD_ERROR,  "the texture coords error is too big");
+	Assert::True(errors.normal   <= MAX_DIRECTION_ERROR, "the normal error is too big");
+	Assert::True(errors.tangent  <= MAX_DIRECTION_ERROR, "the tangent error is too big");
+
+	// the binormal is restored from the normal and tangent so the sign must be right
+	Assert::True(errors.binormal <= 2.0f * MAX_DIRECTION_ERROR, "the binormal error is too big (wrong sign?)");
+}
+
+///////////////////////////////////////////////////////////
+
+static void PrintErrors(const char* label, const u32 vertexSize, const PackingErrors& errors)
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf),
+		"\t\t%-16s %2u bytes (%.0f%% of Vertex3D);  max errors: pos %.2e, tex %.2e, normal %.2e rad, tangent %.2e rad, binormal %.2e rad",
+		label,
+		vertexSize,
+		100.0f * vertexSize / sizeof(Vertex3D),
+		errors.position,
+		errors.texture,
+		errors.normal,
+		errors.tangent,
+		errors.binormal);
+
+	Log::Print(buf);
+}
+
+// *********************************************************************************
+
+void TestPackedVertex::Run()
+{
+	Log::Print();
+	Log::Print("----------------  TESTS: PACKED VERTEX  -----------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		TestOctahedralEncoding();
+		TestPackedVertices();
+		TestPackedVertices16();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("TEST PACKED VERTEX: some test doesn't pass");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestPackedVertex::TestOctahedralEncoding()
+{
+	// encode/decode a lot of random directions + axes and diagonals
+	// (the edges of the octahedron are the worst case)
+
+	std::mt19937 generator(777);
+	std::vector<XMFLOAT3> directions =
+	{
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		{ 1, 1, 1 }, { -1, 1, -1 }, { 1, -1, -1 }, { -1, -1, 1 }, { 1, 0, -1 }, { 0, -1, -1 },
+	};
+
+	for (int i = 0; i < 100000; ++i)
+		directions.push_back(GetRandomDirection(generator));
+
+	float maxError = 0.0f;
+
+	for (const XMFLOAT3& dir : directions)
+	{
+		int16_t oct[2];
+		VertexPacking::EncodeOctahedral(dir, oct);
+
+		const XMFLOAT3 decoded = VertexPacking::DecodeOctahedral(oct);
+		maxError = std::max(maxError, GetAngle(dir, decoded));
+	}
+
+	Assert::True(maxError <= MAX_DIRECTION_ERROR, "the error of the octahedral encoding is too big");
+
+	// a zero vector is decoded as +Z (but not as NaN)
+	int16_t oct[2];
+	VertexPacking::EncodeOctahedral({ 0, 0, 0 }, oct);
+	const XMFLOAT3 decoded = VertexPacking::DecodeOctahedral(oct);
+
+	Assert::True((decoded.x == 0.0f) && (decoded.y == 0.0f) && (decoded.z == 1.0f), "a zero vector is decoded wrong");
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "\t\toctahedral (2 x snorm16): max error %.2e rad", maxError);
+	Log::Print(buf);
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestPackedVertex::TestPackedVertices()
+{
+	// positions are stored as is; other attributes are packed
+
+	const BoundingBox aabb({ 10, -5, 300 }, { 50, 20, 100 });
+	std::vector<Vertex3D>     vertices;
+	std::vector<Vertex3D>     unpacked;
+	std::vector<VertexPacked> packed;
+
+	GenerateVertices(10000, aabb, vertices);
+
+	VertexPacking::PackVertices(vertices, packed);
+	VertexPacking::UnpackVertices(packed, unpacked);
+
+	const PackingErrors errors = GetErrors(vertices, unpacked);
+
+	CheckErrors(errors, 0.0f);
+	Assert::True(sizeof(VertexPacked) < sizeof(Vertex3D), "the packed vertex isn't less than Vertex3D");
+
+	PrintErrors("VertexPacked:", sizeof(VertexPacked), errors);
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestPackedVertex::TestPackedVertices16()
+{
+	// positions are quantized relatively to the AABB so the error
+	// must be within a half of the quantization step by each axis
+
+	const BoundingBox aabb({ 10, -5, 300 }, { 50, 20, 100 });
+	std::vector<Vertex3D>       vertices;
+	std::vector<Vertex3D>       unpacked;
+	std::vector<VertexPacked16> packed;
+
+	GenerateVertices(10000, aabb, vertices);
+
+	VertexPacking::PackVertices(vertices, aabb, packed);
+	VertexPacking::UnpackVertices(packed, aabb, unpacked);
+
+	const XMFLOAT3 maxPosErr    = VertexPacking::GetPositionMaxError(aabb);
+	const float    maxPosErrAll = std::max({ maxPosErr.x, maxPosErr.y, maxPosErr.z });
+	const PackingErrors errors  = GetErrors(vertices, unpacked);
+
+	// + a little for float rounding (the AABB is far from the origin)
+	CheckErrors(errors, 1.01f * maxPosErrAll + 1e-4f);
+	Assert::True(2 * sizeof(VertexPacked16) < sizeof(Vertex3D), "the packed vertex isn't less than a half of Vertex3D");
+
+	// a flat mesh (zero size of the AABB by Y): its positions must be exact by Y
+	const BoundingBox flatAABB({ 0, 2, 0 }, { 10, 0, 10 });
+	std::vector<Vertex3D> flatVertices;
+	std::vector<Vertex3D> flatUnpacked;
+
+	GenerateVertices(1000, flatAABB, flatVertices);
+
+	VertexPacking::PackVertices(flatVertices, flatAABB, packed);
+	VertexPacking::UnpackVertices(packed, flatAABB, flatUnpacked);
+
+	for (const Vertex3D& v : flatUnpacked)
+		Assert::True(v.position.y == 2.0f, "a position of the flat mesh is wrong by Y");
+
+	PrintErrors("VertexPacked16:", sizeof(VertexPacked16), errors);
+	Log::Print("\tPASSED");
+}
@@ -0,0 +1,20 @@
+// *********************************************************************************
+// Filename:       TestPackedVertex.h
+// Description:    tests for packing/unpacking of vertices (round-trip errors)
+// 
+// Created:        17.10.26
+// *********************************************************************************
+#pragma once
+
+class TestPackedVertex final
+{
+public:
+	TestPackedVertex() {}
+	~TestPackedVertex() {}
+
+	void Run();
+
+	void TestOctahedralEncoding();
+	void TestPackedVertices();
+	void TestPackedVertices16();
+};
@@ -0,0 +1,538 @@
+// *********************************************************************************
+// Filename:       TestTerrain.cpp
+// Description:    implementation of tests for the terrain related stuff;
+//
+// Created:        17.10.26
+// *********************************************************************************
+#include "TestTerrain.h"
+
+#include "../../GameObjects/TerrainHeightField.h"
+#include "../../GameObjects/TerrainLOD.h"
+#include "../../GameObjects/TerrainStreamer.h"
+#include "../../GameObjects/Vertex.h"
+#include "../../Engine/log.h"
+#include "../../Common/Assert.h"
+#include "Common/ThreadPool.h"        // from the ECS module
+
+#include <chrono>
+#include <cmath>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+using namespace DirectX;
+
+
+static void InitTestHeightField(const u32 verticesCount, TerrainHeightField& heightField)
+{
+	// init a square height-field with some hills (cell size == 1)
+
+	std::vector<float> heights(verticesCount * verticesCount);
+	const float halfSize = 0.5f * (verticesCount - 1);
+
+	for (u32 row = 0, idx = 0; row < verticesCount; ++row)
+	{
+		for (u32 col = 0; col < verticesCount; ++col, ++idx)
+			heights[idx] = 0.1f * (row * sinf(0.1f * col) + col * cosf(0.1f * row));
+	}
+
+	heightField.Initialize(heights, verticesCount, verticesCount, -halfSize, halfSize, 1.0f, 1.0f);
+}
+
+///////////////////////////////////////////////////////////
+
+static void ComputeFacesNormalsOfGrid(const TerrainHeightField& heightField, std::vector<XMFLOAT3>& outNormals)
+{
+	// the reference: vertex normals are averaged normals of faces of the grid mesh
+	// (the same way as it was done for the generated terrain before)
+
+	const u32 vx = heightField.GetVerticesByX();
+	const u32 vz = heightField.GetVerticesByZ();
+	const std::vector<float>& heights = heightField.GetHeights();
+
+	std::vector<XMFLOAT3> positions(heights.size());
+
+	for (u32 row = 0, idx = 0; row < vz; ++row)
+	{
+		for (u32 col = 0; col < vx; ++col, ++idx)
+		{
+			positions[idx].x = heightField.GetMinX() + col * heightField.GetCellSizeX();
+			positions[idx].y = heights[idx];
+			positions[idx].z = heightField.GetMaxZ() - row * heightField.GetCellSizeZ();
+		}
+	}
+
+	outNormals.assign(heights.size(), { 0, 0, 0 });
+
+	auto addFaceNormal = [&](const u32 i0, const u32 i1, const u32 i2)
+	{
+		const XMVECTOR v0 = XMLoadFloat3(&positions[i0]);
+		const XMVECTOR e0 = XMLoadFloat3(&positions[i1]) - v0;
+		const XMVECTOR e1 = XMLoadFloat3(&positions[i2]) - v0;
+		const XMVECTOR n  = XMVector3Cross(e0, e1);
+
+		for (const u32 i : { i0, i1, i2 })
+			XMStoreFloat3(&outNormals[i], XMLoadFloat3(&outNormals[i]) + n);
+	};
+
+	for (u32 row = 0; row < vz - 1; ++row)
+	{
+		for (u32 col = 0; col < vx - 1; ++col)
+		{
+			const u32 a = row * vx + col;
+			const u32 b = a + 1;
+			const u32 c = a + vx;
+			const u32 d = c + 1;
+
+			addFaceNormal(a, b, c);
+			addFaceNormal(c, b, d);
+		}
+	}
+
+	for (XMFLOAT3& n : outNormals)
+		XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+}
+
+// *********************************************************************************
+
+void TestTerrain::Run()
+{
+	Log::Print();
+	Log::Print("----------------  TESTS: TERRAIN  ----------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		TestLODStitching();
+		TestLODSelection();
+		TestTerrainStreaming();
+		TestTerrainNormals();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("TEST TERRAIN: some test doesn't pass");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::RunBenchmarks()
+{
+	Log::Print();
+	Log::Print("--------------  BENCHMARKS: TERRAIN  -------------", ConsoleColor::YELLOW);
+	Log::Print();
+
+	try
+	{
+		BenchmarkTerrainLOD();
+		BenchmarkTerrainNormals();
+	}
+	catch (EngineException& e)
+	{
+		Log::Error(e, false);
+		Log::Error("BENCHMARK TERRAIN: some benchmark failed");
+		exit(-1);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::TestLODStitching()
+{
+	// check indices of each pair [LOD, stitched edges] of a chunk:
+	// 1. triangles cover the whole chunk without overlapping (the sum of
+	//    triangles areas is equal to the chunk area and all of them have
+	//    the same winding order);
+	// 2. stitched edges use only each second vertex of the LOD so they
+	//    match edges of the coarser neighbour chunk
+
+	const u32 verticesCount = 129;
+	const u32 chunkSize = 32;
+
+	TerrainHeightField heightField;
+	TerrainLOD terrainLOD;
+
+	InitTestHeightField(verticesCount, heightField);
+	terrainLOD.Initialize(heightField, chunkSize, 10.0f);
+
+	const std::vector<u32>& indices = terrainLOD.GetIndices();
+	const int stride = (int)verticesCount;
+
+	for (u32 lod = 0; lod + 1 < terrainLOD.GetLODsCount(); ++lod)
+	{
+		for (u32 mask = 0; mask < TerrainLOD::EDGES_COMBINATIONS; ++mask)
+		{
+			const TerrainLOD::IndexRange& range = terrainLOD.GetIndexRange(lod, mask);
+			const std::string msg = " (LOD: " + std::to_string(lod) + "; edges: " + std::to_string(mask) + ")";
+
+			int areaSum = 0;
+			int positiveCount = 0;
+			std::set<int> edgesVertices[4];    // columns/rows of vertices on each edge of the chunk
+
+			for (u32 i = range.startIndex; i < range.startIndex + range.indexCount; i += 3)
+			{
+				int cols[3];
+				int rows[3];
+
+				for (int v = 0; v < 3; ++v)
+				{
+					cols[v] = (int)indices[i + v] % stride;
+					rows[v] = (int)indices[i + v] / stride;
+
+					if (rows[v] == 0)                edgesVertices[0].insert(cols[v]);   // top
+					if (cols[v] == (int)chunkSize)   edgesVertices[1].insert(rows[v]);   // right
+					if (rows[v] == (int)chunkSize)   edgesVertices[2].insert(cols[v]);   // bottom
+					if (cols[v] == 0)                edgesVertices[3].insert(rows[v]);   // left
+				}
+
+				// doubled signed area of the triangle
+				const int area = (cols[1] - cols[0]) * (rows[2] - rows[0]) - (cols[2] - cols[0]) * (rows[1] - rows[0]);
+
+				areaSum += std::abs(area);
+				positiveCount += (area > 0);
+			}
+
+			const int trianglesCount = (int)range.indexCount / 3;
+
+			Assert::True(areaSum == (int)(2 * chunkSize * chunkSize), "triangles don't cover the chunk" + msg);
+			Assert::True((positiveCount == 0) || (positiveCount == trianglesCount), "wrong winding order of triangles" + msg);
+
+			// check vertices of each edge
+			for (u32 edge = 0; edge < 4; ++edge)
+			{
+				const int step = (mask & (1 << edge)) ? (2 << lod) : (1 << lod);
+				int expected = 0;
+
+				for (const int pos : edgesVertices[edge])
+				{
+					Assert::True(pos == expected, "wrong vertex of the edge: " + std::to_string(edge) + msg);
+					expected += step;
+				}
+
+				Assert::True(expected == (int)chunkSize + step, "not all the vertices of the edge are used: " + std::to_string(edge) + msg);
+			}
+		}
+	}
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::TestLODSelection()
+{
+	// check that LODs of neighbour chunks differ by 1 at most and
+	// each chunk has a draw call with indices of its LOD
+
+	const u32 verticesCount = 513;
+	const u32 chunkSize = 32;
+
+	TerrainHeightField heightField;
+	TerrainLOD terrainLOD;
+
+	InitTestHeightField(verticesCount, heightField);
+	terrainLOD.Initialize(heightField, chunkSize, 16.0f);
+
+	// put the camera into the corner of the terrain
+	terrainLOD.SelectLODs({ -256.0f, 10.0f, 256.0f });
+
+	const std::vector<u32>& lods = terrainLOD.GetChunksLODs();
+	const std::vector<TerrainLOD::DrawCall>& drawCalls = terrainLOD.GetDrawCalls();
+	const u32 chunksByX = terrainLOD.GetChunksByX();
+	const u32 chunksByZ = terrainLOD.GetChunksByZ();
+
+	Assert::True(drawCalls.size() == terrainLOD.GetChunksCount(), "wrong number of draw calls");
+	Assert::True(lods.front() == 0, "the nearest chunk must have LOD 0");
+	Assert::True(lods.back() > 0, "the farthest chunk must have a coarser LOD");
+
+	for (u32 cz = 0, idx = 0; cz < chunksByZ; ++cz)
+	{
+		for (u32 cx = 0; cx < chunksByX; ++cx, ++idx)
+		{
+			if (cx + 1 < chunksByX)
+				Assert::True(std::abs((int)lods[idx] - (int)lods[idx + 1]) <= 1, "LODs of neighbour chunks differ by more than 1");
+
+			if (cz + 1 < chunksByZ)
+				Assert::True(std::abs((int)lods[idx] - (int)lods[idx + chunksByX]) <= 1, "LODs of neighbour chunks differ by more than 1");
+
+			const u32 baseVertex = (cz * chunkSize) * verticesCount + (cx * chunkSize);
+			Assert::True(drawCalls[idx].baseVertex == baseVertex, "wrong base vertex of the chunk");
+		}
+	}
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::BenchmarkTerrainLOD()
+{
+	// BENCHMARK: memory and build time of the terrain for different heightmaps:
+	//            non-indexed terrain (6 unique vertices per quad) vs. indexed
+	//            grid with shared vertices + chunked LOD;
+	//
+	// NOTE: memory of vertices is computed (not allocated) so big heightmaps
+	//       can be measured as well
+
+	const u32 sizes[] = { 257, 1025, 4097 };
+	const u32 chunkSize = 64;
+	const float toMB = 1.0f / (1024.0f * 1024.0f);
+
+	for (const u32 verticesCount : sizes)
+	{
+		TerrainHeightField heightField;
+		TerrainLOD terrainLOD;
+
+		auto start = std::chrono::steady_clock::now();
+
+		InitTestHeightField(verticesCount, heightField);
+		terrainLOD.Initialize(heightField, chunkSize, 64.0f);
+
+		auto end = std::chrono::steady_clock::now();
+		const double buildTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+		start = std::chrono::steady_clock::now();
+		terrainLOD.SelectLODs({ 0.0f, 10.0f, 0.0f });
+		end = std::chrono::steady_clock::now();
+		const double selectTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+		// ---------------------------------------------
+
+		const size_t quadsCount       = (size_t)(verticesCount - 1) * (verticesCount - 1);
+		const size_t nonIndexedBytes  = quadsCount * 6 * sizeof(Vertex3D);
+		const size_t sharedVertsBytes = (size_t)verticesCount * verticesCount * sizeof(Vertex3D);
+		const size_t lodIndicesBytes  = terrainLOD.GetIndices().size() * sizeof(u32);
+		const size_t heightsBytes     = heightField.GetHeights().size() * sizeof(float);
+
+		size_t renderedTriangles = 0;
+
+		for (const TerrainLOD::DrawCall& drawCall : terrainLOD.GetDrawCalls())
+			renderedTriangles += drawCall.indexCount / 3;
+
+		const std::string sizeStr = std::to_string(verticesCount) + "x" + std::to_string(verticesCount);
+
+		Log::Print("\tterrain " + sizeStr + " (chunks: " + std::to_string(terrainLOD.GetChunksCount()) + "; LODs: " + std::to_string(terrainLOD.GetLODsCount()) + "):");
+		Log::Print("\t\tnon-indexed vertices:  " + std::to_string(nonIndexedBytes * toMB) + " MB");
+		Log::Print("\t\tshared vertices:       " + std::to_string(sharedVertsBytes * toMB) + " MB");
+		Log::Print("\t\tLOD indices:           " + std::to_string(lodIndicesBytes * toMB) + " MB");
+		Log::Print("\t\theight-field:          " + std::to_string(heightsBytes * toMB) + " MB");
+		Log::Print("\t\tbuild (heights + LOD): " + std::to_string(buildTimeMs) + " ms");
+		Log::Print("\t\tLODs selection:        " + std::to_string(selectTimeMs) + " ms");
+		Log::Print("\t\trendered triangles:    " + std::to_string(renderedTriangles) + " of " + std::to_string(quadsCount * 2));
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::TestTerrainStreaming()
+{
+	// convert a RAW16 heightmap into tiles and check that:
+	// 1. only tiles near the spawn point are loaded at startup;
+	// 2. heights of resident tiles are the same as in the source heightmap;
+	// 3. neighbour tiles have the same vertices on the common edge (no seams);
+	// 4. when the camera moves the number of resident tiles doesn't exceed
+	//    the memory budget (the least recently used tiles are evicted)
+
+	const u32   verticesCount = 129;
+	const u32   tileSize = 32;                           // so there are 4x4 tiles
+	const u32   tileVerts = tileSize + 1;
+	const float heightScale = 10.0f;
+	const float maxZ = (float)(verticesCount - 1);
+	const u32   maxResidentCount = 4;
+	const size_t tileBytes = sizeof(TerrainStreamer::Tile) + tileVerts * tileVerts * (sizeof(Vertex3D) + sizeof(float));
+
+	const std::filesystem::path tmpDir = std::filesystem::temp_directory_path();
+	const std::string rawFilename   = (tmpDir / "test_heightmap.r16").string();
+	const std::string tilesFilename = (tmpDir / "test_heightmap.tiles").string();
+
+	// write the source heightmap
+	std::vector<uint16_t> samples(verticesCount * verticesCount);
+
+	for (u32 i = 0; i < (u32)samples.size(); ++i)
+		samples[i] = (uint16_t)(((i / verticesCount) * 7 + (i % verticesCount) * 13) % 1000);
+
+	FILE* pFile = nullptr;
+	Assert::True(fopen_s(&pFile, rawFilename.c_str(), "wb") == 0, "can't create a test heightmap file");
+	fwrite(samples.data(), sizeof(uint16_t), samples.size(), pFile);
+	fclose(pFile);
+
+	TerrainTilesFile::ConvertHeightmap(
+		rawFilename,
+		TerrainTilesFile::HEIGHTMAP_RAW16,
+		verticesCount,
+		verticesCount,
+		tileSize,
+		1.0f,
+		heightScale,
+		tilesFilename);
+
+	// ---------------------------------------------
+
+	TerrainStreamer streamer;
+	streamer.Initialize(tilesFilename, 40.0f, maxResidentCount * tileBytes);
+
+	// spawn in the upper left corner: only the corner tile and its 2 neighbours are within the radius
+	streamer.LoadAround({ 0.0f, 10.0f, maxZ });
+
+	Assert::True(streamer.GetResidentCount() == 3, "wrong number of tiles are loaded at startup");
+	Assert::True(streamer.GetTileState(0) == TerrainStreamer::TILE_RESIDENT, "the tile under the spawn point isn't loaded");
+
+	// check heights in the square [minCol, minCol + count) x [minRow, minRow + count) of samples
+	auto checkHeights = [&](const u32 minCol, const u32 minRow, const u32 count)
+	{
+		for (u32 row = minRow; row < minRow + count; ++row)
+		{
+			for (u32 col = minCol; col < minCol + count; ++col)
+			{
+				float height = 0.0f;
+				const bool isResident = streamer.GetHeightAtPosition((float)col, maxZ - row, height);
+				const float expected = samples[row * verticesCount + col] / heightScale;
+
+				Assert::True(isResident, "the tile isn't resident");
+				Assert::True(fabsf(height - expected) < 0.001f, "wrong height at (" + std::to_string(col) + ", " + std::to_string(row) + ")");
+			}
+		}
+	};
+
+	checkHeights(0, 0, tileSize);
+
+	// the right edge of the tile 0 == the left edge of the tile 1
+	const TerrainStreamer::Tile* pTile0 = streamer.GetTile(0);
+	const TerrainStreamer::Tile* pTile1 = streamer.GetTile(1);
+
+	for (u32 row = 0; row < tileVerts; ++row)
+	{
+		const Vertex3D& v0 = pTile0->vertices[row * tileVerts + tileSize];
+		const Vertex3D& v1 = pTile1->vertices[row * tileVerts];
+
+		Assert::True(memcmp(&v0.position, &v1.position, sizeof(XMFLOAT3)) == 0, "positions of neighbour tiles don't match");
+		Assert::True(memcmp(&v0.normal,   &v1.normal,   sizeof(XMFLOAT3)) == 0, "normals of neighbour tiles don't match");
+	}
+
+	// ---------------------------------------------
+
+	// move the camera into the lower right corner: new tiles are built by the worker
+	const XMFLOAT3 cameraPos = { maxZ, 10.0f, 0.0f };
+	const u32 cornerTileIdx = streamer.GetTilesCount() - 1;
+
+	streamer.Update(cameraPos);
+	streamer.Flush();
+	streamer.Update(cameraPos);
+
+	Assert::True(streamer.GetResidentCount() <= maxResidentCount, "the memory budget is exceeded");
+	Assert::True(streamer.GetTileState(cornerTileIdx) == TerrainStreamer::TILE_RESIDENT, "the tile under the camera isn't loaded");
+	Assert::True(streamer.GetEvictedTiles().size() == 2, "the least recently used tiles aren't evicted");
+
+	checkHeights(verticesCount - tileVerts, verticesCount - tileVerts, tileVerts);
+
+	streamer.Shutdown();
+	std::filesystem::remove(rawFilename);
+	std::filesystem::remove(tilesFilename);
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::TestTerrainNormals()
+{
+	// check normals which are computed from the height-field by central differences:
+	// 1. for a plane they are exactly the same as averaged normals of faces;
+	// 2. for hills they are equal to averaged normals of faces within a small angle
+	//    (inner vertices are much closer than the border ones where one-sided
+	//    differences are used);
+	// 3. the result of the parallel computation is the same as the single-thread one;
+
+	const u32 verticesCount = 129;
+	const u32 count = verticesCount * verticesCount;
+
+	TerrainHeightField plane;
+	TerrainHeightField hills;
+	std::vector<XMFLOAT3> expected;
+	std::vector<XMFLOAT3> normals(count);
+
+	// check the plane
+	std::vector<float> heights(count);
+
+	for (u32 row = 0, idx = 0; row < verticesCount; ++row)
+	{
+		for (u32 col = 0; col < verticesCount; ++col, ++idx)
+			heights[idx] = 0.3f * col - 0.2f * row;
+	}
+
+	plane.Initialize(heights, verticesCount, verticesCount, 0.0f, 0.0f, 2.0f, 0.5f);
+	plane.ComputeNormals(normals);
+	ComputeFacesNormalsOfGrid(plane, expected);
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		const float dot = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normals[i]), XMLoadFloat3(&expected[i])));
+		Assert::True(dot > 0.99999f, "wrong normal of the plane vertex: " + std::to_string(i));
+	}
+
+	// check the hills
+	InitTestHeightField(verticesCount, hills);
+	hills.ComputeNormals(normals);
+	ComputeFacesNormalsOfGrid(hills, expected);
+
+	for (u32 row = 0, idx = 0; row < verticesCount; ++row)
+	{
+		for (u32 col = 0; col < verticesCount; ++col, ++idx)
+		{
+			const bool isBorder = (row == 0) || (col == 0) || (row == verticesCount - 1) || (col == verticesCount - 1);
+			const float minDot  = (isBorder) ? 0.999f : 0.9999f;
+			const float dot     = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normals[idx]), XMLoadFloat3(&expected[idx])));
+
+			Assert::True(dot > minDot, "wrong normal of the vertex (" + std::to_string(col) + ", " + std::to_string(row) + ")");
+		}
+	}
+
+	// check the parallel computation
+	ECS::ThreadPool pool;
+	std::vector<XMFLOAT3> parallelNormals(count);
+
+	hills.ComputeNormals(parallelNormals, &pool);
+	Assert::True(memcmp(normals.data(), parallelNormals.data(), count * sizeof(XMFLOAT3)) == 0, "the parallel result differs from the single-thread one");
+
+	Log::Print("\tPASSED");
+}
+
+///////////////////////////////////////////////////////////
+
+void TestTerrain::BenchmarkTerrainNormals()
+{
+	// BENCHMARK: averaging of faces normals vs. central differences (1/N threads)
+
+	const u32 benchVerticesCount = 2049;
+	TerrainHeightField benchField;
+	InitTestHeightField(benchVerticesCount, benchField);
+
+	ECS::ThreadPool pool;
+	std::vector<XMFLOAT3> facesNormals;
+	std::vector<XMFLOAT3> benchNormals((size_t)benchVerticesCount * benchVerticesCount);
+
+	auto start = std::chrono::steady_clock::now();
+	ComputeFacesNormalsOfGrid(benchField, facesNormals);
+	auto end = std::chrono::steady_clock::now();
+	const double facesTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+	start = std::chrono::steady_clock::now();
+	benchField.ComputeNormals(benchNormals);
+	end = std::chrono::steady_clock::now();
+	const double singleTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+	start = std::chrono::steady_clock::now();
+	benchField.ComputeNormals(benchNormals, &pool);
+	end = std::chrono::steady_clock::now();
+	const double parallelTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+	const std::string sizeStr = std::to_string(benchVerticesCount) + "x" + std::to_string(benchVerticesCount);
+
+	Log::Print("\tterrain normals " + sizeStr + ":");
+	Log::Print("\t\tfaces normals averaging:        " + std::to_string(facesTimeMs) + " ms");
+	Log::Print("\t\tcentral differences (1 thread): " + std::to_string(singleTimeMs) + " ms");
+	Log::Print("\t\tcentral differences (" + std::to_string(pool.GetWorkersCount()) + " workers): " + std::to_string(parallelTimeMs) + " ms");
+}
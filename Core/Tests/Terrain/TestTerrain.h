@@ -0,0 +1,25 @@
+// *********************************************************************************
+// Filename:       TestTerrain.h
+// Description:    tests for the terrain related stuff (height-field, LOD, etc.)
+// 
+// Created:        17.10.26
+// *********************************************************************************
+#pragma once
+
+class TestTerrain final
+{
+public:
+	TestTerrain() {}
+	~TestTerrain() {}
+
+	void Run();              // correctness tests
+	void RunBenchmarks();    // performance benchmarks (they aren't run at startup)
+
+	void TestLODStitching();
+	void TestLODSelection();
+	void TestTerrainStreaming();
+	void TestTerrainNormals();
+
+	void BenchmarkTerrainLOD();
+	void BenchmarkTerrainNormals();
+};
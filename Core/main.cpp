@@ -5,7 +5,9 @@
 #include "Engine/Engine.h"
 #include "Engine/Settings.h"
 
-int main()
+#include <cstring>
+
+int main(int argc, char* argv[])
 {
 #if defined(DEBUG) | defined(_DEBUG)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
@@ -13,6 +15,17 @@ int main()
 
 	HINSTANCE hInstance = GetModuleHandle(NULL);
 	Log logger;          // ATTENTION: put the declation of logger before all the others; this instance is necessary to create a logger text file
+
+	// "-bench": only run performance benchmarks of the engine modules
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-bench") == 0)
+		{
+			Engine::RunBenchmarks();
+			return 0;
+		}
+	}
+
 	Engine engine;
 	HWND mainWnd;
 	
@@ -0,0 +1,499 @@
+// *********************************************************************************
+// Filename:     BVH.cpp
+// Description:  implementation of the dynamic bounding volume hierarchy
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "BVH.h"
+#include "Assert.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace ECS
+{
+
+static inline float GetAxisValue(const XMFLOAT3& v, const u32 axis)
+{
+	return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+///////////////////////////////////////////////////////////
+
+static bool IntersectRayNode(
+	const XMVECTOR& origin,
+	const XMVECTOR& invDir,
+	const XMVECTOR& isParallel,      // mask of axes along which the ray direction is zero
+	const XMFLOAT3& boxMin,
+	const XMFLOAT3& boxMax,
+	float& outDist)
+{
+	// the slab test of a ray against AABB;
+	// out: distance to the entry point (0 if the origin is inside the box)
+
+	const XMVECTOR vMin = XMLoadFloat3(&boxMin);
+	const XMVECTOR vMax = XMLoadFloat3(&boxMax);
+
+	// a ray which is parallel to a slab is inside it for any distance or never;
+	// (its distances are computed as (0 * inf = NaN) so they are replaced)
+	const XMVECTOR isInsideSlab = XMVectorAndInt(XMVectorGreaterOrEqual(origin, vMin), XMVectorLessOrEqual(origin, vMax));
+
+	if (!XMVector3EqualInt(XMVectorAndCInt(isParallel, isInsideSlab), XMVectorFalseInt()))
+		return false;
+
+	const XMVECTOR t1 = XMVectorSelect(XMVectorMultiply(XMVectorSubtract(vMin, origin), invDir), g_XMNegInfinity, isParallel);
+	const XMVECTOR t2 = XMVectorSelect(XMVectorMultiply(XMVectorSubtract(vMax, origin), invDir), g_XMInfinity, isParallel);
+
+	XMFLOAT3 tMin;
+	XMFLOAT3 tMax;
+	XMStoreFloat3(&tMin, XMVectorMin(t1, t2));
+	XMStoreFloat3(&tMax, XMVectorMax(t1, t2));
+
+	const float tNear = std::max({ tMin.x, tMin.y, tMin.z, 0.0f });
+	const float tFar  = std::min({ tMax.x, tMax.y, tMax.z });
+
+	outDist = tNear;
+	return tNear <= tFar;
+}
+
+
+// *********************************************************************************
+//                            BUILDING / UPDATING API
+// *********************************************************************************
+
+void BVH::Build(
+	const std::vector<EntityID>& ids,
+	const std::vector<DirectX::BoundingBox>& boxes)
+{
+	// build the tree from scratch over input boxes (the box idx is the item idx)
+
+	Assert::True(ids.size() == boxes.size(), "count of IDs != count of boxes");
+
+	Clear();
+
+	const u32 itemsCount = (u32)ids.size();
+
+	if (itemsCount == 0)
+		return;
+
+	std::vector<XMFLOAT3> centers(itemsCount);
+	std::vector<u32> items(itemsCount);
+
+	for (u32 i = 0; i < itemsCount; ++i)
+	{
+		centers[i] = boxes[i].Center;
+		items[i] = i;
+	}
+
+	ids_ = ids;
+	itemNodes_.resize(itemsCount);
+	nodes_.reserve(2 * itemsCount - 1);
+
+	// create leaves and set their boxes
+	BuildNode(items.data(), 0, itemsCount, centers);
+
+	for (u32 i = 0; i < itemsCount; ++i)
+	{
+		Node& leaf = nodes_[itemNodes_[i]];
+		XMStoreFloat3(&leaf.min, XMVectorSubtract(XMLoadFloat3(&boxes[i].Center), XMLoadFloat3(&boxes[i].Extents)));
+		XMStoreFloat3(&leaf.max, XMVectorAdd(XMLoadFloat3(&boxes[i].Center), XMLoadFloat3(&boxes[i].Extents)));
+	}
+
+	// compute boxes of inner nodes bottom-up: children always have bigger idxs than
+	// their parent so we can go from the end of the nodes arr to its beginning
+	for (size i = std::ssize(nodes_) - 1; i >= 0; --i)
+	{
+		Node& node = nodes_[i];
+
+		if (node.item == INVALID_NODE)
+		{
+			UnionChildren(node);
+			buildCost_ += GetSurfaceArea(node);
+		}
+	}
+
+	currCost_ = buildCost_;
+	++stats_.rebuildsCount;
+}
+
+///////////////////////////////////////////////////////////
+
+void BVH::UpdateItem(const u32 itemIdx, const DirectX::BoundingBox& box)
+{
+	// set a new box of the item and refit boxes of its ancestors;
+	// we stop refitting when the box of some ancestor isn't changed
+
+	if (itemIdx >= (u32)itemNodes_.size())
+		throw LIB_Exception("there is no BVH item by idx: " + std::to_string(itemIdx));
+
+	Node& leaf = nodes_[itemNodes_[itemIdx]];
+	XMStoreFloat3(&leaf.min, XMVectorSubtract(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents)));
+	XMStoreFloat3(&leaf.max, XMVectorAdd(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents)));
+
+	++stats_.refitsCount;
+
+	for (u32 nodeIdx = leaf.parent; nodeIdx != INVALID_NODE; nodeIdx = nodes_[nodeIdx].parent)
+	{
+		Node& node = nodes_[nodeIdx];
+		const Node prevNode = node;
+
+		UnionChildren(node);
+
+		const bool isChanged =
+			(node.min.x != prevNode.min.x) || (node.min.y != prevNode.min.y) || (node.min.z != prevNode.min.z) ||
+			(node.max.x != prevNode.max.x) || (node.max.y != prevNode.max.y) || (node.max.z != prevNode.max.z);
+
+		if (!isChanged)
+			break;
+
+		currCost_ += GetSurfaceArea(node) - GetSurfaceArea(prevNode);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void BVH::Clear()
+{
+	nodes_.clear();
+	ids_.clear();
+	itemNodes_.clear();
+
+	buildCost_ = 0;
+	currCost_ = 0;
+}
+
+
+// *********************************************************************************
+//                                 QUERY API
+// *********************************************************************************
+
+void BVH::QueryFrustum(
+	const XMVECTOR* planes,
+	std::vector<EntityID>& outIDs) const
+{
+	// out: IDs of items whose boxes are (maybe partially) inside the frustum;
+	//
+	// if a node is completely in front of some plane its children aren't tested
+	// against this plane anymore; if a node is completely inside the frustum
+	// we take all its leaves without any tests
+
+	struct Entry
+	{
+		u32 nodeIdx;
+		u32 planesMask;     // planes which still must be tested
+	};
+
+	constexpr u32 allPlanesMask = 0x3F;
+
+	outIDs.clear();
+
+	if (nodes_.empty())
+		return;
+
+	Entry stack[MAX_DEPTH];
+	u32 top = 0;
+	stack[top++] = { 0, allPlanesMask };
+
+	while (top > 0)
+	{
+		const Entry entry = stack[--top];
+		const Node& node = nodes_[entry.nodeIdx];
+		++stats_.nodesVisited;
+
+		const XMVECTOR boxMin  = XMLoadFloat3(&node.min);
+		const XMVECTOR boxMax  = XMLoadFloat3(&node.max);
+		const XMVECTOR center  = XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f);
+		const XMVECTOR extents = XMVectorScale(XMVectorSubtract(boxMax, boxMin), 0.5f);
+
+		u32 planesMask = entry.planesMask;
+		bool isOutside = false;
+
+		for (u32 i = 0; i < 6; ++i)
+		{
+			if (!(planesMask & (1u << i)))
+				continue;
+
+			const float dist   = XMVectorGetX(XMPlaneDotCoord(planes[i], center));
+			const float radius = XMVectorGetX(XMVector3Dot(XMVectorAbs(planes[i]), extents));
+
+			if (dist + radius < 0)
+			{
+				isOutside = true;
+				break;
+			}
+
+			// the box is completely in front of the plane
+			if (dist - radius >= 0)
+				planesMask &= ~(1u << i);
+		}
+
+		if (isOutside)
+			continue;
+
+		if (node.item != INVALID_NODE)
+		{
+			++stats_.leavesTested;
+			outIDs.push_back(ids_[node.item]);
+		}
+		else if (planesMask == 0)
+		{
+			CollectLeaves(entry.nodeIdx, outIDs);
+		}
+		else
+		{
+			stack[top++] = { node.right, planesMask };
+			stack[top++] = { node.left, planesMask };
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+bool BVH::RayCast(
+	const XMVECTOR& origin,
+	const XMVECTOR& dir,
+	EntityID& outID,
+	float& outDist) const
+{
+	// find the nearest item whose box is intersected by the ray;
+	// return: false if there is no intersection at all
+	// out:    ID of the nearest item and distance to it (in units of the dir length)
+
+	if (nodes_.empty())
+		return false;
+
+	// a zero (or denormal) component of the direction gives an infinite reciprocal
+	// and then 0 * inf = NaN in the slab test if the origin lies on a slab plane;
+	// so slabs along such axes are checked explicitly
+	const XMVECTOR invDir     = XMVectorReciprocal(dir);
+	const XMVECTOR isParallel = XMVectorLess(XMVectorAbs(dir), XMVectorReplicate(FLT_MIN));
+
+	float nearestDist = FLT_MAX;
+	bool isHit = false;
+
+	u32 stack[MAX_DEPTH];
+	u32 top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes_[stack[--top]];
+		++stats_.nodesVisited;
+
+		float dist = 0;
+
+		// skip nodes which aren't intersected or are farther than the nearest found item
+		if (!IntersectRayNode(origin, invDir, isParallel, node.min, node.max, dist) || (dist > nearestDist))
+			continue;
+
+		if (node.item != INVALID_NODE)
+		{
+			++stats_.leavesTested;
+			nearestDist = dist;
+			outID = ids_[node.item];
+			isHit = true;
+		}
+		else
+		{
+			stack[top++] = node.right;
+			stack[top++] = node.left;
+		}
+	}
+
+	outDist = nearestDist;
+	return isHit;
+}
+
+///////////////////////////////////////////////////////////
+
+void BVH::QuerySphere(
+	const DirectX::BoundingSphere& sphere,
+	std::vector<EntityID>& outIDs) const
+{
+	// out: IDs of items whose boxes overlap the sphere
+
+	const XMVECTOR center = XMLoadFloat3(&sphere.Center);
+	const float radiusSq = sphere.Radius * sphere.Radius;
+
+	QueryOverlap([center, radiusSq](const Node& node)
+	{
+		// squared distance from the sphere center to the closest point of the box
+		const XMVECTOR d = XMVectorAdd(
+			XMVectorMax(XMVectorSubtract(XMLoadFloat3(&node.min), center), g_XMZero),
+			XMVectorMax(XMVectorSubtract(center, XMLoadFloat3(&node.max)), g_XMZero));
+
+		return XMVectorGetX(XMVector3LengthSq(d)) <= radiusSq;
+	},
+	outIDs);
+}
+
+///////////////////////////////////////////////////////////
+
+void BVH::QueryBox(
+	const DirectX::BoundingBox& box,
+	std::vector<EntityID>& outIDs) const
+{
+	// out: IDs of items whose boxes overlap the input box
+
+	const XMVECTOR boxMin = XMVectorSubtract(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents));
+	const XMVECTOR boxMax = XMVectorAdd(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents));
+
+	QueryOverlap([boxMin, boxMax](const Node& node)
+	{
+		return XMVector3LessOrEqual(XMLoadFloat3(&node.min), boxMax) &&
+			   XMVector3GreaterOrEqual(XMLoadFloat3(&node.max), boxMin);
+	},
+	outIDs);
+}
+
+
+// *********************************************************************************
+//                                PRIVATE HELPERS
+// *********************************************************************************
+
+u32 BVH::BuildNode(
+	u32* items,
+	const u32 first,
+	const u32 last,
+	const std::vector<XMFLOAT3>& centers)
+{
+	// recursively build a subtree over items in range [first, last);
+	// return: idx of the subtree root
+	//
+	// NOTE: boxes of nodes are computed after building of the whole tree
+
+	const u32 nodeIdx = (u32)nodes_.size();
+	nodes_.emplace_back();
+
+	if (last - first == 1)
+	{
+		nodes_[nodeIdx].item = items[first];
+		itemNodes_[items[first]] = nodeIdx;
+		return nodeIdx;
+	}
+
+	// split items by the median of centers along the longest axis of the centers bounds
+	XMVECTOR centersMin = XMLoadFloat3(&centers[items[first]]);
+	XMVECTOR centersMax = centersMin;
+
+	for (u32 i = first + 1; i < last; ++i)
+	{
+		const XMVECTOR center = XMLoadFloat3(&centers[items[i]]);
+		centersMin = XMVectorMin(centersMin, center);
+		centersMax = XMVectorMax(centersMax, center);
+	}
+
+	XMFLOAT3 spread;
+	XMStoreFloat3(&spread, XMVectorSubtract(centersMax, centersMin));
+
+	const u32 axis = ((spread.x >= spread.y) && (spread.x >= spread.z)) ? 0 : ((spread.y >= spread.z) ? 1 : 2);
+	const u32 mid = first + (last - first) / 2;
+
+	std::nth_element(items + first, items + mid, items + last, [&centers, axis](const u32 a, const u32 b)
+	{
+		return GetAxisValue(centers[a], axis) < GetAxisValue(centers[b], axis);
+	});
+
+	const u32 left  = BuildNode(items, first, mid, centers);
+	const u32 right = BuildNode(items, mid, last, centers);
+
+	nodes_[nodeIdx].left = left;
+	nodes_[nodeIdx].right = right;
+	nodes_[left].parent = nodeIdx;
+	nodes_[right].parent = nodeIdx;
+
+	return nodeIdx;
+}
+
+///////////////////////////////////////////////////////////
+
+void BVH::UnionChildren(Node& node) const
+{
+	// set the box of an inner node so it encloses boxes of its children
+
+	const Node& left = nodes_[node.left];
+	const Node& right = nodes_[node.right];
+
+	XMStoreFloat3(&node.min, XMVectorMin(XMLoadFloat3(&left.min), XMLoadFloat3(&right.min)));
+	XMStoreFloat3(&node.max, XMVectorMax(XMLoadFloat3(&left.max), XMLoadFloat3(&right.max)));
+}
+
+///////////////////////////////////////////////////////////
+
+void BVH::CollectLeaves(const u32 nodeIdx, std::vector<EntityID>& outIDs) const
+{
+	// add IDs of all the leaves of the subtree without any tests
+
+	u32 stack[MAX_DEPTH];
+	u32 top = 0;
+	stack[top++] = nodeIdx;
+
+	while (top > 0)
+	{
+		const Node& node = nodes_[stack[--top]];
+		++stats_.nodesVisited;
+
+		if (node.item != INVALID_NODE)
+		{
+			outIDs.push_back(ids_[node.item]);
+		}
+		else
+		{
+			stack[top++] = node.right;
+			stack[top++] = node.left;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+template <class OverlapFunc>
+void BVH::QueryOverlap(const OverlapFunc& overlaps, std::vector<EntityID>& outIDs) const
+{
+	// out: IDs of items whose boxes pass the overlap test;
+	// a subtree is skipped if the box of its root doesn't overlap
+
+	outIDs.clear();
+
+	if (nodes_.empty())
+		return;
+
+	u32 stack[MAX_DEPTH];
+	u32 top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes_[stack[--top]];
+		++stats_.nodesVisited;
+
+		if (!overlaps(node))
+			continue;
+
+		if (node.item != INVALID_NODE)
+		{
+			++stats_.leavesTested;
+			outIDs.push_back(ids_[node.item]);
+		}
+		else
+		{
+			stack[top++] = node.right;
+			stack[top++] = node.left;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+float BVH::GetSurfaceArea(const Node& node)
+{
+	const float dx = node.max.x - node.min.x;
+	const float dy = node.max.y - node.min.y;
+	const float dz = node.max.z - node.min.z;
+
+	return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+} // namespace ECS
@@ -0,0 +1,115 @@
+// *********************************************************************************
+// Filename:     BVH.h
+// Description:  a dynamic bounding volume hierarchy over world space AABBs of
+//               entities; is used for hierarchical frustum culling, ray picking
+//               and sphere/box overlap queries;
+//
+//               the tree is built top-down by splitting items by the median of
+//               their centers along the longest axis (one item per leaf); when
+//               a box of some item is changed the tree isn't rebuilt but boxes of
+//               the leaf ancestors are refitted; refitting makes the tree worse
+//               over time so we track the summary surface area of inner nodes
+//               and if it grows too much the tree has to be rebuilt;
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "Types.h"
+
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace ECS
+{
+
+struct BVHStats
+{
+	u32 nodesVisited  = 0;      // number of visited nodes during queries
+	u32 leavesTested  = 0;      // number of tested leaves (items) during queries
+	u32 refitsCount   = 0;      // number of leaves which were refitted
+	u32 rebuildsCount = 0;      // number of full rebuilds of the tree
+};
+
+///////////////////////////////////////////////////////////
+
+class BVH
+{
+public:
+	static constexpr u32   INVALID_NODE       = UINT32_MAX;
+	static constexpr u32   MAX_DEPTH          = 64;      // the tree is balanced so it is enough for any number of items
+	static constexpr float REBUILD_COST_RATIO = 1.5f;    // rebuild the tree when the cost grows by 50% after refits
+
+
+	// ----------------------------------------------------
+	// building / updating API
+
+	void Build(
+		const std::vector<EntityID>& ids,
+		const std::vector<DirectX::BoundingBox>& boxes);
+
+	void UpdateItem(const u32 itemIdx, const DirectX::BoundingBox& box);
+	void Clear();
+
+	inline bool NeedsRebuild() const { return currCost_ > buildCost_ * REBUILD_COST_RATIO; }
+
+
+	// ----------------------------------------------------
+	// query API
+
+	void QueryFrustum(
+		const XMVECTOR* planes,                     // 6 normalized planes of the frustum (normals point inside)
+		std::vector<EntityID>& outIDs) const;
+
+	bool RayCast(
+		const XMVECTOR& origin,
+		const XMVECTOR& dir,
+		EntityID& outID,
+		float& outDist) const;
+
+	void QuerySphere(
+		const DirectX::BoundingSphere& sphere,
+		std::vector<EntityID>& outIDs) const;
+
+	void QueryBox(
+		const DirectX::BoundingBox& box,
+		std::vector<EntityID>& outIDs) const;
+
+	inline size GetItemsCount() const { return std::ssize(ids_); }
+	inline size GetNodesCount() const { return std::ssize(nodes_); }
+
+	inline const BVHStats& GetStats() const { return stats_; }
+	inline void ResetStats() { stats_ = BVHStats(); }
+
+private:
+	struct Node
+	{
+		XMFLOAT3 min;
+		u32      parent = INVALID_NODE;
+		XMFLOAT3 max;
+		u32      left   = INVALID_NODE;   // children of an inner node
+		u32      right  = INVALID_NODE;
+		u32      item   = INVALID_NODE;   // item idx of a leaf (INVALID_NODE for inner nodes)
+	};
+
+	u32  BuildNode(u32* items, const u32 first, const u32 last, const std::vector<XMFLOAT3>& centers);
+	void UnionChildren(Node& node) const;
+	void CollectLeaves(const u32 nodeIdx, std::vector<EntityID>& outIDs) const;
+
+	template <class OverlapFunc>
+	void QueryOverlap(const OverlapFunc& overlaps, std::vector<EntityID>& outIDs) const;
+
+	static float GetSurfaceArea(const Node& node);
+
+private:
+	std::vector<Node>     nodes_;          // nodes_[0] is the root
+	std::vector<EntityID> ids_;            // ID of each item
+	std::vector<u32>      itemNodes_;      // leaf node idx of each item
+
+	float buildCost_ = 0;                  // summary surface area of inner nodes right after building
+	float currCost_  = 0;                  // current summary surface area of inner nodes
+
+	mutable BVHStats stats_;               // NOTE: counters aren't thread-safe
+};
+
+} // namespace ECS
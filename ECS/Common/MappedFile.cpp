@@ -0,0 +1,81 @@
+// *********************************************************************************
+// Filename:     MappedFile.cpp
+// Description:  implementation of the MappedFile
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "MappedFile.h"
+#include "Assert.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+namespace ECS
+{
+
+void MappedFile::Open(const std::string& filepath, const AccessPattern access)
+{
+	Close();
+
+	// let the OS know how the file is read so it can prefetch pages (or not)
+	const DWORD accessFlag = (access == ACCESS_RANDOM) ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+
+	HANDLE hFile = CreateFileA(
+		filepath.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | accessFlag,
+		nullptr);
+
+	Assert::True(hFile != INVALID_HANDLE_VALUE, "can't open a file for mapping: " + filepath);
+	hFile_ = hFile;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || (fileSize.QuadPart == 0))
+	{
+		Close();
+		throw LIB_Exception("can't map an empty file (or can't get its size): " + filepath);
+	}
+
+	// map the whole file
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (hMapping == nullptr)
+	{
+		Close();
+		throw LIB_Exception("can't create a mapping of the file: " + filepath);
+	}
+	hMapping_ = hMapping;
+
+	const void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (pView == nullptr)
+	{
+		Close();
+		throw LIB_Exception("can't map a view of the file: " + filepath);
+	}
+
+	pData_ = (const uint8_t*)pView;
+	size_  = (uint64_t)fileSize.QuadPart;
+}
+
+///////////////////////////////////////////////////////////
+
+void MappedFile::Close()
+{
+	if (pData_)
+		UnmapViewOfFile(pData_);
+
+	if (hMapping_)
+		CloseHandle((HANDLE)hMapping_);
+
+	if (hFile_)
+		CloseHandle((HANDLE)hFile_);
+
+	pData_    = nullptr;
+	hMapping_ = nullptr;
+	hFile_    = nullptr;
+	size_     = 0;
+}
+
+} // namespace ECS
@@ -0,0 +1,55 @@
+// *********************************************************************************
+// Filename:     MappedFile.h
+// Description:  a read-only mapping of the whole file into the address space;
+//
+//               the content of the file is accessed directly through the returned
+//               pointer: pages are loaded by the OS on the first access so there is
+//               no intermediate buffer and no read calls; the view starts
+//               at the beginning of a page so its address is aligned at least
+//               by 4096 bytes;
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "Types.h"
+
+#include <string>
+
+namespace ECS
+{
+
+class MappedFile final
+{
+public:
+	enum AccessPattern
+	{
+		ACCESS_SEQUENTIAL,      // the file is read from the beginning to the end
+		ACCESS_RANDOM,          // only some parts of the file are read (for instance: tiles of a big terrain)
+	};
+
+public:
+	MappedFile() {}
+	~MappedFile() { Close(); }
+
+	// restrict any copying of instances of this class
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// throw LIB_Exception if we can't map the file;
+	// the access pattern is a hint for the OS how to cache pages of the file
+	void Open(const std::string& filepath, const AccessPattern access = ACCESS_SEQUENTIAL);
+	void Close();
+
+	inline bool           IsOpen()  const { return pData_ != nullptr; }
+	inline const uint8_t* GetData() const { return pData_; }
+	inline uint64_t       GetSize() const { return size_; }
+
+private:
+	void*          hFile_ = nullptr;            // HANDLE of the file
+	void*          hMapping_ = nullptr;         // HANDLE of the file mapping object
+	const uint8_t* pData_ = nullptr;            // the beginning of the mapped view
+	uint64_t       size_ = 0;
+};
+
+} // namespace ECS
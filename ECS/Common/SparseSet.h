@@ -0,0 +1,237 @@
+// *********************************************************************************
+// Filename:     SparseSet.h
+// Description:  a sparse set which maps an entity ID to an index into the dense
+//               data arrays of some ECS component (or the EntityManager);
+//
+//               the dense arrays (ids_ + data arrays) are stored in the component
+//               itself and are only appended to, so adding of records costs O(1)
+//               instead of a sorted insertion; the sparse part is split into pages
+//               which are allocated only when some ID from its range is added;
+//
+//               the set is addressed by the index bits of an entity ID and stores
+//               the whole ID in a slot so a stale ID (an ID of the destroyed entity
+//               whose index was reused) won't be found in the set;
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "Types.h"
+#include <vector>
+#include <utility>
+
+namespace ECS
+{
+
+class SparseSet
+{
+public:
+	static constexpr u32 PAGE_SIZE   = 4096;         // number of records in a single page
+	static constexpr u32 INVALID_IDX = UINT32_MAX;   // there is no data idx for such an ID
+
+
+	// ----------------------------------------------------
+	// query API
+
+	inline bool Has(const EntityID id) const
+	{
+		return GetIdx(id) != -1;
+	}
+
+	// ----------------------------------------------------
+
+	inline ptrdiff_t GetIdx(const EntityID id) const
+	{
+		// return: data idx of ID in the dense arrays or -1 if there is no such ID
+
+		const u32 enttIdx = GetEnttIdx(id);
+		const size_t pageIdx = enttIdx / PAGE_SIZE;
+
+		if ((pageIdx >= pages_.size()) || pages_[pageIdx].empty())
+			return -1;
+
+		const Slot& slot = pages_[pageIdx][enttIdx % PAGE_SIZE];
+		return ((slot.dataIdx != INVALID_IDX) && (slot.id == id)) ? (ptrdiff_t)slot.dataIdx : -1;
+	}
+
+	// ----------------------------------------------------
+
+	void GetIdxs(
+		const std::vector<EntityID>& ids,
+		std::vector<ptrdiff_t>& outIdxs) const
+	{
+		// out: data idx of each input ID (or -1 if there is no such ID)
+
+		outIdxs.resize(ids.size());
+
+		for (size_t i = 0; const EntityID id : ids)
+			outIdxs[i++] = GetIdx(id);
+	}
+
+	// ----------------------------------------------------
+
+	void GetExistingFlags(
+		const std::vector<EntityID>& ids,
+		std::vector<bool>& outFlags) const
+	{
+		// out: arr of boolean flags which define if input IDs exist in the set or not
+
+		outFlags.resize(ids.size());
+
+		for (size_t i = 0; const EntityID id : ids)
+			outFlags[i++] = Has(id);
+	}
+
+	// ----------------------------------------------------
+
+	bool HasAll(const std::vector<EntityID>& ids) const
+	{
+		// return: true if each input ID exists in the set
+
+		bool hasAll = true;
+
+		for (const EntityID id : ids)
+			hasAll &= Has(id);
+
+		return hasAll;
+	}
+
+	// ----------------------------------------------------
+
+	bool HasAny(const std::vector<EntityID>& ids) const
+	{
+		// return: true if at least one of input IDs exists in the set
+
+		bool hasAny = false;
+
+		for (const EntityID id : ids)
+			hasAny |= Has(id);
+
+		return hasAny;
+	}
+
+
+	// ----------------------------------------------------
+	// modification API
+
+	inline void Add(const EntityID id, const ptrdiff_t dataIdx)
+	{
+		// bind the input ID to the data idx in the dense arrays
+
+		const u32 enttIdx = GetEnttIdx(id);
+		GetPage(enttIdx / PAGE_SIZE)[enttIdx % PAGE_SIZE] = { (u32)dataIdx, id };
+	}
+
+	// ----------------------------------------------------
+
+	void Add(const std::vector<EntityID>& ids, const ptrdiff_t firstDataIdx)
+	{
+		// batch version: it is supposed that records of input IDs were
+		// appended to the end of the dense arrays starting from firstDataIdx
+
+		for (ptrdiff_t dataIdx = firstDataIdx; const EntityID id : ids)
+			Add(id, dataIdx++);
+	}
+
+	// ----------------------------------------------------
+
+	inline void Remove(const EntityID id)
+	{
+		const u32 enttIdx = GetEnttIdx(id);
+		const size_t pageIdx = enttIdx / PAGE_SIZE;
+
+		if ((pageIdx >= pages_.size()) || pages_[pageIdx].empty())
+			return;
+
+		Slot& slot = pages_[pageIdx][enttIdx % PAGE_SIZE];
+
+		// we don't touch the slot if it is already bound to another generation of the ID
+		if (slot.id == id)
+			slot = Slot();
+	}
+
+	// ----------------------------------------------------
+
+	template <class... DataArrs>
+	void SwapAndPop(
+		const std::vector<EntityID>& idsToRemove,
+		std::vector<EntityID>& denseIDs,
+		DataArrs&... dataArrs)
+	{
+		// remove records of input IDs from the dense arrays in O(k): the last record
+		// of each dense arr is moved into the place of the removed one so the dense
+		// arrays stay compact (but the order of records isn't preserved);
+		// 
+		// NOTE: input IDs which aren't in the set are skipped
+		//
+		// in:  idsToRemove -- IDs of records to remove
+		// out: denseIDs    -- arr of IDs of the component
+		//      dataArrs    -- all the data arrays of the component (parallel to denseIDs)
+
+		for (const EntityID id : idsToRemove)
+		{
+			const ptrdiff_t idx = GetIdx(id);
+
+			if (idx == -1)
+				continue;
+
+			const ptrdiff_t lastIdx = std::ssize(denseIDs) - 1;
+
+			if (idx != lastIdx)
+			{
+				denseIDs[idx] = denseIDs[lastIdx];
+				((dataArrs[idx] = std::move(dataArrs[lastIdx])), ...);
+
+				// rebind the moved record
+				Add(denseIDs[idx], idx);
+			}
+
+			denseIDs.pop_back();
+			(dataArrs.pop_back(), ...);
+			Remove(id);
+		}
+	}
+
+	// ----------------------------------------------------
+
+	void Rebuild(const std::vector<EntityID>& denseIDs)
+	{
+		// rebuild the whole mapping from the dense arr of IDs
+		// (for instance: after deserialization of the component data)
+
+		Clear();
+		Add(denseIDs, 0);
+	}
+
+	// ----------------------------------------------------
+
+	inline void Clear()
+	{
+		pages_.clear();
+	}
+
+private:
+	struct Slot
+	{
+		u32      dataIdx = INVALID_IDX;         // idx of the record in the dense arrays
+		EntityID id      = INVALID_ENTITY_ID;   // full ID (with generation) bound to this slot
+	};
+
+	std::vector<Slot>& GetPage(const size_t pageIdx)
+	{
+		// return a page by idx; if there is no such page yet we allocate it
+
+		if (pageIdx >= pages_.size())
+			pages_.resize(pageIdx + 1);
+
+		if (pages_[pageIdx].empty())
+			pages_[pageIdx].resize(PAGE_SIZE);
+
+		return pages_[pageIdx];
+	}
+
+private:
+	std::vector<std::vector<Slot>> pages_;    // an empty page means that there are no IDs from its range
+};
+
+} // namespace ECS
@@ -0,0 +1,247 @@
+// *********************************************************************************
+// Filename:     ThreadPool.cpp
+// Description:  implementation of the work-stealing pool of worker threads
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "ThreadPool.h"
+
+namespace ECS
+{
+
+// the pool and the queue idx of the current worker thread
+// (for non-worker threads the pool ptr is nullptr)
+static thread_local const ThreadPool* tl_pPool = nullptr;
+static thread_local u32               tl_queueIdx = 0;
+
+
+ThreadPool::ThreadPool(const u32 workersCount)
+{
+	// create a queue for each worker and one more queue for tasks
+	// which are submitted from external (non-worker) threads
+
+	queues_.reserve(workersCount + 1);
+
+	for (u32 i = 0; i < workersCount + 1; ++i)
+		queues_.push_back(std::make_unique<WorkQueue>());
+
+	workers_.reserve(workersCount);
+
+	for (u32 i = 0; i < workersCount; ++i)
+		workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+///////////////////////////////////////////////////////////
+
+ThreadPool::~ThreadPool()
+{
+	stop_ = true;
+
+	// lock the mutex so no worker misses the notification between
+	// checking of the sleep condition and going to sleep
+	{ std::lock_guard<std::mutex> lock(sleepMutex_); }
+	sleepCV_.notify_all();
+
+	for (std::thread& worker : workers_)
+		worker.join();
+}
+
+///////////////////////////////////////////////////////////
+
+u32 ThreadPool::GetDefaultWorkersCount()
+{
+	// one thread of the CPU is left for the calling (main) thread
+	// which helps to execute tasks while waiting for them
+
+	const u32 hwThreadsCount = std::thread::hardware_concurrency();
+	return (hwThreadsCount > 1) ? hwThreadsCount - 1 : 0;
+}
+
+
+
+// *********************************************************************************
+//                                PUBLIC API
+// *********************************************************************************
+
+void ThreadPool::SubmitTask(Task&& task)
+{
+	// add a task into the queue of the current thread;
+	// in the single-thread mode (or if the queue is full) we execute the task right here
+
+	task.GetGroup().pending_.fetch_add(1, std::memory_order_relaxed);
+
+	if (IsSingleThreaded())
+	{
+		RunTask(task);
+		return;
+	}
+
+	WorkQueue& queue = *queues_[GetCurrQueueIdx()];
+	bool isQueued = false;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.count < QUEUE_CAPACITY)
+		{
+			queue.tasks[(queue.head + queue.count) & (QUEUE_CAPACITY - 1)] = task;
+			++queue.count;
+			isQueued = true;
+		}
+	}
+
+	if (!isQueued)
+	{
+		RunTask(task);
+		return;
+	}
+
+	queuedTasks_.fetch_add(1, std::memory_order_release);
+
+	{ std::lock_guard<std::mutex> lock(sleepMutex_); }
+	sleepCV_.notify_one();
+}
+
+///////////////////////////////////////////////////////////
+
+void ThreadPool::Wait(TaskGroup& group)
+{
+	// wait until all the tasks of the group are finished;
+	// while waiting the current thread executes queued tasks itself;
+	//
+	// if some task of the group threw an exception we rethrow it here
+
+	const u32 queueIdx = GetCurrQueueIdx();
+
+	while (group.pending_.load(std::memory_order_acquire) > 0)
+	{
+		if (!TryRunTask(queueIdx))
+			std::this_thread::yield();
+	}
+
+	if (group.exception_)
+	{
+		std::exception_ptr exception = group.exception_;
+		group.exception_ = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+
+
+// *********************************************************************************
+//                                PRIVATE HELPERS
+// *********************************************************************************
+
+void ThreadPool::WorkerLoop(const u32 workerIdx)
+{
+	tl_pPool = this;
+	tl_queueIdx = workerIdx;
+
+	while (true)
+	{
+		if (TryRunTask(workerIdx))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		sleepCV_.wait(lock, [this]() { return stop_ || (queuedTasks_.load(std::memory_order_acquire) > 0); });
+
+		if (stop_ && (queuedTasks_ == 0))
+			return;
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+bool ThreadPool::TryPopTask(const u32 queueIdx, Task& outTask)
+{
+	// pop the most recently added task from the own queue (LIFO)
+	// so the data of this task is most likely still in the cache
+
+	WorkQueue& queue = *queues_[queueIdx];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.count == 0)
+		return false;
+
+	--queue.count;
+	outTask = queue.tasks[(queue.head + queue.count) & (QUEUE_CAPACITY - 1)];
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+
+bool ThreadPool::TryStealTask(const u32 thiefQueueIdx, Task& outTask)
+{
+	// steal the oldest task (FIFO) from the queue of some other thread
+
+	const u32 queuesCount = (u32)queues_.size();
+
+	for (u32 i = 1; i < queuesCount; ++i)
+	{
+		WorkQueue& victim = *queues_[(thiefQueueIdx + i) % queuesCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (victim.count > 0)
+		{
+			outTask = victim.tasks[victim.head];
+			victim.head = (victim.head + 1) & (QUEUE_CAPACITY - 1);
+			--victim.count;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////
+
+bool ThreadPool::TryRunTask(const u32 queueIdx)
+{
+	// execute one task from the own queue or steal it from another one;
+	// return: false if there are no tasks at all
+
+	Task task;
+
+	if (!TryPopTask(queueIdx, task) && !TryStealTask(queueIdx, task))
+		return false;
+
+	queuedTasks_.fetch_sub(1, std::memory_order_relaxed);
+	RunTask(task);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+
+void ThreadPool::RunTask(Task& task)
+{
+	TaskGroup& group = task.GetGroup();
+
+	try
+	{
+		task();
+	}
+	catch (...)
+	{
+		// store only the first exception of the group
+		std::lock_guard<std::mutex> lock(group.exceptionMutex_);
+
+		if (!group.exception_)
+			group.exception_ = std::current_exception();
+	}
+
+	// NOTE: after this line the group can be already destroyed by the waiting thread
+	group.pending_.fetch_sub(1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////
+
+u32 ThreadPool::GetCurrQueueIdx() const
+{
+	// return: idx of the queue of the current worker thread or
+	//         idx of the shared queue if this is an external thread
+
+	return (tl_pPool == this) ? tl_queueIdx : (u32)workers_.size();
+}
+
+} // namespace ECS
@@ -0,0 +1,176 @@
+// *********************************************************************************
+// Filename:     ThreadPool.h
+// Description:  a work-stealing pool of worker threads for executing of ECS jobs;
+//
+//               each worker has its own deque of tasks: it pops tasks from the
+//               back of its own deque and if there is nothing to do it steals
+//               tasks from the front of deques of other workers; tasks which are
+//               submitted from a non-worker thread go into a separate shared deque;
+//
+//               a thread which waits for a group of tasks doesn't sleep but helps
+//               to execute tasks so nested jobs (a job which splits its work into
+//               chunks) don't block each other;
+//
+//               when the pool is created with 0 worker threads it works in
+//               the single-thread mode: each task is executed right in Submit()
+//               in order of submission (is used for deterministic replay tests);
+//
+//               tasks are stored in place (without type erasure on the heap) and
+//               queues are ring buffers which are allocated once when the pool is
+//               created so submitting of tasks doesn't allocate any memory; if a queue
+//               is full the task is executed right in Submit();
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "Types.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <condition_variable>
+#include <algorithm>
+#include <type_traits>
+#include <new>
+
+namespace ECS
+{
+
+// a group of submitted tasks which can be waited for
+struct TaskGroup
+{
+	std::atomic<u32>   pending_ = 0;        // number of not finished tasks of the group
+	std::exception_ptr exception_;          // the first exception thrown by some task of the group
+	std::mutex         exceptionMutex_;
+};
+
+///////////////////////////////////////////////////////////
+
+class ThreadPool
+{
+public:
+	static constexpr u32    QUEUE_CAPACITY    = 1024;     // max number of tasks in a queue (must be a power of 2)
+	static constexpr size_t TASK_STORAGE_SIZE = 64;       // max size of a callable of a task (its captured data)
+
+	explicit ThreadPool(const u32 workersCount = GetDefaultWorkersCount());
+	~ThreadPool();
+
+	// restrict any copying of instances of this class
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	template <class Func>
+	void Submit(TaskGroup& group, Func&& func)
+	{
+		SubmitTask(Task(std::forward<Func>(func), &group));
+	}
+
+	void Wait(TaskGroup& group);
+
+	inline u32  GetWorkersCount() const { return (u32)workers_.size(); }
+	inline bool IsSingleThreaded() const { return workers_.empty(); }
+
+	static u32 GetDefaultWorkersCount();
+
+	// ----------------------------------------------------
+
+	template <class Func>
+	void ParallelFor(const size count, const size chunkSize, const Func& func)
+	{
+		// split the range [0, count) into chunks of chunkSize elements and
+		// execute func(begin, end) for each chunk in parallel;
+		//
+		// NOTE: bounds of chunks depend only on the count and the chunk size
+		//       (not on the number of threads) so if func writes only into its
+		//       own range the result is the same for any number of threads
+
+		if (count <= 0)
+			return;
+
+		if (IsSingleThreaded() || (count <= chunkSize))
+		{
+			func((size)0, count);
+			return;
+		}
+
+		TaskGroup group;
+
+		for (size begin = 0; begin < count; begin += chunkSize)
+		{
+			const size end = std::min(begin + chunkSize, count);
+			Submit(group, [&func, begin, end]() { func(begin, end); });
+		}
+
+		Wait(group);
+	}
+
+private:
+	class Task
+	{
+	public:
+		Task() {}
+
+		template <class Func>
+		Task(Func&& func, TaskGroup* pGroup) : pGroup_(pGroup)
+		{
+			// the callable is copied into the task as it is so it must be small
+			// and trivially copyable (capture ptrs/refs to big data)
+			using F = std::decay_t<Func>;
+
+			static_assert(sizeof(F) <= TASK_STORAGE_SIZE, "a task is too big: capture less data");
+			static_assert(alignof(F) <= alignof(std::max_align_t), "a task has too big alignment");
+			static_assert(std::is_trivially_copyable_v<F> && std::is_trivially_destructible_v<F>, "a task must be trivially copyable");
+
+			new (storage_) F(std::forward<Func>(func));
+			pInvoke_ = [](void* pFunc) { (*(F*)pFunc)(); };
+		}
+
+		inline void       operator()()    { pInvoke_(storage_); }
+		inline TaskGroup& GetGroup() const { return *pGroup_; }
+
+	private:
+		alignas(std::max_align_t) uint8_t storage_[TASK_STORAGE_SIZE];
+		void (*pInvoke_)(void*) = nullptr;
+		TaskGroup* pGroup_ = nullptr;
+	};
+
+	struct WorkQueue
+	{
+		WorkQueue() : tasks(QUEUE_CAPACITY) {}
+
+		std::mutex        mutex;
+		std::vector<Task> tasks;              // a ring buffer: [head, head + count)
+		u32               head = 0;           // idx of the oldest task
+		u32               count = 0;
+	};
+
+	static_assert((QUEUE_CAPACITY & (QUEUE_CAPACITY - 1)) == 0, "capacity of a queue must be a power of 2");
+
+	void SubmitTask(Task&& task);
+	void WorkerLoop(const u32 workerIdx);
+
+	bool TryPopTask(const u32 queueIdx, Task& outTask);
+	bool TryStealTask(const u32 thiefQueueIdx, Task& outTask);
+	bool TryRunTask(const u32 queueIdx);
+
+	void RunTask(Task& task);
+	u32  GetCurrQueueIdx() const;
+
+private:
+	std::vector<std::thread>                workers_;
+	std::vector<std::unique_ptr<WorkQueue>> queues_;           // a queue per worker + the last one for external threads
+
+	std::atomic<u32>                        queuedTasks_ = 0;  // number of tasks in all the queues
+	std::atomic<bool>                       stop_ = false;
+
+	std::mutex                              sleepMutex_;
+	std::condition_variable                 sleepCV_;
+};
+
+} // namespace ECS
@@ -35,6 +35,17 @@ using ComponentID         = std::string;
 using SystemID            = std::string;
 
 const EntityID   INVALID_ENTITY_ID{ 0 };
+
+// an entity ID is packed as: [ generation (8 bits) | index (24 bits) ];
+// the index can be reused after destruction of the entity but the generation is
+// increased each time so we can detect stale IDs of already destroyed entities
+const u32        ENTT_IDX_BITS{ 24 };
+const u32        ENTT_IDX_MASK{ (1u << ENTT_IDX_BITS) - 1 };
+const u32        ENTT_GEN_MASK{ 0xFF };
+
+inline u32      GetEnttIdx(const EntityID id)                { return id & ENTT_IDX_MASK; }
+inline u32      GetEnttGen(const EntityID id)                { return id >> ENTT_IDX_BITS; }
+inline EntityID MakeEnttID(const u32 idx, const u32 gen)     { return ((gen & ENTT_GEN_MASK) << ENTT_IDX_BITS) | (idx & ENTT_IDX_MASK); }
 const EntityName INVALID_ENTITY_NAME{ "invalid" };
 
 const TexID      INVALID_TEXTURE_ID{ 0 };
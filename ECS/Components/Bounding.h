@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 #include <DirectXCollision.h>
 
@@ -29,6 +30,8 @@ struct Bounding
 	// center  - center of the box / sphere; 
 	// extents - Distance from the center to each side OR radius of the sphere
 	std::vector<DirectX::BoundingBox> data_;    
+
+	SparseSet sparse_;                          // entity ID => data idx
 	
 };
 
@@ -9,6 +9,7 @@
 
 #include "../Common/Types.h"
 #include "../Common/Utils.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -164,6 +165,7 @@ struct TexStaticTransformations
 {
 	std::vector<EntityID> ids_;
 	std::vector<XMMATRIX> transformations_;   // these matrices are used to update the current static transformation
+	SparseSet             sparse_;            // entity ID => data idx
 };
 
 ///////////////////////////////////////////////////////////
@@ -205,6 +207,7 @@ struct TexAtlasAnimations
 	std::vector<float> timeSteps_;               // duration of one animation frame; after this time point we change an animation frame
 	std::vector<float> currAnimTime_;           // frame time value in [0, timeStep]; when this val >= timeStep we change a frame
 	std::vector<TexAtlasAnimationData> data_;
+	SparseSet sparse_;                           // entity ID => data idx
 };
 
 ///////////////////////////////////////////////////////////
@@ -215,6 +218,7 @@ struct TexRotationsAroundCoords
 	std::vector<EntityID> ids_;
 	std::vector<XMFLOAT2> texCoords_;
 	std::vector<float>    rotationsSpeed_;
+	SparseSet             sparse_;       // entity ID => data idx
 };
 
 }
\ No newline at end of file
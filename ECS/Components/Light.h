@@ -10,6 +10,7 @@
 #include <algorithm>
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 
 
 
@@ -250,12 +251,48 @@ struct SpotLightsInitParams
 //           STRUCTURES TO REPRESENT CONTAINERS FOR LIGHT SOURCES
 // *********************************************************************************
 
+struct LightsDirtyRange
+{
+	// data idxs of changed light sources are in the range [begin, end);
+	//
+	// the range only lets the consumer skip converting of unchanged lights on the CPU:
+	// the light shader takes lights from a small constant buffer which is written
+	// whole by Map(WRITE_DISCARD) since a dynamic buffer can't be updated partially;
+	// lights are kept as AoS because it is exactly the layout of the HLSL light
+	// structures so they are copied into the buffer without any gathering
+
+	inline bool IsEmpty() const { return begin >= end; }
+	inline void Reset()         { begin = UINT32_MAX; end = 0; }
+
+	inline void Add(const u32 idx)
+	{
+		begin = std::min(begin, idx);
+		end   = std::max(end, idx + 1);
+	}
+
+	inline void Add(const u32 first, const u32 last)
+	{
+		if (first >= last)
+			return;
+
+		begin = std::min(begin, first);
+		end   = std::max(end, last);
+	}
+
+	u32 begin = UINT32_MAX;
+	u32 end   = 0;
+};
+
+///////////////////////////////////////////////////////////
+
 struct DirLights
 {
 	size GetCount() const { return std::ssize(data_); }
 
 	std::vector<EntityID> ids_;
 	std::vector<DirLight> data_;
+	SparseSet sparse_;          // entity ID => idx of light source
+	LightsDirtyRange dirtyRange_;
 };
 
 struct PointLights
@@ -264,6 +301,8 @@ struct PointLights
 
 	std::vector<EntityID> ids_;
 	std::vector<PointLight> data_;
+	SparseSet sparse_;          // entity ID => idx of light source
+	LightsDirtyRange dirtyRange_;
 };
 
 struct SpotLights
@@ -272,6 +311,61 @@ struct SpotLights
 
 	std::vector<EntityID> ids_;
 	std::vector<SpotLight> data_;
+	SparseSet sparse_;          // entity ID => idx of light source
+	LightsDirtyRange dirtyRange_;
+};
+
+
+// *********************************************************************************
+//                STRUCTURES FOR BATCHED ANIMATION OF LIGHT SOURCES
+// *********************************************************************************
+
+enum LightAnimType : uint8_t
+{
+	LIGHT_ANIM_ORBIT,      // the light moves along a horizontal circle
+	LIGHT_ANIM_PULSE,      // the intensity smoothly goes up and down
+	LIGHT_ANIM_FLICKER,    // the intensity irregularly falls down (like a flame or a bad lamp)
+};
+
+///////////////////////////////////////////////////////////
+
+struct LightAnimParams
+{
+	LightAnimType type = LIGHT_ANIM_ORBIT;
+	XMFLOAT3 center    = { 0,0,0 };   // orbit: the center of the circle
+	float    radius    = 0;           // orbit: the radius of the circle
+	float    speed     = 1;           // the angular speed of the curve (radians per second)
+	float    phase     = 0;           // the angle of the curve at the time == 0
+	float    amplitude = 0;           // pulse/flicker: the max relative change of the intensity
+};
+
+///////////////////////////////////////////////////////////
+
+struct LightAnimations
+{
+	size GetCount() const { return std::ssize(ids_); }
+
+	std::vector<EntityID>      ids_;
+	std::vector<u32>           dataIdxs_;        // idx of the animated light in the data arr of its container
+	std::vector<LightAnimType> types_;
+	std::vector<XMFLOAT4>      baseDiffuses_;    // colors of the light which are scaled by pulse/flicker
+	std::vector<XMFLOAT4>      baseSpeculars_;
+
+	// params of curves (SoA); arrays are padded to a multiple of 4
+	std::vector<float>         centersX_;
+	std::vector<float>         centersY_;
+	std::vector<float>         centersZ_;
+	std::vector<float>         radiuses_;
+	std::vector<float>         speeds_;
+	std::vector<float>         phases_;
+	std::vector<float>         amplitudes_;
+
+	// values of curves which were evaluated by the last update (SoA, padded)
+	std::vector<float>         positionsX_;      // orbit
+	std::vector<float>         positionsY_;
+	std::vector<float>         positionsZ_;
+	std::vector<float>         pulses_;          // factors of the intensity
+	std::vector<float>         flickers_;
 };
 
 
@@ -284,9 +378,13 @@ struct Light
 	ComponentType type_ = ComponentType::LightComponent;
 
 	std::vector<EntityID> ids_;
+	SparseSet             sparse_;        // entity ID => data idx
 	DirLights             dirLights_;
 	PointLights           pointLights_;
 	SpotLights            spotLights_;
+
+	LightAnimations       pointLightsAnims_;
+	LightAnimations       spotLightsAnims_;
 };
 
 
@@ -7,7 +7,7 @@
 #pragma once
 
 #include "../Common/Types.h"
-#include <map>
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -17,8 +17,24 @@ struct MeshComponent
 {
 	ComponentType type_ = ComponentType::MeshComp;
 
-	std::map<EntityID, std::vector<MeshID>> enttToMeshes_;  // each entity can have multiple meshes
-	std::map<MeshID, std::vector<EntityID>> meshToEntts_;  // each mesh can be related to multiple entities
+	// 'entity => meshes' mapping in the CSR form (offsets + flat arrays):
+	// meshes of the entity by data idx i are stored in the range 
+	// [enttsOffsets_[i], enttsOffsets_[i+1]) of the enttsMeshes_ arr
+	std::vector<EntityID> ids_;
+	std::vector<u32>      enttsOffsets_ = { 0 };
+	std::vector<MeshID>   enttsMeshes_;               // each entity can have multiple meshes
+	SparseSet             sparse_;                    // entity ID => data idx
+
+	// 'mesh => entities' mapping in the CSR form (meshes are sorted by IDs):
+	// data idxs of entities related to the mesh i are stored in the range
+	// [meshesOffsets_[i], meshesOffsets_[i+1]) of the meshesEntts_ arr;
+	// so it is also a list of all the entities sorted by meshes (for instancing);
+	// 
+	// NOTE: this mapping is rebuilt at once after a batch of changes
+	std::vector<MeshID>   meshesIDs_;
+	std::vector<u32>      meshesOffsets_ = { 0 };
+	std::vector<u32>      meshesEntts_;               // each mesh can be related to multiple entities
+	bool                  isMeshToEnttsDirty_ = false;
 };
 
-}
\ No newline at end of file
+}
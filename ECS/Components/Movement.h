@@ -8,6 +8,7 @@
 
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 
@@ -21,6 +22,7 @@ struct Movement
 	std::vector<EntityID> ids_;                     // entities IDs
 	std::vector<XMFLOAT4> translationAndUniScales_; // translation (x,y,z); uniform scale (w)
 	std::vector<XMVECTOR> rotationQuats_;           // rotation quatertion {0, pitch, yaw, roll}
+	SparseSet             sparse_;                  // entity ID => data idx
 };
 
 }
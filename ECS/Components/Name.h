@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -21,6 +22,7 @@ struct Name
 	// there is one to one records ['entity_id' => 'entity_name']
 	std::vector<EntityID> ids_;
 	std::vector<EntityName> names_;
+	SparseSet sparse_;                // entity ID => data idx
 };
 
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -50,6 +51,7 @@ struct RenderStates
 
 	std::vector<EntityID> ids_;
 	std::vector<u32> statesHashes_;    // hash where each bit responds for a specific render state
+	SparseSet sparse_;                 // entity ID => data idx
 };
 
 };  // namespace ECS
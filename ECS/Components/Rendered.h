@@ -8,6 +8,7 @@
 
 //#include <vector>
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <unordered_map>
 #include <d3d11.h>
 
@@ -21,6 +22,7 @@ struct Rendered
 	std::vector<EntityID> ids_;
 	std::vector<ECS::RENDERING_SHADERS> shaderTypes_;
 	std::vector<D3D11_PRIMITIVE_TOPOLOGY> primTopologies_;
+	SparseSet sparse_;                        // entity ID => data idx
 
 	std::vector<EntityID> visibleEnttsIDs_;   // currently visible entts for this frame
 };
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "Helpers/TextureTransformHelpers.h"
+#include "../Common/SparseSet.h"
 
 namespace ECS
 {
@@ -36,6 +37,7 @@ struct TextureTransform
 	std::vector<EntityID> ids_;
 	std::vector<TexTransformType> transformTypes_;
 	std::vector<XMMATRIX> texTransforms_;           // current textures transformations
+	SparseSet             sparse_;                  // entity ID => data idx
 
 	TexStaticTransformations texStaticTrans_;
 	TexAtlasAnimations texAtlasAnim_;
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -20,6 +21,7 @@ struct Textured
 	std::vector<EntityID>                ids_;
 	std::vector<std::vector<TexID>>      texIDs_;    // each entt with this component has an IDs array of its textures
 	std::vector<std::vector<TexPath>>    texPaths_;  // each entt with this component has a paths array of its textures
+	SparseSet                            sparse_;    // entity ID => data idx
 };
 
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -23,6 +24,8 @@ struct Transform
 		ids_.reserve(newCapacity);
 		posAndUniformScale_.reserve(newCapacity);
 		dirQuats_.reserve(newCapacity);
+		dirtyFlags_.reserve(newCapacity);
+		dirtyIdxs_.reserve(newCapacity);
 	}
 
 	ComponentType type_ = ComponentType::TransformComponent;
@@ -30,6 +33,9 @@ struct Transform
 	std::vector<EntityID> ids_; 
 	std::vector<XMFLOAT4> posAndUniformScale_;  // pos (x,y,z); uniform scale (w)
 	std::vector<XMVECTOR> dirQuats_;            // normalized direction quaternion
+	std::vector<uint8_t>  dirtyFlags_;          // 1 if the world matrix of the entity must be rebuilt from its transform data
+	std::vector<u32>      dirtyIdxs_;           // data idxs of records with the dirty flag (each idx is stored only once)
+	SparseSet             sparse_;                // entity ID => data idx
 
 };
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
 #include <vector>
 
 namespace ECS
@@ -18,6 +19,9 @@ struct WorldMatrix
 
 	std::vector<EntityID> ids_;
 	std::vector<XMMATRIX> worlds_;
+	SparseSet             sparse_;   // entity ID => data idx
+
+	u32                   version_ = 0;   // is increased when world matrices are explicitly set (not rebuilt from dirty transforms)
 };
 
 }
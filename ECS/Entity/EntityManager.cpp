@@ -11,9 +11,9 @@
 #include <algorithm>
 #include <vector>
 #include <unordered_map>
+#include <utility>
 
 #include <cctype>
-#include <random>
 
 using namespace Utils;
 
@@ -24,20 +24,27 @@ namespace ECS
 EntityManager::EntityManager() :
 	nameSystem_ {&names_},
 	transformSystem_{ &transform_, &world_ },
-	moveSystem_{ &transform_, &world_, &movement_ },
+	moveSystem_{ &transform_, &movement_ },
 	meshSystem_{ &meshComponent_ },
 	renderSystem_{ &renderComponent_, &transform_, &world_, &meshComponent_ },
 	texturesSystem_{ &textureComponent_ },
 	texTransformSystem_ { &texTransform_ },
 	lightSystem_{ &light_ },
 	renderStatesSystem_{ &renderStates_ },
-	boundingSystem_ { &bounding_ }
+	boundingSystem_ { &bounding_ },
+	cullingSystem_ { &bounding_, &world_ },
+	lightInfluenceSystem_ { &light_, &cullingSystem_ },
+	instancesCache_ { &meshSystem_, &world_, &texTransform_ }
 {
 	const u32 reserveMemForEnttsCount = 100;
 
 	ids_.reserve(reserveMemForEnttsCount);
 	componentHashes_.reserve(reserveMemForEnttsCount);
 
+	// the ID == 0 is reserved as invalid so the first entity will have ID == 1
+	lastEnttIdx_ = 0;
+	generations_.push_back(0);
+
 	// make pairs ['component_type' => 'component_name']
 	componentTypeToName_ =
 	{
@@ -48,6 +55,12 @@ EntityManager::EntityManager() :
 		{ ComponentType::RenderedComponent, "Rendered" },
 		{ ComponentType::WorldMatrixComponent, "WorldMatrix" }
 	};
+
+	threadPool_ = std::make_unique<ThreadPool>();
+	InitSystemsScheduler();
+
+	// NOTE: the BVH is disabled by default: frustum culling goes through the parallel
+	//       SIMD test of SoA boxes (see TestSystems::BenchmarkFrustumCulling for the comparison)
 }
 
 EntityManager::~EntityManager()
@@ -81,13 +94,44 @@ bool EntityManager::Serialize(const std::string& dataFilepath)
 
 bool EntityManager::Deserialize(const std::string& dataFilepath)
 {
+	// blocks of the file are decoded right into the manager so its current data
+	// is moved aside (the manager becomes empty) and is moved back if the file
+	// can't be loaded; so a failed loading doesn't leave the manager half-replaced
+	SceneData prevScene;
+	SwapSceneData(prevScene);
+
 	try
 	{
+		// for each index: the minimal generation which is bigger than any generation
+		// given to an entity of this index before loading (so handles which existed
+		// before loading won't alias IDs of entities which will be created after it)
+		std::vector<u32> minFreeGens(lastEnttIdx_ + 1, 0);
+
+		for (u32 idx = 1; idx <= lastEnttIdx_; ++idx)
+		{
+			const u32 gen = prevScene.generations[idx];
+
+			if (prevScene.sparse.Has(MakeEnttID(idx, gen)))
+				minFreeGens[idx] = gen + 1;
+			else
+				minFreeGens[idx] = (gen == 0) ? ENTT_GEN_MASK + 1 : gen;    // a free idx already has the next generation (0 -- the idx is retired)
+		}
+
 		EntityManagerDeserializer deserializer;
 		deserializer.Deserialize(*this, dataFilepath);
+		sceneLoadTimings_ = deserializer.GetTimings();
+
+		// the mapping ['entity_id' => 'data_idx'] is already rebuilt by the deserializer
+		++structVersion_;
+
+		RestoreGenerations(minFreeGens);
 	}
 	catch (LIB_Exception& e)
 	{
+		// restore the previous data (lastEnttIdx_ and free idxs aren't changed before
+		// the file is loaded completely so the manager is the same as before the call)
+		SwapSceneData(prevScene);
+
 		Log::Error(e, false);
 		Log::Error("can't deserialize data from the file: " + dataFilepath);
 		return false;
@@ -119,31 +163,98 @@ std::vector<EntityID> EntityManager::CreateEntities(const u32 newEnttsCount)
 	// create batch of new empty entities, generate for each entity 
 	// unique ID and set that it hasn't any component by default;
 	//
-	// return: SORTED array of IDs of just created entities;
+	// return: array of IDs of just created entities;
 
 	Assert::NotZero(newEnttsCount, "new entitites count == 0");
 
 	std::vector<EntityID> generatedIDs;
 	GenerateIDs(newEnttsCount, generatedIDs);
 
-	for (const EntityID& ID : generatedIDs)
-	{
-		const ptrdiff_t insertAtPos = Utils::GetPosForID(ids_, ID);
+	// append new IDs to the array of IDs and set that 
+	// each new entity by default doesn't have any component
+	sparse_.Add(generatedIDs, std::ssize(ids_));
 
-		// add new ID into the sorted array of IDs
-		// and set that each new entity by default doesn't have any component
-		Utils::InsertAtPos<EntityID>(ids_, insertAtPos, ID);		
-		Utils::InsertAtPos<u32>(componentHashes_, insertAtPos, 0);
-	}
+	Utils::AppendArray(ids_, generatedIDs);
+	componentHashes_.resize(ids_.size(), 0);
+	++structVersion_;
 
 	return generatedIDs;
 }
 
 ///////////////////////////////////////////////////////////
 
+void EntityManager::DestroyEntity(const EntityID id)
+{
+	DestroyEntities(std::vector<EntityID>{ id });
+}
+
+///////////////////////////////////////////////////////////
+
 void EntityManager::DestroyEntities(const std::vector<EntityID>& enttsIDs)
 {
-	assert("TODO: IMPLEMENT IT!" && 0);
+	// destroy a batch of entities: remove their records from each component
+	// and release their IDs so the indices can be reused later (with a new generation);
+	// 
+	// NOTE: records are removed using swap-and-pop so the order of
+	//       data in the components isn't preserved
+
+	try
+	{
+		Assert::NotEmpty(enttsIDs.empty(), "the array of entities IDs is empty");
+		Assert::True(CheckEnttsByIDsExist(enttsIDs), "there is no entity by some input ID (or it is already destroyed)");
+
+		// define which components we need to clean up
+		std::vector<ComponentsHash> hashes;
+		ComponentsHash hash = 0;
+
+		GetComponentHashesByIDs(enttsIDs, hashes);
+
+		for (const ComponentsHash h : hashes)
+			hash |= h;
+
+		auto hasComponent = [hash](const ComponentType type) { return (bool)(hash & (1 << type)); };
+
+		// remove records from components
+		if (hasComponent(TransformComponent) || hasComponent(WorldMatrixComponent))
+			transformSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(MoveComponent))
+			moveSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(MeshComp))
+			meshSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(NameComponent))
+			nameSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(RenderedComponent))
+			renderSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(TexturedComponent))
+			texturesSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(TextureTransformComponent))
+			texTransformSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(LightComponent))
+			lightSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(RenderStatesComponent))
+			renderStatesSystem_.RemoveRecords(enttsIDs);
+
+		if (hasComponent(BoundingComponent))
+			boundingSystem_.Remove(enttsIDs);
+
+		// remove entities from the manager itself
+		sparse_.SwapAndPop(enttsIDs, ids_, componentHashes_);
+		ReleaseIDs(enttsIDs);
+		++structVersion_;
+	}
+	catch (LIB_Exception& e)
+	{
+		Log::Error(e, false);
+		Log::Error("can't destroy entities by IDs: " + Utils::JoinArrIntoStr<EntityID>(enttsIDs));
+	}
 }
 
 
@@ -155,9 +266,127 @@ void EntityManager::DestroyEntities(const std::vector<EntityID>& enttsIDs)
 
 void EntityManager::Update(const float totalGameTime, const float deltaTime)
 {
-	moveSystem_.UpdateAllMoves(deltaTime, transformSystem_);
-	texTransformSystem_.UpdateAllTextrureAnimations(totalGameTime, deltaTime);
-	lightSystem_.Update(deltaTime, totalGameTime);
+	// update all the per-frame systems; independent systems
+	// are updated concurrently by the pool of worker threads
+
+	scheduler_.Run(*threadPool_, totalGameTime, deltaTime);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::SetWorkersCount(const u32 workersCount)
+{
+	// recreate the pool of worker threads (is called between frames);
+	// workersCount == 0 means the single-thread mode (for instance: for replay tests)
+
+	threadPool_.reset();
+	threadPool_ = std::make_unique<ThreadPool>(workersCount);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::ComputeFrustumCulling(const XMMATRIX& viewProj)
+{
+	// compute frustum culling of all the renderable entities and set visible ones
+	// into the Rendered component; world AABBs are fully rebuilt only after
+	// structural changes or explicit setting of world matrices, and in other
+	// frames only boxes of entities whose world matrices were rebuilt during
+	// the last Update() are updated (and refitted in the BVH)
+
+	static const ComponentsHash cullQueryHash = GetHashByComponents({ RenderedComponent, WorldMatrixComponent });
+
+	const EnttsQuery& cullQuery = Query(cullQueryHash);
+
+	if ((cullingStructVersion_ != structVersion_) || (cullingWorldsVersion_ != world_.version_))
+	{
+		cullingSystem_.RebuildWorldBoxes(cullQuery.ids_, *threadPool_);
+		cullingStructVersion_ = structVersion_;
+		cullingWorldsVersion_ = world_.version_;
+	}
+	else
+	{
+		cullingSystem_.UpdateWorldBoxes(transformSystem_.GetDirtyEnttsIDs(), *threadPool_);
+	}
+
+	if (cullingSystem_.IsBVHEnabled())
+		cullingSystem_.CullByFrustumBVH(viewProj, visibleEntts_);
+	else
+		cullingSystem_.CullByFrustum(viewProj, *threadPool_, visibleEntts_);
+
+	renderSystem_.SetVisibleEntts(visibleEntts_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::UpdateEnttsLights()
+{
+	// all the lists are recomputed after structural changes, explicit setting of
+	// world matrices or if we missed some list of dirty entts; in other frames
+	// only lists of moved entts and entts near changed lights are recomputed
+
+	const u32 dirtyVersion = transformSystem_.GetDirtyListVersion();
+
+	const bool isResetRequired =
+		(lightsStructVersion_ != structVersion_) ||
+		(lightsWorldsVersion_ != world_.version_) ||
+		(dirtyVersion - lightsDirtyVersion_ > 1);
+
+	// the same list of dirty entts can't be applied twice
+	static const std::vector<EntityID> s_NoEntts;
+	const std::vector<EntityID>& dirtyEntts = (dirtyVersion != lightsDirtyVersion_) ? transformSystem_.GetDirtyEnttsIDs() : s_NoEntts;
+
+	lightInfluenceSystem_.Update(visibleEntts_, dirtyEntts, isResetRequired, *threadPool_);
+
+	lightsStructVersion_ = structVersion_;
+	lightsWorldsVersion_ = world_.version_;
+	lightsDirtyVersion_  = dirtyVersion;
+}
+
+///////////////////////////////////////////////////////////
+
+const InstancesBucket& EntityManager::UpdateInstancesBucket(const RenderBucketID bucketID)
+{
+	// render states are changed only together with the RenderStates component
+	// so rendered entts are separated by buckets only after structural changes
+	if (bucketsStructVersion_ != structVersion_)
+	{
+		bucketsEntts_.Clear();
+		renderStatesSystem_.GetRenderStates(renderSystem_.GetAllEnttsIDs(), bucketsEntts_);
+		bucketsStructVersion_ = structVersion_;
+	}
+
+	const std::vector<EntityID>* enttsOfBuckets[RENDER_BUCKETS_COUNT] =
+	{
+		&bucketsEntts_.enttsDefault_.ids_,        // BUCKET_DEFAULT_STATES
+		&bucketsEntts_.enttsAlphaClipping_.ids_,  // BUCKET_ALPHA_CLIP_CULL_NONE
+		&bucketsEntts_.enttsBlended_.ids_,        // BUCKET_BLENDING
+	};
+
+	if (bucketID >= RENDER_BUCKETS_COUNT)
+		throw LIB_Exception("invalid render bucket ID: " + std::to_string(bucketID));
+
+	return UpdateInstancesBucket(bucketID, *enttsOfBuckets[bucketID], renderSystem_.GetAllVisibleEntts());
+}
+
+///////////////////////////////////////////////////////////
+
+const InstancesBucket& EntityManager::UpdateInstancesBucket(
+	const RenderBucketID bucketID,
+	const std::vector<EntityID>& enttsIDs,
+	const std::vector<EntityID>& visibleEnttsIDs)
+{
+	// the bucket is fully rebuilt only after structural changes or changes of the set of
+	// its entities; in other frames only instances of entities whose world matrices were
+	// rebuilt during the last Update() and instances with texture transformations are patched;
+	// changes of visible entities only update the list of visible instances of the bucket
+
+	return instancesCache_.UpdateBucket(
+		bucketID,
+		enttsIDs,
+		visibleEnttsIDs,
+		transformSystem_.GetDirtyEnttsIDs(),
+		transformSystem_.GetDirtyListVersion(),
+		structVersion_);
 }
 
 // *********************************************************************************
@@ -173,24 +402,17 @@ void EntityManager::FilterInputEnttsByComponents(
 	const std::vector<ComponentType> compTypes,
 	std::vector<EntityID>& outFilteredEntts)
 {
-	ComponentsHash bitmask = 0;
-	std::vector<ComponentsHash> hashes;
+	// get only such entities from the input arr which have all the input components
 
-	// create a bitmask
-	for (const ComponentType& type : compTypes)
-		bitmask |= (1 << type);
-
-
-	// get all the component flags of input entities
-	GetComponentHashesByIDs(enttsIDs, hashes);
+	const EnttsQuery& query = Query(compTypes);
 
 	outFilteredEntts.reserve(enttsIDs.size());
 
 	// if the entity has such set of components we store this entity ID
-	for (u32 idx = 0; idx < enttsIDs.size(); ++idx)
+	for (const EntityID id : enttsIDs)
 	{
-		if (bitmask == (hashes[idx] & bitmask))
-			outFilteredEntts.push_back(enttsIDs[idx]);
+		if (query.sparse_.Has(id))
+			outFilteredEntts.push_back(id);
 	}
 
 	outFilteredEntts.shrink_to_fit();
@@ -228,6 +450,9 @@ void EntityManager::SetEnttsHaveComponent(
 
 	for (const ptrdiff_t idx : enttsDataIdxs)
 		componentHashes_[idx] |= bitmask;
+
+	// cached queries must be rebuilt
+	++structVersion_;
 }
 
 ///////////////////////////////////////////////////////////
@@ -756,14 +981,7 @@ bool EntityManager::CheckEnttsByIDsExist(const std::vector<EntityID>& enttsIDs)
 	// return: true  -- if all the entities from the input arr exists in the manager
 	//         false -- if some entity from the input arr doesn't exist
 
-	bool allExist = true;
-	const auto beg = ids_.begin();
-	const auto end = ids_.end();
-
-	for (const EntityID& id : enttsIDs)
-		allExist &= std::binary_search(beg, end, id);
-	
-	return allExist;
+	return sparse_.HasAll(enttsIDs);
 }
 
 ///////////////////////////////////////////////////////////
@@ -814,39 +1032,47 @@ void EntityManager::GetEnttsByComponent(
 {
 	// get IDs of entities which have such component;
 
-	switch (componentType)
+	outIDs = Query({ componentType }).ids_;
+}
+
+///////////////////////////////////////////////////////////
+
+const EnttsQuery& EntityManager::Query(const std::vector<ComponentType>& componentsTypes)
+{
+	// get a query of entities which have all the input components;
+	// 
+	// NOTE: the query is cached and rebuilt only if there was any structural
+	//       change since the last call so the returned reference is valid until
+	//       the next creation/destruction of entities or adding of components
+
+	Assert::NotEmpty(componentsTypes.empty(), "the input arr of components types is empty");
+
+	return Query(GetHashByComponents(componentsTypes));
+}
+
+///////////////////////////////////////////////////////////
+
+const EnttsQuery& EntityManager::Query(const ComponentsHash hash)
+{
+	// get a query of entities which have all the components from the input hash
+	// (see the description of the function above)
+	//
+	// NOTE: this function is called each frame so we don't use Assert here
+	//       (it would allocate memory for the message string each call)
+
+	if (hash == 0)
+		throw LIB_Exception("the input components hash is empty");
+
+	EnttsQuery& query = queries_[hash];
+
+	if (query.version_ != structVersion_)
 	{
-		case ComponentType::TransformComponent:
-		{
-			outIDs = transform_.ids_;
-			return;
-		}
-		case ComponentType::WorldMatrixComponent:
-		{
-			transformSystem_.GetAllEnttsIDsFromWorldMatrixComponent(outIDs);
-			return;
-		}
-		case ComponentType::MoveComponent:
-		{
-			outIDs = movement_.ids_;
-			return;
-		}
-		case ComponentType::MeshComp:
-		{
-			meshSystem_.GetEnttsIDsFromMeshComponent(outIDs);
-			return;
-		}
-		case ComponentType::RenderedComponent:
-		{
-			outIDs = renderComponent_.ids_;
-			return;
-		}
-		default:
-		{
-			Log::Error("Unknown component type: " + std::to_string(componentType));
-			throw LIB_Exception("can't get IDs of entities which have such component: " + std::to_string(componentType));
-		}
+		query.hash_ = hash;
+		BuildQuery(query);
+		query.version_ = structVersion_;
 	}
+
+	return query;
 }
 
 #pragma endregion
@@ -867,34 +1093,299 @@ void EntityManager::GenerateIDs(
 {
 	// generate unique IDs in quantity newEnttsCount;
 	// 
+	// NOTE: at first we reuse indices of destroyed entities (with the current
+	//       generation of the index) and then generate new indices sequentially
+	//       so they are dense (the sparse set allocates as few pages as possible)
+	// 
 	// in:  how many entities we will create
-	// out: SORTED array of generated entities IDs
+	// out: array of generated entities IDs
+
+	const u32 reusedCount = std::min(newEnttsCount, (u32)freeIdxs_.size());
+	const u32 newIdxsCount = newEnttsCount - reusedCount;
+
+	Assert::True(lastEnttIdx_ + newIdxsCount <= ENTT_IDX_MASK, "there are no free entities IDs");
+
+	outGeneratedIDs.resize(newEnttsCount);
+
+	// reuse indices of destroyed entities
+	for (u32 i = 0; i < reusedCount; ++i)
+	{
+		const u32 idx = freeIdxs_.back();
+		freeIdxs_.pop_back();
+		outGeneratedIDs[i] = MakeEnttID(idx, generations_[idx]);
+	}
+
+	// generate new indices (with zero generation)
+	generations_.resize(lastEnttIdx_ + newIdxsCount + 1, 0);
+
+	for (u32 i = reusedCount; i < newEnttsCount; ++i)
+		outGeneratedIDs[i] = MakeEnttID(++lastEnttIdx_, 0);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::ReleaseIDs(const std::vector<EntityID>& ids)
+{
+	// increase generation of the index of each input ID so all the
+	// IDs of destroyed entities become stale and put the index into
+	// the list of free indices to reuse it later;
+	//
+	// NOTE: an index whose generation is exhausted is retired forever
+	//       so a stale ID will never match a new one
+
+	for (const EntityID id : ids)
+	{
+		const u32 idx = GetEnttIdx(id);
+
+		// skip duplicates of the already released ID
+		if (generations_[idx] != GetEnttGen(id))
+			continue;
+
+		++generations_[idx];    // (uint8_t) so after 255 it wraps to 0
+
+		if (generations_[idx] != 0)
+			freeIdxs_.push_back(idx);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::RestoreGenerations(const std::vector<u32>& minFreeGens)
+{
+	// restore the list of free idxs after loading so we continue generation
+	// of IDs after the deserialized ones; generations of live entities and
+	// of free idxs are loaded from the file (the deserializer checked that
+	// generations of live entities match their IDs);
+	//
+	// in: minimal generation of each idx which can be given to a new entity
+	//     (a free idx gets the biggest of it and of the generation from the file)
 
-	using engine = std::mt19937;
+	const u32 fileIdxsCount = (u32)generations_.size();
 
-	std::random_device os_seed;
-	const u32 seed = os_seed();
-	engine generator(seed);
-	std::uniform_int_distribution<u32> distribute(0, UINT_MAX);
+	lastEnttIdx_ = std::max(fileIdxsCount, (u32)minFreeGens.size());
+	lastEnttIdx_ = (lastEnttIdx_ > 0) ? lastEnttIdx_ - 1 : 0;
 
-	outGeneratedIDs.reserve(newEnttsCount);
+	generations_.resize(lastEnttIdx_ + 1, 0);
+	freeIdxs_.clear();
 
-	// generate an ID for each new entity
-	for (u32 idx = 0; idx < newEnttsCount; ++idx)
+	for (u32 idx = 1; idx <= lastEnttIdx_; ++idx)
 	{
-		u32 id = distribute(generator);
+		if (sparse_.Has(MakeEnttID(idx, generations_[idx])))
+			continue;
+
+		// a free idx of the file with zero generation is retired
+		if ((idx < fileIdxsCount) && (generations_[idx] == 0))
+			continue;
+
+		u32 gen = generations_[idx];
+
+		if (idx < minFreeGens.size())
+			gen = std::max(gen, minFreeGens[idx]);
 
-		// if such ID already exists we generate new id value
-		while (std::binary_search(ids_.begin(), ids_.end(), id))
+		// all the generations of this idx are exhausted so retire it
+		if (gen > ENTT_GEN_MASK)
 		{
-			id = distribute(generator);
+			generations_[idx] = 0;
+			continue;
 		}
 
-		outGeneratedIDs.push_back(id);
+		generations_[idx] = (uint8_t)gen;
+		freeIdxs_.push_back(idx);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::SwapSceneData(SceneData& data)
+{
+	// swap data which is replaced by loading of a scene with the input data;
+	// systems keep ptrs to the components so only contents of the components are swapped
+
+	std::swap(ids_,             data.ids);
+	std::swap(componentHashes_, data.componentHashes);
+	std::swap(sparse_,          data.sparse);
+	std::swap(generations_,     data.generations);
+
+	std::swap(transform_,        data.transform);
+	std::swap(movement_,         data.movement);
+	std::swap(meshComponent_,    data.meshComponent);
+	std::swap(world_,            data.world);
+	std::swap(renderComponent_,  data.renderComponent);
+	std::swap(textureComponent_, data.textureComponent);
+	std::swap(names_,            data.names);
+	std::swap(texTransform_,     data.texTransform);
+	std::swap(light_,            data.light);
+	std::swap(renderStates_,     data.renderStates);
+	std::swap(bounding_,         data.bounding);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::InitSystemsScheduler()
+{
+	// register per-frame systems with components which they read and write;
+	// systems which don't touch the same data are updated concurrently
+
+	// movement of entities (is split into chunks of entities);
+	// moved entities are marked as dirty in the Transform component
+	scheduler_.AddSystem(
+		"MoveSystem",
+		GetHashByComponents({ MoveComponent }),
+		GetHashByComponents({ TransformComponent }),
+		[this](const float totalGameTime, const float deltaTime)
+		{
+			// a hash of components of entities to move (compute it only once so we don't allocate memory each frame)
+			static const ComponentsHash moveQueryHash = GetHashByComponents({ MoveComponent, TransformComponent });
+			constexpr size moveChunkSize = 4096;
+
+			// NOTE: only this system uses cached queries during the update so it can rebuild the query safely
+			const EnttsQuery& query = Query(moveQueryHash);
+			const size chunksCount = (query.Count() + moveChunkSize - 1) / moveChunkSize;
+
+			// each chunk collects idxs of moved entities into its own list
+			// (lists are kept between frames so there is no allocations after warm up)
+			if (std::ssize(movedIdxsPerChunk_) < chunksCount)
+				movedIdxsPerChunk_.resize(chunksCount);
+
+			for (std::vector<u32>& movedIdxs : movedIdxsPerChunk_)
+				movedIdxs.clear();
+
+			threadPool_->ParallelFor(query.Count(), moveChunkSize, [this, &query, deltaTime](const size begin, const size end)
+			{
+				std::vector<u32>& movedIdxs = movedIdxsPerChunk_[begin / moveChunkSize];
+				moveSystem_.UpdateMovesInRange(deltaTime, query, begin, end, movedIdxs);
+			});
+
+			for (size i = 0; i < chunksCount; ++i)
+				transformSystem_.AddDirtyIdxs(movedIdxsPerChunk_[i]);
+		});
+
+	// rebuilding of world matrices of dirty entities
+	// (reads the Transform so it is executed after the movement)
+	scheduler_.AddSystem(
+		"TransformSystem",
+		GetHashByComponents({ TransformComponent }),
+		GetHashByComponents({ WorldMatrixComponent }),
+		[this](const float totalGameTime, const float deltaTime)
+		{
+			transformSystem_.UpdateDirtyWorldMatrices();
+		});
+
+	// animation of textures
+	scheduler_.AddSystem(
+		"TextureTransformSystem",
+		0,
+		GetHashByComponents({ TextureTransformComponent }),
+		[this](const float totalGameTime, const float deltaTime)
+		{
+			texTransformSystem_.UpdateAllTextrureAnimations(totalGameTime, deltaTime);
+		});
+
+	// animation of light sources
+	scheduler_.AddSystem(
+		"LightSystem",
+		0,
+		GetHashByComponents({ LightComponent }),
+		[this](const float totalGameTime, const float deltaTime)
+		{
+			lightSystem_.Update(deltaTime, totalGameTime);
+		});
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManager::BuildQuery(EnttsQuery& query)
+{
+	// fill in the query with IDs of entities which have all the queried components
+	// and data idxs of these entities into the dense arrays of each component;
+	//
+	// NOTE: we go through the dense arr of the smallest queried component so
+	//       its data idxs in the query are increasing (the data is read contiguously)
+
+	const std::vector<EntityID>* pSmallestIDs = &ids_;
+	std::vector<const SparseSet*> sparseSets;
+
+	query.ids_.clear();
+	query.types_.clear();
+	query.dataIdxs_.clear();
+	query.sparse_.Clear();
+
+	// get a sparse set of each queried component which has dense storage
+	for (u32 type = 0; type < sizeof(ComponentsHash) * 8; ++type)
+	{
+		if (!(query.hash_ & (1u << type)))
+			continue;
+
+		const std::vector<EntityID>* pIDs = nullptr;
+		const SparseSet* pSparse = nullptr;
+
+		GetComponentStorage((ComponentType)type, pIDs, pSparse);
+
+		if (pSparse == nullptr)
+			continue;
+
+		query.types_.push_back((ComponentType)type);
+		sparseSets.push_back(pSparse);
+
+		if (pIDs->size() < pSmallestIDs->size())
+			pSmallestIDs = pIDs;
+	}
+
+	query.dataIdxs_.resize(query.types_.size());
+
+	for (const EntityID id : *pSmallestIDs)
+	{
+		// check if the entity has all the queried components
+		const ptrdiff_t enttIdx = sparse_.GetIdx(id);
+
+		if ((enttIdx == -1) || ((componentHashes_[enttIdx] & query.hash_) != query.hash_))
+			continue;
+
+		// store data idxs of the entity into each component
+		// (skip the entity if some component has no record for it)
+		bool hasAllRecords = true;
+
+		for (const SparseSet* pSparse : sparseSets)
+			hasAllRecords &= pSparse->Has(id);
+
+		if (!hasAllRecords)
+			continue;
+
+		for (size i = 0; i < std::ssize(sparseSets); ++i)
+			query.dataIdxs_[i].push_back(sparseSets[i]->GetIdx(id));
+
+		query.sparse_.Add(id, std::ssize(query.ids_));
+		query.ids_.push_back(id);
 	}
+}
 
-	// after generation we sort IDs so then it will be faster to store them
-	std::sort(outGeneratedIDs.begin(), outGeneratedIDs.end());
+///////////////////////////////////////////////////////////
+
+void EntityManager::GetComponentStorage(
+	const ComponentType type,
+	const std::vector<EntityID>*& outIDs,
+	const SparseSet*& outSparse)
+{
+	// out: ptrs to the dense arr of IDs and the sparse set of the component by type
+	//      (or nullptr if the component has no dense storage)
+
+	outIDs = nullptr;
+	outSparse = nullptr;
+
+	switch (type)
+	{
+		case TransformComponent:        outIDs = &transform_.ids_;        outSparse = &transform_.sparse_;        break;
+		case WorldMatrixComponent:      outIDs = &world_.ids_;            outSparse = &world_.sparse_;            break;
+		case MoveComponent:             outIDs = &movement_.ids_;         outSparse = &movement_.sparse_;         break;
+		case RenderedComponent:         outIDs = &renderComponent_.ids_;  outSparse = &renderComponent_.sparse_;  break;
+		case NameComponent:             outIDs = &names_.ids_;            outSparse = &names_.sparse_;            break;
+		case TexturedComponent:         outIDs = &textureComponent_.ids_; outSparse = &textureComponent_.sparse_; break;
+		case TextureTransformComponent: outIDs = &texTransform_.ids_;     outSparse = &texTransform_.sparse_;     break;
+		case LightComponent:            outIDs = &light_.ids_;            outSparse = &light_.sparse_;            break;
+		case RenderStatesComponent:     outIDs = &renderStates_.ids_;     outSparse = &renderStates_.sparse_;     break;
+		case BoundingComponent:         outIDs = &bounding_.ids_;         outSparse = &bounding_.sparse_;         break;
+		default:                        break;   // the Mesh component (and not implemented ones) has no dense storage
+	}
 }
 
 ///////////////////////////////////////////////////////////
@@ -903,8 +1394,7 @@ void EntityManager::GetDataIdxsByIDs(
 	const std::vector<EntityID>& enttsIDs,
 	std::vector<ptrdiff_t>& outDataIdxs)
 {
-	// get an index into data arrays for each input entity name;
-	// since all the IDs are sorted the output arr will have sorted idxs;
+	// get an index into data arrays for each input entity ID;
 	// 
 	// in:  array of entities IDs
 	// out: array of data idxs
@@ -914,7 +1404,7 @@ void EntityManager::GetDataIdxsByIDs(
 	Assert::True(enttsValid, "there is no entity by some input ID");
 
 	// get data idx into array for each ID
-	Utils::GetIdxsInSortedArr(ids_, enttsIDs, outDataIdxs);
+	sparse_.GetIdxs(enttsIDs, outDataIdxs);
 }
 
 ///////////////////////////////////////////////////////////
@@ -925,7 +1415,7 @@ void EntityManager::GetEnttsIDsByDataIdxs(
 {
 	// get entity ID value from the array by data idx;
 	// 
-	// in:   SORTED array of indices
+	// in:   array of indices
 	// out:  array of entities IDs
 
 	outEnttsIDs.resize(enttsDataIdxs.size());
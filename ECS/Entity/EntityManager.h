@@ -12,8 +12,14 @@
 
 #include <set> 
 #include <cassert>
+#include <memory>
+#include <unordered_map>
 
 #include "../Common/Types.h"
+#include "../Common/SparseSet.h"
+#include "../Common/ThreadPool.h"
+#include "EnttsQuery.h"
+#include "SerializationHelperTypes.h"
 //#include "../Common/log.h"
 
 // components (ECS)
@@ -40,12 +46,20 @@
 #include "../Systems/LightSystem.h"
 #include "../Systems/RenderStatesSystem.h"
 #include "../Systems/BoundingSystem.h"
+#include "../Systems/CullingSystem.h"
+#include "../Systems/LightInfluenceSystem.h"
+#include "../Systems/InstancesCache.h"
+#include "../Systems/SystemsScheduler.h"
 
 namespace ECS
 {
 
 class EntityManager final
 {
+	// the serializer/deserializer have direct access to data of the components
+	friend class EntityManagerSerializer;
+	friend class EntityManagerDeserializer;
+
 public:
 	EntityManager();
 	~EntityManager();
@@ -60,16 +74,47 @@ public:
 	bool Serialize(const std::string& dataFilepath);
 	bool Deserialize(const std::string& dataFilepath);
 
+	// time which was spent on each step of the last Deserialize()
+	inline const SceneLoadTimings& GetSceneLoadTimings() const { return sceneLoadTimings_; }
+
 	// public creation/destroyment API
 	std::vector<EntityID> CreateEntities(const u32 newEnttsCount);
 	void DestroyEntities(const std::vector<EntityID>& enttsIDs);
 
 	EntityID CreateEntity();
-	//void DestroyEntity(const EntityName& enttName);
+	void DestroyEntity(const EntityID id);
 
 
 	void Update(const float totalGameTime, const float deltaTime);
 
+	// set the number of worker threads for updating of systems
+	// (0 -- the single-thread mode: all the systems are updated by the calling thread)
+	void SetWorkersCount(const u32 workersCount);
+	inline u32 GetWorkersCount() const { return threadPool_->GetWorkersCount(); }
+	inline ThreadPool& GetThreadPool() { return *threadPool_; }
+
+	// define which renderable entities are visible by the frustum (viewProj -- view * projection matrix);
+	// the result is stored into the Rendered component as a list of visible entities
+	void ComputeFrustumCulling(const XMMATRIX& viewProj);
+
+	// update lists of the most relevant point/spot lights of visible entities
+	// (the frustum culling must be computed before); lists are recomputed only
+	// for entities which were moved or which are touched by changed lights
+	void UpdateEnttsLights();
+
+	// update cached per-instance rendering data of the bucket; the bucket contains all
+	// the rendered entities with render states of this bucket (this set is recomputed
+	// only after structural changes) and visible instances are selected by the list
+	// of visible entities of the Rendered component
+	const InstancesBucket& UpdateInstancesBucket(const RenderBucketID bucketID);
+
+	// the same but for the input set of entities of the bucket and visible entities
+	// (only instances of changed entities are patched if the set of entities is the same)
+	const InstancesBucket& UpdateInstancesBucket(
+		const RenderBucketID bucketID,
+		const std::vector<EntityID>& enttsIDs,
+		const std::vector<EntityID>& visibleEnttsIDs);
+
 
 	// ------------------------------------------------------------------------
 	// add TRANSFORM component API
@@ -212,6 +257,9 @@ public:
 	// ---------------------------------------------------------------------------
 	// public QUERY API
 
+	const EnttsQuery& Query(const std::vector<ComponentType>& componentsTypes);
+	const EnttsQuery& Query(const ComponentsHash componentsHash);
+
 	inline const Transform& GetComponentTransform() const { return transform_; }
 	inline const Movement& GetComponentMovement()   const { return movement_; }
 	inline const WorldMatrix& GetComponentWorld()   const { return world_; }
@@ -222,6 +270,7 @@ public:
 	inline const TextureTransform& GetComponentTexTransform() const { return texTransform_; }
 	inline const Light& GetComponentLight()         const { return light_; }
 	inline const Bounding& GetComponentBounding()   const { return bounding_; }
+	inline const RenderStates& GetComponentRenderStates() const { return renderStates_; }
 
 	inline const std::map<ComponentType, ComponentID>& GetMapCompTypeToName() {	return componentTypeToName_; }
 	inline const std::vector<EntityID>& GetAllEnttsIDs() const { return ids_; }
@@ -255,6 +304,21 @@ private:
 		const u32 newEnttsCount,
 		std::vector<EntityID>& outGeneratedIDs);
 
+	void ReleaseIDs(const std::vector<EntityID>& ids);
+	void RestoreGenerations(const std::vector<u32>& minFreeGens);
+
+	struct SceneData;
+	void SwapSceneData(SceneData& data);
+
+	void InitSystemsScheduler();
+
+	void BuildQuery(EnttsQuery& query);
+
+	void GetComponentStorage(
+		const ComponentType type,
+		const std::vector<EntityID>*& outIDs,
+		const SparseSet*& outSparse);
+
 	void GetDataIdxsByIDs(
 		const std::vector<EntityID>& enttsIDs,
 		std::vector<ptrdiff_t>& outDataIdxs);
@@ -269,9 +333,6 @@ private:
 
 
 public:
-	static const u32 ENTT_MGR_SERIALIZE_DATA_BLOCK_MARKER = 1000;
-
-
 	// SYSTEMS
 	LightSystem            lightSystem_;
 	NameSystem             nameSystem_;
@@ -283,6 +344,9 @@ public:
 	TextureTransformSystem texTransformSystem_;
 	RenderStatesSystem     renderStatesSystem_;
 	BoundingSystem         boundingSystem_;
+	CullingSystem          cullingSystem_;
+	LightInfluenceSystem   lightInfluenceSystem_;
+	InstancesCache         instancesCache_;
 	
 
 	// "ID" of an entity is just a numeral index
@@ -291,12 +355,38 @@ public:
 	// bit flags for every component, indicating whether this object "has it"
 	std::vector<ComponentsHash> componentHashes_;
 
+	// pairs ['entity_id' => 'data_idx'] into ids_ and componentHashes_
+	SparseSet sparse_;
+
 	// pairs ['component_type' => 'component_name']
 	std::map<ComponentType, ComponentID> componentTypeToName_;  
 
 	//ECS::Log logger_;
 
 private:
+	u32 lastEnttIdx_ = 0;                       // the biggest index of entity ID ever generated (idx == 0 is reserved for INVALID_ENTITY_ID)
+	std::vector<uint8_t> generations_;          // current generation for each entity index
+	std::vector<u32> freeIdxs_;                 // indices of destroyed entities which can be reused
+
+	u32 structVersion_ = 0;                                   // is increased after each structural change (entities or components were added/removed)
+	std::unordered_map<ComponentsHash, EnttsQuery> queries_;  // cached queries: ['components_hash' => 'query']
+
+	std::unique_ptr<ThreadPool> threadPool_;      // worker threads for updating of systems
+	SystemsScheduler            scheduler_;       // per-frame updates of systems with declared read/write components
+	std::vector<std::vector<u32>> movedIdxsPerChunk_;  // data idxs of moved entts for each chunk of the MoveSystem update
+
+	u32 cullingStructVersion_ = UINT32_MAX;       // versions of data when world boxes of the CullingSystem were rebuilt
+	u32 cullingWorldsVersion_ = UINT32_MAX;
+	std::vector<EntityID> visibleEntts_;          // the output of frustum culling (is reused from frame to frame)
+
+	u32 lightsStructVersion_ = UINT32_MAX;        // versions of data when lists of lights of entts were updated
+	u32 lightsWorldsVersion_ = UINT32_MAX;
+	u32 lightsDirtyVersion_  = UINT32_MAX;
+
+	RenderStatesSystem::EnttsRenderStatesData bucketsEntts_;   // all the rendered entts separated by render states (by buckets)
+	u32 bucketsStructVersion_ = UINT32_MAX;
+
+	SceneLoadTimings sceneLoadTimings_;           // timings of the last loading of a scene
 
 	// COMPONENTS
 	Transform        transform_;
@@ -310,6 +400,28 @@ private:
 	Light            light_;
 	RenderStates     renderStates_;
 	Bounding         bounding_;
+
+private:
+	struct SceneData
+	{
+		// data of the manager and the components which is replaced by loading of a scene
+		std::vector<EntityID>       ids;
+		std::vector<ComponentsHash> componentHashes;
+		SparseSet                   sparse;
+		std::vector<uint8_t>        generations;
+
+		Transform        transform;
+		Movement         movement;
+		MeshComponent    meshComponent;
+		WorldMatrix      world;
+		Rendered         renderComponent;
+		Textured         textureComponent;
+		Name             names;
+		TextureTransform texTransform;
+		Light            light;
+		RenderStates     renderStates;
+		Bounding         bounding;
+	};
 };
 
 };
\ No newline at end of file
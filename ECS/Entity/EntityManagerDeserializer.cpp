@@ -1,102 +1,550 @@
 // ********************************************************************************
 // Filename:     EntityManagerDeserializer.cpp
-// Description:  contains implementation of functional 
+// Description:  contains implementation of functional
 //               for the EntityManagerDeserializer
-// 
+//
 // Created:      26.06.24
 // ********************************************************************************
 #include "EntityManagerDeserializer.h"
 
-#include "../Common/UtilsFilesystem.h"
 #include "../Common/Assert.h"
 #include "../Common/Log.h"
 
-#include <fstream>
+#include <chrono>
+#include <utility>
 
 namespace ECS
 {
 
+using Clock = std::chrono::steady_clock;
+
+static float GetElapsedMs(const Clock::time_point startTime)
+{
+	return std::chrono::duration<float, std::milli>(Clock::now() - startTime).count();
+}
+
+///////////////////////////////////////////////////////////
+
+static void CheckCount(const size_t count, const size_t expectedCount, const char* dataName)
+{
+	// check if a deserialized array has the same number of elements as arr of IDs of the component
+	if (count != expectedCount)
+		throw LIB_Exception(std::string("ECS deserialization: wrong number of elements in data: ") + dataName);
+}
+
+///////////////////////////////////////////////////////////
+
 void EntityManagerDeserializer::Deserialize(
 	EntityManager& entityMgr,
 	const std::string& dataFilepath)
 {
-	std::ifstream fin(dataFilepath, std::ios::binary);
-	Assert::True(fin.is_open(), "can't open a file for deserialization: " + dataFilepath);
+	const Clock::time_point startTime = Clock::now();
+	timings_ = SceneLoadTimings();
+
+	// map the file into memory; arrays of blocks are accessed right in the mapping
+	file_.Open(dataFilepath);
+	timings_.openMs = GetElapsedMs(startTime);
+
+	// deserialize EntityManager data (entities IDs, component flags, etc.)
+	// and components data
+	Clock::time_point stepStartTime = Clock::now();
+	DeserializeBlocks(entityMgr);
+	timings_.decodeMs = GetElapsedMs(stepStartTime);
+
+	stepStartTime = Clock::now();
+	ValidateComponents(entityMgr);
+	timings_.validationMs = GetElapsedMs(stepStartTime);
+
+	file_.Close();
+	timings_.totalMs = GetElapsedMs(startTime);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeBlocks(EntityManager& mgr)
+{
+	// blocks are independent from each other: each task reads only its own block
+	// from the shared (read-only) mapping and writes only into its own component
+	// so blocks are decoded in parallel without any synchronization
+
+	using DeserializeFunc = void (EntityManagerDeserializer::*)(EntityManager&) const;
 
-	SerializedDataHeader header;
+	const std::pair<SceneBlockType, DeserializeFunc> blocks[] =
+	{
+		{ SCENE_BLOCK_ENTT_MGR,      &EntityManagerDeserializer::DeserializeDataOfEnttMgr },
+		{ SCENE_BLOCK_TRANSFORM,     &EntityManagerDeserializer::DeserializeTransform },
+		{ SCENE_BLOCK_WORLD_MATRIX,  &EntityManagerDeserializer::DeserializeWorldMatrix },
+		{ SCENE_BLOCK_MOVEMENT,      &EntityManagerDeserializer::DeserializeMovement },
+		{ SCENE_BLOCK_NAME,          &EntityManagerDeserializer::DeserializeName },
+		{ SCENE_BLOCK_MESH,          &EntityManagerDeserializer::DeserializeMesh },
+		{ SCENE_BLOCK_RENDERED,      &EntityManagerDeserializer::DeserializeRendered },
+		{ SCENE_BLOCK_TEXTURED,      &EntityManagerDeserializer::DeserializeTextured },
+		{ SCENE_BLOCK_TEX_TRANSFORM, &EntityManagerDeserializer::DeserializeTexTransform },
+		{ SCENE_BLOCK_LIGHT,         &EntityManagerDeserializer::DeserializeLight },
+		{ SCENE_BLOCK_RENDER_STATES, &EntityManagerDeserializer::DeserializeRenderStates },
+		{ SCENE_BLOCK_BOUNDING,      &EntityManagerDeserializer::DeserializeBounding },
+	};
 
-	ReadDataHeader(fin, header);
+	ThreadPool& threadPool = mgr.GetThreadPool();
+	TaskGroup group;
 
-	// print out header records ['data_block_marker' => 'data_block_pos']
-	for (const SerializedDataHeaderRecord& record : header.records)
+	for (const auto& [type, func] : blocks)
 	{
-		Log::Print(std::to_string(record.dataBlockMarker) + " => " + std::to_string(record.dataBlockPos));
+		threadPool.Submit(group, [this, &mgr, type, func]()
+		{
+			const Clock::time_point startTime = Clock::now();
+			(this->*func)(mgr);
+			timings_.blocksMs[type] = GetElapsedMs(startTime);
+		});
 	}
 
+	// rethrows the first exception which was thrown by some block
+	threadPool.Wait(group);
+}
+
+///////////////////////////////////////////////////////////
 
-	// deserialize EntityManager data: entities IDs, component flags, etc.
-	DeserializeDataOfEnttMgr(fin, entityMgr);
+void EntityManagerDeserializer::ValidateComponents(EntityManager& mgr)
+{
+	// check that each component has records exactly for those entities
+	// which have this component by their components hashes;
+	// components are checked in parallel (each task only reads data)
 
-	// deserialize components data
-	entityMgr.transformSystem_.Deserialize(fin, header.GetDataBlockPos(TransformComponent));
-	entityMgr.nameSystem_.Deserialize(fin, header.GetDataBlockPos(NameComponent));
-	entityMgr.meshSystem_.Deserialize(fin, header.GetDataBlockPos(MeshComp));
-	entityMgr.moveSystem_.Deserialize(fin, header.GetDataBlockPos(MoveComponent));
-	entityMgr.renderSystem_.Deserialize(fin, header.GetDataBlockPos(RenderedComponent));
+	struct ComponentIDs
+	{
+		ComponentType                 type;
+		const std::vector<EntityID>*  pIDs;
+		const SparseSet*              pSparse;
+		const char*                   name;
+	};
+
+	const ComponentIDs components[] =
+	{
+		{ TransformComponent,        &mgr.transform_.ids_,        &mgr.transform_.sparse_,        "Transform" },
+		{ WorldMatrixComponent,      &mgr.world_.ids_,            &mgr.world_.sparse_,            "WorldMatrix" },
+		{ MoveComponent,             &mgr.movement_.ids_,         &mgr.movement_.sparse_,         "Movement" },
+		{ NameComponent,             &mgr.names_.ids_,            &mgr.names_.sparse_,            "Name" },
+		{ MeshComp,                  &mgr.meshComponent_.ids_,    &mgr.meshComponent_.sparse_,    "MeshComponent" },
+		{ RenderedComponent,         &mgr.renderComponent_.ids_,  &mgr.renderComponent_.sparse_,  "Rendered" },
+		{ TexturedComponent,         &mgr.textureComponent_.ids_, &mgr.textureComponent_.sparse_, "Textured" },
+		{ TextureTransformComponent, &mgr.texTransform_.ids_,     &mgr.texTransform_.sparse_,     "TextureTransform" },
+		{ LightComponent,            &mgr.light_.ids_,            &mgr.light_.sparse_,            "Light" },
+		{ RenderStatesComponent,     &mgr.renderStates_.ids_,     &mgr.renderStates_.sparse_,     "RenderStates" },
+		{ BoundingComponent,         &mgr.bounding_.ids_,         &mgr.bounding_.sparse_,         "Bounding" },
+	};
+
+	ThreadPool& threadPool = mgr.GetThreadPool();
+	TaskGroup group;
+
+	for (const ComponentIDs& comp : components)
+	{
+		threadPool.Submit(group, [&mgr, &comp]()
+		{
+			const ComponentsHash bit = (1 << comp.type);
+			size_t recordsCount = 0;
+
+			// each record of the component must belong to an existing entity which has this component
+			// (records with INVALID_ENTITY_ID are default records, for instance: the default textures set)
+			for (const EntityID id : *comp.pIDs)
+			{
+				if (id == INVALID_ENTITY_ID)
+					continue;
+
+				const ptrdiff_t idx = mgr.sparse_.GetIdx(id);
+
+				if ((idx == -1) || !(mgr.componentHashes_[idx] & bit))
+					throw LIB_Exception(std::string("ECS deserialization: there is a record of unknown entity in the component: ") + comp.name);
+
+				++recordsCount;
+			}
+
+			// each entity which has this component must have a record in it
+			size_t enttsCount = 0;
+
+			for (size_t i = 0; i < mgr.ids_.size(); ++i)
+			{
+				if (!(mgr.componentHashes_[i] & bit))
+					continue;
+
+				if (!comp.pSparse->Has(mgr.ids_[i]))
+					throw LIB_Exception(std::string("ECS deserialization: there is no record of entity in the component: ") + comp.name);
+
+				++enttsCount;
+			}
+
+			// the same number of records and entities means there are no duplicated records
+			CheckCount(recordsCount, enttsCount, comp.name);
+		});
+	}
 
-	fin.close();
+	threadPool.Wait(group);
 }
 
 ///////////////////////////////////////////////////////////
 
-void EntityManagerDeserializer::ReadDataHeader(
-	std::ifstream& fin,
-	SerializedDataHeader& header)
+void EntityManagerDeserializer::DeserializeDataOfEnttMgr(EntityManager& mgr) const
 {
-	// read in the data header from the data file;
-	// so later we'll use this header to navigate through the file to
-	// deserialize EntityManager and Components data;
+	// deserialize data for the entity manager: all the entities IDs
+	// and related components flags (not components data itself or something else)
+
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_ENTT_MGR);
+	Assert::True(!block.IsEmpty(), "ECS deserialization: there is no data for the EntityManager");
+
+	block.Next(mgr.ids_);
+	block.Next(mgr.componentHashes_);
 
-	Utils::FileRead(fin, &(header.recordsCount));
+	CheckCount(mgr.componentHashes_.size(), mgr.ids_.size(), "components hashes of entities");
 
-	header.records.resize(header.recordsCount);
+	// generations of indices (including free ones) are restored by the EntityManager itself
+	block.Next(mgr.generations_);
 
-	for (SerializedDataHeaderRecord& record : header.records)
+	for (const EntityID id : mgr.ids_)
 	{
-		Utils::FileRead(fin, &(record.dataBlockMarker));
-		Utils::FileRead(fin, &(record.dataBlockPos));
+		const u32 idx = GetEnttIdx(id);
+
+		if ((idx == 0) || (idx >= mgr.generations_.size()) || (mgr.generations_[idx] != GetEnttGen(id)))
+			throw LIB_Exception("ECS deserialization: wrong generation of entity ID: " + std::to_string(id));
 	}
+
+	// rebuild the mapping ['entity_id' => 'data_idx'] (is used for validation of components)
+	mgr.sparse_.Rebuild(mgr.ids_);
 }
 
 ///////////////////////////////////////////////////////////
 
-void EntityManagerDeserializer::DeserializeDataOfEnttMgr(
-	std::ifstream& fin,
-	EntityManager& entityMgr)
+void EntityManagerDeserializer::DeserializeTransform(EntityManager& mgr) const
 {
-	// deserialize data for the entity manager: all the entities IDs 
-	// and related components flags (not components data itself or something else)
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_TRANSFORM);
+	Transform& comp = mgr.transform_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.posAndUniformScale_);
+	block.Next(comp.dirQuats_);
+	block.Next(comp.dirtyFlags_);
+
+	CheckCount(comp.posAndUniformScale_.size(), comp.ids_.size(), "Transform: positions");
+	CheckCount(comp.dirQuats_.size(),           comp.ids_.size(), "Transform: direction quaternions");
+	CheckCount(comp.dirtyFlags_.size(),         comp.ids_.size(), "Transform: dirty flags");
+
+	comp.sparse_.Rebuild(comp.ids_);
+	mgr.transformSystem_.RebuildDirtyIdxs();
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeWorldMatrix(EntityManager& mgr) const
+{
+	// world matrices are stored as well so we don't need to rebuild them after loading
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_WORLD_MATRIX);
+	WorldMatrix& comp = mgr.world_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.worlds_);
+
+	CheckCount(comp.worlds_.size(), comp.ids_.size(), "WorldMatrix: world matrices");
+
+	comp.sparse_.Rebuild(comp.ids_);
+	++comp.version_;
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeMovement(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_MOVEMENT);
+	Movement& comp = mgr.movement_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.translationAndUniScales_);
+	block.Next(comp.rotationQuats_);
+
+	CheckCount(comp.translationAndUniScales_.size(), comp.ids_.size(), "Movement: translations");
+	CheckCount(comp.rotationQuats_.size(),           comp.ids_.size(), "Movement: rotation quaternions");
+
+	comp.sparse_.Rebuild(comp.ids_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeName(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_NAME);
+	Name& comp = mgr.names_;
+
+	block.Next(comp.ids_);
+	const std::span<const u32> namesIdxs = block.Next<u32>();
+
+	CheckCount(namesIdxs.size(), comp.ids_.size(), "Name: names");
+
+	// names are copied from the string table
+	comp.names_.resize(namesIdxs.size());
+
+	for (size_t i = 0; i < namesIdxs.size(); ++i)
+		comp.names_[i] = file_.GetString(namesIdxs[i]);
+
+	comp.sparse_.Rebuild(comp.ids_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeMesh(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_MESH);
+	MeshComponent& comp = mgr.meshComponent_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.enttsOffsets_);
+	block.Next(comp.enttsMeshes_);
+
+	if (comp.enttsOffsets_.empty())
+		comp.enttsOffsets_.push_back(0);
 
-	u32 dataBlockMarker = 0;
-	Utils::FileRead(fin, &dataBlockMarker);
+	CheckCount(comp.enttsOffsets_.size(), comp.ids_.size() + 1, "MeshComponent: offsets of meshes of entities");
 
-	const bool isProperDataBlock = (dataBlockMarker == EntityManager::ENTT_MGR_SERIALIZE_DATA_BLOCK_MARKER);
-	Assert::True(isProperDataBlock, "ECS deserialization: read wrong block of data (there must be data for the EntityManager)");
+	// offsets must go from 0 to the number of meshes without decreasing
+	bool isValidOffsets = (comp.enttsOffsets_.front() == 0) && (comp.enttsOffsets_.back() == comp.enttsMeshes_.size());
 
-	// --------------------------------
+	for (size_t i = 1; isValidOffsets && (i < comp.enttsOffsets_.size()); ++i)
+		isValidOffsets = (comp.enttsOffsets_[i - 1] <= comp.enttsOffsets_[i]);
 
-	// read in how much data will we have for the entity manager
-	u32 dataCount = 0;
-	Utils::FileRead(fin, &dataCount);
+	if (!isValidOffsets)
+		throw LIB_Exception("ECS deserialization: wrong offsets of meshes of entities");
 
-	// prepare enough amount of memory for data
-	entityMgr.ids_.resize(dataCount);
-	entityMgr.componentHashes_.resize(dataCount);
+	comp.sparse_.Rebuild(comp.ids_);
 
-	Utils::FileRead(fin, entityMgr.ids_);
-	Utils::FileRead(fin, entityMgr.componentHashes_);
+	// the mapping ['mesh_id' => 'entities'] will be rebuilt by the MeshSystem when it's needed
+	comp.meshesIDs_.clear();
+	comp.meshesOffsets_.assign(1, 0);
+	comp.meshesEntts_.clear();
+	comp.isMeshToEnttsDirty_ = true;
 }
 
 ///////////////////////////////////////////////////////////
 
-}
\ No newline at end of file
+void EntityManagerDeserializer::DeserializeRendered(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_RENDERED);
+	Rendered& comp = mgr.renderComponent_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.shaderTypes_);
+	block.Next(comp.primTopologies_);
+
+	CheckCount(comp.shaderTypes_.size(),    comp.ids_.size(), "Rendered: shaders types");
+	CheckCount(comp.primTopologies_.size(), comp.ids_.size(), "Rendered: primitive topologies");
+
+	comp.sparse_.Rebuild(comp.ids_);
+	comp.visibleEnttsIDs_.clear();
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeTextured(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_TEXTURED);
+	Textured& comp = mgr.textureComponent_;
+
+	block.Next(comp.ids_);
+	const std::span<const u32>   texIDsOffsets   = block.Next<u32>();
+	const std::span<const TexID> texIDs          = block.Next<TexID>();
+	const std::span<const u32>   texPathsOffsets = block.Next<u32>();
+	const std::span<const u32>   texPathsIdxs    = block.Next<u32>();
+
+	const size_t enttsCount = comp.ids_.size();
+
+	comp.texIDs_.resize(enttsCount);
+	comp.texPaths_.resize(enttsCount);
+
+	if (enttsCount > 0)
+	{
+		CheckCount(texIDsOffsets.size(),   enttsCount + 1, "Textured: offsets of textures IDs");
+		CheckCount(texPathsOffsets.size(), enttsCount + 1, "Textured: offsets of textures paths");
+		CheckCount(texIDsOffsets.back(),   texIDs.size(),       "Textured: textures IDs");
+		CheckCount(texPathsOffsets.back(), texPathsIdxs.size(), "Textured: textures paths");
+	}
+
+	// restore arrays of textures of each entity from flattened arrays
+	for (size_t i = 0; i < enttsCount; ++i)
+	{
+		if ((texIDsOffsets[i] > texIDsOffsets[i + 1]) || (texPathsOffsets[i] > texPathsOffsets[i + 1]))
+			throw LIB_Exception("ECS deserialization: wrong offsets of textures of entities");
+
+		comp.texIDs_[i].assign(texIDs.begin() + texIDsOffsets[i], texIDs.begin() + texIDsOffsets[i + 1]);
+
+		std::vector<TexPath>& paths = comp.texPaths_[i];
+		paths.resize(texPathsOffsets[i + 1] - texPathsOffsets[i]);
+
+		for (size_t pathIdx = 0; pathIdx < paths.size(); ++pathIdx)
+			paths[pathIdx] = file_.GetString(texPathsIdxs[texPathsOffsets[i] + pathIdx]);
+	}
+
+	comp.sparse_.Rebuild(comp.ids_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeTexTransform(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_TEX_TRANSFORM);
+	TextureTransform& comp = mgr.texTransform_;
+
+	TexStaticTransformations& staticTrans = comp.texStaticTrans_;
+	TexAtlasAnimations&       atlasAnim   = comp.texAtlasAnim_;
+	TexRotationsAroundCoords& rotations   = comp.texRotations_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.transformTypes_);
+	block.Next(comp.texTransforms_);
+
+	block.Next(staticTrans.ids_);
+	block.Next(staticTrans.transformations_);
+
+	block.Next(atlasAnim.ids_);
+	block.Next(atlasAnim.timeSteps_);
+	block.Next(atlasAnim.currAnimTime_);
+	block.Next(atlasAnim.data_);
+
+	block.Next(rotations.ids_);
+	block.Next(rotations.texCoords_);
+	block.Next(rotations.rotationsSpeed_);
+
+	CheckCount(comp.transformTypes_.size(),        comp.ids_.size(),        "TextureTransform: types of transformations");
+	CheckCount(comp.texTransforms_.size(),         comp.ids_.size(),        "TextureTransform: transformations");
+	CheckCount(staticTrans.transformations_.size(), staticTrans.ids_.size(), "TextureTransform: static transformations");
+	CheckCount(atlasAnim.timeSteps_.size(),        atlasAnim.ids_.size(),   "TextureTransform: time steps of atlas animations");
+	CheckCount(atlasAnim.currAnimTime_.size(),     atlasAnim.ids_.size(),   "TextureTransform: time of atlas animations");
+	CheckCount(atlasAnim.data_.size(),             atlasAnim.ids_.size(),   "TextureTransform: atlas animations");
+	CheckCount(rotations.texCoords_.size(),        rotations.ids_.size(),   "TextureTransform: centers of rotations");
+	CheckCount(rotations.rotationsSpeed_.size(),   rotations.ids_.size(),   "TextureTransform: speeds of rotations");
+
+	comp.sparse_.Rebuild(comp.ids_);
+	staticTrans.sparse_.Rebuild(staticTrans.ids_);
+	atlasAnim.sparse_.Rebuild(atlasAnim.ids_);
+	rotations.sparse_.Rebuild(rotations.ids_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeLight(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_LIGHT);
+	Light& comp = mgr.light_;
+
+	block.Next(comp.ids_);
+
+	block.Next(comp.dirLights_.ids_);
+	block.Next(comp.dirLights_.data_);
+
+	block.Next(comp.pointLights_.ids_);
+	block.Next(comp.pointLights_.data_);
+
+	block.Next(comp.spotLights_.ids_);
+	block.Next(comp.spotLights_.data_);
+
+	CheckCount(comp.dirLights_.data_.size(),   comp.dirLights_.ids_.size(),   "Light: directional lights");
+	CheckCount(comp.pointLights_.data_.size(), comp.pointLights_.ids_.size(), "Light: point lights");
+	CheckCount(comp.spotLights_.data_.size(),  comp.spotLights_.ids_.size(),  "Light: spot lights");
+
+	ReadLightAnimations(block, comp.pointLights_.ids_, comp.pointLightsAnims_);
+	ReadLightAnimations(block, comp.spotLights_.ids_,  comp.spotLightsAnims_);
+
+	comp.sparse_.Rebuild(comp.ids_);
+	comp.dirLights_.sparse_.Rebuild(comp.dirLights_.ids_);
+	comp.pointLights_.sparse_.Rebuild(comp.pointLights_.ids_);
+	comp.spotLights_.sparse_.Rebuild(comp.spotLights_.ids_);
+
+	// all the lights must be uploaded to the GPU
+	comp.dirLights_.dirtyRange_.Add(0, (u32)comp.dirLights_.GetCount());
+	comp.pointLights_.dirtyRange_.Add(0, (u32)comp.pointLights_.GetCount());
+	comp.spotLights_.dirtyRange_.Add(0, (u32)comp.spotLights_.GetCount());
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::ReadLightAnimations(
+	SceneBlockReader& block,
+	const std::vector<EntityID>& lightsIDs,
+	LightAnimations& anims) const
+{
+	// in: lightsIDs - IDs of lights of the container which is animated by anims
+	block.Next(anims.ids_);
+	block.Next(anims.dataIdxs_);
+	block.Next(anims.types_);
+	block.Next(anims.baseDiffuses_);
+	block.Next(anims.baseSpeculars_);
+
+	block.Next(anims.centersX_);
+	block.Next(anims.centersY_);
+	block.Next(anims.centersZ_);
+	block.Next(anims.radiuses_);
+	block.Next(anims.speeds_);
+	block.Next(anims.phases_);
+	block.Next(anims.amplitudes_);
+
+	block.Next(anims.positionsX_);
+	block.Next(anims.positionsY_);
+	block.Next(anims.positionsZ_);
+	block.Next(anims.pulses_);
+	block.Next(anims.flickers_);
+
+	const size_t count = anims.ids_.size();
+
+	CheckCount(anims.dataIdxs_.size(),      count, "Light: idxs of animated lights");
+	CheckCount(anims.types_.size(),         count, "Light: types of animations");
+	CheckCount(anims.baseDiffuses_.size(),  count, "Light: base diffuse colors of animations");
+	CheckCount(anims.baseSpeculars_.size(), count, "Light: base specular colors of animations");
+
+	// each animation must refer to its own light in the container
+	for (size_t i = 0; i < count; ++i)
+	{
+		const u32 dataIdx = anims.dataIdxs_[i];
+
+		if ((dataIdx >= lightsIDs.size()) || (lightsIDs[dataIdx] != anims.ids_[i]))
+			throw LIB_Exception("ECS deserialization: wrong idx of animated light: " + std::to_string(anims.ids_[i]));
+	}
+
+	// SoA arrays of curves are padded to a multiple of 4
+	const size_t paddedCount = (count + 3) & ~(size_t)3;
+
+	for (const std::vector<float>* pArr : {
+		&anims.centersX_, &anims.centersY_, &anims.centersZ_, &anims.radiuses_,
+		&anims.speeds_, &anims.phases_, &anims.amplitudes_,
+		&anims.positionsX_, &anims.positionsY_, &anims.positionsZ_, &anims.pulses_, &anims.flickers_ })
+	{
+		CheckCount(pArr->size(), paddedCount, "Light: params of animations");
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeRenderStates(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_RENDER_STATES);
+	RenderStates& comp = mgr.renderStates_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.statesHashes_);
+
+	CheckCount(comp.statesHashes_.size(), comp.ids_.size(), "RenderStates: hashes of states");
+
+	comp.sparse_.Rebuild(comp.ids_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerDeserializer::DeserializeBounding(EntityManager& mgr) const
+{
+	SceneBlockReader block = file_.GetBlock(SCENE_BLOCK_BOUNDING);
+	Bounding& comp = mgr.bounding_;
+
+	block.Next(comp.ids_);
+	block.Next(comp.types_);
+	block.Next(comp.data_);
+
+	CheckCount(comp.types_.size(), comp.ids_.size(), "Bounding: types of bounding shapes");
+	CheckCount(comp.data_.size(),  comp.ids_.size(), "Bounding: bounding boxes");
+
+	comp.sparse_.Rebuild(comp.ids_);
+}
+
+}
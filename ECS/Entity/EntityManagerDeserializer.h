@@ -1,14 +1,15 @@
 // ********************************************************************************
 // Filename:     EntityManagerDeserializer.h
 // Description:  contains functional for deserialization of the EntityManager data
-//               as well as the components
-// 
+//               as well as the components from the scene file
+//               (see SerializationHelperTypes.h for the layout of the file)
+//
 // Created:      26.06.24
 // ********************************************************************************
 #pragma once
 
 #include "EntityManager.h"
-#include "SerializationHelperTypes.h"
+#include "SceneFileView.h"
 
 namespace ECS
 {
@@ -22,14 +23,34 @@ public:
 		EntityManager& entityMgr,
 		const std::string& dataFilepath);
 
+	inline const SceneLoadTimings& GetTimings() const { return timings_; }
+
 private:
-	void ReadDataHeader(
-		std::ifstream& fin,
-		SerializedDataHeader& header);
+	// each block is restored independently from others (by its own task)
+	void DeserializeBlocks(EntityManager& mgr);
+	void ValidateComponents(EntityManager& mgr);
+
+	void DeserializeDataOfEnttMgr(EntityManager& mgr) const;
+	void DeserializeTransform    (EntityManager& mgr) const;
+	void DeserializeWorldMatrix  (EntityManager& mgr) const;
+	void DeserializeMovement     (EntityManager& mgr) const;
+	void DeserializeName         (EntityManager& mgr) const;
+	void DeserializeMesh         (EntityManager& mgr) const;
+	void DeserializeRendered     (EntityManager& mgr) const;
+	void DeserializeTextured     (EntityManager& mgr) const;
+	void DeserializeTexTransform (EntityManager& mgr) const;
+	void DeserializeLight        (EntityManager& mgr) const;
+	void DeserializeRenderStates (EntityManager& mgr) const;
+	void DeserializeBounding     (EntityManager& mgr) const;
 
-	void DeserializeDataOfEnttMgr(
-		std::ifstream& fin,
-		EntityManager& entityMgr);
+	void ReadLightAnimations(
+		SceneBlockReader& block,
+		const std::vector<EntityID>& lightsIDs,
+		LightAnimations& anims) const;
+
+private:
+	SceneFileView    file_;
+	SceneLoadTimings timings_;
 };
 
-}
\ No newline at end of file
+}
@@ -1,13 +1,12 @@
 // ********************************************************************************
 // Filename:     EntityManagerSerializer.cpp
-// Description:  contains implementation of functional 
+// Description:  contains implementation of functional
 //               for the EntityManagerSerializer
-// 
+//
 // Created:      26.06.24
 // ********************************************************************************
 #include "EntityManagerSerializer.h"
 
-#include "../Common/UtilsFilesystem.h"
 #include "../Common/LIB_Exception.h"
 #include "../Common/Log.h"
 #include "../Common/Assert.h"
@@ -21,70 +20,295 @@ void EntityManagerSerializer::Serialize(
 	EntityManager& entityMgr,
 	const std::string& dataFilepath)
 {
-	std::ofstream fout(dataFilepath, std::ios::binary);
-	Assert::True(fout.is_open(), "can't open a file for serialization: " + dataFilepath);
-
-	SerializedDataHeader header;
+	blocks_.reserve(NUM_SCENE_BLOCKS);
 
-	// write into the file a header and data from the EntityManager (IDs, component flags, etc.)
-	WriteDataHeader(fout, header);
-	SerializeDataOfEnttMgr(fout, entityMgr);
+	// data of the EntityManager (IDs, component flags, etc.)
+	Block& enttMgrBlock = AddBlock(SCENE_BLOCK_ENTT_MGR);
+	enttMgrBlock.Add(entityMgr.ids_);
+	enttMgrBlock.Add(entityMgr.componentHashes_);
+	enttMgrBlock.Add(entityMgr.generations_);
 
-	// serialize data from the all components
-	entityMgr.transformSystem_.Serialize(fout, header.GetDataBlockPos(TransformComponent));
-	entityMgr.moveSystem_.Serialize(fout, header.GetDataBlockPos(MoveComponent));
-	entityMgr.nameSystem_.Serialize(fout, header.GetDataBlockPos(NameComponent));
-	entityMgr.meshSystem_.Serialize(fout, header.GetDataBlockPos(MeshComp));
-	entityMgr.renderSystem_.Serialize(fout, header.GetDataBlockPos(RenderedComponent));
+	AddBlocksOfComponents(entityMgr);
 
-	// go at the beginning of the file and update the header
-	fout.seekp(0, std::ios_base::beg);
-	WriteDataHeader(fout, header);
+	// the string table goes after all the blocks which have strings
+	Block& stringsBlock = AddBlock(SCENE_BLOCK_STRINGS);
+	stringsBlock.Add(strOffsets_);
+	stringsBlock.Add(strChars_);
 
-	fout.close();
+	WriteFile(dataFilepath);
 
 	Log::Debug("data from the ECS has been saved successfully into the file: " + dataFilepath);
 }
 
 ///////////////////////////////////////////////////////////
 
-void EntityManagerSerializer::WriteDataHeader(
-	std::ofstream& fout,
-	SerializedDataHeader& header)
+EntityManagerSerializer::Block& EntityManagerSerializer::AddBlock(const SceneBlockType type)
+{
+	blocks_.push_back(Block{ type });
+	return blocks_.back();
+}
+
+///////////////////////////////////////////////////////////
+
+u32 EntityManagerSerializer::AddString(const std::string& str)
+{
+	// add the string into the string table (if there is no such a string yet);
+	// return: idx of the string in the table
+
+	const auto [it, isNew] = strToIdx_.try_emplace(str, (u32)(strOffsets_.size() - 1));
+
+	if (isNew)
+	{
+		strChars_.insert(strChars_.end(), str.begin(), str.end());
+		strOffsets_.push_back((u32)strChars_.size());
+	}
+
+	return it->second;
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerSerializer::AddBlocksOfComponents(EntityManager& mgr)
+{
+	// add references to data arrays of the all components;
+	// NOTE: the order of arrays in each block must be the same as
+	//       the order of reading in the EntityManagerDeserializer
+
+	Block& transform = AddBlock(SCENE_BLOCK_TRANSFORM);
+	transform.Add(mgr.transform_.ids_);
+	transform.Add(mgr.transform_.posAndUniformScale_);
+	transform.Add(mgr.transform_.dirQuats_);
+	transform.Add(mgr.transform_.dirtyFlags_);
+
+	Block& world = AddBlock(SCENE_BLOCK_WORLD_MATRIX);
+	world.Add(mgr.world_.ids_);
+	world.Add(mgr.world_.worlds_);
+
+	Block& move = AddBlock(SCENE_BLOCK_MOVEMENT);
+	move.Add(mgr.movement_.ids_);
+	move.Add(mgr.movement_.translationAndUniScales_);
+	move.Add(mgr.movement_.rotationQuats_);
+
+	// names are stored as idxs into the string table
+	namesIdxs_.resize(mgr.names_.names_.size());
+
+	for (size i = 0; i < std::ssize(namesIdxs_); ++i)
+		namesIdxs_[i] = AddString(mgr.names_.names_[i]);
+
+	Block& name = AddBlock(SCENE_BLOCK_NAME);
+	name.Add(mgr.names_.ids_);
+	name.Add(namesIdxs_);
+
+	// the mapping ['mesh_id' => 'entities'] isn't stored since it's rebuilt by the MeshSystem
+	Block& mesh = AddBlock(SCENE_BLOCK_MESH);
+	mesh.Add(mgr.meshComponent_.ids_);
+	mesh.Add(mgr.meshComponent_.enttsOffsets_);
+	mesh.Add(mgr.meshComponent_.enttsMeshes_);
+
+	Block& rendered = AddBlock(SCENE_BLOCK_RENDERED);
+	rendered.Add(mgr.renderComponent_.ids_);
+	rendered.Add(mgr.renderComponent_.shaderTypes_);
+	rendered.Add(mgr.renderComponent_.primTopologies_);
+
+	AddBlockOfTextured(mgr.textureComponent_);
+	AddBlockOfTexTransform(mgr.texTransform_);
+	AddBlockOfLight(mgr.light_);
+
+	Block& renderStates = AddBlock(SCENE_BLOCK_RENDER_STATES);
+	renderStates.Add(mgr.renderStates_.ids_);
+	renderStates.Add(mgr.renderStates_.statesHashes_);
+
+	Block& bounding = AddBlock(SCENE_BLOCK_BOUNDING);
+	bounding.Add(mgr.bounding_.ids_);
+	bounding.Add(mgr.bounding_.types_);
+	bounding.Add(mgr.bounding_.data_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerSerializer::AddBlockOfTextured(const Textured& comp)
+{
+	// arrays of textures of each entity are flattened into a single array
+	// and arrays of offsets (the same way as the MeshComponent does)
+
+	texIDsOffsets_.assign(1, 0);
+	texPathsOffsets_.assign(1, 0);
+	texIDs_.clear();
+	texPathsIdxs_.clear();
+
+	for (const std::vector<TexID>& texIDs : comp.texIDs_)
+	{
+		texIDs_.insert(texIDs_.end(), texIDs.begin(), texIDs.end());
+		texIDsOffsets_.push_back((u32)texIDs_.size());
+	}
+
+	for (const std::vector<TexPath>& texPaths : comp.texPaths_)
+	{
+		for (const TexPath& path : texPaths)
+			texPathsIdxs_.push_back(AddString(path));
+
+		texPathsOffsets_.push_back((u32)texPathsIdxs_.size());
+	}
+
+	Block& block = AddBlock(SCENE_BLOCK_TEXTURED);
+	block.Add(comp.ids_);
+	block.Add(texIDsOffsets_);
+	block.Add(texIDs_);
+	block.Add(texPathsOffsets_);
+	block.Add(texPathsIdxs_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerSerializer::AddBlockOfTexTransform(const TextureTransform& comp)
 {
-	// write into a file by dataFilepath the data header for all the data
-	// related to the Entity-Component-System; so later this header will be used
-	// to get a position of the necessary block of data;
+	Block& block = AddBlock(SCENE_BLOCK_TEX_TRANSFORM);
+
+	block.Add(comp.ids_);
+	block.Add(comp.transformTypes_);
+	block.Add(comp.texTransforms_);
 
-	header.recordsCount = 17;     // one block per component
-	header.records.resize(header.recordsCount);
+	block.Add(comp.texStaticTrans_.ids_);
+	block.Add(comp.texStaticTrans_.transformations_);
 
-	for (u32 idx = 0; idx < header.recordsCount; ++idx)
-		header.records[idx].dataBlockMarker = idx;
+	block.Add(comp.texAtlasAnim_.ids_);
+	block.Add(comp.texAtlasAnim_.timeSteps_);
+	block.Add(comp.texAtlasAnim_.currAnimTime_);
+	block.Add(comp.texAtlasAnim_.data_);
 
-	// write the header into the file
-	Utils::FileWrite(fout, &(header.recordsCount));
-	Utils::FileWrite(fout, header.records);
+	block.Add(comp.texRotations_.ids_);
+	block.Add(comp.texRotations_.texCoords_);
+	block.Add(comp.texRotations_.rotationsSpeed_);
 }
 
 ///////////////////////////////////////////////////////////
 
-void EntityManagerSerializer::SerializeDataOfEnttMgr(
-	std::ofstream& fout,
-	EntityManager& entityMgr)
+void EntityManagerSerializer::AddBlockOfLight(const Light& comp)
 {
-	// serialize data of the entity manager: all the entities IDs 
-	// and related components flags (not components data itself or something else)
+	Block& block = AddBlock(SCENE_BLOCK_LIGHT);
 
-	const u32 dataBlockMarker = EntityManager::ENTT_MGR_SERIALIZE_DATA_BLOCK_MARKER;
-	const u32 dataCount = (u32)std::ssize(entityMgr.ids_);
+	block.Add(comp.ids_);
 
-	// write data into the data file
-	Utils::FileWrite(fout, &dataBlockMarker);
-	Utils::FileWrite(fout, &dataCount);
+	block.Add(comp.dirLights_.ids_);
+	block.Add(comp.dirLights_.data_);
 
-	Utils::FileWrite(fout, entityMgr.ids_);
-	Utils::FileWrite(fout, entityMgr.componentHashes_);
+	block.Add(comp.pointLights_.ids_);
+	block.Add(comp.pointLights_.data_);
+
+	block.Add(comp.spotLights_.ids_);
+	block.Add(comp.spotLights_.data_);
+
+	AddLightAnimations(block, comp.pointLightsAnims_);
+	AddLightAnimations(block, comp.spotLightsAnims_);
 }
 
-}
\ No newline at end of file
+///////////////////////////////////////////////////////////
+
+void EntityManagerSerializer::AddLightAnimations(Block& block, const LightAnimations& anims)
+{
+	block.Add(anims.ids_);
+	block.Add(anims.dataIdxs_);
+	block.Add(anims.types_);
+	block.Add(anims.baseDiffuses_);
+	block.Add(anims.baseSpeculars_);
+
+	// params and outputs of curves (arrays are padded to a multiple of 4)
+	block.Add(anims.centersX_);
+	block.Add(anims.centersY_);
+	block.Add(anims.centersZ_);
+	block.Add(anims.radiuses_);
+	block.Add(anims.speeds_);
+	block.Add(anims.phases_);
+	block.Add(anims.amplitudes_);
+
+	block.Add(anims.positionsX_);
+	block.Add(anims.positionsY_);
+	block.Add(anims.positionsZ_);
+	block.Add(anims.pulses_);
+	block.Add(anims.flickers_);
+}
+
+///////////////////////////////////////////////////////////
+
+void EntityManagerSerializer::WriteFile(const std::string& dataFilepath)
+{
+	// compute positions of all the tables and arrays first so then
+	// the whole file is written sequentially (without going back to the header)
+
+	SceneFileHeader header;
+	std::vector<SceneBlockDesc> blocksDescs(blocks_.size());
+	std::vector<std::vector<SceneArrayDesc>> arraysDescs(blocks_.size());
+
+	header.blocksCount    = (u32)blocks_.size();
+	header.blocksTablePos = sizeof(SceneFileHeader);
+
+	uint64_t pos = header.blocksTablePos + blocks_.size() * sizeof(SceneBlockDesc);
+
+	for (size_t blockIdx = 0; blockIdx < blocks_.size(); ++blockIdx)
+	{
+		const Block&    block = blocks_[blockIdx];
+		SceneBlockDesc& desc  = blocksDescs[blockIdx];
+
+		pos = AlignScenePos(pos);
+
+		desc.type           = block.type;
+		desc.arraysCount    = (u32)block.arrays.size();
+		desc.arraysTablePos = pos;
+
+		pos += block.arrays.size() * sizeof(SceneArrayDesc);
+
+		for (const ArrayRef& arr : block.arrays)
+		{
+			pos = AlignScenePos(pos);
+			arraysDescs[blockIdx].push_back({ pos, arr.count, arr.elemSize });
+			pos += arr.count * arr.elemSize;
+		}
+
+		desc.size = pos - desc.arraysTablePos;
+	}
+
+	header.fileSize = pos;
+
+	// ---------------------------------------------
+
+	std::ofstream fout(dataFilepath, std::ios::binary);
+	Assert::True(fout.is_open(), "can't open a file for serialization: " + dataFilepath);
+
+	const char padding[SCENE_FILE_ALIGNMENT] = { 0 };
+	uint64_t   currPos = 0;
+
+	// write zeros until the position
+	auto WritePadding = [&](const uint64_t toPos)
+	{
+		fout.write(padding, (std::streamsize)(toPos - currPos));
+		currPos = toPos;
+	};
+
+	fout.write((const char*)&header, sizeof(header));
+	fout.write((const char*)blocksDescs.data(), blocksDescs.size() * sizeof(SceneBlockDesc));
+	currPos = header.blocksTablePos + blocksDescs.size() * sizeof(SceneBlockDesc);
+
+	for (size_t blockIdx = 0; blockIdx < blocks_.size(); ++blockIdx)
+	{
+		const std::vector<SceneArrayDesc>& arrays = arraysDescs[blockIdx];
+
+		WritePadding(blocksDescs[blockIdx].arraysTablePos);
+		fout.write((const char*)arrays.data(), arrays.size() * sizeof(SceneArrayDesc));
+		currPos += arrays.size() * sizeof(SceneArrayDesc);
+
+		for (size_t arrIdx = 0; arrIdx < arrays.size(); ++arrIdx)
+		{
+			const ArrayRef& arr        = blocks_[blockIdx].arrays[arrIdx];
+			const uint64_t  bytesCount = arr.count * arr.elemSize;
+
+			WritePadding(arrays[arrIdx].pos);
+			fout.write((const char*)arr.pData, (std::streamsize)bytesCount);
+			currPos += bytesCount;
+		}
+	}
+
+	Assert::True(fout.good() && (currPos == header.fileSize), "can't write data into the file: " + dataFilepath);
+	fout.close();
+}
+
+}
@@ -1,8 +1,9 @@
 // ********************************************************************************
 // Filename:     EntityManagerSerializer.h
 // Description:  contains functional for serialization of the EntityManager data
-//               as well as the components
-// 
+//               as well as the components into the scene file
+//               (see SerializationHelperTypes.h for the layout of the file)
+//
 // Created:      26.06.24
 // ********************************************************************************
 #pragma once
@@ -10,6 +11,10 @@
 #include "EntityManager.h"
 #include "SerializationHelperTypes.h"
 
+#include <string>
+#include <vector>
+#include <unordered_map>
+
 namespace ECS
 {
 
@@ -23,13 +28,52 @@ public:
 		const std::string& dataFilepath);
 
 private:
-	void WriteDataHeader(
-		std::ofstream& fout,
-		SerializedDataHeader& header);
+	// a reference to the data of an array which will be written into the file
+	struct ArrayRef
+	{
+		const void* pData = nullptr;
+		uint64_t    count = 0;
+		u32         elemSize = 0;
+	};
+
+	struct Block
+	{
+		template <typename T>
+		void Add(const std::vector<T>& arr)
+		{
+			arrays.push_back({ arr.data(), (uint64_t)arr.size(), (u32)sizeof(T) });
+		}
+
+		SceneBlockType        type;
+		std::vector<ArrayRef> arrays;
+	};
+
+	Block& AddBlock(const SceneBlockType type);
+	u32    AddString(const std::string& str);
+
+	void AddBlocksOfComponents(EntityManager& entityMgr);
+	void AddBlockOfTextured(const Textured& comp);
+	void AddBlockOfTexTransform(const TextureTransform& comp);
+	void AddBlockOfLight(const Light& comp);
+	void AddLightAnimations(Block& block, const LightAnimations& anims);
+
+	void WriteFile(const std::string& dataFilepath);
+
+private:
+	std::vector<Block> blocks_;
 
-	void SerializeDataOfEnttMgr(
-		std::ofstream& fout,
-		EntityManager& entityMgr);
+	// the string table (each unique string is stored only once)
+	std::vector<u32>   strOffsets_ = { 0 };
+	std::vector<char>  strChars_;
+	std::unordered_map<std::string, u32> strToIdx_;
+
+	// data which is converted from the components data before writing
+	// (must be alive until the file is written)
+	std::vector<u32>   namesIdxs_;            // idxs of names in the string table
+	std::vector<u32>   texIDsOffsets_;        // Textured: offsets of arrays of textures IDs (count + 1)
+	std::vector<TexID> texIDs_;
+	std::vector<u32>   texPathsOffsets_;      // Textured: offsets of arrays of textures paths (count + 1)
+	std::vector<u32>   texPathsIdxs_;         // idxs of textures paths in the string table
 };
 
-};
\ No newline at end of file
+};
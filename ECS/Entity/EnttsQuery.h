@@ -0,0 +1,61 @@
+// *********************************************************************************
+// Filename:     EnttsQuery.h
+// Description:  a cached query of entities which have a particular set of
+//               components (for instance: Transform + Movement);
+//
+//               the query stores IDs of matched entities and for each queried
+//               component an arr of data idxs into the dense arrays of this
+//               component, so per-frame systems can iterate over components data
+//               without any searches; queries are cached by the EntityManager
+//               and rebuilt only after a structural change (creation/destruction
+//               of entities or adding of components);
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "../Common/Types.h"
+#include "../Common/SparseSet.h"
+#include "../Common/LIB_Exception.h"
+
+#include <vector>
+#include <string>
+
+namespace ECS
+{
+
+struct EnttsQuery
+{
+	inline size Count() const { return std::ssize(ids_); }
+
+	// ----------------------------------------------------
+
+	const std::vector<ptrdiff_t>& GetDataIdxs(const ComponentType type) const
+	{
+		// return: arr of data idxs into the dense arrays of the component by type
+		//         (this arr is parallel to ids_)
+		//
+		// NOTE: there are no data idxs for components without dense
+		//       storage (for instance: the Mesh component)
+
+		for (size i = 0; i < std::ssize(types_); ++i)
+		{
+			if (types_[i] == type)
+				return dataIdxs_[i];
+		}
+
+		throw LIB_Exception("there are no data idxs for the component type: " + std::to_string(type));
+	}
+
+	// ----------------------------------------------------
+
+	ComponentsHash                      hash_ = 0;               // bitmask of queried components
+	u32                                 version_ = UINT32_MAX;   // structural version of the entity mgr when the query was built
+
+	std::vector<EntityID>               ids_;                    // IDs of entities which have all the queried components
+	std::vector<ComponentType>          types_;                  // types of queried components which have dense storage
+	std::vector<std::vector<ptrdiff_t>> dataIdxs_;               // for each type: data idxs of entities into the component
+	SparseSet                           sparse_;                 // entity ID => idx into ids_
+};
+
+} // namespace ECS
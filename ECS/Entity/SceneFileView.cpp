@@ -0,0 +1,133 @@
+// ********************************************************************************
+// Filename:     SceneFileView.cpp
+// Description:  implementation of the SceneFileView
+//
+// Created:      17.10.26
+// ********************************************************************************
+#include "SceneFileView.h"
+
+namespace ECS
+{
+
+void SceneFileView::Open(const std::string& filepath)
+{
+	Close();
+
+	file_.Open(filepath);
+	ValidateLayout(filepath);
+
+	// setup the string table
+	SceneBlockReader strings = GetBlock(SCENE_BLOCK_STRINGS);
+
+	if (!strings.IsEmpty())
+	{
+		strOffsets_ = strings.Next<u32>();
+		strChars_   = strings.Next<char>();
+
+		Assert::True(!strOffsets_.empty() && (strOffsets_[0] == 0), "scene file: wrong string table: " + filepath);
+
+		for (size_t i = 1; i < strOffsets_.size(); ++i)
+		{
+			const bool isValidStr = (strOffsets_[i - 1] <= strOffsets_[i]) && (strOffsets_[i] <= strChars_.size());
+
+			if (!isValidStr)
+				throw LIB_Exception("scene file: wrong string table: " + filepath);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void SceneFileView::Close()
+{
+	file_.Close();
+
+	for (const SceneBlockDesc*& pBlock : blocks_)
+		pBlock = nullptr;
+
+	strOffsets_ = {};
+	strChars_   = {};
+}
+
+///////////////////////////////////////////////////////////
+
+SceneBlockReader SceneFileView::GetBlock(const SceneBlockType type) const
+{
+	const SceneBlockDesc* pBlock = blocks_[type];
+
+	if (!pBlock)
+		return SceneBlockReader();
+
+	const uint8_t* pData = file_.GetData();
+	return SceneBlockReader(pData, (const SceneArrayDesc*)(pData + pBlock->arraysTablePos), pBlock->arraysCount);
+}
+
+///////////////////////////////////////////////////////////
+
+void SceneFileView::ValidateLayout(const std::string& filepath)
+{
+	// check that the header, the table of blocks and all the arrays are
+	// inside the file and properly aligned so later we can access them
+	// without any checking
+
+	const uint8_t* pData    = file_.GetData();
+	const uint64_t fileSize = file_.GetSize();
+
+	Assert::True(fileSize >= sizeof(SceneFileHeader), "scene file: the file is too small: " + filepath);
+
+	const SceneFileHeader& header = *(const SceneFileHeader*)pData;
+
+	Assert::True(header.magic != LEGACY_SCENE_FILE_BLOCKS_COUNT, "scene file: the legacy format isn't supported anymore (the scene must be re-saved): " + filepath);
+	Assert::True(header.magic == SCENE_FILE_MAGIC, "scene file: it isn't a scene file: " + filepath);
+	Assert::True(header.version == SCENE_FILE_VERSION, "scene file: unsupported version (" + std::to_string(header.version) + "): " + filepath);
+	Assert::True(header.alignment == SCENE_FILE_ALIGNMENT, "scene file: wrong alignment: " + filepath);
+	Assert::True(header.fileSize == fileSize, "scene file: the file is truncated: " + filepath);
+
+	const uint64_t blocksTableSize = (uint64_t)header.blocksCount * sizeof(SceneBlockDesc);
+	const bool isBlocksTableValid =
+		(header.blocksTablePos % alignof(SceneBlockDesc) == 0) &&
+		(header.blocksTablePos <= fileSize) &&
+		(blocksTableSize <= fileSize - header.blocksTablePos);
+
+	Assert::True(isBlocksTableValid, "scene file: wrong table of blocks: " + filepath);
+
+	const SceneBlockDesc* blocks = (const SceneBlockDesc*)(pData + header.blocksTablePos);
+
+	for (u32 blockIdx = 0; blockIdx < header.blocksCount; ++blockIdx)
+	{
+		const SceneBlockDesc& block = blocks[blockIdx];
+
+		// skip blocks which are unknown for this version
+		if (block.type >= NUM_SCENE_BLOCKS)
+			continue;
+
+		Assert::True(blocks_[block.type] == nullptr, "scene file: duplicated block (type: " + std::to_string(block.type) + "): " + filepath);
+
+		const uint64_t arraysTableSize = (uint64_t)block.arraysCount * sizeof(SceneArrayDesc);
+		const bool isArraysTableValid =
+			(block.arraysTablePos % alignof(SceneArrayDesc) == 0) &&
+			(block.arraysTablePos <= fileSize) &&
+			(arraysTableSize <= fileSize - block.arraysTablePos);
+
+		Assert::True(isArraysTableValid, "scene file: wrong table of arrays (block type: " + std::to_string(block.type) + "): " + filepath);
+
+		const SceneArrayDesc* arrays = (const SceneArrayDesc*)(pData + block.arraysTablePos);
+
+		for (u32 arrIdx = 0; arrIdx < block.arraysCount; ++arrIdx)
+		{
+			const SceneArrayDesc& arr = arrays[arrIdx];
+
+			const bool isArrValid =
+				(arr.pos % SCENE_FILE_ALIGNMENT == 0) &&
+				(arr.elemSize > 0) &&
+				(arr.pos <= fileSize) &&
+				(arr.count <= (fileSize - arr.pos) / arr.elemSize);
+
+			Assert::True(isArrValid, "scene file: wrong array (block type: " + std::to_string(block.type) + "): " + filepath);
+		}
+
+		blocks_[block.type] = &block;
+	}
+}
+
+} // namespace ECS
@@ -0,0 +1,112 @@
+// ********************************************************************************
+// Filename:     SceneFileView.h
+// Description:  a read-only view of the scene file which is mapped into memory;
+//
+//               the layout of the file is validated once when it is opened, then
+//               arrays of blocks are returned as spans right into the mapping
+//               (without any copying or parsing); strings are returned as
+//               string views into the string table;
+//
+// Created:      17.10.26
+// ********************************************************************************
+#pragma once
+
+#include "SerializationHelperTypes.h"
+#include "../Common/MappedFile.h"
+#include "../Common/Assert.h"
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ECS
+{
+
+class SceneBlockReader
+{
+public:
+	SceneBlockReader() {}
+
+	SceneBlockReader(
+		const uint8_t* pFileData,
+		const SceneArrayDesc* pArrays,
+		const u32 arraysCount) :
+		pFileData_(pFileData),
+		pArrays_(pArrays),
+		arraysCount_(arraysCount) {}
+
+	// return a view of the next array of the block (without copying);
+	// if there is no such block in the file an empty array is returned
+	template <typename T>
+	std::span<const T> Next()
+	{
+		if (arraysCount_ == 0)
+			return {};
+
+		Assert::True(currArrIdx_ < arraysCount_, "scene file: there is no more arrays in the block");
+
+		const SceneArrayDesc& arr = pArrays_[currArrIdx_++];
+		Assert::True(arr.elemSize == sizeof(T), "scene file: the size of array elements doesn't match the type");
+
+		return { (const T*)(pFileData_ + arr.pos), (size_t)arr.count };
+	}
+
+	// copy the next array into the container
+	template <typename T>
+	void Next(std::vector<T>& outArr)
+	{
+		const std::span<const T> arr = Next<T>();
+		outArr.assign(arr.begin(), arr.end());
+	}
+
+	inline bool IsEmpty() const { return arraysCount_ == 0; }
+
+private:
+	const uint8_t*        pFileData_ = nullptr;
+	const SceneArrayDesc* pArrays_ = nullptr;
+	u32                   arraysCount_ = 0;
+	u32                   currArrIdx_ = 0;
+};
+
+///////////////////////////////////////////////////////////
+
+class SceneFileView final
+{
+public:
+	SceneFileView() {}
+
+	// map the file and validate its layout (throw LIB_Exception if it's invalid)
+	void Open(const std::string& filepath);
+	void Close();
+
+	// return a reader of arrays of the block (an empty reader if there is no such block)
+	SceneBlockReader GetBlock(const SceneBlockType type) const;
+
+	inline u32 GetStringsCount() const
+	{
+		return strOffsets_.empty() ? 0 : (u32)(strOffsets_.size() - 1);
+	}
+
+	inline std::string_view GetString(const u32 idx) const
+	{
+		if (idx >= GetStringsCount())
+			throw LIB_Exception("scene file: wrong idx of string: " + std::to_string(idx));
+
+		return { strChars_.data() + strOffsets_[idx], strOffsets_[idx + 1] - strOffsets_[idx] };
+	}
+
+	inline uint64_t GetFileSize() const { return file_.GetSize(); }
+
+private:
+	void ValidateLayout(const std::string& filepath);
+
+private:
+	MappedFile            file_;
+	const SceneBlockDesc* blocks_[NUM_SCENE_BLOCKS] = { nullptr };   // block type => block description
+
+	std::span<const u32>  strOffsets_;         // string idx => offset of the string in chars (count + 1 values)
+	std::span<const char> strChars_;
+};
+
+} // namespace ECS
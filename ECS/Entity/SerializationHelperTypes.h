@@ -1,22 +1,128 @@
+// ********************************************************************************
+// Filename:     SerializationHelperTypes.h
+// Description:  layout of the binary scene file (serialized data of the EntityManager
+//               and all the components);
+//
+//               [header][table of blocks][block 0][block 1]...
+//
+//               each block contains data of a single component (or of the EntityManager,
+//               or the string table) and consists of a table of arrays and arrays
+//               themselves; each array is a plain copy of a POD array of the component
+//               and starts at an offset which is a multiple of SCENE_FILE_ALIGNMENT
+//               so when the file is mapped into memory arrays can be used right in place;
+//
+//               strings (names, texture paths) are stored into the string table block
+//               and are referenced by u32 idxs; arrays of a block go in fixed order
+//               which is defined by the version of the format;
+//
+// Created:      26.06.24
+// ********************************************************************************
 #pragma once
 
-#include <vector>
+#include "../Common/Types.h"
 
+namespace ECS
+{
+
+constexpr u32 SCENE_FILE_MAGIC     = 0x53443345;  // "E3DS" (in little-endian)
+constexpr u32 SCENE_FILE_VERSION   = 2;           // is increased after each change of the layout
+constexpr u32 SCENE_FILE_ALIGNMENT = 64;          // alignment of each array in the file (a cache line)
+
+// the legacy format (before IDs were packed as [generation | index]) starts with
+// the number of its data blocks instead of the magic; its IDs can't be converted
+constexpr u32 LEGACY_SCENE_FILE_BLOCKS_COUNT = 17;
+
+///////////////////////////////////////////////////////////
+
+enum SceneBlockType : u32
+{
+	SCENE_BLOCK_ENTT_MGR,              // IDs of entities, their components hashes and generations of IDs indices
+	SCENE_BLOCK_STRINGS,               // the string table
+	SCENE_BLOCK_TRANSFORM,
+	SCENE_BLOCK_WORLD_MATRIX,
+	SCENE_BLOCK_MOVEMENT,
+	SCENE_BLOCK_NAME,
+	SCENE_BLOCK_MESH,
+	SCENE_BLOCK_RENDERED,
+	SCENE_BLOCK_TEXTURED,
+	SCENE_BLOCK_TEX_TRANSFORM,
+	SCENE_BLOCK_LIGHT,
+	SCENE_BLOCK_RENDER_STATES,
+	SCENE_BLOCK_BOUNDING,
 
-struct SerializedDataHeaderRecord
+	NUM_SCENE_BLOCKS,
+};
+
+///////////////////////////////////////////////////////////
+
+struct SceneFileHeader
 {
-	u32 dataBlockMarker = 0;   // KEY:   markers for data blocks
-	u32 dataBlockPos = 0;      // VALUE: positions of each data block in the file
+	u32      magic       = SCENE_FILE_MAGIC;
+	u32      version     = SCENE_FILE_VERSION;
+	u32      alignment   = SCENE_FILE_ALIGNMENT;
+	u32      blocksCount = 0;
+	uint64_t fileSize    = 0;          // is used to check if the file isn't truncated
+	uint64_t blocksTablePos = 0;       // position of the table of blocks in the file
 };
 
-struct SerializedDataHeader
+struct SceneBlockDesc
 {
-	u32 recordsCount = 0;
+	u32      type        = 0;          // SceneBlockType
+	u32      arraysCount = 0;
+	uint64_t arraysTablePos = 0;       // position of the table of arrays of the block in the file
+	uint64_t size        = 0;          // size of the whole block (the table of arrays and data of arrays)
+};
 
-	std::vector<SerializedDataHeaderRecord> records;
+struct SceneArrayDesc
+{
+	uint64_t pos         = 0;          // position of the array data in the file
+	uint64_t count       = 0;          // number of elements
+	u32      elemSize    = 0;          // size of a single element (is used to check the layout of types)
+	u32      pad         = 0;
+};
 
-	u32& GetDataBlockPos(const u32 idx)
+///////////////////////////////////////////////////////////
+
+inline uint64_t AlignScenePos(const uint64_t pos)
+{
+	return (pos + SCENE_FILE_ALIGNMENT - 1) & ~(uint64_t)(SCENE_FILE_ALIGNMENT - 1);
+}
+
+///////////////////////////////////////////////////////////
+
+inline const char* GetSceneBlockName(const SceneBlockType type)
+{
+	constexpr const char* names[NUM_SCENE_BLOCKS] =
 	{
-		return records[idx].dataBlockPos;
-	}
-};
\ No newline at end of file
+		"EntityManager",
+		"Strings",
+		"Transform",
+		"WorldMatrix",
+		"Movement",
+		"Name",
+		"MeshComponent",
+		"Rendered",
+		"Textured",
+		"TextureTransform",
+		"Light",
+		"RenderStates",
+		"Bounding",
+	};
+
+	return (type < NUM_SCENE_BLOCKS) ? names[type] : "Unknown";
+}
+
+///////////////////////////////////////////////////////////
+
+// time (in ms) which was spent on the last loading of a scene file;
+// blocks are decoded in parallel so the sum of blocksMs can be bigger than decodeMs
+struct SceneLoadTimings
+{
+	float openMs       = 0;                        // mapping of the file + checking of its layout and the string table
+	float blocksMs[NUM_SCENE_BLOCKS] = { 0 };      // decoding of each block (by a single task)
+	float decodeMs     = 0;                        // decoding of all the blocks
+	float validationMs = 0;                        // checking of IDs of components against components hashes of entities
+	float totalMs      = 0;
+};
+
+} // namespace ECS
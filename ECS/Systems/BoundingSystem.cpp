@@ -23,18 +23,26 @@ void BoundingSystem::Add(
 	Bounding& component = *pBoundingComponent_;
 
 	// check if we can add each input entt ID
-	bool canAddComponent = !Utils::CheckValuesExistInSortedArr(component.ids_, ids);
+	bool canAddComponent = !component.sparse_.HasAny(ids);
 	Assert::True(canAddComponent, "can't add component: there is already a record with some entity id");
 
-	// execute sorted insertion of the data
-	for (size idx = 0; idx < std::ssize(ids); ++idx)
-	{
-		const ptrdiff_t insertAt = Utils::GetPosForID(component.ids_, ids[idx]);
+	// append the data to the end of the data arrays
+	component.sparse_.Add(ids, std::ssize(component.ids_));
 
-		Utils::InsertAtPos(component.ids_, insertAt, ids[idx]);
-		Utils::InsertAtPos(component.data_, insertAt, data[idx]);
-		Utils::InsertAtPos(component.types_, insertAt, types[idx]);
-	}
+	Utils::AppendArray(component.ids_, ids);
+	Utils::AppendArray(component.data_, data);
+	Utils::AppendArray(component.types_, types);
+}
+
+///////////////////////////////////////////////////////////
+
+void BoundingSystem::Remove(const std::vector<EntityID>& ids)
+{
+	// remove bounding data of input entities;
+	// (IDs of entities which don't have this component are skipped)
+
+	Bounding& component = *pBoundingComponent_;
+	component.sparse_.SwapAndPop(ids, component.ids_, component.types_, component.data_);
 }
 
 ///////////////////////////////////////////////////////////
@@ -43,12 +51,10 @@ DirectX::BoundingBox BoundingSystem::GetBoundingDataByID(const EntityID id)
 {
 	const Bounding& component = *pBoundingComponent_;
 
-	// if entt by input ID doesn't have AABB we just return the default one
-	if (!Utils::BinarySearch(component.ids_, id))
-		return DirectX::BoundingBox();
+	const ptrdiff_t idx = component.sparse_.GetIdx(id);
 
-	ptrdiff_t idx = Utils::GetIdxInSortedArr(component.ids_, id);
-	return component.data_[idx];
+	// if entt by input ID doesn't have AABB we just return the default one
+	return (idx != -1) ? component.data_[idx] : DirectX::BoundingBox();
 }
 
 ///////////////////////////////////////////////////////////
@@ -60,18 +66,16 @@ void BoundingSystem::GetBoundingDataByIDs(
 	// get an arr of AABB data by input entts IDs
 
 	const Bounding& component = *pBoundingComponent_;
-	std::vector<bool> flags;
 	std::vector<ptrdiff_t> idxs;
 
-	Utils::GetExistingFlags(component.ids_, ids, flags);
-	Utils::GetIdxsInSortedArr(component.ids_, ids, idxs);
+	component.sparse_.GetIdxs(ids, idxs);
 
 	const size enttsCount = std::ssize(ids);
 	outData.reserve(enttsCount);
 
 	// if entt by i has an AABB we get it from the component or set default AABB in another case
 	for (size i = 0; i < enttsCount; ++i)
-		outData.emplace_back((flags[i]) ? component.data_[idxs[i]] : DirectX::BoundingBox());
+		outData.emplace_back((idxs[i] != -1) ? component.data_[idxs[i]] : DirectX::BoundingBox());
 }
 
 
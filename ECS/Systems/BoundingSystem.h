@@ -22,6 +22,8 @@ public:
 		const std::vector<DirectX::BoundingBox>& data,
 		const std::vector<BoundingType>& types);
 
+	void Remove(const std::vector<EntityID>& ids);
+
 	DirectX::BoundingBox GetBoundingDataByID(const EntityID id);
 
 	void GetBoundingDataByIDs(
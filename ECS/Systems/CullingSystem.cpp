@@ -0,0 +1,429 @@
+// *********************************************************************************
+// Filename:     CullingSystem.cpp
+// Description:  implementation of the ECS system for frustum culling of entities
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "CullingSystem.h"
+#include "Helpers/SimdHelpers.h"
+#include "../Common/Assert.h"
+
+#include <cstring>
+
+using namespace DirectX;
+
+namespace ECS
+{
+
+// for each frustum plane we store 7 replicated vectors: nx, ny, nz, d, |nx|, |ny|, |nz|
+static constexpr u32 PLANES_COUNT = 6;
+static constexpr u32 PLANE_VECS_COUNT = 7;
+
+
+CullingSystem::CullingSystem(
+	Bounding* pBoundingComponent,
+	WorldMatrix* pWorldMatComponent)
+{
+	Assert::NotNullptr(pBoundingComponent, "ptr to the bounding component == nullptr");
+	Assert::NotNullptr(pWorldMatComponent, "ptr to the world matrix component == nullptr");
+
+	pBoundingComponent_ = pBoundingComponent;
+	pWorldMatComponent_ = pWorldMatComponent;
+}
+
+
+// *********************************************************************************
+//                                PUBLIC API
+// *********************************************************************************
+
+void CullingSystem::RebuildWorldBoxes(
+	const std::vector<EntityID>& ids,
+	ThreadPool& pool)
+{
+	// set entities to cull and compute world AABB for each of them;
+	// is called after structural changes (entities/components were added or removed)
+	//
+	// NOTE: if an entity doesn't have the Bounding component we use a default box
+
+	const size boxesCount = std::ssize(ids);
+	const size paddedCount = (boxesCount + 3) & ~3;
+
+	ids_ = ids;
+	sparse_.Rebuild(ids_);
+
+	pWorldMatComponent_->sparse_.GetIdxs(ids_, worldIdxs_);
+	pBoundingComponent_->sparse_.GetIdxs(ids_, boundingIdxs_);
+
+	// padding boxes have zero extents in the origin; results of
+	// their tests are ignored because there are no entities for them
+	centersX_.assign(paddedCount, 0.0f);
+	centersY_.assign(paddedCount, 0.0f);
+	centersZ_.assign(paddedCount, 0.0f);
+	extentsX_.assign(paddedCount, 0.0f);
+	extentsY_.assign(paddedCount, 0.0f);
+	extentsZ_.assign(paddedCount, 0.0f);
+
+	pool.ParallelFor(boxesCount, CHUNK_SIZE, [this](const size begin, const size end)
+	{
+		for (size i = begin; i < end; ++i)
+			ComputeWorldBox(i);
+	});
+
+	if (isBVHEnabled_)
+		BuildBVH();
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::UpdateWorldBoxes(
+	const std::vector<EntityID>& ids,
+	ThreadPool& pool)
+{
+	// recompute world AABBs only of input entities (IDs which aren't culled are skipped)
+
+	pool.ParallelFor(std::ssize(ids), CHUNK_SIZE, [this, &ids](const size begin, const size end)
+	{
+		for (size i = begin; i < end; ++i)
+		{
+			const ptrdiff_t boxIdx = sparse_.GetIdx(ids[i]);
+
+			if (boxIdx != -1)
+				ComputeWorldBox(boxIdx);
+		}
+	});
+
+	if (!isBVHEnabled_)
+		return;
+
+	// refit the BVH for changed boxes; if the tree became too bad we rebuild it
+	for (const EntityID id : ids)
+	{
+		const ptrdiff_t boxIdx = sparse_.GetIdx(id);
+
+		if (boxIdx != -1)
+			bvh_.UpdateItem((u32)boxIdx, GetWorldBox(boxIdx));
+	}
+
+	if (bvh_.NeedsRebuild())
+		BuildBVH();
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::CullByFrustum(
+	const XMMATRIX& viewProj,
+	ThreadPool& pool,
+	std::vector<EntityID>& outVisibleIDs)
+{
+	// test world AABBs against the frustum which is defined by the view * projection matrix;
+	// out: IDs of entities which are (maybe partially) inside the frustum
+	//
+	// NOTE: the output arr is reused from frame to frame so there are
+	//       no heap allocations if its capacity is big enough
+
+	const size boxesCount = std::ssize(ids_);
+	outVisibleIDs.resize(boxesCount);
+
+	if (boxesCount == 0)
+		return;
+
+	XMVECTOR frustumPlanes[PLANES_COUNT];
+	ComputeFrustumPlanes(viewProj, frustumPlanes);
+
+	// replicate components of each plane so we can test 4 boxes at once
+	XMVECTOR planes[PLANES_COUNT * PLANE_VECS_COUNT];
+
+	for (u32 i = 0; i < PLANES_COUNT; ++i)
+	{
+		const XMVECTOR plane = frustumPlanes[i];
+		const XMVECTOR absPlane = XMVectorAbs(plane);
+		XMVECTOR* p = planes + i * PLANE_VECS_COUNT;
+
+		p[0] = XMVectorSplatX(plane);
+		p[1] = XMVectorSplatY(plane);
+		p[2] = XMVectorSplatZ(plane);
+		p[3] = XMVectorSplatW(plane);
+		p[4] = XMVectorSplatX(absPlane);
+		p[5] = XMVectorSplatY(absPlane);
+		p[6] = XMVectorSplatZ(absPlane);
+	}
+
+	// each chunk writes IDs of its visible entts starting from the beginning of its own range
+	chunksVisibleCounts_.assign((boxesCount + CHUNK_SIZE - 1) / CHUNK_SIZE, 0);
+	EntityID* visibleIDs = outVisibleIDs.data();
+
+	pool.ParallelFor(boxesCount, CHUNK_SIZE, [this, &planes, visibleIDs](const size begin, const size end)
+	{
+		const EntityID* ids = ids_.data();
+		u32 visibleCount = 0;
+
+		for (size i = begin; i < end; i += 4)
+		{
+			u32 visibleMask = TestBoxesAgainstFrustum(i, planes);
+
+			// skip results of the padding boxes
+			if (end - i < 4)
+				visibleMask &= (1u << (end - i)) - 1;
+
+			for (u32 bit = 0; visibleMask; ++bit, visibleMask >>= 1)
+			{
+				if (visibleMask & 1)
+					visibleIDs[begin + visibleCount++] = ids[i + bit];
+			}
+		}
+
+		chunksVisibleCounts_[begin / CHUNK_SIZE] = visibleCount;
+	});
+
+	// pack results of chunks one after another (in order of chunks so the result is deterministic)
+	size visibleCount = chunksVisibleCounts_[0];
+
+	for (size chunkIdx = 1; chunkIdx < std::ssize(chunksVisibleCounts_); ++chunkIdx)
+	{
+		const u32 count = chunksVisibleCounts_[chunkIdx];
+		std::memmove(visibleIDs + visibleCount, visibleIDs + chunkIdx * CHUNK_SIZE, count * sizeof(EntityID));
+		visibleCount += count;
+	}
+
+	outVisibleIDs.resize(visibleCount);
+}
+
+
+
+// *********************************************************************************
+//                                  BVH API
+// *********************************************************************************
+
+void CullingSystem::EnableBVH(const bool isEnabled)
+{
+	// turn on/off maintaining of the BVH over world boxes
+
+	isBVHEnabled_ = isEnabled;
+
+	if (isEnabled)
+		BuildBVH();
+	else
+		bvh_.Clear();
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::CullByFrustumBVH(
+	const XMMATRIX& viewProj,
+	std::vector<EntityID>& outVisibleIDs) const
+{
+	// the same as CullByFrustum() but subtrees of the BVH which are
+	// completely outside (or inside) of the frustum are culled at once
+
+	Assert::True(isBVHEnabled_, "the BVH is disabled");
+
+	XMVECTOR planes[PLANES_COUNT];
+	ComputeFrustumPlanes(viewProj, planes);
+
+	bvh_.QueryFrustum(planes, outVisibleIDs);
+}
+
+///////////////////////////////////////////////////////////
+
+bool CullingSystem::RayCast(
+	const XMVECTOR& origin,
+	const XMVECTOR& dir,
+	EntityID& outID,
+	float& outDist) const
+{
+	// find the nearest entity whose world box is intersected by the ray (for picking)
+
+	Assert::True(isBVHEnabled_, "the BVH is disabled");
+	return bvh_.RayCast(origin, dir, outID, outDist);
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::QuerySphere(
+	const DirectX::BoundingSphere& sphere,
+	std::vector<EntityID>& outIDs) const
+{
+	// out: IDs of entities whose world boxes overlap the sphere
+
+	if (isBVHEnabled_)
+	{
+		bvh_.QuerySphere(sphere, outIDs);
+		return;
+	}
+
+	// without the BVH we test 4 boxes at once against the sphere: a box overlaps
+	// if the squared distance from the sphere center to its closest point <= radius^2
+	outIDs.clear();
+
+	const size boxesCount = std::ssize(ids_);
+
+	const XMVECTOR sphereX  = XMVectorReplicate(sphere.Center.x);
+	const XMVECTOR sphereY  = XMVectorReplicate(sphere.Center.y);
+	const XMVECTOR sphereZ  = XMVectorReplicate(sphere.Center.z);
+	const XMVECTOR radiusSq = XMVectorReplicate(sphere.Radius * sphere.Radius);
+
+	for (size i = 0; i < boxesCount; i += 4)
+	{
+		const XMVECTOR dx = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(XMLoadFloat4((const XMFLOAT4*)&centersX_[i]), sphereX)), XMLoadFloat4((const XMFLOAT4*)&extentsX_[i])), g_XMZero);
+		const XMVECTOR dy = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(XMLoadFloat4((const XMFLOAT4*)&centersY_[i]), sphereY)), XMLoadFloat4((const XMFLOAT4*)&extentsY_[i])), g_XMZero);
+		const XMVECTOR dz = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(XMLoadFloat4((const XMFLOAT4*)&centersZ_[i]), sphereZ)), XMLoadFloat4((const XMFLOAT4*)&extentsZ_[i])), g_XMZero);
+
+		const XMVECTOR distSq = XMVectorAdd(XMVectorAdd(XMVectorMultiply(dx, dx), XMVectorMultiply(dy, dy)), XMVectorMultiply(dz, dz));
+		u32 mask = GetMask(XMVectorLessOrEqual(distSq, radiusSq));
+
+		// skip results of the padding boxes
+		if (boxesCount - i < 4)
+			mask &= (1u << (boxesCount - i)) - 1;
+
+		for (u32 bit = 0; mask; ++bit, mask >>= 1)
+		{
+			if (mask & 1)
+				outIDs.push_back(ids_[i + bit]);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::QueryBox(
+	const DirectX::BoundingBox& box,
+	std::vector<EntityID>& outIDs) const
+{
+	Assert::True(isBVHEnabled_, "the BVH is disabled");
+	bvh_.QueryBox(box, outIDs);
+}
+
+
+///////////////////////////////////////////////////////////
+
+bool CullingSystem::GetWorldBoxByID(const EntityID id, DirectX::BoundingBox& outBox) const
+{
+	const ptrdiff_t boxIdx = sparse_.GetIdx(id);
+
+	if (boxIdx == -1)
+		return false;
+
+	outBox = GetWorldBox(boxIdx);
+	return true;
+}
+
+
+// *********************************************************************************
+//                                PRIVATE HELPERS
+// *********************************************************************************
+
+void CullingSystem::BuildBVH()
+{
+	// build the BVH over all the current world boxes
+
+	const size boxesCount = std::ssize(ids_);
+	std::vector<DirectX::BoundingBox> boxes(boxesCount);
+
+	for (size i = 0; i < boxesCount; ++i)
+		boxes[i] = GetWorldBox(i);
+
+	bvh_.Build(ids_, boxes);
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::ComputeWorldBox(const size boxIdx)
+{
+	// transform a local AABB of the entity by its world matrix and
+	// compute a new AABB which encloses the transformed box
+
+	static const DirectX::BoundingBox defaultBox;
+
+	const ptrdiff_t worldIdx = worldIdxs_[boxIdx];
+	const ptrdiff_t boundIdx = boundingIdxs_[boxIdx];
+
+	const DirectX::BoundingBox& localBox = (boundIdx != -1) ? pBoundingComponent_->data_[boundIdx] : defaultBox;
+	const XMMATRIX world = (worldIdx != -1) ? pWorldMatComponent_->worlds_[worldIdx] : XMMatrixIdentity();
+
+	const XMVECTOR center  = XMVector3Transform(XMLoadFloat3(&localBox.Center), world);
+	const XMVECTOR extents = XMLoadFloat3(&localBox.Extents);
+
+	// extents of the world box: |world| * extents (only the rotation/scale part of the matrix)
+	XMVECTOR worldExtents = XMVectorMultiply(XMVectorAbs(world.r[0]), XMVectorSplatX(extents));
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[1]), XMVectorSplatY(extents), worldExtents);
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[2]), XMVectorSplatZ(extents), worldExtents);
+
+	centersX_[boxIdx] = XMVectorGetX(center);
+	centersY_[boxIdx] = XMVectorGetY(center);
+	centersZ_[boxIdx] = XMVectorGetZ(center);
+	extentsX_[boxIdx] = XMVectorGetX(worldExtents);
+	extentsY_[boxIdx] = XMVectorGetY(worldExtents);
+	extentsZ_[boxIdx] = XMVectorGetZ(worldExtents);
+}
+
+///////////////////////////////////////////////////////////
+
+DirectX::BoundingBox CullingSystem::GetWorldBox(const size boxIdx) const
+{
+	return DirectX::BoundingBox(
+		{ centersX_[boxIdx], centersY_[boxIdx], centersZ_[boxIdx] },
+		{ extentsX_[boxIdx], extentsY_[boxIdx], extentsZ_[boxIdx] });
+}
+
+///////////////////////////////////////////////////////////
+
+void CullingSystem::ComputeFrustumPlanes(const XMMATRIX& viewProj, XMVECTOR* outPlanes)
+{
+	// extract normalized frustum planes in world space from the view * projection matrix
+	// (row-vector convention, the depth of clip space is in range [0, w]);
+	// normals of planes point inside the frustum
+
+	const XMMATRIX m = XMMatrixTranspose(viewProj);
+
+	outPlanes[0] = XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[0]));         // left
+	outPlanes[1] = XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[0]));    // right
+	outPlanes[2] = XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[1]));         // bottom
+	outPlanes[3] = XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[1]));    // top
+	outPlanes[4] = XMPlaneNormalize(m.r[2]);                              // near
+	outPlanes[5] = XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[2]));    // far
+}
+
+///////////////////////////////////////////////////////////
+
+u32 CullingSystem::TestBoxesAgainstFrustum(const size boxIdx, const XMVECTOR* planes) const
+{
+	// test 4 boxes starting from boxIdx against 6 frustum planes;
+	// a box is outside if it is completely behind at least one plane:
+	// dot(n, center) + d + dot(|n|, extents) < 0
+	//
+	// return: 4-bit mask of visible boxes
+
+	const XMVECTOR cx = XMLoadFloat4((const XMFLOAT4*)&centersX_[boxIdx]);
+	const XMVECTOR cy = XMLoadFloat4((const XMFLOAT4*)&centersY_[boxIdx]);
+	const XMVECTOR cz = XMLoadFloat4((const XMFLOAT4*)&centersZ_[boxIdx]);
+	const XMVECTOR ex = XMLoadFloat4((const XMFLOAT4*)&extentsX_[boxIdx]);
+	const XMVECTOR ey = XMLoadFloat4((const XMFLOAT4*)&extentsY_[boxIdx]);
+	const XMVECTOR ez = XMLoadFloat4((const XMFLOAT4*)&extentsZ_[boxIdx]);
+
+	XMVECTOR outside = XMVectorFalseInt();
+
+	for (u32 i = 0; i < PLANES_COUNT; ++i)
+	{
+		const XMVECTOR* p = planes + i * PLANE_VECS_COUNT;
+
+		XMVECTOR dist = XMVectorMultiplyAdd(p[0], cx, p[3]);
+		dist = XMVectorMultiplyAdd(p[1], cy, dist);
+		dist = XMVectorMultiplyAdd(p[2], cz, dist);
+
+		XMVECTOR radius = XMVectorMultiply(p[4], ex);
+		radius = XMVectorMultiplyAdd(p[5], ey, radius);
+		radius = XMVectorMultiplyAdd(p[6], ez, radius);
+
+		outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(dist, radius), g_XMZero));
+	}
+
+	XMUINT4 outsideFlags;
+	XMStoreUInt4(&outsideFlags, outside);
+
+	return (outsideFlags.x ? 0 : 1) |
+		   (outsideFlags.y ? 0 : 2) |
+		   (outsideFlags.z ? 0 : 4) |
+		   (outsideFlags.w ? 0 : 8);
+}
+
+} // namespace ECS
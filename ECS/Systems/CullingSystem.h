@@ -0,0 +1,111 @@
+// *********************************************************************************
+// Filename:     CullingSystem.h
+// Description:  ECS system for frustum culling of entities;
+//
+//               the system keeps world space AABBs of culled entities in the
+//               structure-of-arrays form (separate arrays for each coordinate of
+//               centers and extents) so 4 boxes are tested against a plane of
+//               the frustum at once using SIMD registers; world boxes are
+//               recomputed only for entities whose world matrices were changed;
+//
+//               the culling is made on the CPU only and is split into chunks
+//               which are processed by the pool of worker threads;
+//
+//               optionally the system maintains a BVH over world boxes which is
+//               refitted when boxes are changed; the BVH is used for hierarchical
+//               frustum culling, ray picking and sphere/box overlap queries
+//               (without the BVH sphere queries are made by a linear SIMD pass);
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "../Components/Bounding.h"
+#include "../Components/WorldMatrix.h"
+#include "../Common/ThreadPool.h"
+#include "../Common/BVH.h"
+
+#include <vector>
+
+namespace ECS
+{
+
+class CullingSystem final
+{
+public:
+	static constexpr size CHUNK_SIZE = 4096;   // number of boxes processed by a single task (a multiple of 4)
+
+	CullingSystem(Bounding* pBoundingComponent, WorldMatrix* pWorldMatComponent);
+	~CullingSystem() {}
+
+	void RebuildWorldBoxes(
+		const std::vector<EntityID>& ids,      // all the entities to cull
+		ThreadPool& pool);
+
+	void UpdateWorldBoxes(
+		const std::vector<EntityID>& ids,      // entities whose world matrices were changed
+		ThreadPool& pool);
+
+	void CullByFrustum(
+		const XMMATRIX& viewProj,
+		ThreadPool& pool,
+		std::vector<EntityID>& outVisibleIDs);
+
+	// BVH API
+	void EnableBVH(const bool isEnabled);
+
+	void CullByFrustumBVH(
+		const XMMATRIX& viewProj,
+		std::vector<EntityID>& outVisibleIDs) const;
+
+	bool RayCast(
+		const XMVECTOR& origin,
+		const XMVECTOR& dir,
+		EntityID& outID,
+		float& outDist) const;
+
+	// uses the BVH if it's enabled or a linear pass over all the world boxes otherwise
+	void QuerySphere(const DirectX::BoundingSphere& sphere, std::vector<EntityID>& outIDs) const;
+
+	void QueryBox(const DirectX::BoundingBox& box, std::vector<EntityID>& outIDs) const;
+
+	inline bool IsBVHEnabled() const { return isBVHEnabled_; }
+	inline const BVH& GetBVH() const { return bvh_; }
+	inline BVH& GetBVH() { return bvh_; }
+
+	inline size GetBoxesCount() const { return std::ssize(ids_); }
+
+	// get the world AABB of the entity (return false if the entity isn't culled by this system)
+	bool GetWorldBoxByID(const EntityID id, DirectX::BoundingBox& outBox) const;
+
+private:
+	void BuildBVH();
+	void ComputeWorldBox(const size boxIdx);
+	DirectX::BoundingBox GetWorldBox(const size boxIdx) const;
+	static void ComputeFrustumPlanes(const XMMATRIX& viewProj, XMVECTOR* outPlanes);
+	u32  TestBoxesAgainstFrustum(const size boxIdx, const XMVECTOR* planes) const;
+
+private:
+	Bounding*    pBoundingComponent_ = nullptr;
+	WorldMatrix* pWorldMatComponent_ = nullptr;
+
+	std::vector<EntityID>  ids_;               // IDs of culled entities
+	std::vector<ptrdiff_t> worldIdxs_;         // data idx of each entt in the WorldMatrix component (or -1)
+	std::vector<ptrdiff_t> boundingIdxs_;      // data idx of each entt in the Bounding component (or -1)
+	SparseSet              sparse_;            // entity ID => box idx
+
+	// world space AABBs (SoA); arrays are padded to a multiple of 4
+	std::vector<float>     centersX_;
+	std::vector<float>     centersY_;
+	std::vector<float>     centersZ_;
+	std::vector<float>     extentsX_;
+	std::vector<float>     extentsY_;
+	std::vector<float>     extentsZ_;
+
+	std::vector<u32>       chunksVisibleCounts_;   // number of visible entts found by each chunk
+
+	BVH                    bvh_;                   // items of the BVH are boxes of this system (the same idxs)
+	bool                   isBVHEnabled_ = false;
+};
+
+} // namespace ECS
@@ -0,0 +1,33 @@
+// **********************************************************************************
+// Filename:      SimdHelpers.h
+// Description:   contains small SIMD helpers shared by the ECS systems
+//                which process data 4 records at a time
+//
+// Created:       17.10.26
+// **********************************************************************************
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "../../Common/Types.h"
+
+
+namespace ECS
+{
+
+// *********************************************************************************
+
+inline u32 GetMask(const DirectX::XMVECTOR v)
+{
+	// return: 4-bit mask of components of the comparison result which are true
+
+	DirectX::XMUINT4 flags;
+	DirectX::XMStoreUInt4(&flags, v);
+
+	return (flags.x ? 1 : 0) |
+		   (flags.y ? 2 : 0) |
+		   (flags.z ? 4 : 0) |
+		   (flags.w ? 8 : 0);
+}
+
+} // namespace ECS
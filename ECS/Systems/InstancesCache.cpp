@@ -0,0 +1,283 @@
+// *********************************************************************************
+// Filename:     InstancesCache.cpp
+// Description:  implementation of the persistent cache of per-instance rendering data
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "InstancesCache.h"
+#include "../Common/Assert.h"
+#include "../Common/Utils.h"
+
+#include <numeric>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace ECS
+{
+
+InstancesCache::InstancesCache(
+	MeshSystem* pMeshSystem,
+	WorldMatrix* pWorldMatComponent,
+	TextureTransform* pTexTransformComponent)
+{
+	Assert::NotNullptr(pMeshSystem, "ptr to the mesh system == nullptr");
+	Assert::NotNullptr(pWorldMatComponent, "ptr to the world matrix component == nullptr");
+	Assert::NotNullptr(pTexTransformComponent, "ptr to the texture transform component == nullptr");
+
+	pMeshSystem_            = pMeshSystem;
+	pWorldMatComponent_     = pWorldMatComponent;
+	pTexTransformComponent_ = pTexTransformComponent;
+}
+
+///////////////////////////////////////////////////////////
+
+const InstancesBucket& InstancesCache::UpdateBucket(
+	const RenderBucketID bucketID,
+	const std::vector<EntityID>& enttsIDs,
+	const std::vector<EntityID>& visibleEnttsIDs,
+	const std::vector<EntityID>& dirtyEnttsIDs,
+	const u32 dirtyListVersion,
+	const u32 structVersion)
+{
+	// update cached instances data of the bucket for this frame;
+	// if the bucket isn't rebuilt then patchedInstances_ contains idxs of
+	// instances whose data was changed so only they have to be uploaded;
+	// changes of visibility don't touch cached data of instances, they
+	// only rebuild the list of visible instances
+
+	if (bucketID >= RENDER_BUCKETS_COUNT)
+		throw LIB_Exception("invalid render bucket ID: " + std::to_string(bucketID));
+
+	InstancesBucket& bucket = buckets_[bucketID];
+	const u32 worldsVersion = pWorldMatComponent_->version_;
+
+	bucket.patchedInstances_.clear();
+
+	const bool isRebuilt = (bucket.structVersion_ != structVersion) || (bucket.entts_ != enttsIDs);
+
+	// the set of entities or their components was changed
+	if (isRebuilt)
+	{
+		RebuildBucket(bucket, enttsIDs);
+	}
+
+	// world matrices were explicitly set or we missed some list of dirty entities
+	else if ((bucket.worldsVersion_ != worldsVersion) || (dirtyListVersion - bucket.dirtyVersion_ > 1))
+	{
+		GatherAllWorlds(bucket);
+		PatchTexTransforms(bucket);
+
+		bucket.patchedInstances_.resize(bucket.GetInstancesCount());
+		std::iota(bucket.patchedInstances_.begin(), bucket.patchedInstances_.end(), 0);
+	}
+
+	// regular frame: patch only changed instances
+	else
+	{
+		if (dirtyListVersion != bucket.dirtyVersion_)
+			PatchDirtyWorlds(bucket, dirtyEnttsIDs);
+
+		PatchTexTransforms(bucket);
+		Utils::AppendArray(bucket.patchedInstances_, bucket.texTransformedInstances_);
+	}
+
+	// the camera or visible entities were changed
+	if (isRebuilt || (bucket.visibleEntts_ != visibleEnttsIDs))
+		UpdateVisibleInstances(bucket, visibleEnttsIDs);
+
+	bucket.structVersion_ = structVersion;
+	bucket.worldsVersion_ = worldsVersion;
+	bucket.dirtyVersion_  = dirtyListVersion;
+
+	return bucket;
+}
+
+
+
+// *********************************************************************************
+//
+//                              PRIVATE HELPERS
+//
+// *********************************************************************************
+
+void InstancesCache::RebuildBucket(
+	InstancesBucket& bucket,
+	const std::vector<EntityID>& enttsIDs)
+{
+	// build instances of the bucket from scratch: each entity has an instance
+	// per each of its meshes; instances are sorted by meshes (and by order of
+	// records of the Mesh component within the same mesh) so they can be
+	// rendered in batches
+
+	const TextureTransform& texTransComp = *pTexTransformComponent_;
+
+	// unbind old instances (pages of the sparse set stay allocated)
+	for (const EntityID id : bucket.instancesEntts_)
+		bucket.sparse_.Remove(id);
+
+	bucket.entts_ = enttsIDs;
+	bucket.texTransformedInstances_.clear();
+	bucket.texTransformIdxs_.clear();
+
+	// the Mesh component already keeps relations 'mesh_id' => 'entts' sorted by meshes
+	pMeshSystem_->GetMeshesIDsRelatedToEntts(
+		enttsIDs,
+		bucket.meshesIDs_,
+		bucket.instancesEntts_,
+		bucket.numInstancesPerMesh_);
+
+	// ---------------------------------------------
+
+	const size instancesCount = bucket.GetInstancesCount();
+
+	bucket.worldIdxs_.resize(instancesCount);
+	bucket.nextInstances_.assign(instancesCount, InstancesBucket::INVALID_INSTANCE);
+
+	for (size i = 0; i < instancesCount; ++i)
+	{
+		const EntityID id = bucket.instancesEntts_[i];
+
+		bucket.worldIdxs_[i] = pWorldMatComponent_->sparse_.GetIdx(id);
+
+		// bind the instance to its entity (an entity with a few meshes has a few instances)
+		const ptrdiff_t firstInstance = bucket.sparse_.GetIdx(id);
+
+		if (firstInstance == -1)
+		{
+			bucket.sparse_.Add(id, i);
+		}
+		else
+		{
+			bucket.nextInstances_[i] = bucket.nextInstances_[firstInstance];
+			bucket.nextInstances_[firstInstance] = (u32)i;
+		}
+
+		// texture transformations are updated each frame so we keep their data idxs
+		const ptrdiff_t texTransIdx = texTransComp.sparse_.GetIdx(id);
+
+		if (texTransIdx != -1)
+		{
+			bucket.texTransformedInstances_.push_back((u32)i);
+			bucket.texTransformIdxs_.push_back(texTransIdx);
+		}
+	}
+
+	// ---------------------------------------------
+
+	GatherAllWorlds(bucket);
+
+	bucket.texTransforms_.assign(instancesCount, XMMatrixIdentity());
+	PatchTexTransforms(bucket);
+
+	++bucket.version_;
+}
+
+///////////////////////////////////////////////////////////
+
+void InstancesCache::GatherAllWorlds(InstancesBucket& bucket)
+{
+	// copy world matrices of all the instances by data idxs which
+	// were stored during rebuilding of the bucket
+
+	const XMMATRIX* worlds = pWorldMatComponent_->worlds_.data();
+	const size instancesCount = bucket.GetInstancesCount();
+
+	bucket.worlds_.resize(instancesCount);
+
+	for (size i = 0; i < instancesCount; ++i)
+	{
+		const ptrdiff_t worldIdx = bucket.worldIdxs_[i];
+		bucket.worlds_[i] = (worldIdx != -1) ? worlds[worldIdx] : XMMatrixIdentity();
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void InstancesCache::PatchDirtyWorlds(
+	InstancesBucket& bucket,
+	const std::vector<EntityID>& dirtyEnttsIDs)
+{
+	// copy world matrices only of instances of dirty entities
+	// (dirty entities which aren't rendered by this bucket are skipped)
+
+	const XMMATRIX* worlds = pWorldMatComponent_->worlds_.data();
+
+	for (const EntityID id : dirtyEnttsIDs)
+	{
+		const ptrdiff_t firstInstance = bucket.sparse_.GetIdx(id);
+
+		if (firstInstance == -1)
+			continue;
+
+		// go through all the instances of the entity
+		for (u32 i = (u32)firstInstance; i != InstancesBucket::INVALID_INSTANCE; i = bucket.nextInstances_[i])
+		{
+			bucket.worlds_[i] = worlds[bucket.worldIdxs_[i]];
+			bucket.patchedInstances_.push_back(i);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void InstancesCache::PatchTexTransforms(InstancesBucket& bucket)
+{
+	// copy current texture transformations (they can be animated)
+
+	const XMMATRIX* texTransforms = pTexTransformComponent_->texTransforms_.data();
+
+	for (size i = 0; i < std::ssize(bucket.texTransformedInstances_); ++i)
+		bucket.texTransforms_[bucket.texTransformedInstances_[i]] = texTransforms[bucket.texTransformIdxs_[i]];
+}
+
+///////////////////////////////////////////////////////////
+
+void InstancesCache::UpdateVisibleInstances(
+	InstancesBucket& bucket,
+	const std::vector<EntityID>& visibleEnttsIDs)
+{
+	// select instances of visible entities and count them per mesh;
+	// instances are sorted by meshes so sorted idxs of visible
+	// instances are also grouped by meshes
+
+	std::vector<u32>& visibleInstances = bucket.visibleInstances_;
+
+	bucket.visibleEntts_ = visibleEnttsIDs;
+	visibleInstances.clear();
+
+	for (const EntityID id : visibleEnttsIDs)
+	{
+		const ptrdiff_t firstInstance = bucket.sparse_.GetIdx(id);
+
+		// the entity isn't rendered by this bucket
+		if (firstInstance == -1)
+			continue;
+
+		for (u32 i = (u32)firstInstance; i != InstancesBucket::INVALID_INSTANCE; i = bucket.nextInstances_[i])
+			visibleInstances.push_back(i);
+	}
+
+	std::sort(visibleInstances.begin(), visibleInstances.end());
+
+	// ---------------------------------------------
+
+	const size meshesCount = std::ssize(bucket.numInstancesPerMesh_);
+	bucket.numVisibleInstancesPerMesh_.assign(meshesCount, 0);
+
+	size meshIdx = 0;
+	size meshEnd = (meshesCount > 0) ? bucket.numInstancesPerMesh_[0] : 0;
+
+	for (const u32 instanceIdx : visibleInstances)
+	{
+		// go to the mesh of this instance
+		while ((size)instanceIdx >= meshEnd)
+			meshEnd += bucket.numInstancesPerMesh_[++meshIdx];
+
+		++bucket.numVisibleInstancesPerMesh_[meshIdx];
+	}
+
+	++bucket.visibilityVersion_;
+}
+
+} // namespace ECS
@@ -0,0 +1,115 @@
+// *********************************************************************************
+// Filename:     InstancesCache.h
+// Description:  a persistent cache of per-instance rendering data of entities
+//               (meshes of instances, world matrices, texture transformations)
+//               which is split into render buckets (sets of entities which are
+//               rendered with the same render states);
+//
+//               a bucket contains all the entities which are rendered with its
+//               render states (visible or not) so it is fully rebuilt only when
+//               the set of its entities or the structure of the ECS is changed;
+//               in other frames only instances of entities whose world matrices
+//               were rebuilt (dirty entities) and instances with texture
+//               transformations are patched in place;
+//
+//               visibility isn't a part of the bucket: visible entities only
+//               select a list of visible instances of the bucket;
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "MeshSystem.h"
+#include "../Components/WorldMatrix.h"
+#include "../Components/TextureTransform.h"
+#include "../Common/SparseSet.h"
+
+#include <vector>
+
+namespace ECS
+{
+
+enum RenderBucketID : u32
+{
+	BUCKET_DEFAULT_STATES,           // fill solid, cull back, no blending, no alpha clipping
+	BUCKET_ALPHA_CLIP_CULL_NONE,     // for instance: foliage, bushes, tree leaves (but no blending)
+	BUCKET_BLENDING,
+
+	RENDER_BUCKETS_COUNT,
+};
+
+///////////////////////////////////////////////////////////
+
+struct InstancesBucket
+{
+	static constexpr u32 INVALID_INSTANCE = UINT32_MAX;
+
+	std::vector<EntityID>  entts_;                     // input entts of the bucket (to detect changes of the set)
+	std::vector<MeshID>    meshesIDs_;                 // meshes which are rendered by the bucket
+	std::vector<size>      numInstancesPerMesh_;       // how many instances are rendered using each mesh
+
+	// per instance data (instances are sorted by meshes)
+	std::vector<EntityID>  instancesEntts_;            // entity of each instance
+	std::vector<ptrdiff_t> worldIdxs_;                 // data idx of the entity in the WorldMatrix component (or -1)
+	std::vector<XMMATRIX>  worlds_;
+	std::vector<XMMATRIX>  texTransforms_;
+	std::vector<u32>       nextInstances_;             // idx of the next instance of the same entity (if it has a few meshes)
+	SparseSet              sparse_;                    // entity ID => idx of its first instance
+
+	std::vector<u32>       texTransformedInstances_;   // instances whose entts have texture transformations
+	std::vector<ptrdiff_t> texTransformIdxs_;          // data idx of each such instance in the TextureTransform component
+
+	std::vector<u32>       patchedInstances_;          // instances which were changed by the last update (if the bucket wasn't rebuilt)
+
+	// visibility of instances
+	std::vector<EntityID>  visibleEntts_;              // input visible entts (to detect changes of visibility)
+	std::vector<u32>       visibleInstances_;          // idxs of visible instances (in ascending order so they are sorted by meshes)
+	std::vector<size>      numVisibleInstancesPerMesh_;
+
+	u32 version_           = 0;                        // is increased each time when the bucket is rebuilt
+	u32 visibilityVersion_ = 0;                        // is increased each time when the list of visible instances is changed
+	u32 structVersion_ = UINT32_MAX;                   // versions of data when the bucket was updated
+	u32 worldsVersion_ = UINT32_MAX;
+	u32 dirtyVersion_  = UINT32_MAX;
+
+	inline size GetInstancesCount() const { return std::ssize(instancesEntts_); }
+};
+
+///////////////////////////////////////////////////////////
+
+class InstancesCache final
+{
+public:
+	InstancesCache(
+		MeshSystem* pMeshSystem,
+		WorldMatrix* pWorldMatComponent,
+		TextureTransform* pTexTransformComponent);
+
+	~InstancesCache() {}
+
+	const InstancesBucket& UpdateBucket(
+		const RenderBucketID bucketID,
+		const std::vector<EntityID>& enttsIDs,        // all the entts which are rendered by this bucket
+		const std::vector<EntityID>& visibleEnttsIDs, // visible entts (entts of other buckets are skipped)
+		const std::vector<EntityID>& dirtyEnttsIDs,   // entts whose world matrices were rebuilt
+		const u32 dirtyListVersion,                   // version of the list of dirty entts
+		const u32 structVersion);                     // version of the ECS structure
+
+	inline const InstancesBucket& GetBucket(const RenderBucketID bucketID) const { return buckets_[bucketID]; }
+
+private:
+	void RebuildBucket(InstancesBucket& bucket, const std::vector<EntityID>& enttsIDs);
+	void GatherAllWorlds(InstancesBucket& bucket);
+	void PatchDirtyWorlds(InstancesBucket& bucket, const std::vector<EntityID>& dirtyEnttsIDs);
+	void PatchTexTransforms(InstancesBucket& bucket);
+	void UpdateVisibleInstances(InstancesBucket& bucket, const std::vector<EntityID>& visibleEnttsIDs);
+
+private:
+	MeshSystem*       pMeshSystem_ = nullptr;
+	WorldMatrix*      pWorldMatComponent_ = nullptr;
+	TextureTransform* pTexTransformComponent_ = nullptr;
+
+	InstancesBucket   buckets_[RENDER_BUCKETS_COUNT];
+};
+
+} // namespace ECS
@@ -0,0 +1,436 @@
+// *********************************************************************************
+// Filename:     LightClusters.cpp
+// Description:  implementation of the CPU clustered assignment of lights
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "LightClusters.h"
+#include "Helpers/SimdHelpers.h"
+#include "../Common/Assert.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace ECS
+{
+
+// *********************************************************************************
+//                                PUBLIC API
+// *********************************************************************************
+
+void LightClusters::Build(
+	const XMMATRIX& view,
+	const XMMATRIX& proj,
+	const PointLights& pointLights,
+	const SpotLights& spotLights,
+	ThreadPool& pool)
+{
+	// bin point and spot lights into clusters of the view frustum;
+	//
+	// NOTE: all the arrays are reused from frame to frame so there are
+	//       no heap allocations if their capacity is big enough
+
+	ComputeClustersBounds(proj);
+	TransformLights(view, pointLights, spotLights, pool);
+
+	slices_.resize(SLICES_Z);
+	pointCounts_.resize(CLUSTERS_COUNT);
+	spotCounts_.resize(CLUSTERS_COUNT);
+
+	// each slice writes counts only of its own clusters
+	pool.ParallelFor(SLICES_Z, 1, [this](const size begin, const size end)
+	{
+		for (size slice = begin; slice < end; ++slice)
+			BinSlice((u32)slice);
+	});
+
+	// pack light idxs of slices one after another (in order of slices so the result is deterministic)
+	offsets_.resize(CLUSTERS_COUNT);
+	u32 offset = 0;
+
+	for (u32 i = 0; i < CLUSTERS_COUNT; ++i)
+	{
+		offsets_[i] = offset;
+		offset += pointCounts_[i] + spotCounts_[i];
+	}
+
+	lightIdxs_.resize(offset);
+
+	for (u32 slice = 0; slice < SLICES_Z; ++slice)
+	{
+		const std::vector<u32>& idxs = slices_[slice].lightIdxs;
+
+		if (!idxs.empty())
+			std::memcpy(lightIdxs_.data() + offsets_[slice * TILES_PER_SLICE], idxs.data(), idxs.size() * sizeof(u32));
+	}
+
+	// gather lights which are in at least one cluster
+	isLightVisible_.assign(pointLightsCount_ + spotLightsCount_, 0);
+
+	for (const SliceData& slice : slices_)
+	{
+		for (const u32 lightIdx : slice.touchedLights)
+			isLightVisible_[lightIdx] = 1;
+	}
+
+	visiblePointLights_.clear();
+	visibleSpotLights_.clear();
+
+	for (u32 i = 0; i < pointLightsCount_; ++i)
+	{
+		if (isLightVisible_[i])
+			visiblePointLights_.push_back(i);
+	}
+
+	for (u32 i = 0; i < spotLightsCount_; ++i)
+	{
+		if (isLightVisible_[pointLightsCount_ + i])
+			visibleSpotLights_.push_back(i);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+u32 LightClusters::GetSliceByDepth(const float viewDepth) const
+{
+	// return: the idx of slice which contains the input view space depth
+	//         (depths out of the clustered range are clamped)
+
+	if (viewDepth <= nearZ_)
+		return 0;
+
+	const float slice = logf(viewDepth / nearZ_) / logFarNear_ * SLICES_Z;
+
+	return std::min((u32)slice, SLICES_Z - 1);
+}
+
+///////////////////////////////////////////////////////////
+
+BoundingBox LightClusters::GetClusterBox(const u32 x, const u32 y, const u32 z) const
+{
+	Assert::True((x < TILES_X) && (y < TILES_Y) && (z < SLICES_Z), "wrong cluster coords");
+
+	const u32 xIdx = z * TILES_X + x;
+	const u32 yIdx = z * TILES_Y + y;
+
+	BoundingBox box;
+	BoundingBox::CreateFromPoints(
+		box,
+		XMVectorSet(tilesMinX_[xIdx], tilesMinY_[yIdx], slicesDepths_[z], 1.0f),
+		XMVectorSet(tilesMaxX_[xIdx], tilesMaxY_[yIdx], slicesDepths_[z + 1], 1.0f));
+
+	return box;
+}
+
+
+// *********************************************************************************
+//                               PRIVATE HELPERS
+// *********************************************************************************
+
+void LightClusters::ComputeClustersBounds(const XMMATRIX& proj)
+{
+	// compute view space bounds of clusters for the left-handed perspective projection:
+	// proj[2][2] == far / (far - near), proj[3][2] == -near * far / (far - near)
+
+	const float p00 = XMVectorGetX(proj.r[0]);
+	const float p11 = XMVectorGetY(proj.r[1]);
+	const float a   = XMVectorGetZ(proj.r[2]);
+	const float b   = XMVectorGetZ(proj.r[3]);
+
+	Assert::True((p00 > 0) && (p11 > 0) && (a > 1.0f) && (b < 0), "the projection matrix must be a left-handed perspective projection");
+
+	const float nearZ = -b / a;
+	const float farZ  = std::min(b / (1.0f - a), maxDepth_);
+
+	Assert::True(farZ > nearZ, "the max depth of clusters must be greater than the near plane");
+
+	nearZ_      = nearZ;
+	logFarNear_ = logf(farZ / nearZ);
+
+	slicesDepths_.resize(SLICES_Z + 1);
+
+	for (u32 z = 0; z < SLICES_Z; ++z)
+		slicesDepths_[z] = nearZ * expf(logFarNear_ * z / SLICES_Z);
+
+	slicesDepths_[SLICES_Z] = farZ;
+
+	// view space x (y) of a point with NDC x (y) at the depth z is x_ndc * z / p00 (y_ndc * z / p11);
+	// the AABB of a tile in the slice contains its frustum in both ends of the slice
+	tilesMinX_.resize(SLICES_Z * TILES_X);
+	tilesMaxX_.resize(SLICES_Z * TILES_X);
+	tilesMinY_.resize(SLICES_Z * TILES_Y);
+	tilesMaxY_.resize(SLICES_Z * TILES_Y);
+
+	for (u32 z = 0; z < SLICES_Z; ++z)
+	{
+		const float z0 = slicesDepths_[z];
+		const float z1 = slicesDepths_[z + 1];
+
+		for (u32 x = 0; x < TILES_X; ++x)
+		{
+			const float ndc0 = -1.0f + 2.0f * x / TILES_X;
+			const float ndc1 = -1.0f + 2.0f * (x + 1) / TILES_X;
+
+			tilesMinX_[z * TILES_X + x] = std::min(ndc0 * z0, ndc0 * z1) / p00;
+			tilesMaxX_[z * TILES_X + x] = std::max(ndc1 * z0, ndc1 * z1) / p00;
+		}
+
+		for (u32 y = 0; y < TILES_Y; ++y)
+		{
+			const float ndc0 = -1.0f + 2.0f * y / TILES_Y;
+			const float ndc1 = -1.0f + 2.0f * (y + 1) / TILES_Y;
+
+			tilesMinY_[z * TILES_Y + y] = std::min(ndc0 * z0, ndc0 * z1) / p11;
+			tilesMaxY_[z * TILES_Y + y] = std::max(ndc1 * z0, ndc1 * z1) / p11;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void LightClusters::TransformLights(
+	const XMMATRIX& view,
+	const PointLights& pointLights,
+	const SpotLights& spotLights,
+	ThreadPool& pool)
+{
+	// compute view space bounding spheres of lights and cones of spot lights
+
+	pointLightsCount_ = (u32)pointLights.GetCount();
+	spotLightsCount_  = (u32)spotLights.GetCount();
+
+	const size lightsCount = (size)pointLightsCount_ + spotLightsCount_;
+	const size paddedCount = (lightsCount + 3) & ~3;
+
+	lightsX_.resize(paddedCount);
+	lightsY_.resize(paddedCount);
+	lightsZ_.resize(paddedCount);
+	lightsRadius_.resize(paddedCount);
+	spotsCones_.resize(spotLightsCount_);
+
+	// padding lights are behind the camera so they never get into clusters
+	for (size i = lightsCount; i < paddedCount; ++i)
+	{
+		lightsX_[i]      = 0.0f;
+		lightsY_[i]      = 0.0f;
+		lightsZ_[i]      = -1.0f;
+		lightsRadius_[i] = 0.0f;
+	}
+
+	pool.ParallelFor(lightsCount, CHUNK_SIZE, [this, &view, &pointLights, &spotLights](const size begin, const size end)
+	{
+		for (size i = begin; i < end; ++i)
+		{
+			XMVECTOR pos;
+			float range;
+
+			if (i < (size)pointLightsCount_)
+			{
+				const PointLight& light = pointLights.data_[i];
+				pos   = XMVector3TransformCoord(XMLoadFloat3(&light.position_), view);
+				range = light.range_;
+			}
+			else
+			{
+				// the spot factor is pow(cos(angle), spot) so the cone border
+				// is where the factor falls down to the cutoff value;
+				// a light with non-positive exponent lits the whole sphere
+				const SpotLight& light = spotLights.data_[i - pointLightsCount_];
+				const XMVECTOR dir     = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.direction_), view));
+				const float cosAngle   = (light.spot_ > 0) ? powf(SPOT_CUTOFF, 1.0f / light.spot_) : -1.0f;
+
+				pos   = XMVector3TransformCoord(XMLoadFloat3(&light.position_), view);
+				range = light.range_;
+				XMStoreFloat4(&spotsCones_[i - pointLightsCount_], XMVectorSetW(dir, cosAngle));
+			}
+
+			lightsX_[i]      = XMVectorGetX(pos);
+			lightsY_[i]      = XMVectorGetY(pos);
+			lightsZ_[i]      = XMVectorGetZ(pos);
+			lightsRadius_[i] = range;
+		}
+	});
+}
+
+///////////////////////////////////////////////////////////
+
+void LightClusters::BinSlice(const u32 slice)
+{
+	// find intersections of lights with clusters of the slice: at first 4 lights are
+	// tested against the depth range of the slice at once; for each light which
+	// passed we test its sphere against AABBs of tiles: the squared distance from
+	// the center to the box is separable so rows are tested one by one and 4 tiles
+	// of a row at once
+
+	SliceData& data = slices_[slice];
+	data.hitTiles.clear();
+	data.hitLights.clear();
+	data.touchedLights.clear();
+
+	const float z0 = slicesDepths_[slice];
+	const float z1 = slicesDepths_[slice + 1];
+	const XMVECTOR vz0 = XMVectorReplicate(z0);
+	const XMVECTOR vz1 = XMVectorReplicate(z1);
+
+	const float* minsX = tilesMinX_.data() + slice * TILES_X;
+	const float* maxsX = tilesMaxX_.data() + slice * TILES_X;
+	const float* minsY = tilesMinY_.data() + slice * TILES_Y;
+	const float* maxsY = tilesMaxY_.data() + slice * TILES_Y;
+
+	const size paddedCount = std::ssize(lightsZ_);
+
+	for (size i = 0; i < paddedCount; i += 4)
+	{
+		const XMVECTOR z = XMLoadFloat4((const XMFLOAT4*)&lightsZ_[i]);
+		const XMVECTOR r = XMLoadFloat4((const XMFLOAT4*)&lightsRadius_[i]);
+
+		u32 depthMask = GetMask(XMVectorAndInt(
+			XMVectorLess(XMVectorSubtract(z, r), vz1),
+			XMVectorGreater(XMVectorAdd(z, r), vz0)));
+
+		for (u32 bit = 0; depthMask; ++bit, depthMask >>= 1)
+		{
+			if (!(depthMask & 1))
+				continue;
+
+			const u32   lightIdx = (u32)i + bit;
+			const float lx       = lightsX_[lightIdx];
+			const float ly       = lightsY_[lightIdx];
+			const float lz       = lightsZ_[lightIdx];
+			const float radius   = lightsRadius_[lightIdx];
+			const bool  isSpot   = (lightIdx >= pointLightsCount_);
+
+			const float dz       = (lz < z0) ? (z0 - lz) : (lz > z1) ? (lz - z1) : 0.0f;
+			const float remDepth = radius * radius - dz * dz;
+
+			if (remDepth < 0)
+				continue;
+
+			// the ranges of rows and groups of 4 columns which the sphere can touch
+			// (tiles go from left to right and from bottom to top)
+			const float extent = sqrtf(remDepth);
+			u32 y0 = 0;
+			u32 y1 = TILES_Y;
+			u32 x0 = 0;
+			u32 x1 = TILES_X;
+
+			while ((y0 < y1) && (maxsY[y0] < ly - extent))     ++y0;
+			while ((y1 > y0) && (minsY[y1 - 1] > ly + extent)) --y1;
+			while ((x0 < x1) && (maxsX[x0 + 3] < lx - extent)) x0 += 4;
+			while ((x1 > x0) && (minsX[x1 - 4] > lx + extent)) x1 -= 4;
+
+			const XMVECTOR vx = XMVectorReplicate(lx);
+			bool isTouched = false;
+
+			for (u32 y = y0; y < y1; ++y)
+			{
+				const float dy  = std::max(std::max(minsY[y] - ly, ly - maxsY[y]), 0.0f);
+				const float rem = remDepth - dy * dy;
+
+				if (rem < 0)
+					continue;
+
+				const XMVECTOR vrem = XMVectorReplicate(rem);
+
+				for (u32 x = x0; x < x1; x += 4)
+				{
+					const XMVECTOR minX = XMLoadFloat4((const XMFLOAT4*)&minsX[x]);
+					const XMVECTOR maxX = XMLoadFloat4((const XMFLOAT4*)&maxsX[x]);
+					const XMVECTOR dx   = XMVectorMax(XMVectorMax(XMVectorSubtract(minX, vx), XMVectorSubtract(vx, maxX)), g_XMZero);
+
+					u32 hitMask = GetMask(XMVectorLessOrEqual(XMVectorMultiply(dx, dx), vrem));
+
+					for (u32 tileBit = 0; hitMask; ++tileBit, hitMask >>= 1)
+					{
+						if (!(hitMask & 1))
+							continue;
+
+						if (isSpot && !IsConeInCluster(lightIdx, x + tileBit, y, slice))
+							continue;
+
+						data.hitTiles.push_back(y * TILES_X + x + tileBit);
+						data.hitLights.push_back(lightIdx);
+						isTouched = true;
+					}
+				}
+			}
+
+			if (isTouched)
+				data.touchedLights.push_back(lightIdx);
+		}
+	}
+
+	// group light idxs by clusters (a counting sort); lights were found in ascending
+	// order of their idxs and the sort is stable so point lights go before spot lights
+	u32* pointCounts = pointCounts_.data() + slice * TILES_PER_SLICE;
+	u32* spotCounts  = spotCounts_.data()  + slice * TILES_PER_SLICE;
+	u32  offsets[TILES_PER_SLICE];
+
+	std::fill(pointCounts, pointCounts + TILES_PER_SLICE, 0);
+	std::fill(spotCounts,  spotCounts  + TILES_PER_SLICE, 0);
+
+	for (size i = 0; i < std::ssize(data.hitTiles); ++i)
+	{
+		if (data.hitLights[i] < pointLightsCount_)
+			++pointCounts[data.hitTiles[i]];
+		else
+			++spotCounts[data.hitTiles[i]];
+	}
+
+	for (u32 tile = 0, offset = 0; tile < TILES_PER_SLICE; ++tile)
+	{
+		offsets[tile] = offset;
+		offset += pointCounts[tile] + spotCounts[tile];
+	}
+
+	data.lightIdxs.resize(data.hitTiles.size());
+
+	for (size i = 0; i < std::ssize(data.hitTiles); ++i)
+	{
+		const u32 lightIdx = data.hitLights[i];
+
+		// store the idx of light among lights of its type
+		data.lightIdxs[offsets[data.hitTiles[i]]++] = (lightIdx < pointLightsCount_) ? lightIdx : (lightIdx - pointLightsCount_);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+bool LightClusters::IsConeInCluster(
+	const u32 lightIdx,
+	const u32 tileX,
+	const u32 tileY,
+	const u32 slice) const
+{
+	// test the cone of a spot light against the bounding sphere of the cluster AABB:
+	// the sphere is outside if it is farther from the cone side than its radius,
+	// or completely in front of the range, or completely behind the light
+
+	const XMFLOAT4& cone = spotsCones_[lightIdx - pointLightsCount_];
+
+	if (cone.w < 0)
+		return true;
+
+	const u32 xIdx = slice * TILES_X + tileX;
+	const u32 yIdx = slice * TILES_Y + tileY;
+
+	const XMVECTOR boxMin = XMVectorSet(tilesMinX_[xIdx], tilesMinY_[yIdx], slicesDepths_[slice], 0.0f);
+	const XMVECTOR boxMax = XMVectorSet(tilesMaxX_[xIdx], tilesMaxY_[yIdx], slicesDepths_[slice + 1], 0.0f);
+	const XMVECTOR center = XMVectorScale(boxMin + boxMax, 0.5f);
+
+	const float radius  = XMVectorGetX(XMVector3Length(boxMax - center));
+	const XMVECTOR v    = center - XMVectorSet(lightsX_[lightIdx], lightsY_[lightIdx], lightsZ_[lightIdx], 0.0f);
+	const float lenSq   = XMVectorGetX(XMVector3LengthSq(v));
+	const float v1      = XMVectorGetX(XMVector3Dot(v, XMLoadFloat4(&cone)));
+	const float sinA    = sqrtf(std::max(1.0f - cone.w * cone.w, 0.0f));
+	const float sideDist = cone.w * sqrtf(std::max(lenSq - v1 * v1, 0.0f)) - v1 * sinA;
+
+	return (sideDist <= radius) &&
+		   (v1 <= radius + lightsRadius_[lightIdx]) &&
+		   (v1 >= -radius);
+}
+
+} // namespace ECS
@@ -0,0 +1,141 @@
+// *********************************************************************************
+// Filename:     LightClusters.h
+// Description:  CPU clustered assignment of point and spot lights;
+//
+//               the view frustum is split into clusters: TILES_X * TILES_Y screen
+//               tiles by SLICES_Z depth slices (the depth of slices grows
+//               exponentially from the near plane to the max depth); each light is
+//               binned into clusters whose view space AABBs intersect the bounding
+//               sphere of the light (for spot lights the cone is tested as well);
+//
+//               the output is a compact list of light idxs and per-cluster arrays
+//               of offsets into this list and counts of point/spot lights
+//               (idxs of point lights of a cluster go first, then idxs of spot lights);
+//
+//               slices are binned in parallel by the pool of worker threads;
+//               4 tiles of a row are tested against a light at once using SIMD
+//               registers; the result doesn't depend on the number of threads;
+//
+//               NOTE: the light shader has a fixed arr of point lights and doesn't
+//                     read clusters yet so the renderer doesn't build them each frame
+//                     (it only needs visible point lights, see GraphicsClass)
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "../Components/Light.h"
+#include "../Common/ThreadPool.h"
+
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace ECS
+{
+
+class LightClusters final
+{
+public:
+	static constexpr u32   TILES_X           = 16;              // a multiple of 4
+	static constexpr u32   TILES_Y           = 9;
+	static constexpr u32   SLICES_Z          = 24;
+	static constexpr u32   TILES_PER_SLICE   = TILES_X * TILES_Y;
+	static constexpr u32   CLUSTERS_COUNT    = TILES_PER_SLICE * SLICES_Z;
+
+	static constexpr size  CHUNK_SIZE        = 4096;            // number of lights transformed into view space by a single task
+	static constexpr float DEFAULT_MAX_DEPTH = 500.0f;          // lights farther than this view space depth aren't clustered
+	static constexpr float SPOT_CUTOFF       = 1.0f / 256.0f;   // the spot factor at the border of the cone of a spot light
+
+public:
+	LightClusters() {}
+	~LightClusters() {}
+
+	// bin lights into clusters of the frustum which is defined by the view and
+	// the (left-handed perspective) projection matrices
+	void Build(
+		const XMMATRIX& view,
+		const XMMATRIX& proj,
+		const PointLights& pointLights,
+		const SpotLights& spotLights,
+		ThreadPool& pool);
+
+	inline void  SetMaxDepth(const float depth) { maxDepth_ = depth; }
+	inline float GetMaxDepth() const            { return maxDepth_; }
+
+	// tile (x, y) covers the part of the screen (in NDC) from the left bottom corner;
+	// slice z covers the view space depth range [GetSliceDepth(z), GetSliceDepth(z+1)]
+	static inline u32 GetClusterIdx(const u32 x, const u32 y, const u32 z) { return (z * TILES_Y + y) * TILES_X + x; }
+
+	inline float GetSliceDepth(const u32 z) const { return slicesDepths_[z]; }
+	u32 GetSliceByDepth(const float viewDepth) const;
+
+	// view space AABB of the cluster
+	DirectX::BoundingBox GetClusterBox(const u32 x, const u32 y, const u32 z) const;
+
+	// output: lights of the cluster are lightIdxs[offset, offset + pointCount + spotCount)
+	inline const std::vector<u32>& GetLightIdxs()   const { return lightIdxs_; }
+	inline const std::vector<u32>& GetOffsets()     const { return offsets_; }
+	inline const std::vector<u32>& GetPointCounts() const { return pointCounts_; }
+	inline const std::vector<u32>& GetSpotCounts()  const { return spotCounts_; }
+
+	// idxs of lights which are in at least one cluster (in ascending order)
+	inline const std::vector<u32>& GetVisiblePointLights() const { return visiblePointLights_; }
+	inline const std::vector<u32>& GetVisibleSpotLights()  const { return visibleSpotLights_; }
+
+private:
+	void ComputeClustersBounds(const XMMATRIX& proj);
+
+	void TransformLights(
+		const XMMATRIX& view,
+		const PointLights& pointLights,
+		const SpotLights& spotLights,
+		ThreadPool& pool);
+
+	void BinSlice(const u32 slice);
+	bool IsConeInCluster(const u32 lightIdx, const u32 tileX, const u32 tileY, const u32 slice) const;
+
+private:
+	float maxDepth_   = DEFAULT_MAX_DEPTH;
+	float nearZ_      = 0.0f;
+	float logFarNear_ = 0.0f;                        // log(far / near) of the clustered depth range
+
+	// bounds of clusters in view space: depth of slices borders (SLICES_Z+1 values);
+	// x bounds of each tile column and y bounds of each tile row (per slice)
+	std::vector<float> slicesDepths_;
+	std::vector<float> tilesMinX_;                   // [slice * TILES_X + x]
+	std::vector<float> tilesMaxX_;
+	std::vector<float> tilesMinY_;                   // [slice * TILES_Y + y]
+	std::vector<float> tilesMaxY_;
+
+	// view space bounding spheres of lights (SoA): point lights and then spot lights;
+	// arrays are padded to a multiple of 4
+	u32                pointLightsCount_ = 0;
+	u32                spotLightsCount_ = 0;
+	std::vector<float> lightsX_;
+	std::vector<float> lightsY_;
+	std::vector<float> lightsZ_;
+	std::vector<float> lightsRadius_;
+	std::vector<XMFLOAT4> spotsCones_;               // (view space direction, cos of the cone angle) of each spot light; w == -1 for no cone
+
+	// per slice data which is filled by tasks
+	struct SliceData
+	{
+		std::vector<u32> hitTiles;                   // (tile idx, light idx) of each light-cluster intersection
+		std::vector<u32> hitLights;
+		std::vector<u32> lightIdxs;                  // light idxs of clusters of the slice one after another
+		std::vector<u32> touchedLights;              // lights which are in at least one cluster of the slice
+	};
+
+	std::vector<SliceData> slices_;
+
+	// output
+	std::vector<u32>   lightIdxs_;
+	std::vector<u32>   offsets_;
+	std::vector<u32>   pointCounts_;
+	std::vector<u32>   spotCounts_;
+	std::vector<u32>   visiblePointLights_;
+	std::vector<u32>   visibleSpotLights_;
+	std::vector<uint8_t> isLightVisible_;
+};
+
+} // namespace ECS
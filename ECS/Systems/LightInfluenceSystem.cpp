@@ -0,0 +1,380 @@
+// *********************************************************************************
+// Filename:     LightInfluenceSystem.cpp
+// Description:  implementation of the LightInfluenceSystem functional
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "LightInfluenceSystem.h"
+#include "LightClusters.h"
+#include "Helpers/SimdHelpers.h"
+#include "../Common/Assert.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace ECS
+{
+
+///////////////////////////////////////////////////////////
+
+static void InsertLight(
+	u32* idxs,
+	float* relevances,
+	u32& count,
+	const u32 maxCount,
+	const u32 lightIdx,
+	const float relevance)
+{
+	// keep lights sorted by relevance in descending order;
+	// lights with the same relevance keep the order of their idxs
+
+	u32 pos = count;
+
+	while ((pos > 0) && (relevances[pos - 1] < relevance))
+		--pos;
+
+	if (pos >= maxCount)
+		return;
+
+	for (u32 i = std::min(count, maxCount - 1); i > pos; --i)
+	{
+		idxs[i]       = idxs[i - 1];
+		relevances[i] = relevances[i - 1];
+	}
+
+	idxs[pos]       = lightIdx;
+	relevances[pos] = relevance;
+	count           = std::min(count + 1, maxCount);
+}
+
+
+// *********************************************************************************
+//                                PUBLIC API
+// *********************************************************************************
+
+LightInfluenceSystem::LightInfluenceSystem(
+	Light* pLightComponent,
+	CullingSystem* pCullingSystem)
+	:
+	pLightComponent_(pLightComponent),
+	pCullingSystem_(pCullingSystem)
+{
+	Assert::NotNullptr(pLightComponent, "ptr to the Light component == nullptr");
+	Assert::NotNullptr(pCullingSystem, "ptr to the CullingSystem == nullptr");
+}
+
+///////////////////////////////////////////////////////////
+
+void LightInfluenceSystem::Update(
+	const std::vector<EntityID>& visibleIDs,
+	const std::vector<EntityID>& dirtyIDs,
+	const bool isResetRequired,
+	ThreadPool& pool)
+{
+	// recompute lists of visible entts which are new or stale; lists of invisible
+	// entts are only marked as stale and they are recomputed when entts become visible
+
+	if (isResetRequired)
+	{
+		ids_.clear();
+		lights_.clear();
+		isStale_.clear();
+		sparse_.Clear();
+	}
+
+	TakeLightsSnapshot();
+
+	if (!isResetRequired)
+	{
+		MarkStaleByChangedLights();
+		MarkStale(dirtyIDs);
+	}
+
+	// gather lists to recompute (add lists of entts which are visible for the first time)
+	recomputedIdxs_.clear();
+
+	for (const EntityID id : visibleIDs)
+	{
+		ptrdiff_t idx = sparse_.GetIdx(id);
+
+		if (idx == -1)
+		{
+			idx = std::ssize(ids_);
+			ids_.push_back(id);
+			lights_.push_back(EnttLights());
+			isStale_.push_back(1);
+			sparse_.Add(id, idx);
+		}
+
+		if (isStale_[idx])
+			recomputedIdxs_.push_back((u32)idx);
+	}
+
+	changedEntts_.clear();
+
+	if (recomputedIdxs_.empty())
+		return;
+
+	// bounding spheres of lights (SoA) to test 4 lights at once
+	const u32 lightsCount  = pointLightsCount_ + spotLightsCount_;
+	const u32 paddedCount  = (lightsCount + 3) & ~3u;
+
+	lightsX_.resize(paddedCount);
+	lightsY_.resize(paddedCount);
+	lightsZ_.resize(paddedCount);
+	lightsRadius_.resize(paddedCount);
+
+	for (u32 i = 0; i < lightsCount; ++i)
+	{
+		lightsX_[i]      = states_[i].position.x;
+		lightsY_[i]      = states_[i].position.y;
+		lightsZ_[i]      = states_[i].position.z;
+		lightsRadius_[i] = states_[i].range;
+	}
+
+	// padding lights are masked out by tests
+	for (u32 i = lightsCount; i < paddedCount; ++i)
+	{
+		lightsX_[i]      = 0;
+		lightsY_[i]      = 0;
+		lightsZ_[i]      = 0;
+		lightsRadius_[i] = 0;
+	}
+
+	// recompute lists; each list is written only by a single task
+	isChanged_.resize(recomputedIdxs_.size());
+
+	pool.ParallelFor(std::ssize(recomputedIdxs_), CHUNK_SIZE, [this, isResetRequired](const size begin, const size end)
+	{
+		for (size i = begin; i < end; ++i)
+		{
+			const u32 idx = recomputedIdxs_[i];
+			EnttLights lights;
+			BoundingBox box;
+
+			// an entity without a world box isn't lit by point/spot lights
+			if (pCullingSystem_->GetWorldBoxByID(ids_[idx], box))
+				ComputeEnttLights(box, lights);
+
+			isChanged_[i] = isResetRequired || (memcmp(&lights, &lights_[idx], sizeof(EnttLights)) != 0);
+			lights_[idx]  = lights;
+			isStale_[idx] = 0;
+		}
+	});
+
+	for (size i = 0; i < std::ssize(recomputedIdxs_); ++i)
+	{
+		if (isChanged_[i])
+			changedEntts_.push_back(ids_[recomputedIdxs_[i]]);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+const EnttLights& LightInfluenceSystem::GetEnttLights(const EntityID id) const
+{
+	static const EnttLights s_NoLights;
+
+	const ptrdiff_t idx = sparse_.GetIdx(id);
+	return (idx != -1) ? lights_[idx] : s_NoLights;
+}
+
+
+// *********************************************************************************
+//                                PRIVATE HELPERS
+// *********************************************************************************
+
+void LightInfluenceSystem::TakeLightsSnapshot()
+{
+	// keep the previous snapshot to find lights which were changed since the last update
+
+	const PointLights& pointLights = pLightComponent_->pointLights_;
+	const SpotLights&  spotLights  = pLightComponent_->spotLights_;
+
+	std::swap(states_, prevStates_);
+	prevPointLightsCount_ = pointLightsCount_;
+	prevSpotLightsCount_  = spotLightsCount_;
+
+	pointLightsCount_ = (u32)pointLights.GetCount();
+	spotLightsCount_  = (u32)spotLights.GetCount();
+	states_.resize(pointLightsCount_ + spotLightsCount_);
+
+	for (u32 i = 0; i < pointLightsCount_; ++i)
+	{
+		const PointLight& light = pointLights.data_[i];
+		LightState& state = states_[i];
+
+		state.position  = light.position_;
+		state.range     = light.range_;
+		state.direction = { 0, 0, 0 };
+		state.cosCone   = -1.0f;
+		state.att       = light.att_;
+		state.intensity = std::max({ light.diffuse_.x, light.diffuse_.y, light.diffuse_.z });
+	}
+
+	for (u32 i = 0; i < spotLightsCount_; ++i)
+	{
+		// the spot factor is pow(cos(angle), spot) so the cone border is where
+		// the factor falls down to the same cutoff value as for light clusters
+		const SpotLight& light = spotLights.data_[i];
+		LightState& state = states_[pointLightsCount_ + i];
+
+		XMStoreFloat3(&state.direction, XMVector3Normalize(XMLoadFloat3(&light.direction_)));
+
+		state.position  = light.position_;
+		state.range     = light.range_;
+		state.cosCone   = (light.spot_ > 0) ? powf(LightClusters::SPOT_CUTOFF, 1.0f / light.spot_) : -1.0f;
+		state.att       = light.att_;
+		state.intensity = std::max({ light.diffuse_.x, light.diffuse_.y, light.diffuse_.z });
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void LightInfluenceSystem::MarkStaleByChangedLights()
+{
+	// mark as stale lists of entts which are touched by the old or by the new
+	// bounding spheres of changed lights; if the set of lights was changed
+	// all the lists are stale
+
+	if ((pointLightsCount_ != prevPointLightsCount_) || (spotLightsCount_ != prevSpotLightsCount_))
+	{
+		std::fill(isStale_.begin(), isStale_.end(), 1);
+		return;
+	}
+
+	for (size i = 0; i < std::ssize(states_); ++i)
+	{
+		const LightState& curr = states_[i];
+		const LightState& prev = prevStates_[i];
+
+		if (memcmp(&curr, &prev, sizeof(LightState)) == 0)
+			continue;
+
+		pCullingSystem_->QuerySphere(BoundingSphere(prev.position, prev.range), queriedIDs_);
+		MarkStale(queriedIDs_);
+
+		pCullingSystem_->QuerySphere(BoundingSphere(curr.position, curr.range), queriedIDs_);
+		MarkStale(queriedIDs_);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void LightInfluenceSystem::MarkStale(const std::vector<EntityID>& ids)
+{
+	for (const EntityID id : ids)
+	{
+		const ptrdiff_t idx = sparse_.GetIdx(id);
+
+		if (idx != -1)
+			isStale_[idx] = 1;
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void LightInfluenceSystem::ComputeEnttLights(
+	const BoundingBox& box,
+	EnttLights& outLights) const
+{
+	// test bounding spheres of 4 lights against the box at once; the relevance of
+	// a touching light is its intensity attenuated by the distance to the closest
+	// point of the box: intensity / (a0 + a1*d + a2*d^2)
+
+	const u32 lightsCount = pointLightsCount_ + spotLightsCount_;
+
+	const XMVECTOR centerX  = XMVectorReplicate(box.Center.x);
+	const XMVECTOR centerY  = XMVectorReplicate(box.Center.y);
+	const XMVECTOR centerZ  = XMVectorReplicate(box.Center.z);
+	const XMVECTOR extentX  = XMVectorReplicate(box.Extents.x);
+	const XMVECTOR extentY  = XMVectorReplicate(box.Extents.y);
+	const XMVECTOR extentZ  = XMVectorReplicate(box.Extents.z);
+
+	const XMVECTOR boxCenter = XMLoadFloat3(&box.Center);
+	const float    boxRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&box.Extents)));
+
+	float pointsRelevances[EnttLights::MAX_POINT_LIGHTS];
+	float spotsRelevances[EnttLights::MAX_SPOT_LIGHTS];
+
+	for (u32 i = 0; i < lightsCount; i += 4)
+	{
+		const XMVECTOR radius = XMLoadFloat4((const XMFLOAT4*)&lightsRadius_[i]);
+
+		const XMVECTOR dx = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(XMLoadFloat4((const XMFLOAT4*)&lightsX_[i]), centerX)), extentX), g_XMZero);
+		const XMVECTOR dy = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(XMLoadFloat4((const XMFLOAT4*)&lightsY_[i]), centerY)), extentY), g_XMZero);
+		const XMVECTOR dz = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(XMLoadFloat4((const XMFLOAT4*)&lightsZ_[i]), centerZ)), extentZ), g_XMZero);
+
+		const XMVECTOR distSq = XMVectorAdd(XMVectorAdd(XMVectorMultiply(dx, dx), XMVectorMultiply(dy, dy)), XMVectorMultiply(dz, dz));
+		u32 mask = GetMask(XMVectorLessOrEqual(distSq, XMVectorMultiply(radius, radius)));
+
+		// skip padding lights
+		if (lightsCount - i < 4)
+			mask &= (1u << (lightsCount - i)) - 1;
+
+		if (mask == 0)
+			continue;
+
+		XMFLOAT4 distsSq;
+		XMStoreFloat4(&distsSq, distSq);
+
+		for (u32 j = 0; j < 4; ++j)
+		{
+			if (!(mask & (1u << j)))
+				continue;
+
+			const u32 lightIdx = i + j;
+			const LightState& light = states_[lightIdx];
+
+			if (light.cosCone > -1.0f)
+			{
+				// test the cone of a spot light against the bounding sphere of the box:
+				// the angle between the cone axis and the direction to the sphere
+				// minus the angular radius of the sphere must be inside the cone
+				const XMVECTOR toBox = XMVectorSubtract(boxCenter, XMLoadFloat3(&light.position));
+				const float    dist  = XMVectorGetX(XMVector3Length(toBox));
+
+				if (dist > boxRadius)
+				{
+					const float cosAngle = std::clamp(XMVectorGetX(XMVector3Dot(toBox, XMLoadFloat3(&light.direction))) / dist, -1.0f, 1.0f);
+
+					if (acosf(cosAngle) - asinf(boxRadius / dist) > acosf(light.cosCone))
+						continue;
+				}
+			}
+
+			const float d  = sqrtf((&distsSq.x)[j]);
+			const float a0 = (light.att.x) ? (1.0f / light.att.x) : 0.0f;
+			const float a1 = (light.att.y) ? (1.0f / light.att.y) : 0.0f;
+			const float a2 = (light.att.z) ? (1.0f / light.att.z) : 0.0f;
+			const float attenuation = a0 + a1*d + a2*d*d;
+			const float relevance   = light.intensity / ((attenuation > 0) ? attenuation : 1.0f);
+
+			if (lightIdx < pointLightsCount_)
+			{
+				InsertLight(
+					outLights.pointLights,
+					pointsRelevances,
+					outLights.pointLightsCount,
+					EnttLights::MAX_POINT_LIGHTS,
+					lightIdx,
+					relevance);
+			}
+			else
+			{
+				InsertLight(
+					outLights.spotLights,
+					spotsRelevances,
+					outLights.spotLightsCount,
+					EnttLights::MAX_SPOT_LIGHTS,
+					lightIdx - pointLightsCount_,
+					relevance);
+			}
+		}
+	}
+}
+
+} // namespace ECS
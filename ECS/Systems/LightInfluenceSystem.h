@@ -0,0 +1,116 @@
+// *********************************************************************************
+// Filename:     LightInfluenceSystem.h
+// Description:  ECS system which picks for each visible entity a few the most
+//               relevant point and spot lights;
+//
+//               the relevance of a light is its intensity attenuated by the distance
+//               from the light to the world AABB of the entity (from the CullingSystem);
+//               lights whose range spheres (or cones) don't touch the box are skipped;
+//
+//               lists are cached and recomputed only for entities which were moved
+//               (dirty entities) or which are touched by moved/changed lights
+//               (they are found by sphere queries of the CullingSystem), so in a static
+//               scene nothing is recomputed per frame; recomputations are split into
+//               chunks which are processed by the pool of worker threads;
+//
+//               NOTE: the light shader doesn't read per-instance lists of lights yet
+//                     so the renderer doesn't update them (see EntityManager::UpdateEnttsLights)
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "../Components/Light.h"
+#include "../Common/ThreadPool.h"
+#include "CullingSystem.h"
+
+#include <vector>
+
+namespace ECS
+{
+
+struct EnttLights
+{
+	static constexpr u32 MAX_POINT_LIGHTS = 4;
+	static constexpr u32 MAX_SPOT_LIGHTS  = 2;
+
+	// data idxs of lights in the Light component (the most relevant light goes first)
+	u32 pointLights[MAX_POINT_LIGHTS] = { 0 };
+	u32 spotLights[MAX_SPOT_LIGHTS]   = { 0 };
+	u32 pointLightsCount = 0;
+	u32 spotLightsCount  = 0;
+};
+
+///////////////////////////////////////////////////////////
+
+class LightInfluenceSystem final
+{
+public:
+	static constexpr size CHUNK_SIZE = 256;    // number of entts processed by a single task
+
+	LightInfluenceSystem(Light* pLightComponent, CullingSystem* pCullingSystem);
+	~LightInfluenceSystem() {}
+
+	void Update(
+		const std::vector<EntityID>& visibleIDs,   // entts which need lists of lights
+		const std::vector<EntityID>& dirtyIDs,     // entts whose world boxes were changed since the last update
+		const bool isResetRequired,                // all the cached lists must be recomputed
+		ThreadPool& pool);
+
+	// return an empty list for an entity which has never been updated
+	const EnttLights& GetEnttLights(const EntityID id) const;
+
+	// entts whose lists were changed by the last update
+	inline const std::vector<EntityID>& GetChangedEntts() const { return changedEntts_; }
+
+	// number of lists which were recomputed by the last update
+	inline size GetRecomputedCount() const { return std::ssize(recomputedIdxs_); }
+
+private:
+	// a light as it is used for computation of lists
+	struct LightState
+	{
+		XMFLOAT3 position;
+		float    range;
+		XMFLOAT3 direction;                        // normalized direction of a spot light
+		float    cosCone;                          // cos of the cone angle of a spot light (-1 for no cone)
+		XMFLOAT3 att;                              // inverted attenuation params (as they are stored in the component)
+		float    intensity;                        // the max component of the diffuse color
+	};
+
+	void TakeLightsSnapshot();
+	void MarkStaleByChangedLights();
+	void MarkStale(const std::vector<EntityID>& ids);
+	void ComputeEnttLights(const DirectX::BoundingBox& box, EnttLights& outLights) const;
+
+private:
+	Light*         pLightComponent_ = nullptr;
+	CullingSystem* pCullingSystem_ = nullptr;
+
+	// cached lists of entts
+	std::vector<EntityID>   ids_;
+	std::vector<EnttLights> lights_;
+	std::vector<uint8_t>    isStale_;          // the list must be recomputed when the entity becomes visible
+	SparseSet               sparse_;           // entity ID => idx of the list
+
+	// lights of the current and of the previous updates: point lights and then spot lights
+	u32                     pointLightsCount_ = 0;
+	u32                     spotLightsCount_ = 0;
+	u32                     prevPointLightsCount_ = 0;
+	u32                     prevSpotLightsCount_ = 0;
+	std::vector<LightState> states_;
+	std::vector<LightState> prevStates_;
+
+	// bounding spheres of lights (SoA); arrays are padded to a multiple of 4
+	std::vector<float>      lightsX_;
+	std::vector<float>      lightsY_;
+	std::vector<float>      lightsZ_;
+	std::vector<float>      lightsRadius_;
+
+	std::vector<u32>        recomputedIdxs_;   // idxs of lists which are recomputed by the current update
+	std::vector<uint8_t>    isChanged_;        // is a list (from recomputedIdxs_) changed
+	std::vector<EntityID>   changedEntts_;
+	std::vector<EntityID>   queriedIDs_;       // output of sphere queries (is reused)
+};
+
+} // namespace ECS
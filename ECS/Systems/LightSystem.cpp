@@ -8,6 +8,8 @@
 #include "../Common/Utils.h"
 #include "../Common/MathHelper.h"
 
+#include <cstring>
+
 using namespace Utils;
 using namespace DirectX;
 
@@ -45,24 +47,24 @@ void LightSystem::AddDirLights(
 	for (XMFLOAT3& dir : params.directions)
 		dir = DirectX::XMFloat3Normalize(dir);
 
-	// execute sorted insertion of new records into the data arrays of the component
-	for (const EntityID& id : ids)
-		InsertAtPos(comp.ids_, GetPosForID(comp.ids_, id), id);
+	// append new records to the data arrays of the component
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
+	AppendArray(comp.ids_, ids);
 
 	// add ids and lights data into the light container
-	for (u32 idx = 0; const EntityID& id : ids)
-	{
-		const ptrdiff_t pos = GetPosForID(lights.ids_, id);
+	lights.sparse_.Add(ids, std::ssize(lights.ids_));
+	AppendArray(lights.ids_, ids);
 
-		InsertAtPos(lights.ids_, pos, id);
-		InsertAtPos(lights.data_, pos, DirLight(
+	for (size idx = 0; idx < std::ssize(ids); ++idx)
+	{
+		lights.data_.emplace_back(
 			params.ambients[idx], 
 			params.diffuses[idx], 
 			params.speculars[idx], 
-			params.directions[idx]));
-		
-		++idx;
+			params.directions[idx]);
 	}
+
+	lights.dirtyRange_.Add((u32)(lights.GetCount() - std::ssize(ids)), (u32)lights.GetCount());
 }
 
 ///////////////////////////////////////////////////////////
@@ -78,26 +80,26 @@ void LightSystem::AddPointLights(
 	Light& comp = *pLightComponent_;
 	PointLights& lights = GetPointLights();
 
-	// execute sorted insertion of new IDs into the component
-	for (const EntityID& id : ids)
-		InsertAtPos(comp.ids_, GetPosForID(comp.ids_, id), id);
+	// append new IDs to the component
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
+	AppendArray(comp.ids_, ids);
 
 	// add ids and lights data into the light container
-	for (u32 idx = 0; const EntityID & id : ids)
-	{
-		const ptrdiff_t pos = GetPosForID(lights.ids_, id);
+	lights.sparse_.Add(ids, std::ssize(lights.ids_));
+	AppendArray(lights.ids_, ids);
 
-		InsertAtPos(lights.ids_,  pos, id);
-		InsertAtPos(lights.data_, pos, PointLight(
+	for (size idx = 0; idx < std::ssize(ids); ++idx)
+	{
+		lights.data_.emplace_back(
 			params.ambients[idx],
 			params.diffuses[idx],
 			params.speculars[idx],
 			params.positions[idx],
 			params.ranges[idx],
-			params.attenuations[idx]));
-
-		++idx;
+			params.attenuations[idx]);
 	}
+
+	lights.dirtyRange_.Add((u32)(lights.GetCount() - std::ssize(ids)), (u32)lights.GetCount());
 }
 
 ///////////////////////////////////////////////////////////
@@ -117,17 +119,17 @@ void LightSystem::AddSpotLights(
 	for (XMFLOAT3& dir : params.directions)
 		dir = DirectX::XMFloat3Normalize(dir);
 
-	// execute sorted insertion of new IDs into the component
-	for (const EntityID& id : ids)
-		InsertAtPos(comp.ids_, GetPosForID(comp.ids_, id), id);
+	// append new IDs to the component
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
+	AppendArray(comp.ids_, ids);
 
 	// add ids and lights data into the light container
-	for (u32 idx = 0; const EntityID & id : ids)
-	{
-		const ptrdiff_t pos = GetPosForID(lights.ids_, id);
+	lights.sparse_.Add(ids, std::ssize(lights.ids_));
+	AppendArray(lights.ids_, ids);
 
-		InsertAtPos(lights.ids_, pos, id);
-		InsertAtPos(lights.data_, pos, SpotLight(
+	for (size idx = 0; idx < std::ssize(ids); ++idx)
+	{
+		lights.data_.emplace_back(
 			params.ambients[idx],
 			params.diffuses[idx],
 			params.speculars[idx],
@@ -135,10 +137,37 @@ void LightSystem::AddSpotLights(
 			params.ranges[idx],
 			params.directions[idx],
 			params.spotExponents[idx],
-			params.attenuations[idx]));
-
-		++idx;
+			params.attenuations[idx]);
 	}
+
+	lights.dirtyRange_.Add((u32)(lights.GetCount() - std::ssize(ids)), (u32)lights.GetCount());
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::RemoveRecords(const std::vector<EntityID>& ids)
+{
+	// remove light sources of input entities (of any type);
+	// (IDs of entities which don't have this component are skipped)
+
+	Light& comp = *pLightComponent_;
+	DirLights& dirLights = GetDirLights();
+	PointLights& pointLights = GetPointLights();
+	SpotLights& spotLights = GetSpotLights();
+
+	comp.sparse_.SwapAndPop(ids, comp.ids_);
+
+	dirLights.sparse_.SwapAndPop(ids, dirLights.ids_, dirLights.data_);
+	pointLights.sparse_.SwapAndPop(ids, pointLights.ids_, pointLights.data_);
+	spotLights.sparse_.SwapAndPop(ids, spotLights.ids_, spotLights.data_);
+
+	// data idxs of remained lights could be changed
+	RemoveAnimations(comp.pointLightsAnims_, pointLights.sparse_);
+	RemoveAnimations(comp.spotLightsAnims_, spotLights.sparse_);
+
+	dirLights.dirtyRange_.Add(0, (u32)dirLights.GetCount());
+	pointLights.dirtyRange_.Add(0, (u32)pointLights.GetCount());
+	spotLights.dirtyRange_.Add(0, (u32)spotLights.GetCount());
 }
 
 
@@ -154,9 +183,11 @@ void LightSystem::SetDirLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	DirLights& lights = GetDirLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
 	DirLight& light = lights.data_[idx];
 
+	lights.dirtyRange_.Add((u32)idx);
+
 	switch (prop)
 	{
 		case LightProps::AMBIENT:
@@ -191,7 +222,9 @@ void LightSystem::SetDirLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	DirLights& lights = GetDirLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
+
+	lights.dirtyRange_.Add((u32)idx);
 
 	// maybe there will be more props of XMFLOAT3 type so...
 	switch (prop)
@@ -218,9 +251,11 @@ void LightSystem::SetPointLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	PointLights& lights = GetPointLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
 	PointLight& light = lights.data_[idx];
 
+	lights.dirtyRange_.Add((u32)idx);
+
 	switch (prop)
 	{
 		case LightProps::AMBIENT:
@@ -231,11 +266,13 @@ void LightSystem::SetPointLightProp(
 		case LightProps::DIFFUSE:
 		{
 			light.diffuse_ = value;
+			SetAnimationsBaseColor(pLightComponent_->pointLightsAnims_, id, prop, value);
 			break;
 		}
 		case LightProps::SPECULAR:
 		{
 			light.specular_ = value;
+			SetAnimationsBaseColor(pLightComponent_->pointLightsAnims_, id, prop, value);
 			break;
 		}
 		default:
@@ -255,9 +292,11 @@ void LightSystem::SetPointLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	PointLights& lights = GetPointLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
 	PointLight& light = lights.data_[idx];
 
+	lights.dirtyRange_.Add((u32)idx);
+
 	switch (prop)
 	{
 		case LightProps::POSITION:
@@ -287,7 +326,9 @@ void LightSystem::SetPointLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	PointLights& lights = GetPointLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
+
+	lights.dirtyRange_.Add((u32)idx);
 
 	// maybe there will be more props of float type so...
 	switch (prop)
@@ -314,9 +355,11 @@ void LightSystem::SetSpotLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	SpotLights& lights = GetSpotLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
 	SpotLight& light = lights.data_[idx];
 
+	lights.dirtyRange_.Add((u32)idx);
+
 	switch (prop)
 	{
 		case LightProps::AMBIENT:
@@ -327,11 +370,13 @@ void LightSystem::SetSpotLightProp(
 		case LightProps::DIFFUSE:
 		{
 			light.diffuse_ = value;
+			SetAnimationsBaseColor(pLightComponent_->spotLightsAnims_, id, prop, value);
 			break;
 		}
 		case LightProps::SPECULAR:
 		{
 			light.specular_ = value;
+			SetAnimationsBaseColor(pLightComponent_->spotLightsAnims_, id, prop, value);
 			break;
 		}
 		default:
@@ -351,9 +396,11 @@ void LightSystem::SetSpotLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	SpotLights& lights = GetSpotLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
 	SpotLight& light = lights.data_[idx];
 
+	lights.dirtyRange_.Add((u32)idx);
+
 	switch (prop)
 	{
 		case LightProps::POSITION:
@@ -388,9 +435,11 @@ void LightSystem::SetSpotLightProp(
 	CheckIdExist(id, "there is no light source by id: " + std::to_string(id));
 
 	SpotLights& lights = GetSpotLights();
-	const ptrdiff_t idx = Utils::GetIdxInSortedArr(lights.ids_, id);
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
 	SpotLight& light = lights.data_[idx];
 
+	lights.dirtyRange_.Add((u32)idx);
+
 	switch (prop)
 	{
 		case LightProps::RANGE:
@@ -422,7 +471,7 @@ void LightSystem::Update(
 	const float totalGameTime)
 {
 	UpdateDirLights(deltaTime, totalGameTime);
-	UpdatePointLights(deltaTime, totalGameTime);
+	UpdateAnimations(totalGameTime);
 }
 
 ///////////////////////////////////////////////////////////
@@ -440,44 +489,142 @@ void LightSystem::UpdateDirLights(
 	float y = -0.57735f;
 	float z = 30.0f * sinf(0.2f * totalGameTime);
 
+	const XMFLOAT3 direction = DirectX::XMFloat3Normalize({ x,y,z });
+
+	// lights are set by data idxs so we don't look for each light by its ID
 	for (ptrdiff_t idx = 0; idx < numDirLights; ++idx)
-	{
-		SetDirLightProp(dirLights.ids_[idx], ECS::LightProps::DIRECTION, {x,y,z});
-	}
+		dirLights.data_[idx].direction_ = direction;
+
+	dirLights.dirtyRange_.Add(0, (u32)numDirLights);
 }
 
 ///////////////////////////////////////////////////////////
 
-void LightSystem::UpdatePointLights(
-	const float deltaTime,
-	const float totalGameTime)
+void LightSystem::UpdateSpotLights(const XMFLOAT3& pos, const XMFLOAT3& dir)
 {
-	// circle point light over the land surface
+	SpotLights& spotLights = GetSpotLights();
+	SpotLight& flashlight = spotLights.data_[0];
 
-	PointLights& pointLights = GetPointLights();
-	size numPointLights = GetLightsNum(ECS::LightTypes::POINT);
+	// the spotlight takes on the camera position and is aimed in the same direction 
+	// the camera is looking. In this way, it looks like we are holding a flashlight
+	flashlight.position_ = pos;
+	flashlight.direction_ = dir;
 
-	float x = 30.0f * cosf(0.2f * totalGameTime);
-	float y = 3;
-	float z = 30.0f * sinf(0.2f * totalGameTime);
+	spotLights.dirtyRange_.Add(0);
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::ResetDirtyRanges()
+{
+	// is called by the consumer of changed lights after it took the changes
 
-	for (ptrdiff_t idx = 0; idx < numPointLights; ++idx)
+	GetDirLights().dirtyRange_.Reset();
+	GetPointLights().dirtyRange_.Reset();
+	GetSpotLights().dirtyRange_.Reset();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//                     PUBLIC BATCHED ANIMATION API FOR LIGHT SOURCES
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LightSystem::AddPointLightAnimation(
+	const EntityID id,
+	const LightAnimParams& params)
+{
+	// add an animation curve to the point light; a light can have a few animations
+	// (for instance: orbit + flicker) but only one of them should change the intensity
+
+	PointLights& lights = GetPointLights();
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
+
+	Assert::True(idx != -1, "there is no point light by id: " + std::to_string(id));
+
+	const PointLight& light = lights.data_[idx];
+	AddAnimation(pLightComponent_->pointLightsAnims_, id, (u32)idx, light.diffuse_, light.specular_, params);
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::AddSpotLightAnimation(
+	const EntityID id,
+	const LightAnimParams& params)
+{
+	// add an animation curve to the spot light (see AddPointLightAnimation)
+
+	SpotLights& lights = GetSpotLights();
+	const ptrdiff_t idx = lights.sparse_.GetIdx(id);
+
+	Assert::True(idx != -1, "there is no spot light by id: " + std::to_string(id));
+
+	const SpotLight& light = lights.data_[idx];
+	AddAnimation(pLightComponent_->spotLightsAnims_, id, (u32)idx, light.diffuse_, light.specular_, params);
+}
+
+///////////////////////////////////////////////////////////
+
+template <class TLight>
+static void ApplyAnimations(
+	const LightAnimations& anims,
+	std::vector<TLight>& lights,
+	LightsDirtyRange& dirtyRange)
+{
+	// write evaluated curves into lights by data idxs;
+	// only lights which were really changed get into the dirty range
+
+	for (size i = 0; i < anims.GetCount(); ++i)
 	{
-		SetPointLightProp(pointLights.ids_[idx], ECS::LightProps::POSITION, {x,y,z});
+		const u32 dataIdx = anims.dataIdxs_[i];
+		TLight& light = lights[dataIdx];
+
+		if (anims.types_[i] == LIGHT_ANIM_ORBIT)
+		{
+			const XMFLOAT3 pos = { anims.positionsX_[i], anims.positionsY_[i], anims.positionsZ_[i] };
+
+			if (memcmp(&pos, &light.position_, sizeof(XMFLOAT3)) == 0)
+				continue;
+
+			light.position_ = pos;
+		}
+		else
+		{
+			const float     factor = (anims.types_[i] == LIGHT_ANIM_PULSE) ? anims.pulses_[i] : anims.flickers_[i];
+			const XMFLOAT4& baseDiff = anims.baseDiffuses_[i];
+			const XMFLOAT4& baseSpec = anims.baseSpeculars_[i];
+
+			const XMFLOAT4 diffuse  = { baseDiff.x * factor, baseDiff.y * factor, baseDiff.z * factor, baseDiff.w };
+			const XMFLOAT4 specular = { baseSpec.x * factor, baseSpec.y * factor, baseSpec.z * factor, baseSpec.w };
+
+			if ((memcmp(&diffuse, &light.diffuse_, sizeof(XMFLOAT4)) == 0) &&
+				(memcmp(&specular, &light.specular_, sizeof(XMFLOAT4)) == 0))
+				continue;
+
+			light.diffuse_  = diffuse;
+			light.specular_ = specular;
+		}
+
+		dirtyRange.Add(dataIdx);
 	}
 }
 
 ///////////////////////////////////////////////////////////
 
-void LightSystem::UpdateSpotLights(const XMFLOAT3& pos, const XMFLOAT3& dir)
+void LightSystem::UpdateAnimations(const float totalGameTime)
 {
+	// evaluate curves of all the animations in one pass over SoA arrays
+	// and then write results into lights
+
+	Light& comp = *pLightComponent_;
+	PointLights& pointLights = GetPointLights();
 	SpotLights& spotLights = GetSpotLights();
-	SpotLight& flashlight = spotLights.data_[0];
 
-	// the spotlight takes on the camera position and is aimed in the same direction 
-	// the camera is looking. In this way, it looks like we are holding a flashlight
-	flashlight.position_ = pos;
-	flashlight.direction_ = dir;
+	EvaluateCurves(comp.pointLightsAnims_, totalGameTime);
+	EvaluateCurves(comp.spotLightsAnims_, totalGameTime);
+
+	ApplyAnimations(comp.pointLightsAnims_, pointLights.data_, pointLights.dirtyRange_);
+	ApplyAnimations(comp.spotLightsAnims_, spotLights.data_, spotLights.dirtyRange_);
 }
 
 
@@ -486,6 +633,23 @@ void LightSystem::UpdateSpotLights(const XMFLOAT3& pos, const XMFLOAT3& dir)
 //                      PUBLIC QUERY API FOR DIRECTIONAL LIGHT SOURCES
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
+const LightsDirtyRange& LightSystem::GetDirtyRange(const LightTypes type) const
+{
+	switch (type)
+	{
+		case DIRECTIONAL:
+			return pLightComponent_->dirLights_.dirtyRange_;
+		case POINT:
+			return pLightComponent_->pointLights_.dirtyRange_;
+		case SPOT:
+			return pLightComponent_->spotLights_.dirtyRange_;
+		default:
+			throw LIB_Exception("unknown type of light source: " + std::to_string(type));
+	}
+}
+
+///////////////////////////////////////////////////////////
+
 const ptrdiff_t LightSystem::GetLightsNum(const LightTypes type) const
 {
 	switch (type)
@@ -531,12 +695,7 @@ void LightSystem::operator delete(void* p)
 bool LightSystem::CheckCanAddRecords(const std::vector<EntityID>& ids)
 {
 	// check if we can add records by IDs
-	bool canAddRecords = true;
-
-	for (const EntityID& id : ids)
-		canAddRecords &= (!BinarySearch(pLightComponent_->ids_, id));
-
-	return canAddRecords;
+	return !pLightComponent_->sparse_.HasAny(ids);
 }
 
 void LightSystem::CheckInputParams(const std::vector<EntityID>& ids, DirLightsInitParams& params)
@@ -559,10 +718,176 @@ void LightSystem::CheckIdExist(const EntityID id, const std::string& errorMsg)
 	// check if there is such an ID in the component;
 	// if there is no such ID we throw an exception with errorMsg;
 
-	bool compHasLightByID = Utils::BinarySearch(pLightComponent_->ids_, id);
+	bool compHasLightByID = pLightComponent_->sparse_.Has(id);
 	Assert::True(compHasLightByID, errorMsg);
 }
 
+///////////////////////////////////////////////////////////
+
+void LightSystem::AddAnimation(
+	LightAnimations& anims,
+	const EntityID id,
+	const u32 dataIdx,
+	const XMFLOAT4& diffuse,
+	const XMFLOAT4& specular,
+	const LightAnimParams& params)
+{
+	const size count = anims.GetCount();
+
+	anims.ids_.push_back(id);
+	anims.dataIdxs_.push_back(dataIdx);
+	anims.types_.push_back(params.type);
+	anims.baseDiffuses_.push_back(diffuse);
+	anims.baseSpeculars_.push_back(specular);
+
+	// put params right after the last animation (instead of padding)
+	const float values[] = { params.center.x, params.center.y, params.center.z, params.radius, params.speed, params.phase, params.amplitude };
+	std::vector<float>* arrs[] = { &anims.centersX_, &anims.centersY_, &anims.centersZ_, &anims.radiuses_, &anims.speeds_, &anims.phases_, &anims.amplitudes_ };
+
+	for (int i = 0; i < 7; ++i)
+	{
+		arrs[i]->resize(count);
+		arrs[i]->push_back(values[i]);
+	}
+
+	PadAnimations(anims);
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::RemoveAnimations(LightAnimations& anims, const SparseSet& lightsSparse)
+{
+	// remove animations of removed lights and update data idxs of animated lights
+	// (which could be changed after removing of other lights)
+
+	std::vector<float>* arrs[] = { &anims.centersX_, &anims.centersY_, &anims.centersZ_, &anims.radiuses_, &anims.speeds_, &anims.phases_, &anims.amplitudes_ };
+	size count = 0;
+
+	for (size i = 0; i < anims.GetCount(); ++i)
+	{
+		const ptrdiff_t dataIdx = lightsSparse.GetIdx(anims.ids_[i]);
+
+		if (dataIdx == -1)
+			continue;
+
+		anims.ids_[count]           = anims.ids_[i];
+		anims.dataIdxs_[count]      = (u32)dataIdx;
+		anims.types_[count]         = anims.types_[i];
+		anims.baseDiffuses_[count]  = anims.baseDiffuses_[i];
+		anims.baseSpeculars_[count] = anims.baseSpeculars_[i];
+
+		for (std::vector<float>* arr : arrs)
+			(*arr)[count] = (*arr)[i];
+
+		++count;
+	}
+
+	anims.ids_.resize(count);
+	anims.dataIdxs_.resize(count);
+	anims.types_.resize(count);
+	anims.baseDiffuses_.resize(count);
+	anims.baseSpeculars_.resize(count);
+
+	for (std::vector<float>* arr : arrs)
+		arr->resize(count);
+
+	PadAnimations(anims);
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::SetAnimationsBaseColor(
+	LightAnimations& anims,
+	const EntityID id,
+	const LightProps prop,
+	const XMFLOAT4& color)
+{
+	// pulse/flicker scale base colors of the light so a new color must become
+	// the base one of each its animation (otherwise the next update overwrites it);
+	// colors are set rarely so we simply go through all the animations
+
+	std::vector<XMFLOAT4>& baseColors = (prop == LightProps::DIFFUSE) ? anims.baseDiffuses_ : anims.baseSpeculars_;
+
+	for (size i = 0; i < anims.GetCount(); ++i)
+	{
+		if (anims.ids_[i] == id)
+			baseColors[i] = color;
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::PadAnimations(LightAnimations& anims)
+{
+	// pad SoA arrays with zeros to a multiple of 4
+
+	const size paddedCount = (anims.GetCount() + 3) & ~3;
+
+	std::vector<float>* arrs[] =
+	{
+		&anims.centersX_, &anims.centersY_, &anims.centersZ_, &anims.radiuses_, &anims.speeds_, &anims.phases_, &anims.amplitudes_,
+		&anims.positionsX_, &anims.positionsY_, &anims.positionsZ_, &anims.pulses_, &anims.flickers_
+	};
+
+	for (std::vector<float>* arr : arrs)
+		arr->resize(paddedCount, 0.0f);
+}
+
+///////////////////////////////////////////////////////////
+
+void LightSystem::EvaluateCurves(LightAnimations& anims, const float totalGameTime)
+{
+	// evaluate all the curves of 4 animations at once (each animation uses only
+	// the curve of its type but it is cheaper to compute all of them than to branch)
+
+	const size paddedCount = std::ssize(anims.speeds_);
+
+	const XMVECTOR time     = XMVectorReplicate(totalGameTime);
+	const XMVECTOR one      = XMVectorReplicate(1.0f);
+	const XMVECTOR half     = XMVectorReplicate(0.5f);
+	const XMVECTOR freq1    = XMVectorReplicate(2.7f);
+	const XMVECTOR freq2    = XMVectorReplicate(5.9f);
+	const XMVECTOR shift1   = XMVectorReplicate(1.3f);
+	const XMVECTOR shift2   = XMVectorReplicate(2.1f);
+	const XMVECTOR weight0  = XMVectorReplicate(0.5f);
+	const XMVECTOR weight1  = XMVectorReplicate(0.3f);
+	const XMVECTOR weight2  = XMVectorReplicate(0.2f);
+
+	for (size i = 0; i < paddedCount; i += 4)
+	{
+		const XMVECTOR radius    = XMLoadFloat4((const XMFLOAT4*)&anims.radiuses_[i]);
+		const XMVECTOR amplitude = XMLoadFloat4((const XMFLOAT4*)&anims.amplitudes_[i]);
+		const XMVECTOR angle     = XMVectorMultiplyAdd(
+			XMLoadFloat4((const XMFLOAT4*)&anims.speeds_[i]),
+			time,
+			XMLoadFloat4((const XMFLOAT4*)&anims.phases_[i]));
+
+		XMVECTOR sinAngle;
+		XMVECTOR cosAngle;
+		XMVectorSinCos(&sinAngle, &cosAngle, angle);
+
+		// orbit: a horizontal circle around the center
+		XMStoreFloat4((XMFLOAT4*)&anims.positionsX_[i], XMVectorMultiplyAdd(radius, cosAngle, XMLoadFloat4((const XMFLOAT4*)&anims.centersX_[i])));
+		XMStoreFloat4((XMFLOAT4*)&anims.positionsY_[i], XMLoadFloat4((const XMFLOAT4*)&anims.centersY_[i]));
+		XMStoreFloat4((XMFLOAT4*)&anims.positionsZ_[i], XMVectorMultiplyAdd(radius, sinAngle, XMLoadFloat4((const XMFLOAT4*)&anims.centersZ_[i])));
+
+		// pulse: the intensity factor is in [1 - amplitude, 1 + amplitude]
+		XMStoreFloat4((XMFLOAT4*)&anims.pulses_[i], XMVectorMultiplyAdd(amplitude, sinAngle, one));
+
+		// flicker: a sum of sines with incommensurable frequencies looks irregular;
+		// the noise is in [0, 1] and the intensity falls down by amplitude * noise
+		const XMVECTOR noise = XMVectorAdd(
+			XMVectorAdd(
+				XMVectorMultiply(weight0, sinAngle),
+				XMVectorMultiply(weight1, XMVectorSin(XMVectorMultiplyAdd(angle, freq1, shift1)))),
+			XMVectorMultiply(weight2, XMVectorSin(XMVectorMultiplyAdd(angle, freq2, shift2))));
+
+		const XMVECTOR noise01 = XMVectorMultiplyAdd(noise, half, half);
+
+		XMStoreFloat4((XMFLOAT4*)&anims.flickers_[i], XMVectorNegativeMultiplySubtract(amplitude, noise01, one));
+	}
+}
+
 
 };
 
@@ -43,12 +43,23 @@ public:
 	void AddDirLights  (const std::vector<EntityID>& ids, DirLightsInitParams& params);
 	void AddPointLights(const std::vector<EntityID>& ids, PointLightsInitParams& params);
 	void AddSpotLights (const std::vector<EntityID>& ids, SpotLightsInitParams& params);
+
+	void RemoveRecords(const std::vector<EntityID>& ids);
 		
 	// Public update API
 	void Update(const float deltaTime, const float totalGameTime);
 	void UpdateDirLights(const float deltaTime, const float totalGameTime);
-	void UpdatePointLights(const float deltaTime, const float totalGameTime);
 	void UpdateSpotLights(const XMFLOAT3& pos, const XMFLOAT3& dir);
+
+	// Public batched animation API: lights are animated by data idxs (without lookups
+	// of IDs) and curves of all the animations are evaluated at once over SoA arrays
+	void AddPointLightAnimation(const EntityID id, const LightAnimParams& params);
+	void AddSpotLightAnimation(const EntityID id, const LightAnimParams& params);
+	void UpdateAnimations(const float totalGameTime);
+
+	// data idxs of lights which were changed since the last reset of dirty ranges
+	const LightsDirtyRange& GetDirtyRange(const LightTypes type) const;
+	void ResetDirtyRanges();
 	
 	// Public modificators API
 	void SetDirLightProp(const EntityID id, const LightProps prop, const XMFLOAT4& val);
@@ -79,6 +90,25 @@ private:
 	void CheckInputParams(const std::vector<EntityID>& ids, DirLightsInitParams& params);
 	void CheckIdExist(const EntityID id, const std::string& errorMsg);
 
+	void AddAnimation(
+		LightAnimations& anims,
+		const EntityID id,
+		const u32 dataIdx,
+		const XMFLOAT4& diffuse,
+		const XMFLOAT4& specular,
+		const LightAnimParams& params);
+
+	void RemoveAnimations(LightAnimations& anims, const SparseSet& lightsSparse);
+
+	void SetAnimationsBaseColor(
+		LightAnimations& anims,
+		const EntityID id,
+		const LightProps prop,
+		const XMFLOAT4& color);
+
+	void PadAnimations(LightAnimations& anims);
+	void EvaluateCurves(LightAnimations& anims, const float totalGameTime);
+
 	Light* pLightComponent_ = nullptr;
 };
 
@@ -1,15 +1,12 @@
 #include "MeshSystem.h"
 
 #include "../Common/Assert.h"
-#include "../Common/UtilsFilesystem.h"
 #include "../Common/Utils.h"
 
-#include "SaveLoad/MeshSysSerDeser.h"
-
 #include <stdexcept>
+#include <algorithm>
 #include <numeric>      // to use std::accumulate()
 
-#include <ranges>
 #include <set>
 
 namespace ECS
@@ -24,28 +21,6 @@ MeshSystem::MeshSystem(MeshComponent* pMeshComponent)
 
 ///////////////////////////////////////////////////////////
 
-void MeshSystem::Serialize(std::ofstream& fout, u32& offset)
-{
-	MeshSysSerDeser::Serialize(
-		fout,
-		offset,
-		static_cast<u32>(ComponentType::MeshComp),  // data block marker
-		pMeshComponent_->enttToMeshes_);
-}
-
-///////////////////////////////////////////////////////////
-
-void MeshSystem::Deserialize(std::ifstream& fin, const u32 offset)
-{
-	MeshSysSerDeser::Deserialize(
-		fin,
-		offset,
-		pMeshComponent_->enttToMeshes_,
-		pMeshComponent_->meshToEntts_);
-}
-
-///////////////////////////////////////////////////////////
-
 void MeshSystem::AddRecords(
 	const std::vector<EntityID>& enttsIDs,
 	const std::vector<MeshID>& meshesIDs)   // add this batch of meshes to each input entity
@@ -54,24 +29,106 @@ void MeshSystem::AddRecords(
 	// NOTICE: if there is already a record by some entity ID 
 	//         we just append the input batch of meshes to it;
 
-	// CheckInputData();
-
 	MeshComponent& comp = *pMeshComponent_;
+	std::vector<ptrdiff_t> existingIdxs;
 
-	// make relations 'entity_id' => 'set_of_meshes_ids'
-	for (const EntityID& enttID : enttsIDs)
-		Utils::AppendArray(comp.enttToMeshes_[enttID], meshesIDs);
+	comp.ids_.reserve(comp.ids_.size() + enttsIDs.size());
+	comp.enttsOffsets_.reserve(comp.enttsOffsets_.size() + enttsIDs.size());
+	comp.enttsMeshes_.reserve(comp.enttsMeshes_.size() + enttsIDs.size() * meshesIDs.size());
 
-	// make relations 'mesh_id' => 'set_of_entts_ids'
-	for (const MeshID& meshID : meshesIDs)
-		Utils::AppendArray(comp.meshToEntts_[meshID], enttsIDs);
+	// make relations 'entity_id' => 'set_of_meshes_ids' for new entities
+	// (records are just appended to the end of the flat arrays)
+	for (const EntityID enttID : enttsIDs)
+	{
+		const ptrdiff_t idx = comp.sparse_.GetIdx(enttID);
+
+		if (idx != -1)
+		{
+			existingIdxs.push_back(idx);
+			continue;
+		}
+
+		comp.sparse_.Add(enttID, std::ssize(comp.ids_));
+		comp.ids_.push_back(enttID);
+
+		Utils::AppendArray(comp.enttsMeshes_, meshesIDs);
+		comp.enttsOffsets_.push_back((u32)comp.enttsMeshes_.size());
+	}
+
+	if (!existingIdxs.empty())
+		AppendMeshesToExistingEntts(existingIdxs, meshesIDs);
+
+	// relations 'mesh_id' => 'set_of_entts_ids' will be rebuilt when we need them
+	comp.isMeshToEnttsDirty_ = true;
 }
 
 ///////////////////////////////////////////////////////////
 
-void MeshSystem::RemoveRecord(const std::vector<EntityID>& enttsIDs)
+void MeshSystem::RemoveRecords(const std::vector<EntityID>& enttsIDs)
 {
-	Assert::True(false, "TODO: IMPLEMENT IT!");
+	// remove relations between input entities and their meshes;
+	// (IDs of entities which don't have this component are skipped)
+	//
+	// the whole batch is removed at once: the flat arrays are compacted
+	// in a single pass and the order of the rest of records is preserved
+
+	MeshComponent& comp = *pMeshComponent_;
+	bool hasRemoved = false;
+
+	enttsMarks_.resize(comp.ids_.size(), 0);
+
+	for (const EntityID enttID : enttsIDs)
+	{
+		const ptrdiff_t idx = comp.sparse_.GetIdx(enttID);
+
+		if (idx == -1)
+			continue;
+
+		enttsMarks_[idx] = 1;
+		comp.sparse_.Remove(enttID);
+		hasRemoved = true;
+	}
+
+	if (!hasRemoved)
+		return;
+
+	// ---------------------------------------------
+
+	const size enttsCount = std::ssize(comp.ids_);
+	size dstIdx = 0;
+	u32 dstMeshIdx = 0;
+
+	for (size srcIdx = 0; srcIdx < enttsCount; ++srcIdx)
+	{
+		// NOTE: read the range before writing since dstIdx <= srcIdx
+		const u32 begin = comp.enttsOffsets_[srcIdx];
+		const u32 end   = comp.enttsOffsets_[srcIdx + 1];
+
+		if (enttsMarks_[srcIdx])
+		{
+			enttsMarks_[srcIdx] = 0;
+			continue;
+		}
+
+		for (u32 i = begin; i < end; ++i)
+			comp.enttsMeshes_[dstMeshIdx++] = comp.enttsMeshes_[i];
+
+		// move the record and rebind its ID to a new data idx
+		if (dstIdx != srcIdx)
+		{
+			comp.ids_[dstIdx] = comp.ids_[srcIdx];
+			comp.sparse_.Add(comp.ids_[dstIdx], dstIdx);
+		}
+
+		comp.enttsOffsets_[dstIdx + 1] = dstMeshIdx;
+		++dstIdx;
+	}
+
+	comp.ids_.resize(dstIdx);
+	comp.enttsOffsets_.resize(dstIdx + 1);
+	comp.enttsMeshes_.resize(dstMeshIdx);
+
+	comp.isMeshToEnttsDirty_ = true;
 }
 
 ///////////////////////////////////////////////////////////
@@ -79,13 +136,10 @@ void MeshSystem::RemoveRecord(const std::vector<EntityID>& enttsIDs)
 void MeshSystem::GetAllMeshesIDsFromMeshComponent(std::vector<MeshID>& outMeshesIDs)
 {
 	// get all the meshes IDs from the Mesh component;
-	// out: array of meshes IDs
-
-	const MeshComponent& comp = *pMeshComponent_;
-	outMeshesIDs.resize(comp.meshToEntts_.size());
+	// out: array of meshes IDs (sorted)
 
-	for (int idx = 0; const auto& it : comp.meshToEntts_)
-		outMeshesIDs[idx++] = it.first;
+	RebuildMeshToEnttsIfNeeded();
+	outMeshesIDs = pMeshComponent_->meshesIDs_;
 }
 
 ///////////////////////////////////////////////////////////
@@ -95,11 +149,7 @@ void MeshSystem::GetEnttsIDsFromMeshComponent(std::vector<EntityID>& outEnttsIDs
 	// get only unique IDs of all the entities which the Mesh component has;
 	// out: array of entities IDs
 
-	const MeshComponent& comp = *pMeshComponent_;
-	outEnttsIDs.resize(std::ssize(comp.enttToMeshes_));
-
-	for (int idx = 0; const auto& it : comp.enttToMeshes_)
-		outEnttsIDs[idx++] = it.first;
+	outEnttsIDs = pMeshComponent_->ids_;
 }
 
 ///////////////////////////////////////////////////////////
@@ -115,34 +165,160 @@ void MeshSystem::GetMeshesIDsRelatedToEntts(
 	// out: 1) arr of meshes which are related to the input entities
 	//      2) arr of entts sorted by its meshes
 	//      3) arr of entts number per mesh
+	//
+	// NOTE: we mark input entities and go through the 'mesh => entities' mapping
+	//       which is already sorted by meshes so there is no sorting here;
+	//       entities of the same mesh go in order of records of the component
+
+	RebuildMeshToEnttsIfNeeded();
 
-	
-	const MeshComponent& component = *pMeshComponent_;
-	std::map<MeshID, std::vector<EntityID>> meshToEntts;
+	const MeshComponent& comp = *pMeshComponent_;
+
+	outMeshesIDs.clear();
+	outEnttsSortByMeshes.clear();
+	outNumInstancesPerMesh.clear();
+
+	enttsMarks_.resize(comp.ids_.size(), 0);
 
-	// get all the IDs of related meshes
+	// mark input entities (entts without meshes are skipped)
 	for (const EntityID enttID : enttsIDs)
 	{
-		for (const MeshID meshID : component.enttToMeshes_.find(enttID)->second)
-			meshToEntts[meshID].push_back(enttID);
+		const ptrdiff_t idx = comp.sparse_.GetIdx(enttID);
+
+		if (idx != -1)
+			enttsMarks_[idx] = 1;
 	}
 
-	// get array of meshes IDs
-	const auto keys = std::views::keys(meshToEntts);
-	outMeshesIDs = { keys.begin(), keys.end() };
+	outEnttsSortByMeshes.reserve(std::ssize(enttsIDs));
 
-	// ---------------------------------------------
+	for (size meshIdx = 0; meshIdx < std::ssize(comp.meshesIDs_); ++meshIdx)
+	{
+		const size firstInstance = std::ssize(outEnttsSortByMeshes);
 
-	outEnttsSortByMeshes.reserve(std::ssize(enttsIDs));
-	outNumInstancesPerMesh.resize(std::ssize(meshToEntts));
+		for (u32 i = comp.meshesOffsets_[meshIdx]; i < comp.meshesOffsets_[meshIdx + 1]; ++i)
+		{
+			const u32 enttIdx = comp.meshesEntts_[i];
+
+			if (enttsMarks_[enttIdx])
+				outEnttsSortByMeshes.push_back(comp.ids_[enttIdx]);
+		}
+
+		// there are some input entts with this mesh
+		const size instancesCount = std::ssize(outEnttsSortByMeshes) - firstInstance;
+
+		if (instancesCount > 0)
+		{
+			outMeshesIDs.push_back(comp.meshesIDs_[meshIdx]);
+			outNumInstancesPerMesh.push_back(instancesCount);
+		}
+	}
+
+	// clear the marks so they can be reused
+	for (const EntityID enttID : enttsIDs)
+	{
+		const ptrdiff_t idx = comp.sparse_.GetIdx(enttID);
+
+		if (idx != -1)
+			enttsMarks_[idx] = 0;
+	}
+}
+
+
+
+// *********************************************************************************
+//
+//                              PRIVATE HELPERS
+//
+// *********************************************************************************
+
+void MeshSystem::AppendMeshesToExistingEntts(
+	const std::vector<ptrdiff_t>& dataIdxs,
+	const std::vector<MeshID>& meshesIDs)
+{
+	// append the batch of meshes to each entity by input data idxs;
+	// the flat arr of meshes is rebuilt in a single pass for the whole batch
+
+	MeshComponent& comp = *pMeshComponent_;
+	const size enttsCount = std::ssize(comp.ids_);
+
+	enttsMarks_.resize(enttsCount, 0);
+
+	for (const ptrdiff_t idx : dataIdxs)
+		enttsMarks_[idx] = 1;
+
+	std::vector<MeshID> enttsMeshes;
+	enttsMeshes.reserve(comp.enttsMeshes_.size() + dataIdxs.size() * meshesIDs.size());
+
+	// NOTE: offsets are overwritten in place so we keep the old end of the previous record
+	u32 begin = 0;
+
+	for (size idx = 0; idx < enttsCount; ++idx)
+	{
+		const u32 end = comp.enttsOffsets_[idx + 1];
+
+		enttsMeshes.insert(
+			enttsMeshes.end(),
+			comp.enttsMeshes_.begin() + begin,
+			comp.enttsMeshes_.begin() + end);
+
+		if (enttsMarks_[idx])
+		{
+			Utils::AppendArray(enttsMeshes, meshesIDs);
+			enttsMarks_[idx] = 0;
+		}
+
+		comp.enttsOffsets_[idx + 1] = (u32)enttsMeshes.size();
+		begin = end;
+	}
+
+	comp.enttsMeshes_ = std::move(enttsMeshes);
+}
+
+///////////////////////////////////////////////////////////
+
+void MeshSystem::RebuildMeshToEnttsIfNeeded()
+{
+	// rebuild the 'mesh => entities' mapping from the 'entity => meshes' mapping
+	// using the counting sort so entities of each mesh go in order of records
+
+	MeshComponent& comp = *pMeshComponent_;
+
+	if (!comp.isMeshToEnttsDirty_)
+		return;
+
+	// get sorted unique IDs of meshes
+	comp.meshesIDs_ = comp.enttsMeshes_;
+	std::sort(comp.meshesIDs_.begin(), comp.meshesIDs_.end());
+	comp.meshesIDs_.erase(std::unique(comp.meshesIDs_.begin(), comp.meshesIDs_.end()), comp.meshesIDs_.end());
+
+	const size meshesCount = std::ssize(comp.meshesIDs_);
+	const size enttsCount = std::ssize(comp.ids_);
+
+	auto getMeshIdx = [&comp](const MeshID meshID)
+	{
+		return std::lower_bound(comp.meshesIDs_.begin(), comp.meshesIDs_.end(), meshID) - comp.meshesIDs_.begin();
+	};
 
-	// get entts IDs sorted by meshes
-	for (const auto& it : meshToEntts)
-		Utils::AppendArray(outEnttsSortByMeshes, it.second);
+	// count entities per each mesh and compute offsets
+	comp.meshesOffsets_.assign(meshesCount + 1, 0);
+
+	for (const MeshID meshID : comp.enttsMeshes_)
+		++comp.meshesOffsets_[getMeshIdx(meshID) + 1];
+
+	for (size i = 0; i < meshesCount; ++i)
+		comp.meshesOffsets_[i + 1] += comp.meshesOffsets_[i];
+
+	// fill in the data idxs of entities for each mesh
+	std::vector<u32> fillPos(comp.meshesOffsets_.begin(), comp.meshesOffsets_.end() - 1);
+	comp.meshesEntts_.resize(comp.enttsMeshes_.size());
+
+	for (size enttIdx = 0; enttIdx < enttsCount; ++enttIdx)
+	{
+		for (u32 i = comp.enttsOffsets_[enttIdx]; i < comp.enttsOffsets_[enttIdx + 1]; ++i)
+			comp.meshesEntts_[fillPos[getMeshIdx(comp.enttsMeshes_[i])]++] = (u32)enttIdx;
+	}
 
-	// get the number of entts per each mesh
-	for (u32 idx = 0; const auto& it : meshToEntts)
-		outNumInstancesPerMesh[idx++] = std::ssize(it.second);
+	comp.isMeshToEnttsDirty_ = false;
 }
 
 ///////////////////////////////////////////////////////////
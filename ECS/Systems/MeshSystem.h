@@ -21,14 +21,11 @@ public:
 	MeshSystem(MeshComponent* pMeshComponent);
 	~MeshSystem() {}
 
-	void Serialize(std::ofstream& fout, u32& offset);
-	void Deserialize(std::ifstream& fin, const u32 offset);
-
 	void AddRecords(
 		const std::vector<EntityID>& enttsIDs,
 		const std::vector<MeshID>& meshesIDs);   // add this batch of meshes to each input entity
 
-	void RemoveRecord(const std::vector<EntityID>& enttsIDs);
+	void RemoveRecords(const std::vector<EntityID>& enttsIDs);
 
 	void GetAllMeshesIDsFromMeshComponent(std::vector<MeshID>& outMeshesIDs);
 	void GetEnttsIDsFromMeshComponent(std::vector<EntityID>& outEnttsIDs);
@@ -39,8 +36,16 @@ public:
 		std::vector<EntityID>& outEnttsSortByMeshes,
 		std::vector<size>& outNumInstancesPerMesh);
 
+private:
+	void AppendMeshesToExistingEntts(
+		const std::vector<ptrdiff_t>& dataIdxs,
+		const std::vector<MeshID>& meshesIDs);
+
+	void RebuildMeshToEnttsIfNeeded();
+
 private:
 	MeshComponent* pMeshComponent_ = nullptr;
+	std::vector<uint8_t> enttsMarks_;            // a flag per each record of the component (is reused by different methods)
 };
 
 }
\ No newline at end of file
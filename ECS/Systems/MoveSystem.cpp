@@ -10,7 +10,6 @@
 #include "../Common/log.h"
 #include "../Common/Utils.h"
 #include "./Helpers/MoveSystemUpdateHelpers.h"
-#include "SaveLoad/MoveSysSerDeser.h"
 
 #include <stdexcept>
 
@@ -22,149 +21,86 @@ namespace ECS
 
 MoveSystem::MoveSystem(
 	Transform* pTransformComponent,
-	WorldMatrix* pWorldMatrixComponent,
 	Movement* pMoveComponent)
 {
 	Assert::NotNullptr(pTransformComponent, "ptr to the Transform component == nullptr");
-	Assert::NotNullptr(pWorldMatrixComponent, "ptr to the WorldMatrix component == nullptr");
 	Assert::NotNullptr(pMoveComponent, "ptr to the Movement component == nullptr");
 
 	pTransformComponent_ = pTransformComponent;
-	pWorldMatComponent_ = pWorldMatrixComponent;
 	pMoveComponent_ = pMoveComponent;
 }
 
 
 // ********************************************************************************
 // 
-//                PUBLIC SERIALIZATION / DESERIALIZATION API
+//                              PUBLIC UPDATING API
 // 
 // ********************************************************************************
 
-void MoveSystem::Serialize(std::ofstream& fout, u32& offset)
+void MoveSystem::UpdateAllMoves(
+	const float deltaTime,
+	const EnttsQuery& query)
 {
-	const Movement& move = *pMoveComponent_;
-
-	MoveSysSerDeser::Serialize(
-		fout,
-		offset,
-		static_cast<u32>(move.type_),   // data block marker
-		move.ids_,
-		move.translationAndUniScales_,
-		move.rotationQuats_);
-}
+	// update transform data of each entity which has the Movement component;
+	// 
+	// in: query -- a query of entts with components: Movement + Transform
 
-///////////////////////////////////////////////////////////
-
-void MoveSystem::Deserialize(std::ifstream& fin, const u32 offset)
-{
-	Movement& move = *pMoveComponent_;
-
-	MoveSysSerDeser::Deserialize(
-		fin,
-		offset,
-		move.ids_,
-		move.translationAndUniScales_,
-		move.rotationQuats_);
+	UpdateMovesInRange(deltaTime, query, 0, query.Count(), pTransformComponent_->dirtyIdxs_);
 }
 
+///////////////////////////////////////////////////////////
 
-
-// ********************************************************************************
-// 
-//                              PUBLIC UPDATING API
-// 
-// ********************************************************************************
-
-void MoveSystem::UpdateAllMoves(
+void MoveSystem::UpdateMovesInRange(
 	const float deltaTime,
-	TransformSystem& transformSys)
+	const EnttsQuery& query,
+	const size begin,
+	const size end,
+	std::vector<u32>& outDirtyIdxs)
 {
-	const std::vector<EntityID>& enttsToMove = pMoveComponent_->ids_;
+	// update transform data of entities from the range [begin, end) of the query
+	// and mark them as dirty so the TransformSystem will rebuild their world matrices;
+	// each entity is updated independently so different ranges can be updated
+	// concurrently by different threads (each range must have its own output list);
+	// 
+	// NOTE: the data is updated IN PLACE right in the components arrays by data idxs
+	//       from the query so there are no searches, copies or heap allocations here;
+	// 
+	// in: query -- a query of entts with components: Movement + Transform
 
 	// if we don't have any entities to move we just go out
-	if (enttsToMove.size() == 0)
+	if (begin >= end)
 		return;
 
-	try
+	Transform& transform  = *pTransformComponent_;
+	Movement& movement    = *pMoveComponent_;
+
+	const ptrdiff_t* moveIdxs  = query.GetDataIdxs(MoveComponent).data();
+	const ptrdiff_t* transIdxs = query.GetDataIdxs(TransformComponent).data();
+
+	XMFLOAT4* posAndUniScales          = transform.posAndUniformScale_.data();
+	XMVECTOR* dirQuats                 = transform.dirQuats_.data();
+	uint8_t*  dirtyFlags               = transform.dirtyFlags_.data();
+	const XMFLOAT4* transAndUniScales  = movement.translationAndUniScales_.data();
+	const XMVECTOR* rotQuats           = movement.rotationQuats_.data();
+
+	for (size i = begin; i < end; ++i)
 	{
-		Transform& transform = *pTransformComponent_;
-		Movement& movement = *pMoveComponent_;
-
-		std::vector<XMFLOAT3> positions;
-		std::vector<XMVECTOR> dirQuats;
-		std::vector<float> uniformScales;
-
-		std::vector<XMMATRIX> worldMatricesToUpdate;
-		std::vector<ptrdiff_t> transformDataIdxs;
-
-		// current transform data of entities as XMVECTORs
-		std::vector<XMVECTOR> positionsVec;
-		std::vector<XMVECTOR> scalesVec;
-
-		// current movement data (scaled according to the deltaTime)
-		std::vector<XMVECTOR> translationsVec;
-		std::vector<XMVECTOR> rotQuatsVec;        
-		std::vector<float> uniformScaleFactors;
-
-		// get entities transform data to update for this frame
-		transformSys.GetTransformDataOfEntts(
-			enttsToMove,
-			transformDataIdxs,
-			positions, 
-			dirQuats, 
-			uniformScales);
-
-		PrepareTransformData(
-			positions,
-			positionsVec);
-
-		PrepareMovementData( 
-			deltaTime,
-			movement.translationAndUniScales_,  // (x: trans_x, y: trans_y, z: trans_z, w: uniform_scale)
-			movement.rotationQuats_,
-			translationsVec,
-			rotQuatsVec,
-			uniformScaleFactors);
-
-		// compute new values of transform data using the movement data
-		ComputeTransformData(
+		const ptrdiff_t moveIdx  = moveIdxs[i];
+		const ptrdiff_t transIdx = transIdxs[i];
+
+		const bool isMoved = UpdateMovedEntt(
 			deltaTime,
-			translationsVec,
-			rotQuatsVec,
-			uniformScaleFactors,
-			positionsVec,
-			dirQuats, 
-			uniformScales);
-
-		// write updated transform data into the Transform component
-		transformSys.SetTransformDataByDataIdxs(
-			transformDataIdxs, 
-			positionsVec, 
-			dirQuats, 
-			uniformScales);
-
-		// ------------------------------------------------------
-
-		// get world matrices which will be updated according to new transform data;
-		transformSys.GetWorldMatricesByDataIdxs(transformDataIdxs, worldMatricesToUpdate);
-
-		// rebuild world matrices of that entities which were moved
-		ComputeWorldMatrices(
-			translationsVec, 
-			rotQuatsVec, 
-			uniformScaleFactors,
-			worldMatricesToUpdate);
-
-		// apply updated world matrices
-		transformSys.SetWorldMatricesByDataIdxs(
-			transformDataIdxs, 
-			worldMatricesToUpdate);
-	}
-	catch (const std::out_of_range& e)
-	{
-		Log::Error(e.what());
-		throw LIB_Exception("Went out of range during movement updating");
+			transAndUniScales[moveIdx],
+			rotQuats[moveIdx],
+			posAndUniScales[transIdx],
+			dirQuats[transIdx]);
+
+		// the dirty list must contain each idx only once
+		if (isMoved && !dirtyFlags[transIdx])
+		{
+			dirtyFlags[transIdx] = 1;
+			outDirtyIdxs.push_back((u32)transIdx);
+		}
 	}
 }
 
@@ -185,38 +121,37 @@ void MoveSystem::AddRecords(
 	Movement& component = *pMoveComponent_;
 
 	// check if there is no record with such entity ID
-	bool areEnttsIDsUnique = true;
-
-	for (const EntityID& id : enttsIDs)
-		areEnttsIDsUnique &= (!BinarySearch(component.ids_, id));
-	
+	bool areEnttsIDsUnique = !component.sparse_.HasAny(enttsIDs);
 	Assert::True(areEnttsIDsUnique, "there is already a record with some input ID (key)");
 
+	// append new records to the end of the data arrays
+	const ptrdiff_t firstDataIdx = std::ssize(component.ids_);
+	const ptrdiff_t newCapacity = firstDataIdx + std::ssize(enttsIDs);
 
-	// execute sorted insertion into the data arrays
-	for (u32 data_idx = 0; const EntityID& id : enttsIDs)
-	{	
-		const XMFLOAT4 translationAndUniScale{ 
-			translations[data_idx].x,
-			translations[data_idx].y, 
-			translations[data_idx].z, 
-			uniformScaleChanges[data_idx] };
+	component.ids_.reserve(newCapacity);
+	component.translationAndUniScales_.reserve(newCapacity);
+	component.rotationQuats_.reserve(newCapacity);
 
-		const ptrdiff_t insertAtPos = Utils::GetPosForID(component.ids_, id);
+	Utils::AppendArray(component.ids_, enttsIDs);
 
-		InsertAtPos(component.ids_, insertAtPos, id);
-		InsertAtPos(component.translationAndUniScales_, insertAtPos, translationAndUniScale);
-		InsertAtPos(component.rotationQuats_, insertAtPos, DirectX::XMQuaternionNormalize(rotationQuats[data_idx]));
+	for (u32 data_idx = 0; const XMFLOAT3& trans : translations)
+		component.translationAndUniScales_.emplace_back(trans.x, trans.y, trans.z, uniformScaleChanges[data_idx++]);
 
-		++data_idx;
-	}
+	for (const XMVECTOR& quat : rotationQuats)
+		component.rotationQuats_.emplace_back(DirectX::XMQuaternionNormalize(quat));
+
+	component.sparse_.Add(enttsIDs, firstDataIdx);
 }
 
 ///////////////////////////////////////////////////////////
 
 void MoveSystem::RemoveRecords(const std::vector<EntityID>& enttsIDs)
 {
-	throw LIB_Exception("TODO: IMPLEMENT IT!");
+	// remove records of input entities from the Movement component;
+	// (IDs of entities which don't have this component are skipped)
+
+	Movement& comp = *pMoveComponent_;
+	comp.sparse_.SwapAndPop(enttsIDs, comp.ids_, comp.translationAndUniScales_, comp.rotationQuats_);
 }
 
 ///////////////////////////////////////////////////////////
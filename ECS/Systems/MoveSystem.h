@@ -10,11 +10,12 @@
 // components
 #include "../Components/Movement.h"
 #include "../Components/Transform.h"
-#include "../Components/WorldMatrix.h"
 
 // systems
 #include "TransformSystem.h"
 
+#include "../Entity/EnttsQuery.h"
+
 namespace ECS
 {
 
@@ -23,14 +24,19 @@ class MoveSystem final
 public:
 	MoveSystem(
 		Transform* pTransformComponent,
-		WorldMatrix* pWorldMatComponent_,
 		Movement* pMoveComponent);
 	~MoveSystem() {}
 
-	void Serialize(std::ofstream& fout, u32& offset);
-	void Deserialize(std::ifstream& fin, const u32 offset);
+	void UpdateAllMoves(
+		const float deltaTime,
+		const EnttsQuery& query);      // entts with components: Movement + Transform
 
-	void UpdateAllMoves(const float deltaTime, TransformSystem& transformSys);
+	void UpdateMovesInRange(
+		const float deltaTime,
+		const EnttsQuery& query,
+		const size begin,              // range [begin, end) of entts in the query
+		const size end,
+		std::vector<u32>& outDirtyIdxs);  // data idxs of Transform records which became dirty
 
 	void AddRecords(
 		const std::vector<EntityID>& enttsIDs,
@@ -47,7 +53,6 @@ private:
 
 private:
 	Transform*   pTransformComponent_ = nullptr;
-	WorldMatrix* pWorldMatComponent_ = nullptr;
 	Movement*    pMoveComponent_ = nullptr;
 };
 
@@ -4,8 +4,6 @@
 #include "../Common/Utils.h"
 #include "../Common/log.h"
 
-#include "SaveLoad/NameSysSerDeser.h"
-
 namespace ECS
 {
 
@@ -18,49 +16,31 @@ NameSystem::NameSystem(Name* pNameComponent)
 
 ///////////////////////////////////////////////////////////
 
-void NameSystem::Serialize(std::ofstream& fout, u32& offset)
+void NameSystem::AddRecords(
+	const std::vector<EntityID>& ids,
+	const std::vector<EntityName>& names)
 {
-	const Name& component = *pNameComponent_;
-
-	NameSysSerDeser::Serialize(
-		fout, 
-		offset,
-		static_cast<u32>(component.type_),
-		component.ids_,
-		component.names_);
-}
+	// add name for each entity from the input arr
 
-///////////////////////////////////////////////////////////
+	CheckInputData(ids, names);
 
-void NameSystem::Deserialize(std::ifstream& fin, const u32 offset)
-{
+	// append new records to the end of the data arrays
 	Name& component = *pNameComponent_;
 
-	NameSysSerDeser::Deserialize(
-		fin,
-		offset,
-		component.ids_,
-		component.names_);
+	component.sparse_.Add(ids, std::ssize(component.ids_));
+	Utils::AppendArray(component.ids_, ids);
+	Utils::AppendArray(component.names_, names);
 }
 
 ///////////////////////////////////////////////////////////
 
-void NameSystem::AddRecords(
-	const std::vector<EntityID>& ids,
-	const std::vector<EntityName>& names)
+void NameSystem::RemoveRecords(const std::vector<EntityID>& enttsIDs)
 {
-	// add name for each entity from the input arr
-
-	CheckInputData(ids, names);
-
-	for (ptrdiff_t idx = 0; idx < std::ssize(ids); ++idx)
-	{
-		Name& component = *pNameComponent_;
-		const ptrdiff_t insertAt = Utils::GetPosForID(component.ids_, ids[idx]);
+	// remove records of input entities from the Name component;
+	// (IDs of entities which don't have this component are skipped)
 
-		Utils::InsertAtPos(component.ids_, insertAt, ids[idx]);
-		Utils::InsertAtPos(component.names_, insertAt, names[idx]);
-	}
+	Name& component = *pNameComponent_;
+	component.sparse_.SwapAndPop(enttsIDs, component.ids_, component.names_);
 }
 
 ///////////////////////////////////////////////////////////
@@ -96,12 +76,11 @@ EntityID NameSystem::GetIdByName(const EntityName& name)
 const EntityName& NameSystem::GetNameById(const EntityID& id) 
 {
 	const Name& comp = *pNameComponent_;
-	const bool exist = Utils::BinarySearch(comp.ids_, id);
-	const ptrdiff_t idx = Utils::FindIdxOfVal(comp.ids_, id);
+	const ptrdiff_t idx = comp.sparse_.GetIdx(id);
 
 	// if there is such an ID in the arr we return a responsible entity name;
 	// or in another case we return invalid value
-	return (exist) ? comp.names_[idx] : INVALID_ENTITY_NAME;
+	return (idx != -1) ? comp.names_[idx] : INVALID_ENTITY_NAME;
 }
 
 ///////////////////////////////////////////////////////////
@@ -118,7 +97,7 @@ void NameSystem::CheckInputData(
 	bool namesUnique = true;
 
 	// check ids are valid (entts doesn't have the Name component yet)
-	idsValid = !Utils::CheckValuesExistInSortedArr(component.ids_, ids);
+	idsValid = !component.sparse_.HasAny(ids);
 
 	// check names are valid
 	for (const EntityName& name : names)
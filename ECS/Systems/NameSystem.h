@@ -18,20 +18,17 @@ public:
 	NameSystem(Name* pNameComponent);
 	~NameSystem() {}
 
-	void Serialize(std::ofstream& fout, u32& offset);
-	void Deserialize(std::ifstream& fin, const u32 offset);
-
 	void AddRecords(
 		const std::vector<EntityID>& enttsIDs,
 		const std::vector<EntityName>& enttsNames);
 	
+	void RemoveRecords(const std::vector<EntityID>& enttsIDs);
+
 #if 0
 	// TODO
 	void RenameRecords(
 		const std::vector<EntityID>& enttsIDs,
 		const std::vector<EntityName>& newEnttsNames);
-
-	void RemoveRecords(const std::vector<EntityID>& enttsIDs);
 #endif
 
 	// for different debug purposes
@@ -96,13 +96,13 @@ void RenderStatesSystem::AddOrUpdate(
 	Assert::True(ids.size() == states.size(), "the number of IDs and states must be equal");
 	
 
-	// if all input entts are new we just execute sorted insertion 
-	// of new records into the component
+	// if all input entts are new we just append new records to the component
 	if (CheckEnttsAreNew(ids))
 	{
 		AddNewRecords(ids, states);
 	}
 	// some entts are new and some entts must be updates
+	else
 	{
 		std::vector<bool> isInComponent;
 		std::vector<EntityID> enttsToAdd;
@@ -111,8 +111,7 @@ void RenderStatesSystem::AddOrUpdate(
 		std::vector<RenderStatesTypesSet> statesToUpdate;
 
 		// define which entts are already in the component and which are not
-		for (const EntityID id : ids)
-			isInComponent.push_back(BinarySearch(pRSComponent_->ids_, id));
+		pRSComponent_->sparse_.GetExistingFlags(ids, isInComponent);
 
 		// separate entts (some we will just add, and other we have to update)
 		for (u32 idx = 0; idx < (u32)ids.size(); ++idx)
@@ -137,6 +136,17 @@ void RenderStatesSystem::AddOrUpdate(
 
 ///////////////////////////////////////////////////////////
 
+void RenderStatesSystem::RemoveRecords(const std::vector<EntityID>& ids)
+{
+	// remove render states of input entities;
+	// (IDs of entities which don't have this component are skipped)
+
+	RenderStates& comp = *pRSComponent_;
+	comp.sparse_.SwapAndPop(ids, comp.ids_, comp.statesHashes_);
+}
+
+///////////////////////////////////////////////////////////
+
 void RenderStatesSystem::AddNewRecords(
 	const std::vector<EntityID>& ids,
 	const std::vector<RenderStatesTypesSet>& states)
@@ -153,15 +163,12 @@ void RenderStatesSystem::AddNewRecords(
 			hashes[idx] |= (1 << state);
 	}
 
-	// add records
-	for (u32 idx = 0; idx < (u32)ids.size(); ++idx)
-	{
-		RenderStates& comp = *pRSComponent_;
-		const ptrdiff_t pos = GetPosForID(comp.ids_, ids[idx]);
+	// add records to the end of the data arrays
+	RenderStates& comp = *pRSComponent_;
 
-		InsertAtPos(comp.ids_, pos, ids[idx]);
-		InsertAtPos(comp.statesHashes_, pos, hashes[idx]);
-	}
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
+	AppendArray(comp.ids_, ids);
+	AppendArray(comp.statesHashes_, hashes);
 }
 
 ///////////////////////////////////////////////////////////
@@ -180,7 +187,7 @@ void RenderStatesSystem::UpdateRecords(
 	std::vector<u32> rsHashes(enttsCount, 0);
 
 	// get data idxs to input entts ids
-	Utils::GetIdxsInSortedArr(comp.ids_, ids, idxs);
+	comp.sparse_.GetIdxs(ids, idxs);
 
 	// get render states hashes which are related to the input entts
 	for (size i = 0; i < enttsCount; ++i)
@@ -263,7 +270,7 @@ void RenderStatesSystem::GetRenderStates(
 	std::vector<bool> isWithSpecRenderState;
 	const size idsCount = std::ssize(ids);
 
-	GetIdxsInSortedArr(component.ids_, ids, idxs);
+	component.sparse_.GetIdxs(ids, idxs);
 
 	// check if entt by such idx has any specific render state
 	isWithSpecRenderState.resize(idsCount);
@@ -418,7 +425,7 @@ void RenderStatesSystem::SeparateEnttsByBlendingStates(
 bool RenderStatesSystem::CheckEnttsAreNew(const std::vector<EntityID>& ids)
 {
 	// check if all input ids of entts don't exist in the component
-	return !CheckValuesExistInSortedArr(pRSComponent_->ids_, ids);
+	return !pRSComponent_->sparse_.HasAny(ids);
 }
 
 ///////////////////////////////////////////////////////////
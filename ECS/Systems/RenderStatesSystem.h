@@ -107,6 +107,8 @@ public:
 		const std::vector<EntityID>& ids,
 		const std::vector<std::set<RenderStatesTypes>>& states);
 
+	void RemoveRecords(const std::vector<EntityID>& ids);
+
 	void GetRenderStates(
 		const std::vector<EntityID>& ids,
 		EnttsRenderStatesData& outData);
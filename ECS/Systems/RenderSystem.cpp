@@ -7,13 +7,11 @@
 #include "RenderSystem.h"
 
 #include "../Common/Utils.h"
-#include "../Common/UtilsFilesystem.h"
 #include "../Common/log.h"
 #include "../Common/Assert.h"
 
 #include <unordered_set>
 #include <stdexcept>
-#include <fstream>
 #include <sstream>
 
 namespace ECS
@@ -41,64 +39,6 @@ RenderSystem::RenderSystem(
 //                            PUBLIC FUNCTIONS
 // *********************************************************************************
 
-void RenderSystem::Serialize(std::ofstream& fout, u32& offset)
-{
-	// serialize all the data from the Rendered component into the data file
-
-	// store offset of this data block so we will use it later for deserialization
-	offset = static_cast<u32>(fout.tellp());
-
-	Rendered& component = *pRenderComponent_;
-	const u32 dataBlockMarker = static_cast<u32>(pRenderComponent_->type_);
-	const u32 dataCount = (u32)std::ssize(component.ids_);
-
-	// write serialized data into the file
-	Utils::FileWrite(fout, &dataBlockMarker);
-	Utils::FileWrite(fout, &dataCount);
-
-	Utils::FileWrite(fout, component.ids_);
-	Utils::FileWrite(fout, component.shaderTypes_);
-	Utils::FileWrite(fout, component.primTopologies_);
-}
-
-/////////////////////////////////////////////////
-
-void RenderSystem::Deserialize(std::ifstream& fin, const u32 offset)
-{
-	// deserialize the data from the data file into the Rendered component
-	
-	// read data starting from this offset
-	fin.seekg(offset, std::ios_base::beg);
-
-	// check if we read the proper data block
-	u32 dataBlockMarker = 0;
-	Utils::FileRead(fin, &dataBlockMarker);
-
-	const bool isProperDataBlock = (dataBlockMarker == static_cast<u32>(ComponentType::RenderedComponent));
-	Assert::True(isProperDataBlock, "read wrong data block during deserialization of the Rendered component data from a file");
-
-	// ------------------------------------------
-
-	// read in how much data will we have
-	u32 dataCount = 0;
-	Utils::FileRead(fin, &dataCount);
-
-	std::vector<EntityID>& ids = pRenderComponent_->ids_;
-	std::vector<RENDERING_SHADERS>& shaderTypes = pRenderComponent_->shaderTypes_;
-	std::vector<D3D11_PRIMITIVE_TOPOLOGY>& topologies = pRenderComponent_->primTopologies_;
-
-	// prepare enough amount of memory for data
-	ids.resize(dataCount);
-	shaderTypes.resize(dataCount);
-	topologies.resize(dataCount);
-
-	Utils::FileRead(fin, ids);
-	Utils::FileRead(fin, shaderTypes);
-	Utils::FileRead(fin, topologies);
-}
-
-/////////////////////////////////////////////////
-
 void RenderSystem::AddRecords(
 	const std::vector<EntityID>& enttsIDs, 
 	const std::vector<RENDERING_SHADERS>& shaderTypes,
@@ -112,14 +52,14 @@ void RenderSystem::AddRecords(
 	for (u32 idx = 0; idx < enttsIDs.size(); ++idx)
 	{
 		// check if there is no record with such entity ID
-		if (!std::binary_search(component.ids_.begin(), component.ids_.end(), enttsIDs[idx]))
+		if (!component.sparse_.Has(enttsIDs[idx]))
 		{
-			// execute sorted insertion into the data arrays
-			const ptrdiff_t insertAtPos = Utils::GetPosForID(component.ids_, enttsIDs[idx]);
+			// append a new record to the end of the data arrays
+			component.sparse_.Add(enttsIDs[idx], std::ssize(component.ids_));
 
-			Utils::InsertAtPos<EntityID>(component.ids_, insertAtPos, enttsIDs[idx]);
-			Utils::InsertAtPos<RENDERING_SHADERS>(component.shaderTypes_, insertAtPos, shaderTypes[idx]);
-			Utils::InsertAtPos<D3D11_PRIMITIVE_TOPOLOGY>(component.primTopologies_, insertAtPos, topologyTypes[idx]);
+			component.ids_.push_back(enttsIDs[idx]);
+			component.shaderTypes_.push_back(shaderTypes[idx]);
+			component.primTopologies_.push_back(topologyTypes[idx]);
 		}
 	}	
 }
@@ -128,15 +68,14 @@ void RenderSystem::AddRecords(
 
 void RenderSystem::RemoveRecords(const std::vector<EntityID>& enttsIDs)
 {
-#if 0
-	std::vector<entitiesName>& enttsIDs = pRenderComponent_->entitiesIDs_;
+	// remove records of input entities from the Rendered component;
+	// (IDs of entities which don't have this component are skipped)
 
-	const ptrdiff_t enttIdx = GetIdxOfEntityByID(enttsIDs, entitiesName);
+	Rendered& comp = *pRenderComponent_;
+	comp.sparse_.SwapAndPop(enttsIDs, comp.ids_, comp.shaderTypes_, comp.primTopologies_);
 
-	pRenderComponent_->renderingShaderType_.push_back(shaderType);
-	pRenderComponent_->usePrimTopoECS::Logy_.push_back(primTopoECS::Logy);
-	pRenderComponent_->entitiesForRendering_.erase(entitiesName);
-#endif
+	// removed entities can't be visible anymore
+	std::erase_if(comp.visibleEnttsIDs_, [&comp](const EntityID id) { return !comp.sparse_.Has(id); });
 }
 
 /////////////////////////////////////////////////
@@ -173,18 +112,15 @@ void RenderSystem::GetShaderTypesOfEntts(
 {
 	// get shader types of each input entity by its ID;
 	// 
-	// in:  SORTED array of entities IDs
+	// in:  array of entities IDs
 	// out: array of rendering shader types
 
 	
 	std::vector<ptrdiff_t> idxs; 
-
-	idxs.reserve(std::ssize(enttsIDs));
 	outShaderTypes.reserve(std::ssize(enttsIDs));
 
 	// get index into array of each input entity by ID
-	for (const EntityID& enttID : enttsIDs)
-		idxs.push_back(Utils::GetIdxInSortedArr(pRenderComponent_->ids_, enttID));
+	pRenderComponent_->sparse_.GetIdxs(enttsIDs, idxs);
 
 	// get shader type of each input entity
 	for (const ptrdiff_t idx : idxs)
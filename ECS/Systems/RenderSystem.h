@@ -31,9 +31,6 @@ public:
 		MeshComponent* pMeshComponent);
 	~RenderSystem() {}
 
-	void Serialize(std::ofstream& fout, u32& offset);
-	void Deserialize(std::ifstream& fin, const u32 offset);
-
 	void AddRecords(
 		const std::vector<EntityID>& enttsIDs,
 		const std::vector<ECS::RENDERING_SHADERS>& shaderTypes,
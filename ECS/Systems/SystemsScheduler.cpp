@@ -0,0 +1,84 @@
+// *********************************************************************************
+// Filename:     SystemsScheduler.cpp
+// Description:  implementation of the scheduler of per-frame ECS systems updates
+//
+// Created:      17.10.26
+// *********************************************************************************
+#include "SystemsScheduler.h"
+#include "../Common/Assert.h"
+
+namespace ECS
+{
+
+void SystemsScheduler::AddSystem(
+	const SystemID& name,
+	const ComponentsHash readComponents,
+	const ComponentsHash writeComponents,
+	SystemFunc&& func)
+{
+	// register a system and put it into the execution wave right after
+	// the last wave which contains a system conflicting with this one
+
+	Assert::True(func != nullptr, "there is no update function for the system: " + name);
+
+	SystemJob job{ name, readComponents, writeComponents, std::move(func) };
+	u32 waveIdx = 0;
+
+	for (size i = 0; i < std::ssize(systems_); ++i)
+	{
+		if (AreConflicting(systems_[i], job))
+			waveIdx = std::max(waveIdx, systemsWaves_[i] + 1);
+	}
+
+	if (waveIdx >= (u32)waves_.size())
+		waves_.resize(waveIdx + 1);
+
+	waves_[waveIdx].push_back((u32)systems_.size());
+	systemsWaves_.push_back(waveIdx);
+	systems_.push_back(std::move(job));
+}
+
+///////////////////////////////////////////////////////////
+
+void SystemsScheduler::Run(
+	ThreadPool& pool,
+	const float totalGameTime,
+	const float deltaTime)
+{
+	// execute updates of all the registered systems: waves go one after another
+	// and systems of the same wave are executed concurrently
+
+	for (const std::vector<u32>& wave : waves_)
+	{
+		// there is nothing to run in parallel
+		if ((wave.size() == 1) || pool.IsSingleThreaded())
+		{
+			for (const u32 sysIdx : wave)
+				systems_[sysIdx].func(totalGameTime, deltaTime);
+
+			continue;
+		}
+
+		TaskGroup group;
+
+		for (const u32 sysIdx : wave)
+		{
+			const SystemFunc* pFunc = &systems_[sysIdx].func;
+			pool.Submit(group, [pFunc, totalGameTime, deltaTime]() { (*pFunc)(totalGameTime, deltaTime); });
+		}
+
+		pool.Wait(group);
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+bool SystemsScheduler::AreConflicting(const SystemJob& sys1, const SystemJob& sys2) const
+{
+	// systems conflict if one of them writes some component
+	// which is read or written by the other one
+
+	return (sys1.writes & (sys2.reads | sys2.writes)) || (sys2.writes & sys1.reads);
+}
+
+} // namespace ECS
@@ -0,0 +1,68 @@
+// *********************************************************************************
+// Filename:     SystemsScheduler.h
+// Description:  a scheduler of per-frame ECS systems updates;
+//
+//               each system is registered with sets of components which it
+//               reads and writes; using these sets the scheduler builds a graph
+//               of dependencies between systems: a system depends on an earlier
+//               registered system if one of them writes a component which
+//               the other one reads or writes;
+//
+//               systems are split into waves: each wave contains only systems
+//               which are independent from each other so they are executed
+//               concurrently, and waves are executed one after another;
+//               conflicting systems are always executed in order of their
+//               registration so the result is deterministic for any number
+//               of threads (including the single-thread mode of the pool);
+//
+// Created:      17.10.26
+// *********************************************************************************
+#pragma once
+
+#include "../Common/Types.h"
+#include "../Common/ThreadPool.h"
+
+#include <vector>
+#include <string>
+#include <functional>
+
+namespace ECS
+{
+
+class SystemsScheduler
+{
+public:
+	using SystemFunc = std::function<void(const float totalGameTime, const float deltaTime)>;
+
+	void AddSystem(
+		const SystemID& name,
+		const ComponentsHash readComponents,
+		const ComponentsHash writeComponents,
+		SystemFunc&& func);
+
+	void Run(
+		ThreadPool& pool,
+		const float totalGameTime,
+		const float deltaTime);
+
+	inline size GetSystemsCount() const { return std::ssize(systems_); }
+	inline size GetWavesCount()   const { return std::ssize(waves_); }
+
+private:
+	struct SystemJob
+	{
+		SystemID       name;
+		ComponentsHash reads  = 0;
+		ComponentsHash writes = 0;
+		SystemFunc     func;
+	};
+
+	bool AreConflicting(const SystemJob& sys1, const SystemJob& sys2) const;
+
+private:
+	std::vector<SystemJob>        systems_;
+	std::vector<u32>              systemsWaves_;   // idx of the execution wave of each system
+	std::vector<std::vector<u32>> waves_;          // idxs of independent systems per wave
+};
+
+} // namespace ECS
@@ -10,7 +10,6 @@
 #include "../Common/log.h"
 #include "../Common/Utils.h"
 
-#include <fstream>    // for serialization / deserialization of data
 
 using namespace Utils;
 using namespace DirectX;
@@ -55,6 +54,25 @@ void TextureTransformSystem::AddTexTransformation(
 
 // --------------------------------------------------------
 
+void TextureTransformSystem::RemoveRecords(const std::vector<EntityID>& ids)
+{
+	// remove texture transformations of input entities (both common and specific data);
+	// (IDs of entities which don't have this component are skipped)
+
+	TextureTransform& comp = *pTexTransformComponent_;
+	TexStaticTransformations& staticTrans = comp.texStaticTrans_;
+	TexAtlasAnimations& anim = comp.texAtlasAnim_;
+	TexRotationsAroundCoords& rotations = comp.texRotations_;
+
+	comp.sparse_.SwapAndPop(ids, comp.ids_, comp.transformTypes_, comp.texTransforms_);
+
+	staticTrans.sparse_.SwapAndPop(ids, staticTrans.ids_, staticTrans.transformations_);
+	anim.sparse_.SwapAndPop(ids, anim.ids_, anim.timeSteps_, anim.currAnimTime_, anim.data_);
+	rotations.sparse_.SwapAndPop(ids, rotations.ids_, rotations.texCoords_, rotations.rotationsSpeed_);
+}
+
+// --------------------------------------------------------
+
 void TextureTransformSystem::GetTexTransformsForEntts(
 	const std::vector<EntityID>& ids,
 	std::vector<XMMATRIX>& outTexTransforms)
@@ -69,19 +87,16 @@ void TextureTransformSystem::GetTexTransformsForEntts(
 	
 
 	const TextureTransform& comp = *pTexTransformComponent_;
-	std::vector<bool> flags;
 	std::vector<ptrdiff_t> idxs;
 
-	// get arr of flags which will be used to define if entt has texture transformation
-	GetExistingFlags(comp.ids_, ids, flags);
+	// get data idxs of entts (idx == -1 means that entt has no texture transformation)
+	comp.sparse_.GetIdxs(ids, idxs);
 
 	// fill in the output arr with default values
 	outTexTransforms.resize(std::ssize(ids), DirectX::XMMatrixIdentity());
 
-	GetIdxsInSortedArr(comp.ids_, ids, idxs);
-
 	for (u32 idx = 0; idx < std::ssize(ids); ++idx)
-		outTexTransforms[idx] = (flags[idx]) ? comp.texTransforms_[idxs[idx]] : DirectX::XMMatrixIdentity();
+		outTexTransforms[idx] = (idxs[idx] != -1) ? comp.texTransforms_[idxs[idx]] : DirectX::XMMatrixIdentity();
 }
 
 // --------------------------------------------------------
@@ -107,15 +122,7 @@ void TextureTransformSystem::UpdateAllTextrureAnimations(
 bool TextureTransformSystem::CheckCanAddRecords(const std::vector<EntityID>& ids)
 {
 	// check if we can add records by IDs
-	bool canAddRecords = true;
-	std::vector<bool> flags;
-
-	GetExistingFlags(pTexTransformComponent_->ids_, ids, flags);
-
-	for (bool exist : flags)
-		canAddRecords &= (!exist);
-
-	return canAddRecords;
+	return !pTexTransformComponent_->sparse_.HasAny(ids);
 }
 
 // --------------------------------------------------------
@@ -132,23 +139,17 @@ void TextureTransformSystem::AddStaticTexTransform(
 	TexStaticTransformations& staticTransf = comp.texStaticTrans_;
 	const StaticTexTransParams& params = static_cast<const StaticTexTransParams&>(inParams);
 
-	// execute sorted insertion of new records into the data arrays
-	for (u32 idx = 0; const EntityID& id : ids)
-	{
-		const ptrdiff_t pos = GetPosForID(comp.ids_, id);
-
-		InsertAtPos(comp.ids_, pos, id);
-		InsertAtPos(comp.transformTypes_, pos, TexTransformType::STATIC);
-		InsertAtPos(comp.texTransforms_, pos, params.initTransform_[idx]);
-	
-		// setup specific data for this kind of texture transformation
-		const ptrdiff_t data_idx = GetPosForID(staticTransf.ids_, id);
+	// append new records to the end of the data arrays
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
 
-		InsertAtPos(staticTransf.ids_, data_idx, id);
-		InsertAtPos(staticTransf.transformations_, data_idx, params.texTransforms_[idx]);
+	AppendArray(comp.ids_, ids);
+	AppendArray(comp.texTransforms_, params.initTransform_);
+	comp.transformTypes_.insert(comp.transformTypes_.end(), ids.size(), TexTransformType::STATIC);
 
-		++idx;
-	}
+	// setup specific data for this kind of texture transformation
+	staticTransf.sparse_.Add(ids, std::ssize(staticTransf.ids_));
+	AppendArray(staticTransf.ids_, ids);
+	AppendArray(staticTransf.transformations_, params.texTransforms_);
 }
 
 // --------------------------------------------------------
@@ -168,14 +169,13 @@ void TextureTransformSystem::AddAtlasTextureAnimation(
 	TextureTransform& comp = *pTexTransformComponent_;
 	const AtlasAnimParams& params = static_cast<const AtlasAnimParams&>(inParams);
 
-	// execute sorted insertion into the data arrays
+	// append new records to the end of the data arrays
 	for (u32 idx = 0; const EntityID & id : ids)
 	{
-		const ptrdiff_t pos = GetPosForID(comp.ids_, id);
-
 		// add common data
-		InsertAtPos(comp.ids_, pos, id);
-		InsertAtPos(comp.transformTypes_, pos, TexTransformType::ATLAS_ANIMATION);
+		comp.sparse_.Add(id, std::ssize(comp.ids_));
+		comp.ids_.push_back(id);
+		comp.transformTypes_.push_back(TexTransformType::ATLAS_ANIMATION);
 
 		// add specific data according to this texture transformation type
 		const ptrdiff_t animIdx = AddAtlasAnimationData(
@@ -188,7 +188,7 @@ void TextureTransformSystem::AddAtlasTextureAnimation(
 		// (we just scale a texture and setup position to the top left corner)
 		TexAtlasAnimationData& animData = comp.texAtlasAnim_.data_[animIdx];
 
-		InsertAtPos(comp.texTransforms_, pos, XMMatrixTranspose(
+		comp.texTransforms_.push_back(XMMatrixTranspose(
 			XMMatrixScaling(animData.texCellWidth_, animData.texCellHeight_, 0)));
 
 		++idx;
@@ -213,26 +213,18 @@ void TextureTransformSystem::AddRotationAroundTexCoord(
 	TexRotationsAroundCoords& rotations = comp.texRotations_;
 	const RotationAroundCoordParams& params = static_cast<const RotationAroundCoordParams&>(inParams);
 
-	// if there is no records with this ID yet
-	for (u32 idx = 0; const EntityID & id : ids)
-	{
-		// execute sorted insertion into the common data arrays
-		
-		const ptrdiff_t comp_idx = GetPosForID(comp.ids_, id);
-
-		InsertAtPos(comp.ids_, comp_idx, id);
-		InsertAtPos(comp.transformTypes_, comp_idx, TexTransformType::ROTATION_AROUND_TEX_COORD);
-		InsertAtPos(comp.texTransforms_, comp_idx, DirectX::XMMatrixIdentity());  // current texture transformation
-
-		// setup specific data
-		const ptrdiff_t data_idx = GetPosForID(rotations.ids_, id);
+	// append new records to the end of the common data arrays
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
 
-		InsertAtPos(rotations.ids_, data_idx, id);
-		InsertAtPos(rotations.texCoords_, data_idx, params.rotationsCenter_[idx]);
-		InsertAtPos(rotations.rotationsSpeed_, data_idx, params.rotationsSpeed_[idx]);
+	AppendArray(comp.ids_, ids);
+	comp.transformTypes_.insert(comp.transformTypes_.end(), ids.size(), TexTransformType::ROTATION_AROUND_TEX_COORD);
+	comp.texTransforms_.insert(comp.texTransforms_.end(), ids.size(), DirectX::XMMatrixIdentity());  // current texture transformation
 
-		++idx;
-	}
+	// setup specific data
+	rotations.sparse_.Add(ids, std::ssize(rotations.ids_));
+	AppendArray(rotations.ids_, ids);
+	AppendArray(rotations.texCoords_, params.rotationsCenter_);
+	AppendArray(rotations.rotationsSpeed_, params.rotationsSpeed_);
 }
 
 // --------------------------------------------------------
@@ -253,15 +245,16 @@ const ptrdiff_t TextureTransformSystem::AddAtlasAnimationData(
 
 	TexAtlasAnimations& anim = pTexTransformComponent_->texAtlasAnim_;
 
-	const ptrdiff_t animIdx = GetPosForID(anim.ids_, id);
-	InsertAtPos(anim.ids_, animIdx, id);
+	const ptrdiff_t animIdx = std::ssize(anim.ids_);
+	anim.sparse_.Add(id, animIdx);
+	anim.ids_.push_back(id);
 
 	// frame_duration = full_anim_duration / frames_count
-	InsertAtPos(anim.timeSteps_, animIdx, animDuration / (texRows * texColumns));
-	InsertAtPos(anim.currAnimTime_, animIdx, 0.0f);
+	anim.timeSteps_.push_back(animDuration / (texRows * texColumns));
+	anim.currAnimTime_.push_back(0.0f);
 
 	// compute and store animation frames data
-	InsertAtPos(anim.data_, animIdx, TexAtlasAnimationData(texRows, texColumns, animDuration));
+	anim.data_.emplace_back(texRows, texColumns, animDuration);
 
 	return animIdx;
 }
@@ -273,7 +266,7 @@ void TextureTransformSystem::UpdateTextureStaticTransformation(const float delta
 	TextureTransform& comp = *pTexTransformComponent_;
 	std::vector<ptrdiff_t> idxs;
 
-	GetDataIdxsOfIDs(comp.ids_, comp.texStaticTrans_.ids_, idxs);
+	GetDataIdxsOfIDs(comp.texStaticTrans_.ids_, idxs);
 
 	for (u32 idx = 0; const ptrdiff_t transIdx : idxs)
 	{
@@ -350,7 +343,7 @@ void TextureTransformSystem::UpdateTextureAtlasAnimations(const float deltaTime)
 		enttsToUpdate.push_back(anim.ids_[animIdx]);
 
 	// get data idxs of transformations to update and apply new values by these idxs
-	GetDataIdxsOfIDs(comp.ids_, enttsToUpdate, transformsIdxs);
+	GetDataIdxsOfIDs(enttsToUpdate, transformsIdxs);
 	ApplyTexTransformsByIdxs(transformsIdxs, texTransToUpdate);
 }
 
@@ -382,27 +375,22 @@ void TextureTransformSystem::UpdateTextureRotations(const float totalGameTime)
 	}
 
 	// get data idxs of transformations to update and apply new values by these idxs
-	GetDataIdxsOfIDs(comp.ids_, rotations.ids_, transformsIdxs);
+	GetDataIdxsOfIDs(rotations.ids_, transformsIdxs);
 	ApplyTexTransformsByIdxs(transformsIdxs, texTransToUpdate);
 }
 
 // --------------------------------------------------------
 
 void TextureTransformSystem::GetDataIdxsOfIDs(
-	const std::vector<EntityID>& allEnttsIDs,
 	const std::vector<EntityID>& searchedEnttsIDs,
 	std::vector<ptrdiff_t>& outDataIdxs)
 {
-	// here we get data idx of ID in the examined array;
+	// here we get data idx of each ID in the common data arrays of the component;
 	//
-	// input:   1. examined array of IDs
-	//          2. array of searched IDs 
-	// output:     array of data idxs
-
-	outDataIdxs.reserve(searchedEnttsIDs.size());
+	// input:   array of searched IDs 
+	// output:  array of data idxs
 
-	for (const EntityID id : searchedEnttsIDs)
-		outDataIdxs.push_back(GetIdxInSortedArr(allEnttsIDs, id));
+	pTexTransformComponent_->sparse_.GetIdxs(searchedEnttsIDs, outDataIdxs);
 }
 
 // --------------------------------------------------------
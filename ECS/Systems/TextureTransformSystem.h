@@ -28,6 +28,8 @@ public:
 		const std::vector<EntityID>& ids,
 		const TexTransformInitParams& inParams);
 
+	void RemoveRecords(const std::vector<EntityID>& ids);
+
 	void GetTexTransformsForEntts(
 		const std::vector<EntityID>& enttsIDs,
 		std::vector<XMMATRIX>& outTexTransforms);
@@ -65,7 +67,6 @@ private:
 
 
 	void GetDataIdxsOfIDs(
-		const std::vector<EntityID>& allEnttsIDs,
 		const std::vector<EntityID>& searchedEnttsIDs,
 		std::vector<ptrdiff_t>& outDataIdxs);
 
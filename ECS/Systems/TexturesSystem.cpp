@@ -31,20 +31,7 @@ TexturesSystem::TexturesSystem(Textured* pTextures)
 	pTexturesComponent_->ids_.push_back(INVALID_ENTITY_ID);
 	pTexturesComponent_->texIDs_.push_back(std::vector<TexID>(texTypesCount, INVALID_TEXTURE_ID));
 	pTexturesComponent_->texPaths_.push_back(std::vector<TexPath>(texTypesCount, INVALID_TEXTURE_PATH));
-}
-
-///////////////////////////////////////////////////////////
-
-void TexturesSystem::Serialize(std::ofstream& fout, u32& offset)
-{
-	Assert::True(false, "TODO: implement it!");
-}
-
-///////////////////////////////////////////////////////////
-
-void TexturesSystem::Deserialize(std::ifstream& fin, const u32 offset)
-{
-	Assert::True(false, "TODO: implement it!");
+	pTexturesComponent_->sparse_.Add(INVALID_ENTITY_ID, 0);
 }
 
 ///////////////////////////////////////////////////////////
@@ -62,15 +49,27 @@ void TexturesSystem::AddRecords(
 
 	Textured& texComp = *pTexturesComponent_;
 
-	// add records (here we execute sorted insertion into the data arrays)
-	for (u32 i = 0; const EntityID& id : enttsIDs)
-	{
-		const ptrdiff_t insertAtPos = Utils::GetPosForID(texComp.ids_, enttsIDs[i]);
+	// add records (here we append them to the end of the data arrays)
+	texComp.sparse_.Add(enttsIDs, std::ssize(texComp.ids_));
 
-		Utils::InsertAtPos(texComp.ids_, insertAtPos, enttsIDs[i]);
-		Utils::InsertAtPos(texComp.texIDs_, insertAtPos, texIDs[i]);
-		Utils::InsertAtPos(texComp.texPaths_, insertAtPos, texPaths[i]);
-	}
+	Utils::AppendArray(texComp.ids_, enttsIDs);
+	Utils::AppendArray(texComp.texIDs_, texIDs);
+	Utils::AppendArray(texComp.texPaths_, texPaths);
+}
+
+///////////////////////////////////////////////////////////
+
+void TexturesSystem::RemoveRecords(const std::vector<EntityID>& enttsIDs)
+{
+	// remove records of input entities from the Textured component;
+	// (IDs of entities which don't have this component are skipped)
+	//
+	// NOTE: the record by idx 0 is the default textures set so we never remove it
+
+	Assert::True(!Utils::ArrHasVal(enttsIDs, INVALID_ENTITY_ID), "can't remove the default textures set");
+
+	Textured& texComp = *pTexturesComponent_;
+	texComp.sparse_.SwapAndPop(enttsIDs, texComp.ids_, texComp.texIDs_, texComp.texPaths_);
 }
 
 ///////////////////////////////////////////////////////////
@@ -78,10 +77,10 @@ void TexturesSystem::AddRecords(
 const std::vector<TexID>& TexturesSystem::GetTexIDsByEnttID(const EntityID enttID)
 {
 	const Textured& comp = *pTexturesComponent_;
-	const bool exist = Utils::BinarySearch(comp.ids_, enttID);
-	const ptrdiff_t idx = (ptrdiff_t)exist * Utils::GetIdxInSortedArr(comp.ids_, enttID);
-	
-	return comp.texIDs_[idx];
+	const ptrdiff_t idx = comp.sparse_.GetIdx(enttID);
+
+	// if there is no such entt we return the default (invalid) textures set
+	return comp.texIDs_[(idx != -1) ? idx : 0];
 }
 
 ///////////////////////////////////////////////////////////
@@ -97,7 +96,7 @@ void TexturesSystem::GetTexIDsByEnttsIDs(
 	const Textured& comp = *pTexturesComponent_;
 	std::vector<ptrdiff_t> idxs;
 
-	Utils::GetIdxsInSortedArr(comp.ids_, ids, idxs);
+	comp.sparse_.GetIdxs(ids, idxs);
 
 	outTexIds.reserve(Textured::TEXTURES_TYPES_COUNT * std::ssize(ids));
 
@@ -114,7 +113,7 @@ void TexturesSystem::FilterEnttsWhichHaveOwnTex(
 	// out: entts which have the Textured component
 
 	std::vector<bool> flags;
-	Utils::GetExistingFlags(pTexturesComponent_->ids_, ids, flags);
+	pTexturesComponent_->sparse_.GetExistingFlags(ids, flags);
 
 	outIds.resize(std::ssize(ids));
 	u32 pos = 0;
@@ -156,7 +155,7 @@ bool TexturesSystem::CheckTexPathsAreValid(
 bool TexturesSystem::CheckCanAddRecords(const std::vector<EntityID>& ids)
 {
 	// check if all input ids of entts don't exist in the component
-	return !Utils::CheckValuesExistInSortedArr(pTexturesComponent_->ids_, ids);
+	return !pTexturesComponent_->sparse_.HasAny(ids);
 }
 
 }
\ No newline at end of file
@@ -20,14 +20,13 @@ public:
 	TexturesSystem(Textured* pTextures);
 	~TexturesSystem() {};
 
-	void Serialize(std::ofstream& fout, u32& offset);
-	void Deserialize(std::ifstream& fin, const u32 offset);
-
 	void AddRecords(
 		const std::vector<EntityID>& enttsIDs,
 		const std::vector<std::vector<TexID>>& texIDs,
 		const std::vector<std::vector<TexPath>>& texPaths);
 
+	void RemoveRecords(const std::vector<EntityID>& enttsIDs);
+
 	const std::vector<TexID>& GetTexIDsByEnttID(const EntityID enttID);
 
 	void GetTexIDsByEnttsIDs(
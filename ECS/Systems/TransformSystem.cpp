@@ -10,8 +10,6 @@
 #include "../Common/Utils.h"
 #include "../Common/log.h"
 
-#include "SaveLoad/TransformSysSerDeser.h"
-
 #include <stdexcept>
 #include <algorithm>
 
@@ -48,43 +46,17 @@ void TransformSystem::AddRecords(
 
 void TransformSystem::RemoveRecords(const std::vector<EntityID>& enttsIDs)
 {
-	assert("TODO: IMPLEMENT IT!" && 0);
-}
-
-///////////////////////////////////////////////////////////
+	// remove records of input entities from the Transform and WorldMatrix components;
+	// (IDs of entities which don't have these components are skipped)
 
-void TransformSystem::Serialize(std::ofstream& fout, u32& offset)
-{
 	Transform& t = *pTransform_;
+	WorldMatrix& w = *pWorldMat_;
 
-	TransformSysSerDeser::Serialize(
-		fout,
-		offset,
-		static_cast<u32>(ComponentType::TransformComponent),    // data block marker
-		t.ids_,
-		t.posAndUniformScale_,
-		t.dirQuats_);
-}
-
-///////////////////////////////////////////////////////////
-
-void TransformSystem::Deserialize(std::ifstream& fin, const u32 offset)
-{
-	Transform& t = *pTransform_;
-
-	TransformSysSerDeser::Deserialize(
-		fin,
-		offset,
-		t.ids_,
-		t.posAndUniformScale_,
-		t.dirQuats_);
-
-	// clear data of the World component and build world matrices 
-	// from deserialized Transform component data
-	pWorldMat_->ids_.clear();
-	pWorldMat_->worlds_.clear();
+	t.sparse_.SwapAndPop(enttsIDs, t.ids_, t.posAndUniformScale_, t.dirQuats_, t.dirtyFlags_);
+	w.sparse_.SwapAndPop(enttsIDs, w.ids_, w.worlds_);
 
-	AddRecordsToWorldMatrixComponent(t.ids_, t.posAndUniformScale_,	t.dirQuats_);
+	// records were moved so the dirty list contains wrong idxs
+	RebuildDirtyIdxs();
 }
 
 
@@ -115,7 +87,7 @@ void TransformSystem::GetTransformDataOfEntts(
 	Transform& comp = *pTransform_;
 
 	// check if there are entities by such IDs
-	bool enttsExist = Utils::CheckValuesExistInSortedArr(comp.ids_, enttsIDs);
+	bool enttsExist = comp.sparse_.HasAll(enttsIDs);
 	Assert::True(enttsExist, "there is some entity which doesn't have the Transform component so we can't get its transform data");
 
 	const ptrdiff_t enttsCount = std::ssize(enttsIDs);
@@ -125,7 +97,7 @@ void TransformSystem::GetTransformDataOfEntts(
 	outUniformScales.reserve(enttsCount);
 
 	// get enttities data indices into arrays inside the Transform component
-	Utils::GetIdxsInSortedArr(comp.ids_, enttsIDs, outDataIdxs);
+	comp.sparse_.GetIdxs(enttsIDs, outDataIdxs);
 
 	GetTransformDataByDataIdxs(outDataIdxs, outPositions, outDirQuats, outUniformScales);
 }
@@ -133,7 +105,7 @@ void TransformSystem::GetTransformDataOfEntts(
 ///////////////////////////////////////////////////////////
 
 void TransformSystem::GetTransformDataByDataIdxs(
-	std::vector<ptrdiff_t>& dataIdxs,
+	const std::vector<ptrdiff_t>& dataIdxs,
 	std::vector<XMFLOAT3>& outPositions,
 	std::vector<XMVECTOR>& outDirQuats,      // direction quaternions
 	std::vector<float>& outUniformScales)
@@ -162,9 +134,8 @@ DirectX::XMMATRIX TransformSystem::GetWorldMatrixOfEntt(const EntityID id)
 {
 	const WorldMatrix& comp = *pWorldMat_;
 
-	bool exist = Utils::BinarySearch(comp.ids_, id);
-	ptrdiff_t idx = Utils::GetIdxInSortedArr(comp.ids_, id);
-	return (exist) ? comp.worlds_[idx] : DirectX::XMMatrixIdentity();
+	const ptrdiff_t idx = comp.sparse_.GetIdx(id);
+	return (idx != -1) ? comp.worlds_[idx] : DirectX::XMMatrixIdentity();
 }
 
 ///////////////////////////////////////////////////////////
@@ -179,7 +150,7 @@ void TransformSystem::GetWorldMatricesOfEntts(
 
 	// check input IDs; if there is no record by some id 
 	// we return an arr of identity matrices
-	bool idsValid = Utils::CheckValuesExistInSortedArr(comp.ids_, enttsIDs);
+	bool idsValid = comp.sparse_.HasAll(enttsIDs);
 	if (!idsValid)
 	{
 		Log::Error("can't get data: not existed record by some id");
@@ -191,7 +162,7 @@ void TransformSystem::GetWorldMatricesOfEntts(
 
 	// get data idx by each entt ID 
 	// and then get world matrices by these idxs
-	Utils::GetIdxsInSortedArr(comp.ids_, enttsIDs, idxs);
+	comp.sparse_.GetIdxs(enttsIDs, idxs);
 	GetWorldMatricesByDataIdxs(idxs, outWorldMatrices);
 }
 
@@ -230,7 +201,7 @@ void TransformSystem::SetTransformDataByIDs(
 	Transform& comp = *pTransform_;
 
 	// check if there are entities by such IDs
-	bool idsValid = Utils::CheckValuesExistInSortedArr(comp.ids_, enttsIDs);
+	bool idsValid = comp.sparse_.HasAll(enttsIDs);
 	Assert::True(idsValid, "can't set data: not existed record by some id");
 
 	const ptrdiff_t enttsCount = std::ssize(enttsIDs);
@@ -241,7 +212,7 @@ void TransformSystem::SetTransformDataByIDs(
 
 	// get enttities data indices into arrays inside the Transform component
 	std::vector<ptrdiff_t> dataIdxs;
-	Utils::GetIdxsInSortedArr(comp.ids_, enttsIDs, dataIdxs);
+	comp.sparse_.GetIdxs(enttsIDs, dataIdxs);
 
 	SetTransformDataByDataIdxs(dataIdxs, newPositions, newDirQuats, newUniformScales);
 }
@@ -264,7 +235,7 @@ void TransformSystem::SetTransformDataByDataIdxs(
 
 	// set new positions by idxs
 	for (ptrdiff_t posIdx = 0; ptrdiff_t dataIdx : dataIdxs)
-		DirectX::XMStoreFloat4(&comp.posAndUniformScale_[dataIdx], newPositions[posIdx]);
+		DirectX::XMStoreFloat4(&comp.posAndUniformScale_[dataIdx], newPositions[posIdx++]);
 
 	// set new uniform scales by idxs
 	for (ptrdiff_t scaleIdx = 0; ptrdiff_t dataIdx : dataIdxs)
@@ -272,7 +243,17 @@ void TransformSystem::SetTransformDataByDataIdxs(
 
 	// the Transform component stores only normalized direction quaternions so just do it
 	for (ptrdiff_t quatIdx = 0; ptrdiff_t dataIdx : dataIdxs)
-		comp.dirQuats_[dataIdx] = DirectX::XMQuaternionNormalize(newDirQuats[quatIdx]);
+		comp.dirQuats_[dataIdx] = DirectX::XMQuaternionNormalize(newDirQuats[quatIdx++]);
+
+	// world matrices of these entities will be rebuilt by UpdateDirtyWorldMatrices()
+	for (const ptrdiff_t dataIdx : dataIdxs)
+	{
+		if (comp.dirtyFlags_[dataIdx])
+			continue;
+
+		comp.dirtyFlags_[dataIdx] = 1;
+		comp.dirtyIdxs_.push_back((u32)dataIdx);
+	}
 }
 
 ///////////////////////////////////////////////////////////
@@ -288,16 +269,12 @@ void TransformSystem::SetWorldMatricesByIDs(
 
 	// check if there are entities by such IDs
 	WorldMatrix& comp = *pWorldMat_;
-	bool idsValid = Utils::CheckValuesExistInSortedArr(comp.ids_, enttsIDs);
+	bool idsValid = comp.sparse_.HasAll(enttsIDs);
 	Assert::True(idsValid, "can't set data: not existed record by some id");
 
-
-	std::vector<ptrdiff_t> idxs;
-	idxs.reserve(std::ssize(enttsIDs));
-
 	// get data idx of each entt ID
-	for (const EntityID& id : enttsIDs)
-		idxs.push_back(Utils::GetIdxInSortedArr(comp.ids_, id));
+	std::vector<ptrdiff_t> idxs;
+	comp.sparse_.GetIdxs(enttsIDs, idxs);
 
 	SetWorldMatricesByDataIdxs(idxs, newWorldMatrices);
 }
@@ -314,6 +291,160 @@ void TransformSystem::SetWorldMatricesByDataIdxs(
 
 	for (ptrdiff_t newMatIdx = 0; const ptrdiff_t idx : dataIdxs)
 		pWorldMat_->worlds_[idx] = newWorldMatrices[newMatIdx++];
+
+	// world matrices were changed so data which depends on them must be updated
+	++pWorldMat_->version_;
+}
+
+///////////////////////////////////////////////////////////
+
+void TransformSystem::UpdateDirtyWorldMatrices()
+{
+	// rebuild world matrices of entities whose transform data was changed since
+	// the previous call (they are in the dirty list) from the canonical position,
+	// direction quaternion and uniform scale; world matrices of other entities
+	// aren't touched at all; IDs of the updated entities are stored so other
+	// systems (culling, instances data, etc.) can process only them;
+	//
+	// matrices are built by 4 at once: transform data of 4 entities is transposed
+	// into SoA form (x0x1x2x3, y0y1y2y3, ...) so each element of the rotation matrix
+	// is computed for 4 entities by a single vector operation;
+	//
+	// NOTE: records of the Transform and WorldMatrix components are always added and
+	//       removed together so data idx of the entity is the same in both of them
+
+	Transform& t   = *pTransform_;
+	WorldMatrix& w = *pWorldMat_;
+
+	if (t.ids_.size() != w.ids_.size())
+		throw LIB_Exception("the Transform and WorldMatrix components are out of sync");
+
+	const size dirtyCount           = std::ssize(t.dirtyIdxs_);
+	const u32* dirtyIdxs            = t.dirtyIdxs_.data();
+	const EntityID* ids             = t.ids_.data();
+	const XMFLOAT4* posAndUniScales = t.posAndUniformScale_.data();
+	const XMVECTOR* dirQuats        = t.dirQuats_.data();
+	uint8_t* dirtyFlags             = t.dirtyFlags_.data();
+	XMMATRIX* worlds                = w.worlds_.data();
+
+	dirtyEnttsIDs_.resize(dirtyCount);
+	++dirtyListVersion_;
+
+	const XMVECTOR one = g_XMOne;
+	const XMVECTOR two = XMVectorReplicate(2.0f);
+	size i = 0;
+
+	for (; i + 4 <= dirtyCount; i += 4)
+	{
+		const u32 idx0 = dirtyIdxs[i + 0];
+		const u32 idx1 = dirtyIdxs[i + 1];
+		const u32 idx2 = dirtyIdxs[i + 2];
+		const u32 idx3 = dirtyIdxs[i + 3];
+
+		// r[0] = pos x; r[1] = pos y; r[2] = pos z; r[3] = uniform scale
+		const XMMATRIX pos = XMMatrixTranspose(XMMATRIX(
+			XMLoadFloat4(&posAndUniScales[idx0]),
+			XMLoadFloat4(&posAndUniScales[idx1]),
+			XMLoadFloat4(&posAndUniScales[idx2]),
+			XMLoadFloat4(&posAndUniScales[idx3])));
+
+		// r[0] = quat x; r[1] = quat y; r[2] = quat z; r[3] = quat w
+		const XMMATRIX quat = XMMatrixTranspose(XMMATRIX(
+			dirQuats[idx0],
+			dirQuats[idx1],
+			dirQuats[idx2],
+			dirQuats[idx3]));
+
+		const XMVECTOR scale = pos.r[3];
+		const XMVECTOR qx = quat.r[0];
+		const XMVECTOR qy = quat.r[1];
+		const XMVECTOR qz = quat.r[2];
+		const XMVECTOR qw = quat.r[3];
+
+		const XMVECTOR xx = XMVectorMultiply(qx, qx);
+		const XMVECTOR yy = XMVectorMultiply(qy, qy);
+		const XMVECTOR zz = XMVectorMultiply(qz, qz);
+		const XMVECTOR xy = XMVectorMultiply(qx, qy);
+		const XMVECTOR xz = XMVectorMultiply(qx, qz);
+		const XMVECTOR yz = XMVectorMultiply(qy, qz);
+		const XMVECTOR xw = XMVectorMultiply(qx, qw);
+		const XMVECTOR yw = XMVectorMultiply(qy, qw);
+		const XMVECTOR zw = XMVectorMultiply(qz, qw);
+
+		// elements of the rotation matrix (the same as XMMatrixRotationQuaternion)
+		// which are already multiplied by the uniform scale
+		const XMVECTOR twoScale = XMVectorMultiply(two, scale);
+
+		const XMVECTOR m00 = XMVectorMultiply(scale, XMVectorNegativeMultiplySubtract(two, XMVectorAdd(yy, zz), one));
+		const XMVECTOR m11 = XMVectorMultiply(scale, XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, zz), one));
+		const XMVECTOR m22 = XMVectorMultiply(scale, XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, yy), one));
+		const XMVECTOR m01 = XMVectorMultiply(twoScale, XMVectorAdd(xy, zw));
+		const XMVECTOR m02 = XMVectorMultiply(twoScale, XMVectorSubtract(xz, yw));
+		const XMVECTOR m10 = XMVectorMultiply(twoScale, XMVectorSubtract(xy, zw));
+		const XMVECTOR m12 = XMVectorMultiply(twoScale, XMVectorAdd(yz, xw));
+		const XMVECTOR m20 = XMVectorMultiply(twoScale, XMVectorAdd(xz, yw));
+		const XMVECTOR m21 = XMVectorMultiply(twoScale, XMVectorSubtract(yz, xw));
+
+		// transpose back from SoA: k-th row of each matrix is a row of the k-th entity
+		const XMMATRIX rows0 = XMMatrixTranspose(XMMATRIX(m00, m01, m02, g_XMZero));
+		const XMMATRIX rows1 = XMMatrixTranspose(XMMATRIX(m10, m11, m12, g_XMZero));
+		const XMMATRIX rows2 = XMMatrixTranspose(XMMATRIX(m20, m21, m22, g_XMZero));
+		const XMMATRIX rows3 = XMMatrixTranspose(XMMATRIX(pos.r[0], pos.r[1], pos.r[2], one));
+
+		worlds[idx0] = XMMATRIX(rows0.r[0], rows1.r[0], rows2.r[0], rows3.r[0]);
+		worlds[idx1] = XMMATRIX(rows0.r[1], rows1.r[1], rows2.r[1], rows3.r[1]);
+		worlds[idx2] = XMMATRIX(rows0.r[2], rows1.r[2], rows2.r[2], rows3.r[2]);
+		worlds[idx3] = XMMATRIX(rows0.r[3], rows1.r[3], rows2.r[3], rows3.r[3]);
+	}
+
+	// the rest of dirty records (less than 4)
+	for (; i < dirtyCount; ++i)
+	{
+		const u32 idx = dirtyIdxs[i];
+
+		// world = S * R * T (the w-component of translation is ignored by DirectXMath)
+		const XMVECTOR posAndScale = XMLoadFloat4(&posAndUniScales[idx]);
+
+		worlds[idx] = XMMatrixAffineTransformation(
+			XMVectorSplatW(posAndScale),
+			g_XMZero,
+			dirQuats[idx],
+			posAndScale);
+	}
+
+	// clear dirty flags and store IDs of updated entities
+	for (i = 0; i < dirtyCount; ++i)
+	{
+		const u32 idx = dirtyIdxs[i];
+
+		dirtyFlags[idx] = 0;
+		dirtyEnttsIDs_[i] = ids[idx];
+	}
+
+	t.dirtyIdxs_.clear();
+}
+
+///////////////////////////////////////////////////////////
+
+void TransformSystem::AddDirtyIdxs(const std::vector<u32>& dataIdxs)
+{
+	Utils::AppendArray(pTransform_->dirtyIdxs_, dataIdxs);
+}
+
+///////////////////////////////////////////////////////////
+
+void TransformSystem::RebuildDirtyIdxs()
+{
+	Transform& t = *pTransform_;
+	const u32 count = (u32)t.dirtyFlags_.size();
+
+	t.dirtyIdxs_.clear();
+
+	for (u32 idx = 0; idx < count; ++idx)
+	{
+		if (t.dirtyFlags_[idx])
+			t.dirtyIdxs_.push_back(idx);
+	}
 }
 
 
@@ -334,7 +465,7 @@ void TransformSystem::AddRecordsToTransformComponent(
 
 	Transform& component = *pTransform_;
 
-	bool canAddComponent = !Utils::CheckValuesExistInSortedArr(component.ids_, ids);
+	bool canAddComponent = !component.sparse_.HasAny(ids);
 	Assert::True(canAddComponent, "can't add component: there is already a record with some entity id");
 
 	// ---------------------------------------------
@@ -348,19 +479,26 @@ void TransformSystem::AddRecordsToTransformComponent(
 
 	// ---------------------------------------------
 
-	for (u32 idx = 0; const EntityID& id : ids)
-	{
-		const ptrdiff_t insertAt = GetPosForID(component.ids_, id);
-		const XMFLOAT3& pos = positions[idx];
-		const XMFLOAT4 transAndUniScale = { pos.x, pos.y, pos.z, uniformScales[idx] };
-		
-		// NOTE: we build a single XMFLOAT4 from position and uniform scale
-		InsertAtPos<EntityID>(component.ids_, insertAt, id);
-		InsertAtPos<XMFLOAT4>(component.posAndUniformScale_, insertAt, transAndUniScale);
-		InsertAtPos<XMVECTOR>(component.dirQuats_, insertAt, normDirQuats[idx]);
-	
-		++idx;
-	}
+	// append new records to the end of the data arrays
+	const ptrdiff_t firstDataIdx = std::ssize(component.ids_);
+	const ptrdiff_t newCapacity = firstDataIdx + std::ssize(ids);
+
+	component.ids_.reserve(newCapacity);
+	component.posAndUniformScale_.reserve(newCapacity);
+	component.dirQuats_.reserve(newCapacity);
+	component.dirtyFlags_.reserve(newCapacity);
+
+	Utils::AppendArray(component.ids_, ids);
+	Utils::AppendArray(component.dirQuats_, normDirQuats);
+
+	// world matrices of new entities are computed right after adding so they aren't dirty
+	component.dirtyFlags_.resize(newCapacity, 0);
+
+	// NOTE: we build a single XMFLOAT4 from position and uniform scale
+	for (u32 idx = 0; const XMFLOAT3& pos : positions)
+		component.posAndUniformScale_.emplace_back(pos.x, pos.y, pos.z, uniformScales[idx++]);
+
+	component.sparse_.Add(ids, firstDataIdx);
 }
 
 ///////////////////////////////////////////////////////////
@@ -375,7 +513,7 @@ void TransformSystem::AddRecordsToWorldMatrixComponent(
 	
 	WorldMatrix& comp = *pWorldMat_;
 
-	bool canAddComponent = !Utils::CheckValuesExistInSortedArr(comp.ids_, ids);
+	bool canAddComponent = !comp.sparse_.HasAny(ids);
 	Assert::True(canAddComponent, "can't add component: there is already a record with some entity id");
 
 	// ---------------------------------------------
@@ -398,63 +536,9 @@ void TransformSystem::AddRecordsToWorldMatrixComponent(
 	// ---------------------------------------------
 		
 	// store records ['entt_id' => 'world_matrix'] into the WorldMatrix componemt	
-	for (u32 idx = 0; const EntityID id : ids)
-	{
-		const ptrdiff_t insertByIdx = Utils::GetPosForID(comp.ids_, id);
-
-		Utils::InsertAtPos(comp.ids_, insertByIdx, id);
-		Utils::InsertAtPos(comp.worlds_, insertByIdx, worldMatrices[idx++]);
-	}
-}
-
-///////////////////////////////////////////////////////////
-
-void TransformSystem::AddRecordsToWorldMatrixComponent(
-	const std::vector<EntityID>& ids,
-	const std::vector<XMFLOAT4>& posAndUniScales,
-	const std::vector<XMVECTOR>& dirQuats)     // direction quaternions
-{
-	// compute and store world matrices into the WorldMatrix component
-
-	WorldMatrix& comp = *pWorldMat_;
-	const size worldMatricesCount = std::ssize(posAndUniScales);
-
-	std::vector<XMMATRIX> scaleMatrices;
-	std::vector<XMMATRIX> rotationMatrices;
-	std::vector<XMMATRIX> translationMatrices;
-	std::vector<XMMATRIX> worldMatrices;
-	std::vector<ptrdiff_t> dataIdxs;
-
-	scaleMatrices.reserve(worldMatricesCount);
-	rotationMatrices.reserve(worldMatricesCount);
-	translationMatrices.reserve(worldMatricesCount);
-	worldMatrices.reserve(worldMatricesCount);
-	dataIdxs.reserve(worldMatricesCount);
-
-	// 1. compute matrices for uniform scaling (we use only w component of XMFLOAT4)
-	// 2. compute rotation matrices
-	// 3. compute translation matrices (we use x,y,z of XMFLOAT4)
-	for (ptrdiff_t idx = 0; idx < worldMatricesCount; ++idx)
-		scaleMatrices.emplace_back(DirectX::XMMatrixScaling(posAndUniScales[idx].w, posAndUniScales[idx].w, posAndUniScales[idx].w));
-
-	for (ptrdiff_t idx = 0; idx < worldMatricesCount; ++idx)
-		rotationMatrices.emplace_back(DirectX::XMMatrixRotationQuaternion(dirQuats[idx]));
-
-	for (ptrdiff_t idx = 0; idx < worldMatricesCount; ++idx)
-		translationMatrices.emplace_back(DirectX::XMMatrixTranslation(posAndUniScales[idx].x, posAndUniScales[idx].y, posAndUniScales[idx].z));
-
-	// compute world matrices
-	for (ptrdiff_t idx = 0; idx < worldMatricesCount; ++idx)
-		worldMatrices.emplace_back(scaleMatrices[idx] * rotationMatrices[idx] * translationMatrices[idx]);
-
-	// store records ['entt_id' => 'world_matrix'] into the WorldMatrix componemt
-	for (u32 data_idx = 0; const EntityID id : ids)
-	{
-		const ptrdiff_t insertAt = Utils::GetPosForID(comp.ids_, id);
-
-		Utils::InsertAtPos(comp.ids_, insertAt, id);
-		Utils::InsertAtPos(comp.worlds_, insertAt, worldMatrices[data_idx++]);
-	}
+	comp.sparse_.Add(ids, std::ssize(comp.ids_));
+	Utils::AppendArray(comp.ids_, ids);
+	Utils::AppendArray(comp.worlds_, worldMatrices);
 }
 
 }
\ No newline at end of file
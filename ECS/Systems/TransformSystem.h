@@ -22,10 +22,6 @@ public:
 	TransformSystem(Transform* pTransform, WorldMatrix* pWorld);
 	~TransformSystem() {}
 
-	// public serialization / deserialization API
-	void Serialize(std::ofstream& fout, u32& offset);
-	void Deserialize(std::ifstream& fin, const u32 offset);
-
 	void AddRecords(
 		const std::vector<EntityID>& enttsIDs, 
 		const std::vector<XMFLOAT3>& positions,
@@ -46,7 +42,7 @@ public:
 		std::vector<float>& outUniformScales);
 
 	void GetTransformDataByDataIdxs(
-		std::vector<ptrdiff_t>& dataIdxs,
+		const std::vector<ptrdiff_t>& dataIdxs,
 		std::vector<XMFLOAT3>& outPositions,
 		std::vector<XMVECTOR>& outDirQuats,      // direction quaternions
 		std::vector<float>& outUniformScales);
@@ -90,6 +86,25 @@ public:
 		const std::vector<XMMATRIX>& newWorldMatrices);
 
 
+	// -------------------------------------------------------
+	// PUBLIC UPDATING API
+
+	void UpdateDirtyWorldMatrices();
+
+	// append data idxs of records which were marked as dirty outside of this system
+	// (their dirty flags must be already set and idxs must not be in the dirty list yet)
+	void AddDirtyIdxs(const std::vector<u32>& dataIdxs);
+
+	// rebuild the list of dirty idxs from dirty flags (after data idxs were changed)
+	void RebuildDirtyIdxs();
+
+	// IDs of entities whose world matrices were rebuilt by the last UpdateDirtyWorldMatrices() call
+	inline const std::vector<EntityID>& GetDirtyEnttsIDs() const { return dirtyEnttsIDs_; }
+
+	// is increased by each UpdateDirtyWorldMatrices() call so consumers can check if they missed some list
+	inline u32 GetDirtyListVersion() const { return dirtyListVersion_; }
+
+
 private:
 	void AddRecordsToTransformComponent(
 		const std::vector<EntityID>& enttsIDs,
@@ -103,14 +118,12 @@ private:
 		const std::vector<XMVECTOR>& dirQuats,      // direction quaternions
 		const std::vector<float>& uniformScales);
 
-	void AddRecordsToWorldMatrixComponent(
-		const std::vector<EntityID>& enttsIDs,
-		const std::vector<XMFLOAT4>& posAndUniformScales,
-		const std::vector<XMVECTOR>& dirQuats);     // direction quaternions
-
 private:
 	Transform* pTransform_ = nullptr;   // a ptr to the Transform component
 	WorldMatrix* pWorldMat_ = nullptr;  // a ptr to the WorldMatrix component
+
+	std::vector<EntityID> dirtyEnttsIDs_;
+	u32                   dirtyListVersion_ = 0;
 };
 
 }
\ No newline at end of file
@@ -200,4 +200,33 @@ void Render::RenderInstances(
 
 ///////////////////////////////////////////////////////////
 
+void Render::RenderChunks(
+	ID3D11DeviceContext* pDeviceContext,
+	const ChunksDataToRender& chunksData)
+{
+	try
+	{
+		shadersContainer_.lightShader_.RenderChunks(
+			pDeviceContext,
+			chunksData.ptrsVB,
+			chunksData.pIB,
+			chunksData.texturesSRVs,
+			chunksData.startIndices,
+			chunksData.indexCounts,
+			chunksData.baseVertices,
+			chunksData.vertexSize);
+	}
+	catch (LIB_Exception& e)
+	{
+		Log::Error(e);
+		Log::Error("can't render chunks onto the screen");
+	}
+	catch (...)
+	{
+		Log::Error("can't render chunks for some unknown reason :)");
+	}
+}
+
+///////////////////////////////////////////////////////////
+
 }; // namespace Render
\ No newline at end of file
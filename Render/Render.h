@@ -15,7 +15,7 @@
 
 #include <d3d11.h>
 #include <DirectXMath.h>
-#include <set>
+#include <vector>
 
 
 namespace Render
@@ -94,26 +94,54 @@ public:
 		}
 	};
 
-	struct RenderDataStorage
+	struct ChunksDataToRender
 	{
-		// stores render data of bunches of instances with different render states
+		// geometry which is rendered without instancing by ranges of buffers
+		// (for instance: chunks of the terrain); each draw call uses its own
+		// vertex buffer and a range of the shared index buffer
+
+		ChunksDataToRender() {}
+
+		std::vector<ID3D11Buffer*> ptrsVB;                        // vertex buffer of each draw call
+		std::vector<uint32_t> startIndices;                       // params of DrawIndexed() of each draw call
+		std::vector<uint32_t> indexCounts;
+		std::vector<uint32_t> baseVertices;
+		ID3D11Buffer* pIB = nullptr;                              // index buffer which is shared by all the draw calls
+		ID3D11ShaderResourceView* texturesSRVs[2] = { nullptr, nullptr };   // the same textures for all the draw calls
+		uint32_t vertexSize = 0;
 
 		void Clear()
 		{
-			for (auto& it : instanceBuffData_)
-				it.second.Clear();
+			ptrsVB.clear();
+			startIndices.clear();
+			indexCounts.clear();
+			baseVertices.clear();
+		}
+	};
+
+	struct RenderDataStorage
+	{
+		// stores render data of bunches of instances with different render states;
+		// data of each bunch is addressed by an integer ID of the bunch and is kept
+		// from frame to frame so it can be updated only partially
+
+		void Resize(const size_t bunchesCount)
+		{
+			instanceBuffData_.resize(bunchesCount);
+			perInstanceData_.resize(bunchesCount);
+		}
 
-			for (auto& it : perInstanceData_)
-				it.second.Clear();
+		void Clear()
+		{
+			for (InstanceBufferData& data : instanceBuffData_)
+				data.Clear();
 
-			instanceBuffData_.clear();
-			perInstanceData_.clear();
-			keys_.clear();
+			for (InstancesDataToRender& data : perInstanceData_)
+				data.Clear();
 		}
 
-		std::map<std::string, InstanceBufferData> instanceBuffData_;
-		std::map<std::string, InstancesDataToRender> perInstanceData_;
-		std::set<std::string> keys_;                                   // keys for set of entts
+		std::vector<InstanceBufferData> instanceBuffData_;
+		std::vector<InstancesDataToRender> perInstanceData_;
 	};
 
 public:
@@ -148,6 +176,11 @@ public:
 		const std::vector<ID3D11Buffer*>& ptrsMeshVB,                     // arr of ptrs to meshes vertex buffers
 		const std::vector<ID3D11Buffer*>& ptrsMeshIB,                     // arr of ptrs to meshes index buffers
 		const std::vector<uint32_t>& indexCounts);
+
+	// render chunks using the first instance of the instanced buffer
+	void RenderChunks(
+		ID3D11DeviceContext* pDeviceContext,
+		const ChunksDataToRender& chunksData);
 		
 	bool Render3D();
 
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <DirectXMath.h>
+#include <cstdint>
 
 namespace Render
 {
@@ -272,6 +272,43 @@ void LightShaderClass::Render(
 	}
 }
 
+///////////////////////////////////////////////////////////
+
+void LightShaderClass::RenderChunks(
+	ID3D11DeviceContext* pDeviceContext,
+	const std::vector<ID3D11Buffer*>& ptrsVB,
+	ID3D11Buffer* pIB,
+	ID3D11ShaderResourceView* const* texturesSRVs,
+	const std::vector<uint32_t>& startIndices,
+	const std::vector<uint32_t>& indexCounts,
+	const std::vector<uint32_t>& baseVertices,
+	const uint32_t vertexSize)
+{
+	const UINT stride[2] = { vertexSize, sizeof(buffTypes::InstancedData) };
+	const UINT offset[2] = { 0,0 };
+	const UINT drawCallsCount = static_cast<UINT>(std::ssize(ptrsVB));
+
+	pDeviceContext->IASetIndexBuffer(pIB, DXGI_FORMAT_R32_UINT, 0);
+	pDeviceContext->PSSetShaderResources(0U, 2U, texturesSRVs);
+
+	for (UINT idx = 0; idx < drawCallsCount; ++idx)
+	{
+		// draw calls of the same vertex buffer usually go one by one
+		if ((idx == 0) || (ptrsVB[idx] != ptrsVB[idx - 1]))
+		{
+			ID3D11Buffer* vbs[2] = { ptrsVB[idx], pInstancedBuffer_ };
+			pDeviceContext->IASetVertexBuffers(0, 2, vbs, stride, offset);
+		}
+
+		pDeviceContext->DrawIndexedInstanced(
+			indexCounts[idx],
+			1U,
+			startIndices[idx],
+			static_cast<INT>(baseVertices[idx]),
+			0U);
+	}
+}
+
 
 	
 
@@ -34,6 +34,10 @@ namespace Render
 
 namespace buffTypes
 {
+	// the max number of point lights which are uploaded for a frame
+	// (must be the same as the size of arr of point lights in the pixel shader)
+	constexpr int MAX_POINT_LIGHTS_PER_FRAME = 25;
+
 	struct InstancedData
 	{
 		DirectX::XMMATRIX world;
@@ -55,7 +59,7 @@ namespace buffTypes
 		// a structure for pixel shader data which is changed each frame
 
 		DirLight          dirLights[3];
-		PointLight        pointLights[25];
+		PointLight        pointLights[MAX_POINT_LIGHTS_PER_FRAME];
 		SpotLight         spotLights;
 		DirectX::XMFLOAT3 cameraPos;
 	};
@@ -136,6 +140,19 @@ public:
 		const uint32_t numOfTexSet,
 		const uint32_t vertexSize);
 
+	// render geometry without instancing (each draw call uses its own vertex buffer
+	// and a range of the shared index buffer); all the draw calls use the first
+	// instance of the instanced buffer
+	void RenderChunks(
+		ID3D11DeviceContext* pDeviceContext,
+		const std::vector<ID3D11Buffer*>& ptrsVB,                         // vertex buffer of each draw call
+		ID3D11Buffer* pIB,
+		ID3D11ShaderResourceView* const* texturesSRVs,                    // 2 textures for all the draw calls
+		const std::vector<uint32_t>& startIndices,
+		const std::vector<uint32_t>& indexCounts,
+		const std::vector<uint32_t>& baseVertices,
+		const uint32_t vertexSize);
+
 	inline const std::string& GetShaderName() const { return className_; }
 
 	// for controlling of different shader states